@@ -36,3 +36,29 @@ function(generate_spritesheets target)
     VERBATIM
   )
 endfunction()
+
+# Cook .gltf scenes into .edbrscene files which are loaded by SceneCache instead
+# (only outdated scenes are cooked)
+function(cook_scenes target)
+  set(GAME_MODELS_PATH "${CMAKE_CURRENT_SOURCE_DIR}/assets/models")
+  assert_dir_exists("${GAME_MODELS_PATH}")
+
+  add_custom_command(TARGET ${target} POST_BUILD
+    COMMENT "Cooking scenes"
+    COMMAND $<TARGET_FILE:scene_cooker> "${GAME_MODELS_PATH}"
+    VERBATIM
+  )
+endfunction()
+
+# Compress textures of .gltf scenes into .ktx2 files which are loaded by
+# GfxDevice instead of the source images (only outdated textures are cooked)
+function(cook_textures target)
+  set(GAME_MODELS_PATH "${CMAKE_CURRENT_SOURCE_DIR}/assets/models")
+  assert_dir_exists("${GAME_MODELS_PATH}")
+
+  add_custom_command(TARGET ${target} POST_BUILD
+    COMMENT "Cooking textures"
+    COMMAND $<TARGET_FILE:texture_cooker> "${GAME_MODELS_PATH}"
+    VERBATIM
+  )
+endfunction()
@@ -58,6 +58,10 @@ function(get_edbr_common_3d_shaders outVar)
     fullscreen_triangle.vert
     skybox.frag
     skinning.comp
+    mesh_cull.comp
+    mesh_cull_compact.comp
+    meshlet_cull.comp
+    hiz_build.comp
     mesh.vert
     mesh_depth_only.vert
     mesh_depth.frag
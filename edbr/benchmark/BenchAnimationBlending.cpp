@@ -0,0 +1,79 @@
+#include "Benchmark.h"
+
+#include <filesystem>
+
+#include <edbr/Graphics/AnimationSampling.h>
+#include <edbr/Graphics/Scene.h>
+#include <edbr/Graphics/SkeletonAnimator.h>
+#include <edbr/Util/GltfLoader.h>
+
+#include <fmt/format.h>
+
+EDBR_BENCHMARK(AnimationBlending500)
+{
+    static const std::size_t numSkeletons = 500;
+    static const int numIterations = 50;
+    static const float dt = 1.f / 60.f;
+
+    const auto path = std::filesystem::path{EDBR_BENCHMARK_ASSETS_DIR} / "models/cato.gltf";
+    if (!std::filesystem::exists(path)) {
+        fmt::println("  {} not found, skipping", path.string());
+        return;
+    }
+    const auto scene = util::loadGltfAnimations(path);
+    const auto& skeleton = scene.skeletons.at(0);
+    const auto& idle = scene.animations.at("Idle");
+    const auto& walk = scene.animations.at("Walk");
+    const auto& run = scene.animations.at("Run");
+    const auto numJoints = skeleton.joints.size();
+
+    // blending joint matrices of each clip: every clip pays for the hierarchy
+    std::vector<std::vector<glm::mat4>> jointMatrices(
+        numSkeletons, std::vector<glm::mat4>(numJoints));
+    std::vector<glm::mat4> clipMatrices[3];
+    for (auto& m : clipMatrices) {
+        m.resize(numJoints);
+    }
+    std::vector<glm::mat4> transforms;
+    const SkeletalAnimation* clips[3] = {&idle, &walk, &run};
+    const float weights[3] = {0.2f, 0.5f, 0.3f};
+    float time = 0.f;
+    const auto matricesMs = bench::measure("blend joint matrices", numIterations, [&]() {
+        time += dt;
+        for (std::size_t i = 0; i < numSkeletons; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                const auto t = std::fmod(time + 0.01f * (float)i, clips[c]->duration);
+                graphics::sampleJointMatrices(
+                    skeleton.flatSkeleton, clips[c]->soaTracks, t, clipMatrices[c], transforms);
+            }
+            for (std::size_t j = 0; j < numJoints; ++j) {
+                jointMatrices[i][j] = clipMatrices[0][j] * weights[0] +
+                                      clipMatrices[1][j] * weights[1] +
+                                      clipMatrices[2][j] * weights[2];
+            }
+        }
+        bench::doNotOptimize((std::size_t)jointMatrices.back()[0][3][0]);
+    });
+
+    // Walk/Run blend space cross-faded from Idle
+    const AnimationBlendSpace1D blendSpace{
+        .name = "Locomotion",
+        .entries = {{.position = 1.f, .animation = &walk}, {.position = 4.f, .animation = &run}},
+    };
+    std::vector<SkeletonAnimator> animators(numSkeletons);
+    for (std::size_t i = 0; i < numSkeletons; ++i) {
+        animators[i].setAnimation(skeleton, idle);
+        animators[i].update(skeleton, 0.01f * (float)i);
+        // long fade, so that all 3 clips are played during the benchmark
+        animators[i].setBlendSpace(skeleton, blendSpace, 1000.f);
+        animators[i].setBlendParameter(2.5f);
+    }
+    const auto posesMs = bench::measure("blend local poses", numIterations, [&]() {
+        for (auto& animator : animators) {
+            animator.update(skeleton, dt);
+        }
+        bench::doNotOptimize((std::size_t)animators.back().getJointMatrices()[0][3][0]);
+    });
+
+    bench::printSpeedup("speedup", matricesMs, posesMs);
+}
@@ -0,0 +1,187 @@
+#include "Benchmark.h"
+
+#include <random>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/CullingStage.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/ShadowCasterCulling.h>
+#include <edbr/Graphics/ShadowMapping.h>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <fmt/format.h>
+
+namespace
+{
+std::vector<MeshDrawCommand> generateDrawCommands(std::size_t count)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-200.f, 200.f};
+    std::uniform_real_distribution<float> heightDist{0.f, 20.f};
+    std::uniform_real_distribution<float> radiusDist{0.1f, 3.f};
+
+    std::vector<MeshDrawCommand> dcs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& dc = dcs[i];
+        dc.meshId = i % 500;
+        dc.materialId = 0;
+        dc.worldBoundingSphere = math::Sphere{
+            .center = {posDist(rng), heightDist(rng), posDist(rng)},
+            .radius = radiusDist(rng),
+        };
+        dc.castShadow = (i % 8) != 0;
+    }
+    return dcs;
+}
+
+std::vector<CullingStage::View> createViews(std::size_t numPointLights)
+{
+    std::vector<CullingStage::View> views;
+
+    Camera camera;
+    camera.setUseInverseDepth(true);
+    camera.init(glm::radians(60.f), 0.1f, 100.f, 16.f / 9.f);
+    camera.setPosition({0.f, 5.f, 0.f});
+    views.push_back({.volume = edge::createFrustumFromCamera(camera)});
+
+    // CSM
+    const auto sunDir = glm::normalize(glm::vec3{0.3f, 1.f, 0.5f}); // towards the sun
+    const auto percents = std::array{0.138f, 0.35f, 1.f};
+    for (std::size_t i = 0; i < percents.size(); ++i) {
+        const auto zNear = i == 0 ? camera.getZNear() : camera.getZNear() * percents[i - 1];
+        const auto zFar = camera.getZFar() * percents[i];
+        Camera subFrustumCamera;
+        subFrustumCamera.setPosition(camera.getPosition());
+        subFrustumCamera.setHeading(camera.getHeading());
+        subFrustumCamera.init(camera.getFOVX(), zNear, zFar, 1.f);
+        const auto corners = edge::calculateFrustumCornersWorldSpace(subFrustumCamera);
+        const auto csmCamera = calculateCSMCamera(corners, sunDir, 4096.f);
+        views.push_back({
+            .volume = edge::createDirectionalLightCasterVolume(
+                edge::calculateFrustumCornersWorldSpace(csmCamera), sunDir),
+            .shadowCastersOnly = true,
+        });
+    }
+
+    // point lights
+    static const std::array<std::pair<glm::vec3, glm::vec3>, 6> shadowDirections{{
+        {{-1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}},
+        {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}},
+        {{0.0, -1.0, 0.0}, {0.0, 0.0, 1.0}},
+        {{0.0, 1.0, 0.0}, {0.0, 0.0, -1.0}},
+        {{0.0, 0.0, 1.0}, {0.0, 1.0, 0.0}},
+        {{0.0, 0.0, -1.0}, {0.0, 1.0, 0.0}},
+    }};
+    for (std::size_t j = 0; j < numPointLights; ++j) {
+        for (std::size_t i = 0; i < 6; ++i) {
+            Camera faceCamera;
+            faceCamera.setHeading(
+                glm::quatLookAt(shadowDirections[i].first, shadowDirections[i].second));
+            faceCamera.init(glm::radians(90.0f), 0.1f, 25.f, 1.f);
+            const auto lightPos = glm::vec3{j * 10.f - 40.f, 3.f, 5.f};
+            faceCamera.setPosition(lightPos);
+            views.push_back({
+                .volume = edge::createPointLightFaceCasterVolume(faceCamera, lightPos, 25.f),
+                .shadowCastersOnly = true,
+            });
+        }
+    }
+
+    return views;
+}
+
+// how the passes did it before CullingStage: one full scalar loop per view
+std::size_t cullScalarPerPass(
+    const std::vector<MeshDrawCommand>& dcs,
+    const std::vector<std::size_t>& order,
+    const std::vector<CullingStage::View>& views,
+    std::vector<std::vector<std::uint32_t>>& visible)
+{
+    std::size_t total = 0;
+    for (std::size_t v = 0; v < views.size(); ++v) {
+        const auto& view = views[v];
+        auto& out = visible[v];
+        out.clear();
+        for (const auto dcIdx : order) {
+            const auto& dc = dcs[dcIdx];
+            if (view.shadowCastersOnly && !dc.castShadow) {
+                continue;
+            }
+            if (!edge::isInVolume(view.volume, dc.worldBoundingSphere)) {
+                continue;
+            }
+            out.push_back((std::uint32_t)dcIdx);
+        }
+        total += out.size();
+    }
+    return total;
+}
+
+std::size_t cullWithStage(
+    CullingStage& stage,
+    const std::vector<MeshDrawCommand>& dcs,
+    const std::vector<std::size_t>& order,
+    const std::vector<CullingStage::View>& views,
+    JobSystem* jobSystem)
+{
+    stage.clear();
+    stage.setDrawCommands(dcs, order);
+    for (const auto& view : views) {
+        stage.addView(view);
+    }
+    stage.cull(jobSystem);
+
+    std::size_t total = 0;
+    for (std::size_t v = 0; v < stage.getNumViews(); ++v) {
+        total += stage.getVisibleDrawCommands(v).size();
+    }
+    return total;
+}
+
+} // end of anonymous namespace
+
+EDBR_BENCHMARK(FrustumCulling100k)
+{
+    static const std::size_t numDrawCommands = 100'000;
+    static const std::size_t numPointLights = 8;
+    static const int numIterations = 20;
+
+    const auto dcs = generateDrawCommands(numDrawCommands);
+    std::vector<std::size_t> order(dcs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    const auto views = createViews(numPointLights);
+    fmt::println("  {} draw commands, {} views", dcs.size(), views.size());
+
+    std::vector<std::vector<std::uint32_t>> visible(views.size());
+    std::size_t scalarTotal = 0;
+    const auto scalarMs = bench::measure("scalar, per pass", numIterations, [&]() {
+        scalarTotal = cullScalarPerPass(dcs, order, views, visible);
+        bench::doNotOptimize(scalarTotal);
+    });
+
+    CullingStage stage;
+    std::size_t stageTotal = 0;
+    const auto singleThreadMs = bench::measure("CullingStage, 1 thread", numIterations, [&]() {
+        stageTotal = cullWithStage(stage, dcs, order, views, nullptr);
+        bench::doNotOptimize(stageTotal);
+    });
+
+    JobSystem jobSystem;
+    const auto label = fmt::format("CullingStage, {} threads", jobSystem.getNumThreads());
+    const auto multiThreadMs = bench::measure(label, numIterations, [&]() {
+        stageTotal = cullWithStage(stage, dcs, order, views, &jobSystem);
+        bench::doNotOptimize(stageTotal);
+    });
+
+    if (scalarTotal != stageTotal) {
+        fmt::println("  ERROR: visible count mismatch ({} vs {})", scalarTotal, stageTotal);
+    }
+    fmt::println("  visible (all views): {}", stageTotal);
+    bench::printSpeedup("speedup (1 thread)", scalarMs, singleThreadMs);
+    bench::printSpeedup("speedup (all threads)", scalarMs, multiThreadMs);
+}
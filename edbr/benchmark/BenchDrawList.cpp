@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+
+#include <random>
+
+#include <entt/entity/registry.hpp>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/ECS/Components/TransformComponent.h>
+#include <edbr/ECS/ParallelForEach.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/ParallelDrawList.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <fmt/format.h>
+
+namespace
+{
+// what GameRenderer::drawMesh needs from MeshCache
+struct BenchMeshComponent {
+    MeshId meshId;
+    MaterialId materialId;
+    math::Sphere boundingSphere;
+    bool castShadow{true};
+};
+
+void fillRegistry(entt::registry& registry, std::size_t numEntities)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-500.f, 500.f};
+    std::uniform_real_distribution<float> angleDist{0.f, 6.28f};
+
+    for (std::size_t i = 0; i < numEntities; ++i) {
+        const auto e = registry.create();
+        auto& tc = registry.emplace<TransformComponent>(e);
+        tc.worldTransform = glm::translate(
+            glm::mat4{1.f}, glm::vec3{posDist(rng), posDist(rng) * 0.05f, posDist(rng)});
+        tc.worldTransform =
+            glm::rotate(tc.worldTransform, angleDist(rng), glm::vec3{0.f, 1.f, 0.f});
+        registry.emplace<BenchMeshComponent>(
+            e,
+            BenchMeshComponent{
+                .meshId = i % 500,
+                .materialId = (MaterialId)(i % 50),
+                .boundingSphere = {.center = {0.f, 1.f, 0.f}, .radius = 1.5f},
+                .castShadow = (i % 8) != 0,
+            });
+    }
+}
+
+MeshDrawCommand createDrawCommand(const TransformComponent& tc, const BenchMeshComponent& mc)
+{
+    return MeshDrawCommand{
+        .meshId = mc.meshId,
+        .transformMatrix = tc.worldTransform,
+        .worldBoundingSphere =
+            edge::calculateBoundingSphereWorld(tc.worldTransform, mc.boundingSphere, false),
+        .materialId = mc.materialId,
+        .castShadow = mc.castShadow,
+    };
+}
+} // end of anonymous namespace
+
+EDBR_BENCHMARK(DrawListGeneration200k)
+{
+    static const std::size_t numEntities = 200'000;
+    static const int numIterations = 20;
+    static const std::size_t chunkSize = 256;
+
+    entt::registry registry;
+    fillRegistry(registry, numEntities);
+    const auto view = registry.view<TransformComponent, BenchMeshComponent>();
+
+    // how Game::generateDrawList did it: one thread, one vector
+    std::vector<MeshDrawCommand> drawCommands;
+    const auto singleThreadMs = bench::measure("single thread", numIterations, [&]() {
+        drawCommands.clear();
+        for (const auto&& [e, tc, mc] : view.each()) {
+            drawCommands.push_back(createDrawCommand(tc, mc));
+        }
+        bench::doNotOptimize(drawCommands.size());
+    });
+
+    JobSystem jobSystem;
+    ParallelDrawList parallelDrawList;
+    std::vector<entt::entity> entities;
+    const auto label = fmt::format("parallel, {} threads", jobSystem.getNumThreads());
+    const auto parallelMs = bench::measure(label, numIterations, [&]() {
+        drawCommands.clear();
+        parallelDrawList.reset(jobSystem.getNumThreads());
+        edbr::ecs::parallelForEach(
+            jobSystem,
+            view,
+            entities,
+            chunkSize,
+            [&view, &parallelDrawList](entt::entity e, std::size_t threadIndex) {
+                const auto& [tc, mc] = view.get<TransformComponent, BenchMeshComponent>(e);
+                parallelDrawList.get(threadIndex).push_back(createDrawCommand(tc, mc));
+            });
+        parallelDrawList.mergeInto(drawCommands);
+        bench::doNotOptimize(drawCommands.size());
+    });
+
+    if (drawCommands.size() != numEntities) {
+        fmt::println("  ERROR: draw command count mismatch ({})", drawCommands.size());
+    }
+    bench::printSpeedup("speedup", singleThreadMs, parallelMs);
+}
@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <functional> // less
+#include <numeric> // iota
+#include <random>
+
+#include <edbr/Graphics/DrawSortKey.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Util/RadixSort.h>
+
+#include <fmt/format.h>
+
+namespace
+{
+std::vector<MeshDrawCommand> makeDrawCommands(std::size_t numDrawCommands)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-500.f, 500.f};
+    std::uniform_int_distribution<MeshId> meshDist{0, 999};
+    std::uniform_int_distribution<MaterialId> materialDist{0, 199};
+
+    std::vector<MeshDrawCommand> drawCommands(numDrawCommands);
+    for (auto& dc : drawCommands) {
+        dc.meshId = meshDist(rng);
+        dc.materialId = materialDist(rng);
+        dc.worldBoundingSphere = {
+            .center = {posDist(rng), posDist(rng), posDist(rng)},
+            .radius = 1.f,
+        };
+    }
+    return drawCommands;
+}
+
+void benchSort(std::size_t numDrawCommands, int numIterations)
+{
+    const auto drawCommands = makeDrawCommands(numDrawCommands);
+
+    // how GameRenderer::sortDrawList did it before
+    std::vector<std::size_t> sorted;
+    const auto comparisonMs = bench::measure("std::sort", numIterations, [&]() {
+        sorted.resize(drawCommands.size());
+        std::iota(sorted.begin(), sorted.end(), 0);
+        std::sort(sorted.begin(), sorted.end(), [&drawCommands](const auto& i1, const auto& i2) {
+            const auto& dc1 = drawCommands[i1];
+            const auto& dc2 = drawCommands[i2];
+            if (dc1.meshId != dc2.meshId) {
+                return dc1.meshId < dc2.meshId;
+            }
+            if (dc1.materialId != dc2.materialId) {
+                return dc1.materialId < dc2.materialId;
+            }
+            return std::less<const SkinnedMesh*>{}(dc1.skinnedMesh, dc2.skinnedMesh);
+        });
+        bench::doNotOptimize(sorted[0]);
+    });
+
+    // key building is included: GameRenderer rebuilds the keys every frame
+    std::vector<util::KeyIndex> keys;
+    std::vector<util::KeyIndex> scratch;
+    const auto radixMs = bench::measure("keys + radix sort", numIterations, [&]() {
+        keys.resize(drawCommands.size());
+        for (std::size_t i = 0; i < drawCommands.size(); ++i) {
+            const auto& dc = drawCommands[i];
+            keys[i] = util::KeyIndex{
+                .key = graphics::makeDrawSortKey(
+                    graphics::DrawSortPass::Opaque,
+                    dc.skinnedMesh != nullptr,
+                    dc.materialId,
+                    dc.meshId,
+                    dc.lod,
+                    (dc.worldBoundingSphere.center.z + 500.f) / 1000.f),
+                .index = (std::uint32_t)i,
+            };
+        }
+        util::radixSort(keys, scratch);
+        bench::doNotOptimize(keys[0].index);
+    });
+
+    bench::printSpeedup("speedup", comparisonMs, radixMs);
+}
+} // end of anonymous namespace
+
+EDBR_BENCHMARK(DrawListSort10k)
+{
+    benchSort(10'000, 200);
+}
+
+EDBR_BENCHMARK(DrawListSort100k)
+{
+    benchSort(100'000, 50);
+}
+
+EDBR_BENCHMARK(DrawListSort1M)
+{
+    benchSort(1'000'000, 10);
+}
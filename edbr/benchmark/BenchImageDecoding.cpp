@@ -0,0 +1,93 @@
+#include "Benchmark.h"
+
+#include <filesystem>
+
+#include <edbr/Core/TaskQueue.h>
+#include <edbr/Graphics/ImageCache.h>
+#include <edbr/Graphics/ImageLoader.h>
+
+#include <fmt/format.h>
+
+namespace
+{
+std::vector<std::filesystem::path> findImages(const std::filesystem::path& dir)
+{
+    std::vector<std::filesystem::path> paths;
+    for (const auto& p : std::filesystem::recursive_directory_iterator(dir)) {
+        const auto ext = p.path().extension();
+        if (p.is_regular_file() && (ext == ".png" || ext == ".jpg" || ext == ".jpeg")) {
+            paths.push_back(p.path());
+        }
+    }
+    return paths;
+}
+
+// decodes the same way as GfxDevice, but doesn't create GPU images
+ImageCache::Device makeDecodeOnlyDevice(std::size_t& numPixels)
+{
+    return ImageCache::Device{
+        .decodeImage = [](const ImageCache::LoadParams& params) -> std::optional<DecodedImage> {
+            DecodedImage decoded;
+            decoded.data = util::loadImage(params.path);
+            if (!decoded.data.pixels) {
+                return std::nullopt;
+            }
+            return decoded;
+        },
+        .createImage = [&numPixels](const ImageCache::LoadParams&, DecodedImage decoded)
+            -> std::optional<GPUImage> {
+            numPixels += (std::size_t)decoded.data.width * decoded.data.height;
+            return GPUImage{};
+        },
+        .destroyImage = [](const GPUImage&) {},
+        .setBindlessImage = [](ImageId, const GPUImage&) {},
+        .getMemorySize = [](const GPUImage&) { return std::size_t{0}; },
+    };
+}
+} // end of anonymous namespace
+
+EDBR_BENCHMARK(ImageDecoding)
+{
+    static const int numIterations = 3;
+    static const std::size_t numDecodeThreads = 4;
+
+    const auto dir = std::filesystem::path{EDBR_BENCHMARK_ASSETS_DIR} / "models";
+    if (!std::filesystem::exists(dir)) {
+        fmt::println("  {} not found, skipping", dir.string());
+        return;
+    }
+
+    std::vector<ImageCache::LoadParams> params;
+    for (const auto& path : findImages(dir)) {
+        params.push_back({
+            .path = path,
+            .format = VK_FORMAT_R8G8B8A8_SRGB,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+            .mipMap = true,
+        });
+    }
+    fmt::println("  {} images", params.size());
+
+    // how scenes loaded textures before: one after another on the calling thread
+    std::size_t numPixels = 0;
+    const auto singleThreadMs = bench::measure("single thread", numIterations, [&]() {
+        numPixels = 0;
+        ImageCache cache(makeDecodeOnlyDevice(numPixels));
+        for (const auto& p : params) {
+            bench::doNotOptimize(cache.loadImageFromFile(p.path, p.format, p.usage, p.mipMap));
+        }
+    });
+
+    TaskQueue decodeQueue(numDecodeThreads);
+    const auto label = fmt::format("batch, {} decode threads", numDecodeThreads);
+    const auto parallelMs = bench::measure(label, numIterations, [&]() {
+        numPixels = 0;
+        ImageCache cache(makeDecodeOnlyDevice(numPixels));
+        cache.setDecodeQueue(decodeQueue);
+        bench::doNotOptimize(cache.loadImagesFromFiles(params).size());
+        cache.waitForLoads();
+    });
+
+    fmt::println("  {:.1f} MPixels per iteration", numPixels / 1e6);
+    bench::printSpeedup("speedup", singleThreadMs, parallelMs);
+}
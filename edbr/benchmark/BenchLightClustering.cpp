@@ -0,0 +1,63 @@
+#include "Benchmark.h"
+
+#include <random>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/Light.h>
+#include <edbr/Graphics/LightClusterGrid.h>
+
+#include <fmt/format.h>
+
+namespace
+{
+// street lights, windows etc. of a night city around the camera
+std::vector<GPULightData> generateLights(std::size_t count)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-150.f, 150.f};
+    std::uniform_real_distribution<float> heightDist{0.f, 30.f};
+    std::uniform_real_distribution<float> rangeDist{2.f, 12.f};
+
+    std::vector<GPULightData> lights(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& light = lights[i];
+        light.position = {posDist(rng), heightDist(rng), posDist(rng)};
+        light.type = (i % 4 == 0) ? edbr::TYPE_SPOT_LIGHT : edbr::TYPE_POINT_LIGHT;
+        light.range = rangeDist(rng);
+    }
+    return lights;
+}
+}
+
+EDBR_BENCHMARK(LightClustering)
+{
+    static const int numIterations = 50;
+
+    Camera camera;
+    camera.setUseInverseDepth(true);
+    camera.init(glm::radians(60.f), 0.1f, 100.f, 16.f / 9.f);
+    camera.setPosition({0.f, 5.f, 0.f});
+
+    LightClusterGrid grid;
+    for (const auto numLights : {100, 1024, 4096}) {
+        const auto lights = generateLights(numLights);
+        const auto label = fmt::format("build, {} lights", numLights);
+        bench::measure(label, numIterations, [&]() {
+            grid.build(camera, lights);
+            bench::doNotOptimize(grid.getLightIndices().size());
+        });
+
+        // what mesh.frag has to loop over per fragment instead of all lights
+        std::size_t numNonEmpty = 0;
+        std::uint32_t maxLights = 0;
+        for (const auto& cluster : grid.getClusters()) {
+            numNonEmpty += (cluster.count != 0);
+            maxLights = std::max(maxLights, cluster.count);
+        }
+        fmt::println(
+            "    light indices: {}, avg lights per non-empty cluster: {:.2f}, max: {}",
+            grid.getLightIndices().size(),
+            numNonEmpty ? (double)grid.getLightIndices().size() / numNonEmpty : 0.0,
+            maxLights);
+    }
+}
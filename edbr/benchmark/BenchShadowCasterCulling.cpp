@@ -0,0 +1,211 @@
+#include "Benchmark.h"
+
+#include <random>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/CullingStage.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/ShadowCasterCulling.h>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <fmt/format.h>
+
+namespace
+{
+static const std::size_t NUM_FACES = 6;
+
+std::vector<MeshDrawCommand> generateDrawCommands(std::size_t count)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-200.f, 200.f};
+    std::uniform_real_distribution<float> heightDist{0.f, 20.f};
+    std::uniform_real_distribution<float> radiusDist{0.1f, 3.f};
+
+    std::vector<MeshDrawCommand> dcs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& dc = dcs[i];
+        dc.meshId = i % 500;
+        dc.worldBoundingSphere = math::Sphere{
+            .center = {posDist(rng), heightDist(rng), posDist(rng)},
+            .radius = radiusDist(rng),
+        };
+        dc.castShadow = true;
+    }
+    return dcs;
+}
+
+struct PointLight {
+    glm::vec3 position;
+    float range;
+};
+
+std::vector<PointLight> generateLights(std::size_t count)
+{
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> posDist{-60.f, 60.f};
+    std::uniform_real_distribution<float> rangeDist{8.f, 25.f};
+
+    std::vector<PointLight> lights(count);
+    for (auto& light : lights) {
+        light.position = {posDist(rng), 4.f, posDist(rng)};
+        light.range = rangeDist(rng);
+    }
+    return lights;
+}
+
+// same as in PointShadowAtlas
+std::array<Camera, NUM_FACES> createFaceCameras(const PointLight& light)
+{
+    static const std::array<std::pair<glm::vec3, glm::vec3>, NUM_FACES> faceDirections{{
+        {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+        {{-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}},
+        {{0.f, -1.f, 0.f}, {0.f, 0.f, -1.f}},
+        {{0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 0.f, -1.f}, {0.f, 1.f, 0.f}},
+    }};
+    std::array<Camera, NUM_FACES> cameras;
+    for (std::size_t i = 0; i < NUM_FACES; ++i) {
+        auto& camera = cameras[i];
+        camera.setHeading(glm::quatLookAt(-faceDirections[i].first, faceDirections[i].second));
+        camera.setPosition(light.position);
+        camera.init(glm::radians(90.f), 0.1f, 25.f, 1.f);
+    }
+    return cameras;
+}
+
+// how the faces were culled before: face camera frustum (with the far plane
+// at the max light range) and big objects were never culled
+std::size_t cullFaceFrustums(
+    const std::vector<MeshDrawCommand>& dcs,
+    const std::vector<Frustum>& frustums,
+    std::vector<std::vector<std::uint32_t>>& visible)
+{
+    static const float noCullRadius = 2.f;
+    std::size_t total = 0;
+    for (std::size_t v = 0; v < frustums.size(); ++v) {
+        auto& out = visible[v];
+        out.clear();
+        for (std::size_t i = 0; i < dcs.size(); ++i) {
+            const auto& sphere = dcs[i].worldBoundingSphere;
+            if (edge::isInFrustum(frustums[v], sphere) || sphere.radius >= noCullRadius) {
+                out.push_back((std::uint32_t)i);
+            }
+        }
+        total += out.size();
+    }
+    return total;
+}
+
+std::size_t cullVolumesScalar(
+    const std::vector<MeshDrawCommand>& dcs,
+    const std::vector<CullingStage::View>& views,
+    std::vector<std::vector<std::uint32_t>>& visible)
+{
+    std::size_t total = 0;
+    for (std::size_t v = 0; v < views.size(); ++v) {
+        auto& out = visible[v];
+        out.clear();
+        for (std::size_t i = 0; i < dcs.size(); ++i) {
+            if (edge::isInVolume(views[v].volume, dcs[i].worldBoundingSphere)) {
+                out.push_back((std::uint32_t)i);
+            }
+        }
+        total += out.size();
+    }
+    return total;
+}
+
+std::size_t cullVolumesWithStage(
+    CullingStage& stage,
+    const std::vector<MeshDrawCommand>& dcs,
+    const std::vector<std::size_t>& order,
+    const std::vector<CullingStage::View>& views,
+    JobSystem* jobSystem)
+{
+    stage.clear();
+    stage.setDrawCommands(dcs, order);
+    for (const auto& view : views) {
+        stage.addView(view);
+    }
+    stage.cull(jobSystem);
+
+    std::size_t total = 0;
+    for (std::size_t v = 0; v < stage.getNumViews(); ++v) {
+        total += stage.getVisibleDrawCommands(v).size();
+    }
+    return total;
+}
+
+} // end of anonymous namespace
+
+EDBR_BENCHMARK(ShadowCasterCulling100k)
+{
+    static const std::size_t numDrawCommands = 100'000;
+    static const std::size_t numPointLights = 16;
+    static const int numIterations = 10;
+
+    const auto dcs = generateDrawCommands(numDrawCommands);
+    std::vector<std::size_t> order(dcs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+    std::vector<Frustum> faceFrustums;
+    std::vector<CullingStage::View> views;
+    for (const auto& light : generateLights(numPointLights)) {
+        for (const auto& camera : createFaceCameras(light)) {
+            faceFrustums.push_back(edge::createFrustumFromCamera(camera));
+            views.push_back({
+                .volume =
+                    edge::createPointLightFaceCasterVolume(camera, light.position, light.range),
+                .shadowCastersOnly = true,
+            });
+        }
+    }
+    fmt::println(
+        "  {} draw commands, {} lights x {} faces", dcs.size(), numPointLights, NUM_FACES);
+
+    std::vector<std::vector<std::uint32_t>> visible(views.size());
+    std::size_t frustumTotal = 0;
+    const auto frustumMs = bench::measure("face frustums, scalar", numIterations, [&]() {
+        frustumTotal = cullFaceFrustums(dcs, faceFrustums, visible);
+        bench::doNotOptimize(frustumTotal);
+    });
+
+    std::size_t scalarTotal = 0;
+    const auto scalarMs = bench::measure("caster volumes, scalar", numIterations, [&]() {
+        scalarTotal = cullVolumesScalar(dcs, views, visible);
+        bench::doNotOptimize(scalarTotal);
+    });
+
+    CullingStage stage;
+    std::size_t stageTotal = 0;
+    const auto singleThreadMs =
+        bench::measure("caster volumes, CullingStage, 1 thread", numIterations, [&]() {
+            stageTotal = cullVolumesWithStage(stage, dcs, order, views, nullptr);
+            bench::doNotOptimize(stageTotal);
+        });
+
+    JobSystem jobSystem;
+    const auto label =
+        fmt::format("caster volumes, CullingStage, {} threads", jobSystem.getNumThreads());
+    const auto multiThreadMs = bench::measure(label, numIterations, [&]() {
+        stageTotal = cullVolumesWithStage(stage, dcs, order, views, &jobSystem);
+        bench::doNotOptimize(stageTotal);
+    });
+
+    if (scalarTotal != stageTotal) {
+        fmt::println("  ERROR: visible count mismatch ({} vs {})", scalarTotal, stageTotal);
+    }
+    fmt::println(
+        "  casters per face: {:.1f} (face frustums) vs {:.1f} (caster volumes)",
+        (double)frustumTotal / (double)views.size(),
+        (double)stageTotal / (double)views.size());
+    bench::printSpeedup("speedup vs scalar volumes (1 thread)", scalarMs, singleThreadMs);
+    bench::printSpeedup("speedup vs face frustums (1 thread)", frustumMs, singleThreadMs);
+    bench::printSpeedup("speedup vs face frustums (all threads)", frustumMs, multiThreadMs);
+}
@@ -0,0 +1,108 @@
+#include "Benchmark.h"
+
+#include <filesystem>
+#include <tuple>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <edbr/Graphics/AnimationSampling.h>
+#include <edbr/Graphics/Scene.h>
+#include <edbr/Util/GltfLoader.h>
+
+#include <fmt/format.h>
+
+namespace
+{
+// how SkeletonAnimator sampled animations before
+std::tuple<std::size_t, std::size_t, float> findPrevNextKeys(std::size_t numKeys, float time)
+{
+    const std::size_t prevKey =
+        std::min((std::size_t)std::floor(time * graphics::ANIMATION_FPS), numKeys - 1);
+    const std::size_t nextKey = std::min(prevKey + 1, numKeys - 1);
+
+    float t{0.f};
+    if (prevKey != nextKey) {
+        t = time * graphics::ANIMATION_FPS - (float)prevKey;
+    }
+
+    return {prevKey, nextKey, t};
+}
+
+glm::mat4 sampleAnimation(const SkeletalAnimation& animation, JointId jointId, float time)
+{
+    const auto& ts = animation.tracks[jointId];
+
+    glm::mat4 tm{1.f};
+    if (const auto& tc = ts.translations; !tc.empty()) {
+        const auto [p, n, t] = findPrevNextKeys(tc.size(), time);
+        tm[3] = glm::vec4(glm::mix(tc[p], tc[n], t), 1.f);
+    }
+    if (const auto& rc = ts.rotations; !rc.empty()) {
+        const auto [p, n, t] = findPrevNextKeys(rc.size(), time);
+        tm *= glm::mat4_cast(glm::slerp(rc[p], rc[n], t));
+    }
+    if (const auto& sc = ts.scales; !sc.empty()) {
+        const auto [p, n, t] = findPrevNextKeys(sc.size(), time);
+        tm = glm::scale(tm, glm::mix(sc[p], sc[n], t));
+    }
+    return tm;
+}
+
+void calculateJointMatrix(
+    const Skeleton& skeleton,
+    JointId jointId,
+    const SkeletalAnimation& animation,
+    float time,
+    const glm::mat4& parentTransform,
+    std::vector<glm::mat4>& jointMatrices)
+{
+    const auto modelTransform = parentTransform * sampleAnimation(animation, jointId, time);
+    jointMatrices[jointId] = modelTransform * skeleton.inverseBindMatrices[jointId];
+    for (const auto childIdx : skeleton.hierarchy[jointId].children) {
+        calculateJointMatrix(skeleton, childIdx, animation, time, modelTransform, jointMatrices);
+    }
+}
+} // end of anonymous namespace
+
+EDBR_BENCHMARK(SkeletalAnimation1000)
+{
+    static const std::size_t numSkeletons = 1000;
+    static const int numIterations = 50;
+
+    const auto path = std::filesystem::path{EDBR_BENCHMARK_ASSETS_DIR} / "models/cato.gltf";
+    if (!std::filesystem::exists(path)) {
+        fmt::println("  {} not found, skipping", path.string());
+        return;
+    }
+    const auto scene = util::loadGltfAnimations(path);
+    const auto& skeleton = scene.skeletons.at(0);
+    const auto& animation = scene.animations.at("Run");
+    fmt::println("  {} joints, {} keys", skeleton.joints.size(), animation.soaTracks.numKeys);
+
+    // every skeleton is at a different point of the animation
+    std::vector<float> times(numSkeletons);
+    for (std::size_t i = 0; i < numSkeletons; ++i) {
+        times[i] = animation.duration * (float)i / (float)numSkeletons;
+    }
+    std::vector<std::vector<glm::mat4>> jointMatrices(
+        numSkeletons, std::vector<glm::mat4>(skeleton.joints.size()));
+
+    const auto recursiveMs = bench::measure("recursive, AoS tracks", numIterations, [&]() {
+        for (std::size_t i = 0; i < numSkeletons; ++i) {
+            calculateJointMatrix(
+                skeleton, ROOT_JOINT_ID, animation, times[i], glm::mat4{1.f}, jointMatrices[i]);
+        }
+        bench::doNotOptimize((std::size_t)jointMatrices.back()[0][3][0]);
+    });
+
+    std::vector<glm::mat4> transforms;
+    const auto flatMs = bench::measure("flat, SoA tracks, SIMD", numIterations, [&]() {
+        for (std::size_t i = 0; i < numSkeletons; ++i) {
+            graphics::sampleJointMatrices(
+                skeleton.flatSkeleton, animation.soaTracks, times[i], jointMatrices[i], transforms);
+        }
+        bench::doNotOptimize((std::size_t)jointMatrices.back()[0][3][0]);
+    });
+
+    bench::printSpeedup("speedup", recursiveMs, flatMs);
+}
@@ -0,0 +1,52 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+
+namespace bench
+{
+std::vector<Benchmark>& getBenchmarks()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+Registrar::Registrar(const char* name, std::function<void()> func)
+{
+    getBenchmarks().push_back(Benchmark{.name = name, .func = std::move(func)});
+}
+
+void doNotOptimize(std::size_t value)
+{
+    static volatile std::size_t sink;
+    sink = value;
+}
+
+double measure(const std::string& label, int numIterations, const std::function<void()>& f)
+{
+    using Clock = std::chrono::steady_clock;
+
+    f(); // warm up
+
+    double minMs = std::numeric_limits<double>::max();
+    double totalMs = 0.0;
+    for (int i = 0; i < numIterations; ++i) {
+        const auto start = Clock::now();
+        f();
+        const auto end = Clock::now();
+        const auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+        minMs = std::min(minMs, ms);
+        totalMs += ms;
+    }
+
+    const auto avgMs = totalMs / numIterations;
+    fmt::println("  {:<48} avg: {:>9.3f} ms, min: {:>9.3f} ms", label, avgMs, minMs);
+    return avgMs;
+}
+
+void printSpeedup(const std::string& label, double baselineMs, double ms)
+{
+    fmt::println("  {:<48} x{:.2f}", label, baselineMs / ms);
+}
+}
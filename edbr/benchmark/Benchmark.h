@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Tiny benchmark harness: benchmarks are registered with EDBR_BENCHMARK
+// and run by edbr_benchmark executable (use --filter to run only some of them)
+namespace bench
+{
+struct Benchmark {
+    std::string name;
+    std::function<void()> func;
+};
+
+std::vector<Benchmark>& getBenchmarks();
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> func);
+};
+
+// Prevents the compiler from optimizing the computation of value away
+void doNotOptimize(std::size_t value);
+
+// Runs f once to warm up and then numIterations times.
+// Prints and returns the average time of one iteration in milliseconds.
+double measure(const std::string& label, int numIterations, const std::function<void()>& f);
+
+// Prints "<label>: x<N>"
+void printSpeedup(const std::string& label, double baselineMs, double ms);
+}
+
+#define EDBR_BENCHMARK(name)                                                                       \
+    static void name();                                                                            \
+    static const bench::Registrar name##Registrar{#name, &name};                                   \
+    static void name()
@@ -0,0 +1,28 @@
+#include "Benchmark.h"
+
+#include <CLI/CLI.hpp>
+
+#include <fmt/format.h>
+
+int main(int argc, char** argv)
+{
+    CLI::App app{"EDBR CPU benchmarks"};
+
+    std::string filter;
+    bool listOnly{false};
+    app.add_option("-f,--filter", filter, "Only run benchmarks which contain this string");
+    app.add_flag("-l,--list", listOnly, "List benchmarks");
+    CLI11_PARSE(app, argc, argv);
+
+    for (const auto& benchmark : bench::getBenchmarks()) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        if (listOnly) {
+            fmt::println("{}", benchmark.name);
+            continue;
+        }
+        fmt::println("{}", benchmark.name);
+        benchmark.func();
+    }
+}
@@ -6,6 +6,8 @@
 
 #include <edbr/ActionList/ActionListManager.h>
 #include <edbr/Audio/IAudioManager.h>
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Core/TaskQueue.h>
 #include <edbr/DevTools/ScreenshotTaker.h>
 #include <edbr/Event/EventManager.h>
 #include <edbr/Graphics/GfxDevice.h>
@@ -82,6 +84,8 @@ protected:
 
     CLI::App cliApp{};
 
+    JobSystem jobSystem;
+    TaskQueue taskQueue; // for loading resources in background
     InputManager inputManager;
     EventManager eventManager;
     ActionListManager actionListManager;
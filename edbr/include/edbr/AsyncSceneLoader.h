@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <edbr/Graphics/Scene.h>
+#include <edbr/Util/CookedScene.h>
+
+class TaskQueue;
+
+// Result of the CPU part of scene loading
+using DecodedScene = std::variant<SceneData, CookedScene>;
+
+// Handle to a scene loaded by AsyncSceneLoader. Can be copied and kept
+// around, e.g. by action lists which wait for the scene to become ready.
+class SceneLoadHandle {
+public:
+    // handle of the scene which was already loaded
+    static SceneLoadHandle makeReady(const std::filesystem::path& path);
+
+    bool isValid() const { return state != nullptr; }
+
+    // the scene was added to SceneCache and its GPU uploads are complete
+    // (textures can still be loading, see ImageCache::loadImagesFromFiles)
+    bool isReady() const;
+    bool hasFailed() const;
+    bool isDone() const { return isReady() || hasFailed(); }
+
+    const std::filesystem::path& getPath() const;
+
+private:
+    friend class AsyncSceneLoader;
+    struct State;
+
+    std::shared_ptr<State> state;
+};
+
+// Loads scenes in three stages:
+//   1. Decode (on TaskQueue threads): file I/O, glTF parsing, building CPU meshes
+//   2. Upload (on the main thread, in update): creates GPU resources and records
+//      uploads. All scenes decoded since the previous update are submitted together.
+//   3. Wait until the submission completes on GPU (polled in update)
+// The stages are passed in as functions, so that the loader can be tested without GPU.
+class AsyncSceneLoader {
+public:
+    struct Stages {
+        // called on TaskQueue threads, can throw
+        std::function<DecodedScene(const std::filesystem::path&)> decode;
+        // the rest is called on the main thread
+        std::function<Scene(const std::filesystem::path&, DecodedScene)> upload;
+        // submits recorded uploads, returns the value passed to isUploadComplete
+        std::function<std::uint64_t()> submit;
+        std::function<bool(std::uint64_t)> isUploadComplete;
+        std::function<void(std::uint64_t)> waitForUpload;
+        std::function<void(const std::filesystem::path&, Scene)> onLoaded;
+    };
+
+public:
+    AsyncSceneLoader(TaskQueue& taskQueue, Stages stages);
+
+    // If the scene is already being loaded, returns its handle
+    SceneLoadHandle load(const std::filesystem::path& path);
+
+    // Should be called every frame on the main thread
+    void update();
+
+    // Blocks until the scene is loaded (or fails to load)
+    void wait(const SceneLoadHandle& handle);
+
+    // returns an invalid handle if the scene isn't being loaded
+    SceneLoadHandle findLoadingScene(const std::filesystem::path& path) const;
+    std::size_t getNumLoadingScenes() const { return loadingScenes.size(); }
+
+private:
+    TaskQueue& taskQueue;
+    Stages stages;
+
+    std::vector<SceneLoadHandle> loadingScenes;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A simple pool of worker threads for data-parallel work.
+// parallelFor splits [0, count) into batches and runs them on the workers
+// and on the calling thread. It blocks until all batches are finished.
+class JobSystem {
+public:
+    // begin, end, thread index (0 - calling thread, 1..N - workers)
+    using BatchFunc = std::function<void(std::size_t, std::size_t, std::size_t)>;
+
+public:
+    // numWorkers == 0 - run everything on the calling thread
+    explicit JobSystem(std::size_t numWorkers = getDefaultNumWorkers());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void parallelFor(std::size_t count, std::size_t batchSize, const BatchFunc& f);
+
+    // number of threads which can run batches at the same time (including the calling thread)
+    // thread indices passed to BatchFunc are always less than this number
+    std::size_t getNumThreads() const { return workers.size() + 1; }
+
+    static std::size_t getDefaultNumWorkers();
+
+private:
+    struct Task;
+
+    void workerLoop(std::size_t threadIndex);
+    void runBatches(Task& task, std::size_t threadIndex);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeCV;
+    std::condition_variable doneCV;
+    std::shared_ptr<Task> currentTask;
+    std::size_t taskGeneration{0};
+    bool stopping{false};
+
+    std::mutex submitMutex; // only one parallelFor can run at a time
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Vectors which JobSystem threads append to without locking: each thread
+// gets its own vector (indexed by the thread index JobSystem passes to batch
+// functions). The vectors are merged after parallelFor is done.
+template<typename T>
+class PerThreadVector {
+public:
+    void reset(std::size_t numThreads)
+    {
+        assert(numThreads > 0);
+        threadVectors.resize(numThreads);
+        for (auto& tv : threadVectors) {
+            tv.elements.clear();
+        }
+    }
+
+    std::vector<T>& get(std::size_t threadIndex)
+    {
+        assert(threadIndex < threadVectors.size());
+        return threadVectors[threadIndex].elements;
+    }
+
+    // Appends all the per-thread vectors to out (in thread index order) and
+    // clears them. The capacity of the per-thread vectors is kept.
+    void mergeInto(std::vector<T>& out)
+    {
+        out.reserve(out.size() + getNumElements());
+        for (auto& tv : threadVectors) {
+            out.insert(out.end(), tv.elements.begin(), tv.elements.end());
+            tv.elements.clear();
+        }
+    }
+
+    std::size_t getNumThreads() const { return threadVectors.size(); }
+
+    std::size_t getNumElements() const
+    {
+        std::size_t count = 0;
+        for (const auto& tv : threadVectors) {
+            count += tv.elements.size();
+        }
+        return count;
+    }
+
+private:
+    // each vector is on its own cache line so that threads don't fight
+    // over vector's begin/end pointers
+    struct alignas(64) ThreadVector {
+        std::vector<T> elements;
+    };
+    std::vector<ThreadVector> threadVectors;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs long tasks (e.g. loading files) on background threads.
+// Unlike JobSystem::parallelFor, push doesn't wait for the task to finish:
+// tasks report their results themselves (see AsyncSceneLoader).
+// Tasks are started in the order they were pushed.
+class TaskQueue {
+public:
+    using TaskFunc = std::function<void()>;
+
+public:
+    // numThreads == 0 - run tasks immediately in push
+    explicit TaskQueue(std::size_t numThreads = 2);
+    // finishes all pushed tasks
+    ~TaskQueue();
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    void push(TaskFunc task);
+
+    // blocks until all pushed tasks are finished
+    void waitIdle();
+
+    std::size_t getNumThreads() const { return threads.size(); }
+
+private:
+    void threadLoop();
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wakeCV;
+    std::condition_variable idleCV;
+    std::deque<TaskFunc> tasks;
+    std::size_t numRunningTasks{0};
+    bool stopping{false};
+};
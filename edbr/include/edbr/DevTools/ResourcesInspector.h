@@ -2,8 +2,13 @@
 
 class ImageCache;
 class MaterialCache;
+class SkeletalAnimationCache;
 
 class ResourcesInspector {
 public:
-    void update(float dt, const ImageCache& imageCache, const MaterialCache& materialCache);
+    void update(
+        float dt,
+        const ImageCache& imageCache,
+        const MaterialCache& materialCache,
+        const SkeletalAnimationCache& animationCache);
 };
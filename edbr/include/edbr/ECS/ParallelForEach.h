@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <edbr/Core/JobSystem.h>
+
+namespace edbr::ecs
+{
+// Calls f(entity, threadIndex) for every entity of the view. Entities are
+// gathered into the entities vector (kept by the caller to reuse its memory)
+// and split into chunks of chunkSize which are processed on JobSystem threads.
+// f can read the components of the entity, but should only write into
+// per-thread storage (e.g. ParallelDrawList) - it runs on several threads at once.
+template<typename View, typename F>
+void parallelForEach(
+    JobSystem& jobSystem,
+    const View& view,
+    std::vector<typename View::entity_type>& entities,
+    std::size_t chunkSize,
+    F&& f)
+{
+    entities.clear();
+    for (const auto e : view) {
+        entities.push_back(e);
+    }
+
+    jobSystem.parallelFor(
+        entities.size(),
+        chunkSize,
+        [&entities, &f](std::size_t begin, std::size_t end, std::size_t threadIndex) {
+            for (std::size_t i = begin; i < end; ++i) {
+                f(entities[i], threadIndex);
+            }
+        });
+}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+struct SkeletalAnimation;
+struct SoAAnimation;
+
+// Compressed SkeletalAnimation. Each track only keeps the keys which can't be
+// restored by interpolating between their neighbours (within a tolerance).
+// Constant tracks are reduced to one key and identity tracks are dropped.
+// Translations and scales are quantized to 16 bits per component within the
+// track's range, rotations are stored as "smallest three" in 48 bits.
+// Keys of all tracks are stored in shared arrays.
+struct CompressedAnimation {
+    enum class TrackType { Translation, Rotation, Scale };
+    static constexpr std::size_t NUM_TRACK_TYPES = 3;
+
+    struct Track {
+        std::uint32_t firstKey{0}; // index into keyValues / 3
+        std::uint32_t firstFrame{0}; // index into keyFrames (constant tracks have no frames)
+        std::uint16_t numKeys{0}; // 0 - identity, 1 - constant
+        std::uint16_t rangeIndex{0}; // index into ranges (translation/scale only)
+    };
+
+    struct Range {
+        glm::vec3 min;
+        glm::vec3 extent;
+    };
+
+    // max difference between the original and the decompressed animation
+    struct Error {
+        float translation{0.f};
+        float rotation{0.f}; // in radians
+        float scale{0.f};
+    };
+
+    std::vector<Track> tracks; // [jointId * NUM_TRACK_TYPES + TrackType]
+    std::vector<std::uint16_t> keyFrames;
+    std::vector<std::uint16_t> keyValues; // 3 per key
+    std::vector<Range> ranges;
+    Error error;
+
+    // not compressed
+    std::string name;
+    float duration{0.f};
+    bool looped{true};
+    int startFrame{0};
+    std::map<int, std::vector<std::string>> events;
+
+    std::size_t getNumJoints() const { return tracks.size() / NUM_TRACK_TYPES; }
+    const Track& getTrack(std::size_t jointId, TrackType type) const
+    {
+        return tracks[jointId * NUM_TRACK_TYPES + (std::size_t)type];
+    }
+};
+
+namespace graphics
+{
+struct AnimationCompressionSettings {
+    float translationTolerance{0.001f};
+    float rotationTolerance{0.004f}; // in radians
+    float scaleTolerance{0.001f};
+};
+
+CompressedAnimation compressAnimation(
+    const SkeletalAnimation& animation,
+    const AnimationCompressionSettings& settings = {});
+
+// Restores keys for every frame (soaTracks are rebuilt too)
+SkeletalAnimation decompressAnimation(const CompressedAnimation& animation);
+
+// Memory used by translation/rotation/scale keys in bytes
+std::size_t getTrackDataSize(const SkeletalAnimation& animation);
+std::size_t getTrackDataSize(const CompressedAnimation& animation);
+std::size_t getTrackDataSize(const SoAAnimation& animation);
+}
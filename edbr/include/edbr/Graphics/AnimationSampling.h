@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include <edbr/Graphics/IdTypes.h>
+
+struct Skeleton;
+struct SkeletalAnimation;
+
+// Skeleton joints in flat arrays sorted topologically (parents always go
+// before children), so that the hierarchy can be walked without recursion.
+// Only joints reachable from ROOT_JOINT_ID are included.
+struct FlatSkeleton {
+    static constexpr JointId NO_PARENT = NULL_JOINT_ID;
+
+    std::vector<JointId> jointIds; // flat index -> JointId
+    std::vector<JointId> parents; // flat index -> parent's JointId
+    std::vector<glm::mat4> inverseBindMatrices; // by flat index
+
+    std::size_t getNumJoints() const { return jointIds.size(); }
+};
+
+// Animation tracks in SoA layout: for every key, the values of all joints
+// (by JointId) are stored next to each other, so that several joints can be
+// sampled at once. Keys are sampled with ANIMATION_FPS.
+struct SoAAnimation {
+    std::size_t numKeys{0};
+    std::size_t numLanes{0}; // number of joints rounded up to the SIMD width
+    std::vector<float> translations; // [key][x, y, z][lane]
+    std::vector<float> rotations; // [key][x, y, z, w][lane]
+    std::vector<float> scales; // [key][x, y, z][lane]
+};
+
+// Local (parent-relative) transforms of all joints in the same layout as one
+// key of SoAAnimation. Animations are sampled and blended as local poses,
+// and only the final pose is converted into joint matrices.
+struct LocalPose {
+    std::size_t numLanes{0};
+    std::vector<float> translations; // [x, y, z][lane]
+    std::vector<float> rotations; // [x, y, z, w][lane]
+    std::vector<float> scales; // [x, y, z][lane]
+};
+
+// Keeps LocalPose buffers between frames so that blending doesn't allocate.
+// Poses are acquired during the frame and all of them are released at once.
+class LocalPosePool {
+public:
+    LocalPose& acquire();
+    void releaseAll() { numUsed = 0; }
+
+    std::size_t getNumPoses() const { return poses.size(); }
+
+private:
+    std::deque<LocalPose> poses; // deque - references to poses stay valid
+    std::size_t numUsed{0};
+};
+
+namespace graphics
+{
+static constexpr int ANIMATION_FPS = 30;
+static constexpr std::size_t ANIMATION_SIMD_WIDTH = 4;
+
+FlatSkeleton makeFlatSkeleton(const Skeleton& skeleton);
+SoAAnimation makeSoAAnimation(const SkeletalAnimation& animation);
+
+// Makes an animation for additive blending (see addLocalPose): each key
+// stores the difference between the key and the first key of the animation
+SoAAnimation makeAdditiveAnimation(const SoAAnimation& animation);
+
+// Samples the animation at time (in seconds) and writes skinning matrices
+// (indexed by JointId) into jointMatrices.
+// Rotations are interpolated with nlerp, which is close enough to slerp
+// for keys sampled at ANIMATION_FPS.
+// transforms is a scratch buffer (kept by the caller to reuse its memory).
+void sampleJointMatrices(
+    const FlatSkeleton& skeleton,
+    const SoAAnimation& animation,
+    float time,
+    std::span<glm::mat4> jointMatrices,
+    std::vector<glm::mat4>& transforms);
+
+// Samples the animation at time (in seconds) into pose
+void sampleLocalPose(const SoAAnimation& animation, float time, LocalPose& pose);
+
+// out = nlerp(a, b, weight), out can be the same pose as a or b
+void blendLocalPoses(const LocalPose& a, const LocalPose& b, float weight, LocalPose& out);
+
+// Applies additive pose (sampled from makeAdditiveAnimation's result) on top of pose
+void addLocalPose(LocalPose& pose, const LocalPose& additive, float weight);
+
+// Same as sampleJointMatrices, but for an already sampled (and blended) pose
+void calculateJointMatrices(
+    const FlatSkeleton& skeleton,
+    const LocalPose& pose,
+    std::span<glm::mat4> jointMatrices,
+    std::vector<glm::mat4>& transforms);
+}
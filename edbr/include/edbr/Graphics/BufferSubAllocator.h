@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+
+// BufferSubAllocator manages ranges inside one big buffer. It doesn't
+// know anything about the GPU - offsets and sizes are in abstract units
+// (e.g. vertices or indices). Free ranges are coalesced on free().
+class BufferSubAllocator {
+public:
+    BufferSubAllocator() = default;
+    explicit BufferSubAllocator(std::size_t capacity);
+
+    // Returns the offset of the allocated range or nullopt if there's no
+    // free range big enough (first fit)
+    [[nodiscard]] std::optional<std::size_t> allocate(std::size_t size);
+    void free(std::size_t offset, std::size_t size);
+
+    // New space is appended to the end of the managed range
+    void grow(std::size_t newCapacity);
+
+    std::size_t getCapacity() const { return capacity; }
+    std::size_t getUsedSize() const { return usedSize; }
+    std::size_t getNumFreeRanges() const { return freeRanges.size(); }
+
+private:
+    std::size_t capacity{0};
+    std::size_t usedSize{0};
+    std::map<std::size_t, std::size_t> freeRanges; // offset -> size
+};
@@ -8,6 +8,7 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+#include <edbr/Graphics/Meshlet.h>
 #include <edbr/Graphics/Skeleton.h>
 
 struct CPUMesh {
@@ -35,4 +36,16 @@ struct CPUMesh {
 
     glm::vec3 minPos;
     glm::vec3 maxPos;
+
+    // simplified versions of the mesh which use the same vertices
+    // (see graphics::generateMeshLODs)
+    struct LOD {
+        std::vector<std::uint32_t> indices;
+        float error{0.f}; // max distance from the original surface (in mesh units)
+    };
+    std::vector<LOD> lods; // LOD 1, 2, ... (LOD 0 is the mesh itself)
+
+    // clusters of the mesh's triangles (see graphics::generateMeshlets),
+    // LODs don't have them
+    std::vector<Meshlet> meshlets;
 };
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Math/Sphere.h>
+
+struct MeshDrawCommand;
+
+// Decides when cached cascaded shadow maps need to be redrawn (see CSMPipeline).
+// Static shadow casters are drawn once into a persistent layer per cascade,
+// dynamic casters are drawn on top of its copy every frame.
+// Each cascade keeps its light camera while the cascade's bounding sphere still
+// fits into it: the camera is made moveThresholdTexels bigger than needed, so
+// the view camera can move by that much before the static layer is redrawn.
+// Static layers are also redrawn when the light direction or the static
+// casters change.
+class CSMCache {
+public:
+    enum class UpdateType {
+        None, // shadow map is kept from the previous frame
+        Dynamic, // static layer is copied, dynamic casters are drawn on top of it
+        Full, // static layer is redrawn first, then same as Dynamic
+    };
+
+    struct Params {
+        float shadowMapSize{4096.f};
+        float moveThresholdTexels{64.f};
+        // static layer is redrawn if the cascade shrinks (e.g. after changing
+        // the cascade split) below this fraction, so that resolution isn't wasted
+        float minRadiusRatio{0.75f};
+        // cascades with index >= firstFarCascade get dynamic casters drawn every
+        // other frame (static layer is still redrawn immediately when needed)
+        bool updateFarCascadesEveryOtherFrame{false};
+        std::size_t firstFarCascade{2};
+    };
+
+public:
+    void init(std::size_t numCascades, const Params& params);
+
+    // cascadeBounds - spheres which must be covered by each cascade
+    void update(
+        std::span<const math::Sphere> cascadeBounds,
+        const glm::vec3& lightDir,
+        std::uint64_t staticCastersHash);
+    // forces full update of all cascades next frame
+    void invalidate();
+
+    UpdateType getUpdateType(std::size_t cascadeIndex) const;
+    // camera which should be used for drawing and sampling the cascade
+    const Camera& getCamera(std::size_t cascadeIndex) const;
+    float getRadius(std::size_t cascadeIndex) const;
+
+    std::size_t getNumCascades() const { return cascades.size(); }
+    const Params& getParams() const { return params; }
+    // invalidates cached cascades if the size or threshold change
+    void setParams(const Params& params);
+
+private:
+    bool canKeepCamera(
+        std::size_t cascadeIndex,
+        const math::Sphere& bounds,
+        const glm::vec3& lightDir) const;
+    void fitCamera(std::size_t cascadeIndex, const math::Sphere& bounds, const glm::vec3& lightDir);
+
+    struct Cascade {
+        bool valid{false};
+        Camera camera;
+        glm::vec3 center; // snapped to texels
+        float radius{0.f};
+        UpdateType updateType{UpdateType::Full};
+    };
+    std::vector<Cascade> cascades;
+    Params params;
+
+    glm::vec3 lightDir{};
+    std::uint64_t staticCastersHash{0};
+    std::uint64_t frameIndex{0};
+};
+
+namespace graphics
+{
+// Hash of the caster's mesh, material and transform
+std::uint64_t hashShadowCaster(const MeshDrawCommand& dc);
+
+// Order-independent hash of static shadow casters (MeshDrawCommand::isStatic),
+// so that draw lists built by several threads hash the same way every frame
+std::uint64_t hashStaticShadowCasters(std::span<const MeshDrawCommand> drawCommands);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <edbr/Graphics/FrustumCulling.h>
+
+class JobSystem;
+struct MeshDrawCommand;
+
+// CullingStage tests the bounding spheres of all draw commands against every
+// active view (main camera, CSM cascades, point light cube faces) in one sweep.
+// Spheres are stored as SoA so that 4 of them are tested against a plane at once (SSE)
+// and the sweep is split between JobSystem threads.
+// Each view gets its own compact list of visible draw command indices.
+class CullingStage {
+public:
+    struct View {
+        // camera frustum or shadow caster volume (see ShadowCasterCulling.h)
+        CullingVolume volume;
+        // if true, draw commands with castShadow == false are never visible
+        bool shadowCastersOnly{false};
+    };
+
+public:
+    void clear();
+
+    // order - the order in which the draw commands will be stored in the visible lists
+    // (e.g. sorted draw list)
+    void setDrawCommands(
+        const std::vector<MeshDrawCommand>& drawCommands,
+        std::span<const std::size_t> order);
+    std::size_t addView(const View& view);
+
+    // jobSystem can be nullptr - everything will be done on the calling thread
+    void cull(JobSystem* jobSystem);
+
+    std::span<const std::uint32_t> getVisibleDrawCommands(std::size_t viewIndex) const;
+
+    std::size_t getNumViews() const { return views.size(); }
+    std::size_t getNumDrawCommands() const { return numDrawCommands; }
+
+private:
+    void cullRange(std::size_t begin, std::size_t end);
+
+    static constexpr std::size_t CHUNK_SIZE = 1024; // must be divisible by 4
+
+    struct ViewData {
+        View view;
+        std::vector<std::uint32_t> visible;
+        std::size_t numVisible{0};
+        std::vector<std::uint32_t> chunkCounts;
+    };
+    std::vector<ViewData> views;
+
+    std::size_t numDrawCommands{0};
+
+    // SoA bounding spheres in world space, padded to a multiple of 4
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> zs;
+    std::vector<float> radii;
+    // same as radii, but -inf for objects that don't cast shadows
+    std::vector<float> shadowRadii;
+    std::vector<std::uint32_t> drawCommandIndices;
+};
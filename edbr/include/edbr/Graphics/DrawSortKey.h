@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include <edbr/Graphics/IdTypes.h>
+
+namespace graphics
+{
+enum class DrawSortPass : std::uint8_t {
+    Opaque = 0,
+    Transparent = 1,
+};
+
+// Packed 64 bit key for sorting the draw list (from the highest bits):
+// Opaque:      [pass:2][skinned:1][material:20][mesh:25][lod:3][depth:13] - front to back
+// Transparent: [pass:2][depth:13][skinned:1][material:20][mesh:25][lod:3] - back to front
+// Opaque draws are grouped by material, mesh and LOD first so that they can be
+// instanced (see IndirectDrawBuilder) and then go front to back within the group.
+// normalizedDepth - view depth divided by the camera's zFar
+std::uint64_t makeDrawSortKey(
+    DrawSortPass pass,
+    bool skinned,
+    MaterialId materialId,
+    MeshId meshId,
+    std::uint32_t lod,
+    float normalizedDepth);
+}
@@ -1,13 +1,16 @@
 #pragma once
 
 #include <array>
+#include <cassert>
+#include <optional>
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
+#include <edbr/Math/Sphere.h>
+
 namespace math
 {
-struct Sphere;
 struct AABB;
 }
 class Camera;
@@ -62,6 +65,32 @@ struct Frustum {
     Plane bottomFace;
 };
 
+// Convex volume: intersection of up to MAX_PLANES half-spaces (plane normals
+// point inside) and an optional sphere. Used for the volumes which are not
+// frustums, e.g. shadow caster volumes (see ShadowCasterCulling.h)
+struct CullingVolume {
+    static constexpr std::size_t MAX_PLANES = 12;
+
+    CullingVolume() = default;
+    // not explicit: a frustum can be passed wherever a volume is expected
+    CullingVolume(const Frustum& frustum)
+    {
+        for (int i = 0; i < 6; ++i) {
+            addPlane(frustum.getPlane(i));
+        }
+    }
+
+    void addPlane(const Frustum::Plane& plane)
+    {
+        assert(numPlanes < MAX_PLANES);
+        planes[numPlanes++] = plane;
+    }
+
+    std::array<Frustum::Plane, MAX_PLANES> planes;
+    std::size_t numPlanes{0};
+    std::optional<math::Sphere> sphere;
+};
+
 namespace edge
 {
 // NOTE: this doesn't work for cameras with inverse depth
@@ -70,6 +99,7 @@ std::array<glm::vec3, 8> calculateFrustumCornersWorldSpace(const Camera& camera)
 Frustum createFrustumFromCamera(const Camera& camera);
 bool isInFrustum(const Frustum& frustum, const math::Sphere& s);
 bool isInFrustum(const Frustum& frustum, const math::AABB& aabb);
+bool isInVolume(const CullingVolume& volume, const math::Sphere& s);
 math::Sphere calculateBoundingSphereWorld(
     const glm::mat4& transform,
     const math::Sphere& s,
@@ -1,19 +1,48 @@
 #pragma once
 
+#include <array>
+
 #include <glm/vec3.hpp>
 
 #include <edbr/Math/Sphere.h>
 
 #include <edbr/Graphics/IdTypes.h>
+#include <edbr/Graphics/VertexQuantization.h>
 #include <edbr/Graphics/Vulkan/GPUBuffer.h>
 
 struct GPUMesh {
-    GPUBuffer vertexBuffer;
-    GPUBuffer indexBuffer;
+    // Vertices and indices are sub-allocated from MeshCache's shared buffers.
+    // Indices are relative to the mesh's first vertex, so vertex pulling
+    // should be done from vertexBufferAddress (and vertexOffset should be 0
+    // when issuing draws).
+    // For compact meshes, vertexBufferAddress points to CompactVertexHeader
+    // which is followed by the vertices.
+    std::uint32_t vertexOffset{0}; // in MeshCache's vertex slots
+    std::uint32_t firstIndex{0}; // in indices of indexType
+    VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+    VkDeviceAddress vertexBufferAddress{0};
+    VertexFormat vertexFormat{VertexFormat::Full};
 
     std::uint32_t numVertices{0};
     std::uint32_t numIndices{0};
 
+    // Discrete LODs which share the mesh's vertices. LOD 0 is the full mesh
+    // (same firstIndex and numIndices as above), each next one has fewer
+    // triangles and a bigger error (see graphics::selectMeshLOD)
+    struct LOD {
+        std::uint32_t firstIndex{0}; // in indices of indexType
+        std::uint32_t numIndices{0};
+        float error{0.f}; // max distance from the original surface, in mesh units
+    };
+    static constexpr std::size_t MAX_LODS = 8;
+    std::array<LOD, MAX_LODS> lods;
+    std::uint32_t numLODs{1};
+
+    // Meshlets of LOD 0 (see graphics::buildMeshlets) in MeshCache's meshlet
+    // buffer. Only big meshes without skeletons have them
+    std::uint32_t firstMeshlet{0};
+    std::uint32_t numMeshlets{0};
+
     // AABB
     glm::vec3 minPos;
     glm::vec3 maxPos;
@@ -21,9 +50,11 @@ struct GPUMesh {
 
     bool hasSkeleton{false};
     // skinned meshes only
+    // graphics::CompactSkinningData for compact meshes, CPUMesh::SkinningData otherwise
     GPUBuffer skinningDataBuffer;
 };
 
 struct SkinnedMesh {
+    // skinning.comp always outputs VertexFormat::Full vertices
     GPUBuffer skinnedVertexBuffer;
 };
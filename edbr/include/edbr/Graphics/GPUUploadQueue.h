@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <edbr/Graphics/UploadRegions.h>
+#include <edbr/Graphics/UploadRingAllocator.h>
+#include <edbr/Graphics/Vulkan/GPUBuffer.h>
+
+class GfxDevice;
+struct GPUImage;
+
+// All one-time uploads (mesh data, textures) go through GPUUploadQueue.
+// Data is copied into one persistently mapped ring buffer and copies are
+// only recorded. flush() submits all of them at once without waiting - it's
+// called by GfxDevice once per frame (before the frame's commands are
+// submitted) and before immediate submits, so the uploaded data is always
+// ready for the commands submitted after it.
+// Space in the ring buffer is reclaimed when the flush's submission completes.
+class GPUUploadQueue {
+public:
+    GPUUploadQueue(GfxDevice& gfxDevice);
+
+    void init(std::size_t ringBufferSize);
+    void cleanup();
+
+    // data is copied, so it doesn't need to outlive the call
+    void uploadBuffer(VkBuffer dstBuffer, std::size_t dstOffset, std::span<const std::byte> data);
+    // Writes the whole image: all layers and mips which are not generated
+    // should be passed in one call. They're copied into one staging allocation,
+    // so that a flush caused by the full ring buffer can't happen in the middle
+    // of the image (each flush starts image uploads from
+    // VK_IMAGE_LAYOUT_UNDEFINED). The image is transitioned to
+    // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL on flush. If only mip 0 was
+    // written, the other mips are generated from it (pre-generated mips, e.g.
+    // block-compressed ones, should all be uploaded).
+    // The image must not be destroyed before the flush.
+    void uploadImage(
+        const GPUImage& image,
+        std::span<const graphics::ImageSubresourceUpload> subresources);
+
+    // Submits all recorded copies. Returns the value which can be passed
+    // to GfxDevice::isAsyncSubmitComplete/waitForAsyncSubmit
+    std::uint64_t flush();
+    bool hasPendingUploads() const;
+
+    std::size_t getRingBufferUsedSize() const { return ringAllocator.getUsedSize(); }
+
+private:
+    struct StagingAllocation {
+        VkBuffer buffer;
+        std::size_t offset;
+        void* mappedData;
+    };
+    StagingAllocation allocateStaging(std::size_t size);
+    void releaseCompleted();
+
+    GfxDevice& gfxDevice;
+
+    GPUBuffer ringBuffer;
+    UploadRingAllocator ringAllocator;
+
+    // copies from the ring buffer
+    std::vector<graphics::BufferUploadRegion> bufferUploads;
+
+    // uploads which don't fit into the ring buffer get their own staging buffers
+    struct DedicatedBufferUpload {
+        VkBuffer srcBuffer;
+        graphics::BufferUploadRegion upload;
+    };
+    std::vector<DedicatedBufferUpload> dedicatedBufferUploads;
+    std::vector<GPUBuffer> pendingDedicatedBuffers;
+    struct InFlightBuffer {
+        GPUBuffer buffer;
+        std::uint64_t submitValue;
+    };
+    std::vector<InFlightBuffer> inFlightDedicatedBuffers;
+
+    struct ImageUpload {
+        VkImage image;
+        VkExtent3D extent;
+        VkImageUsageFlags usage;
+        std::uint32_t mipLevels;
+        bool generateMips;
+        VkBuffer srcBuffer;
+        std::vector<VkBufferImageCopy> regions;
+    };
+    std::vector<ImageUpload> imageUploads;
+
+    std::uint64_t lastSubmitValue{0};
+
+    // enough for vkCmdCopyBufferToImage with any uncompressed or block-compressed format
+    static constexpr std::size_t STAGING_ALIGNMENT = 16;
+};
@@ -8,23 +8,32 @@
 #include <edbr/Graphics/Vulkan/GPUImage.h>
 
 #include <edbr/Graphics/Color.h>
+#include <edbr/Graphics/CullingStage.h>
 #include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/IndirectDrawBuilder.h>
 #include <edbr/Graphics/Light.h>
+#include <edbr/Graphics/LightClusterGrid.h>
 #include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/MeshLODSelection.h>
 #include <edbr/Graphics/NBuffer.h>
+#include <edbr/Graphics/ParallelDrawList.h>
 
 #include <edbr/Graphics/Pipelines/CSMPipeline.h>
 #include <edbr/Graphics/Pipelines/DepthResolvePipeline.h>
+#include <edbr/Graphics/Pipelines/MeshCullingPipeline.h>
 #include <edbr/Graphics/Pipelines/MeshPipeline.h>
 #include <edbr/Graphics/Pipelines/PointLightShadowMapPipeline.h>
 #include <edbr/Graphics/Pipelines/PostFXPipeline.h>
 #include <edbr/Graphics/Pipelines/SkinningPipeline.h>
 #include <edbr/Graphics/Pipelines/SkyboxPipeline.h>
 
+#include <edbr/Util/RadixSort.h>
+
 struct SDL_Window;
 
 class Camera;
 class GfxDevice;
+class JobSystem;
 class MeshCache;
 class MaterialCache;
 
@@ -39,7 +48,7 @@ public:
     };
 
 public:
-    GameRenderer(MeshCache& meshCache, MaterialCache& materialCache);
+    GameRenderer(MeshCache& meshCache, MaterialCache& materialCache, JobSystem& jobSystem);
 
     void init(GfxDevice& gfxDevice, const glm::ivec2& drawImageSize);
     void draw(
@@ -53,11 +62,34 @@ public:
 
     void setSkyboxImage(ImageId skyboxImageId);
     void beginDrawing(GfxDevice& gfxDevice);
-    void endDrawing();
+    // sorts and culls the draw list for all passes
+    void endDrawing(const Camera& camera);
 
     void addLight(const Light& light, const Transform& transform);
 
-    void drawMesh(MeshId id, const glm::mat4& transform, MaterialId materialId, bool castShadow);
+    // isStatic - the mesh doesn't move (static shadow casters are cached, see CSMCache).
+    // Static meshes can still be moved, but this causes all CSM cascades to be redrawn.
+    // drawId - stable id of the draw, used to keep its LOD between frames
+    // (LODs of draws without ids can flicker near the LOD switch distance)
+    void drawMesh(
+        MeshId id,
+        const glm::mat4& transform,
+        MaterialId materialId,
+        bool castShadow,
+        bool isStatic,
+        DrawId drawId = NULL_DRAW_ID);
+
+    // Same as drawMesh, but can be called from JobSystem threads at the same time
+    // (threadIndex is the one passed to JobSystem's batch function).
+    // Per-thread draw lists are merged in endDrawing
+    void drawMeshParallel(
+        std::size_t threadIndex,
+        MeshId id,
+        const glm::mat4& transform,
+        MaterialId materialId,
+        bool castShadow,
+        bool isStatic,
+        DrawId drawId = NULL_DRAW_ID);
 
     std::size_t appendJointMatrices(GfxDevice& gfxDevice, std::span<const glm::mat4> jointMatrices);
 
@@ -66,7 +98,8 @@ public:
         const glm::mat4& transform,
         MaterialId materialId,
         const SkinnedMesh& skinnedMesh,
-        std::size_t jointMatricesStartIndex);
+        std::size_t jointMatricesStartIndex,
+        DrawId drawId = NULL_DRAW_ID);
 
     ImageId getDrawImageId() const { return drawImageId; }
     ImageId getFinalDrawImageId() const { return postFXDrawImageId; }
@@ -79,25 +112,81 @@ public:
 private:
     void createDrawImage(GfxDevice& gfxDevice, const glm::ivec2& drawImageSize, bool firstCreate);
     void initSceneData(GfxDevice& gfxDevice);
+    void createMeshDrawBuffers(GfxDevice& gfxDevice);
+    // reallocates the buffers if instances or meshlet draws of this frame don't fit
+    void growMeshDrawBuffers(GfxDevice& gfxDevice);
 
     bool isMultisamplingEnabled() const;
     void onMultisamplingStateUpdate(GfxDevice& gfxDevice);
 
-    void sortDrawList();
+    MeshDrawCommand createMeshDrawCommand(
+        MeshId id,
+        const glm::mat4& transform,
+        MaterialId materialId,
+        bool castShadow,
+        bool isStatic,
+        DrawId drawId) const;
+    void sortDrawList(const Camera& camera);
+    void cullDrawList(const Camera& camera);
+    std::span<const std::uint32_t> getVisibleDrawCommands(std::size_t viewIndex) const;
 
     MeshCache& meshCache;
     MaterialCache& materialCache;
+    JobSystem& jobSystem;
 
     SkinningPipeline skinningPipeline;
     CSMPipeline csmPipeline;
     PointLightShadowMapPipeline pointLightShadowMapPipeline;
+    MeshCullingPipeline meshCullingPipeline;
     MeshPipeline meshPipeline;
     SkyboxPipeline skyboxPipeline;
     DepthResolvePipeline depthResolvePipeline;
     PostFXPipeline postFXPipeline;
 
     std::vector<MeshDrawCommand> meshDrawCommands;
+    ParallelDrawList parallelDrawList;
     std::vector<std::size_t> sortedMeshDrawCommands;
+    std::vector<util::KeyIndex> drawSortKeys;
+    std::vector<util::KeyIndex> drawSortKeysScratch;
+
+    // LODs are selected by the projected size of meshes' bounding spheres,
+    // shadow passes use their own params (shadows can usually be coarser)
+    graphics::LODSelectionParams lodParams;
+    graphics::LODSelectionParams shadowLODParams{.bias = 2.f};
+    graphics::MeshLODHistory lodHistory;
+    float drawImageHeight{0.f}; // in pixels
+
+    CullingStage cullingStage;
+    static constexpr std::size_t NO_VIEW = std::numeric_limits<std::size_t>::max();
+    std::size_t mainViewIndex{NO_VIEW};
+    std::size_t csmViewsStart{NO_VIEW}; // NUM_SHADOW_CASCADES views
+    // views of faces of each shadow casting point light, NO_VIEW for skipped faces
+    std::vector<std::array<std::size_t, PointShadowAtlas::NUM_FACES>> pointLightFaceViews;
+
+    // geometry pass is drawn with one vkCmdDrawIndexedIndirectCount call,
+    // repeated meshes are drawn as instances. Instances are culled on the GPU
+    // by MeshCullingPipeline before drawing.
+    // Instance and meshlet draw buffers grow when a frame doesn't fit into
+    // them (see growMeshDrawBuffers)
+    static constexpr std::size_t INITIAL_MAX_MESH_INSTANCES = 64 * 1024;
+    std::size_t maxMeshInstances{INITIAL_MAX_MESH_INSTANCES};
+    std::vector<VkDrawIndexedIndirectCommand> meshIndirectCommands;
+    std::vector<GPUMeshInstanceData> meshInstanceData;
+    NBuffer meshIndirectCommandsBuffer;
+    NBuffer meshInstanceDataBuffer;
+    graphics::IndirectDrawStats meshDrawStats;
+
+    // Big static meshes are drawn per meshlet: their instances go after the
+    // ones of regular draws and each meshlet is culled separately by
+    // MeshCullingPipeline (see graphics::buildMeshletDraws)
+    static constexpr std::size_t INITIAL_MAX_MESHLET_DRAWS = 256 * 1024;
+    std::size_t maxMeshletDraws{INITIAL_MAX_MESHLET_DRAWS};
+    std::vector<std::uint32_t> visibleDrawCommands; // main view, regular draws only
+    std::vector<std::uint32_t> visibleMeshletDrawCommands;
+    std::vector<GPUMeshletDraw> meshletDraws;
+    NBuffer meshletDrawsBuffer;
+    graphics::MeshletDrawStats meshletDrawStats;
+    bool meshletCullingEnabled{true};
 
     VkFormat drawImageFormat{VK_FORMAT_R16G16B16A16_SFLOAT};
     VkFormat depthImageFormat{VK_FORMAT_D32_SFLOAT};
@@ -134,18 +223,32 @@ private:
 
         // Point light data
         float pointLightFarPlane;
+        std::uint32_t pointShadowAtlasId;
+        VkDeviceAddress pointShadowFacesBuffer;
 
         VkDeviceAddress lightsBuffer;
         std::uint32_t numLights;
         std::int32_t sunlightIndex;
 
         VkDeviceAddress materialsBuffer;
+
+        // clustered lighting
+        VkDeviceAddress lightClustersBuffer;
+        VkDeviceAddress lightIndicesBuffer;
+        float cameraZNear;
+        float cameraZFar;
     };
     NBuffer sceneDataBuffer;
 
     NBuffer lightDataBuffer;
-    static const int MAX_LIGHTS = 100;
+    static const int MAX_LIGHTS = 4096;
     std::vector<GPULightData> lightDataGPU;
+
+    // mesh.frag only goes through the lights binned into the fragment's cluster
+    LightClusterGrid lightClusterGrid;
+    static constexpr std::size_t MAX_LIGHT_INDICES = 256 * 1024;
+    NBuffer lightClustersBuffer;
+    NBuffer lightIndicesBuffer;
     const float pointLightMaxRange{25.f};
     const float spotLightMaxRange{64.f};
     std::int32_t sunlightIndex{-1}; // index of sun light inside the light data buffer
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <filesystem>
 #include <optional>
+#include <span>
+#include <vector>
 
 // don't sort these includes
 // clang-format off
@@ -18,8 +20,11 @@
 
 #include <edbr/Graphics/Color.h>
 #include <edbr/Graphics/Common.h>
+#include <edbr/Graphics/GPUUploadQueue.h>
 #include <edbr/Graphics/ImageCache.h>
+#include <edbr/Graphics/Vulkan/BindlessSetManager.h>
 #include <edbr/Graphics/Vulkan/Swapchain.h>
+#include <edbr/Graphics/Vulkan/VulkanAsyncExecutor.h>
 #include <edbr/Graphics/Vulkan/VulkanImGuiBackend.h>
 #include <edbr/Graphics/Vulkan/VulkanImmediateExecutor.h>
 #include <edbr/Version.h>
@@ -33,6 +38,7 @@ struct GPUBuffer;
 struct GPUImage;
 
 struct SDL_Window;
+class TaskQueue;
 
 class GfxDevice {
 public:
@@ -47,7 +53,13 @@ public:
     GfxDevice(const GfxDevice&) = delete;
     GfxDevice& operator=(const GfxDevice&) = delete;
 
-    void init(SDL_Window* window, const char* appName, const Version& appVersion, bool vSync);
+    // image files are decoded on taskQueue (see ImageCache::loadImagesFromFiles)
+    void init(
+        SDL_Window* window,
+        const char* appName,
+        const Version& appVersion,
+        bool vSync,
+        TaskQueue& taskQueue);
     void recreateSwapchain(std::uint32_t swapchainWidth, std::uint32_t swapchainHeight);
 
     VkCommandBuffer beginFrame();
@@ -74,7 +86,21 @@ public:
     float getMaxAnisotropy() const { return maxSamplerAnisotropy; }
 
     VulkanImmediateExecutor createImmediateExecutor() const;
-    void immediateSubmit(std::function<void(VkCommandBuffer)>&& f) const;
+    // flushes the upload queue first, so that uploaded data can be used by f
+    void immediateSubmit(std::function<void(VkCommandBuffer)>&& f);
+
+    // Submits without waiting for completion. The returned value can be
+    // passed to isAsyncSubmitComplete/waitForAsyncSubmit
+    std::uint64_t submitAsync(std::function<void(VkCommandBuffer)>&& f);
+    bool isAsyncSubmitComplete(std::uint64_t value) const;
+    void waitForAsyncSubmit(std::uint64_t value) const;
+    std::uint64_t getCompletedAsyncSubmitValue() const;
+
+    // Uploads are flushed at the end of every frame. flushUploads can be
+    // called to submit them earlier (e.g. after a batch of loaded assets)
+    GPUUploadQueue& getUploadQueue() { return uploadQueue; }
+    std::uint64_t flushUploads() { return uploadQueue.flush(); }
+    void waitForUploads() { waitForAsyncSubmit(uploadQueue.flush()); }
 
     void waitIdle() const;
 
@@ -104,11 +130,27 @@ public:
         VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
         VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT,
         bool mipMap = false);
+    // Files are decoded on ImageCache's decode threads, the returned ids show
+    // the error image until the images are uploaded (see ImageCache)
+    [[nodiscard]] std::vector<ImageId> loadImagesFromFiles(
+        std::span<const ImageCache::LoadParams> params);
 
     ImageId addImageToCache(GPUImage image);
 
+    // Images returned by createImage, loadImageFromFile and addImageToCache are
+    // referenced once. Released images are destroyed when frames in flight
+    // don't use them anymore (or evicted later if an image memory budget is set)
+    void addImageRef(ImageId id) { imageCache.addRef(id); }
+    void releaseImage(ImageId id) { imageCache.releaseImage(id); }
+    void setImageMemoryBudget(std::optional<std::size_t> budget)
+    {
+        imageCache.setMemoryBudget(budget);
+    }
+
     [[nodiscard]] const GPUImage& getImage(ImageId id) const;
-    void uploadImageData(const GPUImage& image, void* pixelData, std::uint32_t layer = 0) const;
+    // The upload is recorded into the upload queue.
+    // pixelData contains mip 0 of all layers one after another
+    void uploadImageData(const GPUImage& image, void* pixelData);
 
     ImageId getWhiteTextureID() { return whiteImageId; }
 
@@ -120,12 +162,14 @@ public:
         std::optional<VmaAllocationCreateInfo> customAllocationInfo = std::nullopt) const;
     // loadImageFromFileRaw is mostly intended for low level usage. In most cases,
     // loadImageFromFile should be preferred as it will automatically
-    // add the image to bindless set
+    // add the image to bindless set.
+    // If the image has an up to date cooked .ktx2 file (see CookedTexture.h) of
+    // a compatible format, its block-compressed mips are loaded instead.
     [[nodiscard]] GPUImage loadImageFromFileRaw(
         const std::filesystem::path& path,
         VkFormat format,
         VkImageUsageFlags usage,
-        bool mipMap) const;
+        bool mipMap);
     // destroyImage should only be called on images not beloning to image cache / bindless set
     void destroyImage(const GPUImage& image) const;
 
@@ -153,6 +197,8 @@ private:
     void checkDeviceCapabilities();
     void createCommandBuffers();
 
+    GPUImage createDecodedImage(const ImageCache::LoadParams& params, DecodedImage decoded);
+
     FrameData& getCurrentFrame();
 
 private: // data
@@ -172,6 +218,8 @@ private: // data
     std::uint32_t frameNumber{0};
 
     VulkanImmediateExecutor executor;
+    VulkanAsyncExecutor asyncExecutor;
+    GPUUploadQueue uploadQueue;
 
     VulkanImGuiBackend imGuiBackend;
 
@@ -179,6 +227,7 @@ private: // data
     VkSampleCountFlagBits highestSupportedSamples{VK_SAMPLE_COUNT_1_BIT};
     float maxSamplerAnisotropy{1.f};
 
+    BindlessSetManager bindlessSetManager;
     ImageCache imageCache;
 
     ImageId whiteImageId{NULL_IMAGE_ID};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+namespace math
+{
+struct Sphere;
+}
+
+// CPU reference of the Hi-Z pyramid used for GPU occlusion culling
+// (see hiz.glsl, hiz_build.comp and mesh_cull.comp - keep in sync).
+// Depth is expected to be reverse-Z (1 - near, 0 - far), so each texel
+// stores the farthest (min) depth of the texels it covers.
+// All levels are packed into one float array. Level 0 has half the size of
+// the depth image (rounded up) and each next level halves it again until 1x1.
+// Texel x of level L covers depth image pixels [x << (L + 1), (x + 1) << (L + 1)).
+class HiZPyramid {
+public:
+    struct Level {
+        glm::ivec2 size;
+        std::uint32_t offset; // in floats
+    };
+
+    static std::vector<Level> calculateLevels(const glm::ivec2& depthImageSize);
+    static std::size_t calculateDataSize(std::span<const Level> levels);
+
+    void build(std::span<const float> depth, const glm::ivec2& depthImageSize);
+
+    // Returns true if the sphere is fully behind the depth stored in the pyramid.
+    // Spheres which intersect the near plane are never occluded.
+    bool isSphereOccluded(
+        const math::Sphere& sphere,
+        const glm::mat4& view,
+        const glm::mat4& proj,
+        float zNear) const;
+
+    float getDepth(std::size_t level, int x, int y) const;
+
+    const std::vector<Level>& getLevels() const { return levels; }
+    const std::vector<float>& getData() const { return data; }
+
+private:
+    glm::ivec2 depthImageSize{};
+    std::vector<Level> levels;
+    std::vector<float> data;
+};
@@ -15,3 +15,8 @@ static const auto NULL_IMAGE_ID = std::numeric_limits<std::uint32_t>::max();
 
 using MaterialId = std::uint32_t;
 static const auto NULL_MATERIAL_ID = std::numeric_limits<std::uint32_t>::max();
+
+// Chosen by the game, should stay the same for the same draw between frames
+// (e.g. entity id + mesh index), see GameRenderer::drawMesh
+using DrawId = std::uint64_t;
+static const auto NULL_DRAW_ID = std::numeric_limits<std::uint64_t>::max();
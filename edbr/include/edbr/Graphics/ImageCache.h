@@ -1,50 +1,166 @@
 #pragma once
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
 #include <edbr/Graphics/IdTypes.h>
+#include <edbr/Graphics/ImageLoader.h>
 #include <edbr/Graphics/Vulkan/GPUImage.h>
+#include <edbr/Util/TextureKind.h>
 
-#include <edbr/Graphics/Vulkan/BindlessSetManager.h>
-
-class GfxDevice;
+class TaskQueue;
 
+// Owns all images which are accessible through the bindless set. ImageId is
+// the image's slot in the bindless set.
+// Images are reference counted: loadImageFromFile and addImage return a
+// referenced id, addRef/releaseImage change the count. An image without
+// references is destroyed after the frames in flight which could use it are
+// complete, then its slot is reused. If a memory budget is set, images
+// loaded from files are kept after their last release and evicted in LRU
+// order when loaded images take more memory than the budget.
+// Images can be loaded in batches: files are decoded on decode threads and
+// ids are returned right away. Until the image is created, its bindless slot
+// points at the error image.
 class ImageCache {
     friend class ResourcesInspector;
 
 public:
-    ImageCache(GfxDevice& gfxDevice);
+    struct LoadParams {
+        std::filesystem::path path;
+        VkFormat format;
+        VkImageUsageFlags usage;
+        bool mipMap;
+        // decides which cooked textures can be loaded instead of the image
+        // (see util::isCookedTextureCompatible)
+        std::optional<util::TextureKind> kind{};
+
+        bool operator==(const LoadParams&) const = default;
+    };
+
+    // What ImageCache needs from GfxDevice (can be mocked in tests)
+    struct Device {
+        // called on decode threads, returns std::nullopt if loading fails
+        std::function<std::optional<DecodedImage>(const LoadParams&)> decodeImage;
+        // creates the image and records its upload, returns std::nullopt on failure
+        std::function<std::optional<GPUImage>(const LoadParams&, DecodedImage)> createImage;
+        std::function<void(const GPUImage&)> destroyImage;
+        std::function<void(ImageId, const GPUImage&)> setBindlessImage;
+        std::function<std::size_t(const GPUImage&)> getMemorySize;
+    };
+
+    explicit ImageCache(Device device);
+    ~ImageCache();
 
+    // The queue is shared with other background work (e.g. the app's task queue)
+    // and should outlive the cache. If not set, batches are decoded on the calling thread.
+    void setDecodeQueue(TaskQueue& queue) { decodeQueue = &queue; }
+
+    // If the image is being loaded by loadImagesFromFiles, waits for it
     ImageId loadImageFromFile(
         const std::filesystem::path& path,
         VkFormat format,
         VkImageUsageFlags usage,
         bool mipMap);
 
+    // Decodes all images on decode threads. Returns referenced ids in the
+    // same order as params right away. Images are created in update after
+    // they're decoded, their uploads are submitted together.
+    // Images which fail to load keep pointing at the error image.
+    std::vector<ImageId> loadImagesFromFiles(std::span<const LoadParams> params);
+    // Creates images which were decoded since the last call.
+    // Should be called on the main thread each frame.
+    void update();
+    // Blocks until all images are decoded and creates them
+    void waitForLoads();
+    bool isImageLoading(ImageId id) const;
+    std::size_t getNumLoadingImages() const { return numLoadingImages; }
+
     ImageId addImage(GPUImage image);
+    // replaces the image if the id is used
     ImageId addImage(ImageId id, GPUImage image);
+    // returns the error image for images which are being loaded
     const GPUImage& getImage(ImageId id) const;
 
     ImageId getFreeImageId() const;
 
-    void destroyImages();
+    void addRef(ImageId id);
+    void releaseImage(ImageId id);
+    std::uint32_t getRefCount(ImageId id) const;
+
+    // Destroys released images which are not used by frames in flight anymore.
+    // Should be called at the start of each frame.
+    void beginFrame(std::uint64_t frameNumber);
 
-    BindlessSetManager bindlessSetManager;
+    // nullopt - no budget: images are destroyed as soon as they're released
+    void setMemoryBudget(std::optional<std::size_t> budget);
+    // memory used by images loaded from files (including unreferenced ones)
+    std::size_t getLoadedImagesMemory() const { return loadedImagesMemory; }
+    std::size_t getNumPendingDestroys() const { return pendingDestroys.size(); }
+
+    void destroyImages();
 
     void setErrorImageId(ImageId id) { errorImageId = id; }
 
 private:
+    struct LoadParamsHash {
+        std::size_t operator()(const LoadParams& p) const;
+    };
+
+    struct ImageInfo {
+        std::uint32_t refCount{0};
+        std::optional<LoadParams> loadParams; // set for images loaded from files
+        std::size_t memorySize{0}; // only calculated for images loaded from files
+        std::optional<std::list<ImageId>::iterator> lruIt; // set if unreferenced and kept
+        std::optional<std::uint64_t> pendingLoad; // set while the image is being loaded
+    };
+
+    struct DecodeResult {
+        ImageId id;
+        std::uint64_t loadIndex;
+        std::optional<DecodedImage> image;
+    };
+
+    ImageId reserveImageId(const LoadParams& params);
+    void finishLoad(DecodeResult result);
+    void scheduleDestroy(ImageId id);
+    void evictUnusedImages();
+    void waitForDecodes();
+
+    Device device;
+
     std::vector<GPUImage> images;
-    GfxDevice& gfxDevice;
+    std::vector<ImageInfo> imageInfos; // same indices as images
 
-    struct LoadedImageInfo {
-        std::filesystem::path path;
-        VkFormat format;
-        VkImageUsageFlags usage;
-        bool mipMap;
+    std::unordered_map<LoadParams, ImageId, LoadParamsHash> loadedImages;
+    std::vector<ImageId> freeIds;
+
+    struct PendingDestroy {
+        ImageId id;
+        std::uint64_t releaseFrame;
     };
-    std::unordered_map<ImageId, LoadedImageInfo> loadedImagesInfo;
+    std::vector<PendingDestroy> pendingDestroys;
+    std::uint64_t frameNumber{0};
+
+    std::optional<std::size_t> memoryBudget;
+    std::size_t loadedImagesMemory{0};
+    std::list<ImageId> lru; // unreferenced loaded images, most recently released first
+
     ImageId errorImageId{NULL_IMAGE_ID};
+
+    TaskQueue* decodeQueue{nullptr};
+    std::mutex decodedImagesMutex;
+    std::condition_variable decodedImagesCV;
+    std::vector<DecodeResult> decodedImages; // decoded, but not created yet
+    std::size_t numDecodingImages{0}; // pushed to decodeQueue, but not decoded yet
+    std::uint64_t nextLoadIndex{0};
+    std::size_t numLoadingImages{0};
 };
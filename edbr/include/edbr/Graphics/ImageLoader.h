@@ -1,14 +1,17 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
+
+#include <edbr/Util/CookedTexture.h>
 
 struct ImageData {
     ImageData() = default;
     ~ImageData();
 
     // move only
-    ImageData(ImageData&& o) = default;
-    ImageData& operator=(ImageData&& o) = default;
+    ImageData(ImageData&& o) noexcept;
+    ImageData& operator=(ImageData&& o) noexcept;
 
     // no copies
     ImageData(const ImageData& o) = delete;
@@ -28,6 +31,13 @@ struct ImageData {
     bool shouldSTBFree{false};
 };
 
+// CPU data of an image file. Can be decoded on any thread, GfxDevice creates
+// the GPU image from it on the main thread.
+struct DecodedImage {
+    ImageData data; // not loaded if cooked is set
+    std::optional<CookedTexture> cooked;
+};
+
 namespace util
 {
 ImageData loadImage(const std::filesystem::path& p);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <edbr/Graphics/VertexQuantization.h>
+
+struct GPUMesh;
+struct MeshDrawCommand;
+
+// Per-instance data read by mesh.vert (via gl_InstanceIndex) and mesh_cull.comp
+// keep in sync with mesh_pcs.glsl
+struct GPUMeshInstanceData {
+    glm::mat4 transform;
+    glm::vec4 worldBoundingSphere; // xyz - center, w - radius
+    VkDeviceAddress vertexBuffer;
+    VertexFormat vertexFormat;
+    std::uint32_t materialId;
+    std::uint32_t drawIndex; // index of the indirect command which draws this instance
+    std::uint32_t padding;
+};
+
+// Draw of a single meshlet of an instance, culled by meshlet_cull.comp
+// keep in sync with mesh_cull.glsl
+struct GPUMeshletDraw {
+    std::uint32_t instanceIndex; // index in instance data
+    std::uint32_t meshletIndex; // index in MeshCache's meshlet buffer
+};
+
+namespace graphics
+{
+struct IndirectDrawStats {
+    std::size_t numDraws{0};
+    std::size_t numInstances{0};
+    std::size_t numIndex16Draws{0}; // first numIndex16Draws commands use 16-bit indices
+};
+
+// Builds indexed indirect commands for visible draw commands.
+// Each draw uses the indices of the draw command's LOD (MeshDrawCommand::lod).
+// Consecutive draw commands which share mesh, LOD, material and skinning state
+// are merged into one instanced draw, so draw lists should be sorted by
+// these first (see GameRenderer::sortDrawList).
+// firstInstance of each command points into instanceData.
+// All meshes are expected to be sub-allocated from the same index buffer
+// (see MeshCache). Commands of meshes with 16-bit indices go first, so that
+// each index type can be drawn with its own indirect call.
+// Output vectors are cleared first.
+IndirectDrawStats buildIndirectDrawCommands(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const std::uint32_t> visibleDrawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<VkDrawIndexedIndirectCommand>& indirectCommands,
+    std::vector<GPUMeshInstanceData>& instanceData,
+    std::size_t maxInstances = std::numeric_limits<std::size_t>::max());
+
+struct MeshletDrawStats {
+    std::size_t numDraws{0};
+    std::size_t numInstances{0};
+    std::size_t numIndex16Draws{0}; // first numIndex16Draws draws use 16-bit indices
+};
+
+// Only static, non-skinned meshes drawn with LOD 0 are drawn per meshlet:
+// meshlets of other LODs are not generated
+bool canUseMeshletDraws(const MeshDrawCommand& dc, const GPUMesh& mesh);
+
+// Moves draw commands which can be drawn per meshlet from visibleDrawCommands
+// to meshletDrawCommands (keeping the order). Draw commands whose meshlets
+// don't fit into maxMeshletDraws are kept as regular draws.
+// meshletDrawCommands is cleared first.
+void splitMeshletDrawCommands(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<std::uint32_t>& visibleDrawCommands,
+    std::vector<std::uint32_t>& meshletDrawCommands,
+    std::size_t maxMeshletDraws = std::numeric_limits<std::size_t>::max());
+
+// Appends an instance for each draw command to instanceData and adds a draw
+// for each of its meshlets to meshletDraws. Each meshlet draw becomes a
+// separate indirect command after GPU culling.
+// Draws of meshes with 16-bit indices go first.
+// Draw commands whose instances don't fit into maxInstances (counting the
+// ones already in instanceData) are skipped. meshletDraws is cleared first.
+MeshletDrawStats buildMeshletDraws(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const std::uint32_t> meshletDrawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<GPUMeshInstanceData>& instanceData,
+    std::vector<GPUMeshletDraw>& meshletDraws,
+    std::size_t maxInstances = std::numeric_limits<std::size_t>::max());
+}
@@ -68,6 +68,6 @@ struct GPULightData {
     LinearColorNoAlpha color;
     float intensity;
     glm::vec2 scaleOffset;
-    ImageId shadowMapID;
+    std::uint32_t shadowSlot; // 0 - no shadow, otherwise point light shadow slot + 1
     float unused;
 };
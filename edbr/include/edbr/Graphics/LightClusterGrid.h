@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <edbr/Math/AABB.h>
+
+class Camera;
+struct GPULightData;
+
+// LightClusterGrid bins point and spot lights into a 3D grid of view space
+// froxels for clustered forward shading. X/Y split the screen into tiles and
+// Z slices are distributed exponentially between the camera's near and far planes.
+// mesh.frag finds the cluster of the fragment and only iterates over the lights
+// binned into it (see light_clusters.glsl - keep in sync).
+// Directional lights are not binned: they affect every cluster.
+class LightClusterGrid {
+public:
+    static constexpr std::uint32_t GRID_SIZE_X = 16;
+    static constexpr std::uint32_t GRID_SIZE_Y = 9;
+    static constexpr std::uint32_t GRID_SIZE_Z = 24;
+    static constexpr std::uint32_t NUM_CLUSTERS = GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z;
+
+    // keep in sync with light_clusters.glsl
+    struct Cluster {
+        std::uint32_t offset; // into light indices
+        std::uint32_t count;
+    };
+
+public:
+    // Camera should be a perspective camera without an off-center projection.
+    // Light indices which don't fit into maxLightIndices are dropped
+    void build(
+        const Camera& camera,
+        std::span<const GPULightData> lights,
+        std::size_t maxLightIndices = std::numeric_limits<std::size_t>::max());
+
+    // screenUV - (0, 0) is the top left corner of the screen,
+    // viewDepth - distance from the camera along its view direction
+    glm::uvec3 findCluster(const glm::vec2& screenUV, float viewDepth) const;
+    static std::uint32_t getClusterIndex(const glm::uvec3& cluster);
+
+    std::span<const std::uint32_t> getClusterLights(std::uint32_t clusterIndex) const;
+
+    const std::vector<Cluster>& getClusters() const { return clusters; }
+    const std::vector<std::uint32_t>& getLightIndices() const { return lightIndices; }
+    std::size_t getNumDroppedLightIndices() const { return numDroppedLightIndices; }
+
+    float getZNear() const { return zNear; }
+    float getZFar() const { return zFar; }
+
+private:
+    void calculateClusterBounds(const glm::mat4& proj);
+    std::uint32_t getSlice(float viewDepth) const;
+    float getSliceDepth(std::uint32_t slice) const;
+    void addLight(std::uint32_t lightIndex, const glm::vec3& center, float radius);
+
+    // view space bounds, only recalculated when the projection changes
+    std::vector<math::AABB> clusterBounds;
+    glm::mat4 boundsProj{0.f};
+    float zNear{0.f};
+    float zFar{0.f};
+    float logZFarOverZNear{0.f};
+
+    // (cluster, light) pairs in light order, sorted into lightIndices at the end of build()
+    struct ClusterLight {
+        std::uint32_t clusterIndex;
+        std::uint32_t lightIndex;
+    };
+    std::vector<ClusterLight> clusterLights;
+    std::vector<std::uint32_t> clusterCursors;
+
+    std::vector<Cluster> clusters;
+    std::vector<std::uint32_t> lightIndices;
+    std::size_t numDroppedLightIndices{0};
+};
@@ -1,21 +1,97 @@
 #pragma once
 
+#include <optional>
+#include <span>
 #include <vector>
 
+#include <edbr/Graphics/BufferSubAllocator.h>
+#include <edbr/Graphics/CPUMesh.h>
 #include <edbr/Graphics/GPUMesh.h>
 
 class GfxDevice;
-struct CPUMesh;
 
+// Simplified index buffer which uses the vertices of the mesh (see
+// graphics::generateMeshLODs)
+struct MeshLODView {
+    std::span<const std::uint32_t> indices;
+    float error{0.f}; // in mesh units
+};
+
+// Mesh data in the full vertex format (MeshCache compacts it on upload if
+// needed). Can point into CPUMesh or straight into a memory-mapped cooked
+// scene (see CookedScene.h)
+struct MeshDataView {
+    std::span<const CPUMesh::Vertex> vertices;
+    std::span<const std::uint32_t> indices;
+    std::span<const CPUMesh::SkinningData> skinningData; // empty if there's no skeleton
+    std::vector<MeshLODView> lods; // LOD 1, 2, ... (only the first GPUMesh::MAX_LODS - 1 are used)
+    std::span<const Meshlet> meshlets; // of LOD 0, can be empty
+
+    glm::vec3 minPos;
+    glm::vec3 maxPos;
+    std::optional<math::Sphere> boundingSphere; // calculated from vertices if not set
+};
+
+// All meshes live in two shared buffers (vertex and index), which lets
+// the renderer draw everything with a single index buffer and
+// multi-draw-indirect. Meshes with up to 65536 vertices get 16-bit indices,
+// they're stored in the same buffer, which is bound with both index types
+// (see GPUMesh::indexType). Indices of all LODs of a mesh are stored in a
+// single allocation. Meshlets of all meshes are stored in another shared
+// buffer, which is read by the GPU meshlet culling (see MeshCullingPipeline).
 class MeshCache {
 public:
     void cleanup(const GfxDevice& gfxDevice);
 
+    // Format of meshes added after this call. Compact vertices take a third
+    // of the memory (16 bytes instead of 48, see VertexQuantization.h).
+    // Skinned meshes with more than 256 joints are always stored in the full
+    // format.
+    void setVertexFormat(VertexFormat format) { vertexFormat = format; }
+    VertexFormat getVertexFormat() const { return vertexFormat; }
+
+    // Mesh data is uploaded through GfxDevice's upload queue (see GPUUploadQueue),
+    // so many meshes can be added with a single submission
     MeshId addMesh(GfxDevice& gfxDevice, const CPUMesh& cpuMesh);
+    MeshId addMesh(GfxDevice& gfxDevice, const MeshDataView& mesh);
+
     const GPUMesh& getMesh(MeshId id) const;
+    std::span<const GPUMesh> getMeshes() const { return meshes; }
+
+    // Meshlets of the mesh, their firstIndex is in the index buffer (same as
+    // GPUMesh::LOD::firstIndex)
+    std::span<const Meshlet> getMeshlets(const GPUMesh& mesh) const;
+
+    const GPUBuffer& getVertexBuffer() const { return vertexBuffer; }
+    const GPUBuffer& getIndexBuffer() const { return indexBuffer; }
+    const GPUBuffer& getMeshletBuffer() const { return meshletBuffer; }
 
 private:
-    void uploadMesh(GfxDevice& gfxDevice, const CPUMesh& cpuMesh, GPUMesh& gpuMesh) const;
+    void uploadMesh(GfxDevice& gfxDevice, const MeshDataView& mesh, GPUMesh& gpuMesh);
+    void growVertexBuffer(GfxDevice& gfxDevice, std::size_t minNumSlots);
+    void growIndexBuffer(GfxDevice& gfxDevice, std::size_t minNumSlots);
+    void uploadMeshlets(GfxDevice& gfxDevice, const MeshDataView& mesh, GPUMesh& gpuMesh);
+    void updateVertexBufferAddresses();
 
     std::vector<GPUMesh> meshes;
+    VertexFormat vertexFormat{VertexFormat::Full};
+
+    GPUBuffer vertexBuffer;
+    GPUBuffer indexBuffer;
+    BufferSubAllocator vertexAllocator; // in slots
+    BufferSubAllocator indexAllocator; // in 32-bit slots
+
+    // meshes are never removed, so meshlets are only appended
+    std::vector<Meshlet> meshlets;
+    GPUBuffer meshletBuffer;
+    std::size_t meshletBufferCapacity{0}; // in meshlets
+
+    // Vertex buffer is allocated in slots of one compact vertex, so that meshes
+    // of both formats can share it (a full vertex takes three slots). Every
+    // mesh stays 16-byte aligned.
+    static constexpr std::size_t VERTEX_SLOT_SIZE = sizeof(graphics::CompactVertex);
+    static constexpr std::size_t INITIAL_NUM_VERTEX_SLOTS = 768 * 1024;
+    static constexpr std::size_t INITIAL_NUM_INDEX_SLOTS = 1024 * 1024;
+    static constexpr std::size_t MAX_NUM_VERTICES_16_BIT_INDICES = 65536;
+    static constexpr std::size_t INITIAL_NUM_MESHLETS = 16 * 1024;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <edbr/Graphics/CPUMesh.h>
+#include <edbr/Graphics/Meshlet.h>
+
+// Splitting of meshes into meshlets: small clusters of adjacent triangles
+// with similar normals, each with its own bounding sphere and normal cone.
+// Meshlets are stored as contiguous ranges of the mesh's index buffer, so
+// a mesh can still be drawn as a whole and any range of meshlets can be
+// drawn with a single indexed draw.
+namespace graphics
+{
+struct MeshletParams {
+    std::size_t maxVertices{96};
+    std::size_t maxTriangles{128};
+    // 0 - meshlets are only made compact, 1 - only their normal cones are made narrow
+    float coneWeight{0.25f};
+    // meshes with fewer triangles don't get meshlets
+    std::size_t minTriangles{1024};
+};
+
+// Greedily grows meshlets from adjacent triangles and reorders indices so
+// that each meshlet is a contiguous range of them. Triangles of each meshlet
+// keep their relative order, so the post-transform cache optimization of
+// the mesh is mostly preserved.
+std::vector<Meshlet> buildMeshlets(
+    std::vector<std::uint32_t>& indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    const MeshletParams& params = {});
+
+// Fills mesh.meshlets for meshes without skeletons which have at least
+// params.minTriangles triangles (skinned meshes move, so their bounds don't hold)
+void generateMeshlets(CPUMesh& mesh, const MeshletParams& params = {});
+}
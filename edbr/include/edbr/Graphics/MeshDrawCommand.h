@@ -19,7 +19,15 @@ struct MeshDrawCommand {
     // instead of whatever material the mesh has
     MaterialId materialId{NULL_MATERIAL_ID};
 
+    // index in GPUMesh::lods used by the main view, set by GameRenderer
+    // (see graphics::selectMeshLODs)
+    std::uint32_t lod{0};
+    // the LOD selected last frame is found by it (see graphics::MeshLODHistory)
+    DrawId drawId{NULL_DRAW_ID};
+
     bool castShadow{true};
+    // static shadow casters are cached in CSM (see CSMCache)
+    bool isStatic{false};
 
     // skinned meshes only
     const SkinnedMesh* skinnedMesh{nullptr};
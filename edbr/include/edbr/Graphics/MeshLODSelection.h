@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+
+#include <edbr/Math/Sphere.h>
+
+#include <edbr/Graphics/IdTypes.h>
+
+class Camera;
+struct GPUMesh;
+struct MeshDrawCommand;
+
+// Screen-space LOD selection: the coarsest LOD whose error (see
+// GPUMesh::LOD::error) is smaller than maxScreenError pixels when
+// projected at the distance of the mesh's bounding sphere.
+namespace graphics
+{
+struct LODSelectionParams {
+    float maxScreenError{1.f}; // in pixels
+    // bigger values make coarser LODs get picked earlier
+    float bias{1.f};
+    // coarser LOD is only picked when its error is smaller than the threshold
+    // by this fraction, so that LODs don't flicker near the threshold
+    float hysteresis{0.25f};
+
+    bool operator==(const LODSelectionParams&) const = default;
+};
+
+// Number of pixels which one world unit covers at the distance of the sphere
+// (for orthographic cameras it doesn't depend on the distance).
+// Spheres which contain the camera are treated as if they were at zNear.
+float calculatePixelsPerUnit(
+    const Camera& camera,
+    float viewportHeight,
+    const math::Sphere& worldBoundingSphere);
+
+// worldScale - how much the mesh is scaled by its transform (world bounding
+// sphere radius / mesh bounding sphere radius).
+// prevLOD - LOD selected last frame (hysteresis isn't applied without it)
+std::uint32_t selectMeshLOD(
+    const GPUMesh& mesh,
+    float worldScale,
+    float pixelsPerUnit,
+    const LODSelectionParams& params,
+    std::optional<std::uint32_t> prevLOD = std::nullopt);
+
+// Selects the LOD of the draw command as seen by the camera without hysteresis.
+// Used by shadow passes: CSM cameras are orthographic and point light cameras
+// only move with their lights, so LODs don't flicker when the view camera moves.
+std::uint32_t selectDrawCommandLOD(
+    const MeshDrawCommand& dc,
+    const GPUMesh& mesh,
+    const Camera& camera,
+    float viewportHeight,
+    const LODSelectionParams& params);
+
+// LODs selected in the previous frame by MeshDrawCommand::drawId, so that
+// draws get their own LOD back even if they're submitted in a different
+// order (e.g. by drawMeshParallel). Draws without ids don't get hysteresis.
+// Entries of draws which weren't submitted in the last frame are dropped.
+struct MeshLODHistory {
+    struct Entry {
+        MeshId meshId{NULL_MESH_ID};
+        std::uint32_t lod{0};
+    };
+    std::unordered_map<DrawId, Entry> entries;
+    std::unordered_map<DrawId, Entry> prevEntries; // reused between frames
+};
+
+// Sets MeshDrawCommand::lod of each draw command and updates the history
+void selectMeshLODs(
+    std::span<MeshDrawCommand> drawCommands,
+    std::span<const GPUMesh> meshes,
+    const Camera& camera,
+    float viewportHeight,
+    const LODSelectionParams& params,
+    MeshLODHistory& history);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <edbr/Graphics/CPUMesh.h>
+
+// Offline/load-time mesh optimization: vertex deduplication, triangle
+// reordering for the post-transform vertex cache and for less overdraw,
+// and vertex reordering for fetch locality.
+namespace graphics
+{
+struct VertexCacheStats {
+    std::size_t numTransformedVertices{0};
+    float acmr{0.f}; // average cache miss ratio: transformed vertices per triangle (0.5 - 3)
+    float atvr{0.f}; // transformed vertices per vertex (1 is optimal)
+};
+
+// Simulates a FIFO post-transform vertex cache of the given size
+VertexCacheStats analyzeVertexCache(
+    std::span<const std::uint32_t> indices,
+    std::size_t numVertices,
+    std::size_t cacheSize = 16);
+
+// Merges identical vertices (including their skinning data) and remaps
+// indices. Non-indexed meshes get indices first. Returns the number of
+// removed vertices.
+std::size_t deduplicateVertices(CPUMesh& mesh);
+
+// Reorders triangles for the post-transform cache (Tom Forsyth's "Linear-Speed
+// Vertex Cache Optimisation")
+void optimizeVertexCache(std::span<std::uint32_t> indices, std::size_t numVertices);
+
+// Reorders clusters of triangles so that the ones facing outwards are drawn
+// first (Sander et al. "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw"). Indices should be optimized by optimizeVertexCache first.
+// Clusters are split only where ACMR stays within threshold of the input.
+void optimizeOverdraw(
+    std::span<std::uint32_t> indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    float threshold = 1.05f);
+
+// Reorders vertices in the order in which they're first used by indices
+// and drops unused ones
+void optimizeVertexFetch(CPUMesh& mesh);
+
+struct MeshOptimizationStats {
+    std::size_t numVerticesBefore{0};
+    std::size_t numVerticesAfter{0};
+    VertexCacheStats cacheBefore;
+    VertexCacheStats cacheAfter;
+};
+
+// Runs all the passes above
+MeshOptimizationStats optimizeMesh(CPUMesh& mesh);
+}
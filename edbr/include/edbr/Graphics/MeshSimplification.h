@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <edbr/Graphics/CPUMesh.h>
+
+// Mesh simplification by quadric error edge collapse (Garland and Heckbert,
+// "Surface Simplification Using Quadric Error Metrics"). Vertices are only
+// collapsed into their neighbours, so simplified index buffers can use the
+// vertex buffer of the original mesh.
+// Vertices on attribute seams (same position, different UVs or normals) and
+// non-manifold vertices are never moved, border vertices only slide along
+// the border.
+namespace graphics
+{
+struct SimplifiedMesh {
+    std::vector<std::uint32_t> indices;
+    // max distance by which the surface was moved (estimated with quadrics, in mesh units)
+    float error{0.f};
+};
+
+// Collapses edges until there are no more than targetIndexCount indices or
+// until the next collapse would have an error bigger than maxError (in mesh units)
+SimplifiedMesh simplifyMesh(
+    std::span<const std::uint32_t> indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    std::size_t targetIndexCount,
+    float maxError = std::numeric_limits<float>::max());
+
+struct MeshLODParams {
+    std::size_t maxLODs{4}; // not counting LOD 0 (the mesh itself)
+    // each LOD has this many triangles of the previous one
+    float reduction{0.5f};
+    // relative to the mesh's bounding sphere radius
+    float maxError{0.05f};
+    // meshes with fewer triangles don't get LODs
+    std::size_t minTriangles{64};
+};
+
+// Fills mesh.lods with a chain of simplified index buffers (each LOD has
+// fewer triangles and a bigger error than the previous one). The chain ends
+// early if the simplifier can't reduce the mesh further within maxError.
+// LOD indices are optimized for the post-transform cache.
+void generateMeshLODs(CPUMesh& mesh, const MeshLODParams& params = {});
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include <edbr/Math/Sphere.h>
+
+// Cluster of adjacent triangles of a mesh (see graphics::buildMeshlets).
+// Meshlets are culled one by one against the view (see MeshletCulling.h),
+// so that only visible parts of big meshes get drawn.
+// keep in sync with mesh_cull.glsl
+struct Meshlet {
+    math::Sphere boundingSphere; // in mesh space
+
+    // Normal cone: all triangles of the meshlet are backfacing when seen from
+    // any point p for which dot(normalize(coneApex - p), coneAxis) > coneCutoff
+    glm::vec3 coneApex{};
+    glm::vec3 coneAxis{0.f, 0.f, 1.f};
+    float coneCutoff{1.f}; // 1 - the cone is too wide, the meshlet is never backfacing
+
+    // in CPUMesh - relative to the mesh's indices,
+    // in MeshCache - in MeshCache's index buffer (like GPUMesh::LOD::firstIndex)
+    std::uint32_t firstIndex{0};
+    std::uint32_t numIndices{0};
+};
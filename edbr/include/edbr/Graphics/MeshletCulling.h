@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/Meshlet.h>
+
+class Camera;
+
+// CPU meshlet culling. meshlet_cull.comp does the same tests on the GPU
+// for the geometry pass, shadow passes use these functions directly.
+namespace graphics
+{
+// viewPos - in mesh space
+bool isMeshletBackfacing(const Meshlet& meshlet, const glm::vec3& viewPos);
+// Same for orthographic views, viewDir - direction the view looks at (normalized, in mesh space)
+bool isMeshletBackfacingOrtho(const Meshlet& meshlet, const glm::vec3& viewDir);
+
+struct MeshletCullingView {
+    CullingVolume volume; // in world space
+    // camera position for perspective views, look direction for orthographic ones
+    glm::vec3 viewPoint{};
+    bool orthographic{false};
+};
+
+MeshletCullingView createMeshletCullingView(const Camera& camera, const CullingVolume& volume);
+
+struct IndexRange {
+    std::uint32_t firstIndex{0};
+    std::uint32_t numIndices{0};
+};
+
+// Appends index ranges of meshlets which are in the view's volume and not
+// backfacing. Ranges of consecutive visible meshlets are merged, so that
+// they can be drawn with a single draw call.
+// Backface culling is skipped for mirrored transforms.
+void cullMeshlets(
+    std::span<const Meshlet> meshlets,
+    const glm::mat4& transform,
+    const MeshletCullingView& view,
+    std::vector<IndexRange>& visibleRanges);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <edbr/Core/PerThreadVector.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+// Per-thread lists of draw commands which are filled by drawMeshParallel
+using ParallelDrawList = PerThreadVector<MeshDrawCommand>;
@@ -1,19 +1,28 @@
 #pragma once
 
 #include <array>
+#include <span>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include <edbr/Graphics/CSMCache.h>
 #include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/MeshLODSelection.h>
+#include <edbr/Graphics/MeshletCulling.h>
 
 #include <edbr/Graphics/IdTypes.h>
+#include <edbr/Graphics/VertexQuantization.h>
 
 class GfxDevice;
 class MeshCache;
 struct MeshDrawCommand;
 struct GPUBuffer;
 
+// Cascaded shadow maps with cached static casters: static casters
+// (MeshDrawCommand::isStatic) are drawn into a persistent layer only when
+// CSMCache decides so, and each frame it's copied into the sampled shadow map
+// and dynamic casters are drawn on top of it.
 class CSMPipeline {
 public:
     static const int NUM_SHADOW_CASCADES = 3;
@@ -22,17 +31,30 @@ public:
     void init(GfxDevice& gfxDevice, const std::array<float, NUM_SHADOW_CASCADES>& percents);
     void cleanup(GfxDevice& gfxDevice);
 
+    // Calculates cascade splits and light space matrices for the current frame.
+    // Must be called before draw (cascade cameras are needed for culling)
+    // staticCastersHash - see graphics::hashStaticShadowCasters
+    void updateCascades(
+        const Camera& camera,
+        const glm::vec3& sunlightDirection,
+        std::uint64_t staticCastersHash);
+
     void draw(
         VkCommandBuffer cmd,
         const GfxDevice& gfxDevice,
         const MeshCache& meshCache,
-        const Camera& camera,
-        const glm::vec3& sunlightDirection,
         const GPUBuffer& materialsBuffer,
         const std::vector<MeshDrawCommand>& meshDrawCommands,
-        bool shadowsEnabled);
+        const std::array<std::span<const std::uint32_t>, NUM_SHADOW_CASCADES>&
+            visibleDrawCommands);
+
+    // LODs of casters are selected by their size in the cascade's shadow map.
+    // Cached cascades are redrawn if the params change
+    void setLODParams(const graphics::LODSelectionParams& params);
+    const graphics::LODSelectionParams& getLODParams() const { return lodParams; }
 
     ImageId getShadowMap() { return csmShadowMapID; }
+    const Camera& getCascadeCamera(std::size_t i) const { return cascadeCameras[i]; }
 
     std::array<float, NUM_SHADOW_CASCADES> cascadeFarPlaneZs{};
     std::array<glm::mat4, NUM_SHADOW_CASCADES> csmLightSpaceTMs{};
@@ -40,13 +62,42 @@ public:
     // how cascades are distributed
     std::array<float, NUM_SHADOW_CASCADES> percents;
 
+    // if false, static casters are redrawn every frame
+    bool cachingEnabled{true};
+    // the last cascade gets dynamic casters drawn every other frame
+    bool updateFarCascadeEveryOtherFrame{false};
+    // Meshlets of static casters are culled against the cascade's bounds
+    // and the light direction. Culled meshlets wouldn't produce any depth,
+    // so cached layers stay valid when this changes
+    bool meshletCullingEnabled{true};
+
 private:
     void initCSMData(GfxDevice& device);
+    // draws static or dynamic casters into the layer (clears it if clear is set)
+    void drawCasters(
+        VkCommandBuffer cmd,
+        VkImageView layerView,
+        bool clear,
+        const MeshCache& meshCache,
+        const GPUBuffer& materialsBuffer,
+        const std::vector<MeshDrawCommand>& meshDrawCommands,
+        std::span<const std::uint32_t> visibleDrawCommands,
+        std::size_t cascadeIndex,
+        bool staticCasters);
+    void copyStaticLayer(VkCommandBuffer cmd, const GfxDevice& gfxDevice, std::size_t cascadeIndex);
 
     ImageId csmShadowMapID{NULL_IMAGE_ID};
+    // static casters only
+    ImageId staticShadowMapID{NULL_IMAGE_ID};
     float shadowMapTextureSize{4096.f};
     std::array<Camera, NUM_SHADOW_CASCADES> cascadeCameras;
     std::array<VkImageView, NUM_SHADOW_CASCADES> csmShadowMapViews;
+    std::array<VkImageView, NUM_SHADOW_CASCADES> staticShadowMapViews;
+
+    CSMCache cache;
+    graphics::LODSelectionParams lodParams;
+    std::vector<graphics::IndexRange> visibleMeshletRanges; // scratch
+    bool shadowMapsInitialized{false}; // images are in VK_IMAGE_LAYOUT_UNDEFINED until then
 
     VkPipelineLayout pipelineLayout;
     VkPipeline pipeline;
@@ -56,6 +107,6 @@ private:
         VkDeviceAddress vertexBuffer;
         VkDeviceAddress materialsBuffer;
         std::uint32_t materialId;
-        std::uint32_t padding;
+        VertexFormat vertexFormat;
     };
 };
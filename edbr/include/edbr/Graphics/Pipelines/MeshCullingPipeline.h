@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <edbr/Graphics/NBuffer.h>
+#include <edbr/Graphics/Vulkan/GPUBuffer.h>
+
+class Camera;
+class GfxDevice;
+struct GPUImage;
+
+// GPU culling for the geometry pass: instances are tested against the
+// camera frustum and against the Hi-Z pyramid built from the previous
+// frame's depth. Visible instances are written per draw and draws without
+// visible instances are compacted away, so that MeshPipeline can draw
+// everything with vkCmdDrawIndexedIndirectCount.
+// Meshlet draws (see graphics::buildMeshletDraws) are culled one by one
+// (frustum, normal cone and Hi-Z) and each visible meshlet gets its own
+// command. Their instances use the visible instance slots after maxInstances.
+// See HiZPyramid for the CPU reference of the Hi-Z part and MeshletCulling.h
+// for the CPU reference of the meshlet tests.
+class MeshCullingPipeline {
+public:
+    void init(GfxDevice& gfxDevice, std::size_t maxInstances, std::size_t maxMeshletDraws);
+    void cleanup(GfxDevice& gfxDevice);
+    // Recreates the buffers which depend on the number of instances and
+    // meshlet draws, waits for the GPU to be idle
+    void resize(GfxDevice& gfxDevice, std::size_t maxInstances, std::size_t maxMeshletDraws);
+
+    void cull(
+        VkCommandBuffer cmd,
+        GfxDevice& gfxDevice,
+        const Camera& camera,
+        const GPUBuffer& instanceDataBuffer,
+        const GPUBuffer& indirectCommandsBuffer,
+        std::uint32_t numInstances,
+        std::uint32_t numDraws,
+        std::uint32_t numIndex16Draws,
+        const GPUBuffer& meshletBuffer,
+        const GPUBuffer& meshletDrawsBuffer,
+        std::uint32_t numMeshletDraws,
+        std::uint32_t numIndex16MeshletDraws);
+
+    // Builds the Hi-Z pyramid which will be used by cull() next frame.
+    // depthImage should be single sampled (resolved) and in
+    // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    void buildHiZ(
+        VkCommandBuffer cmd,
+        GfxDevice& gfxDevice,
+        const GPUImage& depthImage,
+        const Camera& camera);
+    // should be called when the depth image gets recreated
+    void invalidateHiZ() { hizValid = false; }
+
+    const GPUBuffer& getVisibleInstancesBuffer() const { return visibleInstancesBuffer; }
+    const GPUBuffer& getCompactedCommandsBuffer() const { return compactedCommandsBuffer; }
+    // Two counts: draws with 16-bit indices and draws with 32-bit ones.
+    // Compacted commands with 32-bit indices start at
+    // numIndex16Draws + numIndex16MeshletDraws
+    const GPUBuffer& getDrawCountBuffer() const { return drawCountBuffer; }
+    std::uint32_t getMaxDraws() const { return maxDraws; }
+
+    bool occlusionCullingEnabled{true};
+
+private:
+    void createOutputBuffers(
+        GfxDevice& gfxDevice,
+        std::size_t maxInstances,
+        std::size_t maxMeshletDraws);
+    void destroyOutputBuffers(GfxDevice& gfxDevice);
+    void createHiZBuffer(GfxDevice& gfxDevice, const glm::ivec2& depthImageSize);
+
+    VkPipelineLayout cullPipelineLayout;
+    VkPipeline cullPipeline;
+    VkPipeline compactPipeline;
+    VkPipeline meshletCullPipeline;
+
+    VkPipelineLayout hizPipelineLayout;
+    VkPipeline hizPipeline;
+
+    // keep in sync with mesh_cull.glsl
+    struct CullPushConstants {
+        VkDeviceAddress cullData;
+        VkDeviceAddress instances;
+        VkDeviceAddress commands;
+        VkDeviceAddress visibleCounts;
+        VkDeviceAddress visibleInstances;
+        VkDeviceAddress hiz;
+        VkDeviceAddress compactedCommands;
+        VkDeviceAddress drawCount;
+        VkDeviceAddress meshlets;
+        VkDeviceAddress meshletDraws;
+    };
+
+    struct HiZPushConstants {
+        VkDeviceAddress hiz;
+        glm::ivec2 depthImageSize;
+        std::uint32_t depthImageId;
+        std::uint32_t level;
+    };
+
+    // keep in sync with mesh_cull.glsl
+    struct CullData {
+        std::array<glm::vec4, 6> frustumPlanes;
+        glm::mat4 hizView;
+        glm::mat4 hizProj;
+        glm::ivec2 depthImageSize;
+        float hizZNear;
+        std::uint32_t occlusionCullingEnabled;
+        std::uint32_t numInstances;
+        std::uint32_t numDraws;
+        std::uint32_t numIndex16Draws;
+        std::uint32_t numMeshletDraws;
+        std::uint32_t numIndex16MeshletDraws;
+        std::uint32_t numIndex16Slots; // first compacted command with 32-bit indices
+        std::uint32_t firstMeshletInstance; // first visible instance slot of meshlet draws
+        glm::vec3 cameraPos;
+    };
+    NBuffer cullDataBuffer;
+
+    std::uint32_t maxInstances{0};
+    std::uint32_t maxDraws{0};
+    std::uint32_t maxMeshletDraws{0};
+
+    GPUBuffer visibleCountsBuffer;
+    GPUBuffer visibleInstancesBuffer;
+    GPUBuffer compactedCommandsBuffer;
+    GPUBuffer drawCountBuffer;
+
+    GPUBuffer hizBuffer;
+    glm::ivec2 hizDepthImageSize{};
+    bool hizValid{false};
+    // camera which was used to render the depth which Hi-Z was built from
+    glm::mat4 hizView{1.f};
+    glm::mat4 hizProj{1.f};
+    float hizZNear{0.f};
+};
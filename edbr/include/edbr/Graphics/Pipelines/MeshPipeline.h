@@ -1,18 +1,14 @@
 #pragma once
 
-#include <glm/mat4x4.hpp>
-
-#include <vector>
+#include <cstdint>
 
 #include <vulkan/vulkan.h>
 
 class GfxDevice;
 class MeshCache;
 class MaterialCache;
-class Camera;
 struct GPUImage;
 struct GPUBuffer;
-struct MeshDrawCommand;
 
 class MeshPipeline {
 public:
@@ -29,18 +25,19 @@ public:
         const GfxDevice& gfxDevice,
         const MeshCache& meshCache,
         const MaterialCache& materialCache,
-        const Camera& camera,
         const GPUBuffer& sceneDataBuffer,
-        const std::vector<MeshDrawCommand>& drawCommands,
-        const std::vector<std::size_t>& sortedDrawCommands);
+        const GPUBuffer& instanceDataBuffer,
+        const GPUBuffer& visibleInstancesBuffer,
+        const GPUBuffer& indirectCommandsBuffer,
+        const GPUBuffer& drawCountBuffer,
+        std::uint32_t maxDraws,
+        std::uint32_t numIndex16Draws);
 
 private:
     struct PushConstants {
-        glm::mat4 transform;
         VkDeviceAddress sceneDataBuffer;
-        VkDeviceAddress vertexBuffer;
-        std::uint32_t materialId;
-        std::uint32_t padding;
+        VkDeviceAddress instanceDataBuffer;
+        VkDeviceAddress visibleInstancesBuffer;
     };
 
     VkPipelineLayout pipelineLayout;
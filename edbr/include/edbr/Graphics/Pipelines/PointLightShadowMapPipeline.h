@@ -1,81 +1,115 @@
 #pragma once
 
 #include <array>
-#include <unordered_map>
+#include <span>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
 #include <edbr/Graphics/Camera.h>
-#include <edbr/Graphics/Light.h>
+#include <edbr/Graphics/MeshLODSelection.h>
+#include <edbr/Graphics/MeshletCulling.h>
 #include <edbr/Graphics/NBuffer.h>
+#include <edbr/Graphics/PointShadowAtlas.h>
 #include <edbr/Graphics/Vulkan/GPUBuffer.h>
 
 #include <edbr/Graphics/IdTypes.h>
+#include <edbr/Graphics/VertexQuantization.h>
 
 class GfxDevice;
 class MeshCache;
 struct MeshDrawCommand;
-struct Light;
+struct GPULightData;
 
+// Point light shadows: each face of the point light's "cubemap" is drawn into
+// its own tile of a single depth atlas. PointShadowAtlas decides which lights
+// get shadows, how big their tiles are and which faces need to be redrawn.
 class PointLightShadowMapPipeline {
+public:
+    static constexpr int MAX_POINT_LIGHTS = 16;
+
+    // see PointShadowFace in shadow.glsl
+    struct GPUFaceData {
+        glm::mat4 viewProj;
+        // xy - offset, z - size (in atlas UV space), w - half texel (in face UV space)
+        glm::vec4 atlasRect;
+    };
+
 public:
     void init(GfxDevice& gfxDevice, float pointLightMaxRange);
     void cleanup(GfxDevice& gfxDevice);
 
-    void beginFrame(
-        VkCommandBuffer cmd,
-        const GfxDevice& gfxDevice,
-        const std::vector<GPULightData>& lightData,
-        const std::vector<std::size_t> pointLightIndices);
+    // Ranks point lights and allocates their atlas tiles.
+    // Must be called before beginFrame (face cameras are needed for culling)
+    void updateLights(const Camera& camera, std::span<const GPULightData> lightData);
+    // index in this span is the light's shadow slot
+    std::span<const PointShadowAtlas::ShadowCastingLight> getShadowCastingLights() const
+    {
+        return atlas.getShadowCastingLights();
+    }
+    // see PointShadowAtlas::updateFaceCasters
+    void updateFaceCasters(
+        std::size_t slot,
+        std::size_t face,
+        const std::vector<MeshDrawCommand>& meshDrawCommands,
+        std::span<const std::uint32_t> visibleDrawCommands);
+
+    // LODs of casters are selected by their size in the face's tile.
+    // Cached faces are redrawn if the params change
+    void setLODParams(const graphics::LODSelectionParams& params);
+
+    void beginFrame(VkCommandBuffer cmd, const GfxDevice& gfxDevice);
+    // draws faces of the light in the slot which are marked as FaceState::Draw
     void draw(
         VkCommandBuffer cmd,
         const GfxDevice& gfxDevice,
         const MeshCache& meshCache,
-        const Camera& camera,
-        const std::uint32_t lightIndex,
-        const glm::vec3& lightPos,
+        std::size_t slot,
         const GPUBuffer& materialsBuffer,
-        const GPUBuffer& lightsBuffer,
         const std::vector<MeshDrawCommand>& meshDrawCommands,
-        bool shadowsEnabled);
+        const std::array<std::span<const std::uint32_t>, PointShadowAtlas::NUM_FACES>&
+            visibleDrawCommands);
     void endFrame(VkCommandBuffer cmd, const GfxDevice& gfxDevice);
 
-    const std::unordered_map<std::uint32_t, ImageId>& getLightToShadowMapId() const
-    {
-        return lightToShadowMapId;
-    };
+    ImageId getShadowAtlas() const { return shadowAtlasID; }
+    // GPUFaceData for each face of each slot
+    const GPUBuffer& getFacesBuffer() const { return facesBuffer.getBuffer(); }
 
-private:
-    void initCSMData(GfxDevice& device);
+    PointShadowAtlas::Stats getStats() const { return atlas.getStats(); }
+    std::size_t getNumDraws() const { return numDraws; }
 
+    // if false, visible faces are redrawn every frame
+    bool cachingEnabled{true};
+    // meshlets of static casters are culled against each face's caster volume
+    bool meshletCullingEnabled{true};
+
+private:
     float pointLightMaxRange{0.f}; // set in init function
-    float shadowMapTextureSize{1024.f};
 
-    static constexpr int MAX_POINT_LIGHTS = 16;
-    std::array<Camera, MAX_POINT_LIGHTS * 6> pointLightShadowMapCameras;
-    std::array<glm::mat4, MAX_POINT_LIGHTS * 6> pointLightShadowMapVPs;
+    PointShadowAtlas atlas;
+    graphics::LODSelectionParams lodParams;
+    std::vector<graphics::IndexRange> visibleMeshletRanges; // scratch
+    ImageId shadowAtlasID{NULL_IMAGE_ID};
+    bool shadowAtlasInitialized{false}; // in VK_IMAGE_LAYOUT_UNDEFINED until then
+    bool drawingFaces{false}; // atlas is in VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
 
-    std::array<ImageId, MAX_POINT_LIGHTS> shadowMaps;
-    std::vector<VkImageView> shadowMapImageViews;
+    std::array<GPUFaceData, MAX_POINT_LIGHTS * PointShadowAtlas::NUM_FACES> faceData;
+    NBuffer facesBuffer;
+    std::size_t numDraws{0};
 
     VkPipelineLayout pipelineLayout;
     VkPipeline pipeline;
 
     struct PushConstants {
         glm::mat4 model;
+        // passed directly because the lights buffer is uploaded after shadow mapping
+        glm::vec3 lightPosition;
+        float farPlane;
         VkDeviceAddress vertexBuffer;
         VkDeviceAddress materialsBuffer;
-        VkDeviceAddress lightsBuffer;
-        VkDeviceAddress vpsBuffer;
+        VkDeviceAddress facesBuffer;
         std::uint32_t materialId;
-        std::uint32_t lightIndex;
-        std::uint32_t vpsBufferIndex;
-        float farPlane;
+        std::uint32_t faceIndex; // index in facesBuffer
+        VertexFormat vertexFormat;
     };
-
-    std::unordered_map<std::uint32_t, ImageId> lightToShadowMapId;
-    std::uint32_t currShadowMapIndex{0};
-
-    NBuffer vpsBuffer;
 };
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <array>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
 #include <glm/mat4x4.hpp>
 
 #include <edbr/Graphics/Common.h>
+#include <edbr/Graphics/SkinningJobBuilder.h>
 #include <edbr/Graphics/Vulkan/AppendableBuffer.h>
 
 struct MeshDrawCommand;
@@ -18,11 +20,12 @@ public:
     void init(GfxDevice& gfxDevice);
     void cleanup(GfxDevice& gfxDevice);
 
+    // Skins all skinned meshes of drawCommands with a single indirect dispatch
     void doSkinning(
         VkCommandBuffer cmd,
         std::size_t frameIndex,
         const MeshCache& meshCache,
-        const MeshDrawCommand& dc);
+        const std::vector<MeshDrawCommand>& drawCommands);
 
     void beginDrawing(std::size_t frameIndex);
     std::size_t appendJointMatrices(
@@ -34,18 +37,20 @@ private:
     VkPipeline skinningPipeline;
     struct PushConstants {
         VkDeviceAddress jointMatricesBuffer;
-        std::uint32_t jointMatricesStartIndex;
-        std::uint32_t numVertices;
-        VkDeviceAddress inputBuffer;
-        VkDeviceAddress skinningData;
-        VkDeviceAddress outputBuffer;
+        VkDeviceAddress jobsBuffer;
+        std::uint32_t numJobs;
     };
     static constexpr std::size_t MAX_JOINT_MATRICES = 5000;
+    static constexpr std::size_t MAX_SKINNING_JOBS = 1000;
 
     struct PerFrameData {
         AppendableBuffer<glm::mat4> jointMatricesBuffer;
+        AppendableBuffer<GPUSkinningJob> jobsBuffer;
+        GPUBuffer dispatchCommandBuffer; // VkDispatchIndirectCommand
     };
 
+    std::vector<GPUSkinningJob> jobs;
+
     std::array<PerFrameData, graphics::FRAME_OVERLAP> framesData;
 
     PerFrameData& getCurrentFrameData(std::size_t frameIndex);
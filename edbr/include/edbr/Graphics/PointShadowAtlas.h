@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include <edbr/Graphics/Camera.h>
+
+struct GPULightData;
+struct MeshDrawCommand;
+
+// Square region of the shadow atlas (in texels)
+struct ShadowAtlasTile {
+    std::uint32_t x{0};
+    std::uint32_t y{0};
+    std::uint32_t size{0};
+
+    bool operator==(const ShadowAtlasTile&) const = default;
+};
+
+// Quadtree ("buddy") allocator of power-of-two tiles in a square atlas.
+// Freed tiles are merged back with their siblings, so that the atlas
+// doesn't get fragmented when tile sizes change.
+class ShadowAtlasAllocator {
+public:
+    void init(std::uint32_t atlasSize, std::uint32_t minTileSize);
+
+    // size must be a power of two in [minTileSize, atlasSize]
+    std::optional<ShadowAtlasTile> allocate(std::uint32_t size);
+    void free(const ShadowAtlasTile& tile);
+
+    std::uint64_t getNumFreeTexels() const;
+    std::uint32_t getAtlasSize() const { return atlasSize; }
+
+private:
+    std::size_t getLevel(std::uint32_t size) const;
+    std::uint32_t getLevelSize(std::size_t level) const { return atlasSize >> level; }
+
+    std::uint32_t atlasSize{0};
+    std::uint32_t minTileSize{0};
+    // free tiles by level: level 0 is the whole atlas, every next level has
+    // tiles which are two times smaller
+    std::vector<std::vector<ShadowAtlasTile>> freeTiles;
+};
+
+// Decides which point lights get shadows, where their cubemap faces are
+// placed in the shadow atlas and which faces have to be redrawn
+// (see PointLightShadowMapPipeline).
+// Lights are ranked by the screen area of their range sphere and only the top
+// maxShadowCastingLights get shadows. Tile size halves every time the distance
+// to the camera doubles. Faces which can't shadow anything visible are skipped
+// and faces whose casters didn't change since they were drawn are kept.
+class PointShadowAtlas {
+public:
+    static constexpr std::size_t NUM_FACES = 6;
+
+    enum class FaceState {
+        Skipped, // doesn't intersect the view frustum
+        Cached, // tile has the same casters drawn in one of the previous frames
+        Draw,
+    };
+
+    struct Params {
+        std::uint32_t atlasSize{4096};
+        std::uint32_t maxTileSize{512};
+        std::uint32_t minTileSize{64};
+        // lights closer than this get maxTileSize tiles
+        float fullResolutionDistance{6.f};
+        // tile size isn't changed until the distance is this far (in log2 units)
+        // from the distance where it would change, so that lights near
+        // the threshold don't get redrawn every frame
+        float lodHysteresis{0.2f};
+        std::size_t maxShadowCastingLights{16};
+        // if false, all visible faces are redrawn every frame
+        bool cachingEnabled{true};
+    };
+
+    struct Face {
+        Camera camera;
+        ShadowAtlasTile tile;
+        FaceState state{FaceState::Skipped};
+
+        // casters drawn into the tile
+        bool valid{false};
+        std::uint64_t castersHash{0};
+    };
+
+    struct ShadowCastingLight {
+        // index into the lights passed to update - lights are expected to
+        // come in the same order each frame, otherwise caching doesn't work
+        std::size_t lightIndex;
+        glm::vec3 position;
+        float range{0.f};
+        float importance{0.f};
+        std::uint32_t lod{0}; // desired tile size is maxTileSize >> lod
+        std::uint32_t tileSize{0}; // can be smaller than desired if the atlas is full
+        std::array<Face, NUM_FACES> faces;
+    };
+
+    struct Stats {
+        std::size_t numLights{0};
+        std::size_t numDrawnFaces{0};
+        std::size_t numCachedFaces{0};
+        std::size_t numSkippedFaces{0};
+    };
+
+public:
+    // farPlane - far plane of face cameras, depth is stored as distance / farPlane
+    void init(const Params& params, float farPlane);
+
+    // Ranks point lights and (re)allocates their tiles.
+    // Visible faces are marked as FaceState::Draw until updateFaceCasters is called.
+    void update(const Camera& camera, std::span<const GPULightData> lights);
+    // Marks the face as FaceState::Cached if casters visible from it are the
+    // same as when it was drawn. Skinned casters always make the face redrawn.
+    void updateFaceCasters(
+        std::size_t slot,
+        std::size_t face,
+        const std::vector<MeshDrawCommand>& meshDrawCommands,
+        std::span<const std::uint32_t> visibleDrawCommands);
+    // forces all faces to be redrawn
+    void invalidate();
+
+    // sorted by importance, index in this span is the light's slot
+    std::span<const ShadowCastingLight> getShadowCastingLights() const { return lights; }
+    Stats getStats() const;
+
+    const ShadowAtlasAllocator& getAllocator() const { return allocator; }
+    const Params& getParams() const { return params; }
+    // frees all tiles if tile sizes change
+    void setParams(const Params& params);
+
+private:
+    std::uint32_t calculateLOD(float distance, std::optional<std::uint32_t> prevLOD) const;
+    bool allocateTiles(ShadowCastingLight& light, std::uint32_t tileSize);
+    void freeTiles(ShadowCastingLight& light);
+    void initFaceCameras(ShadowCastingLight& light) const;
+
+    Params params;
+    float farPlane{0.f};
+    ShadowAtlasAllocator allocator;
+    std::vector<ShadowCastingLight> lights;
+};
+
+namespace graphics
+{
+// Returns which face of the point light's "cubemap" has the point at
+// lightToPoint - faces look along +X, -X, +Y, -Y, +Z, -Z.
+// Must be kept in sync with getPointShadowFace in shadow.glsl
+std::size_t getPointShadowFace(const glm::vec3& lightToPoint);
+}
@@ -2,13 +2,16 @@
 
 #include <filesystem>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include <edbr/Graphics/AnimationCompression.h>
 #include <edbr/Graphics/CPUMesh.h>
 #include <edbr/Graphics/Light.h>
 #include <edbr/Graphics/Material.h>
+#include <edbr/Graphics/MeshOptimization.h>
 #include <edbr/Graphics/SkeletalAnimation.h>
 #include <edbr/Graphics/Skeleton.h>
 #include <edbr/Math/AABB.h>
@@ -41,12 +44,47 @@ struct Scene {
 
     std::vector<SceneMesh> meshes;
     std::vector<Skeleton> skeletons;
+    // compressed by scene_cooker or by SceneCache when loading glTF
     std::unordered_map<std::string, SkeletalAnimation> animations;
+    // moved to SkeletalAnimationCache by SceneCache
+    std::unordered_map<std::string, CompressedAnimation> compressedAnimations;
     std::vector<Light> lights;
     std::unordered_map<MeshId, CPUMesh> cpuMeshes;
 };
 
+// Scene loaded on CPU only: nothing is uploaded to GPU yet and materials
+// reference their textures by path. Used for cooking scenes (see CookedScene.h)
+struct SceneMaterial {
+    Material material; // texture ids are not set
+    // empty if the material doesn't have the texture
+    std::filesystem::path diffuseTexture;
+    std::filesystem::path normalMapTexture;
+    std::filesystem::path metallicRoughnessTexture;
+    std::filesystem::path emissiveTexture;
+};
+
+struct ScenePrimitive {
+    CPUMesh mesh;
+    int materialIndex{-1}; // index in SceneData::materials
+    graphics::MeshOptimizationStats optimizationStats; // see graphics::optimizeMesh
+};
+
+struct SceneData {
+    std::vector<SceneMaterial> materials;
+    std::vector<std::vector<ScenePrimitive>> meshes;
+    // skeletons, animations, lights and nodes (meshes are not set)
+    Scene scene;
+};
+
+class GfxDevice;
+
 namespace edbr
 {
 math::AABB calculateBoundingBoxLocal(const Scene& scene, const std::vector<MeshId> meshes);
+
+// Loads textures of all materials as one batch (see GfxDevice::loadImagesFromFiles):
+// textures show the error image until they're uploaded
+std::vector<Material> loadSceneMaterials(
+    GfxDevice& gfxDevice,
+    std::span<const SceneMaterial> sceneMaterials);
 }
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+
+#include <glm/vec3.hpp>
+
+#include <edbr/Graphics/FrustumCulling.h>
+
+class Camera;
+
+// Volumes which contain all objects that can cast shadows into a shadow pass.
+// They're passed to CullingStage as views, so each pass gets its own list of casters.
+namespace edge
+{
+// Face of a point light's "cubemap": the face camera's frustum without the far
+// plane, intersected with the light's range sphere - objects out of range
+// can't shadow anything lit by the light
+CullingVolume createPointLightFaceCasterVolume(
+    const Camera& faceCamera,
+    const glm::vec3& lightPosition,
+    float lightRange);
+
+// Receiver volume extruded towards the light: objects which are outside of
+// the receiver volume (e.g. off-screen or above the cascade's near plane) can
+// still cast shadows into it.
+// receiverCorners - in the same order as calculateFrustumCornersWorldSpace returns
+// lightDir - direction towards the light (same as GPULightData::direction)
+CullingVolume createDirectionalLightCasterVolume(
+    const std::array<glm::vec3, 8>& receiverCorners,
+    const glm::vec3& lightDir);
+}
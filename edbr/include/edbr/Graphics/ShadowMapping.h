@@ -4,8 +4,25 @@
 
 #include <glm/fwd.hpp>
 
+#include <edbr/Math/Sphere.h>
+
 class Camera;
 
+// Sphere around the AABB of the frustum
+math::Sphere calculateCSMBoundingSphere(const std::array<glm::vec3, 8>& frustumCorners);
+
+// Orthographic light camera which covers the sphere with the given center
+// and radius (center should already be snapped to shadow map texels)
+Camera createCSMCamera(const glm::vec3& center, float radius, const glm::vec3& lightDir);
+
+// Snaps the position to shadow map texels in light space, so that shadow
+// edges don't shimmer when the cascade moves
+glm::vec3 snapToShadowMapTexels(
+    const glm::vec3& pos,
+    const glm::vec3& lightDir,
+    float radius,
+    float shadowMapSize);
+
 Camera calculateCSMCamera(
     const std::array<glm::vec3, 8>& frustumCorners,
     const glm::vec3& lightDir,
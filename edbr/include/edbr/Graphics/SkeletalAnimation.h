@@ -7,6 +7,8 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/vec3.hpp>
 
+#include <edbr/Graphics/AnimationSampling.h>
+
 struct SkeletalAnimation {
     struct Tracks {
         std::vector<glm::vec3> translations;
@@ -15,6 +17,8 @@ struct SkeletalAnimation {
     };
 
     std::vector<Tracks> tracks; // index = jointId
+    // same tracks in the layout used by SkeletonAnimator (see makeSoAAnimation)
+    SoAAnimation soaTracks;
     float duration{0.f}; // in seconds
     bool looped{true};
 
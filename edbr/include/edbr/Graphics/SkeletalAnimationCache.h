@@ -2,8 +2,10 @@
 
 #include <filesystem>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 
+#include <edbr/Graphics/AnimationCompression.h>
 #include <edbr/Graphics/SkeletalAnimation.h>
 
 class SkeletalAnimationCache {
@@ -11,12 +13,31 @@ public:
     void loadAnimationData(const std::filesystem::path& path);
 
     using AnimationsMap = std::unordered_map<std::string, SkeletalAnimation>;
-    void addAnimations(const std::filesystem::path& gltfPath, AnimationsMap anims);
-    const AnimationsMap& getAnimations(const std::filesystem::path& gltfPath) const;
+    using CompressedAnimationsMap = std::unordered_map<std::string, CompressedAnimation>;
+    // Only compressed animations are stored (see AnimationCompression.h)
+    void addAnimations(const std::filesystem::path& gltfPath, CompressedAnimationsMap anims);
+
+    const CompressedAnimationsMap& getAnimations(const std::filesystem::path& gltfPath) const;
+
+    bool hasAnimation(const std::filesystem::path& gltfPath, const std::string& name) const;
+    // Decompresses the animation the first time it's requested. The decompressed
+    // animation is shared by all its users and stays valid for the lifetime of the cache.
+    // Thread safe.
+    const SkeletalAnimation& getAnimation(
+        const std::filesystem::path& gltfPath,
+        const std::string& name);
+
+    std::size_t getNumAnimations() const;
+    std::size_t getCompressedDataSize() const;
+    std::size_t getDecompressedDataSize() const;
 
 private:
-    // gltf path -> animations
-    std::unordered_map<std::string, AnimationsMap> animations;
+    // gltf path -> compressed animations
+    std::unordered_map<std::string, CompressedAnimationsMap> compressedAnimations;
+
+    // gltf path -> animation name -> decompressed animation (only has soaTracks)
+    std::unordered_map<std::string, AnimationsMap> decompressedAnimations;
+    mutable std::mutex decompressedAnimationsMutex;
 
     struct AnimationData {
         bool looped{true};
@@ -5,6 +5,7 @@
 
 #include <glm/mat4x4.hpp>
 
+#include <edbr/Graphics/AnimationSampling.h>
 #include <edbr/Graphics/IdTypes.h>
 #include <edbr/Math/Transform.h>
 
@@ -22,4 +23,7 @@ struct Skeleton {
 
     std::vector<Joint> joints;
     std::vector<std::string> jointNames;
+
+    // used by SkeletonAnimator for sampling animations
+    FlatSkeleton flatSkeleton;
 };
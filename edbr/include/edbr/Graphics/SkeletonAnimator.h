@@ -5,22 +5,57 @@
 
 #include <glm/mat4x4.hpp>
 
+#include <edbr/Graphics/AnimationSampling.h>
 #include <edbr/Graphics/Skeleton.h>
 
 struct SkeletalAnimation;
 
+// Clips placed on a line by some parameter (e.g. movement speed). Clips are
+// played in sync by normalized time, so that e.g. the feet of Walk and Run
+// stay in the same phase while they're blended. Clips are always looped.
+struct AnimationBlendSpace1D {
+    struct Entry {
+        float position{0.f};
+        const SkeletalAnimation* animation{nullptr};
+    };
+
+    std::string name;
+    std::vector<Entry> entries; // sorted by position
+};
+
+// Plays animations of one skeleton. What's played is built like a small
+// blend tree: the current animation or blend space, cross-faded with the
+// previous one, with additive layers on top. Everything is blended as local
+// poses and joint matrices are calculated once per update.
 class SkeletonAnimator {
 public:
-    void setAnimation(const Skeleton& skeleton, const SkeletalAnimation& animation);
+    // If fadeDuration > 0, the previous animation is cross-faded into the new one
+    void setAnimation(
+        const Skeleton& skeleton,
+        const SkeletalAnimation& animation,
+        float fadeDuration = 0.f);
+    void setBlendSpace(
+        const Skeleton& skeleton,
+        const AnimationBlendSpace1D& blendSpace,
+        float fadeDuration = 0.f);
+    void setBlendParameter(float value) { current.blendParameter = value; }
+
+    // Additive layers are applied on top of the base animation in order.
+    // soaTracks of the animation should be made by graphics::makeAdditiveAnimation.
+    // Layers are always looped.
+    void setAdditiveLayer(std::size_t layer, const SkeletalAnimation* animation, float weight);
+    void setAdditiveLayerWeight(std::size_t layer, float weight);
 
     void update(const Skeleton& skeleton, float dt);
 
-    const SkeletalAnimation* getAnimation() const { return animation; }
+    // when a blend space is played, this is the clip which has the most weight
+    const SkeletalAnimation* getAnimation() const { return current.animation; }
     const std::string& getCurrentAnimationName() const;
 
-    bool isAnimationFinished() const { return animationFinished; }
+    bool isAnimationFinished() const { return current.finished; }
+    bool isBlendSpacePlaying() const { return !current.blendSpace.entries.empty(); }
 
-    float getProgress() const { return time; }
+    float getProgress() const { return current.time; }
 
     void setNormalizedProgress(float t);
     float getNormalizedProgress() const;
@@ -31,21 +66,42 @@ public:
     int getCurrentFrame() const { return currentFrame; }
 
 private:
+    struct State {
+        // clip which is played (or dominant clip of the blend space)
+        const SkeletalAnimation* animation{nullptr};
+        AnimationBlendSpace1D blendSpace; // copied, so that the caller doesn't need to keep it
+        float blendParameter{0.f};
+        float time{0.f}; // in seconds, time of animation
+        bool finished{false};
+        bool frozen{false}; // uses fadeOutPose instead of sampling
+
+        bool isActive() const { return animation != nullptr || frozen; }
+    };
+
+    struct AdditiveLayer {
+        const SkeletalAnimation* animation{nullptr};
+        float weight{0.f};
+        float time{0.f};
+    };
+
+    void startFade(float fadeDuration);
+    void advance(State& state, float dt);
+    void samplePose(const State& state, LocalPose& pose);
     void calculateJointMatrices(const Skeleton& skeleton);
-    void calculateJointMatrix(
-        const Skeleton& skeleton,
-        JointId jointId,
-        const SkeletalAnimation& animation,
-        float time,
-        const glm::mat4& parentTransform);
 
-    float time{0}; // current animation time (in seconds)
-    const SkeletalAnimation* animation{nullptr};
-    bool animationFinished{false};
+    State current;
+    State previous; // being faded out
+    float fadeTime{0.f};
+    float fadeDuration{0.f};
+    std::vector<AdditiveLayer> layers;
 
     int currentFrame{0};
-    bool firstFrame = true;
     bool frameChanged{false};
 
+    LocalPosePool posePool;
+    LocalPose basePose; // last pose without additive layers
+    LocalPose fadeOutPose; // snapshot of basePose when a fade is interrupted
+
     std::vector<glm::mat4> jointMatrices;
+    std::vector<glm::mat4> transforms; // scratch for calculateJointMatrices
 };
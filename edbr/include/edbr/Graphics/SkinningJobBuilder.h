@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <edbr/Graphics/VertexQuantization.h>
+
+struct GPUMesh;
+struct MeshDrawCommand;
+
+// One skinned mesh instance to be skinned by skinning.comp
+// keep in sync with skinning.comp
+struct GPUSkinningJob {
+    VkDeviceAddress inputBuffer; // mesh's vertices in MeshCache's vertex buffer
+    VkDeviceAddress skinningData; // compact for VertexFormat::Compact meshes
+    VkDeviceAddress outputBuffer; // always VertexFormat::Full
+    std::uint32_t jointMatricesStartIndex;
+    std::uint32_t numVertices;
+    std::uint32_t firstGroup; // first workgroup which skins this job's vertices
+    VertexFormat inputVertexFormat;
+};
+
+namespace graphics
+{
+static constexpr std::uint32_t SKINNING_WORKGROUP_SIZE = 256;
+
+// Builds a job table for all skinned draw commands so that they can be
+// skinned with one dispatch. Each skinned mesh is added only once, even
+// if there are several draw commands for it. Every job gets a range of
+// workgroups which starts at firstGroup, so jobs are sorted by it.
+// jobs is cleared first. Returns the number of workgroups to dispatch.
+std::uint32_t buildSkinningJobs(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<GPUSkinningJob>& jobs);
+}
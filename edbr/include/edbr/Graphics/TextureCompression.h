@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// CPU-side block compression for offline texture cooking (see CookedTexture.h).
+// Encoders work on 4x4 blocks of texels in row-major order.
+namespace graphics
+{
+enum class BlockCompression {
+    BC4, // one channel (R)
+    BC5, // two channels (RG)
+    BC7, // RGBA
+};
+
+// in bytes, per 4x4 block
+std::size_t getBlockSize(BlockCompression compression);
+std::size_t getCompressedSize(
+    BlockCompression compression,
+    std::uint32_t width,
+    std::uint32_t height);
+
+void encodeBC4Block(std::span<const std::uint8_t, 16> values, std::span<std::uint8_t, 8> block);
+void decodeBC4Block(std::span<const std::uint8_t, 8> block, std::span<std::uint8_t, 16> values);
+
+// Only uses mode 6 (one subset, 7-bit RGBA endpoints + p-bits, 4-bit
+// indices), which is good enough for most textures and fast to encode
+void encodeBC7Block(std::span<const std::uint8_t, 64> rgba, std::span<std::uint8_t, 16> block);
+// Only decodes mode 6 blocks. Returns false for blocks in other modes.
+bool decodeBC7Block(std::span<const std::uint8_t, 16> block, std::span<std::uint8_t, 64> rgba);
+
+// rgba should contain width * height RGBA8 texels. Texels of partial
+// blocks at the right and bottom edges are clamped to the edge.
+std::vector<std::uint8_t> compressImage(
+    BlockCompression compression,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> rgba);
+// Returns RGBA8 texels. Channels which aren't stored are 0 (alpha is 255).
+std::vector<std::uint8_t> decompressImage(
+    BlockCompression compression,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> data);
+
+// how texels are averaged when mips are generated
+enum class MipFilter {
+    Linear,
+    SRGB, // RGB is averaged in linear space
+    NormalMap, // RGB is a unit vector which is renormalized
+};
+
+// Returns all mips of RGBA8 image down to 1x1 (the first one is a copy of rgba).
+// The number of mips is the same as GfxDevice uses for mipmapped images.
+std::vector<std::vector<std::uint8_t>> generateMipChain(
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> rgba,
+    MipFilter filter);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace graphics
+{
+// a copy from the staging buffer into dstBuffer
+struct BufferUploadRegion {
+    VkBuffer dstBuffer{VK_NULL_HANDLE};
+    VkBufferCopy region;
+};
+
+// copies which can be done with one vkCmdCopyBuffer
+struct BufferUploadBatch {
+    VkBuffer dstBuffer{VK_NULL_HANDLE};
+    std::vector<VkBufferCopy> regions;
+};
+
+// Groups copies by destination buffer and merges copies which are
+// contiguous both in the staging buffer and in the destination buffer.
+// Copies into the same buffer keep their order: if a copy overlaps
+// an earlier one, it goes into a separate batch (regions of one
+// vkCmdCopyBuffer must not overlap).
+std::vector<BufferUploadBatch> coalesceBufferUploads(std::span<const BufferUploadRegion> uploads);
+
+// data of one mip of one layer of an image
+struct ImageSubresourceUpload {
+    std::span<const std::byte> data;
+    std::uint32_t layer{0};
+    std::uint32_t mipLevel{0};
+};
+
+// copies of all subresources of an image from one staging allocation
+struct ImageUploadRegions {
+    std::size_t stagingSize{0};
+    std::vector<VkBufferImageCopy> regions; // bufferOffset is relative to the allocation
+};
+
+// Places subresources one after another, each one starts at an aligned offset
+ImageUploadRegions makeImageUploadRegions(
+    const VkExtent3D& extent,
+    std::span<const ImageSubresourceUpload> subresources,
+    std::size_t alignment);
+}
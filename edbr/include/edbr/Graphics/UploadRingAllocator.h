@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+// UploadRingAllocator manages space in a ring-shaped staging buffer. Like
+// BufferSubAllocator, it doesn't know anything about the GPU. Allocations
+// are grouped into batches (one batch = one GPU submission) and space is
+// freed in the order of allocation once the batch's submission is complete.
+class UploadRingAllocator {
+public:
+    UploadRingAllocator() = default;
+    explicit UploadRingAllocator(std::size_t capacity);
+
+    // Returns the offset of the allocated range or nullopt if there's not
+    // enough free space. Allocations never wrap around the end of the buffer.
+    [[nodiscard]] std::optional<std::size_t> allocate(std::size_t size, std::size_t alignment);
+
+    // All allocations made since the previous endBatch belong to the
+    // submission which will signal submitValue
+    void endBatch(std::uint64_t submitValue);
+    // Frees the space of all batches with submitValue <= completedValue
+    void release(std::uint64_t completedValue);
+
+    bool hasBatchesInFlight() const { return !batches.empty(); }
+    // submit value of the oldest batch which wasn't released yet
+    std::uint64_t getOldestBatchValue() const;
+
+    std::size_t getCapacity() const { return capacity; }
+    // includes padding and space skipped at the end of the buffer
+    std::size_t getUsedSize() const { return usedSize; }
+
+private:
+    struct Batch {
+        std::uint64_t submitValue;
+        std::size_t size;
+    };
+
+    std::size_t capacity{0};
+    std::size_t head{0}; // where the next allocation starts
+    std::size_t tail{0}; // start of the oldest used range
+    std::size_t usedSize{0};
+    std::size_t currentBatchSize{0};
+    std::deque<Batch> batches;
+};
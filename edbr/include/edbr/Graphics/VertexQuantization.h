@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <edbr/Graphics/CPUMesh.h>
+
+// How a mesh's vertices are stored in MeshCache's vertex buffer
+// keep in sync with vertex.glsl
+enum class VertexFormat : std::uint32_t {
+    Full = 0, // CPUMesh::Vertex
+    Compact = 1, // CompactVertexHeader followed by graphics::CompactVertex
+};
+
+namespace graphics
+{
+// Dequantization parameters of compact positions:
+// position = positionMin + unorm16(position) * positionScale.
+// Stored right before the first compact vertex of a mesh.
+struct CompactVertexHeader {
+    glm::vec3 positionMin;
+    float padding0{0.f};
+    glm::vec3 positionScale;
+    float padding1{0.f};
+};
+
+// 16 bytes instead of 48 of CPUMesh::Vertex
+struct CompactVertex {
+    std::array<std::uint16_t, 3> position; // unorm16, relative to mesh AABB
+    std::uint16_t tangent; // see encodeTangent
+    std::array<std::int16_t, 2> normal; // octahedral, snorm16
+    std::array<std::uint16_t, 2> uv; // half floats
+};
+
+// 12 bytes instead of 32 of CPUMesh::SkinningData
+struct CompactSkinningData {
+    std::array<std::uint8_t, 4> jointIds;
+    std::array<std::uint16_t, 4> weights; // unorm16, sum up to exactly 65535
+};
+
+static_assert(sizeof(CompactVertexHeader) == 2 * sizeof(CompactVertex));
+static_assert(sizeof(CPUMesh::Vertex) == 3 * sizeof(CompactVertex));
+static_assert(sizeof(CompactSkinningData) == 12);
+
+// Maps a unit vector to the [-1, 1] square
+glm::vec2 encodeOctahedral(const glm::vec3& n);
+glm::vec3 decodeOctahedral(const glm::vec2& e);
+
+// Tangent is stored as its angle around the normal (15 bits) and the sign
+// of the bitangent (bit 15). Tangents are expected to be orthogonal to
+// normals (as glTF requires), otherwise they're projected onto the
+// normal's plane. The normal should be the decoded one, so that the
+// tangent basis is the same when decoding.
+std::uint16_t encodeTangent(const glm::vec3& normal, const glm::vec4& tangent);
+glm::vec4 decodeTangent(const glm::vec3& normal, std::uint16_t tangent);
+
+CompactVertexHeader makeCompactVertexHeader(std::span<const CPUMesh::Vertex> vertices);
+
+// Half float UVs have 11 bits of precision, so UVs far outside of [0, 1]
+// (e.g. heavily tiled ones) lose some of it
+CompactVertex encodeCompactVertex(
+    const CPUMesh::Vertex& vertex,
+    const CompactVertexHeader& header);
+CPUMesh::Vertex decodeCompactVertex(
+    const CompactVertex& vertex,
+    const CompactVertexHeader& header);
+
+// Returns false if some joint ids don't fit into 8 bits
+bool canUseCompactSkinningData(std::span<const CPUMesh::SkinningData> skinningData);
+CompactSkinningData encodeCompactSkinningData(const CPUMesh::SkinningData& skinningData);
+CPUMesh::SkinningData decodeCompactSkinningData(const CompactSkinningData& skinningData);
+
+// Data which MeshCache uploads for compact meshes
+struct CompactMeshData {
+    CompactVertexHeader header;
+    std::vector<CompactVertex> vertices;
+    std::vector<CompactSkinningData> skinningData;
+};
+
+CompactMeshData encodeCompactMesh(
+    std::span<const CPUMesh::Vertex> vertices,
+    std::span<const CPUMesh::SkinningData> skinningData);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Unlike VulkanImmediateExecutor, doesn't wait for the submitted commands.
+// Every submission signals the next value of a timeline semaphore, so that
+// the caller can poll or wait for the submissions it's interested in.
+class VulkanAsyncExecutor {
+public:
+    void init(VkDevice device, std::uint32_t queueFamily, VkQueue queue);
+    void cleanup(VkDevice device);
+
+    // Returns the value which the timeline semaphore will have when the commands complete
+    std::uint64_t submit(std::function<void(VkCommandBuffer cmd)>&& function);
+
+    std::uint64_t getCompletedValue() const;
+    void wait(std::uint64_t value) const;
+
+private:
+    VkCommandBuffer acquireCommandBuffer();
+
+    struct Submission {
+        VkCommandBuffer cmd;
+        std::uint64_t value;
+    };
+
+    bool initialized{false};
+
+    VkDevice device;
+    VkQueue queue;
+
+    VkCommandPool commandPool;
+    VkSemaphore timelineSemaphore;
+    std::uint64_t lastSubmittedValue{0};
+
+    std::vector<Submission> submissions; // possibly still executing
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+};
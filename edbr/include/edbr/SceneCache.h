@@ -4,12 +4,14 @@
 #include <string>
 #include <unordered_map>
 
+#include <edbr/AsyncSceneLoader.h>
 #include <edbr/Graphics/Scene.h>
 
 class SkeletalAnimationCache;
 class GfxDevice;
 class MeshCache;
 class MaterialCache;
+class TaskQueue;
 
 class SceneCache {
 public:
@@ -17,18 +19,31 @@ public:
         GfxDevice& gfxDevice,
         MeshCache& meshCache,
         MaterialCache& materialCache,
-        SkeletalAnimationCache& animationCache);
+        SkeletalAnimationCache& animationCache,
+        TaskQueue& taskQueue);
 
     const Scene& addScene(const std::string& scenePath, Scene scene);
     const Scene& getScene(const std::string& scenePath) const;
 
+    // If the scene is being loaded asynchronously, waits for it
     [[nodiscard]] const Scene& loadOrGetScene(const std::filesystem::path& path);
 
+    // Starts loading the scene in the background. When the returned handle
+    // becomes ready, getScene/loadOrGetScene can get the scene without waiting.
+    // update should be called every frame for async loading to progress.
+    SceneLoadHandle loadSceneAsync(const std::filesystem::path& path);
+    void update();
+
 private:
+    Scene uploadScene(const std::filesystem::path& path, DecodedScene decoded);
+    const Scene& addLoadedScene(const std::filesystem::path& path, Scene scene);
+
     std::unordered_map<std::string, Scene> sceneCache;
 
     GfxDevice& gfxDevice;
     MeshCache& meshCache;
     MaterialCache& materialCache;
     SkeletalAnimationCache& animationCache;
+
+    AsyncSceneLoader asyncLoader;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <edbr/Graphics/MeshCache.h>
+#include <edbr/Graphics/Scene.h>
+#include <edbr/Util/MappedFile.h>
+
+class GfxDevice;
+class MaterialCache;
+
+// Scene cooked from glTF into a binary file which is memory-mapped on load.
+// Vertex, index, skinning, LOD and meshlet data are stored exactly as MeshCache
+// uploads them, so meshes are uploaded straight from the mapped file.
+// Everything is stored in native byte order.
+struct CookedScene {
+    struct Primitive {
+        std::string name;
+        int materialIndex{-1}; // index in materials
+        MeshDataView mesh; // points into file
+    };
+
+    MappedFile file;
+    std::vector<SceneMaterial> materials;
+    std::vector<std::vector<Primitive>> meshes;
+    // skeletons, compressed animations, lights and nodes (meshes are not set)
+    Scene scene;
+};
+
+namespace util
+{
+// should be increased on every change of the format
+inline constexpr std::uint32_t COOKED_SCENE_VERSION = 5;
+
+// e.g. "models/cato.gltf" -> "models/cato.edbrscene"
+std::filesystem::path getCookedScenePath(const std::filesystem::path& gltfPath);
+
+// Returns true if the cooked scene exists, has the current version and is
+// newer than the glTF file
+bool isCookedSceneUpToDate(const std::filesystem::path& gltfPath);
+
+// Animations are compressed (see graphics::compressAnimation)
+void writeCookedScene(const std::filesystem::path& path, const SceneData& data);
+
+// Returns std::nullopt if the file doesn't exist, is corrupted or was
+// written by another version
+std::optional<CookedScene> readCookedScene(const std::filesystem::path& path);
+
+// Loads material textures and records mesh and texture uploads into
+// GfxDevice's upload queue (see GPUUploadQueue)
+Scene loadCookedScene(
+    GfxDevice& gfxDevice,
+    MeshCache& meshCache,
+    MaterialCache& materialCache,
+    CookedScene cookedScene);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include <vulkan/vulkan.h>
+
+#include <edbr/Util/Ktx2.h>
+#include <edbr/Util/MappedFile.h>
+#include <edbr/Util/TextureKind.h>
+
+// Texture cooked into a KTX2 file with block-compressed mips which is
+// memory-mapped on load. Mips are uploaded straight from the mapped file.
+struct CookedTexture {
+    MappedFile file;
+    Ktx2Texture texture; // mips point into file
+};
+
+namespace util
+{
+VkFormat getCookedTextureFormat(TextureKind kind);
+
+// Returns true if a cooked texture of this format can be loaded instead of an
+// image which is requested to be loaded with requestedFormat as a texture of
+// this kind. If kind is not set, SRGB requests are Color and UNORM requests
+// are Linear, so BC5 and BC4 are only used when they're asked for.
+bool isCookedTextureCompatible(
+    VkFormat cookedFormat,
+    VkFormat requestedFormat,
+    std::optional<TextureKind> kind);
+
+// e.g. "images/brick.png" -> "images/brick.ktx2"
+std::filesystem::path getCookedTexturePath(const std::filesystem::path& imagePath);
+
+// Returns true if the cooked texture exists, is a KTX2 file and is newer
+// than the image
+bool isCookedTextureUpToDate(const std::filesystem::path& imagePath);
+
+// Compresses all mips of RGBA8 image. Throws on failure.
+void writeCookedTexture(
+    const std::filesystem::path& path,
+    TextureKind kind,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> rgba);
+
+// Loads the image and writes it to getCookedTexturePath(imagePath)
+void cookTexture(const std::filesystem::path& imagePath, TextureKind kind);
+
+// Returns std::nullopt if the file doesn't exist or is corrupted
+std::optional<CookedTexture> readCookedTexture(const std::filesystem::path& path);
+}
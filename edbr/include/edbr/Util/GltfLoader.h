@@ -3,15 +3,33 @@
 #include <filesystem>
 
 struct Scene;
+struct SceneData;
 class MeshCache;
 class MaterialCache;
 class GfxDevice;
 
 namespace util
 {
+// Loads the scene on CPU only: doesn't create any GPU resources and doesn't
+// load textures (used for cooking scenes).
+// Meshes are optimized with graphics::optimizeMesh.
+SceneData loadGltfSceneData(const std::filesystem::path& path);
+
+// Creates materials and records mesh uploads into GfxDevice's upload queue
+// (see GPUUploadQueue)
+Scene uploadGltfSceneData(
+    GfxDevice& gfxDevice,
+    MeshCache& meshCache,
+    MaterialCache& materialCache,
+    SceneData data);
+
+// Loads the scene and waits until it's uploaded
 Scene loadGltfFile(
     GfxDevice& gfxDevice,
     MeshCache& meshCache,
     MaterialCache& materialCache,
     const std::filesystem::path& path);
+
+// Loads only skeletons and animations, doesn't create any GPU resources
+Scene loadGltfAnimations(const std::filesystem::path& path);
 }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Minimal KTX2 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html)
+// reader and writer: only 2D textures with one layer and one face and
+// without supercompression are supported.
+struct Ktx2Texture {
+    VkFormat format{VK_FORMAT_UNDEFINED};
+    std::uint32_t width{0};
+    std::uint32_t height{0};
+    std::vector<std::span<const std::byte>> mips; // mips[0] is the largest one
+};
+
+namespace util
+{
+// Supported formats: RGBA8 (UNORM and SRGB), BC4, BC5 and BC7
+void writeKtx2(
+    const std::filesystem::path& path,
+    VkFormat format,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::vector<std::uint8_t>> mips);
+
+// Mips point into data. Returns std::nullopt if the data isn't a valid KTX2
+// file or uses features which aren't supported.
+std::optional<Ktx2Texture> parseKtx2(std::span<const std::byte> data);
+}
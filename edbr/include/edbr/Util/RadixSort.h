@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace util
+{
+struct KeyIndex {
+    std::uint64_t key;
+    std::uint32_t index;
+};
+
+// Stable LSD radix sort by key, 8 bits per pass. Passes in which all keys have
+// the same byte are skipped, so keys which vary only in a few bytes sort faster.
+// scratch is a temporary buffer, pass the same one each time to reuse its memory.
+void radixSort(std::vector<KeyIndex>& items, std::vector<KeyIndex>& scratch);
+}
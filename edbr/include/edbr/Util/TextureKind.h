@@ -0,0 +1,12 @@
+#pragma once
+
+namespace util
+{
+// what the texture is used for (decides the compression and mip filter)
+enum class TextureKind {
+    Color, // BC7, sRGB
+    Linear, // BC7 (e.g. metallic/roughness)
+    NormalMap, // BC5, Z is reconstructed in shaders
+    SingleChannel, // BC4 (red channel only)
+};
+}
@@ -136,7 +136,7 @@ void Application::init(const Params& ps)
         std::exit(1);
     }
 
-    gfxDevice.init(window, params.appName.c_str(), params.version, vSync);
+    gfxDevice.init(window, params.appName.c_str(), params.version, vSync, taskQueue);
 
     if (!devDirPath.empty() && std::filesystem::exists(devDirPath)) {
         imguiIniPath = (devDirPath / "imgui.ini").string();
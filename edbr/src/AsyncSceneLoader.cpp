@@ -0,0 +1,173 @@
+#include <edbr/AsyncSceneLoader.h>
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
+#include <fmt/printf.h>
+
+#include <edbr/Core/TaskQueue.h>
+
+struct SceneLoadHandle::State {
+    enum class Stage {
+        Decoding,
+        Decoded,
+        Uploading,
+        Ready,
+        Failed,
+    };
+
+    std::filesystem::path path;
+    std::atomic<Stage> stage{Stage::Decoding};
+
+    // set by the decode task
+    std::mutex mutex;
+    std::condition_variable decodedCV;
+    std::optional<DecodedScene> decoded;
+    std::string error;
+
+    // set on the main thread
+    std::optional<Scene> scene;
+    std::uint64_t uploadValue{0};
+};
+
+SceneLoadHandle SceneLoadHandle::makeReady(const std::filesystem::path& path)
+{
+    SceneLoadHandle handle;
+    handle.state = std::make_shared<State>();
+    handle.state->path = path;
+    handle.state->stage = State::Stage::Ready;
+    return handle;
+}
+
+bool SceneLoadHandle::isReady() const
+{
+    return state && state->stage == State::Stage::Ready;
+}
+
+bool SceneLoadHandle::hasFailed() const
+{
+    return state && state->stage == State::Stage::Failed;
+}
+
+const std::filesystem::path& SceneLoadHandle::getPath() const
+{
+    assert(state);
+    return state->path;
+}
+
+AsyncSceneLoader::AsyncSceneLoader(TaskQueue& taskQueue, Stages stages) :
+    taskQueue(taskQueue), stages(std::move(stages))
+{}
+
+SceneLoadHandle AsyncSceneLoader::load(const std::filesystem::path& path)
+{
+    if (auto handle = findLoadingScene(path); handle.isValid()) {
+        return handle;
+    }
+
+    SceneLoadHandle handle;
+    handle.state = std::make_shared<SceneLoadHandle::State>();
+    handle.state->path = path;
+    loadingScenes.push_back(handle);
+
+    // the task doesn't reference the loader, so it can outlive it
+    taskQueue.push([state = handle.state, decode = stages.decode]() {
+        using Stage = SceneLoadHandle::State::Stage;
+        std::optional<DecodedScene> decoded;
+        std::string error;
+        try {
+            decoded = decode(state->path);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+
+        {
+            std::lock_guard lock{state->mutex};
+            state->decoded = std::move(decoded);
+            state->error = std::move(error);
+            state->stage = state->decoded ? Stage::Decoded : Stage::Failed;
+        }
+        state->decodedCV.notify_all();
+    });
+
+    return handle;
+}
+
+void AsyncSceneLoader::update()
+{
+    using Stage = SceneLoadHandle::State::Stage;
+
+    // upload everything which was decoded and submit it at once
+    std::vector<SceneLoadHandle::State*> uploadedScenes;
+    for (const auto& handle : loadingScenes) {
+        auto& state = *handle.state;
+        if (state.stage != Stage::Decoded) {
+            continue;
+        }
+
+        std::lock_guard lock{state.mutex};
+        try {
+            state.scene = stages.upload(state.path, std::move(*state.decoded));
+            state.stage = Stage::Uploading;
+            uploadedScenes.push_back(&state);
+        } catch (const std::exception& e) {
+            state.error = e.what();
+            state.stage = Stage::Failed;
+        }
+        state.decoded.reset();
+    }
+
+    if (!uploadedScenes.empty()) {
+        const auto uploadValue = stages.submit();
+        for (auto* state : uploadedScenes) {
+            state->uploadValue = uploadValue;
+        }
+    }
+
+    std::erase_if(loadingScenes, [this](const SceneLoadHandle& handle) {
+        auto& state = *handle.state;
+        if (state.stage == Stage::Uploading && stages.isUploadComplete(state.uploadValue)) {
+            stages.onLoaded(state.path, std::move(*state.scene));
+            state.scene.reset();
+            state.stage = Stage::Ready;
+            return true;
+        }
+        if (state.stage == Stage::Failed) {
+            fmt::println("Failed to load scene '{}': {}", state.path.string(), state.error);
+            return true;
+        }
+        return false;
+    });
+}
+
+void AsyncSceneLoader::wait(const SceneLoadHandle& handle)
+{
+    using Stage = SceneLoadHandle::State::Stage;
+    assert(handle.isValid());
+    auto& state = *handle.state;
+
+    {
+        std::unique_lock lock{state.mutex};
+        state.decodedCV.wait(lock, [&state]() { return state.stage != Stage::Decoding; });
+    }
+
+    update(); // uploads the scene if it was just decoded
+    if (state.stage == Stage::Uploading) {
+        stages.waitForUpload(state.uploadValue);
+        update();
+    }
+    assert(handle.isDone());
+}
+
+SceneLoadHandle AsyncSceneLoader::findLoadingScene(const std::filesystem::path& path) const
+{
+    for (const auto& handle : loadingScenes) {
+        if (handle.state->path == path) {
+            return handle;
+        }
+    }
+    return {};
+}
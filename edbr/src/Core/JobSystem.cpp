@@ -0,0 +1,125 @@
+#include <edbr/Core/JobSystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+#include <tracy/Tracy.hpp>
+
+struct JobSystem::Task {
+    const BatchFunc* func{nullptr};
+    std::size_t count{0};
+    std::size_t batchSize{0};
+    std::size_t numBatches{0};
+    std::atomic<std::size_t> nextBatch{0};
+    std::atomic<std::size_t> finishedBatches{0};
+};
+
+JobSystem::JobSystem(std::size_t numWorkers)
+{
+    workers.reserve(numWorkers);
+    for (std::size_t i = 0; i < numWorkers; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i + 1); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    wakeCV.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t JobSystem::getDefaultNumWorkers()
+{
+    const auto numCores = std::thread::hardware_concurrency();
+    // leave one core for the main thread
+    return numCores > 1 ? numCores - 1 : 0;
+}
+
+void JobSystem::parallelFor(std::size_t count, std::size_t batchSize, const BatchFunc& f)
+{
+    if (count == 0) {
+        return;
+    }
+    batchSize = std::max(batchSize, std::size_t{1});
+
+    const auto numBatches = (count + batchSize - 1) / batchSize;
+    if (workers.empty() || numBatches == 1) {
+        f(0, count, 0);
+        return;
+    }
+
+    ZoneScopedN("JobSystem::parallelFor");
+
+    std::lock_guard submitLock{submitMutex};
+
+    auto task = std::make_shared<Task>();
+    task->func = &f;
+    task->count = count;
+    task->batchSize = batchSize;
+    task->numBatches = numBatches;
+
+    {
+        std::lock_guard lock{mutex};
+        currentTask = task;
+        ++taskGeneration;
+    }
+    wakeCV.notify_all();
+
+    // the calling thread does work too
+    runBatches(*task, 0);
+
+    {
+        std::unique_lock lock{mutex};
+        doneCV.wait(lock, [&task]() { return task->finishedBatches == task->numBatches; });
+        currentTask.reset();
+    }
+}
+
+void JobSystem::workerLoop(std::size_t threadIndex)
+{
+    std::size_t lastGeneration = 0;
+    while (true) {
+        std::shared_ptr<Task> task;
+        {
+            std::unique_lock lock{mutex};
+            wakeCV.wait(lock, [this, lastGeneration]() {
+                return stopping || (currentTask && taskGeneration != lastGeneration);
+            });
+            if (stopping) {
+                return;
+            }
+            lastGeneration = taskGeneration;
+            task = currentTask;
+        }
+
+        runBatches(*task, threadIndex);
+    }
+}
+
+void JobSystem::runBatches(Task& task, std::size_t threadIndex)
+{
+    while (true) {
+        const auto batch = task.nextBatch.fetch_add(1);
+        if (batch >= task.numBatches) {
+            return;
+        }
+
+        const auto begin = batch * task.batchSize;
+        const auto end = std::min(begin + task.batchSize, task.count);
+        (*task.func)(begin, end, threadIndex);
+
+        if (task.finishedBatches.fetch_add(1) + 1 == task.numBatches) {
+            // can't call notify without locking: the waiting thread
+            // might miss the notification otherwise
+            std::lock_guard lock{mutex};
+            doneCV.notify_all();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include <edbr/Core/TaskQueue.h>
+
+#include <tracy/Tracy.hpp>
+
+TaskQueue::TaskQueue(std::size_t numThreads)
+{
+    threads.reserve(numThreads);
+    for (std::size_t i = 0; i < numThreads; ++i) {
+        threads.emplace_back([this]() { threadLoop(); });
+    }
+}
+
+TaskQueue::~TaskQueue()
+{
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    wakeCV.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void TaskQueue::push(TaskFunc task)
+{
+    if (threads.empty()) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        tasks.push_back(std::move(task));
+    }
+    wakeCV.notify_one();
+}
+
+void TaskQueue::waitIdle()
+{
+    std::unique_lock lock{mutex};
+    idleCV.wait(lock, [this]() { return tasks.empty() && numRunningTasks == 0; });
+}
+
+void TaskQueue::threadLoop()
+{
+    while (true) {
+        TaskFunc task;
+        {
+            std::unique_lock lock{mutex};
+            // tasks pushed before stopping are still finished
+            wakeCV.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++numRunningTasks;
+        }
+
+        {
+            ZoneScopedN("TaskQueue task");
+            task();
+        }
+
+        {
+            std::lock_guard lock{mutex};
+            --numRunningTasks;
+        }
+        idleCV.notify_all();
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <edbr/Graphics/ImageCache.h>
 #include <edbr/Graphics/MaterialCache.h>
+#include <edbr/Graphics/SkeletalAnimationCache.h>
 #include <edbr/Util/ImGuiUtil.h>
 
 #include <array>
@@ -25,7 +26,8 @@ void imagePreview(const GPUImage& image, const glm::vec2 maxSize = glm::vec2{512
 void ResourcesInspector::update(
     float dt,
     const ImageCache& imageCache,
-    const MaterialCache& materialCache)
+    const MaterialCache& materialCache,
+    const SkeletalAnimationCache& animationCache)
 {
     ImGui::Begin("Resources");
 
@@ -37,6 +39,9 @@ void ResourcesInspector::update(
     static bool showFormatColumn = false;
     static bool showUsageColumn = false;
     if (ImGui::TreeNode("Images")) {
+        ImGui::Text(
+            "Loaded from files: %.1f MB",
+            imageCache.getLoadedImagesMemory() / (1024.f * 1024.f));
         ImGui::Checkbox("Format", &showFormatColumn);
         ImGui::SameLine();
         ImGui::Checkbox("Usage", &showUsageColumn);
@@ -192,8 +197,21 @@ void ResourcesInspector::update(
         ImGui::TextUnformatted("TODO");
         ImGui::TreePop();
     }
+
+    if (ImGui::TreeNode("Animations")) {
+        ImGui::Text(
+            "%d animations, %.1f KB compressed, %.1f KB decompressed",
+            (int)animationCache.getNumAnimations(),
+            animationCache.getCompressedDataSize() / 1024.f,
+            animationCache.getDecompressedDataSize() / 1024.f);
+        ImGui::TreePop();
+    }
     ImGui::End();
 
+    if (selectedImageId != NULL_IMAGE_ID &&
+        !imageCache.getImage(selectedImageId).isInitialized()) {
+        selectedImageId = NULL_IMAGE_ID; // was destroyed
+    }
     if (selectedImageId != NULL_IMAGE_ID && showPreviewWindow) {
         auto& image = imageCache.getImage(selectedImageId);
         if (ImGui::Begin("Image preview", &showPreviewWindow, ImGuiWindowFlags_NoResize)) {
@@ -0,0 +1,394 @@
+#include <edbr/Graphics/AnimationCompression.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <edbr/Graphics/SkeletalAnimation.h>
+
+namespace
+{
+using TrackType = CompressedAnimation::TrackType;
+
+constexpr float MAX_U16 = 65535.f;
+constexpr float MAX_U15 = 32767.f;
+constexpr float SQRT_2 = 1.41421356f;
+const glm::quat IDENTITY_QUAT{1.f, 0.f, 0.f, 0.f};
+
+float distance(const glm::vec3& a, const glm::vec3& b)
+{
+    return glm::length(a - b);
+}
+
+// angle between rotations
+// (acos of the dot product is too imprecise for small angles)
+float distance(const glm::quat& a, glm::quat b)
+{
+    if (glm::dot(a, b) < 0.f) {
+        b = -b;
+    }
+    const auto d = glm::length(glm::vec4{a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w});
+    return 4.f * std::asin(std::min(d * 0.5f, 1.f));
+}
+
+glm::vec3 interpolate(const glm::vec3& a, const glm::vec3& b, float t)
+{
+    return a + (b - a) * t;
+}
+
+// nlerp, same as in sampleJointMatrices
+glm::quat interpolate(const glm::quat& a, glm::quat b, float t)
+{
+    if (glm::dot(a, b) < 0.f) {
+        b = -b;
+    }
+    return glm::normalize(glm::quat{
+        a.w + (b.w - a.w) * t,
+        a.x + (b.x - a.x) * t,
+        a.y + (b.y - a.y) * t,
+        a.z + (b.z - a.z) * t,
+    });
+}
+
+template<typename T>
+T getKey(const std::vector<T>& keys, std::size_t frame, const T& defaultValue)
+{
+    if (keys.empty()) {
+        return defaultValue;
+    }
+    return keys[std::min(frame, keys.size() - 1)];
+}
+
+// Returns frames of the keys which need to be kept so that the rest of the
+// keys can be restored by interpolation with an error <= tolerance
+template<typename T>
+std::vector<std::uint16_t> reduceKeys(const std::vector<T>& keys, float tolerance)
+{
+    assert(keys.size() < std::numeric_limits<std::uint16_t>::max());
+
+    const auto isConstant = std::all_of(keys.begin(), keys.end(), [&](const T& key) {
+        return distance(key, keys[0]) <= tolerance;
+    });
+    if (isConstant) {
+        return {0};
+    }
+
+    const auto canSkipKeysBetween = [&](std::size_t from, std::size_t to) {
+        for (auto i = from + 1; i < to; ++i) {
+            const auto t = (float)(i - from) / (float)(to - from);
+            if (distance(interpolate(keys[from], keys[to], t), keys[i]) > tolerance) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // greedily extend each segment as far as possible
+    std::vector<std::uint16_t> frames{0};
+    std::size_t from = 0;
+    while (from < keys.size() - 1) {
+        auto to = from + 1;
+        while (to + 1 < keys.size() && canSkipKeysBetween(from, to + 1)) {
+            ++to;
+        }
+        frames.push_back((std::uint16_t)to);
+        from = to;
+    }
+    return frames;
+}
+
+// "smallest three": the largest component is dropped (and restored from
+// the unit length), the other three are in [-1/sqrt(2), 1/sqrt(2)].
+// 2 bits for the index of the dropped component + 3 x 15 bits
+std::array<std::uint16_t, 3> packQuat(const glm::quat& q)
+{
+    auto c = std::array{q.x, q.y, q.z, q.w};
+    std::size_t largest = 0;
+    for (std::size_t i = 1; i < 4; ++i) {
+        if (std::abs(c[i]) > std::abs(c[largest])) {
+            largest = i;
+        }
+    }
+    if (c[largest] < 0.f) { // q and -q are the same rotation
+        for (auto& v : c) {
+            v = -v;
+        }
+    }
+
+    std::uint64_t bits = largest;
+    for (std::size_t i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        const auto v = std::clamp((c[i] * SQRT_2 + 1.f) * 0.5f, 0.f, 1.f);
+        bits = (bits << 15) | (std::uint64_t)std::round(v * MAX_U15);
+    }
+    return {(std::uint16_t)bits, (std::uint16_t)(bits >> 16), (std::uint16_t)(bits >> 32)};
+}
+
+glm::quat unpackQuat(const std::uint16_t* values)
+{
+    auto bits = (std::uint64_t)values[0] | ((std::uint64_t)values[1] << 16) |
+                ((std::uint64_t)values[2] << 32);
+    const auto largest = (std::size_t)(bits >> 45);
+
+    std::array<float, 4> c{};
+    float sumSq = 0.f;
+    for (int i = 3; i >= 0; --i) {
+        if ((std::size_t)i == largest) {
+            continue;
+        }
+        const auto v = (float)(bits & 0x7FFF) / MAX_U15;
+        c[i] = (v * 2.f - 1.f) / SQRT_2;
+        sumSq += c[i] * c[i];
+        bits >>= 15;
+    }
+    c[largest] = std::sqrt(std::max(1.f - sumSq, 0.f));
+    return glm::normalize(glm::quat{c[3], c[0], c[1], c[2]});
+}
+
+class Compressor {
+public:
+    explicit Compressor(CompressedAnimation& animation) : animation(animation) {}
+
+    void addTrack(const std::vector<glm::vec3>& keys, float tolerance, const glm::vec3& identity)
+    {
+        auto& track = animation.tracks.emplace_back();
+        if (keys.empty()) {
+            return;
+        }
+
+        const auto frames = reduceKeys(keys, tolerance);
+        if (frames.size() == 1 && distance(keys[0], identity) <= tolerance) {
+            return; // missing track == identity
+        }
+
+        glm::vec3 minValue{std::numeric_limits<float>::max()};
+        glm::vec3 maxValue{std::numeric_limits<float>::lowest()};
+        for (const auto frame : frames) {
+            minValue = glm::min(minValue, keys[frame]);
+            maxValue = glm::max(maxValue, keys[frame]);
+        }
+        // constant tracks get extent == 0, so their value is restored exactly
+        const auto range = CompressedAnimation::Range{
+            .min = minValue,
+            .extent = maxValue - minValue,
+        };
+
+        assert(animation.ranges.size() < std::numeric_limits<std::uint16_t>::max());
+        track.rangeIndex = (std::uint16_t)animation.ranges.size();
+        animation.ranges.push_back(range);
+
+        addKeys(track, frames, [&](std::size_t frame) {
+            std::array<std::uint16_t, 3> values{};
+            for (int c = 0; c < 3; ++c) {
+                const auto extent = range.extent[c];
+                const auto v = extent > 0.f ? (keys[frame][c] - range.min[c]) / extent : 0.f;
+                values[c] = (std::uint16_t)std::round(std::clamp(v, 0.f, 1.f) * MAX_U16);
+            }
+            return values;
+        });
+    }
+
+    void addTrack(const std::vector<glm::quat>& keys, float tolerance)
+    {
+        auto& track = animation.tracks.emplace_back();
+        if (keys.empty()) {
+            return;
+        }
+
+        // neighbouring keys should be in the same hemisphere for interpolation
+        auto aligned = keys;
+        for (std::size_t i = 1; i < aligned.size(); ++i) {
+            if (glm::dot(aligned[i - 1], aligned[i]) < 0.f) {
+                aligned[i] = -aligned[i];
+            }
+        }
+
+        const auto frames = reduceKeys(aligned, tolerance);
+        if (frames.size() == 1 && distance(aligned[0], IDENTITY_QUAT) <= tolerance) {
+            return;
+        }
+
+        addKeys(track, frames, [&aligned](std::size_t frame) {
+            return packQuat(glm::normalize(aligned[frame]));
+        });
+    }
+
+private:
+    template<typename PackFunc>
+    void addKeys(
+        CompressedAnimation::Track& track,
+        const std::vector<std::uint16_t>& frames,
+        PackFunc pack)
+    {
+        track.firstKey = (std::uint32_t)(animation.keyValues.size() / 3);
+        track.firstFrame = (std::uint32_t)animation.keyFrames.size();
+        track.numKeys = (std::uint16_t)frames.size();
+        if (frames.size() > 1) { // constant tracks don't need frames
+            animation.keyFrames.insert(animation.keyFrames.end(), frames.begin(), frames.end());
+        }
+        for (const auto frame : frames) {
+            const auto values = pack(frame);
+            animation.keyValues.insert(animation.keyValues.end(), values.begin(), values.end());
+        }
+    }
+
+    CompressedAnimation& animation;
+};
+
+template<typename T, typename UnpackFunc>
+std::vector<T> decompressTrack(
+    const CompressedAnimation& animation,
+    const CompressedAnimation::Track& track,
+    UnpackFunc unpack)
+{
+    const auto numKeys = track.numKeys;
+    if (numKeys <= 1) { // identity or constant
+        return numKeys == 0 ? std::vector<T>{} : std::vector<T>{unpack(track.firstKey)};
+    }
+
+    const auto* frames = &animation.keyFrames[track.firstFrame];
+    std::vector<T> values(frames[numKeys - 1] + 1);
+    auto prev = unpack(track.firstKey);
+    for (std::size_t k = 1; k < numKeys; ++k) {
+        const auto next = unpack(track.firstKey + k);
+        const auto from = frames[k - 1];
+        const auto to = frames[k];
+        for (auto frame = from; frame <= to; ++frame) {
+            const auto t = (float)(frame - from) / (float)(to - from);
+            values[frame] = interpolate(prev, next, t);
+        }
+        prev = next;
+    }
+    return values;
+}
+
+std::vector<glm::vec3> decompressVec3Track(
+    const CompressedAnimation& animation,
+    const CompressedAnimation::Track& track)
+{
+    return decompressTrack<glm::vec3>(animation, track, [&](std::size_t key) {
+        const auto& range = animation.ranges[track.rangeIndex];
+        const auto* v = &animation.keyValues[key * 3];
+        const auto q = glm::vec3{(float)v[0], (float)v[1], (float)v[2]};
+        return range.min + q / MAX_U16 * range.extent;
+    });
+}
+
+template<typename T>
+float calculateError(
+    const std::vector<T>& original,
+    const std::vector<T>& decompressed,
+    const T& identity)
+{
+    float error = 0.f;
+    const auto numFrames = std::max(original.size(), decompressed.size());
+    for (std::size_t frame = 0; frame < numFrames; ++frame) {
+        const auto d = distance(
+            getKey(original, frame, identity), getKey(decompressed, frame, identity));
+        error = std::max(error, d);
+    }
+    return error;
+}
+} // end of anonymous namespace
+
+namespace graphics
+{
+CompressedAnimation compressAnimation(
+    const SkeletalAnimation& animation,
+    const AnimationCompressionSettings& settings)
+{
+    CompressedAnimation compressed{
+        .name = animation.name,
+        .duration = animation.duration,
+        .looped = animation.looped,
+        .startFrame = animation.startFrame,
+        .events = animation.events,
+    };
+
+    // order of tracks is the same as in TrackType
+    compressed.tracks.reserve(animation.tracks.size() * CompressedAnimation::NUM_TRACK_TYPES);
+    Compressor compressor(compressed);
+    for (const auto& tracks : animation.tracks) {
+        compressor.addTrack(tracks.translations, settings.translationTolerance, glm::vec3{0.f});
+        compressor.addTrack(tracks.rotations, settings.rotationTolerance);
+        compressor.addTrack(tracks.scales, settings.scaleTolerance, glm::vec3{1.f});
+    }
+
+    // measure what was actually lost (key reduction + quantization)
+    const auto decompressed = decompressAnimation(compressed);
+    auto& error = compressed.error;
+    for (std::size_t i = 0; i < animation.tracks.size(); ++i) {
+        const auto& orig = animation.tracks[i];
+        const auto& dec = decompressed.tracks[i];
+        error.translation = std::max(
+            error.translation, calculateError(orig.translations, dec.translations, glm::vec3{0.f}));
+        error.rotation = std::max(
+            error.rotation, calculateError(orig.rotations, dec.rotations, IDENTITY_QUAT));
+        error.scale =
+            std::max(error.scale, calculateError(orig.scales, dec.scales, glm::vec3{1.f}));
+    }
+
+    return compressed;
+}
+
+SkeletalAnimation decompressAnimation(const CompressedAnimation& animation)
+{
+    SkeletalAnimation decompressed{
+        .duration = animation.duration,
+        .looped = animation.looped,
+        .name = animation.name,
+        .startFrame = animation.startFrame,
+        .events = animation.events,
+    };
+
+    const auto unpackRotation = [&animation](std::size_t key) {
+        return unpackQuat(&animation.keyValues[key * 3]);
+    };
+
+    decompressed.tracks.resize(animation.getNumJoints());
+    for (std::size_t i = 0; i < decompressed.tracks.size(); ++i) {
+        auto& tracks = decompressed.tracks[i];
+        tracks.translations =
+            decompressVec3Track(animation, animation.getTrack(i, TrackType::Translation));
+        tracks.rotations = decompressTrack<glm::quat>(
+            animation, animation.getTrack(i, TrackType::Rotation), unpackRotation);
+        tracks.scales = decompressVec3Track(animation, animation.getTrack(i, TrackType::Scale));
+    }
+    decompressed.soaTracks = makeSoAAnimation(decompressed);
+
+    return decompressed;
+}
+
+std::size_t getTrackDataSize(const SkeletalAnimation& animation)
+{
+    std::size_t size = 0;
+    for (const auto& tracks : animation.tracks) {
+        size += tracks.translations.size() * sizeof(glm::vec3);
+        size += tracks.rotations.size() * sizeof(glm::quat);
+        size += tracks.scales.size() * sizeof(glm::vec3);
+    }
+    return size;
+}
+
+std::size_t getTrackDataSize(const CompressedAnimation& animation)
+{
+    return animation.tracks.size() * sizeof(CompressedAnimation::Track) +
+           animation.keyFrames.size() * sizeof(std::uint16_t) +
+           animation.keyValues.size() * sizeof(std::uint16_t) +
+           animation.ranges.size() * sizeof(CompressedAnimation::Range);
+}
+
+std::size_t getTrackDataSize(const SoAAnimation& animation)
+{
+    return (animation.translations.size() + animation.rotations.size() +
+            animation.scales.size()) *
+           sizeof(float);
+}
+}
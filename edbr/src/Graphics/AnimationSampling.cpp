@@ -0,0 +1,590 @@
+#include <edbr/Graphics/AnimationSampling.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <edbr/Graphics/SkeletalAnimation.h>
+#include <edbr/Graphics/Skeleton.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EDBR_ANIMATION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+template<typename T>
+T getKey(const std::vector<T>& track, std::size_t key, const T& defaultValue)
+{
+    if (track.empty()) {
+        return defaultValue;
+    }
+    return track[std::min(key, track.size() - 1)];
+}
+
+#ifdef EDBR_ANIMATION_SSE
+using Float4 = __m128;
+
+Float4 load4(const float* p)
+{
+    return _mm_loadu_ps(p);
+}
+
+void store4(float* p, Float4 v)
+{
+    _mm_storeu_ps(p, v);
+}
+
+Float4 set4(float v)
+{
+    return _mm_set1_ps(v);
+}
+
+Float4 add4(Float4 a, Float4 b)
+{
+    return _mm_add_ps(a, b);
+}
+
+Float4 sub4(Float4 a, Float4 b)
+{
+    return _mm_sub_ps(a, b);
+}
+
+Float4 mul4(Float4 a, Float4 b)
+{
+    return _mm_mul_ps(a, b);
+}
+
+Float4 rsqrt4(Float4 a)
+{
+    return _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(a));
+}
+
+// 1 or -1 depending on the sign of a
+Float4 sign4(Float4 a)
+{
+    return _mm_or_ps(_mm_and_ps(a, _mm_set1_ps(-0.f)), _mm_set1_ps(1.f));
+}
+
+// writes column of 4 matrices: x, y, z and w contain the values for all 4 matrices
+void storeColumn(glm::mat4* out, int column, Float4 x, Float4 y, Float4 z, Float4 w)
+{
+    // SoA -> AoS: after the transpose, each register holds a column of one matrix
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(&out[0][column][0], x);
+    _mm_storeu_ps(&out[1][column][0], y);
+    _mm_storeu_ps(&out[2][column][0], z);
+    _mm_storeu_ps(&out[3][column][0], w);
+}
+
+// out = a * b, out can be the same matrix as a or b
+void mulMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+    const auto a0 = _mm_loadu_ps(&a[0][0]);
+    const auto a1 = _mm_loadu_ps(&a[1][0]);
+    const auto a2 = _mm_loadu_ps(&a[2][0]);
+    const auto a3 = _mm_loadu_ps(&a[3][0]);
+
+    __m128 res[4];
+    for (int i = 0; i < 4; ++i) {
+        auto c = _mm_mul_ps(a0, _mm_set1_ps(b[i][0]));
+        c = _mm_add_ps(c, _mm_mul_ps(a1, _mm_set1_ps(b[i][1])));
+        c = _mm_add_ps(c, _mm_mul_ps(a2, _mm_set1_ps(b[i][2])));
+        c = _mm_add_ps(c, _mm_mul_ps(a3, _mm_set1_ps(b[i][3])));
+        res[i] = c;
+    }
+    for (int i = 0; i < 4; ++i) {
+        _mm_storeu_ps(&out[i][0], res[i]);
+    }
+}
+#else
+struct Float4 {
+    float v[4];
+};
+
+template<typename F>
+Float4 apply4(Float4 a, Float4 b, F f)
+{
+    return {f(a.v[0], b.v[0]), f(a.v[1], b.v[1]), f(a.v[2], b.v[2]), f(a.v[3], b.v[3])};
+}
+
+Float4 load4(const float* p)
+{
+    return {p[0], p[1], p[2], p[3]};
+}
+
+void store4(float* p, Float4 v)
+{
+    std::copy(v.v, v.v + 4, p);
+}
+
+Float4 set4(float v)
+{
+    return {v, v, v, v};
+}
+
+Float4 add4(Float4 a, Float4 b)
+{
+    return apply4(a, b, [](float x, float y) { return x + y; });
+}
+
+Float4 sub4(Float4 a, Float4 b)
+{
+    return apply4(a, b, [](float x, float y) { return x - y; });
+}
+
+Float4 mul4(Float4 a, Float4 b)
+{
+    return apply4(a, b, [](float x, float y) { return x * y; });
+}
+
+Float4 rsqrt4(Float4 a)
+{
+    return apply4(a, a, [](float x, float) { return 1.f / std::sqrt(x); });
+}
+
+Float4 sign4(Float4 a)
+{
+    return apply4(a, a, [](float x, float) { return std::copysign(1.f, x); });
+}
+
+void storeColumn(glm::mat4* out, int column, Float4 x, Float4 y, Float4 z, Float4 w)
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i][column] = glm::vec4{x.v[i], y.v[i], z.v[i], w.v[i]};
+    }
+}
+
+void mulMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+    out = a * b;
+}
+#endif
+
+// Transforms of ANIMATION_SIMD_WIDTH joints
+struct JointTransforms {
+    Float4 translation[3];
+    Float4 rotation[4]; // x, y, z, w
+    Float4 scale[3];
+};
+
+// Pointers to the values of one key of SoAAnimation or of a LocalPose
+struct PoseValues {
+    const float* translations;
+    const float* rotations;
+    const float* scales;
+    std::size_t numLanes;
+};
+
+PoseValues getKeyValues(const SoAAnimation& animation, std::size_t key)
+{
+    const auto n = animation.numLanes;
+    return {
+        .translations = &animation.translations[key * 3 * n],
+        .rotations = &animation.rotations[key * 4 * n],
+        .scales = &animation.scales[key * 3 * n],
+        .numLanes = n,
+    };
+}
+
+PoseValues getPoseValues(const LocalPose& pose)
+{
+    return {
+        .translations = pose.translations.data(),
+        .rotations = pose.rotations.data(),
+        .scales = pose.scales.data(),
+        .numLanes = pose.numLanes,
+    };
+}
+
+JointTransforms loadTransforms(const PoseValues& pose, std::size_t firstLane)
+{
+    const auto n = pose.numLanes;
+    JointTransforms tr;
+    for (std::size_t c = 0; c < 3; ++c) {
+        tr.translation[c] = load4(&pose.translations[c * n + firstLane]);
+        tr.scale[c] = load4(&pose.scales[c * n + firstLane]);
+    }
+    for (std::size_t c = 0; c < 4; ++c) {
+        tr.rotation[c] = load4(&pose.rotations[c * n + firstLane]);
+    }
+    return tr;
+}
+
+void storeTransforms(const JointTransforms& tr, LocalPose& pose, std::size_t firstLane)
+{
+    const auto n = pose.numLanes;
+    for (std::size_t c = 0; c < 3; ++c) {
+        store4(&pose.translations[c * n + firstLane], tr.translation[c]);
+        store4(&pose.scales[c * n + firstLane], tr.scale[c]);
+    }
+    for (std::size_t c = 0; c < 4; ++c) {
+        store4(&pose.rotations[c * n + firstLane], tr.rotation[c]);
+    }
+}
+
+void normalizeQuats(Float4* q)
+{
+    auto len = mul4(q[0], q[0]);
+    len = add4(len, mul4(q[1], q[1]));
+    len = add4(len, mul4(q[2], q[2]));
+    len = add4(len, mul4(q[3], q[3]));
+    const auto invLen = rsqrt4(len);
+    for (int c = 0; c < 4; ++c) {
+        q[c] = mul4(q[c], invLen);
+    }
+}
+
+// out = a * b
+void mulQuats(const Float4* a, const Float4* b, Float4* out)
+{
+    const auto ax = a[0], ay = a[1], az = a[2], aw = a[3];
+    const auto bx = b[0], by = b[1], bz = b[2], bw = b[3];
+    const auto x = add4(sub4(add4(mul4(aw, bx), mul4(ax, bw)), mul4(az, by)), mul4(ay, bz));
+    const auto y = add4(sub4(add4(mul4(aw, by), mul4(ay, bw)), mul4(ax, bz)), mul4(az, bx));
+    const auto z = add4(sub4(add4(mul4(aw, bz), mul4(az, bw)), mul4(ay, bx)), mul4(ax, by));
+    const auto w = sub4(sub4(sub4(mul4(aw, bw), mul4(ax, bx)), mul4(ay, by)), mul4(az, bz));
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+    out[3] = w;
+}
+
+// Translations and scales are lerped, rotations are nlerped.
+// If shortestPath is false, rotations are expected to be in the same hemisphere
+// (true for neighbouring keys, see makeSoAAnimation)
+JointTransforms interpolate(
+    const JointTransforms& a,
+    const JointTransforms& b,
+    float t,
+    bool shortestPath)
+{
+    const auto tv = set4(t);
+    const auto lerp = [tv](Float4 p, Float4 q) { return add4(p, mul4(sub4(q, p), tv)); };
+
+    JointTransforms res;
+    for (int c = 0; c < 3; ++c) {
+        res.translation[c] = lerp(a.translation[c], b.translation[c]);
+        res.scale[c] = lerp(a.scale[c], b.scale[c]);
+    }
+
+    auto sign = set4(1.f);
+    if (shortestPath) {
+        auto dot = mul4(a.rotation[0], b.rotation[0]);
+        for (int c = 1; c < 4; ++c) {
+            dot = add4(dot, mul4(a.rotation[c], b.rotation[c]));
+        }
+        sign = sign4(dot);
+    }
+    for (int c = 0; c < 4; ++c) {
+        res.rotation[c] = lerp(a.rotation[c], mul4(b.rotation[c], sign));
+    }
+    normalizeQuats(res.rotation);
+
+    return res;
+}
+
+// Calculates local transforms (T * R * S) of ANIMATION_SIMD_WIDTH joints
+void storeMatrices(const JointTransforms& tr, glm::mat4* out)
+{
+    // same as glm::mat3_cast
+    const auto& [qx, qy, qz, qw] = tr.rotation;
+    const auto one = set4(1.f);
+    const auto two = set4(2.f);
+    const auto xx = mul4(qx, qx);
+    const auto yy = mul4(qy, qy);
+    const auto zz = mul4(qz, qz);
+    const auto xy = mul4(qx, qy);
+    const auto xz = mul4(qx, qz);
+    const auto yz = mul4(qy, qz);
+    const auto wx = mul4(qw, qx);
+    const auto wy = mul4(qw, qy);
+    const auto wz = mul4(qw, qz);
+
+    // column i is scaled by scale[i]
+    const auto& [sx, sy, sz] = tr.scale;
+    const auto m00 = mul4(sub4(one, mul4(two, add4(yy, zz))), sx);
+    const auto m01 = mul4(mul4(two, add4(xy, wz)), sx);
+    const auto m02 = mul4(mul4(two, sub4(xz, wy)), sx);
+    const auto m10 = mul4(mul4(two, sub4(xy, wz)), sy);
+    const auto m11 = mul4(sub4(one, mul4(two, add4(xx, zz))), sy);
+    const auto m12 = mul4(mul4(two, add4(yz, wx)), sy);
+    const auto m20 = mul4(mul4(two, add4(xz, wy)), sz);
+    const auto m21 = mul4(mul4(two, sub4(yz, wx)), sz);
+    const auto m22 = mul4(sub4(one, mul4(two, add4(xx, yy))), sz);
+
+    const auto zero = set4(0.f);
+    storeColumn(out, 0, m00, m01, m02, zero);
+    storeColumn(out, 1, m10, m11, m12, zero);
+    storeColumn(out, 2, m20, m21, m22, zero);
+    storeColumn(out, 3, tr.translation[0], tr.translation[1], tr.translation[2], one);
+}
+
+struct KeyPair {
+    std::size_t prevKey;
+    std::size_t nextKey;
+    float t;
+};
+
+KeyPair findKeys(const SoAAnimation& animation, float time)
+{
+    // keys are sampled by ANIMATION_FPS, so finding prev/next key is easy
+    const auto keyTime = std::max(time, 0.f) * graphics::ANIMATION_FPS;
+    const auto prevKey = std::min((std::size_t)std::floor(keyTime), animation.numKeys - 1);
+    const auto nextKey = std::min(prevKey + 1, animation.numKeys - 1);
+    const auto t = (prevKey != nextKey) ? keyTime - (float)prevKey : 0.f;
+    return {prevKey, nextKey, t};
+}
+
+void resizePose(LocalPose& pose, std::size_t numLanes)
+{
+    pose.numLanes = numLanes;
+    pose.translations.resize(numLanes * 3);
+    pose.rotations.resize(numLanes * 4);
+    pose.scales.resize(numLanes * 3);
+}
+
+// local -> model, parents always go before children
+void calculateModelTransforms(
+    const FlatSkeleton& skeleton,
+    std::span<glm::mat4> jointMatrices,
+    std::vector<glm::mat4>& transforms)
+{
+    for (std::size_t i = 0; i < skeleton.getNumJoints(); ++i) {
+        const auto jointId = skeleton.jointIds[i];
+        assert(jointId < transforms.size() && jointId < jointMatrices.size());
+        const auto parent = skeleton.parents[i];
+        if (parent != FlatSkeleton::NO_PARENT) {
+            mulMat4(transforms[parent], transforms[jointId], transforms[jointId]);
+        }
+        mulMat4(transforms[jointId], skeleton.inverseBindMatrices[i], jointMatrices[jointId]);
+    }
+}
+} // end of anonymous namespace
+
+namespace graphics
+{
+FlatSkeleton makeFlatSkeleton(const Skeleton& skeleton)
+{
+    FlatSkeleton flat;
+    if (skeleton.joints.empty()) {
+        return flat;
+    }
+
+    // depth-first, so that subtrees are next to each other in memory
+    struct StackEntry {
+        JointId jointId;
+        JointId parent;
+    };
+    std::vector<StackEntry> stack{{ROOT_JOINT_ID, FlatSkeleton::NO_PARENT}};
+    while (!stack.empty()) {
+        const auto [jointId, parent] = stack.back();
+        stack.pop_back();
+
+        flat.jointIds.push_back(jointId);
+        flat.parents.push_back(parent);
+        flat.inverseBindMatrices.push_back(skeleton.inverseBindMatrices[jointId]);
+
+        const auto& children = skeleton.hierarchy[jointId].children;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            stack.push_back({*it, jointId});
+        }
+    }
+    return flat;
+}
+
+SoAAnimation makeSoAAnimation(const SkeletalAnimation& animation)
+{
+    const auto w = ANIMATION_SIMD_WIDTH;
+    SoAAnimation soa{
+        .numKeys = 1,
+        .numLanes = (animation.tracks.size() + w - 1) / w * w,
+    };
+    for (const auto& track : animation.tracks) {
+        soa.numKeys = std::max(
+            {soa.numKeys, track.translations.size(), track.rotations.size(), track.scales.size()});
+    }
+
+    const auto n = soa.numLanes;
+    soa.translations.resize(soa.numKeys * 3 * n, 0.f);
+    soa.rotations.resize(soa.numKeys * 4 * n, 0.f);
+    soa.scales.resize(soa.numKeys * 3 * n, 1.f);
+
+    static const SkeletalAnimation::Tracks emptyTracks{};
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& tracks = i < animation.tracks.size() ? animation.tracks[i] : emptyTracks;
+
+        glm::quat prevRotation{1.f, 0.f, 0.f, 0.f};
+        for (std::size_t key = 0; key < soa.numKeys; ++key) {
+            const auto pos = getKey(tracks.translations, key, glm::vec3{0.f});
+            const auto scale = getKey(tracks.scales, key, glm::vec3{1.f});
+            auto rot = getKey(tracks.rotations, key, glm::quat{1.f, 0.f, 0.f, 0.f});
+            // keep neighbouring keys in the same hemisphere so that nlerp
+            // doesn't need to check for the shortest path
+            if (key > 0 && glm::dot(prevRotation, rot) < 0.f) {
+                rot = -rot;
+            }
+            prevRotation = rot;
+
+            for (int c = 0; c < 3; ++c) {
+                soa.translations[(key * 3 + c) * n + i] = pos[c];
+                soa.scales[(key * 3 + c) * n + i] = scale[c];
+            }
+            soa.rotations[(key * 4 + 0) * n + i] = rot.x;
+            soa.rotations[(key * 4 + 1) * n + i] = rot.y;
+            soa.rotations[(key * 4 + 2) * n + i] = rot.z;
+            soa.rotations[(key * 4 + 3) * n + i] = rot.w;
+        }
+    }
+
+    return soa;
+}
+
+SoAAnimation makeAdditiveAnimation(const SoAAnimation& animation)
+{
+    SoAAnimation additive = animation;
+    const auto n = animation.numLanes;
+    for (std::size_t key = 0; key < animation.numKeys; ++key) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto get = [n, i](const std::vector<float>& values, std::size_t k, int c) {
+                return values[(k * 3 + c) * n + i];
+            };
+            for (int c = 0; c < 3; ++c) {
+                additive.translations[(key * 3 + c) * n + i] =
+                    get(animation.translations, key, c) - get(animation.translations, 0, c);
+                const auto refScale = get(animation.scales, 0, c);
+                additive.scales[(key * 3 + c) * n + i] =
+                    refScale != 0.f ? get(animation.scales, key, c) / refScale : 1.f;
+            }
+
+            const auto getRotation = [&animation, n, i](std::size_t k) {
+                const auto& r = animation.rotations;
+                return glm::quat{
+                    r[(k * 4 + 3) * n + i],
+                    r[(k * 4 + 0) * n + i],
+                    r[(k * 4 + 1) * n + i],
+                    r[(k * 4 + 2) * n + i],
+                };
+            };
+            // reference * delta = key (deltas of neighbouring keys stay in the
+            // same hemisphere, because the keys are)
+            const auto delta = glm::inverse(getRotation(0)) * getRotation(key);
+            additive.rotations[(key * 4 + 0) * n + i] = delta.x;
+            additive.rotations[(key * 4 + 1) * n + i] = delta.y;
+            additive.rotations[(key * 4 + 2) * n + i] = delta.z;
+            additive.rotations[(key * 4 + 3) * n + i] = delta.w;
+        }
+    }
+    return additive;
+}
+
+void sampleJointMatrices(
+    const FlatSkeleton& skeleton,
+    const SoAAnimation& animation,
+    float time,
+    std::span<glm::mat4> jointMatrices,
+    std::vector<glm::mat4>& transforms)
+{
+    if (animation.numKeys == 0) {
+        return;
+    }
+
+    const auto [prevKey, nextKey, t] = findKeys(animation, time);
+    const auto prev = getKeyValues(animation, prevKey);
+    const auto next = getKeyValues(animation, nextKey);
+
+    transforms.resize(animation.numLanes);
+    for (std::size_t lane = 0; lane < animation.numLanes; lane += ANIMATION_SIMD_WIDTH) {
+        const auto a = loadTransforms(prev, lane);
+        const auto b = loadTransforms(next, lane);
+        storeMatrices(interpolate(a, b, t, false), &transforms[lane]);
+    }
+
+    calculateModelTransforms(skeleton, jointMatrices, transforms);
+}
+
+void sampleLocalPose(const SoAAnimation& animation, float time, LocalPose& pose)
+{
+    resizePose(pose, animation.numLanes);
+    if (animation.numKeys == 0) {
+        return;
+    }
+
+    const auto [prevKey, nextKey, t] = findKeys(animation, time);
+    const auto prev = getKeyValues(animation, prevKey);
+    const auto next = getKeyValues(animation, nextKey);
+    for (std::size_t lane = 0; lane < animation.numLanes; lane += ANIMATION_SIMD_WIDTH) {
+        const auto a = loadTransforms(prev, lane);
+        const auto b = loadTransforms(next, lane);
+        storeTransforms(interpolate(a, b, t, false), pose, lane);
+    }
+}
+
+void blendLocalPoses(const LocalPose& a, const LocalPose& b, float weight, LocalPose& out)
+{
+    assert(a.numLanes == b.numLanes);
+    const auto pa = getPoseValues(a);
+    const auto pb = getPoseValues(b);
+    resizePose(out, a.numLanes);
+    for (std::size_t lane = 0; lane < a.numLanes; lane += ANIMATION_SIMD_WIDTH) {
+        // poses come from different animations - rotations can be in different hemispheres
+        const auto ta = loadTransforms(pa, lane);
+        const auto tb = loadTransforms(pb, lane);
+        storeTransforms(interpolate(ta, tb, weight, true), out, lane);
+    }
+}
+
+void addLocalPose(LocalPose& pose, const LocalPose& additive, float weight)
+{
+    assert(pose.numLanes == additive.numLanes);
+    const auto pa = getPoseValues(pose);
+    const auto pd = getPoseValues(additive);
+    const auto w = set4(weight);
+    const auto one = set4(1.f);
+    for (std::size_t lane = 0; lane < pose.numLanes; lane += ANIMATION_SIMD_WIDTH) {
+        auto tr = loadTransforms(pa, lane);
+        auto delta = loadTransforms(pd, lane);
+        for (int c = 0; c < 3; ++c) {
+            tr.translation[c] = add4(tr.translation[c], mul4(delta.translation[c], w));
+            // scale *= lerp(1, deltaScale, weight)
+            const auto scale = add4(one, mul4(sub4(delta.scale[c], one), w));
+            tr.scale[c] = mul4(tr.scale[c], scale);
+        }
+        // rotation *= nlerp(identity, deltaRotation, weight), by the shortest path
+        const auto sign = mul4(sign4(delta.rotation[3]), w);
+        for (int c = 0; c < 4; ++c) {
+            delta.rotation[c] = mul4(delta.rotation[c], sign);
+        }
+        delta.rotation[3] = add4(delta.rotation[3], set4(1.f - weight));
+        normalizeQuats(delta.rotation);
+        mulQuats(tr.rotation, delta.rotation, tr.rotation);
+        storeTransforms(tr, pose, lane);
+    }
+}
+
+void calculateJointMatrices(
+    const FlatSkeleton& skeleton,
+    const LocalPose& pose,
+    std::span<glm::mat4> jointMatrices,
+    std::vector<glm::mat4>& transforms)
+{
+    const auto values = getPoseValues(pose);
+    transforms.resize(pose.numLanes);
+    for (std::size_t lane = 0; lane < pose.numLanes; lane += ANIMATION_SIMD_WIDTH) {
+        storeMatrices(loadTransforms(values, lane), &transforms[lane]);
+    }
+
+    calculateModelTransforms(skeleton, jointMatrices, transforms);
+}
+}
+
+LocalPose& LocalPosePool::acquire()
+{
+    if (numUsed == poses.size()) {
+        poses.emplace_back();
+    }
+    return poses[numUsed++];
+}
@@ -0,0 +1,83 @@
+#include <edbr/Graphics/BufferSubAllocator.h>
+
+#include <cassert>
+#include <iterator>
+
+BufferSubAllocator::BufferSubAllocator(std::size_t capacity)
+{
+    grow(capacity);
+}
+
+std::optional<std::size_t> BufferSubAllocator::allocate(std::size_t size)
+{
+    if (size == 0) {
+        return std::nullopt;
+    }
+
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        const auto [offset, rangeSize] = *it;
+        if (rangeSize < size) {
+            continue;
+        }
+
+        freeRanges.erase(it);
+        if (rangeSize > size) {
+            freeRanges.emplace(offset + size, rangeSize - size);
+        }
+        usedSize += size;
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void BufferSubAllocator::free(std::size_t offset, std::size_t size)
+{
+    assert(size != 0);
+    assert(offset + size <= capacity);
+    assert(usedSize >= size);
+    usedSize -= size;
+
+    auto [it, inserted] = freeRanges.emplace(offset, size);
+    assert(inserted && "double free");
+
+    // merge with the next range
+    if (auto next = std::next(it); next != freeRanges.end()) {
+        assert(offset + size <= next->first && "freed range overlaps a free range");
+        if (offset + size == next->first) {
+            it->second += next->second;
+            freeRanges.erase(next);
+        }
+    }
+
+    // merge with the previous range
+    if (it != freeRanges.begin()) {
+        auto prev = std::prev(it);
+        assert(prev->first + prev->second <= offset && "freed range overlaps a free range");
+        if (prev->first + prev->second == offset) {
+            prev->second += it->second;
+            freeRanges.erase(it);
+        }
+    }
+}
+
+void BufferSubAllocator::grow(std::size_t newCapacity)
+{
+    assert(newCapacity >= capacity);
+    if (newCapacity == capacity) {
+        return;
+    }
+
+    const auto oldCapacity = capacity;
+    capacity = newCapacity;
+
+    // extend the last free range if it ends at the old capacity
+    if (!freeRanges.empty()) {
+        auto& [offset, size] = *freeRanges.rbegin();
+        if (offset + size == oldCapacity) {
+            size += newCapacity - oldCapacity;
+            return;
+        }
+    }
+    freeRanges.emplace(oldCapacity, newCapacity - oldCapacity);
+}
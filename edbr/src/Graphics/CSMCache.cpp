@@ -0,0 +1,164 @@
+#include <edbr/Graphics/CSMCache.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/ShadowMapping.h>
+#include <edbr/Math/GlobalAxes.h>
+
+namespace
+{
+// see createCSMCamera
+constexpr float CSM_CAMERA_DEPTH_SCALE = 1.5f;
+
+// splitmix64 finalizer
+std::uint64_t mix(std::uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+std::uint64_t hashCombine(std::uint64_t seed, std::uint64_t v)
+{
+    return mix(seed ^ (v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+}
+
+void CSMCache::init(std::size_t numCascades, const Params& params)
+{
+    cascades.clear();
+    cascades.resize(numCascades);
+    setParams(params);
+    frameIndex = 0;
+}
+
+void CSMCache::setParams(const Params& params)
+{
+    assert(params.moveThresholdTexels >= 1.f && "texel snapping needs at least one texel");
+    assert(params.moveThresholdTexels * 2.f < params.shadowMapSize);
+    if (params.shadowMapSize != this->params.shadowMapSize ||
+        params.moveThresholdTexels != this->params.moveThresholdTexels) {
+        invalidate();
+    }
+    this->params = params;
+}
+
+void CSMCache::invalidate()
+{
+    for (auto& cascade : cascades) {
+        cascade.valid = false;
+    }
+}
+
+void CSMCache::update(
+    std::span<const math::Sphere> cascadeBounds,
+    const glm::vec3& lightDir,
+    std::uint64_t staticCastersHash)
+{
+    assert(cascadeBounds.size() == cascades.size());
+
+    if (glm::dot(lightDir, this->lightDir) < 0.99999f ||
+        staticCastersHash != this->staticCastersHash) {
+        invalidate();
+    }
+    this->lightDir = lightDir;
+    this->staticCastersHash = staticCastersHash;
+
+    for (std::size_t i = 0; i < cascades.size(); ++i) {
+        auto& cascade = cascades[i];
+        if (!cascade.valid || !canKeepCamera(i, cascadeBounds[i], lightDir)) {
+            fitCamera(i, cascadeBounds[i], lightDir);
+            cascade.updateType = UpdateType::Full;
+            continue;
+        }
+
+        const auto skipFrame = params.updateFarCascadesEveryOtherFrame &&
+                               i >= params.firstFarCascade && frameIndex % 2 == 1;
+        cascade.updateType = skipFrame ? UpdateType::None : UpdateType::Dynamic;
+    }
+
+    ++frameIndex;
+}
+
+bool CSMCache::canKeepCamera(
+    std::size_t cascadeIndex,
+    const math::Sphere& bounds,
+    const glm::vec3& lightDir) const
+{
+    const auto& cascade = cascades[cascadeIndex];
+    if (bounds.radius < cascade.radius * params.minRadiusRatio) {
+        return false;
+    }
+
+    // offset of the sphere from the camera's center in light space
+    const auto view = glm::lookAt({}, lightDir, math::GlobalUpAxis);
+    const auto d = glm::vec3{view * glm::vec4{bounds.center - cascade.center, 0.f}};
+    return std::max(std::abs(d.x), std::abs(d.y)) + bounds.radius <= cascade.radius &&
+           std::abs(d.z) + bounds.radius <= cascade.radius * CSM_CAMERA_DEPTH_SCALE;
+}
+
+void CSMCache::fitCamera(
+    std::size_t cascadeIndex,
+    const math::Sphere& bounds,
+    const glm::vec3& lightDir)
+{
+    auto& cascade = cascades[cascadeIndex];
+
+    // make the camera moveThresholdTexels bigger on each side
+    const auto size = params.shadowMapSize;
+    cascade.radius = bounds.radius * size / (size - 2.f * params.moveThresholdTexels);
+    cascade.center = snapToShadowMapTexels(bounds.center, lightDir, cascade.radius, size);
+    cascade.camera = createCSMCamera(cascade.center, cascade.radius, lightDir);
+    cascade.valid = true;
+}
+
+CSMCache::UpdateType CSMCache::getUpdateType(std::size_t cascadeIndex) const
+{
+    return cascades[cascadeIndex].updateType;
+}
+
+const Camera& CSMCache::getCamera(std::size_t cascadeIndex) const
+{
+    return cascades[cascadeIndex].camera;
+}
+
+float CSMCache::getRadius(std::size_t cascadeIndex) const
+{
+    return cascades[cascadeIndex].radius;
+}
+
+namespace graphics
+{
+std::uint64_t hashShadowCaster(const MeshDrawCommand& dc)
+{
+    auto h = hashCombine(dc.meshId, dc.materialId);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            h = hashCombine(h, std::bit_cast<std::uint32_t>(dc.transformMatrix[i][j]));
+        }
+    }
+    return h;
+}
+
+std::uint64_t hashStaticShadowCasters(std::span<const MeshDrawCommand> drawCommands)
+{
+    std::uint64_t hash = 0;
+    for (const auto& dc : drawCommands) {
+        if (!dc.isStatic || !dc.castShadow) {
+            continue;
+        }
+        // sum doesn't depend on the order of draw commands
+        hash += hashShadowCaster(dc);
+    }
+    return hash;
+}
+}
@@ -1,5 +1,8 @@
 #include <edbr/Graphics/Cubemap.h>
 
+#include <cstring>
+#include <vector>
+
 #include <edbr/Graphics/GfxDevice.h>
 #include <edbr/Graphics/Vulkan/Util.h>
 
@@ -20,7 +23,10 @@ GPUImage loadCubemap(GfxDevice& gfxDevice, const std::filesystem::path& imagesDi
     static const auto paths =
         std::array{"right.jpg", "left.jpg", "top.jpg", "bottom.jpg", "front.jpg", "back.jpg"};
 
-    std::uint32_t face = 0;
+    // faces are uploaded together (see GPUUploadQueue::uploadImage)
+    std::vector<unsigned char> pixels;
+    std::size_t faceSize = 0;
+    std::size_t face = 0;
     bool imageCreated = false;
 
     for (auto& p : paths) {
@@ -43,6 +49,8 @@ GPUImage loadCubemap(GfxDevice& gfxDevice, const std::filesystem::path& imagesDi
                 .isCubemap = true,
             });
             imageCreated = true;
+            faceSize = (std::size_t)data.width * data.height * 4;
+            pixels.resize(faceSize * paths.size());
         } else {
             assert(
                 img.extent.width == (std::uint32_t)data.width &&
@@ -50,9 +58,10 @@ GPUImage loadCubemap(GfxDevice& gfxDevice, const std::filesystem::path& imagesDi
                 "All images for cubemap must have the same size");
         }
 
-        gfxDevice.uploadImageData(img, data.pixels, face);
+        std::memcpy(&pixels[face * faceSize], data.pixels, faceSize);
         ++face;
     }
+    gfxDevice.uploadImageData(img, pixels.data());
 
     const auto cubemapLabel = "cubemap, dir=" + imagesDir.string();
     img.debugName = cubemapLabel;
@@ -0,0 +1,214 @@
+#include <edbr/Graphics/CullingStage.h>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EDBR_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+#include <tracy/Tracy.hpp>
+
+namespace
+{
+constexpr float NEG_INF = -std::numeric_limits<float>::infinity();
+
+std::size_t roundUpTo4(std::size_t n)
+{
+    return (n + 3) & ~std::size_t{3};
+}
+}
+
+void CullingStage::clear()
+{
+    views.clear();
+    numDrawCommands = 0;
+    xs.clear();
+    ys.clear();
+    zs.clear();
+    radii.clear();
+    shadowRadii.clear();
+    drawCommandIndices.clear();
+}
+
+void CullingStage::setDrawCommands(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const std::size_t> order)
+{
+    assert(order.size() == drawCommands.size());
+    numDrawCommands = drawCommands.size();
+
+    // padding lanes have -inf radius so that they're never visible
+    const auto paddedSize = roundUpTo4(numDrawCommands);
+    xs.assign(paddedSize, 0.f);
+    ys.assign(paddedSize, 0.f);
+    zs.assign(paddedSize, 0.f);
+    radii.assign(paddedSize, NEG_INF);
+    shadowRadii.assign(paddedSize, NEG_INF);
+    drawCommandIndices.assign(paddedSize, 0);
+
+    for (std::size_t i = 0; i < numDrawCommands; ++i) {
+        const auto dcIdx = order[i];
+        const auto& dc = drawCommands[dcIdx];
+        const auto& sphere = dc.worldBoundingSphere;
+        xs[i] = sphere.center.x;
+        ys[i] = sphere.center.y;
+        zs[i] = sphere.center.z;
+        radii[i] = sphere.radius;
+        shadowRadii[i] = dc.castShadow ? sphere.radius : NEG_INF;
+        drawCommandIndices[i] = (std::uint32_t)dcIdx;
+    }
+}
+
+std::size_t CullingStage::addView(const View& view)
+{
+    views.push_back(ViewData{.view = view});
+    return views.size() - 1;
+}
+
+void CullingStage::cull(JobSystem* jobSystem)
+{
+    ZoneScopedN("Culling");
+
+    const auto paddedSize = xs.size();
+    const auto numChunks = (paddedSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    for (auto& vd : views) {
+        vd.visible.resize(paddedSize);
+        vd.chunkCounts.assign(numChunks, 0);
+        vd.numVisible = 0;
+    }
+
+    if (paddedSize == 0 || views.empty()) {
+        return;
+    }
+
+    if (jobSystem) {
+        jobSystem->parallelFor(
+            paddedSize, CHUNK_SIZE, [this](std::size_t begin, std::size_t end, std::size_t) {
+                cullRange(begin, end);
+            });
+    } else {
+        for (std::size_t begin = 0; begin < paddedSize; begin += CHUNK_SIZE) {
+            cullRange(begin, std::min(begin + CHUNK_SIZE, paddedSize));
+        }
+    }
+
+    // each chunk has written its visible indices at the chunk's offset - compact them
+    for (auto& vd : views) {
+        std::size_t numVisible = 0;
+        for (std::size_t c = 0; c < numChunks; ++c) {
+            const auto count = vd.chunkCounts[c];
+            const auto chunkBegin = c * CHUNK_SIZE;
+            if (numVisible != chunkBegin && count != 0) {
+                std::memmove(
+                    &vd.visible[numVisible],
+                    &vd.visible[chunkBegin],
+                    count * sizeof(std::uint32_t));
+            }
+            numVisible += count;
+        }
+        vd.numVisible = numVisible;
+    }
+}
+
+void CullingStage::cullRange(std::size_t begin, std::size_t end)
+{
+    assert(begin % CHUNK_SIZE == 0);
+    assert(end % 4 == 0);
+    const auto chunkIndex = begin / CHUNK_SIZE;
+
+    for (auto& vd : views) {
+        const auto& view = vd.view;
+        const auto* rs = view.shadowCastersOnly ? shadowRadii.data() : radii.data();
+        auto* out = &vd.visible[begin];
+        std::uint32_t count = 0;
+
+#ifdef EDBR_CULLING_SSE
+        const auto& volume = view.volume;
+        const auto numPlanes = volume.numPlanes;
+        constexpr auto maxPlanes = CullingVolume::MAX_PLANES;
+        __m128 nx[maxPlanes], ny[maxPlanes], nz[maxPlanes], d[maxPlanes];
+        for (std::size_t p = 0; p < numPlanes; ++p) {
+            const auto& plane = volume.planes[p];
+            nx[p] = _mm_set1_ps(plane.normal.x);
+            ny[p] = _mm_set1_ps(plane.normal.y);
+            nz[p] = _mm_set1_ps(plane.normal.z);
+            d[p] = _mm_set1_ps(plane.distance);
+        }
+        const auto hasSphere = volume.sphere.has_value();
+        const auto sphere = volume.sphere.value_or(math::Sphere{});
+        const auto sx = _mm_set1_ps(sphere.center.x);
+        const auto sy = _mm_set1_ps(sphere.center.y);
+        const auto sz = _mm_set1_ps(sphere.center.z);
+        const auto sr = _mm_set1_ps(sphere.radius);
+        const auto zero = _mm_setzero_ps();
+        const auto negInf = _mm_set1_ps(NEG_INF);
+
+        for (std::size_t i = begin; i < end; i += 4) {
+            const auto x = _mm_loadu_ps(&xs[i]);
+            const auto y = _mm_loadu_ps(&ys[i]);
+            const auto z = _mm_loadu_ps(&zs[i]);
+            const auto r = _mm_loadu_ps(&rs[i]);
+            const auto negR = _mm_sub_ps(zero, r);
+
+            // padding and filtered out spheres have -inf radius
+            auto mask = _mm_cmpgt_ps(r, negInf);
+            // sphere is visible if signed distance to each plane is > -radius
+            for (std::size_t p = 0; p < numPlanes; ++p) {
+                auto dist = _mm_mul_ps(nx[p], x);
+                dist = _mm_add_ps(dist, _mm_mul_ps(ny[p], y));
+                dist = _mm_add_ps(dist, _mm_mul_ps(nz[p], z));
+                dist = _mm_sub_ps(dist, d[p]);
+                mask = _mm_and_ps(mask, _mm_cmpgt_ps(dist, negR));
+            }
+            // ... and if it intersects the volume's sphere
+            if (hasSphere) {
+                const auto dx = _mm_sub_ps(x, sx);
+                const auto dy = _mm_sub_ps(y, sy);
+                const auto dz = _mm_sub_ps(z, sz);
+                auto dist2 = _mm_mul_ps(dx, dx);
+                dist2 = _mm_add_ps(dist2, _mm_mul_ps(dy, dy));
+                dist2 = _mm_add_ps(dist2, _mm_mul_ps(dz, dz));
+                const auto rSum = _mm_add_ps(r, sr);
+                mask = _mm_and_ps(mask, _mm_cmpgt_ps(rSum, zero));
+                mask = _mm_and_ps(mask, _mm_cmplt_ps(dist2, _mm_mul_ps(rSum, rSum)));
+            }
+
+            auto bits = (unsigned)_mm_movemask_ps(mask);
+            while (bits != 0) {
+                const auto lane = std::countr_zero(bits);
+                out[count++] = drawCommandIndices[i + lane];
+                bits &= bits - 1;
+            }
+        }
+#else
+        for (std::size_t i = begin; i < end; ++i) {
+            if (rs[i] == NEG_INF) { // padding or filtered out
+                continue;
+            }
+            const auto sphere = math::Sphere{
+                .center = {xs[i], ys[i], zs[i]},
+                .radius = rs[i],
+            };
+            if (edge::isInVolume(view.volume, sphere)) {
+                out[count++] = drawCommandIndices[i];
+            }
+        }
+#endif
+        vd.chunkCounts[chunkIndex] = count;
+    }
+}
+
+std::span<const std::uint32_t> CullingStage::getVisibleDrawCommands(std::size_t viewIndex) const
+{
+    const auto& vd = views.at(viewIndex);
+    return {vd.visible.data(), vd.numVisible};
+}
@@ -0,0 +1,53 @@
+#include <edbr/Graphics/DrawSortKey.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+constexpr std::uint64_t PASS_BITS = 2;
+constexpr std::uint64_t SKINNED_BITS = 1;
+constexpr std::uint64_t MATERIAL_BITS = 20;
+constexpr std::uint64_t MESH_BITS = 25;
+constexpr std::uint64_t LOD_BITS = 3; // GPUMesh::MAX_LODS
+constexpr std::uint64_t DEPTH_BITS = 13;
+static_assert(
+    PASS_BITS + SKINNED_BITS + MATERIAL_BITS + MESH_BITS + LOD_BITS + DEPTH_BITS == 64);
+
+std::uint64_t quantizeDepth(float normalizedDepth)
+{
+    static const auto maxValue = (float)((1 << DEPTH_BITS) - 1);
+    return (std::uint64_t)(std::clamp(normalizedDepth, 0.f, 1.f) * maxValue);
+}
+}
+
+namespace graphics
+{
+std::uint64_t makeDrawSortKey(
+    DrawSortPass pass,
+    bool skinned,
+    MaterialId materialId,
+    MeshId meshId,
+    std::uint32_t lod,
+    float normalizedDepth)
+{
+    assert((std::uint64_t)pass < (1ull << PASS_BITS));
+    assert(materialId < (1ull << MATERIAL_BITS));
+    assert(meshId < (1ull << MESH_BITS));
+    assert(lod < (1ull << LOD_BITS));
+
+    // skinned, material, mesh and LOD together
+    const auto state = ((std::uint64_t)skinned << (MATERIAL_BITS + MESH_BITS + LOD_BITS)) |
+                       ((std::uint64_t)materialId << (MESH_BITS + LOD_BITS)) |
+                       ((std::uint64_t)meshId << LOD_BITS) | (std::uint64_t)lod;
+    static const auto STATE_BITS = SKINNED_BITS + MATERIAL_BITS + MESH_BITS + LOD_BITS;
+
+    const auto depth = quantizeDepth(normalizedDepth);
+    const auto passBits = (std::uint64_t)pass << (64 - PASS_BITS);
+    if (pass == DrawSortPass::Transparent) {
+        const auto invDepth = ((1ull << DEPTH_BITS) - 1) - depth;
+        return passBits | (invDepth << STATE_BITS) | state;
+    }
+    return passBits | (state << DEPTH_BITS) | depth;
+}
+}
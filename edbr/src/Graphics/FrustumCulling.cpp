@@ -135,6 +135,22 @@ bool isInFrustum(const Frustum& frustum, const math::Sphere& s)
         isOnOrForwardPlane(frustum.topFace, s) && isOnOrForwardPlane(frustum.bottomFace, s));
 }
 
+bool isInVolume(const CullingVolume& volume, const math::Sphere& s)
+{
+    for (std::size_t i = 0; i < volume.numPlanes; ++i) {
+        if (!isOnOrForwardPlane(volume.planes[i], s)) {
+            return false;
+        }
+    }
+    if (volume.sphere) {
+        // written the same way as in CullingStage so that the results match exactly
+        const auto d = s.center - volume.sphere->center;
+        const auto r = s.radius + volume.sphere->radius;
+        return r > 0.f && d.x * d.x + d.y * d.y + d.z * d.z < r * r;
+    }
+    return true;
+}
+
 bool isInFrustum(const Frustum& frustum, const math::AABB& aabb)
 {
     glm::vec3 vmin, vmax;
@@ -0,0 +1,237 @@
+#include <edbr/Graphics/GPUUploadQueue.h>
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include <edbr/Graphics/GfxDevice.h>
+#include <edbr/Graphics/MipMapGeneration.h>
+#include <edbr/Graphics/Vulkan/GPUImage.h>
+#include <edbr/Graphics/Vulkan/Util.h>
+
+#include <tracy/Tracy.hpp>
+
+GPUUploadQueue::GPUUploadQueue(GfxDevice& gfxDevice) : gfxDevice(gfxDevice)
+{}
+
+void GPUUploadQueue::init(std::size_t ringBufferSize)
+{
+    ringBuffer = gfxDevice.createBuffer(ringBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    vkutil::addDebugLabel(gfxDevice.getDevice(), ringBuffer.buffer, "upload ring buffer");
+    ringAllocator = UploadRingAllocator(ringBufferSize);
+}
+
+void GPUUploadQueue::cleanup()
+{
+    gfxDevice.waitForAsyncSubmit(lastSubmitValue);
+
+    for (const auto& buffer : pendingDedicatedBuffers) {
+        gfxDevice.destroyBuffer(buffer);
+    }
+    pendingDedicatedBuffers.clear();
+    for (const auto& inFlight : inFlightDedicatedBuffers) {
+        gfxDevice.destroyBuffer(inFlight.buffer);
+    }
+    inFlightDedicatedBuffers.clear();
+
+    bufferUploads.clear();
+    dedicatedBufferUploads.clear();
+    imageUploads.clear();
+
+    gfxDevice.destroyBuffer(ringBuffer);
+}
+
+void GPUUploadQueue::uploadBuffer(
+    VkBuffer dstBuffer,
+    std::size_t dstOffset,
+    std::span<const std::byte> data)
+{
+    if (data.empty()) {
+        return;
+    }
+
+    const auto staging = allocateStaging(data.size());
+    std::memcpy(staging.mappedData, data.data(), data.size());
+
+    const auto upload = graphics::BufferUploadRegion{
+        .dstBuffer = dstBuffer,
+        .region =
+            {
+                .srcOffset = staging.offset,
+                .dstOffset = dstOffset,
+                .size = data.size(),
+            },
+    };
+    if (staging.buffer == ringBuffer.buffer) {
+        bufferUploads.push_back(upload);
+    } else {
+        dedicatedBufferUploads.push_back({.srcBuffer = staging.buffer, .upload = upload});
+    }
+}
+
+void GPUUploadQueue::uploadImage(
+    const GPUImage& image,
+    std::span<const graphics::ImageSubresourceUpload> subresources)
+{
+    assert(
+        (image.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0 &&
+        "Image needs to have VK_IMAGE_USAGE_TRANSFER_DST_BIT to upload data to it");
+    if (subresources.empty()) {
+        return;
+    }
+
+    auto upload = graphics::makeImageUploadRegions(image.extent, subresources, STAGING_ALIGNMENT);
+    const auto staging = allocateStaging(upload.stagingSize);
+    bool generateMips = image.mipLevels > 1;
+    for (std::size_t i = 0; i < subresources.size(); ++i) {
+        const auto& sub = subresources[i];
+        assert(sub.mipLevel < image.mipLevels && sub.layer < image.numLayers);
+        auto& region = upload.regions[i];
+        std::memcpy(
+            (std::byte*)staging.mappedData + region.bufferOffset, sub.data.data(), sub.data.size());
+        region.bufferOffset += staging.offset;
+        if (sub.mipLevel != 0) {
+            generateMips = false;
+        }
+    }
+
+    imageUploads.push_back(ImageUpload{
+        .image = image.image,
+        .extent = image.extent,
+        .usage = image.usage,
+        .mipLevels = image.mipLevels,
+        .generateMips = generateMips,
+        .srcBuffer = staging.buffer,
+        .regions = std::move(upload.regions),
+    });
+}
+
+bool GPUUploadQueue::hasPendingUploads() const
+{
+    return !bufferUploads.empty() || !dedicatedBufferUploads.empty() || !imageUploads.empty();
+}
+
+std::uint64_t GPUUploadQueue::flush()
+{
+    releaseCompleted();
+    if (!hasPendingUploads()) {
+        return lastSubmitValue;
+    }
+
+    ZoneScopedN("Flush uploads");
+
+    const auto batches = graphics::coalesceBufferUploads(bufferUploads);
+    lastSubmitValue = gfxDevice.submitAsync([&](VkCommandBuffer cmd) {
+        for (const auto& batch : batches) {
+            vkCmdCopyBuffer(
+                cmd,
+                ringBuffer.buffer,
+                batch.dstBuffer,
+                (std::uint32_t)batch.regions.size(),
+                batch.regions.data());
+        }
+        for (const auto& u : dedicatedBufferUploads) {
+            vkCmdCopyBuffer(cmd, u.srcBuffer, u.upload.dstBuffer, 1, &u.upload.region);
+        }
+
+        for (const auto& u : imageUploads) {
+            vkutil::transitionImage(
+                cmd, u.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkCmdCopyBufferToImage(
+                cmd,
+                u.srcBuffer,
+                u.image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                (std::uint32_t)u.regions.size(),
+                u.regions.data());
+            if (u.generateMips) {
+                assert(
+                    (u.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0 &&
+                    "Image needs to have VK_IMAGE_USAGE_TRANSFER_{DST,SRC}_BIT to generate mip "
+                    "maps");
+                graphics::generateMipmaps(
+                    cmd, u.image, VkExtent2D{u.extent.width, u.extent.height}, u.mipLevels);
+            } else {
+                vkutil::transitionImage(
+                    cmd,
+                    u.image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        }
+
+        // make uploaded data visible to everything submitted after this
+        const auto barrier = VkMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+        };
+        const auto dependencyInfo = VkDependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers = &barrier,
+        };
+        vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+    });
+
+    ringAllocator.endBatch(lastSubmitValue);
+    for (const auto& buffer : pendingDedicatedBuffers) {
+        inFlightDedicatedBuffers.push_back({.buffer = buffer, .submitValue = lastSubmitValue});
+    }
+    pendingDedicatedBuffers.clear();
+    bufferUploads.clear();
+    dedicatedBufferUploads.clear();
+    imageUploads.clear();
+
+    return lastSubmitValue;
+}
+
+GPUUploadQueue::StagingAllocation GPUUploadQueue::allocateStaging(std::size_t size)
+{
+    if (size > ringAllocator.getCapacity()) {
+        const auto buffer = gfxDevice.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+        pendingDedicatedBuffers.push_back(buffer);
+        return {
+            .buffer = buffer.buffer,
+            .offset = 0,
+            .mappedData = buffer.info.pMappedData,
+        };
+    }
+
+    releaseCompleted();
+    while (true) {
+        if (const auto offset = ringAllocator.allocate(size, STAGING_ALIGNMENT); offset) {
+            return {
+                .buffer = ringBuffer.buffer,
+                .offset = *offset,
+                .mappedData = (std::byte*)ringBuffer.info.pMappedData + *offset,
+            };
+        }
+
+        // the ring buffer is full: submit what's recorded and wait for
+        // the oldest submission to free some space
+        ZoneScopedN("Wait for upload ring buffer");
+        if (hasPendingUploads()) {
+            flush();
+        }
+        assert(ringAllocator.hasBatchesInFlight());
+        gfxDevice.waitForAsyncSubmit(ringAllocator.getOldestBatchValue());
+        releaseCompleted();
+    }
+}
+
+void GPUUploadQueue::releaseCompleted()
+{
+    if (ringAllocator.hasBatchesInFlight()) {
+        ringAllocator.release(gfxDevice.getCompletedAsyncSubmitValue());
+    }
+    std::erase_if(inFlightDedicatedBuffers, [this](const InFlightBuffer& inFlight) {
+        if (gfxDevice.isAsyncSubmitComplete(inFlight.submitValue)) {
+            gfxDevice.destroyBuffer(inFlight.buffer);
+            return true;
+        }
+        return false;
+    });
+}
@@ -1,23 +1,27 @@
 #include <edbr/Graphics/GameRenderer.h>
 
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Graphics/DrawSortKey.h>
 #include <edbr/Graphics/Font.h>
 #include <edbr/Graphics/FrustumCulling.h>
 #include <edbr/Graphics/GfxDevice.h>
 #include <edbr/Graphics/MaterialCache.h>
 #include <edbr/Graphics/MeshCache.h>
 #include <edbr/Graphics/Scene.h>
+#include <edbr/Graphics/ShadowCasterCulling.h>
 #include <edbr/Graphics/Vulkan/Init.h>
 #include <edbr/Graphics/Vulkan/Pipelines.h>
 #include <edbr/Graphics/Vulkan/Util.h>
 
 #include <imgui.h>
 
-#include <numeric> // iota
-
 #include <tracy/Tracy.hpp>
 
-GameRenderer::GameRenderer(MeshCache& meshCache, MaterialCache& materialCache) :
-    meshCache(meshCache), materialCache(materialCache)
+GameRenderer::GameRenderer(
+    MeshCache& meshCache,
+    MaterialCache& materialCache,
+    JobSystem& jobSystem) :
+    meshCache(meshCache), materialCache(materialCache), jobSystem(jobSystem)
 {}
 
 void GameRenderer::init(GfxDevice& gfxDevice, const glm::ivec2& drawImageSize)
@@ -34,7 +38,10 @@ void GameRenderer::init(GfxDevice& gfxDevice, const glm::ivec2& drawImageSize)
     // const auto cascadePercents = std::array{0.04f, 0.1f, 1.f}; // good for far = 500.f
     csmPipeline.init(gfxDevice, cascadePercents);
     pointLightShadowMapPipeline.init(gfxDevice, pointLightMaxRange);
+    csmPipeline.setLODParams(shadowLODParams);
+    pointLightShadowMapPipeline.setLODParams(shadowLODParams);
 
+    meshCullingPipeline.init(gfxDevice, maxMeshInstances, maxMeshletDraws);
     meshPipeline.init(gfxDevice, drawImageFormat, depthImageFormat, samples);
     skyboxPipeline.init(gfxDevice, drawImageFormat, depthImageFormat, samples);
 
@@ -53,6 +60,7 @@ void GameRenderer::createDrawImage(
         .height = (std::uint32_t)drawImageSize.y,
         .depth = 1,
     };
+    drawImageHeight = (float)drawImageSize.y;
 
     { // setup draw image
         VkImageUsageFlags usages{};
@@ -125,6 +133,71 @@ void GameRenderer::initSceneData(GfxDevice& gfxDevice)
         graphics::FRAME_OVERLAP,
         "light data");
     lightDataGPU.resize(MAX_LIGHTS);
+
+    lightClustersBuffer.init(
+        gfxDevice,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        sizeof(LightClusterGrid::Cluster) * LightClusterGrid::NUM_CLUSTERS,
+        graphics::FRAME_OVERLAP,
+        "light clusters");
+
+    lightIndicesBuffer.init(
+        gfxDevice,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        sizeof(std::uint32_t) * MAX_LIGHT_INDICES,
+        graphics::FRAME_OVERLAP,
+        "light indices");
+
+    createMeshDrawBuffers(gfxDevice);
+}
+
+void GameRenderer::createMeshDrawBuffers(GfxDevice& gfxDevice)
+{
+    meshIndirectCommandsBuffer.init(
+        gfxDevice,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        sizeof(VkDrawIndexedIndirectCommand) * maxMeshInstances,
+        graphics::FRAME_OVERLAP,
+        "mesh indirect commands");
+
+    meshInstanceDataBuffer.init(
+        gfxDevice,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        sizeof(GPUMeshInstanceData) * maxMeshInstances,
+        graphics::FRAME_OVERLAP,
+        "mesh instance data");
+
+    meshletDrawsBuffer.init(
+        gfxDevice,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        sizeof(GPUMeshletDraw) * maxMeshletDraws,
+        graphics::FRAME_OVERLAP,
+        "meshlet draws");
+}
+
+void GameRenderer::growMeshDrawBuffers(GfxDevice& gfxDevice)
+{
+    // regular and meshlet draw instances share the instance buffer
+    const auto numInstances = meshInstanceData.size();
+    const auto numMeshletDraws = meshletDraws.size();
+    if (numInstances <= maxMeshInstances && numMeshletDraws <= maxMeshletDraws) {
+        return;
+    }
+
+    while (maxMeshInstances < numInstances) {
+        maxMeshInstances *= 2;
+    }
+    while (maxMeshletDraws < numMeshletDraws) {
+        maxMeshletDraws *= 2;
+    }
+
+    // the old buffers might still be used by frames in flight
+    gfxDevice.waitIdle();
+    meshInstanceDataBuffer.cleanup(gfxDevice);
+    meshletDrawsBuffer.cleanup(gfxDevice);
+    meshIndirectCommandsBuffer.cleanup(gfxDevice);
+    createMeshDrawBuffers(gfxDevice);
+    meshCullingPipeline.resize(gfxDevice, maxMeshInstances, maxMeshletDraws);
 }
 
 void GameRenderer::draw(
@@ -133,6 +206,8 @@ void GameRenderer::draw(
     const Camera& camera,
     const SceneData& sceneData)
 {
+    growMeshDrawBuffers(gfxDevice);
+
     { // skinning
         { // Sync reading from skinning buffers with new writes
             const auto memoryBarrier = VkMemoryBarrier2{
@@ -151,12 +226,8 @@ void GameRenderer::draw(
         }
 
         vkutil::cmdBeginLabel(cmd, "Skinning");
-        for (const auto& dc : meshDrawCommands) {
-            if (!dc.skinnedMesh) {
-                continue;
-            }
-            skinningPipeline.doSkinning(cmd, gfxDevice.getCurrentFrameIndex(), meshCache, dc);
-        }
+        skinningPipeline.doSkinning(
+            cmd, gfxDevice.getCurrentFrameIndex(), meshCache, meshDrawCommands);
         vkutil::cmdEndLabel(cmd);
 
         { // Sync skinning with CSM
@@ -181,16 +252,18 @@ void GameRenderer::draw(
         TracyVkZoneC(gfxDevice.getTracyVkCtx(), cmd, "CSM", tracy::Color::CornflowerBlue);
         vkutil::cmdBeginLabel(cmd, "CSM");
 
-        auto& sunlight = lightDataGPU[sunlightIndex];
+        std::array<std::span<const std::uint32_t>, CSMPipeline::NUM_SHADOW_CASCADES> visible;
+        for (std::size_t i = 0; i < visible.size(); ++i) {
+            visible[i] = getVisibleDrawCommands(
+                csmViewsStart == NO_VIEW ? NO_VIEW : csmViewsStart + i);
+        }
         csmPipeline.draw(
             cmd,
             gfxDevice,
             meshCache,
-            camera,
-            sunlight.direction,
             materialCache.getMaterialDataBuffer(),
             meshDrawCommands,
-            shadowsEnabled);
+            visible);
 
         vkutil::cmdEndLabel(cmd);
     }
@@ -200,29 +273,20 @@ void GameRenderer::draw(
         TracyVkZoneC(gfxDevice.getTracyVkCtx(), cmd, "Point shadow", tracy::Color::CornflowerBlue);
         vkutil::cmdBeginLabel(cmd, "Point shadow");
 
-        std::vector<std::size_t> pointLightIndices;
-        for (std::size_t i = 0; i < lightDataGPU.size(); ++i) {
-            const auto& light = lightDataGPU[i];
-            if (light.type == edbr::TYPE_POINT_LIGHT) {
-                // TODO: check if this light should cast shadow or not
-                pointLightIndices.push_back(i);
+        pointLightShadowMapPipeline.beginFrame(cmd, gfxDevice);
+        for (std::size_t j = 0; j < pointLightFaceViews.size(); ++j) {
+            std::array<std::span<const std::uint32_t>, PointShadowAtlas::NUM_FACES> visible;
+            for (std::size_t i = 0; i < visible.size(); ++i) {
+                visible[i] = getVisibleDrawCommands(pointLightFaceViews[j][i]);
             }
-        }
-
-        pointLightShadowMapPipeline.beginFrame(cmd, gfxDevice, lightDataGPU, pointLightIndices);
-        for (const auto lightIndex : pointLightIndices) {
-            const auto& light = lightDataGPU[lightIndex];
             pointLightShadowMapPipeline.draw(
                 cmd,
                 gfxDevice,
                 meshCache,
-                camera,
-                (std::uint32_t)lightIndex,
-                light.position,
+                j,
                 materialCache.getMaterialDataBuffer(),
-                lightDataBuffer.getBuffer(),
                 meshDrawCommands,
-                shadowsEnabled);
+                visible);
         }
         pointLightShadowMapPipeline.endFrame(cmd, gfxDevice);
         vkutil::cmdEndLabel(cmd);
@@ -248,21 +312,27 @@ void GameRenderer::draw(
             .csmLightSpaceTMs = csmPipeline.csmLightSpaceTMs,
             .csmShadowMapId = (std::uint32_t)csmPipeline.getShadowMap(),
             .pointLightFarPlane = pointLightMaxRange,
+            .pointShadowAtlasId = (std::uint32_t)pointLightShadowMapPipeline.getShadowAtlas(),
+            .pointShadowFacesBuffer = pointLightShadowMapPipeline.getFacesBuffer().address,
             .lightsBuffer = lightDataBuffer.getBuffer().address,
             .numLights = (std::uint32_t)lightDataGPU.size(),
             .sunlightIndex = sunlightIndex,
             .materialsBuffer = materialCache.getMaterialDataBufferAddress(),
+            .lightClustersBuffer = lightClustersBuffer.getBuffer().address,
+            .lightIndicesBuffer = lightIndicesBuffer.getBuffer().address,
+            .cameraZNear = lightClusterGrid.getZNear(),
+            .cameraZFar = lightClusterGrid.getZFar(),
         };
         sceneDataBuffer.uploadNewData(
             cmd, gfxDevice.getCurrentFrameIndex(), (void*)&gpuSceneData, sizeof(GPUSceneData));
 
         { // update lights
-            // update point light shadow map IDs
-            const auto& lightToSM = pointLightShadowMapPipeline.getLightToShadowMapId();
-            for (std::size_t i = 0; i < lightDataGPU.size(); ++i) {
-                if (auto it = lightToSM.find(i); it != lightToSM.end()) {
-                    lightDataGPU[i].shadowMapID = it->second;
-                }
+            // update point light shadow slots
+            const auto shadowCastingLights =
+                pointLightShadowMapPipeline.getShadowCastingLights();
+            for (std::size_t i = 0; i < shadowCastingLights.size(); ++i) {
+                const auto lightIndex = shadowCastingLights[i].lightIndex;
+                lightDataGPU[lightIndex].shadowSlot = (std::uint32_t)i + 1;
             }
 
             lightDataBuffer.uploadNewData(
@@ -270,9 +340,61 @@ void GameRenderer::draw(
                 gfxDevice.getCurrentFrameIndex(),
                 (void*)lightDataGPU.data(),
                 sizeof(GPULightData) * lightDataGPU.size());
+
+            const auto& clusters = lightClusterGrid.getClusters();
+            lightClustersBuffer.uploadNewData(
+                cmd,
+                gfxDevice.getCurrentFrameIndex(),
+                (void*)clusters.data(),
+                sizeof(LightClusterGrid::Cluster) * clusters.size());
+
+            const auto& lightIndices = lightClusterGrid.getLightIndices();
+            lightIndicesBuffer.uploadNewData(
+                cmd,
+                gfxDevice.getCurrentFrameIndex(),
+                (void*)lightIndices.data(),
+                sizeof(std::uint32_t) * lightIndices.size());
+        }
+
+        { // upload indirect draws and instance data for the geometry pass
+            meshIndirectCommandsBuffer.uploadNewData(
+                cmd,
+                gfxDevice.getCurrentFrameIndex(),
+                (void*)meshIndirectCommands.data(),
+                sizeof(VkDrawIndexedIndirectCommand) * meshIndirectCommands.size());
+            meshInstanceDataBuffer.uploadNewData(
+                cmd,
+                gfxDevice.getCurrentFrameIndex(),
+                (void*)meshInstanceData.data(),
+                sizeof(GPUMeshInstanceData) * meshInstanceData.size());
+            meshletDrawsBuffer.uploadNewData(
+                cmd,
+                gfxDevice.getCurrentFrameIndex(),
+                (void*)meshletDraws.data(),
+                sizeof(GPUMeshletDraw) * meshletDraws.size());
         }
     }
 
+    { // GPU culling
+        ZoneScopedN("Mesh culling");
+        TracyVkZoneC(gfxDevice.getTracyVkCtx(), cmd, "Mesh culling", tracy::Color::Orange);
+        vkutil::cmdBeginLabel(cmd, "Mesh culling");
+        meshCullingPipeline.cull(
+            cmd,
+            gfxDevice,
+            camera,
+            meshInstanceDataBuffer.getBuffer(),
+            meshIndirectCommandsBuffer.getBuffer(),
+            (std::uint32_t)meshDrawStats.numInstances,
+            (std::uint32_t)meshIndirectCommands.size(),
+            (std::uint32_t)meshDrawStats.numIndex16Draws,
+            meshCache.getMeshletBuffer(),
+            meshletDrawsBuffer.getBuffer(),
+            (std::uint32_t)meshletDrawStats.numDraws,
+            (std::uint32_t)meshletDrawStats.numIndex16Draws);
+        vkutil::cmdEndLabel(cmd);
+    }
+
     const auto& drawImage = gfxDevice.getImage(drawImageId);
     const auto& resolveImage = gfxDevice.getImage(resolveImageId);
     const auto& depthImage = gfxDevice.getImage(depthImageId);
@@ -320,10 +442,13 @@ void GameRenderer::draw(
             gfxDevice,
             meshCache,
             materialCache,
-            camera,
             sceneDataBuffer.getBuffer(),
-            meshDrawCommands,
-            sortedMeshDrawCommands);
+            meshInstanceDataBuffer.getBuffer(),
+            meshCullingPipeline.getVisibleInstancesBuffer(),
+            meshCullingPipeline.getCompactedCommandsBuffer(),
+            meshCullingPipeline.getDrawCountBuffer(),
+            (std::uint32_t)(meshIndirectCommands.size() + meshletDrawStats.numDraws),
+            (std::uint32_t)(meshDrawStats.numIndex16Draws + meshletDrawStats.numIndex16Draws));
 
         // sky
         skyboxPipeline.draw(cmd, gfxDevice, camera);
@@ -348,7 +473,8 @@ void GameRenderer::draw(
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
             .srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
             .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-            .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstStageMask =
+                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
             .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
             .oldLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
             .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -397,6 +523,14 @@ void GameRenderer::draw(
         vkutil::cmdEndLabel(cmd);
     }
 
+    { // Hi-Z for next frame's occlusion culling
+        ZoneScopedN("Hi-Z");
+        TracyVkZoneC(gfxDevice.getTracyVkCtx(), cmd, "Hi-Z", tracy::Color::Orange);
+        vkutil::cmdBeginLabel(cmd, "Hi-Z");
+        meshCullingPipeline.buildHiZ(cmd, gfxDevice, getDepthImage(gfxDevice), camera);
+        vkutil::cmdEndLabel(cmd);
+    }
+
     { // post FX
         ZoneScopedN("Post FX");
         TracyVkZoneC(gfxDevice.getTracyVkCtx(), cmd, "Post FX", tracy::Color::Purple);
@@ -432,9 +566,16 @@ void GameRenderer::cleanup(GfxDevice& gfxDevice)
 {
     const auto& device = gfxDevice.getDevice();
 
+    meshInstanceDataBuffer.cleanup(gfxDevice);
+    meshletDrawsBuffer.cleanup(gfxDevice);
+    meshIndirectCommandsBuffer.cleanup(gfxDevice);
+    lightIndicesBuffer.cleanup(gfxDevice);
+    lightClustersBuffer.cleanup(gfxDevice);
     lightDataBuffer.cleanup(gfxDevice);
     sceneDataBuffer.cleanup(gfxDevice);
 
+    meshCullingPipeline.cleanup(gfxDevice);
+
     postFXPipeline.cleanup(device);
     depthResolvePipeline.cleanup(device);
     skyboxPipeline.cleanup(device);
@@ -446,9 +587,52 @@ void GameRenderer::cleanup(GfxDevice& gfxDevice)
 
 void GameRenderer::updateDevTools(GfxDevice& gfxDevice, float dt)
 {
+    ImGui::Text(
+        "Mesh draw calls: %d (%d instances, %d with 16-bit indices)",
+        (int)meshDrawStats.numDraws,
+        (int)meshDrawStats.numInstances,
+        (int)meshDrawStats.numIndex16Draws);
+    ImGui::Text(
+        "Meshlet draws: %d (%d instances)",
+        (int)meshletDrawStats.numDraws,
+        (int)meshletDrawStats.numInstances);
+    ImGui::Text(
+        "Instance buffers: %d instances, %d meshlet draws",
+        (int)maxMeshInstances,
+        (int)maxMeshletDraws);
+    ImGui::Text("Draw commands: %d", (int)meshDrawCommands.size());
+    ImGui::Text(
+        "Lights: %d (%d light indices, %d dropped)",
+        (int)lightDataGPU.size(),
+        (int)lightClusterGrid.getLightIndices().size(),
+        (int)lightClusterGrid.getNumDroppedLightIndices());
+
     ImGui::DragFloat3("Cascades", csmPipeline.percents.data(), 0.1f, 0.f, 1.f);
 
     ImGui::Checkbox("Shadows", &shadowsEnabled);
+    ImGui::Checkbox("Cache static CSM casters", &csmPipeline.cachingEnabled);
+    ImGui::Checkbox(
+        "Update far CSM cascade every other frame", &csmPipeline.updateFarCascadeEveryOtherFrame);
+    ImGui::Checkbox("Cache point light shadows", &pointLightShadowMapPipeline.cachingEnabled);
+    const auto pointShadowStats = pointLightShadowMapPipeline.getStats();
+    ImGui::Text(
+        "Point shadows: %d lights, %d faces drawn (%d draws), %d cached, %d skipped",
+        (int)pointShadowStats.numLights,
+        (int)pointShadowStats.numDrawnFaces,
+        (int)pointLightShadowMapPipeline.getNumDraws(),
+        (int)pointShadowStats.numCachedFaces,
+        (int)pointShadowStats.numSkippedFaces);
+    ImGui::Checkbox("Occlusion culling", &meshCullingPipeline.occlusionCullingEnabled);
+    if (ImGui::Checkbox("Meshlet culling", &meshletCullingEnabled)) {
+        csmPipeline.meshletCullingEnabled = meshletCullingEnabled;
+        pointLightShadowMapPipeline.meshletCullingEnabled = meshletCullingEnabled;
+    }
+
+    ImGui::DragFloat("LOD bias", &lodParams.bias, 0.05f, 0.f, 16.f);
+    if (ImGui::DragFloat("Shadow LOD bias", &shadowLODParams.bias, 0.05f, 0.f, 16.f)) {
+        csmPipeline.setLODParams(shadowLODParams);
+        pointLightShadowMapPipeline.setLODParams(shadowLODParams);
+    }
 
     if (ImGui::BeginCombo("MSAA", vkutil::sampleCountToString(samples))) {
         static const auto counts = std::array{
@@ -498,6 +682,7 @@ void GameRenderer::onMultisamplingStateUpdate(GfxDevice& gfxDevice)
     const auto prevDrawImageSize =
         glm::ivec2{drawImage.getExtent2D().width, drawImage.getExtent2D().height};
     createDrawImage(gfxDevice, prevDrawImageSize, false);
+    meshCullingPipeline.invalidateHiZ();
 
     // recreate pipelines
     meshPipeline.init(gfxDevice, drawImageFormat, depthImageFormat, samples);
@@ -512,18 +697,65 @@ void GameRenderer::setSkyboxImage(ImageId skyboxImageId)
 void GameRenderer::beginDrawing(GfxDevice& gfxDevice)
 {
     meshDrawCommands.clear();
+    parallelDrawList.reset(jobSystem.getNumThreads());
     lightDataGPU.clear();
     sunlightIndex = -1;
     skinningPipeline.beginDrawing(gfxDevice.getCurrentFrameIndex());
 }
 
-void GameRenderer::endDrawing()
+void GameRenderer::endDrawing(const Camera& camera)
 {
-    sortDrawList();
+    parallelDrawList.mergeInto(meshDrawCommands);
+    {
+        ZoneScopedN("Select LODs");
+        graphics::selectMeshLODs(
+            meshDrawCommands,
+            meshCache.getMeshes(),
+            camera,
+            drawImageHeight,
+            lodParams,
+            lodHistory);
+    }
+    sortDrawList(camera);
+    cullDrawList(camera);
+
+    {
+        ZoneScopedN("Light clustering");
+        lightClusterGrid.build(camera, lightDataGPU, MAX_LIGHT_INDICES);
+    }
+
+    const auto mainViewDrawCommands = getVisibleDrawCommands(mainViewIndex);
+    visibleDrawCommands.assign(mainViewDrawCommands.begin(), mainViewDrawCommands.end());
+    visibleMeshletDrawCommands.clear();
+    if (meshletCullingEnabled) {
+        graphics::splitMeshletDrawCommands(
+            meshDrawCommands,
+            meshCache.getMeshes(),
+            visibleDrawCommands,
+            visibleMeshletDrawCommands);
+    }
+
+    // all visible instances are drawn: draw grows the buffers if they don't fit
+    meshDrawStats = graphics::buildIndirectDrawCommands(
+        meshDrawCommands,
+        visibleDrawCommands,
+        meshCache.getMeshes(),
+        meshIndirectCommands,
+        meshInstanceData);
+    meshletDrawStats = graphics::buildMeshletDraws(
+        meshDrawCommands,
+        visibleMeshletDrawCommands,
+        meshCache.getMeshes(),
+        meshInstanceData,
+        meshletDraws);
 }
 
 void GameRenderer::addLight(const Light& light, const Transform& transform)
 {
+    if (lightDataGPU.size() == MAX_LIGHTS) {
+        return;
+    }
+
     if (light.type == LightType::Directional) {
         assert(sunlightIndex == -1 && "directional light was already added before in the frame");
         sunlightIndex = (std::uint32_t)lightDataGPU.size();
@@ -549,7 +781,7 @@ void GameRenderer::addLight(const Light& light, const Transform& transform)
     ld.scaleOffset.x = light.scaleOffset.x;
     ld.scaleOffset.y = light.scaleOffset.y;
 
-    ld.shadowMapID = 0;
+    ld.shadowSlot = 0;
 
     lightDataGPU.push_back(ld);
 }
@@ -558,20 +790,49 @@ void GameRenderer::drawMesh(
     MeshId id,
     const glm::mat4& transform,
     MaterialId materialId,
-    bool castShadow)
+    bool castShadow,
+    bool isStatic,
+    DrawId drawId)
+{
+    meshDrawCommands.push_back(
+        createMeshDrawCommand(id, transform, materialId, castShadow, isStatic, drawId));
+}
+
+void GameRenderer::drawMeshParallel(
+    std::size_t threadIndex,
+    MeshId id,
+    const glm::mat4& transform,
+    MaterialId materialId,
+    bool castShadow,
+    bool isStatic,
+    DrawId drawId)
+{
+    parallelDrawList.get(threadIndex)
+        .push_back(createMeshDrawCommand(id, transform, materialId, castShadow, isStatic, drawId));
+}
+
+MeshDrawCommand GameRenderer::createMeshDrawCommand(
+    MeshId id,
+    const glm::mat4& transform,
+    MaterialId materialId,
+    bool castShadow,
+    bool isStatic,
+    DrawId drawId) const
 {
     const auto& mesh = meshCache.getMesh(id);
     const auto worldBoundingSphere =
         edge::calculateBoundingSphereWorld(transform, mesh.boundingSphere, false);
     assert(materialId != NULL_MATERIAL_ID);
 
-    meshDrawCommands.push_back(MeshDrawCommand{
+    return MeshDrawCommand{
         .meshId = id,
         .transformMatrix = transform,
         .worldBoundingSphere = worldBoundingSphere,
         .materialId = materialId,
+        .drawId = drawId,
         .castShadow = castShadow,
-    });
+        .isStatic = isStatic,
+    };
 }
 
 std::size_t GameRenderer::appendJointMatrices(
@@ -586,7 +847,8 @@ void GameRenderer::drawSkinnedMesh(
     const glm::mat4& transform,
     MaterialId materialId,
     const SkinnedMesh& skinnedMesh,
-    std::size_t jointMatricesStartIndex)
+    std::size_t jointMatricesStartIndex,
+    DrawId drawId)
 {
     const auto& mesh = meshCache.getMesh(meshId);
     assert(mesh.hasSkeleton);
@@ -599,25 +861,125 @@ void GameRenderer::drawSkinnedMesh(
         .transformMatrix = transform,
         .worldBoundingSphere = worldBoundingSphere,
         .materialId = materialId,
+        .drawId = drawId,
         .skinnedMesh = &skinnedMesh,
         .jointMatricesStartIndex = (std::uint32_t)jointMatricesStartIndex,
     });
 }
 
-void GameRenderer::sortDrawList()
+void GameRenderer::sortDrawList(const Camera& camera)
 {
-    sortedMeshDrawCommands.clear();
-    sortedMeshDrawCommands.resize(meshDrawCommands.size());
-    std::iota(sortedMeshDrawCommands.begin(), sortedMeshDrawCommands.end(), 0);
-
-    std::sort(
-        sortedMeshDrawCommands.begin(),
-        sortedMeshDrawCommands.end(),
-        [this](const auto& i1, const auto& i2) {
-            const auto& dc1 = meshDrawCommands[i1];
-            const auto& dc2 = meshDrawCommands[i2];
-            return dc1.meshId < dc2.meshId;
-        });
+    ZoneScopedN("Sort draw list");
+
+    // view space looks at -Z, so depth = -(view * pos).z
+    const auto view = camera.getView();
+    const auto depthRow = -glm::vec4{view[0][2], view[1][2], view[2][2], view[3][2]};
+    const auto invZFar = 1.f / camera.getZFar();
+
+    drawSortKeys.resize(meshDrawCommands.size());
+    for (std::size_t i = 0; i < meshDrawCommands.size(); ++i) {
+        const auto& dc = meshDrawCommands[i];
+        const auto depth = glm::dot(depthRow, glm::vec4{dc.worldBoundingSphere.center, 1.f});
+        drawSortKeys[i] = util::KeyIndex{
+            // everything is opaque for now
+            .key = graphics::makeDrawSortKey(
+                graphics::DrawSortPass::Opaque,
+                dc.skinnedMesh != nullptr,
+                dc.materialId,
+                dc.meshId,
+                dc.lod,
+                depth * invZFar),
+            .index = (std::uint32_t)i,
+        };
+    }
+    util::radixSort(drawSortKeys, drawSortKeysScratch);
+
+    sortedMeshDrawCommands.resize(drawSortKeys.size());
+    for (std::size_t i = 0; i < drawSortKeys.size(); ++i) {
+        sortedMeshDrawCommands[i] = drawSortKeys[i].index;
+    }
+}
+
+void GameRenderer::cullDrawList(const Camera& camera)
+{
+    ZoneScopedN("Cull draw list");
+
+    cullingStage.clear();
+    cullingStage.setDrawCommands(meshDrawCommands, sortedMeshDrawCommands);
+
+    mainViewIndex = cullingStage.addView({.volume = edge::createFrustumFromCamera(camera)});
+
+    csmViewsStart = NO_VIEW;
+    if (sunlightIndex != -1) {
+        const auto& sunlight = lightDataGPU[sunlightIndex];
+        // static layers are empty while shadows are disabled, so they need to
+        // be redrawn when shadows get enabled again
+        const auto staticCastersHash =
+            shadowsEnabled ? graphics::hashStaticShadowCasters(meshDrawCommands) : 0;
+        csmPipeline.updateCascades(camera, sunlight.direction, staticCastersHash);
+        if (shadowsEnabled) {
+            for (std::size_t i = 0; i < CSMPipeline::NUM_SHADOW_CASCADES; ++i) {
+                // the whole cascade is the receiver volume (and not just the
+                // part of the camera frustum) because static casters are cached
+                const auto cascadeCorners =
+                    edge::calculateFrustumCornersWorldSpace(csmPipeline.getCascadeCamera(i));
+                const auto viewIndex = cullingStage.addView({
+                    .volume = edge::createDirectionalLightCasterVolume(
+                        cascadeCorners, sunlight.direction),
+                    .shadowCastersOnly = true,
+                });
+                if (i == 0) {
+                    csmViewsStart = viewIndex;
+                }
+            }
+        }
+    }
+
+    // while shadows are disabled all lights are dropped from the atlas,
+    // so their faces get redrawn when shadows are enabled again
+    auto shadowCastingCandidates = std::span<const GPULightData>{lightDataGPU};
+    if (!shadowsEnabled) {
+        shadowCastingCandidates = {};
+    }
+    pointLightShadowMapPipeline.updateLights(camera, shadowCastingCandidates);
+
+    const auto shadowCastingLights = pointLightShadowMapPipeline.getShadowCastingLights();
+    pointLightFaceViews.resize(shadowCastingLights.size());
+    for (std::size_t j = 0; j < shadowCastingLights.size(); ++j) {
+        const auto& light = shadowCastingLights[j];
+        for (std::size_t i = 0; i < PointShadowAtlas::NUM_FACES; ++i) {
+            const auto& face = light.faces[i];
+            if (face.state == PointShadowAtlas::FaceState::Skipped) {
+                pointLightFaceViews[j][i] = NO_VIEW;
+                continue;
+            }
+            pointLightFaceViews[j][i] = cullingStage.addView({
+                .volume = edge::createPointLightFaceCasterVolume(
+                    face.camera, light.position, light.range),
+                .shadowCastersOnly = true,
+            });
+        }
+    }
+
+    cullingStage.cull(&jobSystem);
+
+    // faces whose casters didn't change are kept in the atlas
+    for (std::size_t j = 0; j < pointLightFaceViews.size(); ++j) {
+        for (std::size_t i = 0; i < PointShadowAtlas::NUM_FACES; ++i) {
+            if (pointLightFaceViews[j][i] != NO_VIEW) {
+                pointLightShadowMapPipeline.updateFaceCasters(
+                    j, i, meshDrawCommands, getVisibleDrawCommands(pointLightFaceViews[j][i]));
+            }
+        }
+    }
+}
+
+std::span<const std::uint32_t> GameRenderer::getVisibleDrawCommands(std::size_t viewIndex) const
+{
+    if (viewIndex == NO_VIEW) {
+        return {};
+    }
+    return cullingStage.getVisibleDrawCommands(viewIndex);
 }
 
 const GPUImage& GameRenderer::getDrawImage(GfxDevice& gfxDevice) const
@@ -22,22 +22,94 @@
 #include <edbr/Graphics/Vulkan/Util.h>
 
 #include <edbr/Graphics/ImageLoader.h>
-#include <edbr/Graphics/MipMapGeneration.h>
+#include <edbr/Util/CookedTexture.h>
 
 #include <tracy/Tracy.hpp>
 
 namespace
 {
 static constexpr auto NO_TIMEOUT = std::numeric_limits<std::uint64_t>::max();
+static constexpr std::size_t UPLOAD_RING_BUFFER_SIZE = 64 * 1024 * 1024;
+
+std::optional<CookedTexture> readCookedImage(const ImageCache::LoadParams& params)
+{
+    // block-compressed images can only be sampled and copied
+    const auto allowedUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                              VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if ((params.usage & ~allowedUsage) != 0 || !util::isCookedTextureUpToDate(params.path)) {
+        return std::nullopt;
+    }
+
+    auto cooked = util::readCookedTexture(util::getCookedTexturePath(params.path));
+    if (!cooked.has_value() ||
+        !util::isCookedTextureCompatible(cooked->texture.format, params.format, params.kind)) {
+        return std::nullopt;
+    }
+
+    // cooked by an older cooker without all mips - fall back to the image
+    const auto& texture = cooked->texture;
+    const auto maxExtent = std::max(texture.width, texture.height);
+    const auto numMips = params.mipMap ? (std::size_t)std::floor(std::log2(maxExtent)) + 1 : 1;
+    if (texture.mips.size() < numMips) {
+        return std::nullopt;
+    }
+    return cooked;
 }
 
-GfxDevice::GfxDevice() : imageCache(*this)
+// can be called from any thread
+std::optional<DecodedImage> decodeImageFile(const ImageCache::LoadParams& params)
+{
+    DecodedImage decoded;
+    // cooked textures are made by texture_cooker
+    decoded.cooked = readCookedImage(params);
+    if (decoded.cooked) {
+        return decoded;
+    }
+
+    decoded.data = util::loadImage(params.path);
+    if (!decoded.data.pixels) {
+        fmt::println("[error] failed to load image from '{}'", params.path.string());
+        return std::nullopt;
+    }
+    return decoded;
+}
+}
+
+GfxDevice::GfxDevice() :
+    uploadQueue(*this),
+    imageCache(
+        ImageCache::Device{
+            .decodeImage = decodeImageFile,
+            .createImage =
+                [this](const ImageCache::LoadParams& params, DecodedImage decoded) {
+                    return std::optional{createDecodedImage(params, std::move(decoded))};
+                },
+            .destroyImage = [this](const GPUImage& image) { destroyImage(image); },
+            .setBindlessImage =
+                [this](ImageId id, const GPUImage& image) {
+                    bindlessSetManager.addImage(device, id, image.imageView);
+                },
+            .getMemorySize =
+                [this](const GPUImage& image) {
+                    VmaAllocationInfo info;
+                    vmaGetAllocationInfo(allocator, image.allocation, &info);
+                    return (std::size_t)info.size;
+                },
+        })
 {}
 
-void GfxDevice::init(SDL_Window* window, const char* appName, const Version& version, bool vSync)
+void GfxDevice::init(
+    SDL_Window* window,
+    const char* appName,
+    const Version& version,
+    bool vSync,
+    TaskQueue& taskQueue)
 {
+    imageCache.setDecodeQueue(taskQueue);
     initVulkan(window, appName, version);
     executor = createImmediateExecutor();
+    asyncExecutor.init(device, graphicsQueueFamily, graphicsQueue);
+    uploadQueue.init(UPLOAD_RING_BUFFER_SIZE);
 
     swapchain.initSyncStructures(device);
 
@@ -49,7 +121,7 @@ void GfxDevice::init(SDL_Window* window, const char* appName, const Version& ver
     swapchain.create(device, swapchainFormat, (std::uint32_t)w, (std::uint32_t)h, vSync);
 
     createCommandBuffers();
-    imageCache.bindlessSetManager.init(device, getMaxAnisotropy());
+    bindlessSetManager.init(device, getMaxAnisotropy());
 
     { // create white texture
         std::uint32_t pixel = 0xFFFFFFFF;
@@ -117,11 +189,15 @@ void GfxDevice::initVulkan(SDL_Window* window, const char* appName, const Versio
     const auto deviceFeatures = VkPhysicalDeviceFeatures{
         .imageCubeArray = VK_TRUE,
         .geometryShader = VK_TRUE, // for im3d
+        .multiDrawIndirect = VK_TRUE,
+        .drawIndirectFirstInstance = VK_TRUE, // mesh draw data is indexed by gl_InstanceIndex
         .depthClamp = VK_TRUE,
         .samplerAnisotropy = VK_TRUE,
+        .textureCompressionBC = VK_TRUE, // cooked textures (see CookedTexture.h)
     };
 
     const auto features12 = VkPhysicalDeviceVulkan12Features{
+        .drawIndirectCount = true,
         .descriptorIndexing = true,
         .descriptorBindingSampledImageUpdateAfterBind = true,
         .descriptorBindingStorageImageUpdateAfterBind = true,
@@ -129,6 +205,7 @@ void GfxDevice::initVulkan(SDL_Window* window, const char* appName, const Versio
         .descriptorBindingVariableDescriptorCount = true,
         .runtimeDescriptorArray = true,
         .scalarBlockLayout = true,
+        .timelineSemaphore = true, // for VulkanAsyncExecutor
         .bufferDeviceAddress = true,
     };
     const auto features13 = VkPhysicalDeviceVulkan13Features{
@@ -230,6 +307,8 @@ void GfxDevice::recreateSwapchain(std::uint32_t swapchainWidth, std::uint32_t sw
 VkCommandBuffer GfxDevice::beginFrame()
 {
     swapchain.beginFrame(device, getCurrentFrameIndex());
+    imageCache.beginFrame(frameNumber);
+    imageCache.update(); // uploads are submitted in endFrame
 
     const auto& frame = getCurrentFrame();
     const auto& cmd = frame.mainCommandBuffer;
@@ -244,6 +323,9 @@ VkCommandBuffer GfxDevice::beginFrame()
 
 void GfxDevice::endFrame(VkCommandBuffer cmd, const GPUImage& drawImage, const EndFrameProps& props)
 {
+    // submitted before the frame's commands, so everything uploaded during the frame can be used
+    uploadQueue.flush();
+
     // get swapchain image
     const auto [swapchainImage, swapchainImageIndex] =
         swapchain.acquireImage(device, getCurrentFrameIndex());
@@ -338,8 +420,9 @@ void GfxDevice::endFrame(VkCommandBuffer cmd, const GPUImage& drawImage, const E
 
 void GfxDevice::cleanup()
 {
+    uploadQueue.cleanup();
     imageCache.destroyImages();
-    imageCache.bindlessSetManager.cleanup(device);
+    bindlessSetManager.cleanup(device);
 
     for (auto& frame : frames) {
         vkDestroyCommandPool(device, frame.commandPool, 0);
@@ -354,6 +437,7 @@ void GfxDevice::cleanup()
     swapchain.cleanup(device);
 
     executor.cleanup(device);
+    asyncExecutor.cleanup(device);
 
     vkb::destroy_surface(instance, surface);
     vmaDestroyAllocator(allocator);
@@ -439,11 +523,32 @@ VulkanImmediateExecutor GfxDevice::createImmediateExecutor() const
     return executor;
 }
 
-void GfxDevice::immediateSubmit(std::function<void(VkCommandBuffer)>&& f) const
+void GfxDevice::immediateSubmit(std::function<void(VkCommandBuffer)>&& f)
 {
+    uploadQueue.flush();
     executor.immediateSubmit(std::move(f));
 }
 
+std::uint64_t GfxDevice::submitAsync(std::function<void(VkCommandBuffer)>&& f)
+{
+    return asyncExecutor.submit(std::move(f));
+}
+
+bool GfxDevice::isAsyncSubmitComplete(std::uint64_t value) const
+{
+    return asyncExecutor.getCompletedValue() >= value;
+}
+
+void GfxDevice::waitForAsyncSubmit(std::uint64_t value) const
+{
+    asyncExecutor.wait(value);
+}
+
+std::uint64_t GfxDevice::getCompletedAsyncSubmitValue() const
+{
+    return asyncExecutor.getCompletedValue();
+}
+
 void GfxDevice::waitIdle() const
 {
     VK_CHECK(vkDeviceWaitIdle(device));
@@ -451,17 +556,17 @@ void GfxDevice::waitIdle() const
 
 BindlessSetManager& GfxDevice::getBindlessSetManager()
 {
-    return imageCache.bindlessSetManager;
+    return bindlessSetManager;
 }
 
 VkDescriptorSetLayout GfxDevice::getBindlessDescSetLayout() const
 {
-    return imageCache.bindlessSetManager.getDescSetLayout();
+    return bindlessSetManager.getDescSetLayout();
 }
 
 const VkDescriptorSet& GfxDevice::getBindlessDescSet() const
 {
-    return imageCache.bindlessSetManager.getDescSet();
+    return bindlessSetManager.getDescSet();
 }
 
 void GfxDevice::bindBindlessDescSet(VkCommandBuffer cmd, VkPipelineLayout layout) const
@@ -472,7 +577,7 @@ void GfxDevice::bindBindlessDescSet(VkCommandBuffer cmd, VkPipelineLayout layout
         layout,
         0,
         1,
-        &imageCache.bindlessSetManager.getDescSet(),
+        &bindlessSetManager.getDescSet(),
         0,
         nullptr);
 }
@@ -533,6 +638,12 @@ ImageId GfxDevice::loadImageFromFile(
     return imageCache.loadImageFromFile(path, format, usage, mipMap);
 }
 
+std::vector<ImageId> GfxDevice::loadImagesFromFiles(
+    std::span<const ImageCache::LoadParams> params)
+{
+    return imageCache.loadImagesFromFiles(params);
+}
+
 const GPUImage& GfxDevice::getImage(ImageId id) const
 {
     return imageCache.getImage(id);
@@ -630,99 +741,93 @@ GPUImage GfxDevice::createImageRaw(
     return image;
 }
 
-void GfxDevice::uploadImageData(const GPUImage& image, void* pixelData, std::uint32_t layer) const
+void GfxDevice::uploadImageData(const GPUImage& image, void* pixelData)
 {
     int numChannels = 4;
     if (image.format == VK_FORMAT_R8_UNORM) {
         // FIXME: support more types
         numChannels = 1;
     }
-    const auto dataSize =
-        image.extent.depth * image.extent.width * image.extent.height * numChannels;
-
-    const auto uploadBuffer = createBuffer(dataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-    memcpy(uploadBuffer.info.pMappedData, pixelData, dataSize);
-
-    executor.immediateSubmit([&](VkCommandBuffer cmd) {
-        assert(
-            (image.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0 &&
-            "Image needs to have VK_IMAGE_USAGE_TRANSFER_DST_BIT to upload data to it");
-        vkutil::transitionImage(
-            cmd, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        const auto copyRegion = VkBufferImageCopy{
-            .bufferOffset = 0,
-            .bufferRowLength = 0,
-            .bufferImageHeight = 0,
-            .imageSubresource =
-                {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .mipLevel = 0,
-                    .baseArrayLayer = layer,
-                    .layerCount = 1,
-                },
-            .imageExtent = image.extent,
+    const auto layerSize =
+        (std::size_t)image.extent.depth * image.extent.width * image.extent.height * numChannels;
+
+    // all layers are uploaded together (see GPUUploadQueue::uploadImage)
+    std::vector<graphics::ImageSubresourceUpload> layers(image.numLayers);
+    for (std::uint32_t layer = 0; layer < image.numLayers; ++layer) {
+        layers[layer] = graphics::ImageSubresourceUpload{
+            .data = std::span{(const std::byte*)pixelData + layer * layerSize, layerSize},
+            .layer = layer,
         };
-
-        vkCmdCopyBufferToImage(
-            cmd,
-            uploadBuffer.buffer,
-            image.image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &copyRegion);
-
-        if (image.mipLevels > 1) {
-            assert(
-                (image.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0 &&
-                (image.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0 &&
-                "Image needs to have VK_IMAGE_USAGE_TRANSFER_{DST,SRC}_BIT to generate mip maps");
-            graphics::generateMipmaps(
-                cmd,
-                image.image,
-                VkExtent2D{image.extent.width, image.extent.height},
-                image.mipLevels);
-        } else {
-            vkutil::transitionImage(
-                cmd,
-                image.image,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        }
-    });
-
-    destroyBuffer(uploadBuffer);
+    }
+    uploadQueue.uploadImage(image, layers);
 }
 
 GPUImage GfxDevice::loadImageFromFileRaw(
     const std::filesystem::path& path,
     VkFormat format,
     VkImageUsageFlags usage,
-    bool mipMap) const
+    bool mipMap)
 {
-    auto data = util::loadImage(path);
-    if (!data.pixels) {
-        fmt::println("[error] failed to load image from '{}'", path.string());
-        return getImage(errorImageId);
-    }
-
-    auto image = createImageRaw({
+    const auto params = ImageCache::LoadParams{
+        .path = path,
         .format = format,
-        .usage = usage | //
-                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | // for uploading pixel data to image
-                 VK_IMAGE_USAGE_TRANSFER_SRC_BIT, // for generating mips
-        .extent =
-            VkExtent3D{
-                .width = (std::uint32_t)data.width,
-                .height = (std::uint32_t)data.height,
-                .depth = 1,
-            },
+        .usage = usage,
         .mipMap = mipMap,
-    });
-    uploadImageData(image, data.pixels);
+    };
+    auto decoded = decodeImageFile(params);
+    if (!decoded) {
+        return getImage(errorImageId);
+    }
+    return createDecodedImage(params, std::move(*decoded));
+}
+
+GPUImage GfxDevice::createDecodedImage(
+    const ImageCache::LoadParams& params,
+    DecodedImage decoded)
+{
+    GPUImage image;
+    if (decoded.cooked) {
+        const auto& texture = decoded.cooked->texture;
+        image = createImageRaw({
+            .format = texture.format,
+            .usage = params.usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .extent =
+                VkExtent3D{
+                    .width = texture.width,
+                    .height = texture.height,
+                    .depth = 1,
+                },
+            .mipMap = params.mipMap,
+        });
+        // data is copied to the staging buffer, so the file can be unmapped after this
+        std::vector<graphics::ImageSubresourceUpload> mips(image.mipLevels);
+        for (std::uint32_t mip = 0; mip < image.mipLevels; ++mip) {
+            mips[mip] = graphics::ImageSubresourceUpload{
+                .data = texture.mips[mip],
+                .mipLevel = mip,
+            };
+        }
+        uploadQueue.uploadImage(image, mips);
+    } else {
+        const auto& data = decoded.data;
+        image = createImageRaw({
+            .format = params.format,
+            .usage = params.usage | //
+                     VK_IMAGE_USAGE_TRANSFER_DST_BIT | // for uploading pixel data to image
+                     VK_IMAGE_USAGE_TRANSFER_SRC_BIT, // for generating mips
+            .extent =
+                VkExtent3D{
+                    .width = (std::uint32_t)data.width,
+                    .height = (std::uint32_t)data.height,
+                    .depth = 1,
+                },
+            .mipMap = params.mipMap,
+        });
+        uploadImageData(image, data.pixels);
+    }
 
-    image.debugName = path.string();
-    vkutil::addDebugLabel(device, image.image, path.string().c_str());
+    image.debugName = params.path.string();
+    vkutil::addDebugLabel(device, image.image, image.debugName.c_str());
 
     return image;
 }
@@ -0,0 +1,138 @@
+#include <edbr/Graphics/HiZPyramid.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include <edbr/Math/Sphere.h>
+
+namespace
+{
+float reduceMin(std::span<const float> src, const glm::ivec2& srcSize, int x, int y)
+{
+    // odd sizes are handled by clamping - the last texel just covers one row/column
+    const auto x0 = 2 * x;
+    const auto y0 = 2 * y;
+    const auto x1 = std::min(x0 + 1, srcSize.x - 1);
+    const auto y1 = std::min(y0 + 1, srcSize.y - 1);
+    return std::min(
+        std::min(src[y0 * srcSize.x + x0], src[y0 * srcSize.x + x1]),
+        std::min(src[y1 * srcSize.x + x0], src[y1 * srcSize.x + x1]));
+}
+}
+
+std::vector<HiZPyramid::Level> HiZPyramid::calculateLevels(const glm::ivec2& depthImageSize)
+{
+    assert(depthImageSize.x > 0 && depthImageSize.y > 0);
+
+    std::vector<Level> levels;
+    auto size = depthImageSize;
+    std::uint32_t offset = 0;
+    do {
+        size = (size + 1) / 2;
+        levels.push_back(Level{.size = size, .offset = offset});
+        offset += size.x * size.y;
+    } while (size.x > 1 || size.y > 1);
+    return levels;
+}
+
+std::size_t HiZPyramid::calculateDataSize(std::span<const Level> levels)
+{
+    assert(!levels.empty());
+    const auto& last = levels.back();
+    return last.offset + last.size.x * last.size.y;
+}
+
+void HiZPyramid::build(std::span<const float> depth, const glm::ivec2& depthImageSize)
+{
+    assert(depth.size() == (std::size_t)(depthImageSize.x * depthImageSize.y));
+
+    if (this->depthImageSize != depthImageSize) {
+        this->depthImageSize = depthImageSize;
+        levels = calculateLevels(depthImageSize);
+        data.resize(calculateDataSize(levels));
+    }
+
+    auto src = depth;
+    auto srcSize = depthImageSize;
+    for (const auto& level : levels) {
+        auto dst = std::span{data}.subspan(level.offset, level.size.x * level.size.y);
+        for (int y = 0; y < level.size.y; ++y) {
+            for (int x = 0; x < level.size.x; ++x) {
+                dst[y * level.size.x + x] = reduceMin(src, srcSize, x, y);
+            }
+        }
+        src = dst;
+        srcSize = level.size;
+    }
+}
+
+float HiZPyramid::getDepth(std::size_t level, int x, int y) const
+{
+    assert(level < levels.size());
+    const auto& l = levels[level];
+    assert(x >= 0 && x < l.size.x && y >= 0 && y < l.size.y);
+    return data[l.offset + y * l.size.x + x];
+}
+
+bool HiZPyramid::isSphereOccluded(
+    const math::Sphere& sphere,
+    const glm::mat4& view,
+    const glm::mat4& proj,
+    float zNear) const
+{
+    assert(!levels.empty());
+
+    const auto c = glm::vec3{view * glm::vec4{sphere.center, 1.f}};
+    const auto r = sphere.radius;
+    if (-c.z - r < zNear) {
+        return false;
+    }
+
+    // screen rect of the sphere's view space AABB - a bit conservative but simple
+    auto uvMin = glm::vec2{std::numeric_limits<float>::max()};
+    auto uvMax = glm::vec2{std::numeric_limits<float>::lowest()};
+    for (int i = 0; i < 8; ++i) {
+        const auto corner = c + glm::vec3{
+                                    (i & 1) ? r : -r,
+                                    (i & 2) ? r : -r,
+                                    (i & 4) ? r : -r,
+                                };
+        const auto clip = proj * glm::vec4{corner, 1.f};
+        const auto uv = glm::vec2{clip.x, clip.y} / clip.w * 0.5f + 0.5f;
+        uvMin = glm::min(uvMin, uv);
+        uvMax = glm::max(uvMax, uv);
+    }
+    if (uvMax.x < 0.f || uvMax.y < 0.f || uvMin.x > 1.f || uvMin.y > 1.f) {
+        return false; // off-screen: left to frustum culling
+    }
+
+    // depth of the sphere's closest point (max depth with reverse-Z)
+    const auto nearestClip = proj * glm::vec4{c.x, c.y, c.z + r, 1.f};
+    const auto sphereDepth = nearestClip.z / nearestClip.w;
+
+    const auto sizeF = glm::vec2{depthImageSize};
+    const auto maxPixel = depthImageSize - 1;
+    const auto pMin = glm::clamp(glm::ivec2{uvMin * sizeF}, glm::ivec2{0}, maxPixel);
+    const auto pMax = glm::clamp(glm::ivec2{uvMax * sizeF}, glm::ivec2{0}, maxPixel);
+
+    // pick the level where the rect covers at most 2x2 texels
+    const auto extent = std::max(pMax.x - pMin.x, pMax.y - pMin.y) + 1;
+    std::size_t level = 0;
+    while (level + 1 < levels.size() && (1 << (level + 1)) < extent) {
+        ++level;
+    }
+
+    const auto shift = (int)level + 1;
+    const auto& l = levels[level];
+    const auto tMin = glm::min(pMin >> shift, l.size - 1);
+    const auto tMax = glm::min(pMax >> shift, l.size - 1);
+
+    auto farthestDepth = 1.f;
+    for (int y = tMin.y; y <= tMax.y; ++y) {
+        for (int x = tMin.x; x <= tMax.x; ++x) {
+            farthestDepth = std::min(farthestDepth, getDepth(level, x, y));
+        }
+    }
+    return sphereDepth < farthestDepth;
+}
@@ -1,44 +1,203 @@
 #include <edbr/Graphics/ImageCache.h>
 
-#include <edbr/Graphics/GfxDevice.h>
+#include <algorithm>
+#include <cassert>
 
-ImageCache::ImageCache(GfxDevice& gfxDevice) : gfxDevice(gfxDevice)
+#include <edbr/Core/TaskQueue.h>
+#include <edbr/Graphics/Common.h>
+#include <edbr/Math/HashCombine.h>
+
+#include <tracy/Tracy.hpp>
+
+std::size_t ImageCache::LoadParamsHash::operator()(const LoadParams& p) const
+{
+    std::size_t seed = std::filesystem::hash_value(p.path);
+    math::hash_combine(seed, p.format);
+    math::hash_combine(seed, p.usage);
+    math::hash_combine(seed, p.mipMap);
+    math::hash_combine(seed, p.kind);
+    return seed;
+}
+
+ImageCache::ImageCache(Device device) : device(std::move(device))
 {}
 
+// decode tasks use the cache
+ImageCache::~ImageCache()
+{
+    waitForDecodes();
+}
+
 ImageId ImageCache::loadImageFromFile(
     const std::filesystem::path& path,
     VkFormat format,
     VkImageUsageFlags usage,
     bool mipMap)
 {
-    for (const auto& [id, info] : loadedImagesInfo) {
-        // TODO: calculate some hash to not have to linear search every time?
-        if (info.path == path && info.format == format && info.usage == usage &&
-            info.mipMap == mipMap) {
-            // std::cout << "Already loaded: " << path << std::endl;
-            return id;
+    auto params = LoadParams{
+        .path = path,
+        .format = format,
+        .usage = usage,
+        .mipMap = mipMap,
+    };
+    if (const auto it = loadedImages.find(params); it != loadedImages.end()) {
+        const auto id = it->second;
+        addRef(id);
+        if (imageInfos[id].pendingLoad) {
+            waitForLoads();
         }
+        return id;
     }
 
-    auto image = gfxDevice.loadImageFromFileRaw(path, format, usage, mipMap);
-    if (image.isInitialized() && image.getBindlessId() == errorImageId) {
+    auto decoded = device.decodeImage(params);
+    auto image = decoded ? device.createImage(params, std::move(*decoded)) : std::nullopt;
+    if (!image) {
+        if (errorImageId != NULL_IMAGE_ID) {
+            addRef(errorImageId);
+        }
         return errorImageId;
     }
 
+    const auto memorySize = device.getMemorySize(*image);
+    const auto id = addImage(std::move(*image));
+    auto& info = imageInfos[id];
+    info.memorySize = memorySize;
+    info.loadParams = params;
+    loadedImages.emplace(std::move(params), id);
+    loadedImagesMemory += memorySize;
+
+    evictUnusedImages();
+    return id;
+}
+
+std::vector<ImageId> ImageCache::loadImagesFromFiles(std::span<const LoadParams> params)
+{
+    std::vector<ImageId> ids;
+    ids.reserve(params.size());
+    for (const auto& p : params) {
+        if (const auto it = loadedImages.find(p); it != loadedImages.end()) {
+            addRef(it->second);
+            ids.push_back(it->second);
+            continue;
+        }
+
+        const auto id = reserveImageId(p);
+        ids.push_back(id);
+        auto decode = [this, id, loadIndex = *imageInfos[id].pendingLoad, p]() {
+            ZoneScopedN("Decode image");
+            auto image = device.decodeImage(p);
+            std::lock_guard lock{decodedImagesMutex};
+            decodedImages.push_back(
+                {.id = id, .loadIndex = loadIndex, .image = std::move(image)});
+            --numDecodingImages;
+            decodedImagesCV.notify_all();
+        };
+
+        {
+            std::lock_guard lock{decodedImagesMutex};
+            ++numDecodingImages;
+        }
+        if (decodeQueue) {
+            decodeQueue->push(std::move(decode));
+        } else {
+            decode();
+        }
+    }
+    return ids;
+}
+
+ImageId ImageCache::reserveImageId(const LoadParams& params)
+{
     const auto id = getFreeImageId();
-    addImage(id, std::move(image));
-
-    loadedImagesInfo.emplace(
-        id,
-        LoadedImageInfo{
-            .path = path,
-            .format = format,
-            .usage = usage,
-            .mipMap = mipMap,
-        });
+    if (id == images.size()) {
+        images.emplace_back();
+        imageInfos.emplace_back();
+    } else {
+        freeIds.pop_back();
+    }
+
+    imageInfos[id] = ImageInfo{
+        .refCount = 1,
+        .loadParams = params,
+        .pendingLoad = nextLoadIndex++,
+    };
+    loadedImages.emplace(params, id);
+    ++numLoadingImages;
+
+    if (errorImageId != NULL_IMAGE_ID) {
+        device.setBindlessImage(id, images[errorImageId]);
+    }
     return id;
 }
 
+void ImageCache::update()
+{
+    std::vector<DecodeResult> results;
+    {
+        std::lock_guard lock{decodedImagesMutex};
+        results.swap(decodedImages);
+    }
+    if (results.empty()) {
+        return;
+    }
+
+    ZoneScopedN("Create decoded images");
+    for (auto& result : results) {
+        finishLoad(std::move(result));
+    }
+}
+
+void ImageCache::waitForLoads()
+{
+    waitForDecodes();
+    update();
+}
+
+void ImageCache::waitForDecodes()
+{
+    // the queue can be busy with other tasks, so only the cache's tasks are waited for
+    std::unique_lock lock{decodedImagesMutex};
+    decodedImagesCV.wait(lock, [this]() { return numDecodingImages == 0; });
+}
+
+bool ImageCache::isImageLoading(ImageId id) const
+{
+    return imageInfos.at(id).pendingLoad.has_value();
+}
+
+void ImageCache::finishLoad(DecodeResult result)
+{
+    const auto id = result.id;
+    auto& info = imageInfos[id];
+    if (info.pendingLoad != result.loadIndex) {
+        return; // was destroyed while being decoded (and the id could be reused)
+    }
+    info.pendingLoad.reset();
+    --numLoadingImages;
+
+    auto image = result.image ? device.createImage(*info.loadParams, std::move(*result.image)) :
+                                std::nullopt;
+    if (!image) {
+        // the id keeps pointing at the error image, but can be loaded again
+        loadedImages.erase(*info.loadParams);
+        info.loadParams.reset();
+        if (info.lruIt) {
+            lru.erase(*info.lruIt);
+            info.lruIt.reset();
+            scheduleDestroy(id);
+        }
+        return;
+    }
+
+    info.memorySize = device.getMemorySize(*image);
+    loadedImagesMemory += info.memorySize;
+    image->setBindlessId(static_cast<std::uint32_t>(id));
+    images[id] = std::move(*image);
+    device.setBindlessImage(id, images[id]);
+
+    evictUnusedImages();
+}
+
 ImageId ImageCache::addImage(GPUImage image)
 {
     return addImage(getFreeImageId(), std::move(image));
@@ -46,32 +205,150 @@ ImageId ImageCache::addImage(GPUImage image)
 
 ImageId ImageCache::addImage(ImageId id, GPUImage image)
 {
+    assert(id <= images.size());
     image.setBindlessId(static_cast<std::uint32_t>(id));
-    if (id != images.size()) {
-        images[id] = std::move(image); // replacing existing image
-    } else {
+    if (id == images.size()) {
         images.push_back(std::move(image));
+        imageInfos.push_back(ImageInfo{.refCount = 1});
+    } else {
+        if (const auto it = std::find(freeIds.begin(), freeIds.end(), id); it != freeIds.end()) {
+            freeIds.erase(it);
+            imageInfos[id] = ImageInfo{.refCount = 1};
+        }
+        // otherwise the existing image is replaced and keeps its references
+        images[id] = std::move(image);
     }
-    bindlessSetManager.addImage(gfxDevice.getDevice(), id, image.imageView);
+    device.setBindlessImage(id, images[id]);
 
     return id;
 }
 
 const GPUImage& ImageCache::getImage(ImageId id) const
 {
-    return images.at(id);
+    const auto& image = images.at(id);
+    const auto& info = imageInfos[id];
+    const auto isAlive = info.refCount > 0 || info.lruIt.has_value();
+    if (!image.isInitialized() && isAlive && errorImageId != NULL_IMAGE_ID) {
+        return images.at(errorImageId); // still loading or failed to load
+    }
+    return image;
 }
 
 ImageId ImageCache::getFreeImageId() const
 {
-    return images.size();
+    return freeIds.empty() ? (ImageId)images.size() : freeIds.back();
+}
+
+void ImageCache::addRef(ImageId id)
+{
+    auto& info = imageInfos.at(id);
+    assert((info.refCount > 0 || info.lruIt) && "Image was already destroyed");
+    ++info.refCount;
+    if (info.lruIt) {
+        lru.erase(*info.lruIt);
+        info.lruIt.reset();
+    }
+}
+
+void ImageCache::releaseImage(ImageId id)
+{
+    auto& info = imageInfos.at(id);
+    assert(info.refCount > 0);
+    --info.refCount;
+    if (info.refCount > 0) {
+        return;
+    }
+
+    if (info.loadParams && memoryBudget) {
+        // keep it around in case it gets loaded again
+        lru.push_front(id);
+        info.lruIt = lru.begin();
+        evictUnusedImages();
+    } else {
+        scheduleDestroy(id);
+    }
+}
+
+std::uint32_t ImageCache::getRefCount(ImageId id) const
+{
+    return imageInfos.at(id).refCount;
+}
+
+void ImageCache::scheduleDestroy(ImageId id)
+{
+    auto& info = imageInfos[id];
+    if (info.loadParams) {
+        loadedImages.erase(*info.loadParams);
+        loadedImagesMemory -= info.memorySize;
+        info.loadParams.reset();
+    }
+    if (info.pendingLoad) {
+        info.pendingLoad.reset();
+        --numLoadingImages;
+    }
+    pendingDestroys.push_back({.id = id, .releaseFrame = frameNumber});
+}
+
+void ImageCache::beginFrame(std::uint64_t frameNumber)
+{
+    this->frameNumber = frameNumber;
+
+    // frame N has completed when frame N + FRAME_OVERLAP begins
+    std::erase_if(pendingDestroys, [this](const PendingDestroy& pd) {
+        if (this->frameNumber < pd.releaseFrame + graphics::FRAME_OVERLAP) {
+            return false;
+        }
+        if (images[pd.id].image != VK_NULL_HANDLE) { // not set if loading failed
+            device.destroyImage(images[pd.id]);
+        }
+        images[pd.id] = GPUImage{};
+        imageInfos[pd.id] = ImageInfo{};
+        freeIds.push_back(pd.id);
+        return true;
+    });
+}
+
+void ImageCache::setMemoryBudget(std::optional<std::size_t> budget)
+{
+    memoryBudget = budget;
+    if (!memoryBudget) {
+        // nothing is kept without a budget
+        while (!lru.empty()) {
+            const auto id = lru.back();
+            lru.pop_back();
+            imageInfos[id].lruIt.reset();
+            scheduleDestroy(id);
+        }
+    }
+    evictUnusedImages();
+}
+
+void ImageCache::evictUnusedImages()
+{
+    while (memoryBudget && loadedImagesMemory > *memoryBudget && !lru.empty()) {
+        const auto id = lru.back();
+        lru.pop_back();
+        imageInfos[id].lruIt.reset();
+        scheduleDestroy(id);
+    }
 }
 
 void ImageCache::destroyImages()
 {
+    waitForDecodes();
+    decodedImages.clear();
+    numLoadingImages = 0;
+
     for (const auto& image : images) {
-        gfxDevice.destroyImage(image);
+        if (image.image != VK_NULL_HANDLE) {
+            device.destroyImage(image);
+        }
     }
     images.clear();
-    loadedImagesInfo.clear();
+    imageInfos.clear();
+    loadedImages.clear();
+    freeIds.clear();
+    pendingDestroys.clear();
+    lru.clear();
+    loadedImagesMemory = 0;
 }
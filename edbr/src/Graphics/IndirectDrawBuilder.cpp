@@ -0,0 +1,166 @@
+#include <edbr/Graphics/IndirectDrawBuilder.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+namespace
+{
+bool canBeInstanced(const MeshDrawCommand& dc1, const MeshDrawCommand& dc2)
+{
+    // skinned meshes have their own vertex buffers, so they're never merged
+    return dc1.meshId == dc2.meshId && dc1.lod == dc2.lod && dc1.materialId == dc2.materialId &&
+           !dc1.skinnedMesh && !dc2.skinnedMesh;
+}
+}
+
+namespace graphics
+{
+IndirectDrawStats buildIndirectDrawCommands(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const std::uint32_t> visibleDrawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<VkDrawIndexedIndirectCommand>& indirectCommands,
+    std::vector<GPUMeshInstanceData>& instanceData,
+    std::size_t maxInstances)
+{
+    indirectCommands.clear();
+    instanceData.clear();
+
+    const auto numInstances = std::min(visibleDrawCommands.size(), maxInstances);
+    instanceData.reserve(numInstances);
+
+    std::size_t numIndex16Draws = 0;
+    for (const auto indexType : {VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32}) {
+        const MeshDrawCommand* prevDC = nullptr;
+        for (const auto dcIdx : visibleDrawCommands.first(numInstances)) {
+            const auto& dc = drawCommands[dcIdx];
+            assert(dc.meshId < meshes.size());
+            assert(dc.materialId != NULL_MATERIAL_ID);
+            const auto& mesh = meshes[dc.meshId];
+            if (mesh.indexType != indexType) {
+                continue;
+            }
+            assert(dc.lod < mesh.numLODs);
+            const auto& lod = mesh.lods[dc.lod];
+
+            if (prevDC && canBeInstanced(*prevDC, dc)) {
+                ++indirectCommands.back().instanceCount;
+            } else {
+                indirectCommands.push_back(VkDrawIndexedIndirectCommand{
+                    .indexCount = lod.numIndices,
+                    .instanceCount = 1,
+                    .firstIndex = lod.firstIndex,
+                    // indices are relative to the mesh's vertex buffer address
+                    .vertexOffset = 0,
+                    .firstInstance = (std::uint32_t)instanceData.size(),
+                });
+            }
+            prevDC = &dc;
+
+            instanceData.push_back(GPUMeshInstanceData{
+                .transform = dc.transformMatrix,
+                .worldBoundingSphere =
+                    glm::vec4{dc.worldBoundingSphere.center, dc.worldBoundingSphere.radius},
+                .vertexBuffer = dc.skinnedMesh ? dc.skinnedMesh->skinnedVertexBuffer.address :
+                                                 mesh.vertexBufferAddress,
+                .vertexFormat = dc.skinnedMesh ? VertexFormat::Full : mesh.vertexFormat,
+                .materialId = dc.materialId,
+                .drawIndex = (std::uint32_t)indirectCommands.size() - 1,
+            });
+        }
+        if (indexType == VK_INDEX_TYPE_UINT16) {
+            numIndex16Draws = indirectCommands.size();
+        }
+    }
+
+    return IndirectDrawStats{
+        .numDraws = indirectCommands.size(),
+        .numInstances = instanceData.size(),
+        .numIndex16Draws = numIndex16Draws,
+    };
+}
+
+bool canUseMeshletDraws(const MeshDrawCommand& dc, const GPUMesh& mesh)
+{
+    return dc.isStatic && !dc.skinnedMesh && dc.lod == 0 && mesh.numMeshlets > 0;
+}
+
+void splitMeshletDrawCommands(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<std::uint32_t>& visibleDrawCommands,
+    std::vector<std::uint32_t>& meshletDrawCommands,
+    std::size_t maxMeshletDraws)
+{
+    meshletDrawCommands.clear();
+
+    std::size_t numMeshletDraws = 0;
+    std::erase_if(visibleDrawCommands, [&](std::uint32_t dcIdx) {
+        const auto& dc = drawCommands[dcIdx];
+        const auto& mesh = meshes[dc.meshId];
+        if (!canUseMeshletDraws(dc, mesh) ||
+            numMeshletDraws + mesh.numMeshlets > maxMeshletDraws) {
+            return false;
+        }
+        numMeshletDraws += mesh.numMeshlets;
+        meshletDrawCommands.push_back(dcIdx);
+        return true;
+    });
+}
+
+MeshletDrawStats buildMeshletDraws(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const std::uint32_t> meshletDrawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<GPUMeshInstanceData>& instanceData,
+    std::vector<GPUMeshletDraw>& meshletDraws,
+    std::size_t maxInstances)
+{
+    meshletDraws.clear();
+
+    const auto firstInstance = instanceData.size();
+    std::size_t numIndex16Draws = 0;
+    for (const auto indexType : {VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32}) {
+        for (const auto dcIdx : meshletDrawCommands) {
+            const auto& dc = drawCommands[dcIdx];
+            assert(dc.meshId < meshes.size());
+            assert(dc.materialId != NULL_MATERIAL_ID);
+            const auto& mesh = meshes[dc.meshId];
+            assert(canUseMeshletDraws(dc, mesh));
+            if (mesh.indexType != indexType || instanceData.size() >= maxInstances) {
+                continue;
+            }
+
+            const auto instanceIndex = (std::uint32_t)instanceData.size();
+            instanceData.push_back(GPUMeshInstanceData{
+                .transform = dc.transformMatrix,
+                .worldBoundingSphere =
+                    glm::vec4{dc.worldBoundingSphere.center, dc.worldBoundingSphere.radius},
+                .vertexBuffer = mesh.vertexBufferAddress,
+                .vertexFormat = mesh.vertexFormat,
+                .materialId = dc.materialId,
+                // meshlet draws don't have per-instance commands
+                .drawIndex = std::numeric_limits<std::uint32_t>::max(),
+            });
+            for (std::uint32_t i = 0; i < mesh.numMeshlets; ++i) {
+                meshletDraws.push_back(GPUMeshletDraw{
+                    .instanceIndex = instanceIndex,
+                    .meshletIndex = mesh.firstMeshlet + i,
+                });
+            }
+        }
+        if (indexType == VK_INDEX_TYPE_UINT16) {
+            numIndex16Draws = meshletDraws.size();
+        }
+    }
+
+    return MeshletDrawStats{
+        .numDraws = meshletDraws.size(),
+        .numInstances = instanceData.size() - firstInstance,
+        .numIndex16Draws = numIndex16Draws,
+    };
+}
+}
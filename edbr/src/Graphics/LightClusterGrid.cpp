@@ -0,0 +1,201 @@
+#include <edbr/Graphics/LightClusterGrid.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/Light.h>
+
+namespace
+{
+bool sphereIntersectsAABB(const math::AABB& aabb, const glm::vec3& center, float radius)
+{
+    const auto closest = glm::clamp(center, aabb.min, aabb.max);
+    const auto d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+std::uint32_t uvToTile(float uv, std::uint32_t gridSize)
+{
+    const auto tile = (int)std::floor(uv * (float)gridSize);
+    return (std::uint32_t)std::clamp(tile, 0, (int)gridSize - 1);
+}
+}
+
+void LightClusterGrid::build(
+    const Camera& camera,
+    std::span<const GPULightData> lights,
+    std::size_t maxLightIndices)
+{
+    assert(!camera.isOrthographic());
+
+    const auto& proj = camera.getProjection();
+    if (proj != boundsProj || camera.getZNear() != zNear || camera.getZFar() != zFar) {
+        zNear = camera.getZNear();
+        zFar = camera.getZFar();
+        logZFarOverZNear = std::log(zFar / zNear);
+        calculateClusterBounds(proj);
+    }
+
+    clusterLights.clear();
+    clusters.assign(NUM_CLUSTERS, Cluster{});
+    numDroppedLightIndices = 0;
+
+    const auto view = camera.getView();
+    for (std::size_t i = 0; i < lights.size(); ++i) {
+        const auto& light = lights[i];
+        if (light.type == edbr::TYPE_DIRECTIONAL_LIGHT) {
+            continue;
+        }
+        const auto center = glm::vec3{view * glm::vec4{light.position, 1.f}};
+        addLight((std::uint32_t)i, center, light.range);
+    }
+
+    // counting sort of (cluster, light) pairs into per cluster lists
+    std::size_t numLightIndices = 0;
+    for (auto& cluster : clusters) {
+        const auto available = maxLightIndices - std::min(numLightIndices, maxLightIndices);
+        const auto count = std::min((std::size_t)cluster.count, available);
+        numDroppedLightIndices += cluster.count - count;
+        cluster.offset = (std::uint32_t)numLightIndices;
+        cluster.count = (std::uint32_t)count;
+        numLightIndices += count;
+    }
+
+    lightIndices.resize(numLightIndices);
+    clusterCursors.assign(NUM_CLUSTERS, 0);
+    for (const auto& [clusterIndex, lightIndex] : clusterLights) {
+        const auto& cluster = clusters[clusterIndex];
+        auto& cursor = clusterCursors[clusterIndex];
+        if (cursor < cluster.count) {
+            lightIndices[cluster.offset + cursor] = lightIndex;
+            ++cursor;
+        }
+    }
+}
+
+void LightClusterGrid::addLight(std::uint32_t lightIndex, const glm::vec3& center, float radius)
+{
+    const auto depth = -center.z;
+    if (depth + radius < zNear || depth - radius > zFar) {
+        return;
+    }
+
+    // part of the sphere's view space AABB in front of the near plane
+    const auto minDepth = std::max(depth - radius, zNear);
+    const auto maxDepth = std::min(depth + radius, zFar);
+    const auto minZ = getSlice(minDepth);
+    const auto maxZ = getSlice(maxDepth);
+
+    // project the box to find which tiles it covers - all of its corners
+    // are in front of the camera, so this works even if the camera is inside the sphere
+    auto uvMin = glm::vec2{std::numeric_limits<float>::max()};
+    auto uvMax = glm::vec2{std::numeric_limits<float>::lowest()};
+    for (int i = 0; i < 8; ++i) {
+        const auto corner = glm::vec3{
+            center.x + ((i & 1) ? radius : -radius),
+            center.y + ((i & 2) ? radius : -radius),
+            (i & 4) ? -minDepth : -maxDepth,
+        };
+        const auto clip = boundsProj * glm::vec4{corner, 1.f};
+        const auto uv = glm::vec2{clip.x, clip.y} / clip.w * 0.5f + 0.5f;
+        uvMin = glm::min(uvMin, uv);
+        uvMax = glm::max(uvMax, uv);
+    }
+    if (uvMax.x < 0.f || uvMax.y < 0.f || uvMin.x > 1.f || uvMin.y > 1.f) {
+        return; // off-screen
+    }
+    const auto minTile =
+        glm::uvec2{uvToTile(uvMin.x, GRID_SIZE_X), uvToTile(uvMin.y, GRID_SIZE_Y)};
+    const auto maxTile =
+        glm::uvec2{uvToTile(uvMax.x, GRID_SIZE_X), uvToTile(uvMax.y, GRID_SIZE_Y)};
+
+    for (auto z = minZ; z <= maxZ; ++z) {
+        for (auto y = minTile.y; y <= maxTile.y; ++y) {
+            for (auto x = minTile.x; x <= maxTile.x; ++x) {
+                const auto clusterIndex = getClusterIndex({x, y, z});
+                if (sphereIntersectsAABB(clusterBounds[clusterIndex], center, radius)) {
+                    clusterLights.push_back({clusterIndex, lightIndex});
+                    ++clusters[clusterIndex].count;
+                }
+            }
+        }
+    }
+}
+
+glm::uvec3 LightClusterGrid::findCluster(const glm::vec2& screenUV, float viewDepth) const
+{
+    return {
+        uvToTile(screenUV.x, GRID_SIZE_X),
+        uvToTile(screenUV.y, GRID_SIZE_Y),
+        getSlice(viewDepth),
+    };
+}
+
+std::uint32_t LightClusterGrid::getClusterIndex(const glm::uvec3& cluster)
+{
+    return (cluster.z * GRID_SIZE_Y + cluster.y) * GRID_SIZE_X + cluster.x;
+}
+
+std::span<const std::uint32_t> LightClusterGrid::getClusterLights(std::uint32_t clusterIndex) const
+{
+    assert(clusterIndex < clusters.size());
+    const auto& cluster = clusters[clusterIndex];
+    return std::span{lightIndices}.subspan(cluster.offset, cluster.count);
+}
+
+std::uint32_t LightClusterGrid::getSlice(float viewDepth) const
+{
+    if (viewDepth <= zNear) {
+        return 0;
+    }
+    const auto slice =
+        (int)std::floor(std::log(viewDepth / zNear) / logZFarOverZNear * GRID_SIZE_Z);
+    return (std::uint32_t)std::clamp(slice, 0, (int)GRID_SIZE_Z - 1);
+}
+
+float LightClusterGrid::getSliceDepth(std::uint32_t slice) const
+{
+    return zNear * std::pow(zFar / zNear, (float)slice / (float)GRID_SIZE_Z);
+}
+
+void LightClusterGrid::calculateClusterBounds(const glm::mat4& proj)
+{
+    boundsProj = proj;
+    clusterBounds.resize(NUM_CLUSTERS);
+
+    // for symmetric perspective projection: ndc.xy = (proj[0][0] * x, proj[1][1] * y) / depth
+    const auto toViewSpace = [&proj](const glm::vec2& uv, float depth) {
+        const auto ndc = uv * 2.f - 1.f;
+        return glm::vec3{ndc.x * depth / proj[0][0], ndc.y * depth / proj[1][1], -depth};
+    };
+
+    const auto tileSize = glm::vec2{1.f / GRID_SIZE_X, 1.f / GRID_SIZE_Y};
+    for (std::uint32_t z = 0; z < GRID_SIZE_Z; ++z) {
+        const auto depths = std::array{getSliceDepth(z), getSliceDepth(z + 1)};
+        for (std::uint32_t y = 0; y < GRID_SIZE_Y; ++y) {
+            for (std::uint32_t x = 0; x < GRID_SIZE_X; ++x) {
+                const auto uvMin = glm::vec2{(float)x, (float)y} * tileSize;
+                const auto uvMax = uvMin + tileSize;
+                auto bounds = math::AABB{
+                    .min = glm::vec3{std::numeric_limits<float>::max()},
+                    .max = glm::vec3{std::numeric_limits<float>::lowest()},
+                };
+                for (const auto depth : depths) {
+                    for (int i = 0; i < 4; ++i) {
+                        const auto uv = glm::vec2{
+                            (i & 1) ? uvMax.x : uvMin.x,
+                            (i & 2) ? uvMax.y : uvMin.y,
+                        };
+                        const auto p = toViewSpace(uv, depth);
+                        bounds.min = glm::min(bounds.min, p);
+                        bounds.max = glm::max(bounds.max, p);
+                    }
+                }
+                clusterBounds[getClusterIndex({x, y, z})] = bounds;
+            }
+        }
+    }
+}
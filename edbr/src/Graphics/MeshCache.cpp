@@ -2,103 +2,282 @@
 
 #include <edbr/Graphics/CPUMesh.h>
 #include <edbr/Graphics/GfxDevice.h>
+#include <edbr/Graphics/VertexQuantization.h>
 #include <edbr/Graphics/Vulkan/Util.h>
 #include <edbr/Math/Util.h>
 
+#include <algorithm>
+#include <cassert>
+
 MeshId MeshCache::addMesh(GfxDevice& gfxDevice, const CPUMesh& cpuMesh)
 {
-    auto gpuMesh = GPUMesh{
-        .numVertices = (std::uint32_t)cpuMesh.vertices.size(),
-        .numIndices = (std::uint32_t)cpuMesh.indices.size(),
+    auto mesh = MeshDataView{
+        .vertices = cpuMesh.vertices,
+        .indices = cpuMesh.indices,
+        .skinningData = cpuMesh.hasSkeleton ? std::span{cpuMesh.skinningData} :
+                                              std::span<const CPUMesh::SkinningData>{},
+        .meshlets = cpuMesh.meshlets,
         .minPos = cpuMesh.minPos,
         .maxPos = cpuMesh.maxPos,
-        .hasSkeleton = cpuMesh.hasSkeleton,
     };
+    for (const auto& lod : cpuMesh.lods) {
+        mesh.lods.push_back(MeshLODView{.indices = lod.indices, .error = lod.error});
+    }
+    return addMesh(gfxDevice, mesh);
+}
+
+MeshId MeshCache::addMesh(GfxDevice& gfxDevice, const MeshDataView& mesh)
+{
+    auto gpuMesh = GPUMesh{
+        .vertexFormat = vertexFormat,
+        .numVertices = (std::uint32_t)mesh.vertices.size(),
+        .numIndices = (std::uint32_t)mesh.indices.size(),
+        .minPos = mesh.minPos,
+        .maxPos = mesh.maxPos,
+        .hasSkeleton = !mesh.skinningData.empty(),
+    };
+    if (gpuMesh.vertexFormat == VertexFormat::Compact &&
+        !graphics::canUseCompactSkinningData(mesh.skinningData)) {
+        gpuMesh.vertexFormat = VertexFormat::Full;
+    }
 
-    std::vector<glm::vec3> positions(cpuMesh.vertices.size());
-    for (std::size_t i = 0; i < cpuMesh.vertices.size(); ++i) {
-        positions[i] = cpuMesh.vertices[i].position;
+    if (mesh.boundingSphere) {
+        gpuMesh.boundingSphere = *mesh.boundingSphere;
+    } else {
+        std::vector<glm::vec3> positions(mesh.vertices.size());
+        for (std::size_t i = 0; i < mesh.vertices.size(); ++i) {
+            positions[i] = mesh.vertices[i].position;
+        }
+        gpuMesh.boundingSphere = util::calculateBoundingSphere(positions);
     }
-    gpuMesh.boundingSphere = util::calculateBoundingSphere(positions);
 
-    uploadMesh(gfxDevice, cpuMesh, gpuMesh);
+    uploadMesh(gfxDevice, mesh, gpuMesh);
     const auto id = meshes.size();
     meshes.push_back(std::move(gpuMesh));
     return id;
 }
 
-void MeshCache::uploadMesh(GfxDevice& gfxDevice, const CPUMesh& cpuMesh, GPUMesh& gpuMesh) const
+namespace
 {
-    // create index buffer
-    const auto indexBufferSize = cpuMesh.indices.size() * sizeof(std::uint32_t);
-    gpuMesh.indexBuffer = gfxDevice.createBuffer(
-        indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
-
-    // create vertex buffer
-    const auto vertexBufferSize = cpuMesh.vertices.size() * sizeof(CPUMesh::Vertex);
-    gpuMesh.vertexBuffer = gfxDevice.createBuffer(
-        vertexBufferSize,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
-
-    const auto staging =
-        gfxDevice
-            .createBuffer(vertexBufferSize + indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-    // copy data
-    void* data = staging.info.pMappedData;
-    memcpy(data, cpuMesh.vertices.data(), vertexBufferSize);
-    memcpy((char*)data + vertexBufferSize, cpuMesh.indices.data(), indexBufferSize);
-
-    gfxDevice.immediateSubmit([&](VkCommandBuffer cmd) {
-        const auto vertexCopy = VkBufferCopy{
-            .srcOffset = 0,
-            .dstOffset = 0,
-            .size = vertexBufferSize,
-        };
-        vkCmdCopyBuffer(cmd, staging.buffer, gpuMesh.vertexBuffer.buffer, 1, &vertexCopy);
+constexpr auto VERTEX_BUFFER_USAGE =
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+    VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+constexpr auto INDEX_BUFFER_USAGE = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+constexpr auto MESHLET_BUFFER_USAGE =
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+    VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+// Creates a bigger buffer and copies the contents of the old one into it
+void reallocateBuffer(
+    GfxDevice& gfxDevice,
+    GPUBuffer& buffer,
+    std::size_t oldSize,
+    std::size_t newSize,
+    VkBufferUsageFlags usage,
+    const char* label)
+{
+    auto newBuffer = gfxDevice.createBuffer(newSize, usage);
+    vkutil::addDebugLabel(gfxDevice.getDevice(), newBuffer.buffer, label);
+
+    if (buffer.buffer != VK_NULL_HANDLE) {
+        // immediateSubmit flushes the upload queue first, so that queued
+        // copies into the old buffer are done before its contents are copied
+        gfxDevice.immediateSubmit([&](VkCommandBuffer cmd) {
+            const auto copy = VkBufferCopy{
+                .srcOffset = 0,
+                .dstOffset = 0,
+                .size = oldSize,
+            };
+            vkCmdCopyBuffer(cmd, buffer.buffer, newBuffer.buffer, 1, &copy);
+        });
+        // the old buffer might still be used by frames in flight
+        gfxDevice.waitIdle();
+        gfxDevice.destroyBuffer(buffer);
+    }
+    buffer = newBuffer;
+}
+}
+
+void MeshCache::growVertexBuffer(GfxDevice& gfxDevice, std::size_t minNumSlots)
+{
+    const auto oldCapacity = vertexAllocator.getCapacity();
+    auto newCapacity = std::max(oldCapacity * 2, INITIAL_NUM_VERTEX_SLOTS);
+    while (newCapacity - oldCapacity < minNumSlots) {
+        newCapacity *= 2;
+    }
+
+    reallocateBuffer(
+        gfxDevice,
+        vertexBuffer,
+        oldCapacity * VERTEX_SLOT_SIZE,
+        newCapacity * VERTEX_SLOT_SIZE,
+        VERTEX_BUFFER_USAGE,
+        "mesh vertices");
+    vertexAllocator.grow(newCapacity);
+    updateVertexBufferAddresses();
+}
+
+void MeshCache::growIndexBuffer(GfxDevice& gfxDevice, std::size_t minNumSlots)
+{
+    const auto oldCapacity = indexAllocator.getCapacity();
+    auto newCapacity = std::max(oldCapacity * 2, INITIAL_NUM_INDEX_SLOTS);
+    while (newCapacity - oldCapacity < minNumSlots) {
+        newCapacity *= 2;
+    }
+
+    reallocateBuffer(
+        gfxDevice,
+        indexBuffer,
+        oldCapacity * sizeof(std::uint32_t),
+        newCapacity * sizeof(std::uint32_t),
+        INDEX_BUFFER_USAGE,
+        "mesh indices");
+    indexAllocator.grow(newCapacity);
+}
+
+void MeshCache::uploadMeshlets(GfxDevice& gfxDevice, const MeshDataView& mesh, GPUMesh& gpuMesh)
+{
+    // skinned meshes get deformed, so meshlet bounds don't hold for them
+    if (mesh.meshlets.empty() || gpuMesh.hasSkeleton) {
+        return;
+    }
+
+    const auto firstMeshlet = meshlets.size();
+    const auto minCapacity = firstMeshlet + mesh.meshlets.size();
+    if (minCapacity > meshletBufferCapacity) {
+        auto newCapacity = std::max(meshletBufferCapacity * 2, INITIAL_NUM_MESHLETS);
+        while (newCapacity < minCapacity) {
+            newCapacity *= 2;
+        }
+        reallocateBuffer(
+            gfxDevice,
+            meshletBuffer,
+            meshletBufferCapacity * sizeof(Meshlet),
+            newCapacity * sizeof(Meshlet),
+            MESHLET_BUFFER_USAGE,
+            "meshlets");
+        meshletBufferCapacity = newCapacity;
+    }
+
+    for (const auto& meshlet : mesh.meshlets) {
+        auto& m = meshlets.emplace_back(meshlet);
+        m.firstIndex += gpuMesh.firstIndex;
+    }
+    gpuMesh.firstMeshlet = (std::uint32_t)firstMeshlet;
+    gpuMesh.numMeshlets = (std::uint32_t)mesh.meshlets.size();
+
+    gfxDevice.getUploadQueue().uploadBuffer(
+        meshletBuffer.buffer,
+        firstMeshlet * sizeof(Meshlet),
+        std::as_bytes(std::span{meshlets}.subspan(firstMeshlet)));
+}
+
+void MeshCache::updateVertexBufferAddresses()
+{
+    for (auto& mesh : meshes) {
+        mesh.vertexBufferAddress = vertexBuffer.address + mesh.vertexOffset * VERTEX_SLOT_SIZE;
+    }
+}
+
+void MeshCache::uploadMesh(GfxDevice& gfxDevice, const MeshDataView& mesh, GPUMesh& gpuMesh)
+{
+    const auto isCompact = gpuMesh.vertexFormat == VertexFormat::Compact;
+    auto vertexDataSize = mesh.vertices.size() * sizeof(CPUMesh::Vertex);
+    if (isCompact) {
+        vertexDataSize = sizeof(graphics::CompactVertexHeader) +
+                         mesh.vertices.size() * sizeof(graphics::CompactVertex);
+    }
+    const auto numVertexSlots = vertexDataSize / VERTEX_SLOT_SIZE;
 
-        const auto indexCopy = VkBufferCopy{
-            .srcOffset = vertexBufferSize,
-            .dstOffset = 0,
-            .size = indexBufferSize,
+    // sub-allocate from the shared buffers (growing them if needed)
+    auto vertexOffset = vertexAllocator.allocate(numVertexSlots);
+    if (!vertexOffset) {
+        growVertexBuffer(gfxDevice, numVertexSlots);
+        vertexOffset = vertexAllocator.allocate(numVertexSlots);
+    }
+    // LODs' indices follow the indices of the mesh
+    const auto numLODs = std::min(mesh.lods.size() + 1, GPUMesh::MAX_LODS);
+    std::vector<std::uint32_t> lodIndices;
+    auto indices = mesh.indices;
+    if (numLODs > 1) {
+        lodIndices.assign(mesh.indices.begin(), mesh.indices.end());
+        for (std::size_t i = 1; i < numLODs; ++i) {
+            const auto& lod = mesh.lods[i - 1];
+            lodIndices.insert(lodIndices.end(), lod.indices.begin(), lod.indices.end());
+        }
+        indices = lodIndices;
+    }
+
+    const auto use16BitIndices = mesh.vertices.size() <= MAX_NUM_VERTICES_16_BIT_INDICES;
+    const auto numIndexSlots = use16BitIndices ? (indices.size() + 1) / 2 : indices.size();
+    auto indexSlot = indexAllocator.allocate(numIndexSlots);
+    if (!indexSlot) {
+        growIndexBuffer(gfxDevice, numIndexSlots);
+        indexSlot = indexAllocator.allocate(numIndexSlots);
+    }
+    assert(vertexOffset.has_value() && indexSlot.has_value());
+
+    gpuMesh.vertexOffset = (std::uint32_t)*vertexOffset;
+    gpuMesh.indexType = use16BitIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    gpuMesh.firstIndex = (std::uint32_t)(use16BitIndices ? *indexSlot * 2 : *indexSlot);
+    gpuMesh.vertexBufferAddress = vertexBuffer.address + gpuMesh.vertexOffset * VERTEX_SLOT_SIZE;
+
+    gpuMesh.numLODs = (std::uint32_t)numLODs;
+    gpuMesh.lods[0] = GPUMesh::LOD{
+        .firstIndex = gpuMesh.firstIndex,
+        .numIndices = gpuMesh.numIndices,
+    };
+    for (std::size_t i = 1; i < numLODs; ++i) {
+        const auto& prev = gpuMesh.lods[i - 1];
+        gpuMesh.lods[i] = GPUMesh::LOD{
+            .firstIndex = prev.firstIndex + prev.numIndices,
+            .numIndices = (std::uint32_t)mesh.lods[i - 1].indices.size(),
+            .error = mesh.lods[i - 1].error,
         };
-        vkCmdCopyBuffer(cmd, staging.buffer, gpuMesh.indexBuffer.buffer, 1, &indexCopy);
-    });
+    }
 
-    gfxDevice.destroyBuffer(staging);
+    // compact data is copied into staging memory by the upload queue,
+    // so it only needs to live until the end of this function
+    auto compactMesh = graphics::CompactMeshData{};
+    auto vertexData = std::as_bytes(mesh.vertices);
+    auto skinningData = std::as_bytes(mesh.skinningData);
+    if (isCompact) {
+        compactMesh = graphics::encodeCompactMesh(mesh.vertices, mesh.skinningData);
+        vertexData = std::as_bytes(std::span{compactMesh.vertices});
+        skinningData = std::as_bytes(std::span{compactMesh.skinningData});
+    }
 
-    const auto vtxBufferName = cpuMesh.name + " (vtx)";
-    const auto idxBufferName = cpuMesh.name + " (idx)";
-    vkutil::
-        addDebugLabel(gfxDevice.getDevice(), gpuMesh.vertexBuffer.buffer, vtxBufferName.c_str());
-    vkutil::addDebugLabel(gfxDevice.getDevice(), gpuMesh.indexBuffer.buffer, idxBufferName.c_str());
+    auto& uploadQueue = gfxDevice.getUploadQueue();
+    auto vertexDataOffset = gpuMesh.vertexOffset * VERTEX_SLOT_SIZE;
+    if (isCompact) {
+        uploadQueue.uploadBuffer(
+            vertexBuffer.buffer,
+            vertexDataOffset,
+            std::as_bytes(std::span{&compactMesh.header, 1}));
+        vertexDataOffset += sizeof(graphics::CompactVertexHeader);
+    }
+    uploadQueue.uploadBuffer(vertexBuffer.buffer, vertexDataOffset, vertexData);
+
+    const auto indexDataOffset = *indexSlot * sizeof(std::uint32_t);
+    if (use16BitIndices) {
+        const auto indices16 = std::vector<std::uint16_t>(indices.begin(), indices.end());
+        uploadQueue.uploadBuffer(
+            indexBuffer.buffer, indexDataOffset, std::as_bytes(std::span{indices16}));
+    } else {
+        uploadQueue.uploadBuffer(indexBuffer.buffer, indexDataOffset, std::as_bytes(indices));
+    }
+
+    uploadMeshlets(gfxDevice, mesh, gpuMesh);
 
     if (gpuMesh.hasSkeleton) {
         // create skinning data buffer
-        const auto skinningDataSize = cpuMesh.vertices.size() * sizeof(CPUMesh::SkinningData);
         gpuMesh.skinningDataBuffer = gfxDevice.createBuffer(
-            skinningDataSize,
+            skinningData.size(),
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
-
-        const auto staging =
-            gfxDevice.createBuffer(skinningDataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-        // copy data
-        void* data = staging.info.pMappedData;
-        memcpy(data, cpuMesh.skinningData.data(), skinningDataSize);
-
-        gfxDevice.immediateSubmit([&](VkCommandBuffer cmd) {
-            const auto vertexCopy = VkBufferCopy{
-                .srcOffset = 0,
-                .dstOffset = 0,
-                .size = skinningDataSize,
-            };
-            vkCmdCopyBuffer(cmd, staging.buffer, gpuMesh.skinningDataBuffer.buffer, 1, &vertexCopy);
-        });
-
-        gfxDevice.destroyBuffer(staging);
+        uploadQueue.uploadBuffer(gpuMesh.skinningDataBuffer.buffer, 0, skinningData);
     }
 }
 
@@ -107,13 +286,26 @@ const GPUMesh& MeshCache::getMesh(MeshId id) const
     return meshes.at(id);
 }
 
+std::span<const Meshlet> MeshCache::getMeshlets(const GPUMesh& mesh) const
+{
+    return std::span{meshlets}.subspan(mesh.firstMeshlet, mesh.numMeshlets);
+}
+
 void MeshCache::cleanup(const GfxDevice& gfxDevice)
 {
     for (const auto& mesh : meshes) {
-        gfxDevice.destroyBuffer(mesh.indexBuffer);
-        gfxDevice.destroyBuffer(mesh.vertexBuffer);
         if (mesh.hasSkeleton) {
             gfxDevice.destroyBuffer(mesh.skinningDataBuffer);
         }
     }
+    meshes.clear();
+    meshlets.clear();
+
+    if (vertexBuffer.buffer != VK_NULL_HANDLE) {
+        gfxDevice.destroyBuffer(vertexBuffer);
+        gfxDevice.destroyBuffer(indexBuffer);
+    }
+    if (meshletBuffer.buffer != VK_NULL_HANDLE) {
+        gfxDevice.destroyBuffer(meshletBuffer);
+    }
 }
@@ -0,0 +1,268 @@
+#include <edbr/Graphics/MeshClustering.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Math/Util.h>
+
+namespace
+{
+constexpr auto NONE = std::numeric_limits<std::uint32_t>::max();
+
+// triangles which use each vertex
+struct VertexTriangles {
+    std::vector<std::uint32_t> offsets; // numVertices + 1
+    std::vector<std::uint32_t> triangles;
+
+    std::span<const std::uint32_t> get(std::uint32_t v) const
+    {
+        return std::span{triangles}.subspan(offsets[v], offsets[v + 1] - offsets[v]);
+    }
+};
+
+VertexTriangles buildVertexTriangles(
+    std::span<const std::uint32_t> indices,
+    std::size_t numVertices)
+{
+    VertexTriangles vt;
+    vt.offsets.assign(numVertices + 1, 0);
+    for (const auto v : indices) {
+        ++vt.offsets[v + 1];
+    }
+    for (std::size_t i = 1; i < vt.offsets.size(); ++i) {
+        vt.offsets[i] += vt.offsets[i - 1];
+    }
+
+    vt.triangles.resize(indices.size());
+    auto next = vt.offsets;
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        vt.triangles[next[indices[i]]++] = (std::uint32_t)(i / 3);
+    }
+    return vt;
+}
+
+void calculateMeshletBounds(
+    Meshlet& meshlet,
+    std::span<const std::uint32_t> indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    std::span<const glm::vec3> triangleNormals)
+{
+    const auto meshletIndices = indices.subspan(meshlet.firstIndex, meshlet.numIndices);
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(meshletIndices.size());
+    for (const auto v : meshletIndices) {
+        positions.push_back(vertices[v].position);
+    }
+    meshlet.boundingSphere = util::calculateBoundingSphere(positions);
+    meshlet.coneApex = meshlet.boundingSphere.center;
+
+    // degenerate triangles have zero normals and don't affect the cone
+    const auto firstTriangle = meshlet.firstIndex / 3;
+    const auto normals = triangleNormals.subspan(firstTriangle, meshlet.numIndices / 3);
+    auto axis = glm::vec3{};
+    for (const auto& n : normals) {
+        axis += n;
+    }
+    const auto axisLength = glm::length(axis);
+    if (axisLength < 1e-6f) {
+        return;
+    }
+    axis /= axisLength;
+
+    auto minDot = 1.f;
+    for (const auto& n : normals) {
+        if (n != glm::vec3{}) {
+            minDot = std::min(minDot, glm::dot(n, axis));
+        }
+    }
+    // the cone is wider than a hemisphere - the meshlet can always be seen
+    if (minDot <= 0.f) {
+        return;
+    }
+
+    // The apex is moved back along the axis until it's behind all triangle
+    // planes: a triangle is backfacing from p if p is behind its plane, and
+    // every point p which passes the cone test is behind the apex.
+    const auto& center = meshlet.boundingSphere.center;
+    auto maxT = std::numeric_limits<float>::lowest();
+    for (std::size_t i = 0; i < normals.size(); ++i) {
+        const auto& n = normals[i];
+        if (n == glm::vec3{}) {
+            continue;
+        }
+        const auto& p0 = vertices[meshletIndices[i * 3]].position;
+        maxT = std::max(maxT, glm::dot(center - p0, n) / glm::dot(axis, n));
+    }
+
+    meshlet.coneApex = center - axis * maxT;
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+}
+}
+
+namespace graphics
+{
+std::vector<Meshlet> buildMeshlets(
+    std::vector<std::uint32_t>& indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    const MeshletParams& params)
+{
+    assert(indices.size() % 3 == 0);
+    assert(params.maxVertices >= 3 && params.maxTriangles >= 1);
+
+    const auto numTriangles = indices.size() / 3;
+    std::vector<glm::vec3> centroids(numTriangles);
+    std::vector<glm::vec3> normals(numTriangles);
+    for (std::size_t t = 0; t < numTriangles; ++t) {
+        const auto& p0 = vertices[indices[t * 3 + 0]].position;
+        const auto& p1 = vertices[indices[t * 3 + 1]].position;
+        const auto& p2 = vertices[indices[t * 3 + 2]].position;
+        centroids[t] = (p0 + p1 + p2) / 3.f;
+        const auto n = glm::cross(p1 - p0, p2 - p0);
+        const auto area = glm::length(n);
+        normals[t] = area > 0.f ? n / area : glm::vec3{};
+    }
+
+    const auto vertexTriangles = buildVertexTriangles(indices, vertices.size());
+
+    std::vector<bool> emitted(numTriangles, false);
+    // index of the last meshlet which used the vertex / had the triangle as a candidate
+    std::vector<std::uint32_t> vertexMeshlet(vertices.size(), NONE);
+    std::vector<std::uint32_t> candidateMeshlet(numTriangles, NONE);
+
+    std::vector<Meshlet> meshlets;
+    std::vector<std::uint32_t> newIndices;
+    newIndices.reserve(indices.size());
+    std::vector<glm::vec3> newNormals;
+    newNormals.reserve(numTriangles);
+
+    std::vector<std::uint32_t> meshletTriangles;
+    std::vector<std::uint32_t> candidates;
+    std::vector<float> candidateDistances;
+
+    std::size_t seed = 0;
+    while (true) {
+        // new meshlets start from the first free triangle: triangles which
+        // are close in the index buffer are usually close in space too
+        while (seed < numTriangles && emitted[seed]) {
+            ++seed;
+        }
+        if (seed == numTriangles) {
+            break;
+        }
+
+        const auto meshletIndex = (std::uint32_t)meshlets.size();
+        meshletTriangles.clear();
+        candidates.clear();
+        std::size_t numMeshletVertices = 0;
+        auto centroidSum = glm::vec3{};
+        auto normalSum = glm::vec3{};
+
+        const auto countNewVertices = [&](std::uint32_t t) {
+            std::size_t count = 0;
+            for (std::size_t k = 0; k < 3; ++k) {
+                count += vertexMeshlet[indices[t * 3 + k]] != meshletIndex;
+            }
+            return count;
+        };
+        const auto addTriangle = [&](std::uint32_t t) {
+            emitted[t] = true;
+            meshletTriangles.push_back(t);
+            centroidSum += centroids[t];
+            normalSum += normals[t];
+            for (std::size_t k = 0; k < 3; ++k) {
+                const auto v = indices[t * 3 + k];
+                if (vertexMeshlet[v] == meshletIndex) {
+                    continue;
+                }
+                vertexMeshlet[v] = meshletIndex;
+                ++numMeshletVertices;
+                // triangles which share vertices with the meshlet can be added next
+                for (const auto adj : vertexTriangles.get(v)) {
+                    if (!emitted[adj] && candidateMeshlet[adj] != meshletIndex) {
+                        candidateMeshlet[adj] = meshletIndex;
+                        candidates.push_back(adj);
+                    }
+                }
+            }
+        };
+
+        addTriangle((std::uint32_t)seed);
+        while (meshletTriangles.size() < params.maxTriangles) {
+            const auto center = centroidSum / (float)meshletTriangles.size();
+            const auto normalLength = glm::length(normalSum);
+            const auto axis = normalLength > 0.f ? normalSum / normalLength : glm::vec3{};
+
+            // drop candidates which were added and find the farthest one
+            // (distances are normalized by it)
+            candidateDistances.clear();
+            auto maxDistance = 0.f;
+            std::erase_if(candidates, [&](std::uint32_t t) { return emitted[t]; });
+            for (const auto t : candidates) {
+                const auto distance = glm::length(centroids[t] - center);
+                candidateDistances.push_back(distance);
+                maxDistance = std::max(maxDistance, distance);
+            }
+
+            // Triangles which add fewer new vertices always go first (this
+            // keeps meshlets round), then the closest ones with the normals
+            // closest to the meshlet's average normal
+            auto best = NONE;
+            auto bestScore = std::numeric_limits<float>::max();
+            for (std::size_t i = 0; i < candidates.size(); ++i) {
+                const auto t = candidates[i];
+                const auto newVertices = countNewVertices(t);
+                if (numMeshletVertices + newVertices > params.maxVertices) {
+                    continue;
+                }
+                const auto distance =
+                    maxDistance > 0.f ? candidateDistances[i] / maxDistance : 0.f;
+                const auto spread = 1.f - glm::dot(axis, normals[t]); // [0, 2]
+                const auto score = (float)newVertices * 2.f +
+                                   (1.f - params.coneWeight) * distance +
+                                   params.coneWeight * spread * 0.5f;
+                if (score < bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+            if (best == NONE) {
+                break;
+            }
+            addTriangle(best);
+        }
+
+        auto meshlet = Meshlet{
+            .firstIndex = (std::uint32_t)newIndices.size(),
+            .numIndices = (std::uint32_t)meshletTriangles.size() * 3,
+        };
+        std::ranges::sort(meshletTriangles);
+        for (const auto t : meshletTriangles) {
+            newIndices.insert(newIndices.end(), &indices[t * 3], &indices[t * 3] + 3);
+            newNormals.push_back(normals[t]);
+        }
+        meshlets.push_back(meshlet);
+    }
+
+    indices = std::move(newIndices);
+    for (auto& meshlet : meshlets) {
+        calculateMeshletBounds(meshlet, indices, vertices, newNormals);
+    }
+
+    return meshlets;
+}
+
+void generateMeshlets(CPUMesh& mesh, const MeshletParams& params)
+{
+    mesh.meshlets.clear();
+    if (mesh.hasSkeleton || mesh.indices.size() / 3 < params.minTriangles) {
+        return;
+    }
+    mesh.meshlets = buildMeshlets(mesh.indices, mesh.vertices, params);
+}
+}
@@ -0,0 +1,116 @@
+#include <edbr/Graphics/MeshLODSelection.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+namespace
+{
+float getWorldScale(const MeshDrawCommand& dc, const GPUMesh& mesh)
+{
+    if (mesh.boundingSphere.radius <= 0.f) {
+        return 1.f;
+    }
+    return dc.worldBoundingSphere.radius / mesh.boundingSphere.radius;
+}
+}
+
+namespace graphics
+{
+float calculatePixelsPerUnit(
+    const Camera& camera,
+    float viewportHeight,
+    const math::Sphere& worldBoundingSphere)
+{
+    // proj[1][1] is 1 / tan(fovY / 2) for perspective cameras
+    // and 2 / height for orthographic ones
+    const auto projScale = std::abs(camera.getProjection()[1][1]);
+    if (camera.isOrthographic()) {
+        return viewportHeight * projScale * 0.5f;
+    }
+
+    // closest point of the sphere
+    const auto distance =
+        glm::length(worldBoundingSphere.center - camera.getPosition()) - worldBoundingSphere.radius;
+    return viewportHeight * projScale / (2.f * std::max(distance, camera.getZNear()));
+}
+
+std::uint32_t selectMeshLOD(
+    const GPUMesh& mesh,
+    float worldScale,
+    float pixelsPerUnit,
+    const LODSelectionParams& params,
+    std::optional<std::uint32_t> prevLOD)
+{
+    assert(mesh.numLODs >= 1 && mesh.numLODs <= GPUMesh::MAX_LODS);
+    if (mesh.numLODs == 1 || pixelsPerUnit <= 0.f) {
+        return 0;
+    }
+
+    // max error in mesh units
+    const auto threshold = params.maxScreenError * params.bias / (pixelsPerUnit * worldScale);
+    const auto coarsenThreshold = prevLOD ? threshold * (1.f - params.hysteresis) : threshold;
+
+    auto lod = std::min(prevLOD.value_or(0), mesh.numLODs - 1);
+    while (lod > 0 && mesh.lods[lod].error > threshold) {
+        --lod;
+    }
+    while (lod + 1 < mesh.numLODs && mesh.lods[lod + 1].error <= coarsenThreshold) {
+        ++lod;
+    }
+    return lod;
+}
+
+std::uint32_t selectDrawCommandLOD(
+    const MeshDrawCommand& dc,
+    const GPUMesh& mesh,
+    const Camera& camera,
+    float viewportHeight,
+    const LODSelectionParams& params)
+{
+    return selectMeshLOD(
+        mesh,
+        getWorldScale(dc, mesh),
+        calculatePixelsPerUnit(camera, viewportHeight, dc.worldBoundingSphere),
+        params);
+}
+
+void selectMeshLODs(
+    std::span<MeshDrawCommand> drawCommands,
+    std::span<const GPUMesh> meshes,
+    const Camera& camera,
+    float viewportHeight,
+    const LODSelectionParams& params,
+    MeshLODHistory& history)
+{
+    std::swap(history.entries, history.prevEntries);
+    history.entries.clear();
+    for (auto& dc : drawCommands) {
+        const auto& mesh = meshes[dc.meshId];
+
+        std::optional<std::uint32_t> prevLOD;
+        if (dc.drawId != NULL_DRAW_ID) {
+            const auto it = history.prevEntries.find(dc.drawId);
+            if (it != history.prevEntries.end() && it->second.meshId == dc.meshId) {
+                prevLOD = it->second.lod;
+            }
+        }
+        dc.lod = selectMeshLOD(
+            mesh,
+            getWorldScale(dc, mesh),
+            calculatePixelsPerUnit(camera, viewportHeight, dc.worldBoundingSphere),
+            params,
+            prevLOD);
+
+        if (dc.drawId != NULL_DRAW_ID) {
+            history.entries[dc.drawId] = MeshLODHistory::Entry{.meshId = dc.meshId, .lod = dc.lod};
+        }
+    }
+}
+}
@@ -0,0 +1,443 @@
+#include <edbr/Graphics/MeshOptimization.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+
+#include <glm/geometric.hpp>
+
+namespace
+{
+constexpr auto UNUSED_VERTEX = std::numeric_limits<std::uint32_t>::max();
+
+// FIFO cache simulation: a vertex is in the cache if it was one of the last
+// cacheSize vertices which were added to it
+class FIFOCacheSimulator {
+public:
+    FIFOCacheSimulator(std::size_t numVertices, std::size_t cacheSize) :
+        timestamps(numVertices, 0), cacheSize((std::uint32_t)cacheSize)
+    {
+        reset();
+    }
+
+    void reset() { time += cacheSize + 1; }
+
+    // returns the number of misses
+    std::uint32_t addTriangle(const std::uint32_t* tri)
+    {
+        std::uint32_t misses = 0;
+        for (int i = 0; i < 3; ++i) {
+            auto& ts = timestamps[tri[i]];
+            if (time - ts > cacheSize) {
+                ts = time++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+
+private:
+    std::vector<std::uint32_t> timestamps;
+    std::uint32_t cacheSize;
+    std::uint32_t time{0};
+};
+
+// Forsyth's scoring function
+constexpr std::size_t FORSYTH_CACHE_SIZE = 32;
+
+float getVertexScore(int cachePosition, std::uint32_t numRemainingTriangles)
+{
+    if (numRemainingTriangles == 0) {
+        return -1.f; // not needed anymore
+    }
+
+    float score = 0.f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // the last triangle's vertices get a fixed score, so that the
+            // next triangle doesn't always reuse them
+            score = 0.75f;
+        } else {
+            const auto t =
+                1.f - (float)(cachePosition - 3) / (float)(FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(t, 1.5f);
+        }
+    }
+    // boost vertices with few triangles left, so that lone triangles are finished
+    score += 2.f * std::pow((float)numRemainingTriangles, -0.5f);
+    return score;
+}
+
+struct Cluster {
+    std::size_t firstTriangle;
+    std::size_t numTriangles;
+    float sortKey;
+};
+
+std::size_t hashVertex(const CPUMesh& mesh, std::uint32_t i)
+{
+    auto hash = std::hash<std::string_view>{}(
+        std::string_view{(const char*)&mesh.vertices[i], sizeof(CPUMesh::Vertex)});
+    if (!mesh.skinningData.empty()) {
+        const auto skinningHash = std::hash<std::string_view>{}(std::string_view{
+            (const char*)&mesh.skinningData[i], sizeof(CPUMesh::SkinningData)});
+        hash ^= skinningHash + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+bool areVerticesEqual(const CPUMesh& mesh, std::uint32_t a, std::uint32_t b)
+{
+    if (std::memcmp(&mesh.vertices[a], &mesh.vertices[b], sizeof(CPUMesh::Vertex)) != 0) {
+        return false;
+    }
+    return mesh.skinningData.empty() ||
+           std::memcmp(
+               &mesh.skinningData[a], &mesh.skinningData[b], sizeof(CPUMesh::SkinningData)) ==
+               0;
+}
+
+void generateIndices(CPUMesh& mesh)
+{
+    mesh.indices.resize(mesh.vertices.size());
+    std::iota(mesh.indices.begin(), mesh.indices.end(), 0);
+}
+}
+
+namespace graphics
+{
+VertexCacheStats analyzeVertexCache(
+    std::span<const std::uint32_t> indices,
+    std::size_t numVertices,
+    std::size_t cacheSize)
+{
+    assert(indices.size() % 3 == 0);
+    if (indices.empty() || numVertices == 0) {
+        return {};
+    }
+
+    FIFOCacheSimulator cache(numVertices, cacheSize);
+    std::size_t numTransformed = 0;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        numTransformed += cache.addTriangle(&indices[i]);
+    }
+
+    return VertexCacheStats{
+        .numTransformedVertices = numTransformed,
+        .acmr = (float)numTransformed / (float)(indices.size() / 3),
+        .atvr = (float)numTransformed / (float)numVertices,
+    };
+}
+
+std::size_t deduplicateVertices(CPUMesh& mesh)
+{
+    if (mesh.indices.empty()) {
+        generateIndices(mesh);
+    }
+    const auto hasSkinningData = !mesh.skinningData.empty();
+    assert(!hasSkinningData || mesh.skinningData.size() == mesh.vertices.size());
+
+    const auto hash = [&mesh](std::uint32_t i) { return hashVertex(mesh, i); };
+    const auto equal = [&mesh](std::uint32_t a, std::uint32_t b) {
+        return areVerticesEqual(mesh, a, b);
+    };
+    // vertex index -> index of the same vertex in the deduplicated array
+    std::unordered_map<std::uint32_t, std::uint32_t, decltype(hash), decltype(equal)>
+        uniqueVertices(mesh.vertices.size(), hash, equal);
+
+    std::vector<std::uint32_t> remap(mesh.vertices.size());
+    std::vector<CPUMesh::Vertex> vertices;
+    std::vector<CPUMesh::SkinningData> skinningData;
+    vertices.reserve(mesh.vertices.size());
+    for (std::uint32_t i = 0; i < (std::uint32_t)mesh.vertices.size(); ++i) {
+        const auto [it, inserted] = uniqueVertices.try_emplace(i, (std::uint32_t)vertices.size());
+        if (inserted) {
+            vertices.push_back(mesh.vertices[i]);
+            if (hasSkinningData) {
+                skinningData.push_back(mesh.skinningData[i]);
+            }
+        }
+        remap[i] = it->second;
+    }
+
+    for (auto& index : mesh.indices) {
+        index = remap[index];
+    }
+
+    const auto numRemoved = mesh.vertices.size() - vertices.size();
+    mesh.vertices = std::move(vertices);
+    if (hasSkinningData) {
+        mesh.skinningData = std::move(skinningData);
+    }
+    return numRemoved;
+}
+
+void optimizeVertexCache(std::span<std::uint32_t> indices, std::size_t numVertices)
+{
+    assert(indices.size() % 3 == 0);
+    const auto numTriangles = indices.size() / 3;
+    if (numTriangles == 0) {
+        return;
+    }
+
+    // triangles which use each vertex (CSR), only live ones are kept in the
+    // first numRemainingTriangles[v] entries
+    std::vector<std::uint32_t> numRemainingTriangles(numVertices, 0);
+    for (const auto index : indices) {
+        ++numRemainingTriangles[index];
+    }
+    std::vector<std::uint32_t> adjacencyOffsets(numVertices + 1, 0);
+    for (std::size_t v = 0; v < numVertices; ++v) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + numRemainingTriangles[v];
+    }
+    std::vector<std::uint32_t> adjacency(indices.size());
+    {
+        auto fill = adjacencyOffsets;
+        for (std::size_t i = 0; i < indices.size(); ++i) {
+            adjacency[fill[indices[i]]++] = (std::uint32_t)(i / 3);
+        }
+    }
+
+    std::vector<float> vertexScores(numVertices);
+    for (std::size_t v = 0; v < numVertices; ++v) {
+        vertexScores[v] = getVertexScore(-1, numRemainingTriangles[v]);
+    }
+
+    const auto getTriangleScore = [&indices, &vertexScores](std::size_t t) {
+        return vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+               vertexScores[indices[t * 3 + 2]];
+    };
+    std::vector<bool> emitted(numTriangles, false);
+
+    std::vector<std::uint32_t> output;
+    output.reserve(indices.size());
+
+    std::vector<std::uint32_t> cache;
+    std::vector<std::uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    std::size_t bestTriangle = 0;
+    for (std::size_t t = 1; t < numTriangles; ++t) {
+        if (getTriangleScore(t) > getTriangleScore(bestTriangle)) {
+            bestTriangle = t;
+        }
+    }
+    std::size_t fallbackCursor = 0;
+
+    while (output.size() < indices.size()) {
+        const auto* tri = &indices[bestTriangle * 3];
+        output.insert(output.end(), tri, tri + 3);
+        emitted[bestTriangle] = true;
+
+        // remove the triangle from its vertices' adjacency
+        for (int i = 0; i < 3; ++i) {
+            const auto v = tri[i];
+            auto* begin = &adjacency[adjacencyOffsets[v]];
+            auto* end = begin + numRemainingTriangles[v];
+            auto* it = std::find(begin, end, (std::uint32_t)bestTriangle);
+            assert(it != end);
+            std::swap(*it, *(end - 1));
+            --numRemainingTriangles[v];
+        }
+
+        // move the triangle's vertices to the front of the LRU cache
+        newCache.assign(tri, tri + 3);
+        for (const auto v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache.push_back(v);
+            }
+        }
+        for (std::size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); ++i) {
+            // evicted
+            vertexScores[newCache[i]] = getVertexScore(-1, numRemainingTriangles[newCache[i]]);
+        }
+        newCache.resize(std::min(newCache.size(), FORSYTH_CACHE_SIZE));
+        std::swap(cache, newCache);
+
+        // rescore triangles of the cached vertices and pick the best one
+        for (std::size_t i = 0; i < cache.size(); ++i) {
+            vertexScores[cache[i]] = getVertexScore((int)i, numRemainingTriangles[cache[i]]);
+        }
+        auto bestScore = -1.f;
+        auto found = false;
+        for (const auto v : cache) {
+            const auto* begin = &adjacency[adjacencyOffsets[v]];
+            for (std::uint32_t j = 0; j < numRemainingTriangles[v]; ++j) {
+                const auto t = begin[j];
+                const auto score = getTriangleScore(t);
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                    found = true;
+                }
+            }
+        }
+
+        if (!found && output.size() < indices.size()) {
+            // nothing left around the cache: continue from the first triangle
+            // which wasn't emitted yet
+            while (emitted[fallbackCursor]) {
+                ++fallbackCursor;
+            }
+            bestTriangle = fallbackCursor;
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimizeOverdraw(
+    std::span<std::uint32_t> indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    float threshold)
+{
+    assert(indices.size() % 3 == 0);
+    const auto numTriangles = indices.size() / 3;
+    if (numTriangles < 2) {
+        return;
+    }
+    static constexpr std::size_t CACHE_SIZE = 16;
+
+    // hard boundaries: triangles where the cache optimizer had to start over
+    std::vector<std::size_t> hardBoundaries;
+    {
+        FIFOCacheSimulator cache(vertices.size(), CACHE_SIZE);
+        for (std::size_t t = 0; t < numTriangles; ++t) {
+            if (cache.addTriangle(&indices[t * 3]) == 3 || t == 0) {
+                hardBoundaries.push_back(t);
+            }
+        }
+        hardBoundaries.push_back(numTriangles);
+    }
+
+    // soft boundaries: split hard clusters where the cache efficiency of the
+    // part so far is close enough to the efficiency of the whole cluster
+    std::vector<Cluster> clusters;
+    FIFOCacheSimulator cache(vertices.size(), CACHE_SIZE);
+    for (std::size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+        const auto begin = hardBoundaries[h];
+        const auto end = hardBoundaries[h + 1];
+
+        cache.reset();
+        std::size_t clusterMisses = 0;
+        for (std::size_t t = begin; t < end; ++t) {
+            clusterMisses += cache.addTriangle(&indices[t * 3]);
+        }
+        const auto maxACMR = (float)clusterMisses / (float)(end - begin) * threshold;
+
+        cache.reset();
+        auto start = begin;
+        std::size_t misses = 0;
+        for (std::size_t t = begin; t < end; ++t) {
+            misses += cache.addTriangle(&indices[t * 3]);
+            if (t + 1 < end && (float)misses / (float)(t - start + 1) <= maxACMR) {
+                clusters.push_back({.firstTriangle = start, .numTriangles = t - start + 1});
+                start = t + 1;
+                misses = 0;
+                cache.reset();
+            }
+        }
+        clusters.push_back({.firstTriangle = start, .numTriangles = end - start});
+    }
+
+    // sort clusters which face away from the mesh's center first
+    glm::vec3 meshCentroid{};
+    float meshArea = 0.f;
+    std::vector<glm::vec3> clusterCentroids(clusters.size());
+    std::vector<glm::vec3> clusterNormals(clusters.size());
+    for (std::size_t c = 0; c < clusters.size(); ++c) {
+        glm::vec3 centroid{};
+        glm::vec3 normal{};
+        float area = 0.f;
+        for (std::size_t t = clusters[c].firstTriangle;
+             t < clusters[c].firstTriangle + clusters[c].numTriangles;
+             ++t) {
+            const auto& p0 = vertices[indices[t * 3]].position;
+            const auto& p1 = vertices[indices[t * 3 + 1]].position;
+            const auto& p2 = vertices[indices[t * 3 + 2]].position;
+            const auto n = glm::cross(p1 - p0, p2 - p0); // length = 2 * area
+            const auto triArea = glm::length(n) * 0.5f;
+            centroid += (p0 + p1 + p2) / 3.f * triArea;
+            normal += n;
+            area += triArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        clusterCentroids[c] = area > 0.f ? centroid / area : vertices[indices[0]].position;
+        const auto normalLength = glm::length(normal);
+        clusterNormals[c] = normalLength > 0.f ? normal / normalLength : glm::vec3{};
+    }
+    if (meshArea > 0.f) {
+        meshCentroid /= meshArea;
+    }
+    for (std::size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].sortKey = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const auto& a, const auto& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<std::uint32_t> output;
+    output.reserve(indices.size());
+    for (const auto& cluster : clusters) {
+        const auto* first = &indices[cluster.firstTriangle * 3];
+        output.insert(output.end(), first, first + cluster.numTriangles * 3);
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimizeVertexFetch(CPUMesh& mesh)
+{
+    const auto hasSkinningData = !mesh.skinningData.empty();
+
+    std::vector<std::uint32_t> remap(mesh.vertices.size(), UNUSED_VERTEX);
+    std::uint32_t numUsedVertices = 0;
+    for (auto& index : mesh.indices) {
+        if (remap[index] == UNUSED_VERTEX) {
+            remap[index] = numUsedVertices++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<CPUMesh::Vertex> vertices(numUsedVertices);
+    std::vector<CPUMesh::SkinningData> skinningData(hasSkinningData ? numUsedVertices : 0);
+    for (std::size_t i = 0; i < remap.size(); ++i) {
+        if (remap[i] == UNUSED_VERTEX) {
+            continue;
+        }
+        vertices[remap[i]] = mesh.vertices[i];
+        if (hasSkinningData) {
+            skinningData[remap[i]] = mesh.skinningData[i];
+        }
+    }
+    mesh.vertices = std::move(vertices);
+    mesh.skinningData = std::move(skinningData);
+}
+
+MeshOptimizationStats optimizeMesh(CPUMesh& mesh)
+{
+    if (mesh.indices.empty()) {
+        generateIndices(mesh);
+    }
+
+    auto stats = MeshOptimizationStats{
+        .numVerticesBefore = mesh.vertices.size(),
+        .cacheBefore = analyzeVertexCache(mesh.indices, mesh.vertices.size()),
+    };
+
+    deduplicateVertices(mesh);
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    optimizeOverdraw(mesh.indices, mesh.vertices);
+    optimizeVertexFetch(mesh);
+
+    stats.numVerticesAfter = mesh.vertices.size();
+    stats.cacheAfter = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    return stats;
+}
+}
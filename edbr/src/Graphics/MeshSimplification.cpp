@@ -0,0 +1,530 @@
+#include <edbr/Graphics/MeshSimplification.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/MeshOptimization.h>
+#include <edbr/Math/Util.h>
+
+namespace
+{
+// border edges are kept in place by planes which are perpendicular to
+// their triangles, weighted by this much more than the triangles themselves
+constexpr double BORDER_WEIGHT = 10.0;
+// LOD chain ends when the simplifier can't remove at least this many triangles
+constexpr float MIN_LOD_REDUCTION = 0.1f;
+
+// Sum of squared distances to a set of planes (symmetric 4x4 matrix).
+// Planes are weighted (by area) and the weight is accumulated too, so that
+// the error is the average squared distance
+struct Quadric {
+    double a2{0}, ab{0}, ac{0}, ad{0};
+    double b2{0}, bc{0}, bd{0};
+    double c2{0}, cd{0};
+    double d2{0};
+    double weight{0};
+
+    // plane: dot(n, p) + d = 0, n is normalized
+    void addPlane(const glm::dvec3& n, double d, double w)
+    {
+        a2 += w * n.x * n.x;
+        ab += w * n.x * n.y;
+        ac += w * n.x * n.z;
+        ad += w * n.x * d;
+        b2 += w * n.y * n.y;
+        bc += w * n.y * n.z;
+        bd += w * n.y * d;
+        c2 += w * n.z * n.z;
+        cd += w * n.z * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& o)
+    {
+        a2 += o.a2;
+        ab += o.ab;
+        ac += o.ac;
+        ad += o.ad;
+        b2 += o.b2;
+        bc += o.bc;
+        bd += o.bd;
+        c2 += o.c2;
+        cd += o.cd;
+        d2 += o.d2;
+        weight += o.weight;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const auto err = a2 * x * x + b2 * y * y + c2 * z * z +
+                         2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+                         2.0 * (ad * x + bd * y + cd * z) + d2;
+        // can be slightly negative because of rounding
+        return weight > 0.0 ? std::max(err, 0.0) / weight : 0.0;
+    }
+};
+
+enum class VertexKind : std::uint8_t {
+    Manifold, // can be collapsed into any neighbour
+    Border, // can only be collapsed along the border
+    Locked, // attribute seam or non-manifold - never moved
+};
+
+struct PositionKey {
+    std::uint32_t x, y, z;
+    bool operator==(const PositionKey&) const = default;
+};
+
+struct PositionKeyHash {
+    std::size_t operator()(const PositionKey& k) const
+    {
+        return (std::size_t)k.x * 73856093u ^ (std::size_t)k.y * 19349663u ^
+               (std::size_t)k.z * 83492791u;
+    }
+};
+
+std::uint64_t makeEdgeKey(std::uint32_t a, std::uint32_t b)
+{
+    return ((std::uint64_t)std::min(a, b) << 32) | std::max(a, b);
+}
+
+// Vertices are identified by their position (see positionIds) for
+// topology: vertices on attribute seams are split in the index buffer,
+// but their triangles are still connected
+class Simplifier {
+public:
+    Simplifier(std::span<const std::uint32_t> indices, std::span<const CPUMesh::Vertex> vertices);
+
+    // continues from the result of the previous call
+    void simplify(std::size_t targetIndexCount, float maxError);
+
+    std::vector<std::uint32_t> getIndices() const;
+    float getError() const { return (float)std::sqrt(maxCollapseError); }
+
+private:
+    struct Collapse {
+        double error;
+        std::uint32_t from; // vertex (its position is only used by it)
+        std::uint32_t to; // vertex
+
+        bool operator>(const Collapse& o) const { return error > o.error; }
+    };
+
+    const glm::vec3& getPosition(std::uint32_t v) const { return vertices[v].position; }
+    bool hasPosition(std::uint32_t triangle, std::uint32_t positionId) const;
+    double getCollapseError(std::uint32_t from, std::uint32_t to) const;
+    void pushCollapse(std::uint32_t from, std::uint32_t to);
+    bool canCollapse(std::uint32_t from, std::uint32_t to) const;
+    void collapse(std::uint32_t from, std::uint32_t to);
+
+    std::span<const CPUMesh::Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+    std::vector<bool> triangleRemoved;
+    std::size_t numTriangles{0};
+
+    // vertex -> first vertex with the same position
+    std::vector<std::uint32_t> positionIds;
+    // indexed by position id
+    std::vector<VertexKind> kinds;
+    std::vector<Quadric> quadrics;
+    std::vector<std::vector<std::uint32_t>> positionTriangles;
+    std::vector<bool> collapsed;
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+    double maxCollapseError{0.0}; // squared
+};
+
+Simplifier::Simplifier(
+    std::span<const std::uint32_t> indices,
+    std::span<const CPUMesh::Vertex> vertices) :
+    vertices(vertices), indices(indices.begin(), indices.end())
+{
+    assert(indices.size() % 3 == 0);
+    const auto numVertices = vertices.size();
+
+    // unused vertices don't take part in position deduplication - otherwise
+    // they could become the position ids of used vertices
+    std::vector<bool> isUsed(numVertices, false);
+    for (const auto v : indices) {
+        isUsed[v] = true;
+    }
+
+    positionIds.resize(numVertices);
+    std::vector<std::uint32_t> numVerticesAtPosition(numVertices, 0);
+    {
+        std::unordered_map<PositionKey, std::uint32_t, PositionKeyHash> firstVertex;
+        firstVertex.reserve(numVertices);
+        for (std::uint32_t v = 0; v < (std::uint32_t)numVertices; ++v) {
+            positionIds[v] = v;
+            if (!isUsed[v]) {
+                continue;
+            }
+            // + 0.f turns -0.f into 0.f
+            const auto p = getPosition(v) + 0.f;
+            const auto key = PositionKey{
+                std::bit_cast<std::uint32_t>(p.x),
+                std::bit_cast<std::uint32_t>(p.y),
+                std::bit_cast<std::uint32_t>(p.z),
+            };
+            positionIds[v] = firstVertex.try_emplace(key, v).first->second;
+            ++numVerticesAtPosition[positionIds[v]];
+        }
+    }
+
+    // degenerate triangles are dropped right away
+    const auto numInputTriangles = this->indices.size() / 3;
+    triangleRemoved.resize(numInputTriangles, false);
+    positionTriangles.resize(numVertices);
+    std::unordered_map<std::uint64_t, std::uint32_t> edgeCounts;
+    for (std::uint32_t t = 0; t < (std::uint32_t)numInputTriangles; ++t) {
+        const auto* tri = &this->indices[t * 3];
+        const auto p0 = positionIds[tri[0]];
+        const auto p1 = positionIds[tri[1]];
+        const auto p2 = positionIds[tri[2]];
+        if (p0 == p1 || p1 == p2 || p0 == p2) {
+            triangleRemoved[t] = true;
+            continue;
+        }
+        ++numTriangles;
+        for (int i = 0; i < 3; ++i) {
+            const auto v = tri[i];
+            positionTriangles[positionIds[v]].push_back(t);
+            ++edgeCounts[makeEdgeKey(positionIds[v], positionIds[tri[(i + 1) % 3]])];
+        }
+    }
+
+    kinds.resize(numVertices, VertexKind::Manifold);
+    std::vector<std::uint32_t> numBorderEdges(numVertices, 0);
+    for (const auto& [key, count] : edgeCounts) {
+        const auto a = (std::uint32_t)(key >> 32);
+        const auto b = (std::uint32_t)(key & 0xFFFFFFFF);
+        if (count == 1) {
+            ++numBorderEdges[a];
+            ++numBorderEdges[b];
+        } else if (count > 2) {
+            kinds[a] = VertexKind::Locked;
+            kinds[b] = VertexKind::Locked;
+        }
+    }
+    for (std::size_t p = 0; p < numVertices; ++p) {
+        if (numVerticesAtPosition[p] > 1) {
+            kinds[p] = VertexKind::Locked;
+        } else if (numBorderEdges[p] != 0 && kinds[p] != VertexKind::Locked) {
+            // border vertices which are shared by several borders are corners
+            kinds[p] = numBorderEdges[p] == 2 ? VertexKind::Border : VertexKind::Locked;
+        }
+    }
+
+    // quadrics of triangle planes and border planes
+    quadrics.resize(numVertices);
+    for (std::uint32_t t = 0; t < (std::uint32_t)numInputTriangles; ++t) {
+        if (triangleRemoved[t]) {
+            continue;
+        }
+        const auto* tri = &this->indices[t * 3];
+        const auto p0 = glm::dvec3{getPosition(tri[0])};
+        const auto p1 = glm::dvec3{getPosition(tri[1])};
+        const auto p2 = glm::dvec3{getPosition(tri[2])};
+        const auto normal = glm::cross(p1 - p0, p2 - p0);
+        const auto doubleArea = glm::length(normal);
+        if (doubleArea == 0.0) {
+            continue;
+        }
+        const auto n = normal / doubleArea;
+        Quadric q;
+        q.addPlane(n, -glm::dot(n, p0), doubleArea * 0.5);
+        for (int i = 0; i < 3; ++i) {
+            quadrics[positionIds[tri[i]]] += q;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            const auto a = tri[i];
+            const auto b = tri[(i + 1) % 3];
+            if (edgeCounts[makeEdgeKey(positionIds[a], positionIds[b])] != 1) {
+                continue;
+            }
+            const auto pa = glm::dvec3{getPosition(a)};
+            const auto edge = glm::dvec3{getPosition(b)} - pa;
+            const auto edgeLength2 = glm::dot(edge, edge);
+            const auto borderNormal = glm::normalize(glm::cross(edge, n));
+            Quadric bq;
+            bq.addPlane(borderNormal, -glm::dot(borderNormal, pa), edgeLength2 * BORDER_WEIGHT);
+            quadrics[positionIds[a]] += bq;
+            quadrics[positionIds[b]] += bq;
+        }
+    }
+
+    collapsed.resize(numVertices, false);
+    for (std::uint32_t t = 0; t < (std::uint32_t)numInputTriangles; ++t) {
+        if (triangleRemoved[t]) {
+            continue;
+        }
+        const auto* tri = &this->indices[t * 3];
+        for (int i = 0; i < 3; ++i) {
+            pushCollapse(tri[i], tri[(i + 1) % 3]);
+            pushCollapse(tri[(i + 1) % 3], tri[i]);
+        }
+    }
+}
+
+bool Simplifier::hasPosition(std::uint32_t triangle, std::uint32_t positionId) const
+{
+    const auto* tri = &indices[triangle * 3];
+    return positionIds[tri[0]] == positionId || positionIds[tri[1]] == positionId ||
+           positionIds[tri[2]] == positionId;
+}
+
+double Simplifier::getCollapseError(std::uint32_t from, std::uint32_t to) const
+{
+    auto q = quadrics[from];
+    q += quadrics[positionIds[to]];
+    return q.evaluate(getPosition(to));
+}
+
+void Simplifier::pushCollapse(std::uint32_t from, std::uint32_t to)
+{
+    // only vertices which don't share their position with other vertices
+    // can be moved (so position id == vertex index)
+    if (kinds[positionIds[from]] == VertexKind::Locked) {
+        return;
+    }
+    assert(positionIds[from] == from);
+    queue.push(Collapse{.error = getCollapseError(from, to), .from = from, .to = to});
+}
+
+bool Simplifier::canCollapse(std::uint32_t from, std::uint32_t to) const
+{
+    const auto toPos = positionIds[to];
+
+    // triangles which share the edge are removed by the collapse - all of
+    // them should have the same target vertex, otherwise the target is on
+    // a seam which goes through the edge
+    std::size_t numShared = 0;
+    for (const auto t : positionTriangles[from]) {
+        if (triangleRemoved[t] || !hasPosition(t, toPos)) {
+            continue;
+        }
+        const auto* tri = &indices[t * 3];
+        if (tri[0] != to && tri[1] != to && tri[2] != to) {
+            return false;
+        }
+        ++numShared;
+    }
+    const auto expectedShared = kinds[from] == VertexKind::Border ? 1 : 2;
+    if (numShared != (std::size_t)expectedShared) {
+        // not an edge anymore or border vertex which would leave the border
+        return false;
+    }
+
+    // link condition: the edge's vertices can only have the shared
+    // triangles' third vertices as common neighbours, otherwise the collapse
+    // makes the mesh non-manifold
+    const auto getNeighbours = [this](std::uint32_t positionId) {
+        std::vector<std::uint32_t> neighbours;
+        for (const auto t : positionTriangles[positionId]) {
+            if (triangleRemoved[t]) {
+                continue;
+            }
+            for (int i = 0; i < 3; ++i) {
+                const auto p = positionIds[indices[t * 3 + i]];
+                if (p != positionId) {
+                    neighbours.push_back(p);
+                }
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        return neighbours;
+    };
+    const auto fromNeighbours = getNeighbours(from);
+    const auto toNeighbours = getNeighbours(toPos);
+    std::size_t numCommon = 0;
+    for (const auto p : fromNeighbours) {
+        if (std::binary_search(toNeighbours.begin(), toNeighbours.end(), p)) {
+            ++numCommon;
+        }
+    }
+    if (numCommon != numShared) {
+        return false;
+    }
+
+    // triangles which stay shouldn't flip or rotate too much
+    const auto& newPos = getPosition(to);
+    for (const auto t : positionTriangles[from]) {
+        if (triangleRemoved[t] || hasPosition(t, toPos)) {
+            continue;
+        }
+        const auto* tri = &indices[t * 3];
+        std::array<glm::vec3, 3> ps;
+        for (int i = 0; i < 3; ++i) {
+            ps[i] = getPosition(tri[i]);
+        }
+        const auto oldNormal = glm::cross(ps[1] - ps[0], ps[2] - ps[0]);
+        for (int i = 0; i < 3; ++i) {
+            if (tri[i] == from) {
+                ps[i] = newPos;
+            }
+        }
+        const auto newNormal = glm::cross(ps[1] - ps[0], ps[2] - ps[0]);
+        const auto limit = 0.25f * glm::length(oldNormal) * glm::length(newNormal);
+        if (glm::dot(oldNormal, newNormal) <= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Simplifier::collapse(std::uint32_t from, std::uint32_t to)
+{
+    const auto toPos = positionIds[to];
+    auto& toTriangles = positionTriangles[toPos];
+    for (const auto t : positionTriangles[from]) {
+        if (triangleRemoved[t]) {
+            continue;
+        }
+        if (hasPosition(t, toPos)) {
+            triangleRemoved[t] = true;
+            --numTriangles;
+            continue;
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (indices[t * 3 + i] == from) {
+                indices[t * 3 + i] = to;
+            }
+        }
+        toTriangles.push_back(t);
+    }
+    positionTriangles[from].clear();
+    std::erase_if(toTriangles, [this](std::uint32_t t) { return triangleRemoved[t]; });
+
+    quadrics[toPos] += quadrics[from];
+    collapsed[from] = true;
+
+    // the quadric of the target has changed - errors of its edges are updated
+    for (const auto t : toTriangles) {
+        const auto* tri = &indices[t * 3];
+        for (int i = 0; i < 3; ++i) {
+            if (positionIds[tri[i]] == toPos) {
+                continue;
+            }
+            // find the target's vertex in this triangle (can differ from
+            // "to" if the target is on a seam)
+            for (int j = 0; j < 3; ++j) {
+                if (positionIds[tri[j]] == toPos) {
+                    pushCollapse(tri[i], tri[j]);
+                    pushCollapse(tri[j], tri[i]);
+                }
+            }
+        }
+    }
+}
+
+void Simplifier::simplify(std::size_t targetIndexCount, float maxError)
+{
+    const auto maxErrorSquared = (double)maxError * (double)maxError;
+    while (numTriangles * 3 > targetIndexCount && !queue.empty()) {
+        const auto c = queue.top();
+        if (collapsed[positionIds[c.from]] || collapsed[positionIds[c.to]]) {
+            queue.pop();
+            continue;
+        }
+
+        // quadrics could have changed since the collapse was queued
+        const auto error = getCollapseError(c.from, c.to);
+        if (error > c.error) {
+            queue.pop();
+            queue.push(Collapse{.error = error, .from = c.from, .to = c.to});
+            continue;
+        }
+        if (error > maxErrorSquared) {
+            break; // kept in the queue for the next call
+        }
+        queue.pop();
+
+        if (canCollapse(c.from, c.to)) {
+            collapse(c.from, c.to);
+            maxCollapseError = std::max(maxCollapseError, error);
+        }
+    }
+}
+
+std::vector<std::uint32_t> Simplifier::getIndices() const
+{
+    std::vector<std::uint32_t> result;
+    result.reserve(numTriangles * 3);
+    for (std::size_t t = 0; t < triangleRemoved.size(); ++t) {
+        if (!triangleRemoved[t]) {
+            result.insert(result.end(), &indices[t * 3], &indices[t * 3] + 3);
+        }
+    }
+    return result;
+}
+
+} // end of anonymous namespace
+
+namespace graphics
+{
+SimplifiedMesh simplifyMesh(
+    std::span<const std::uint32_t> indices,
+    std::span<const CPUMesh::Vertex> vertices,
+    std::size_t targetIndexCount,
+    float maxError)
+{
+    Simplifier simplifier(indices, vertices);
+    simplifier.simplify(targetIndexCount, maxError);
+    return SimplifiedMesh{
+        .indices = simplifier.getIndices(),
+        .error = simplifier.getError(),
+    };
+}
+
+void generateMeshLODs(CPUMesh& mesh, const MeshLODParams& params)
+{
+    mesh.lods.clear();
+    if (mesh.indices.size() / 3 < params.minTriangles) {
+        return;
+    }
+
+    std::vector<glm::vec3> positions(mesh.vertices.size());
+    for (std::size_t i = 0; i < mesh.vertices.size(); ++i) {
+        positions[i] = mesh.vertices[i].position;
+    }
+    const auto maxError = params.maxError * util::calculateBoundingSphere(positions).radius;
+
+    // all LODs are made by one simplifier, so that their errors are
+    // measured against the original mesh
+    Simplifier simplifier(mesh.indices, mesh.vertices);
+    auto prevNumTriangles = mesh.indices.size() / 3;
+    for (std::size_t i = 0; i < params.maxLODs; ++i) {
+        const auto targetNumTriangles = (std::size_t)((float)prevNumTriangles * params.reduction);
+        if (targetNumTriangles == 0) {
+            break;
+        }
+        simplifier.simplify(targetNumTriangles * 3, maxError);
+
+        auto indices = simplifier.getIndices();
+        const auto numTriangles = indices.size() / 3;
+        if (numTriangles == 0 ||
+            (float)numTriangles > (float)prevNumTriangles * (1.f - MIN_LOD_REDUCTION)) {
+            break;
+        }
+        optimizeVertexCache(indices, mesh.vertices.size());
+        mesh.lods.push_back(CPUMesh::LOD{
+            .indices = std::move(indices),
+            .error = simplifier.getError(),
+        });
+        prevNumTriangles = numTriangles;
+    }
+}
+}
@@ -0,0 +1,84 @@
+#include <edbr/Graphics/MeshletCulling.h>
+
+#include <glm/geometric.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/matrix.hpp>
+
+#include <edbr/Graphics/Camera.h>
+
+namespace graphics
+{
+bool isMeshletBackfacing(const Meshlet& meshlet, const glm::vec3& viewPos)
+{
+    // dot(normalize(v), axis) > cutoff without the division
+    const auto v = meshlet.coneApex - viewPos;
+    return glm::dot(v, meshlet.coneAxis) > meshlet.coneCutoff * glm::length(v);
+}
+
+bool isMeshletBackfacingOrtho(const Meshlet& meshlet, const glm::vec3& viewDir)
+{
+    return glm::dot(viewDir, meshlet.coneAxis) > meshlet.coneCutoff;
+}
+
+MeshletCullingView createMeshletCullingView(const Camera& camera, const CullingVolume& volume)
+{
+    if (camera.isOrthographic()) {
+        // view space looks at -Z
+        const auto view = camera.getView();
+        return MeshletCullingView{
+            .volume = volume,
+            .viewPoint = -glm::vec3{view[0][2], view[1][2], view[2][2]},
+            .orthographic = true,
+        };
+    }
+    return MeshletCullingView{
+        .volume = volume,
+        .viewPoint = camera.getPosition(),
+    };
+}
+
+void cullMeshlets(
+    std::span<const Meshlet> meshlets,
+    const glm::mat4& transform,
+    const MeshletCullingView& view,
+    std::vector<IndexRange>& visibleRanges)
+{
+    // backfacing is preserved by transforms which don't flip the winding,
+    // so the cone test is done in mesh space
+    const auto coneCulling = glm::determinant(glm::mat3{transform}) > 0.f;
+    const auto invTransform = glm::inverse(transform);
+    const auto localViewPoint =
+        view.orthographic ? glm::normalize(glm::mat3{invTransform} * view.viewPoint) :
+                            glm::vec3{invTransform * glm::vec4{view.viewPoint, 1.f}};
+
+    const auto firstRange = visibleRanges.size();
+    for (const auto& meshlet : meshlets) {
+        if (coneCulling) {
+            const auto backfacing = view.orthographic ?
+                                        isMeshletBackfacingOrtho(meshlet, localViewPoint) :
+                                        isMeshletBackfacing(meshlet, localViewPoint);
+            if (backfacing) {
+                continue;
+            }
+        }
+
+        const auto worldSphere =
+            edge::calculateBoundingSphereWorld(transform, meshlet.boundingSphere, false);
+        if (!edge::isInVolume(view.volume, worldSphere)) {
+            continue;
+        }
+
+        if (visibleRanges.size() > firstRange) {
+            auto& last = visibleRanges.back();
+            if (last.firstIndex + last.numIndices == meshlet.firstIndex) {
+                last.numIndices += meshlet.numIndices;
+                continue;
+            }
+        }
+        visibleRanges.push_back(IndexRange{
+            .firstIndex = meshlet.firstIndex,
+            .numIndices = meshlet.numIndices,
+        });
+    }
+}
+}
@@ -49,37 +49,56 @@ void CSMPipeline::init(GfxDevice& gfxDevice, const std::array<float, NUM_SHADOW_
 
 void CSMPipeline::initCSMData(GfxDevice& gfxDevice)
 {
+    const auto createLayerViews = [&gfxDevice](
+                                      const GPUImage& image,
+                                      std::array<VkImageView, NUM_SHADOW_CASCADES>& views,
+                                      const char* label) {
+        for (int i = 0; i < NUM_SHADOW_CASCADES; ++i) {
+            const auto createInfo = VkImageViewCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = image.image,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = image.format,
+                .subresourceRange =
+                    VkImageSubresourceRange{
+                        .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = (std::uint32_t)i,
+                        .layerCount = 1,
+                    },
+            };
+            VK_CHECK(vkCreateImageView(gfxDevice.getDevice(), &createInfo, nullptr, &views[i]));
+            vkutil::addDebugLabel(gfxDevice.getDevice(), views[i], label);
+        }
+    };
+
+    const auto extent =
+        VkExtent3D{(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize, 1};
+
     csmShadowMapID = gfxDevice.createImage(
         {
             .format = VK_FORMAT_D32_SFLOAT,
-            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            .extent =
-                VkExtent3D{
-                    (std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize, 1},
+            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                     VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .extent = extent,
             .numLayers = NUM_SHADOW_CASCADES,
         },
         "CSM shadow map");
-    const auto& csmShadowMap = gfxDevice.getImage(csmShadowMapID);
+    createLayerViews(gfxDevice.getImage(csmShadowMapID), csmShadowMapViews, "CSM shadow map view");
 
-    for (int i = 0; i < NUM_SHADOW_CASCADES; ++i) {
-        const auto createInfo = VkImageViewCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .image = csmShadowMap.image,
-            .viewType = VK_IMAGE_VIEW_TYPE_2D,
-            .format = csmShadowMap.format,
-            .subresourceRange =
-                VkImageSubresourceRange{
-                    .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = (std::uint32_t)i,
-                    .layerCount = 1,
-                },
-        };
-        VK_CHECK(
-            vkCreateImageView(gfxDevice.getDevice(), &createInfo, nullptr, &csmShadowMapViews[i]));
-        vkutil::addDebugLabel(gfxDevice.getDevice(), csmShadowMapViews[i], "CSM shadow map view");
-    }
+    staticShadowMapID = gfxDevice.createImage(
+        {
+            .format = VK_FORMAT_D32_SFLOAT,
+            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .extent = extent,
+            .numLayers = NUM_SHADOW_CASCADES,
+        },
+        "CSM static shadow map");
+    createLayerViews(
+        gfxDevice.getImage(staticShadowMapID), staticShadowMapViews, "CSM static shadow map view");
+
+    cache.init(NUM_SHADOW_CASCADES, {.shadowMapSize = shadowMapTextureSize});
 }
 
 void CSMPipeline::cleanup(GfxDevice& gfxDevice)
@@ -88,30 +107,16 @@ void CSMPipeline::cleanup(GfxDevice& gfxDevice)
     vkDestroyPipeline(gfxDevice.getDevice(), pipeline, nullptr);
     for (int i = 0; i < NUM_SHADOW_CASCADES; ++i) {
         vkDestroyImageView(gfxDevice.getDevice(), csmShadowMapViews[i], nullptr);
+        vkDestroyImageView(gfxDevice.getDevice(), staticShadowMapViews[i], nullptr);
     }
 }
 
-void CSMPipeline::draw(
-    VkCommandBuffer cmd,
-    const GfxDevice& gfxDevice,
-    const MeshCache& meshCache,
+void CSMPipeline::updateCascades(
     const Camera& camera,
     const glm::vec3& sunlightDirection,
-    const GPUBuffer& materialsBuffer,
-    const std::vector<MeshDrawCommand>& meshDrawCommands,
-    bool shadowsEnabled)
+    std::uint64_t staticCastersHash)
 {
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-    gfxDevice.bindBindlessDescSet(cmd, pipelineLayout);
-
-    const auto& csmShadowMap = gfxDevice.getImage(csmShadowMapID);
-
-    vkutil::transitionImage(
-        cmd,
-        csmShadowMap.image,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
-
+    std::array<math::Sphere, NUM_SHADOW_CASCADES> cascadeBounds;
     for (std::size_t i = 0; i < NUM_SHADOW_CASCADES; ++i) {
         float zNear = i == 0 ? camera.getZNear() : camera.getZNear() * percents[i - 1];
         float zFar = camera.getZFar() * percents[i];
@@ -125,76 +130,119 @@ void CSMPipeline::draw(
         subFrustumCamera.init(camera.getFOVX(), zNear, zFar, 1.f);
 
         const auto corners = edge::calculateFrustumCornersWorldSpace(subFrustumCamera);
-        const auto csmCamera = calculateCSMCamera(corners, sunlightDirection, shadowMapTextureSize);
-        csmLightSpaceTMs[i] = csmCamera.getViewProj();
-
-        const auto renderInfo = vkutil::createRenderingInfo({
-            .renderExtent =
-                {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize},
-            .depthImageView = csmShadowMapViews[i],
-            .depthImageClearValue = 0.f,
-        });
-        vkCmdBeginRendering(cmd, &renderInfo.renderingInfo);
-
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-        const auto viewport = VkViewport{
-            .x = 0,
-            .y = 0,
-            .width = shadowMapTextureSize,
-            .height = shadowMapTextureSize,
-            .minDepth = 0.f,
-            .maxDepth = 1.f,
-        };
-        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        cascadeBounds[i] = calculateCSMBoundingSphere(corners);
+    }
 
-        const auto scissor = VkRect2D{
-            .offset = {},
-            .extent = {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize},
-        };
-        vkCmdSetScissor(cmd, 0, 1, &scissor);
+    auto cacheParams = cache.getParams();
+    cacheParams.updateFarCascadesEveryOtherFrame = updateFarCascadeEveryOtherFrame;
+    cacheParams.firstFarCascade = NUM_SHADOW_CASCADES - 1;
+    cache.setParams(cacheParams);
+    if (!cachingEnabled) {
+        cache.invalidate();
+    }
+    cache.update(cascadeBounds, sunlightDirection, staticCastersHash);
 
-        const auto frustum = edge::createFrustumFromCamera(csmCamera);
-        auto prevMeshId = NULL_MESH_ID;
+    for (std::size_t i = 0; i < NUM_SHADOW_CASCADES; ++i) {
+        cascadeCameras[i] = cache.getCamera(i);
+        csmLightSpaceTMs[i] = cascadeCameras[i].getViewProj();
+    }
+}
 
-        for (const auto& dc : meshDrawCommands) {
-            if (!shadowsEnabled || !dc.castShadow) {
-                continue;
-            }
+void CSMPipeline::draw(
+    VkCommandBuffer cmd,
+    const GfxDevice& gfxDevice,
+    const MeshCache& meshCache,
+    const GPUBuffer& materialsBuffer,
+    const std::vector<MeshDrawCommand>& meshDrawCommands,
+    const std::array<std::span<const std::uint32_t>, NUM_SHADOW_CASCADES>& visibleDrawCommands)
+{
+    using UpdateType = CSMCache::UpdateType;
 
-            if (!edge::isInFrustum(frustum, dc.worldBoundingSphere)) {
-                // hack: don't cull big objects, because shadows from them might disappear
-                if (dc.worldBoundingSphere.radius < 2.f) {
-                    continue;
-                }
-            }
+    bool needStaticUpdate = false;
+    bool needUpdate = false;
+    for (std::size_t i = 0; i < NUM_SHADOW_CASCADES; ++i) {
+        needStaticUpdate |= cache.getUpdateType(i) == UpdateType::Full;
+        needUpdate |= cache.getUpdateType(i) != UpdateType::None;
+    }
+    if (!needUpdate) {
+        return;
+    }
 
-            const auto& mesh = meshCache.getMesh(dc.meshId);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    gfxDevice.bindBindlessDescSet(cmd, pipelineLayout);
+
+    const auto& csmShadowMap = gfxDevice.getImage(csmShadowMapID);
+    const auto& staticShadowMap = gfxDevice.getImage(staticShadowMapID);
 
-            if (dc.meshId != prevMeshId) {
-                prevMeshId = dc.meshId;
-                vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    if (needStaticUpdate) {
+        vkutil::transitionImage(
+            cmd,
+            staticShadowMap.image,
+            shadowMapsInitialized ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL :
+                                    VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+
+        for (std::size_t i = 0; i < NUM_SHADOW_CASCADES; ++i) {
+            if (cache.getUpdateType(i) == UpdateType::Full) {
+                drawCasters(
+                    cmd,
+                    staticShadowMapViews[i],
+                    true,
+                    meshCache,
+                    materialsBuffer,
+                    meshDrawCommands,
+                    visibleDrawCommands[i],
+                    i,
+                    true);
             }
+        }
 
-            const auto pushConstants = PushConstants{
-                .mvp = csmLightSpaceTMs[i] * dc.transformMatrix,
-                .vertexBuffer = dc.skinnedMesh ? dc.skinnedMesh->skinnedVertexBuffer.address :
-                                                 mesh.vertexBuffer.address,
-                .materialsBuffer = materialsBuffer.address,
-                .materialId = dc.materialId,
-            };
-            vkCmdPushConstants(
-                cmd,
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(PushConstants),
-                &pushConstants);
+        vkutil::transitionImage(
+            cmd,
+            staticShadowMap.image,
+            VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    }
 
-            vkCmdDrawIndexed(cmd, mesh.numIndices, 1, 0, 0, 0);
+    if (!shadowMapsInitialized) {
+        // transitionImage can't tell that the image is a depth image otherwise
+        vkutil::transitionImage(
+            cmd,
+            csmShadowMap.image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+    }
+    vkutil::transitionImage(
+        cmd,
+        csmShadowMap.image,
+        shadowMapsInitialized ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL :
+                                VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    for (std::size_t i = 0; i < NUM_SHADOW_CASCADES; ++i) {
+        if (cache.getUpdateType(i) != UpdateType::None) {
+            copyStaticLayer(cmd, gfxDevice, i);
         }
+    }
 
-        vkCmdEndRendering(cmd);
+    // dynamic casters on top of the static ones
+    vkutil::transitionImage(
+        cmd,
+        csmShadowMap.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+    for (std::size_t i = 0; i < NUM_SHADOW_CASCADES; ++i) {
+        if (cache.getUpdateType(i) != UpdateType::None) {
+            drawCasters(
+                cmd,
+                csmShadowMapViews[i],
+                false,
+                meshCache,
+                materialsBuffer,
+                meshDrawCommands,
+                visibleDrawCommands[i],
+                i,
+                false);
+        }
     }
 
     // this also gives us sync with future passes that will read from CSM shadow map
@@ -203,4 +251,141 @@ void CSMPipeline::draw(
         csmShadowMap.image,
         VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
         VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL);
+
+    shadowMapsInitialized = true;
+}
+
+void CSMPipeline::setLODParams(const graphics::LODSelectionParams& params)
+{
+    if (params != lodParams) {
+        lodParams = params;
+        cache.invalidate();
+    }
+}
+
+void CSMPipeline::copyStaticLayer(
+    VkCommandBuffer cmd,
+    const GfxDevice& gfxDevice,
+    std::size_t cascadeIndex)
+{
+    const auto layer = VkImageSubresourceLayers{
+        .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+        .mipLevel = 0,
+        .baseArrayLayer = (std::uint32_t)cascadeIndex,
+        .layerCount = 1,
+    };
+    const auto region = VkImageCopy{
+        .srcSubresource = layer,
+        .dstSubresource = layer,
+        .extent =
+            {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize, 1},
+    };
+    vkCmdCopyImage(
+        cmd,
+        gfxDevice.getImage(staticShadowMapID).image,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        gfxDevice.getImage(csmShadowMapID).image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &region);
+}
+
+void CSMPipeline::drawCasters(
+    VkCommandBuffer cmd,
+    VkImageView layerView,
+    bool clear,
+    const MeshCache& meshCache,
+    const GPUBuffer& materialsBuffer,
+    const std::vector<MeshDrawCommand>& meshDrawCommands,
+    std::span<const std::uint32_t> visibleDrawCommands,
+    std::size_t cascadeIndex,
+    bool staticCasters)
+{
+    const auto renderInfo = vkutil::createRenderingInfo({
+        .renderExtent = {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize},
+        .depthImageView = layerView,
+        .depthImageClearValue = clear ? std::optional{0.f} : std::nullopt,
+    });
+    vkCmdBeginRendering(cmd, &renderInfo.renderingInfo);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    const auto viewport = VkViewport{
+        .x = 0,
+        .y = 0,
+        .width = shadowMapTextureSize,
+        .height = shadowMapTextureSize,
+        .minDepth = 0.f,
+        .maxDepth = 1.f,
+    };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    const auto scissor = VkRect2D{
+        .offset = {},
+        .extent = {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize},
+    };
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+    // all meshes share one index buffer - see MeshCache
+    // it's rebound only when the index type changes
+    auto boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+    // Only the side planes of the cascade are used: casters in front of the
+    // near plane still cast shadows into it
+    const auto& cascadeCamera = cascadeCameras[cascadeIndex];
+    const auto cascadeFrustum = edge::createFrustumFromCamera(cascadeCamera);
+    auto cascadeVolume = CullingVolume{};
+    for (int i = 2; i < 6; ++i) {
+        cascadeVolume.addPlane(cascadeFrustum.getPlane(i));
+    }
+    const auto meshletView = graphics::createMeshletCullingView(cascadeCamera, cascadeVolume);
+
+    // draw commands were already culled by CullingStage
+    for (const auto dcIdx : visibleDrawCommands) {
+        const auto& dc = meshDrawCommands[dcIdx];
+        if (dc.isStatic != staticCasters) {
+            continue;
+        }
+
+        const auto& mesh = meshCache.getMesh(dc.meshId);
+        if (mesh.indexType != boundIndexType) {
+            vkCmdBindIndexBuffer(cmd, meshCache.getIndexBuffer().buffer, 0, mesh.indexType);
+            boundIndexType = mesh.indexType;
+        }
+        const auto lodIndex = graphics::selectDrawCommandLOD(
+            dc, mesh, cascadeCamera, shadowMapTextureSize, lodParams);
+        const auto& lod = mesh.lods[lodIndex];
+
+        const auto pushConstants = PushConstants{
+            .mvp = csmLightSpaceTMs[cascadeIndex] * dc.transformMatrix,
+            .vertexBuffer = dc.skinnedMesh ? dc.skinnedMesh->skinnedVertexBuffer.address :
+                                             mesh.vertexBufferAddress,
+            .materialsBuffer = materialsBuffer.address,
+            .materialId = dc.materialId,
+            // skinning.comp outputs full vertices
+            .vertexFormat = dc.skinnedMesh ? VertexFormat::Full : mesh.vertexFormat,
+        };
+        vkCmdPushConstants(
+            cmd,
+            pipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(PushConstants),
+            &pushConstants);
+
+        if (meshletCullingEnabled && dc.isStatic && !dc.skinnedMesh && lodIndex == 0 &&
+            mesh.numMeshlets > 0) {
+            visibleMeshletRanges.clear();
+            graphics::cullMeshlets(
+                meshCache.getMeshlets(mesh), dc.transformMatrix, meshletView, visibleMeshletRanges);
+            for (const auto& range : visibleMeshletRanges) {
+                vkCmdDrawIndexed(cmd, range.numIndices, 1, range.firstIndex, 0, 0);
+            }
+            continue;
+        }
+
+        vkCmdDrawIndexed(cmd, lod.numIndices, 1, lod.firstIndex, 0, 0);
+    }
+
+    vkCmdEndRendering(cmd);
 }
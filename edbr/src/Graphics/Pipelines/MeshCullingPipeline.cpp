@@ -0,0 +1,395 @@
+#include <edbr/Graphics/Pipelines/MeshCullingPipeline.h>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/GfxDevice.h>
+#include <edbr/Graphics/HiZPyramid.h>
+#include <edbr/Graphics/Vulkan/GPUImage.h>
+#include <edbr/Graphics/Vulkan/Pipelines.h>
+#include <edbr/Graphics/Vulkan/Util.h>
+
+#include <tracy/Tracy.hpp>
+
+namespace
+{
+void memoryBarrier(
+    VkCommandBuffer cmd,
+    VkPipelineStageFlags2 srcStageMask,
+    VkAccessFlags2 srcAccessMask,
+    VkPipelineStageFlags2 dstStageMask,
+    VkAccessFlags2 dstAccessMask)
+{
+    const auto barrier = VkMemoryBarrier2{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStageMask,
+        .srcAccessMask = srcAccessMask,
+        .dstStageMask = dstStageMask,
+        .dstAccessMask = dstAccessMask,
+    };
+    const auto dependencyInfo = VkDependencyInfo{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &barrier,
+    };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+
+std::uint32_t getNumGroups(std::uint32_t count, std::uint32_t groupSize)
+{
+    return (count + groupSize - 1) / groupSize;
+}
+}
+
+void MeshCullingPipeline::init(
+    GfxDevice& gfxDevice,
+    std::size_t maxInstances,
+    std::size_t maxMeshletDraws)
+{
+    const auto& device = gfxDevice.getDevice();
+
+    { // cull + compact + meshlet cull
+        const auto pushConstant = VkPushConstantRange{
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(CullPushConstants),
+        };
+        const auto pushConstants = std::array{pushConstant};
+        cullPipelineLayout = vkutil::createPipelineLayout(device, {}, pushConstants);
+        vkutil::addDebugLabel(device, cullPipelineLayout, "mesh cull pipeline layout");
+
+        const auto cullShader = vkutil::loadShaderModule("shaders/mesh_cull.comp.spv", device);
+        vkutil::addDebugLabel(device, cullShader, "mesh_cull.comp");
+        cullPipeline = ComputePipelineBuilder{cullPipelineLayout}.setShader(cullShader).build(device);
+        vkutil::addDebugLabel(device, cullPipeline, "mesh cull pipeline");
+        vkDestroyShaderModule(device, cullShader, nullptr);
+
+        const auto compactShader =
+            vkutil::loadShaderModule("shaders/mesh_cull_compact.comp.spv", device);
+        vkutil::addDebugLabel(device, compactShader, "mesh_cull_compact.comp");
+        compactPipeline =
+            ComputePipelineBuilder{cullPipelineLayout}.setShader(compactShader).build(device);
+        vkutil::addDebugLabel(device, compactPipeline, "mesh cull compact pipeline");
+        vkDestroyShaderModule(device, compactShader, nullptr);
+
+        const auto meshletCullShader =
+            vkutil::loadShaderModule("shaders/meshlet_cull.comp.spv", device);
+        vkutil::addDebugLabel(device, meshletCullShader, "meshlet_cull.comp");
+        meshletCullPipeline =
+            ComputePipelineBuilder{cullPipelineLayout}.setShader(meshletCullShader).build(device);
+        vkutil::addDebugLabel(device, meshletCullPipeline, "meshlet cull pipeline");
+        vkDestroyShaderModule(device, meshletCullShader, nullptr);
+    }
+
+    { // Hi-Z
+        const auto pushConstant = VkPushConstantRange{
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(HiZPushConstants),
+        };
+        const auto pushConstants = std::array{pushConstant};
+        const auto layouts = std::array{gfxDevice.getBindlessDescSetLayout()};
+        hizPipelineLayout = vkutil::createPipelineLayout(device, layouts, pushConstants);
+        vkutil::addDebugLabel(device, hizPipelineLayout, "Hi-Z pipeline layout");
+
+        const auto shader = vkutil::loadShaderModule("shaders/hiz_build.comp.spv", device);
+        vkutil::addDebugLabel(device, shader, "hiz_build.comp");
+        hizPipeline = ComputePipelineBuilder{hizPipelineLayout}.setShader(shader).build(device);
+        vkutil::addDebugLabel(device, hizPipeline, "Hi-Z pipeline");
+        vkDestroyShaderModule(device, shader, nullptr);
+    }
+
+    cullDataBuffer.init(
+        gfxDevice,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        sizeof(CullData),
+        graphics::FRAME_OVERLAP,
+        "mesh cull data");
+
+    createOutputBuffers(gfxDevice, maxInstances, maxMeshletDraws);
+
+    drawCountBuffer = gfxDevice.createBuffer(
+        2 * sizeof(std::uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+    vkutil::addDebugLabel(device, drawCountBuffer.buffer, "mesh cull draw count");
+}
+
+void MeshCullingPipeline::createOutputBuffers(
+    GfxDevice& gfxDevice,
+    std::size_t maxInstances,
+    std::size_t maxMeshletDraws)
+{
+    const auto& device = gfxDevice.getDevice();
+
+    // each instance can be in its own draw in the worst case
+    this->maxInstances = (std::uint32_t)maxInstances;
+    maxDraws = (std::uint32_t)maxInstances;
+    // each meshlet draw has its own command and instance slot
+    this->maxMeshletDraws = (std::uint32_t)maxMeshletDraws;
+
+    visibleCountsBuffer = gfxDevice.createBuffer(
+        maxDraws * sizeof(std::uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+    vkutil::addDebugLabel(device, visibleCountsBuffer.buffer, "mesh cull visible counts");
+
+    visibleInstancesBuffer = gfxDevice.createBuffer(
+        (maxInstances + maxMeshletDraws) * sizeof(std::uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+    vkutil::addDebugLabel(device, visibleInstancesBuffer.buffer, "mesh cull visible instances");
+
+    compactedCommandsBuffer = gfxDevice.createBuffer(
+        (maxDraws + maxMeshletDraws) * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+    vkutil::addDebugLabel(device, compactedCommandsBuffer.buffer, "mesh cull compacted commands");
+}
+
+void MeshCullingPipeline::destroyOutputBuffers(GfxDevice& gfxDevice)
+{
+    gfxDevice.destroyBuffer(compactedCommandsBuffer);
+    gfxDevice.destroyBuffer(visibleInstancesBuffer);
+    gfxDevice.destroyBuffer(visibleCountsBuffer);
+}
+
+void MeshCullingPipeline::resize(
+    GfxDevice& gfxDevice,
+    std::size_t maxInstances,
+    std::size_t maxMeshletDraws)
+{
+    // the old buffers might still be used by frames in flight
+    gfxDevice.waitIdle();
+    destroyOutputBuffers(gfxDevice);
+    createOutputBuffers(gfxDevice, maxInstances, maxMeshletDraws);
+}
+
+void MeshCullingPipeline::cleanup(GfxDevice& gfxDevice)
+{
+    if (hizBuffer.buffer != VK_NULL_HANDLE) {
+        gfxDevice.destroyBuffer(hizBuffer);
+    }
+    gfxDevice.destroyBuffer(drawCountBuffer);
+    destroyOutputBuffers(gfxDevice);
+    cullDataBuffer.cleanup(gfxDevice);
+
+    const auto& device = gfxDevice.getDevice();
+    vkDestroyPipeline(device, hizPipeline, nullptr);
+    vkDestroyPipelineLayout(device, hizPipelineLayout, nullptr);
+    vkDestroyPipeline(device, meshletCullPipeline, nullptr);
+    vkDestroyPipeline(device, compactPipeline, nullptr);
+    vkDestroyPipeline(device, cullPipeline, nullptr);
+    vkDestroyPipelineLayout(device, cullPipelineLayout, nullptr);
+}
+
+void MeshCullingPipeline::cull(
+    VkCommandBuffer cmd,
+    GfxDevice& gfxDevice,
+    const Camera& camera,
+    const GPUBuffer& instanceDataBuffer,
+    const GPUBuffer& indirectCommandsBuffer,
+    std::uint32_t numInstances,
+    std::uint32_t numDraws,
+    std::uint32_t numIndex16Draws,
+    const GPUBuffer& meshletBuffer,
+    const GPUBuffer& meshletDrawsBuffer,
+    std::uint32_t numMeshletDraws,
+    std::uint32_t numIndex16MeshletDraws)
+{
+    ZoneScopedN("Mesh GPU culling");
+    assert(numInstances <= maxInstances);
+    assert(numDraws <= maxDraws);
+    assert(numIndex16Draws <= numDraws);
+    assert(numMeshletDraws <= maxMeshletDraws);
+    assert(numIndex16MeshletDraws <= numMeshletDraws);
+
+    const auto frustum = edge::createFrustumFromCamera(camera);
+    auto cullData = CullData{
+        .hizView = hizView,
+        .hizProj = hizProj,
+        .depthImageSize = hizDepthImageSize,
+        .hizZNear = hizZNear,
+        .occlusionCullingEnabled = (occlusionCullingEnabled && hizValid) ? 1u : 0u,
+        .numInstances = numInstances,
+        .numDraws = numDraws,
+        .numIndex16Draws = numIndex16Draws,
+        .numMeshletDraws = numMeshletDraws,
+        .numIndex16MeshletDraws = numIndex16MeshletDraws,
+        .numIndex16Slots = numIndex16Draws + numIndex16MeshletDraws,
+        .firstMeshletInstance = maxInstances,
+        .cameraPos = camera.getPosition(),
+    };
+    for (int i = 0; i < 6; ++i) {
+        const auto& plane = frustum.getPlane(i);
+        cullData.frustumPlanes[i] = glm::vec4{plane.normal, plane.distance};
+    }
+    cullDataBuffer.uploadNewData(
+        cmd, gfxDevice.getCurrentFrameIndex(), (void*)&cullData, sizeof(CullData));
+
+    // previous frame could still be reading the outputs
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_READ_BIT |
+            VK_ACCESS_2_SHADER_WRITE_BIT);
+
+    if (numDraws > 0) {
+        vkCmdFillBuffer(cmd, visibleCountsBuffer.buffer, 0, numDraws * sizeof(std::uint32_t), 0);
+    }
+    vkCmdFillBuffer(cmd, drawCountBuffer.buffer, 0, 2 * sizeof(std::uint32_t), 0);
+
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+
+    if (numInstances > 0 || numMeshletDraws > 0) {
+        const auto pcs = CullPushConstants{
+            .cullData = cullDataBuffer.getBuffer().address,
+            .instances = instanceDataBuffer.address,
+            .commands = indirectCommandsBuffer.address,
+            .visibleCounts = visibleCountsBuffer.address,
+            .visibleInstances = visibleInstancesBuffer.address,
+            .hiz = hizBuffer.address,
+            .compactedCommands = compactedCommandsBuffer.address,
+            .drawCount = drawCountBuffer.address,
+            .meshlets = meshletBuffer.address,
+            .meshletDraws = meshletDrawsBuffer.address,
+        };
+        vkCmdPushConstants(
+            cmd,
+            cullPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(CullPushConstants),
+            &pcs);
+
+        static const auto workgroupSize = 64;
+
+        if (numInstances > 0) {
+            // cull instances
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+            vkCmdDispatch(cmd, getNumGroups(numInstances, workgroupSize), 1, 1);
+
+            memoryBarrier(
+                cmd,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+
+            // compact draws
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compactPipeline);
+            vkCmdDispatch(cmd, getNumGroups(numDraws, workgroupSize), 1, 1);
+        }
+
+        // cull meshlets: doesn't depend on the passes above, as all commands
+        // are appended with atomics on the draw counts
+        if (numMeshletDraws > 0) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, meshletCullPipeline);
+            vkCmdDispatch(cmd, getNumGroups(numMeshletDraws, workgroupSize), 1, 1);
+        }
+    }
+
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT);
+}
+
+void MeshCullingPipeline::createHiZBuffer(GfxDevice& gfxDevice, const glm::ivec2& depthImageSize)
+{
+    if (hizBuffer.buffer != VK_NULL_HANDLE) {
+        // rare (only happens on resolution change), so just wait for the GPU
+        gfxDevice.waitIdle();
+        gfxDevice.destroyBuffer(hizBuffer);
+    }
+
+    const auto levels = HiZPyramid::calculateLevels(depthImageSize);
+    hizBuffer = gfxDevice.createBuffer(
+        HiZPyramid::calculateDataSize(levels) * sizeof(float),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+    vkutil::addDebugLabel(gfxDevice.getDevice(), hizBuffer.buffer, "Hi-Z pyramid");
+
+    hizDepthImageSize = depthImageSize;
+}
+
+void MeshCullingPipeline::buildHiZ(
+    VkCommandBuffer cmd,
+    GfxDevice& gfxDevice,
+    const GPUImage& depthImage,
+    const Camera& camera)
+{
+    ZoneScopedN("Build Hi-Z");
+
+    const auto depthImageSize = depthImage.getSize2D();
+    if (hizBuffer.buffer == VK_NULL_HANDLE || depthImageSize != hizDepthImageSize) {
+        createHiZBuffer(gfxDevice, depthImageSize);
+    }
+
+    // sync with culling which read the previous pyramid
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_WRITE_BIT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, hizPipeline);
+    vkCmdBindDescriptorSets(
+        cmd,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        hizPipelineLayout,
+        0,
+        1,
+        &gfxDevice.getBindlessDescSet(),
+        0,
+        nullptr);
+
+    const auto levels = HiZPyramid::calculateLevels(depthImageSize);
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        const auto pcs = HiZPushConstants{
+            .hiz = hizBuffer.address,
+            .depthImageSize = depthImageSize,
+            .depthImageId = depthImage.getBindlessId(),
+            .level = (std::uint32_t)i,
+        };
+        vkCmdPushConstants(
+            cmd,
+            hizPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(HiZPushConstants),
+            &pcs);
+
+        static const auto workgroupSize = 8;
+        vkCmdDispatch(
+            cmd,
+            getNumGroups(levels[i].size.x, workgroupSize),
+            getNumGroups(levels[i].size.y, workgroupSize),
+            1);
+
+        // next level (and next frame's culling) reads this one
+        memoryBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_READ_BIT);
+    }
+
+    hizView = camera.getView();
+    hizProj = camera.getProjection();
+    hizZNear = camera.getZNear();
+    hizValid = true;
+}
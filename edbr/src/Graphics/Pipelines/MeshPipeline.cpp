@@ -1,10 +1,8 @@
 #include <edbr/Graphics/Pipelines/MeshPipeline.h>
 
-#include <edbr/Graphics/FrustumCulling.h>
 #include <edbr/Graphics/GfxDevice.h>
 #include <edbr/Graphics/MaterialCache.h>
 #include <edbr/Graphics/MeshCache.h>
-#include <edbr/Graphics/MeshDrawCommand.h>
 #include <edbr/Graphics/Vulkan/Init.h>
 #include <edbr/Graphics/Vulkan/Pipelines.h>
 #include <edbr/Graphics/Vulkan/Util.h>
@@ -57,11 +55,18 @@ void MeshPipeline::draw(
     const GfxDevice& gfxDevice,
     const MeshCache& meshCache,
     const MaterialCache& materialCache,
-    const Camera& camera,
     const GPUBuffer& sceneDataBuffer,
-    const std::vector<MeshDrawCommand>& drawCommands,
-    const std::vector<std::size_t>& sortedDrawCommands)
+    const GPUBuffer& instanceDataBuffer,
+    const GPUBuffer& visibleInstancesBuffer,
+    const GPUBuffer& indirectCommandsBuffer,
+    const GPUBuffer& drawCountBuffer,
+    std::uint32_t maxDraws,
+    std::uint32_t numIndex16Draws)
 {
+    if (maxDraws == 0) {
+        return;
+    }
+
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
     gfxDevice.bindBindlessDescSet(cmd, pipelineLayout);
 
@@ -81,39 +86,44 @@ void MeshPipeline::draw(
     };
     vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-    auto prevMeshId = NULL_MESH_ID;
-
-    const auto frustum = edge::createFrustumFromCamera(camera);
-
-    for (const auto& dcIdx : sortedDrawCommands) {
-        const auto& dc = drawCommands[dcIdx];
-        if (!edge::isInFrustum(frustum, dc.worldBoundingSphere)) {
-            continue;
-        }
-
-        const auto& mesh = meshCache.getMesh(dc.meshId);
-        if (dc.meshId != prevMeshId) {
-            prevMeshId = dc.meshId;
-            vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        }
-
-        assert(dc.materialId != NULL_MATERIAL_ID);
-        const auto pushConstants = PushConstants{
-            .transform = dc.transformMatrix,
-            .sceneDataBuffer = sceneDataBuffer.address,
-            .vertexBuffer = dc.skinnedMesh ? dc.skinnedMesh->skinnedVertexBuffer.address :
-                                             mesh.vertexBuffer.address,
-            .materialId = dc.materialId,
-        };
-        vkCmdPushConstants(
+    const auto pushConstants = PushConstants{
+        .sceneDataBuffer = sceneDataBuffer.address,
+        .instanceDataBuffer = instanceDataBuffer.address,
+        .visibleInstancesBuffer = visibleInstancesBuffer.address,
+    };
+    vkCmdPushConstants(
+        cmd,
+        pipelineLayout,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(PushConstants),
+        &pushConstants);
+
+    // draw commands were culled and compacted on the GPU - see MeshCullingPipeline.
+    // All meshes share one index buffer (see MeshCache), it's bound once per
+    // index type: draws with 16-bit indices come first and have their own count.
+    const auto& indexBuffer = meshCache.getIndexBuffer().buffer;
+    if (numIndex16Draws > 0) {
+        vkCmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+        vkCmdDrawIndexedIndirectCount(
             cmd,
-            pipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            indirectCommandsBuffer.buffer,
             0,
-            sizeof(PushConstants),
-            &pushConstants);
-
-        vkCmdDrawIndexed(cmd, mesh.numIndices, 1, 0, 0, 0);
+            drawCountBuffer.buffer,
+            0,
+            numIndex16Draws,
+            sizeof(VkDrawIndexedIndirectCommand));
+    }
+    if (maxDraws > numIndex16Draws) {
+        vkCmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexedIndirectCount(
+            cmd,
+            indirectCommandsBuffer.buffer,
+            numIndex16Draws * sizeof(VkDrawIndexedIndirectCommand),
+            drawCountBuffer.buffer,
+            sizeof(std::uint32_t),
+            maxDraws - numIndex16Draws,
+            sizeof(VkDrawIndexedIndirectCommand));
     }
 }
 
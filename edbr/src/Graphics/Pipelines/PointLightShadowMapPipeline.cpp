@@ -1,11 +1,12 @@
 #include <edbr/Graphics/Pipelines/PointLightShadowMapPipeline.h>
 
-#include <edbr/Graphics/FrustumCulling.h>
+#include <algorithm>
+
 #include <edbr/Graphics/GfxDevice.h>
 #include <edbr/Graphics/Light.h>
 #include <edbr/Graphics/MeshCache.h>
 #include <edbr/Graphics/MeshDrawCommand.h>
-#include <edbr/Graphics/ShadowMapping.h>
+#include <edbr/Graphics/ShadowCasterCulling.h>
 #include <edbr/Graphics/Vulkan/Pipelines.h>
 #include <edbr/Graphics/Vulkan/Util.h>
 
@@ -47,203 +48,204 @@ void PointLightShadowMapPipeline::init(GfxDevice& gfxDevice, float pointLightMax
     vkDestroyShaderModule(device, vertexShader, nullptr);
     vkDestroyShaderModule(device, fragShader, nullptr);
 
-    shadowMapImageViews.resize(6 * MAX_POINT_LIGHTS);
-    for (std::size_t j = 0; j < MAX_POINT_LIGHTS; ++j) {
-        shadowMaps[j] = gfxDevice.createImage(
-            {
-                .format = VK_FORMAT_D32_SFLOAT,
-                .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-                .extent =
-                    VkExtent3D{
-                        (std::uint32_t)shadowMapTextureSize,
-                        (std::uint32_t)shadowMapTextureSize,
-                        1},
-                .numLayers = 6 * MAX_POINT_LIGHTS,
-                .isCubemap = true,
-            },
-            fmt::format("point light shadow map[{}]", j).c_str());
-
-        // create shadow map image views
-        const auto& shadowMap = gfxDevice.getImage(shadowMaps[j]);
-        for (std::size_t i = 0; i < 6; ++i) {
-            const auto viewCreateInfo = VkImageViewCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                .image = shadowMap.image,
-                .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                .format = VK_FORMAT_D32_SFLOAT,
-                .subresourceRange =
-                    VkImageSubresourceRange{
-                        .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
-                        .baseMipLevel = 0,
-                        .levelCount = 1,
-                        .baseArrayLayer = (std::uint32_t)i,
-                        .layerCount = 1,
-                    },
-            };
-
-            VK_CHECK(vkCreateImageView(
-                gfxDevice.getDevice(), &viewCreateInfo, nullptr, &shadowMapImageViews[i + j * 6]));
-        }
-    }
+    atlas.init(
+        PointShadowAtlas::Params{.maxShadowCastingLights = MAX_POINT_LIGHTS}, pointLightMaxRange);
 
-    { // init point light shadow map cameras
-        const auto aspect = 1.f; // shadow maps are square
-        const auto nearPlane = 0.1f;
-        const auto farPlane = pointLightMaxRange;
-
-        // <front, up>
-        static const std::array<std::pair<glm::vec3, glm::vec3>, 6> shadowDirections{{
-            {{-1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}}, // posx
-            {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}}, // negx
-            {{0.0, -1.0, 0.0}, {0.0, 0.0, 1.0}}, // posy
-            {{0.0, 1.0, 0.0}, {0.0, 0.0, -1.0}}, // negy
-            {{0.0, 0.0, 1.0}, {0.0, 1.0, 0.0}}, // posx
-            {{0.0, 0.0, -1.0}, {0.0, 1.0, 0.0}}, // negz
-        }};
-
-        for (std::size_t j = 0; j < MAX_POINT_LIGHTS; ++j) {
-            for (std::size_t i = 0; i < 6; ++i) {
-                auto& camera = pointLightShadowMapCameras[i + j * 6];
-                camera.setHeading(
-                    glm::quatLookAt(shadowDirections[i].first, shadowDirections[i].second));
-                camera.init(glm::radians(90.0f), nearPlane, farPlane, aspect);
-            }
-        }
-    }
+    const auto atlasSize = atlas.getParams().atlasSize;
+    shadowAtlasID = gfxDevice.createImage(
+        {
+            .format = VK_FORMAT_D32_SFLOAT,
+            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .extent = VkExtent3D{atlasSize, atlasSize, 1},
+        },
+        "point light shadow atlas");
 
-    vpsBuffer.init(
+    facesBuffer.init(
         gfxDevice,
         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-        sizeof(glm::mat4) * 6 * MAX_POINT_LIGHTS,
+        sizeof(faceData),
         graphics::FRAME_OVERLAP,
-        "point light vps data");
+        "point light shadow faces data");
 }
 
 void PointLightShadowMapPipeline::cleanup(GfxDevice& gfxDevice)
 {
-    vpsBuffer.cleanup(gfxDevice);
-
-    for (const auto& view : shadowMapImageViews) {
-        vkDestroyImageView(gfxDevice.getDevice(), view, nullptr);
-    }
+    facesBuffer.cleanup(gfxDevice);
 
     vkDestroyPipelineLayout(gfxDevice.getDevice(), pipelineLayout, nullptr);
     vkDestroyPipeline(gfxDevice.getDevice(), pipeline, nullptr);
 }
 
-void PointLightShadowMapPipeline::beginFrame(
-    VkCommandBuffer cmd,
-    const GfxDevice& gfxDevice,
-    const std::vector<GPULightData>& lightData,
-    const std::vector<std::size_t> pointLightIndices)
+void PointLightShadowMapPipeline::updateLights(
+    const Camera& camera,
+    std::span<const GPULightData> lightData)
+{
+    if (cachingEnabled != atlas.getParams().cachingEnabled) {
+        auto params = atlas.getParams();
+        params.cachingEnabled = cachingEnabled;
+        atlas.setParams(params);
+    }
+    atlas.update(camera, lightData);
+}
+
+void PointLightShadowMapPipeline::updateFaceCasters(
+    std::size_t slot,
+    std::size_t face,
+    const std::vector<MeshDrawCommand>& meshDrawCommands,
+    std::span<const std::uint32_t> visibleDrawCommands)
+{
+    atlas.updateFaceCasters(slot, face, meshDrawCommands, visibleDrawCommands);
+}
+
+void PointLightShadowMapPipeline::beginFrame(VkCommandBuffer cmd, const GfxDevice& gfxDevice)
 {
-    lightToShadowMapId.clear();
-    currShadowMapIndex = 0;
-
-    // calculate shadow map vps
-    auto currIndex = 0;
-    for (const auto lightIndex : pointLightIndices) {
-        for (std::size_t i = 0; i < 6; ++i) {
-            auto& currCamera = pointLightShadowMapCameras[i + currIndex * 6];
-            currCamera.setPosition(lightData[lightIndex].position);
-            pointLightShadowMapVPs[i + currIndex * 6] = currCamera.getViewProj();
+    numDraws = 0;
+
+    const auto lights = atlas.getShadowCastingLights();
+    const auto atlasSize = (float)atlas.getParams().atlasSize;
+    bool needDraw = false;
+    for (std::size_t j = 0; j < lights.size(); ++j) {
+        for (std::size_t i = 0; i < PointShadowAtlas::NUM_FACES; ++i) {
+            const auto& face = lights[j].faces[i];
+            faceData[i + j * PointShadowAtlas::NUM_FACES] = GPUFaceData{
+                .viewProj = face.camera.getViewProj(),
+                .atlasRect =
+                    glm::vec4{
+                        (float)face.tile.x / atlasSize,
+                        (float)face.tile.y / atlasSize,
+                        (float)face.tile.size / atlasSize,
+                        0.5f / (float)face.tile.size,
+                    },
+            };
+            needDraw |= (face.state == PointShadowAtlas::FaceState::Draw);
         }
-        ++currIndex;
     }
+
     // upload to GPU
-    vpsBuffer.uploadNewData(
+    facesBuffer.uploadNewData(
         cmd,
         gfxDevice.getCurrentFrameIndex(),
-        (void*)pointLightShadowMapVPs.data(),
-        sizeof(pointLightShadowMapVPs));
+        (void*)faceData.data(),
+        sizeof(GPUFaceData) * lights.size() * PointShadowAtlas::NUM_FACES);
+
+    drawingFaces = needDraw || !shadowAtlasInitialized;
+    if (!drawingFaces) {
+        return;
+    }
+
+    // tiles of cached faces are kept, so the atlas is never cleared as a whole
+    const auto& shadowAtlas = gfxDevice.getImage(shadowAtlasID);
+    vkutil::transitionImage(
+        cmd,
+        shadowAtlas.image,
+        shadowAtlasInitialized ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL :
+                                 VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+    shadowAtlasInitialized = true;
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
     gfxDevice.bindBindlessDescSet(cmd, pipelineLayout);
 }
 
+void PointLightShadowMapPipeline::setLODParams(const graphics::LODSelectionParams& params)
+{
+    if (params != lodParams) {
+        lodParams = params;
+        atlas.invalidate();
+    }
+}
+
 void PointLightShadowMapPipeline::draw(
     VkCommandBuffer cmd,
     const GfxDevice& gfxDevice,
     const MeshCache& meshCache,
-    const Camera& camera,
-    const std::uint32_t lightIndex,
-    const glm::vec3& lightPos,
+    std::size_t slot,
     const GPUBuffer& materialsBuffer,
-    const GPUBuffer& lightsBuffer,
     const std::vector<MeshDrawCommand>& meshDrawCommands,
-    bool shadowsEnabled)
+    const std::array<std::span<const std::uint32_t>, PointShadowAtlas::NUM_FACES>&
+        visibleDrawCommands)
 {
-    if (currShadowMapIndex >= MAX_POINT_LIGHTS) {
-        fmt::println(
-            "too many point lights with shadows: the shadow won't be drawn for the current light");
+    const auto& light = atlas.getShadowCastingLights()[slot];
+    if (std::ranges::none_of(light.faces, [](const auto& face) {
+            return face.state == PointShadowAtlas::FaceState::Draw;
+        })) {
         return;
     }
 
-    const auto& shadowMap = gfxDevice.getImage(shadowMaps[currShadowMapIndex]);
-    vkutil::transitionImage(
-        cmd, shadowMap.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
-
-    for (std::size_t i = 0; i < 6; ++i) {
-        const auto& currCamera = pointLightShadowMapCameras[i + currShadowMapIndex * 6];
-
-        const auto renderInfo = vkutil::createRenderingInfo({
-            .renderExtent =
-                {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize},
-            .depthImageView = shadowMapImageViews[i + currShadowMapIndex * 6],
-            .depthImageClearValue = 1.f,
-        });
-        vkCmdBeginRendering(cmd, &renderInfo.renderingInfo);
+    const auto& shadowAtlas = gfxDevice.getImage(shadowAtlasID);
+    const auto renderInfo = vkutil::createRenderingInfo({
+        .renderExtent = shadowAtlas.getExtent2D(),
+        .depthImageView = shadowAtlas.imageView,
+    });
+    vkCmdBeginRendering(cmd, &renderInfo.renderingInfo);
+
+    for (std::size_t i = 0; i < PointShadowAtlas::NUM_FACES; ++i) {
+        const auto& face = light.faces[i];
+        if (face.state != PointShadowAtlas::FaceState::Draw) {
+            continue;
+        }
 
         const auto viewport = VkViewport{
-            .x = 0,
-            .y = 0,
-            .width = shadowMapTextureSize,
-            .height = shadowMapTextureSize,
+            .x = (float)face.tile.x,
+            .y = (float)face.tile.y,
+            .width = (float)face.tile.size,
+            .height = (float)face.tile.size,
             .minDepth = 0.f,
             .maxDepth = 1.f,
         };
         vkCmdSetViewport(cmd, 0, 1, &viewport);
 
         const auto scissor = VkRect2D{
-            .offset = {},
-            .extent = {(std::uint32_t)shadowMapTextureSize, (std::uint32_t)shadowMapTextureSize},
+            .offset = {(std::int32_t)face.tile.x, (std::int32_t)face.tile.y},
+            .extent = {face.tile.size, face.tile.size},
         };
         vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-        const auto frustum = edge::createFrustumFromCamera(currCamera);
-        auto prevMeshId = NULL_MESH_ID;
+        // only this tile is cleared - other tiles can be cached
+        const auto clearAttachment = VkClearAttachment{
+            .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+            .clearValue = {.depthStencil = {.depth = 1.f}},
+        };
+        const auto clearRect = VkClearRect{
+            .rect = scissor,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+        vkCmdClearAttachments(cmd, 1, &clearAttachment, 1, &clearRect);
 
-        for (const auto& dc : meshDrawCommands) {
-            if (!shadowsEnabled || !dc.castShadow) {
-                continue;
-            }
+        // all meshes share one index buffer - see MeshCache
+        // it's rebound only when the index type changes
+        auto boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
 
-            if (!edge::isInFrustum(frustum, dc.worldBoundingSphere)) {
-                // hack: don't cull big objects, because shadows from them might disappear
-                if (dc.worldBoundingSphere.radius < 2.f) {
-                    continue;
-                }
-            }
+        // same volume which CullingStage used for the face's casters
+        const auto meshletView = graphics::createMeshletCullingView(
+            face.camera,
+            edge::createPointLightFaceCasterVolume(face.camera, light.position, light.range));
 
+        // draw commands were already culled by CullingStage
+        for (const auto dcIdx : visibleDrawCommands[i]) {
+            const auto& dc = meshDrawCommands[dcIdx];
             const auto& mesh = meshCache.getMesh(dc.meshId);
-
-            if (dc.meshId != prevMeshId) {
-                prevMeshId = dc.meshId;
-                vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+            if (mesh.indexType != boundIndexType) {
+                vkCmdBindIndexBuffer(cmd, meshCache.getIndexBuffer().buffer, 0, mesh.indexType);
+                boundIndexType = mesh.indexType;
             }
+            const auto lodIndex = graphics::selectDrawCommandLOD(
+                dc, mesh, face.camera, (float)face.tile.size, lodParams);
+            const auto& lod = mesh.lods[lodIndex];
 
             const auto pushConstants = PushConstants{
                 .model = dc.transformMatrix,
+                .lightPosition = light.position,
+                .farPlane = pointLightMaxRange,
                 .vertexBuffer = dc.skinnedMesh ? dc.skinnedMesh->skinnedVertexBuffer.address :
-                                                 mesh.vertexBuffer.address,
+                                                 mesh.vertexBufferAddress,
                 .materialsBuffer = materialsBuffer.address,
-                .lightsBuffer = lightsBuffer.address,
-                .vpsBuffer = vpsBuffer.getBuffer().address,
+                .facesBuffer = facesBuffer.getBuffer().address,
                 .materialId = dc.materialId,
-                .lightIndex = lightIndex,
-                .vpsBufferIndex = (std::uint32_t)(i + currShadowMapIndex * 6),
-                .farPlane = pointLightMaxRange,
+                .faceIndex = (std::uint32_t)(i + slot * PointShadowAtlas::NUM_FACES),
+                // skinning.comp outputs full vertices
+                .vertexFormat = dc.skinnedMesh ? VertexFormat::Full : mesh.vertexFormat,
             };
             vkCmdPushConstants(
                 cmd,
@@ -253,22 +255,40 @@ void PointLightShadowMapPipeline::draw(
                 sizeof(PushConstants),
                 &pushConstants);
 
-            vkCmdDrawIndexed(cmd, mesh.numIndices, 1, 0, 0, 0);
-        }
+            if (meshletCullingEnabled && dc.isStatic && !dc.skinnedMesh && lodIndex == 0 &&
+                mesh.numMeshlets > 0) {
+                visibleMeshletRanges.clear();
+                graphics::cullMeshlets(
+                    meshCache.getMeshlets(mesh),
+                    dc.transformMatrix,
+                    meshletView,
+                    visibleMeshletRanges);
+                for (const auto& range : visibleMeshletRanges) {
+                    vkCmdDrawIndexed(cmd, range.numIndices, 1, range.firstIndex, 0, 0);
+                }
+                numDraws += visibleMeshletRanges.size();
+                continue;
+            }
 
-        vkCmdEndRendering(cmd);
+            vkCmdDrawIndexed(cmd, lod.numIndices, 1, lod.firstIndex, 0, 0);
+            ++numDraws;
+        }
     }
 
-    lightToShadowMapId[lightIndex] = shadowMaps[currShadowMapIndex];
+    vkCmdEndRendering(cmd);
+}
 
+void PointLightShadowMapPipeline::endFrame(VkCommandBuffer cmd, const GfxDevice& gfxDevice)
+{
+    if (!drawingFaces) {
+        return;
+    }
+
+    const auto& shadowAtlas = gfxDevice.getImage(shadowAtlasID);
     vkutil::transitionImage(
         cmd,
-        shadowMap.image,
+        shadowAtlas.image,
         VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
         VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL);
-
-    ++currShadowMapIndex;
+    drawingFaces = false;
 }
-
-void PointLightShadowMapPipeline::endFrame(VkCommandBuffer cmd, const GfxDevice& gfxDevice)
-{}
@@ -6,6 +6,8 @@
 #include <edbr/Graphics/Vulkan/Pipelines.h>
 #include <edbr/Graphics/Vulkan/Util.h>
 
+#include <cstring> // memcpy
+
 void SkinningPipeline::init(GfxDevice& gfxDevice)
 {
     const auto& device = gfxDevice.getDevice();
@@ -33,6 +35,15 @@ void SkinningPipeline::init(GfxDevice& gfxDevice)
         jointMatricesBuffer.buffer = gfxDevice.createBuffer(
             MAX_JOINT_MATRICES * sizeof(glm::mat4),
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+
+        auto& jobsBuffer = framesData[i].jobsBuffer;
+        jobsBuffer.capacity = MAX_SKINNING_JOBS;
+        jobsBuffer.buffer = gfxDevice.createBuffer(
+            MAX_SKINNING_JOBS * sizeof(GPUSkinningJob),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+
+        framesData[i].dispatchCommandBuffer = gfxDevice.createBuffer(
+            sizeof(VkDispatchIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
     }
 }
 
@@ -40,6 +51,8 @@ void SkinningPipeline::cleanup(GfxDevice& gfxDevice)
 {
     for (std::size_t i = 0; i < graphics::FRAME_OVERLAP; ++i) {
         gfxDevice.destroyBuffer(framesData[i].jointMatricesBuffer.buffer);
+        gfxDevice.destroyBuffer(framesData[i].jobsBuffer.buffer);
+        gfxDevice.destroyBuffer(framesData[i].dispatchCommandBuffer);
     }
     vkDestroyPipelineLayout(gfxDevice.getDevice(), skinningPipelineLayout, nullptr);
     vkDestroyPipeline(gfxDevice.getDevice(), skinningPipeline, nullptr);
@@ -47,7 +60,9 @@ void SkinningPipeline::cleanup(GfxDevice& gfxDevice)
 
 void SkinningPipeline::beginDrawing(std::size_t frameIndex)
 {
-    getCurrentFrameData(frameIndex).jointMatricesBuffer.clear();
+    auto& frameData = getCurrentFrameData(frameIndex);
+    frameData.jointMatricesBuffer.clear();
+    frameData.jobsBuffer.clear();
 }
 
 SkinningPipeline::PerFrameData& SkinningPipeline::getCurrentFrameData(std::size_t frameIndex)
@@ -69,26 +84,32 @@ void SkinningPipeline::doSkinning(
     VkCommandBuffer cmd,
     std::size_t frameIndex,
     const MeshCache& meshCache,
-    const MeshDrawCommand& dc)
+    const std::vector<MeshDrawCommand>& drawCommands)
 {
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, skinningPipeline);
+    const auto numGroups = graphics::buildSkinningJobs(drawCommands, meshCache.getMeshes(), jobs);
+    if (jobs.empty()) {
+        return;
+    }
+    assert(jobs.size() <= MAX_SKINNING_JOBS);
+
+    auto& frameData = getCurrentFrameData(frameIndex);
+    frameData.jobsBuffer.append(jobs);
 
-    const auto& mesh = meshCache.getMesh(dc.meshId);
-    assert(mesh.hasSkeleton);
-    assert(dc.skinnedMesh);
+    const auto dispatchCommand = VkDispatchIndirectCommand{.x = numGroups, .y = 1, .z = 1};
+    memcpy(
+        frameData.dispatchCommandBuffer.info.pMappedData,
+        &dispatchCommand,
+        sizeof(VkDispatchIndirectCommand));
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, skinningPipeline);
 
     const auto cs = PushConstants{
-        .jointMatricesBuffer = getCurrentFrameData(frameIndex).jointMatricesBuffer.buffer.address,
-        .jointMatricesStartIndex = dc.jointMatricesStartIndex,
-        .numVertices = mesh.numVertices,
-        .inputBuffer = mesh.vertexBuffer.address,
-        .skinningData = mesh.skinningDataBuffer.address,
-        .outputBuffer = dc.skinnedMesh->skinnedVertexBuffer.address,
+        .jointMatricesBuffer = frameData.jointMatricesBuffer.buffer.address,
+        .jobsBuffer = frameData.jobsBuffer.buffer.address,
+        .numJobs = (std::uint32_t)jobs.size(),
     };
     vkCmdPushConstants(
         cmd, skinningPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &cs);
 
-    static const auto workgroupSize = 256;
-    const auto groupSizeX = (std::uint32_t)std::ceil(mesh.numVertices / (float)workgroupSize);
-    vkCmdDispatch(cmd, groupSizeX, 1, 1);
+    vkCmdDispatchIndirect(cmd, frameData.dispatchCommandBuffer.buffer, 0);
 }
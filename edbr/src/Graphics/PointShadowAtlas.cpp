@@ -0,0 +1,431 @@
+#include <edbr/Graphics/PointShadowAtlas.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <edbr/Graphics/CSMCache.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/Light.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Math/Sphere.h>
+
+void ShadowAtlasAllocator::init(std::uint32_t atlasSize, std::uint32_t minTileSize)
+{
+    assert(std::has_single_bit(atlasSize) && std::has_single_bit(minTileSize));
+    assert(minTileSize <= atlasSize);
+    this->atlasSize = atlasSize;
+    this->minTileSize = minTileSize;
+
+    freeTiles.clear();
+    freeTiles.resize(getLevel(minTileSize) + 1);
+    freeTiles[0].push_back(ShadowAtlasTile{.size = atlasSize});
+}
+
+std::size_t ShadowAtlasAllocator::getLevel(std::uint32_t size) const
+{
+    return std::countr_zero(atlasSize) - std::countr_zero(size);
+}
+
+std::optional<ShadowAtlasTile> ShadowAtlasAllocator::allocate(std::uint32_t size)
+{
+    assert(std::has_single_bit(size) && size >= minTileSize && size <= atlasSize);
+    const auto level = getLevel(size);
+
+    // find the smallest free tile which is big enough
+    auto freeLevel = level + 1;
+    while (freeLevel > 0 && freeTiles[freeLevel - 1].empty()) {
+        --freeLevel;
+    }
+    if (freeLevel == 0) {
+        return std::nullopt;
+    }
+    --freeLevel;
+
+    auto tile = freeTiles[freeLevel].back();
+    freeTiles[freeLevel].pop_back();
+
+    // split it until it has the requested size: the first child is kept
+    // and the other three become free
+    for (auto l = freeLevel + 1; l <= level; ++l) {
+        const auto s = getLevelSize(l);
+        freeTiles[l].push_back(ShadowAtlasTile{.x = tile.x + s, .y = tile.y, .size = s});
+        freeTiles[l].push_back(ShadowAtlasTile{.x = tile.x, .y = tile.y + s, .size = s});
+        freeTiles[l].push_back(ShadowAtlasTile{.x = tile.x + s, .y = tile.y + s, .size = s});
+        tile.size = s;
+    }
+    return tile;
+}
+
+void ShadowAtlasAllocator::free(const ShadowAtlasTile& tile)
+{
+    auto level = getLevel(tile.size);
+    auto t = tile;
+    assert(std::ranges::find(freeTiles[level], t) == freeTiles[level].end() && "double free");
+
+    // merge with siblings while all of them are free
+    while (level > 0) {
+        const auto parentSize = t.size * 2;
+        const auto parent = ShadowAtlasTile{
+            .x = t.x - t.x % parentSize,
+            .y = t.y - t.y % parentSize,
+            .size = parentSize,
+        };
+        const auto siblings = std::array{
+            ShadowAtlasTile{.x = parent.x, .y = parent.y, .size = t.size},
+            ShadowAtlasTile{.x = parent.x + t.size, .y = parent.y, .size = t.size},
+            ShadowAtlasTile{.x = parent.x, .y = parent.y + t.size, .size = t.size},
+            ShadowAtlasTile{.x = parent.x + t.size, .y = parent.y + t.size, .size = t.size},
+        };
+
+        auto& levelTiles = freeTiles[level];
+        const auto numFreeSiblings = std::ranges::count_if(levelTiles, [&](const auto& ft) {
+            return std::ranges::find(siblings, ft) != siblings.end();
+        });
+        if (numFreeSiblings != 3) {
+            break;
+        }
+        std::erase_if(levelTiles, [&](const auto& ft) {
+            return std::ranges::find(siblings, ft) != siblings.end();
+        });
+
+        t = parent;
+        --level;
+    }
+    freeTiles[level].push_back(t);
+}
+
+std::uint64_t ShadowAtlasAllocator::getNumFreeTexels() const
+{
+    std::uint64_t numTexels = 0;
+    for (const auto& levelTiles : freeTiles) {
+        for (const auto& tile : levelTiles) {
+            numTexels += (std::uint64_t)tile.size * tile.size;
+        }
+    }
+    return numTexels;
+}
+
+namespace
+{
+// <look direction, up> - see graphics::getPointShadowFace
+const std::array<std::pair<glm::vec3, glm::vec3>, PointShadowAtlas::NUM_FACES> faceDirections{{
+    {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+    {{-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+    {{0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}},
+    {{0.f, -1.f, 0.f}, {0.f, 0.f, -1.f}},
+    {{0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}},
+    {{0.f, 0.f, -1.f}, {0.f, 1.f, 0.f}},
+}};
+
+// screen area of the range sphere (relative to the screen height squared)
+float calculateImportance(const Camera& camera, const glm::vec3& position, float range)
+{
+    const auto distance = std::max(glm::distance(camera.getPosition(), position), 1e-3f);
+    const auto projectedRadius = range / (distance * std::tan(camera.getFOVY() / 2.f));
+    return projectedRadius * projectedRadius;
+}
+
+// Everything the face can shadow is inside the pyramid with the apex at
+// the light and the base at the light's range
+bool isFaceVisible(const Frustum& frustum, const glm::vec3& lightPos, float range, std::size_t face)
+{
+    const auto& [dir, up] = faceDirections[face];
+    const auto right = glm::cross(dir, up);
+    const auto corners = std::array{
+        lightPos,
+        lightPos + range * (dir + up + right),
+        lightPos + range * (dir + up - right),
+        lightPos + range * (dir - up + right),
+        lightPos + range * (dir - up - right),
+    };
+    for (int i = 0; i < 6; ++i) {
+        const auto& plane = frustum.getPlane(i);
+        if (std::ranges::all_of(corners, [&plane](const glm::vec3& p) {
+                return plane.getSignedDistanceToPlane(p) < 0.f;
+            })) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+void PointShadowAtlas::init(const Params& params, float farPlane)
+{
+    assert(farPlane > 0.f);
+    this->farPlane = farPlane;
+    this->params = params;
+    lights.clear();
+    allocator.init(params.atlasSize, params.minTileSize);
+}
+
+void PointShadowAtlas::setParams(const Params& params)
+{
+    if (params.atlasSize != this->params.atlasSize ||
+        params.maxTileSize != this->params.maxTileSize ||
+        params.minTileSize != this->params.minTileSize) {
+        init(params, farPlane);
+        return;
+    }
+    this->params = params;
+}
+
+void PointShadowAtlas::invalidate()
+{
+    for (auto& light : lights) {
+        for (auto& face : light.faces) {
+            face.valid = false;
+        }
+    }
+}
+
+void PointShadowAtlas::update(const Camera& camera, std::span<const GPULightData> lightData)
+{
+    const auto frustum = edge::createFrustumFromCamera(camera);
+
+    struct Candidate {
+        float importance;
+        std::size_t lightIndex;
+    };
+    std::vector<Candidate> candidates;
+    for (std::size_t i = 0; i < lightData.size(); ++i) {
+        const auto& ld = lightData[i];
+        if (ld.type != edbr::TYPE_POINT_LIGHT) {
+            continue;
+        }
+        // nothing visible is lit by the light
+        if (!edge::isInFrustum(frustum, math::Sphere{.center = ld.position, .radius = ld.range})) {
+            continue;
+        }
+        candidates.push_back(Candidate{
+            .importance = calculateImportance(camera, ld.position, ld.range),
+            .lightIndex = i,
+        });
+    }
+    std::ranges::sort(candidates, [](const Candidate& a, const Candidate& b) {
+        if (a.importance != b.importance) {
+            return a.importance > b.importance;
+        }
+        return a.lightIndex < b.lightIndex;
+    });
+    if (candidates.size() > params.maxShadowCastingLights) {
+        candidates.resize(params.maxShadowCastingLights);
+    }
+
+    // keep tiles of the lights which had shadows in the previous frame
+    std::vector<ShadowCastingLight> newLights;
+    newLights.reserve(candidates.size());
+    std::vector<bool> kept(lights.size(), false);
+    for (const auto& candidate : candidates) {
+        const auto& ld = lightData[candidate.lightIndex];
+        const auto distance = glm::distance(camera.getPosition(), ld.position);
+
+        const auto it = std::ranges::find_if(lights, [&candidate](const auto& light) {
+            return light.lightIndex == candidate.lightIndex;
+        });
+        if (it != lights.end()) {
+            kept[it - lights.begin()] = true;
+            auto& light = newLights.emplace_back(*it);
+            const auto lod = calculateLOD(distance, light.lod);
+            if (lod != light.lod) {
+                freeTiles(light);
+                light.lod = lod;
+            }
+            if (light.position != ld.position || light.range != ld.range) {
+                light.position = ld.position;
+                light.range = ld.range;
+                initFaceCameras(light);
+                for (auto& face : light.faces) {
+                    face.valid = false;
+                }
+            }
+        } else {
+            auto& light = newLights.emplace_back(ShadowCastingLight{
+                .lightIndex = candidate.lightIndex,
+                .position = ld.position,
+                .range = ld.range,
+                .lod = calculateLOD(distance, std::nullopt),
+            });
+            initFaceCameras(light);
+        }
+        newLights.back().importance = candidate.importance;
+    }
+    for (std::size_t i = 0; i < lights.size(); ++i) {
+        if (!kept[i]) {
+            freeTiles(lights[i]);
+        }
+    }
+
+    // allocate tiles in order of importance: less important lights are
+    // evicted first, then the tile size is reduced
+    for (std::size_t i = 0; i < newLights.size(); ++i) {
+        auto& light = newLights[i];
+        if (light.tileSize != 0) {
+            continue;
+        }
+
+        auto tileSize = params.maxTileSize >> light.lod;
+        while (!allocateTiles(light, tileSize)) {
+            auto evicted = false;
+            for (auto j = newLights.size() - 1; j > i; --j) {
+                if (newLights[j].tileSize != 0) {
+                    freeTiles(newLights[j]);
+                    evicted = true;
+                    break;
+                }
+            }
+            if (!evicted) {
+                if (tileSize == params.minTileSize) {
+                    break;
+                }
+                tileSize /= 2;
+            }
+        }
+    }
+    std::erase_if(newLights, [](const auto& light) { return light.tileSize == 0; });
+    lights = std::move(newLights);
+
+    for (auto& light : lights) {
+        for (std::size_t i = 0; i < NUM_FACES; ++i) {
+            light.faces[i].state = isFaceVisible(frustum, light.position, light.range, i) ?
+                                       FaceState::Draw :
+                                       FaceState::Skipped;
+        }
+    }
+}
+
+void PointShadowAtlas::updateFaceCasters(
+    std::size_t slot,
+    std::size_t faceIndex,
+    const std::vector<MeshDrawCommand>& meshDrawCommands,
+    std::span<const std::uint32_t> visibleDrawCommands)
+{
+    auto& face = lights[slot].faces[faceIndex];
+    if (face.state == FaceState::Skipped) {
+        return;
+    }
+
+    std::uint64_t castersHash = 0;
+    bool hasSkinnedCasters = false;
+    for (const auto dcIdx : visibleDrawCommands) {
+        const auto& dc = meshDrawCommands[dcIdx];
+        // skinned meshes can change without changing their transform
+        hasSkinnedCasters |= (dc.skinnedMesh != nullptr);
+        castersHash += graphics::hashShadowCaster(dc);
+    }
+
+    if (params.cachingEnabled && face.valid && !hasSkinnedCasters &&
+        castersHash == face.castersHash) {
+        face.state = FaceState::Cached;
+        return;
+    }
+
+    face.state = FaceState::Draw;
+    // skinned casters are drawn with the current pose, so the face is
+    // redrawn next frame even if they stop being skinned
+    face.valid = !hasSkinnedCasters;
+    face.castersHash = castersHash;
+}
+
+PointShadowAtlas::Stats PointShadowAtlas::getStats() const
+{
+    Stats stats{.numLights = lights.size()};
+    for (const auto& light : lights) {
+        for (const auto& face : light.faces) {
+            switch (face.state) {
+            case FaceState::Skipped:
+                ++stats.numSkippedFaces;
+                break;
+            case FaceState::Cached:
+                ++stats.numCachedFaces;
+                break;
+            case FaceState::Draw:
+                ++stats.numDrawnFaces;
+                break;
+            }
+        }
+    }
+    return stats;
+}
+
+std::uint32_t PointShadowAtlas::calculateLOD(
+    float distance,
+    std::optional<std::uint32_t> prevLOD) const
+{
+    const auto lod = std::log2(std::max(distance, 1e-3f) / params.fullResolutionDistance);
+    if (prevLOD) {
+        const auto prev = (float)*prevLOD;
+        if (lod > prev - params.lodHysteresis && lod < prev + 1.f + params.lodHysteresis) {
+            return *prevLOD;
+        }
+    }
+
+    const auto maxLOD = std::countr_zero(params.maxTileSize) - std::countr_zero(params.minTileSize);
+    return (std::uint32_t)std::clamp(std::floor(lod), 0.f, (float)maxLOD);
+}
+
+bool PointShadowAtlas::allocateTiles(ShadowCastingLight& light, std::uint32_t tileSize)
+{
+    std::array<ShadowAtlasTile, NUM_FACES> tiles;
+    for (std::size_t i = 0; i < NUM_FACES; ++i) {
+        const auto tile = allocator.allocate(tileSize);
+        if (!tile) {
+            for (std::size_t j = 0; j < i; ++j) {
+                allocator.free(tiles[j]);
+            }
+            return false;
+        }
+        tiles[i] = *tile;
+    }
+
+    for (std::size_t i = 0; i < NUM_FACES; ++i) {
+        light.faces[i].tile = tiles[i];
+        light.faces[i].valid = false;
+    }
+    light.tileSize = tileSize;
+    return true;
+}
+
+void PointShadowAtlas::freeTiles(ShadowCastingLight& light)
+{
+    if (light.tileSize == 0) {
+        return;
+    }
+    for (auto& face : light.faces) {
+        allocator.free(face.tile);
+        face.tile = {};
+        face.valid = false;
+    }
+    light.tileSize = 0;
+}
+
+void PointShadowAtlas::initFaceCameras(ShadowCastingLight& light) const
+{
+    for (std::size_t i = 0; i < NUM_FACES; ++i) {
+        auto& camera = light.faces[i].camera;
+        // quatLookAt points -Z at the direction, but cameras look along
+        // GlobalFrontAxis (+Z)
+        camera.setHeading(glm::quatLookAt(-faceDirections[i].first, faceDirections[i].second));
+        camera.setPosition(light.position);
+        camera.init(glm::radians(90.f), 0.1f, farPlane, 1.f);
+    }
+}
+
+namespace graphics
+{
+std::size_t getPointShadowFace(const glm::vec3& lightToPoint)
+{
+    const auto a = glm::abs(lightToPoint);
+    if (a.x >= a.y && a.x >= a.z) {
+        return lightToPoint.x > 0.f ? 0 : 1;
+    }
+    if (a.y >= a.z) {
+        return lightToPoint.y > 0.f ? 2 : 3;
+    }
+    return lightToPoint.z > 0.f ? 4 : 5;
+}
+}
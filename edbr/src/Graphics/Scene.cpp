@@ -1,5 +1,7 @@
 #include <edbr/Graphics/Scene.h>
 
+#include <edbr/Graphics/GfxDevice.h>
+
 namespace edbr
 {
 math::AABB calculateBoundingBoxLocal(const Scene& scene, const std::vector<MeshId> meshes)
@@ -29,4 +31,48 @@ math::AABB calculateBoundingBoxLocal(const Scene& scene, const std::vector<MeshI
         .max = glm::vec3{maxX, maxY, maxZ},
     };
 }
+
+std::vector<Material> loadSceneMaterials(
+    GfxDevice& gfxDevice,
+    std::span<const SceneMaterial> sceneMaterials)
+{
+    std::vector<ImageCache::LoadParams> params;
+    const auto addTexture = [&params](const std::filesystem::path& path, util::TextureKind kind) {
+        if (!path.empty()) {
+            params.push_back({
+                .path = path,
+                .format = kind == util::TextureKind::Color ? VK_FORMAT_R8G8B8A8_SRGB :
+                                                             VK_FORMAT_R8G8B8A8_UNORM,
+                .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+                .mipMap = true,
+                .kind = kind,
+            });
+        }
+    };
+    // same kinds as the ones texture_cooker uses for material textures
+    for (const auto& sm : sceneMaterials) {
+        addTexture(sm.diffuseTexture, util::TextureKind::Color);
+        addTexture(sm.normalMapTexture, util::TextureKind::NormalMap);
+        addTexture(sm.metallicRoughnessTexture, util::TextureKind::Linear);
+        addTexture(sm.emissiveTexture, util::TextureKind::Color);
+    }
+
+    const auto imageIds = gfxDevice.loadImagesFromFiles(params);
+
+    // ids are returned in the same order as the textures were added
+    std::vector<Material> materials;
+    materials.reserve(sceneMaterials.size());
+    std::size_t nextImage = 0;
+    const auto getTexture = [&imageIds, &nextImage](const std::filesystem::path& path) {
+        return path.empty() ? NULL_IMAGE_ID : imageIds[nextImage++];
+    };
+    for (const auto& sm : sceneMaterials) {
+        auto& material = materials.emplace_back(sm.material);
+        material.diffuseTexture = getTexture(sm.diffuseTexture);
+        material.normalMapTexture = getTexture(sm.normalMapTexture);
+        material.metallicRoughnessTexture = getTexture(sm.metallicRoughnessTexture);
+        material.emissiveTexture = getTexture(sm.emissiveTexture);
+    }
+    return materials;
+}
 }
@@ -0,0 +1,128 @@
+#include <edbr/Graphics/ShadowCasterCulling.h>
+
+#include <edbr/Graphics/Camera.h>
+
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+namespace
+{
+// same face layout as in createFrustumFromCamera
+const std::array<std::array<std::size_t, 4>, 6> boxFaces{{
+    {0, 1, 2, 3}, // near
+    {7, 6, 5, 4}, // far
+    {4, 5, 1, 0}, // left
+    {3, 2, 6, 7}, // right
+    {4, 0, 3, 7}, // bottom
+    {5, 6, 2, 1}, // top
+}};
+
+// planes of adjacent faces and silhouette edges often coincide (e.g. when
+// the light is parallel to the box's side)
+void addUniquePlane(CullingVolume& volume, const Frustum::Plane& plane)
+{
+    for (std::size_t i = 0; i < volume.numPlanes; ++i) {
+        const auto& other = volume.planes[i];
+        if (glm::dot(other.normal, plane.normal) > 0.9999f &&
+            std::abs(other.distance - plane.distance) < 1e-3f) {
+            return;
+        }
+    }
+    volume.addPlane(plane);
+}
+}
+
+namespace edge
+{
+CullingVolume createPointLightFaceCasterVolume(
+    const Camera& faceCamera,
+    const glm::vec3& lightPosition,
+    float lightRange)
+{
+    const auto frustum = createFrustumFromCamera(faceCamera);
+
+    CullingVolume volume;
+    volume.addPlane(frustum.nearFace);
+    volume.addPlane(frustum.leftFace);
+    volume.addPlane(frustum.rightFace);
+    volume.addPlane(frustum.topFace);
+    volume.addPlane(frustum.bottomFace);
+    volume.sphere = math::Sphere{.center = lightPosition, .radius = lightRange};
+    return volume;
+}
+
+CullingVolume createDirectionalLightCasterVolume(
+    const std::array<glm::vec3, 8>& receiverCorners,
+    const glm::vec3& lightDir)
+{
+    const auto& corners = receiverCorners;
+    auto centroid = glm::vec3{};
+    for (const auto& c : corners) {
+        centroid += c;
+    }
+    centroid /= 8.f;
+
+    // outward normals are oriented with the centroid, so that the winding
+    // (which depends on inverse depth and clip space Y) doesn't matter
+    std::array<glm::vec3, 6> normals;
+    std::array<bool, 6> facesLight;
+    for (std::size_t f = 0; f < boxFaces.size(); ++f) {
+        const auto& face = boxFaces[f];
+        const auto e1 = corners[face[1]] - corners[face[0]];
+        const auto e2 = corners[face[2]] - corners[face[0]];
+        auto n = glm::normalize(glm::cross(e1, e2));
+        if (glm::dot(n, corners[face[0]] - centroid) < 0.f) {
+            n = -n;
+        }
+        normals[f] = n;
+        facesLight[f] = glm::dot(n, lightDir) > 0.f;
+    }
+
+    CullingVolume volume;
+    // faces which face the light are removed - the volume is unbounded in
+    // the light's direction
+    for (std::size_t f = 0; f < boxFaces.size(); ++f) {
+        if (!facesLight[f]) {
+            addUniquePlane(volume, Frustum::Plane{corners[boxFaces[f][0]], -normals[f]});
+        }
+    }
+
+    // silhouette edges (shared by a face which faces the light and a face which
+    // doesn't) are extruded towards the light
+    for (std::size_t f1 = 0; f1 < boxFaces.size(); ++f1) {
+        for (std::size_t f2 = f1 + 1; f2 < boxFaces.size(); ++f2) {
+            if (facesLight[f1] == facesLight[f2]) {
+                continue;
+            }
+            std::array<std::size_t, 2> edge;
+            std::size_t numShared = 0;
+            for (const auto i : boxFaces[f1]) {
+                for (const auto j : boxFaces[f2]) {
+                    if (i == j && numShared < 2) {
+                        edge[numShared++] = i;
+                    }
+                }
+            }
+            if (numShared != 2) { // opposite faces
+                continue;
+            }
+
+            const auto edgeVec = corners[edge[1]] - corners[edge[0]];
+            auto n = glm::cross(edgeVec, lightDir);
+            const auto len = glm::length(n);
+            if (len < 1e-3f * glm::length(edgeVec)) {
+                // the edge is (almost) parallel to the light - the plane's normal
+                // would be imprecise, and skipping it only makes the volume bigger
+                continue;
+            }
+            n /= len;
+            if (glm::dot(n, corners[edge[0]] - centroid) < 0.f) {
+                n = -n;
+            }
+            addUniquePlane(volume, Frustum::Plane{corners[edge[0]], -n});
+        }
+    }
+    return volume;
+}
+}
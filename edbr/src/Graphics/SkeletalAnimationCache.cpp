@@ -36,7 +36,7 @@ void SkeletalAnimationCache::loadAnimationData(const std::filesystem::path& path
 
 void SkeletalAnimationCache::addAnimations(
     const std::filesystem::path& gltfPath,
-    AnimationsMap anims)
+    CompressedAnimationsMap anims)
 {
     // append animation data
     if (auto it = animationData.find(gltfPath.string()); it != animationData.end()) {
@@ -48,11 +48,69 @@ void SkeletalAnimationCache::addAnimations(
         }
     }
 
-    animations.emplace(gltfPath.string(), std::move(anims));
+    auto& compressed = compressedAnimations[gltfPath.string()];
+    compressed.merge(std::move(anims));
 }
 
-const SkeletalAnimationCache::AnimationsMap& SkeletalAnimationCache::getAnimations(
+const SkeletalAnimationCache::CompressedAnimationsMap& SkeletalAnimationCache::getAnimations(
     const std::filesystem::path& gltfPath) const
 {
-    return animations.at(gltfPath.string());
+    return compressedAnimations.at(gltfPath.string());
+}
+
+bool SkeletalAnimationCache::hasAnimation(
+    const std::filesystem::path& gltfPath,
+    const std::string& name) const
+{
+    const auto it = compressedAnimations.find(gltfPath.string());
+    return it != compressedAnimations.end() && it->second.contains(name);
+}
+
+const SkeletalAnimation& SkeletalAnimationCache::getAnimation(
+    const std::filesystem::path& gltfPath,
+    const std::string& name)
+{
+    std::lock_guard lock{decompressedAnimationsMutex};
+    auto& anims = decompressedAnimations[gltfPath.string()];
+    if (const auto it = anims.find(name); it != anims.end()) {
+        return it->second;
+    }
+
+    auto animation = graphics::decompressAnimation(getAnimations(gltfPath).at(name));
+    // only soaTracks are used for sampling
+    animation.tracks = {};
+    // map nodes don't move, so the users can keep pointers to them
+    return anims.emplace(name, std::move(animation)).first->second;
+}
+
+std::size_t SkeletalAnimationCache::getNumAnimations() const
+{
+    std::size_t numAnimations = 0;
+    for (const auto& [path, anims] : compressedAnimations) {
+        numAnimations += anims.size();
+    }
+    return numAnimations;
+}
+
+std::size_t SkeletalAnimationCache::getCompressedDataSize() const
+{
+    std::size_t size = 0;
+    for (const auto& [path, anims] : compressedAnimations) {
+        for (const auto& [name, animation] : anims) {
+            size += graphics::getTrackDataSize(animation);
+        }
+    }
+    return size;
+}
+
+std::size_t SkeletalAnimationCache::getDecompressedDataSize() const
+{
+    std::lock_guard lock{decompressedAnimationsMutex};
+    std::size_t size = 0;
+    for (const auto& [path, anims] : decompressedAnimations) {
+        for (const auto& [name, animation] : anims) {
+            size += graphics::getTrackDataSize(animation.soaTracks);
+        }
+    }
+    return size;
 }
@@ -3,153 +3,271 @@
 #include <edbr/Graphics/SkeletalAnimation.h>
 #include <edbr/Graphics/Skeleton.h>
 
-#include <tuple>
-
-#include <glm/gtx/compatibility.hpp> // lerp for vec3
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace
 {
-static const int ANIMATION_FPS = 30;
-static const glm::mat4 I{1.f};
+struct BlendSpaceEntries {
+    std::size_t first;
+    std::size_t second;
+    float weight; // weight of the second entry
+};
+
+BlendSpaceEntries findBlendSpaceEntries(const AnimationBlendSpace1D& blendSpace, float value)
+{
+    const auto& entries = blendSpace.entries;
+    assert(!entries.empty());
+    if (value <= entries.front().position) {
+        return {0, 0, 0.f};
+    }
+    for (std::size_t i = 0; i + 1 < entries.size(); ++i) {
+        const auto p0 = entries[i].position;
+        const auto p1 = entries[i + 1].position;
+        if (value < p1) {
+            return {i, i + 1, (value - p0) / (p1 - p0)};
+        }
+    }
+    return {entries.size() - 1, entries.size() - 1, 0.f};
+}
+
+float getNormalizedTime(const SkeletalAnimation& animation, float time)
+{
+    return animation.duration > 0.f ? time / animation.duration : 0.f;
 }
+} // end of anonymous namespace
 
-void SkeletonAnimator::setAnimation(const Skeleton& skeleton, const SkeletalAnimation& animation)
+void SkeletonAnimator::setAnimation(
+    const Skeleton& skeleton,
+    const SkeletalAnimation& animation,
+    float fadeDuration)
 {
-    if (this->animation != nullptr && this->animation->name == animation.name) {
+    if (!isBlendSpacePlaying() && current.animation != nullptr &&
+        current.animation->name == animation.name) {
         return; // TODO: allow to reset animation
     }
 
     jointMatrices.resize(skeleton.joints.size());
 
-    time = static_cast<float>(animation.startFrame) / ANIMATION_FPS;
-    animationFinished = false;
+    startFade(fadeDuration);
+    current = State{
+        .animation = &animation,
+        .time = static_cast<float>(animation.startFrame) / graphics::ANIMATION_FPS,
+    };
     currentFrame = 0;
     frameChanged = false; // ideally should be "true", but update will override it
-    this->animation = &animation;
 
     calculateJointMatrices(skeleton);
 }
 
-void SkeletonAnimator::update(const Skeleton& skeleton, float dt)
+void SkeletonAnimator::setBlendSpace(
+    const Skeleton& skeleton,
+    const AnimationBlendSpace1D& blendSpace,
+    float fadeDuration)
 {
-    if (!animation || animationFinished) {
+    assert(!blendSpace.entries.empty());
+    if (isBlendSpacePlaying() && current.blendSpace.name == blendSpace.name) {
         return;
     }
 
-    time += dt;
-    if (time > animation->duration) { // loop
-        if (animation->looped) {
-            time -= animation->duration;
-        } else {
-            time = animation->duration;
-            animationFinished = true;
-        }
-    }
+    jointMatrices.resize(skeleton.joints.size());
 
-    auto newFrame = (int)std::floor(time * static_cast<float>(ANIMATION_FPS));
-    frameChanged = newFrame != currentFrame;
-    currentFrame = newFrame;
+    const auto blendParameter = current.blendParameter;
+    startFade(fadeDuration);
+    current = State{
+        .animation = blendSpace.entries[0].animation,
+        .blendSpace = blendSpace,
+        .blendParameter = blendParameter,
+    };
+    currentFrame = 0;
+    frameChanged = false;
 
     calculateJointMatrices(skeleton);
 }
 
-const std::string& SkeletonAnimator::getCurrentAnimationName() const
+void SkeletonAnimator::setAdditiveLayer(
+    std::size_t layer,
+    const SkeletalAnimation* animation,
+    float weight)
 {
-    static const std::string nullAnimationName{};
-    return animation ? animation->name : nullAnimationName;
+    if (layer >= layers.size()) {
+        layers.resize(layer + 1);
+    }
+    auto& l = layers[layer];
+    if (l.animation != animation) {
+        l.animation = animation;
+        l.time = 0.f;
+    }
+    l.weight = weight;
 }
 
-namespace
+void SkeletonAnimator::setAdditiveLayerWeight(std::size_t layer, float weight)
 {
+    assert(layer < layers.size());
+    layers[layer].weight = weight;
+}
 
-std::tuple<std::size_t, std::size_t, float> findPrevNextKeys(std::size_t numKeys, float time)
+void SkeletonAnimator::startFade(float fadeDuration)
 {
-    // keys are sampled by ANIMATION_FPS, so finding prev/next key is easy
-    const std::size_t prevKey =
-        std::min((std::size_t)std::floor(time * ANIMATION_FPS), numKeys - 1);
-    const std::size_t nextKey = std::min(prevKey + 1, numKeys - 1);
-
-    float t{0.f};
-    if (prevKey != nextKey) {
-        t = time * ANIMATION_FPS - (float)prevKey;
+    if (fadeDuration <= 0.f || !current.isActive()) {
+        previous = State{};
+        return;
     }
 
-    return {prevKey, nextKey, t};
+    if (previous.isActive()) {
+        // the fade is interrupted - fade out from the last pose
+        fadeOutPose = basePose;
+        previous = State{.frozen = true};
+    } else {
+        previous = std::move(current);
+    }
+    fadeTime = 0.f;
+    this->fadeDuration = fadeDuration;
 }
 
-glm::mat4 sampleAnimation(const SkeletalAnimation& animation, JointId jointId, float time)
+void SkeletonAnimator::advance(State& state, float dt)
 {
-    const auto& ts = animation.tracks[jointId];
+    if (state.animation == nullptr || state.finished) {
+        return;
+    }
 
-    auto tm = I;
+    if (!state.blendSpace.entries.empty()) {
+        // all clips of the blend space play in sync, the speed of playback
+        // is interpolated between the clips
+        const auto [first, second, weight] =
+            findBlendSpaceEntries(state.blendSpace, state.blendParameter);
+        const auto& a = *state.blendSpace.entries[first].animation;
+        const auto& b = *state.blendSpace.entries[second].animation;
+        const auto duration = a.duration + (b.duration - a.duration) * weight;
 
-    { // translation
-        const auto& tc = ts.translations;
-        if (!tc.empty()) {
-            const auto [p, n, t] = findPrevNextKeys(tc.size(), time);
-            const auto pos = glm::lerp(tc[p], tc[n], t);
-            tm[3] = glm::vec4(pos, 1.f);
+        auto t = getNormalizedTime(*state.animation, state.time);
+        if (duration > 0.f) {
+            t = std::fmod(t + dt / duration, 1.f);
         }
+        state.animation = weight < 0.5f ? &a : &b;
+        state.time = t * state.animation->duration;
+        return;
     }
 
-    { // rotation
-        const auto& rc = ts.rotations;
-        if (!rc.empty()) {
-            const auto [p, n, t] = findPrevNextKeys(rc.size(), time);
-            const auto rot = glm::slerp(rc[p], rc[n], t);
-            tm *= glm::mat4_cast(rot);
+    const auto& animation = *state.animation;
+    state.time += dt;
+    if (state.time > animation.duration) { // loop
+        if (animation.looped) {
+            state.time -= animation.duration;
+        } else {
+            state.time = animation.duration;
+            state.finished = true;
         }
     }
+}
 
-    // TODO: one more potential optimization: if there's no scaling in
-    // animation, we can skip this calculating the scale.
+void SkeletonAnimator::update(const Skeleton& skeleton, float dt)
+{
+    if (!current.isActive()) {
+        return;
+    }
 
-    { // scale
-        const auto& sc = ts.scales;
-        if (!sc.empty()) {
-            const auto [p, n, t] = findPrevNextKeys(sc.size(), time);
-            const auto scale = glm::lerp(sc[p], sc[n], t);
-            tm = glm::scale(tm, scale);
+    const auto hasLayers = std::any_of(layers.begin(), layers.end(), [](const auto& l) {
+        return l.animation != nullptr && l.weight > 0.f;
+    });
+    if (current.finished && !previous.isActive() && !hasLayers) {
+        frameChanged = false;
+        return;
+    }
+
+    advance(current, dt);
+    if (previous.isActive()) {
+        advance(previous, dt);
+        fadeTime += dt;
+        if (fadeTime >= fadeDuration) {
+            previous = State{};
+        }
+    }
+    for (auto& layer : layers) {
+        if (layer.animation && layer.animation->duration > 0.f) {
+            layer.time = std::fmod(layer.time + dt, layer.animation->duration);
         }
     }
 
-    return tm;
+    auto newFrame = (int)std::floor(current.time * static_cast<float>(graphics::ANIMATION_FPS));
+    frameChanged = newFrame != currentFrame;
+    currentFrame = newFrame;
+
+    calculateJointMatrices(skeleton);
 }
 
-} // end of anonymous namespace
+const std::string& SkeletonAnimator::getCurrentAnimationName() const
+{
+    static const std::string nullAnimationName{};
+    return current.animation ? current.animation->name : nullAnimationName;
+}
 
-void SkeletonAnimator::calculateJointMatrices(const Skeleton& skeleton)
+void SkeletonAnimator::samplePose(const State& state, LocalPose& pose)
 {
-    static const glm::mat4 I{1.f};
-    calculateJointMatrix(skeleton, ROOT_JOINT_ID, *animation, time, I);
+    if (state.frozen) {
+        pose = fadeOutPose;
+        return;
+    }
+
+    if (state.blendSpace.entries.empty()) {
+        graphics::sampleLocalPose(state.animation->soaTracks, state.time, pose);
+        return;
+    }
+
+    const auto [first, second, weight] =
+        findBlendSpaceEntries(state.blendSpace, state.blendParameter);
+    const auto& a = *state.blendSpace.entries[first].animation;
+    const auto t = getNormalizedTime(*state.animation, state.time);
+    graphics::sampleLocalPose(a.soaTracks, t * a.duration, pose);
+    if (first != second) {
+        const auto& b = *state.blendSpace.entries[second].animation;
+        auto& other = posePool.acquire();
+        graphics::sampleLocalPose(b.soaTracks, t * b.duration, other);
+        graphics::blendLocalPoses(pose, other, weight, pose);
+    }
 }
 
-void SkeletonAnimator::calculateJointMatrix(
-    const Skeleton& skeleton,
-    JointId jointId,
-    const SkeletalAnimation& animation,
-    float time,
-    const glm::mat4& parentTransform)
+void SkeletonAnimator::calculateJointMatrices(const Skeleton& skeleton)
 {
-    const auto localTransform = sampleAnimation(animation, jointId, time);
-    const auto modelTransform = parentTransform * localTransform;
-    jointMatrices[jointId] = modelTransform * skeleton.inverseBindMatrices[jointId];
+    posePool.releaseAll();
+
+    samplePose(current, basePose);
+    if (previous.isActive()) {
+        auto& pose = posePool.acquire();
+        samplePose(previous, pose);
+        const auto weight = std::min(fadeTime / fadeDuration, 1.f);
+        graphics::blendLocalPoses(pose, basePose, weight, basePose);
+    }
 
-    for (const auto childIdx : skeleton.hierarchy[jointId].children) {
-        calculateJointMatrix(skeleton, childIdx, animation, time, modelTransform);
+    auto* pose = &basePose;
+    for (const auto& layer : layers) {
+        if (layer.animation == nullptr || layer.weight <= 0.f) {
+            continue;
+        }
+        if (pose == &basePose) { // basePose is kept for fades
+            auto& layeredPose = posePool.acquire();
+            layeredPose = basePose;
+            pose = &layeredPose;
+        }
+        auto& additivePose = posePool.acquire();
+        graphics::sampleLocalPose(layer.animation->soaTracks, layer.time, additivePose);
+        graphics::addLocalPose(*pose, additivePose, layer.weight);
     }
+
+    graphics::calculateJointMatrices(skeleton.flatSkeleton, *pose, jointMatrices, transforms);
 }
 
 void SkeletonAnimator::setNormalizedProgress(float t)
 {
     assert(t >= 0.f && t <= 1.f);
-    time = t * animation->duration;
+    current.time = t * current.animation->duration;
 }
 
 float SkeletonAnimator::getNormalizedProgress() const
 {
-    if (!animation) {
+    if (!current.animation) {
         return 0.f;
     }
-    return time / animation->duration;
+    return getNormalizedTime(*current.animation, current.time);
 }
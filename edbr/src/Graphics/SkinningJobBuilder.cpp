@@ -0,0 +1,45 @@
+#include <edbr/Graphics/SkinningJobBuilder.h>
+
+#include <cassert>
+#include <unordered_set>
+
+#include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+namespace graphics
+{
+std::uint32_t buildSkinningJobs(
+    const std::vector<MeshDrawCommand>& drawCommands,
+    std::span<const GPUMesh> meshes,
+    std::vector<GPUSkinningJob>& jobs)
+{
+    jobs.clear();
+
+    std::unordered_set<const SkinnedMesh*> skinnedMeshes;
+    std::uint32_t numGroups = 0;
+    for (const auto& dc : drawCommands) {
+        if (!dc.skinnedMesh || !skinnedMeshes.insert(dc.skinnedMesh).second) {
+            continue;
+        }
+
+        assert(dc.meshId < meshes.size());
+        const auto& mesh = meshes[dc.meshId];
+        assert(mesh.hasSkeleton);
+        if (mesh.numVertices == 0) {
+            continue;
+        }
+
+        jobs.push_back(GPUSkinningJob{
+            .inputBuffer = mesh.vertexBufferAddress,
+            .skinningData = mesh.skinningDataBuffer.address,
+            .outputBuffer = dc.skinnedMesh->skinnedVertexBuffer.address,
+            .jointMatricesStartIndex = dc.jointMatricesStartIndex,
+            .numVertices = mesh.numVertices,
+            .firstGroup = numGroups,
+            .inputVertexFormat = mesh.vertexFormat,
+        });
+        numGroups += (mesh.numVertices + SKINNING_WORKGROUP_SIZE - 1) / SKINNING_WORKGROUP_SIZE;
+    }
+    return numGroups;
+}
+}
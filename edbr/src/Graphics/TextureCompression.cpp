@@ -0,0 +1,562 @@
+#include <edbr/Graphics/TextureCompression.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// writes/reads bits starting from the least significant bit of the first byte
+class BlockBitWriter {
+public:
+    explicit BlockBitWriter(std::span<std::uint8_t> block) : block(block)
+    {
+        std::fill(block.begin(), block.end(), 0);
+    }
+
+    void write(std::uint32_t value, int numBits)
+    {
+        for (int i = 0; i < numBits; ++i, ++pos) {
+            if ((value >> i) & 1) {
+                block[pos / 8] |= (std::uint8_t)(1 << (pos % 8));
+            }
+        }
+    }
+
+private:
+    std::span<std::uint8_t> block;
+    std::size_t pos{0};
+};
+
+class BlockBitReader {
+public:
+    explicit BlockBitReader(std::span<const std::uint8_t> block) : block(block) {}
+
+    std::uint32_t read(int numBits)
+    {
+        std::uint32_t value = 0;
+        for (int i = 0; i < numBits; ++i, ++pos) {
+            value |= (std::uint32_t)((block[pos / 8] >> (pos % 8)) & 1) << i;
+        }
+        return value;
+    }
+
+private:
+    std::span<const std::uint8_t> block;
+    std::size_t pos{0};
+};
+
+/* BC4 */
+
+// palette[0] = r0 and palette[1] = r1 (as in the format)
+std::array<int, 8> makeBC4Palette(int r0, int r1)
+{
+    std::array<int, 8> palette{r0, r1};
+    if (r0 > r1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * r0 + i * r1 + 3) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1] = ((5 - i) * r0 + i * r1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    return palette;
+}
+
+/* BC7 mode 6 */
+
+constexpr std::array<int, 16> BC7_WEIGHTS = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+int bc7Interpolate(int e0, int e1, int weight)
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+struct Mode6Endpoints {
+    std::array<int, 4> q0; // 7 bits per channel
+    std::array<int, 4> q1;
+    int p0;
+    int p1;
+
+    std::array<int, 4> getEndpoint0() const { return unquantize(q0, p0); }
+    std::array<int, 4> getEndpoint1() const { return unquantize(q1, p1); }
+
+    static std::array<int, 4> unquantize(const std::array<int, 4>& q, int p)
+    {
+        return {q[0] * 2 + p, q[1] * 2 + p, q[2] * 2 + p, q[3] * 2 + p};
+    }
+};
+
+Mode6Endpoints quantizeEndpoints(
+    const std::array<float, 4>& e0,
+    const std::array<float, 4>& e1,
+    int p0,
+    int p1)
+{
+    Mode6Endpoints endpoints{.p0 = p0, .p1 = p1};
+    for (int c = 0; c < 4; ++c) {
+        endpoints.q0[c] = std::clamp((int)std::lround((e0[c] - p0) / 2.f), 0, 127);
+        endpoints.q1[c] = std::clamp((int)std::lround((e1[c] - p1) / 2.f), 0, 127);
+    }
+    return endpoints;
+}
+
+// Finds the closest palette entry for each texel, returns the total squared error
+int findMode6Indices(
+    std::span<const std::uint8_t, 64> rgba,
+    const Mode6Endpoints& endpoints,
+    std::array<int, 16>& indices)
+{
+    const auto e0 = endpoints.getEndpoint0();
+    const auto e1 = endpoints.getEndpoint1();
+    std::array<std::array<int, 4>, 16> palette;
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            palette[i][c] = bc7Interpolate(e0[c], e1[c], BC7_WEIGHTS[i]);
+        }
+    }
+
+    int totalError = 0;
+    for (int t = 0; t < 16; ++t) {
+        int bestError = std::numeric_limits<int>::max();
+        for (int i = 0; i < 16; ++i) {
+            int error = 0;
+            for (int c = 0; c < 4; ++c) {
+                const auto d = (int)rgba[t * 4 + c] - palette[i][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                indices[t] = i;
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+// Principal axis of the texels: endpoints are placed on it
+void findInitialEndpoints(
+    std::span<const std::uint8_t, 64> rgba,
+    std::array<float, 4>& e0,
+    std::array<float, 4>& e1)
+{
+    std::array<float, 4> mean{};
+    for (int t = 0; t < 16; ++t) {
+        for (int c = 0; c < 4; ++c) {
+            mean[c] += rgba[t * 4 + c] / 16.f;
+        }
+    }
+
+    std::array<std::array<float, 4>, 4> cov{};
+    for (int t = 0; t < 16; ++t) {
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                cov[i][j] += (rgba[t * 4 + i] - mean[i]) * (rgba[t * 4 + j] - mean[j]);
+            }
+        }
+    }
+
+    // power iteration
+    std::array<float, 4> axis{1.f, 1.f, 1.f, 1.f};
+    for (int iter = 0; iter < 8; ++iter) {
+        std::array<float, 4> next{};
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                next[i] += cov[i][j] * axis[j];
+            }
+        }
+        float len = 0.f;
+        for (const auto v : next) {
+            len += v * v;
+        }
+        len = std::sqrt(len);
+        if (len < 1e-6f) {
+            break; // all texels are the same
+        }
+        for (int i = 0; i < 4; ++i) {
+            axis[i] = next[i] / len;
+        }
+    }
+
+    float minT = 0.f;
+    float maxT = 0.f;
+    for (int t = 0; t < 16; ++t) {
+        float proj = 0.f;
+        for (int c = 0; c < 4; ++c) {
+            proj += (rgba[t * 4 + c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, proj);
+        maxT = std::max(maxT, proj);
+    }
+
+    for (int c = 0; c < 4; ++c) {
+        e0[c] = std::clamp(mean[c] + axis[c] * minT, 0.f, 255.f);
+        e1[c] = std::clamp(mean[c] + axis[c] * maxT, 0.f, 255.f);
+    }
+}
+
+// Least squares fit of endpoints for the chosen indices
+bool refitEndpoints(
+    std::span<const std::uint8_t, 64> rgba,
+    const std::array<int, 16>& indices,
+    std::array<float, 4>& e0,
+    std::array<float, 4>& e1)
+{
+    float a = 0.f, b = 0.f, c = 0.f;
+    std::array<float, 4> x0{};
+    std::array<float, 4> x1{};
+    for (int t = 0; t < 16; ++t) {
+        const auto w = BC7_WEIGHTS[indices[t]] / 64.f;
+        a += (1.f - w) * (1.f - w);
+        b += (1.f - w) * w;
+        c += w * w;
+        for (int ch = 0; ch < 4; ++ch) {
+            x0[ch] += (1.f - w) * rgba[t * 4 + ch];
+            x1[ch] += w * rgba[t * 4 + ch];
+        }
+    }
+    const auto det = a * c - b * b;
+    if (std::abs(det) < 1e-6f) {
+        return false;
+    }
+    for (int ch = 0; ch < 4; ++ch) {
+        e0[ch] = std::clamp((c * x0[ch] - b * x1[ch]) / det, 0.f, 255.f);
+        e1[ch] = std::clamp((a * x1[ch] - b * x0[ch]) / det, 0.f, 255.f);
+    }
+    return true;
+}
+
+// Gathers a 4x4 block, clamping coordinates to the image
+template<std::size_t N>
+void gatherBlock(
+    std::span<const std::uint8_t> rgba,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::uint32_t blockX,
+    std::uint32_t blockY,
+    std::array<std::uint8_t, N>& out)
+{
+    static_assert(N == 64);
+    for (std::uint32_t y = 0; y < 4; ++y) {
+        for (std::uint32_t x = 0; x < 4; ++x) {
+            const auto srcX = std::min(blockX * 4 + x, width - 1);
+            const auto srcY = std::min(blockY * 4 + y, height - 1);
+            const auto src = (srcY * width + srcX) * 4;
+            const auto dst = (y * 4 + x) * 4;
+            for (int c = 0; c < 4; ++c) {
+                out[dst + c] = rgba[src + c];
+            }
+        }
+    }
+}
+
+std::array<std::uint8_t, 16> extractChannel(const std::array<std::uint8_t, 64>& rgba, int channel)
+{
+    std::array<std::uint8_t, 16> values;
+    for (int t = 0; t < 16; ++t) {
+        values[t] = rgba[t * 4 + channel];
+    }
+    return values;
+}
+
+/* mips */
+
+float srgbToLinear(float v)
+{
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSRGB(float v)
+{
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.f / 2.4f) - 0.055f;
+}
+
+std::uint8_t toUNorm8(float v)
+{
+    return (std::uint8_t)std::lround(std::clamp(v, 0.f, 1.f) * 255.f);
+}
+}
+
+namespace graphics
+{
+std::size_t getBlockSize(BlockCompression compression)
+{
+    return compression == BlockCompression::BC4 ? 8 : 16;
+}
+
+std::size_t getCompressedSize(
+    BlockCompression compression,
+    std::uint32_t width,
+    std::uint32_t height)
+{
+    const auto numBlocks = (std::size_t)((width + 3) / 4) * ((height + 3) / 4);
+    return numBlocks * getBlockSize(compression);
+}
+
+void encodeBC4Block(std::span<const std::uint8_t, 16> values, std::span<std::uint8_t, 8> block)
+{
+    const auto [minIt, maxIt] = std::minmax_element(values.begin(), values.end());
+    const auto palette = makeBC4Palette(*maxIt, *minIt);
+
+    std::uint64_t bits = 0;
+    for (int t = 0; t < 16; ++t) {
+        int bestIndex = 0;
+        int bestError = std::numeric_limits<int>::max();
+        for (int i = 0; i < 8; ++i) {
+            const auto error = std::abs(palette[i] - (int)values[t]);
+            if (error < bestError) {
+                bestError = error;
+                bestIndex = i;
+            }
+        }
+        bits |= (std::uint64_t)bestIndex << (t * 3);
+    }
+
+    block[0] = *maxIt;
+    block[1] = *minIt;
+    for (int i = 0; i < 6; ++i) {
+        block[2 + i] = (std::uint8_t)(bits >> (i * 8));
+    }
+}
+
+void decodeBC4Block(std::span<const std::uint8_t, 8> block, std::span<std::uint8_t, 16> values)
+{
+    const auto palette = makeBC4Palette(block[0], block[1]);
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) {
+        bits |= (std::uint64_t)block[2 + i] << (i * 8);
+    }
+    for (int t = 0; t < 16; ++t) {
+        values[t] = (std::uint8_t)palette[(bits >> (t * 3)) & 0x7];
+    }
+}
+
+void encodeBC7Block(std::span<const std::uint8_t, 64> rgba, std::span<std::uint8_t, 16> block)
+{
+    std::array<float, 4> e0, e1;
+    findInitialEndpoints(rgba, e0, e1);
+
+    Mode6Endpoints best{};
+    std::array<int, 16> bestIndices{};
+    int bestError = std::numeric_limits<int>::max();
+
+    std::array<int, 16> indices{};
+    for (int iter = 0; iter < 2; ++iter) {
+        for (int p = 0; p < 4; ++p) {
+            const auto endpoints = quantizeEndpoints(e0, e1, p & 1, p >> 1);
+            const auto error = findMode6Indices(rgba, endpoints, indices);
+            if (error < bestError) {
+                bestError = error;
+                best = endpoints;
+                bestIndices = indices;
+            }
+        }
+        if (bestError == 0 || !refitEndpoints(rgba, bestIndices, e0, e1)) {
+            break;
+        }
+    }
+
+    // the MSB of the first index is implicitly 0
+    if (bestIndices[0] >= 8) {
+        std::swap(best.q0, best.q1);
+        std::swap(best.p0, best.p1);
+        for (auto& index : bestIndices) {
+            index = 15 - index;
+        }
+    }
+
+    BlockBitWriter writer(block);
+    writer.write(1 << 6, 7); // mode 6
+    for (int c = 0; c < 4; ++c) {
+        writer.write(best.q0[c], 7);
+        writer.write(best.q1[c], 7);
+    }
+    writer.write(best.p0, 1);
+    writer.write(best.p1, 1);
+    writer.write(bestIndices[0], 3);
+    for (int t = 1; t < 16; ++t) {
+        writer.write(bestIndices[t], 4);
+    }
+}
+
+bool decodeBC7Block(std::span<const std::uint8_t, 16> block, std::span<std::uint8_t, 64> rgba)
+{
+    BlockBitReader reader(block);
+    if (reader.read(7) != (1 << 6)) {
+        return false;
+    }
+
+    Mode6Endpoints endpoints;
+    for (int c = 0; c < 4; ++c) {
+        endpoints.q0[c] = (int)reader.read(7);
+        endpoints.q1[c] = (int)reader.read(7);
+    }
+    endpoints.p0 = (int)reader.read(1);
+    endpoints.p1 = (int)reader.read(1);
+    const auto e0 = endpoints.getEndpoint0();
+    const auto e1 = endpoints.getEndpoint1();
+
+    for (int t = 0; t < 16; ++t) {
+        const auto index = reader.read(t == 0 ? 3 : 4);
+        for (int c = 0; c < 4; ++c) {
+            rgba[t * 4 + c] = (std::uint8_t)bc7Interpolate(e0[c], e1[c], BC7_WEIGHTS[index]);
+        }
+    }
+    return true;
+}
+
+std::vector<std::uint8_t> compressImage(
+    BlockCompression compression,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> rgba)
+{
+    assert(rgba.size() == (std::size_t)width * height * 4);
+    const auto blockSize = getBlockSize(compression);
+    std::vector<std::uint8_t> data(getCompressedSize(compression, width, height));
+
+    const auto numBlocksX = (width + 3) / 4;
+    const auto numBlocksY = (height + 3) / 4;
+    std::array<std::uint8_t, 64> texels;
+    for (std::uint32_t by = 0; by < numBlocksY; ++by) {
+        for (std::uint32_t bx = 0; bx < numBlocksX; ++bx) {
+            gatherBlock(rgba, width, height, bx, by, texels);
+            auto* block = data.data() + (by * numBlocksX + bx) * blockSize;
+            switch (compression) {
+            case BlockCompression::BC4:
+                encodeBC4Block(extractChannel(texels, 0), std::span<std::uint8_t, 8>{block, 8});
+                break;
+            case BlockCompression::BC5:
+                encodeBC4Block(extractChannel(texels, 0), std::span<std::uint8_t, 8>{block, 8});
+                encodeBC4Block(
+                    extractChannel(texels, 1), std::span<std::uint8_t, 8>{block + 8, 8});
+                break;
+            case BlockCompression::BC7:
+                encodeBC7Block(texels, std::span<std::uint8_t, 16>{block, 16});
+                break;
+            }
+        }
+    }
+    return data;
+}
+
+std::vector<std::uint8_t> decompressImage(
+    BlockCompression compression,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> data)
+{
+    assert(data.size() == getCompressedSize(compression, width, height));
+    const auto blockSize = getBlockSize(compression);
+    std::vector<std::uint8_t> rgba((std::size_t)width * height * 4);
+
+    const auto numBlocksX = (width + 3) / 4;
+    const auto numBlocksY = (height + 3) / 4;
+    std::array<std::uint8_t, 64> texels;
+    std::array<std::uint8_t, 16> red, green;
+    for (std::uint32_t by = 0; by < numBlocksY; ++by) {
+        for (std::uint32_t bx = 0; bx < numBlocksX; ++bx) {
+            const auto* block = data.data() + (by * numBlocksX + bx) * blockSize;
+            texels.fill(0);
+            switch (compression) {
+            case BlockCompression::BC4:
+            case BlockCompression::BC5:
+                decodeBC4Block(std::span<const std::uint8_t, 8>{block, 8}, red);
+                if (compression == BlockCompression::BC5) {
+                    decodeBC4Block(std::span<const std::uint8_t, 8>{block + 8, 8}, green);
+                }
+                for (int t = 0; t < 16; ++t) {
+                    texels[t * 4 + 0] = red[t];
+                    texels[t * 4 + 1] = (compression == BlockCompression::BC5) ? green[t] : 0;
+                    texels[t * 4 + 3] = 255;
+                }
+                break;
+            case BlockCompression::BC7:
+                decodeBC7Block(std::span<const std::uint8_t, 16>{block, 16}, texels);
+                break;
+            }
+
+            for (std::uint32_t y = 0; y < 4 && by * 4 + y < height; ++y) {
+                for (std::uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                    const auto dst = ((by * 4 + y) * width + bx * 4 + x) * 4;
+                    const auto src = (y * 4 + x) * 4;
+                    std::copy_n(texels.begin() + src, 4, rgba.begin() + dst);
+                }
+            }
+        }
+    }
+    return rgba;
+}
+
+std::vector<std::vector<std::uint8_t>> generateMipChain(
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> rgba,
+    MipFilter filter)
+{
+    assert(rgba.size() == (std::size_t)width * height * 4);
+
+    std::array<float, 256> toLinear;
+    for (int i = 0; i < 256; ++i) {
+        toLinear[i] = (filter == MipFilter::SRGB) ? srgbToLinear(i / 255.f) : i / 255.f;
+    }
+
+    std::vector<std::vector<std::uint8_t>> mips;
+    mips.emplace_back(rgba.begin(), rgba.end());
+    while (width > 1 || height > 1) {
+        const auto& src = mips.back();
+        const auto dstWidth = std::max(width / 2, 1u);
+        const auto dstHeight = std::max(height / 2, 1u);
+        std::vector<std::uint8_t> dst((std::size_t)dstWidth * dstHeight * 4);
+
+        for (std::uint32_t y = 0; y < dstHeight; ++y) {
+            for (std::uint32_t x = 0; x < dstWidth; ++x) {
+                const std::array<std::uint32_t, 2> xs{
+                    std::min(x * 2, width - 1), std::min(x * 2 + 1, width - 1)};
+                const std::array<std::uint32_t, 2> ys{
+                    std::min(y * 2, height - 1), std::min(y * 2 + 1, height - 1)};
+
+                std::array<float, 4> sum{};
+                for (const auto sy : ys) {
+                    for (const auto sx : xs) {
+                        const auto* texel = &src[(sy * width + sx) * 4];
+                        for (int c = 0; c < 3; ++c) {
+                            sum[c] += (filter == MipFilter::NormalMap) ?
+                                          texel[c] / 255.f * 2.f - 1.f :
+                                          toLinear[texel[c]];
+                        }
+                        sum[3] += texel[3] / 255.f;
+                    }
+                }
+
+                auto* out = &dst[(y * dstWidth + x) * 4];
+                if (filter == MipFilter::NormalMap) {
+                    const auto len = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                    for (int c = 0; c < 3; ++c) {
+                        const auto n = len > 1e-6f ? sum[c] / len : (c == 2 ? 1.f : 0.f);
+                        out[c] = toUNorm8(n * 0.5f + 0.5f);
+                    }
+                } else {
+                    for (int c = 0; c < 3; ++c) {
+                        const auto v = sum[c] / 4.f;
+                        out[c] = toUNorm8(filter == MipFilter::SRGB ? linearToSRGB(v) : v);
+                    }
+                }
+                out[3] = toUNorm8(sum[3] / 4.f);
+            }
+        }
+
+        mips.push_back(std::move(dst));
+        width = dstWidth;
+        height = dstHeight;
+    }
+    return mips;
+}
+}
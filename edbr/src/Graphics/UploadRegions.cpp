@@ -0,0 +1,95 @@
+#include <edbr/Graphics/UploadRegions.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+bool regionsOverlap(const VkBufferCopy& a, const VkBufferCopy& b)
+{
+    return a.dstOffset < b.dstOffset + b.size && b.dstOffset < a.dstOffset + a.size;
+}
+}
+
+namespace graphics
+{
+ImageUploadRegions makeImageUploadRegions(
+    const VkExtent3D& extent,
+    std::span<const ImageSubresourceUpload> subresources,
+    std::size_t alignment)
+{
+    ImageUploadRegions upload;
+    upload.regions.reserve(subresources.size());
+    for (const auto& sub : subresources) {
+        const auto offset = (upload.stagingSize + alignment - 1) / alignment * alignment;
+        upload.regions.push_back(VkBufferImageCopy{
+            .bufferOffset = offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = sub.mipLevel,
+                    .baseArrayLayer = sub.layer,
+                    .layerCount = 1,
+                },
+            .imageExtent =
+                {
+                    .width = std::max(extent.width >> sub.mipLevel, 1u),
+                    .height = std::max(extent.height >> sub.mipLevel, 1u),
+                    .depth = 1,
+                },
+        });
+        upload.stagingSize = offset + sub.data.size();
+    }
+    return upload;
+}
+
+std::vector<BufferUploadBatch> coalesceBufferUploads(std::span<const BufferUploadRegion> uploads)
+{
+    std::vector<BufferUploadBatch> batches;
+    // [min, max) of dst offsets of each batch - lets most copies skip the overlap check
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> dstRanges;
+    for (const auto& upload : uploads) {
+        if (upload.region.size == 0) {
+            continue;
+        }
+
+        // only the last batch for each buffer can be appended to,
+        // otherwise the order of overlapping copies would change
+        const auto dstBegin = upload.region.dstOffset;
+        const auto dstEnd = upload.region.dstOffset + upload.region.size;
+        auto it = std::find_if(batches.rbegin(), batches.rend(), [&upload](const auto& batch) {
+            return batch.dstBuffer == upload.dstBuffer;
+        });
+        if (it != batches.rend()) {
+            auto& regions = it->regions;
+            auto& dstRange = dstRanges[std::distance(it, batches.rend()) - 1];
+            const auto overlaps =
+                dstBegin < dstRange.second && dstRange.first < dstEnd &&
+                std::any_of(regions.begin(), regions.end(), [&upload](const auto& region) {
+                    return regionsOverlap(region, upload.region);
+                });
+            if (!overlaps) {
+                dstRange.first = std::min(dstRange.first, dstBegin);
+                dstRange.second = std::max(dstRange.second, dstEnd);
+                auto& last = regions.back();
+                if (last.srcOffset + last.size == upload.region.srcOffset &&
+                    last.dstOffset + last.size == upload.region.dstOffset) {
+                    last.size += upload.region.size;
+                } else {
+                    regions.push_back(upload.region);
+                }
+                continue;
+            }
+        }
+
+        batches.push_back(BufferUploadBatch{
+            .dstBuffer = upload.dstBuffer,
+            .regions = {upload.region},
+        });
+        dstRanges.emplace_back(dstBegin, dstEnd);
+    }
+    return batches;
+}
+}
@@ -0,0 +1,72 @@
+#include <edbr/Graphics/UploadRingAllocator.h>
+
+#include <cassert>
+
+UploadRingAllocator::UploadRingAllocator(std::size_t capacity) : capacity(capacity)
+{}
+
+std::optional<std::size_t> UploadRingAllocator::allocate(std::size_t size, std::size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "alignment must be pow2");
+    if (size == 0 || size > capacity || usedSize == capacity) {
+        return std::nullopt;
+    }
+
+    if (usedSize == 0) {
+        // nothing is in use - start from the beginning to have the most space
+        head = 0;
+        tail = 0;
+    }
+
+    const auto alignedHead = (head + alignment - 1) & ~(alignment - 1);
+    std::size_t offset = 0;
+    if (head >= tail) {
+        // free space is [head, capacity) and [0, tail)
+        if (alignedHead + size <= capacity) {
+            offset = alignedHead;
+        } else if (size <= tail) {
+            offset = 0; // the end of the buffer is skipped
+        } else {
+            return std::nullopt;
+        }
+    } else {
+        // free space is [head, tail)
+        if (alignedHead + size > tail) {
+            return std::nullopt;
+        }
+        offset = alignedHead;
+    }
+
+    const auto newHead = offset + size;
+    const auto consumed = (offset >= head) ? newHead - head : (capacity - head) + newHead;
+    head = newHead;
+    usedSize += consumed;
+    currentBatchSize += consumed;
+    return offset;
+}
+
+void UploadRingAllocator::endBatch(std::uint64_t submitValue)
+{
+    if (currentBatchSize == 0) {
+        return;
+    }
+    assert(batches.empty() || batches.back().submitValue <= submitValue);
+    batches.push_back(Batch{.submitValue = submitValue, .size = currentBatchSize});
+    currentBatchSize = 0;
+}
+
+void UploadRingAllocator::release(std::uint64_t completedValue)
+{
+    while (!batches.empty() && batches.front().submitValue <= completedValue) {
+        const auto& batch = batches.front();
+        tail = (tail + batch.size) % capacity;
+        usedSize -= batch.size;
+        batches.pop_front();
+    }
+}
+
+std::uint64_t UploadRingAllocator::getOldestBatchValue() const
+{
+    assert(!batches.empty());
+    return batches.front().submitValue;
+}
@@ -0,0 +1,235 @@
+#include <edbr/Graphics/VertexQuantization.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+constexpr float UNORM16_MAX = 65535.f;
+constexpr float SNORM16_MAX = 32767.f;
+
+float fromSnorm16(std::int16_t v)
+{
+    return std::max((float)v / SNORM16_MAX, -1.f);
+}
+
+glm::vec2 signNotZero(const glm::vec2& v)
+{
+    return {v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f};
+}
+
+// Rounding each component separately isn't the closest snorm16 pair, so all
+// four floor/ceil combinations are tried
+std::array<std::int16_t, 2> encodeOctahedralSnorm16(const glm::vec3& v)
+{
+    const auto len = glm::length(v);
+    // zero normals are encoded as some valid direction
+    const auto n = len > 0.f ? v / len : glm::vec3{1.f, 0.f, 0.f};
+    const auto e = glm::clamp(graphics::encodeOctahedral(n), -1.f, 1.f) * SNORM16_MAX;
+
+    auto best = std::array<std::int16_t, 2>{};
+    auto bestDot = -std::numeric_limits<float>::max();
+    for (int i = 0; i < 4; ++i) {
+        const auto x = (i & 1) ? std::ceil(e.x) : std::floor(e.x);
+        const auto y = (i & 2) ? std::ceil(e.y) : std::floor(e.y);
+        const auto candidate = std::array{(std::int16_t)x, (std::int16_t)y};
+        const auto decoded = graphics::decodeOctahedral(
+            {fromSnorm16(candidate[0]), fromSnorm16(candidate[1])});
+        const auto d = glm::dot(decoded, n);
+        if (d > bestDot) {
+            bestDot = d;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+glm::vec3 decodeOctahedralSnorm16(const std::array<std::int16_t, 2>& e)
+{
+    return graphics::decodeOctahedral({fromSnorm16(e[0]), fromSnorm16(e[1])});
+}
+
+// Orthonormal basis of the plane orthogonal to n, see "Building an Orthonormal
+// Basis, Revisited" (Duff et al.). Keep in sync with vertex.glsl
+void makeTangentBasis(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
+{
+    const auto sign = n.z >= 0.f ? 1.f : -1.f;
+    const auto a = -1.f / (sign + n.z);
+    const auto c = n.x * n.y * a;
+    t = {1.f + sign * n.x * n.x * a, sign * c, -sign * n.x};
+    b = {c, sign + n.y * n.y * a, -n.y};
+}
+
+constexpr std::uint16_t TANGENT_ANGLE_MASK = 0x7fff;
+constexpr std::uint16_t TANGENT_SIGN_BIT = 0x8000;
+constexpr float TANGENT_ANGLE_STEPS = 32768.f;
+}
+
+namespace graphics
+{
+glm::vec2 encodeOctahedral(const glm::vec3& n)
+{
+    const auto p = glm::vec2{n.x, n.y} / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+    if (n.z >= 0.f) {
+        return p;
+    }
+    // fold the lower hemisphere over the diagonals
+    return (1.f - glm::abs(glm::vec2{p.y, p.x})) * signNotZero(p);
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& e)
+{
+    auto n = glm::vec3{e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y)};
+    if (n.z < 0.f) {
+        const auto xy = (1.f - glm::abs(glm::vec2{n.y, n.x})) * signNotZero({n.x, n.y});
+        n.x = xy.x;
+        n.y = xy.y;
+    }
+    return glm::normalize(n);
+}
+
+std::uint16_t encodeTangent(const glm::vec3& normal, const glm::vec4& tangent)
+{
+    glm::vec3 t, b;
+    makeTangentBasis(normal, t, b);
+    const auto tangentDir = glm::vec3{tangent};
+    auto angle = std::atan2(glm::dot(tangentDir, b), glm::dot(tangentDir, t)); // [-pi, pi]
+    if (angle < 0.f) {
+        angle += glm::two_pi<float>();
+    }
+    const auto steps = (int)std::round(angle / glm::two_pi<float>() * TANGENT_ANGLE_STEPS);
+    auto encoded = (std::uint16_t)(steps & TANGENT_ANGLE_MASK); // 2pi wraps to 0
+    if (tangent.w < 0.f) {
+        encoded |= TANGENT_SIGN_BIT;
+    }
+    return encoded;
+}
+
+glm::vec4 decodeTangent(const glm::vec3& normal, std::uint16_t tangent)
+{
+    glm::vec3 t, b;
+    makeTangentBasis(normal, t, b);
+    const auto angle =
+        (float)(tangent & TANGENT_ANGLE_MASK) / TANGENT_ANGLE_STEPS * glm::two_pi<float>();
+    return glm::vec4{
+        std::cos(angle) * t + std::sin(angle) * b,
+        (tangent & TANGENT_SIGN_BIT) ? -1.f : 1.f,
+    };
+}
+
+CompactVertexHeader makeCompactVertexHeader(std::span<const CPUMesh::Vertex> vertices)
+{
+    if (vertices.empty()) {
+        return {};
+    }
+
+    auto minPos = vertices[0].position;
+    auto maxPos = vertices[0].position;
+    for (const auto& v : vertices) {
+        minPos = glm::min(minPos, v.position);
+        maxPos = glm::max(maxPos, v.position);
+    }
+    return CompactVertexHeader{
+        .positionMin = minPos,
+        .positionScale = maxPos - minPos,
+    };
+}
+
+CompactVertex encodeCompactVertex(const CPUMesh::Vertex& vertex, const CompactVertexHeader& header)
+{
+    auto v = CompactVertex{
+        .normal = encodeOctahedralSnorm16(vertex.normal),
+        .uv = {glm::packHalf1x16(vertex.uv_x), glm::packHalf1x16(vertex.uv_y)},
+    };
+    v.tangent = encodeTangent(decodeOctahedralSnorm16(v.normal), vertex.tangent);
+    for (int i = 0; i < 3; ++i) {
+        const auto scale = header.positionScale[i];
+        const auto t = scale > 0.f ? (vertex.position[i] - header.positionMin[i]) / scale : 0.f;
+        v.position[i] = (std::uint16_t)std::round(std::clamp(t, 0.f, 1.f) * UNORM16_MAX);
+    }
+    return v;
+}
+
+CPUMesh::Vertex decodeCompactVertex(const CompactVertex& vertex, const CompactVertexHeader& header)
+{
+    const auto q = glm::vec3{vertex.position[0], vertex.position[1], vertex.position[2]};
+    const auto normal = decodeOctahedralSnorm16(vertex.normal);
+    return CPUMesh::Vertex{
+        .position = header.positionMin + q / UNORM16_MAX * header.positionScale,
+        .uv_x = glm::unpackHalf1x16(vertex.uv[0]),
+        .normal = normal,
+        .uv_y = glm::unpackHalf1x16(vertex.uv[1]),
+        .tangent = decodeTangent(normal, vertex.tangent),
+    };
+}
+
+bool canUseCompactSkinningData(std::span<const CPUMesh::SkinningData> skinningData)
+{
+    for (const auto& sd : skinningData) {
+        for (int i = 0; i < 4; ++i) {
+            if (sd.jointIds[i] > std::numeric_limits<std::uint8_t>::max()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+CompactSkinningData encodeCompactSkinningData(const CPUMesh::SkinningData& skinningData)
+{
+    auto sd = CompactSkinningData{};
+    const auto weightSum =
+        skinningData.weights.x + skinningData.weights.y + skinningData.weights.z +
+        skinningData.weights.w;
+    std::uint32_t quantizedSum = 0;
+    for (int i = 0; i < 4; ++i) {
+        assert(skinningData.jointIds[i] <= std::numeric_limits<std::uint8_t>::max());
+        sd.jointIds[i] = (std::uint8_t)skinningData.jointIds[i];
+        const auto w = weightSum > 0.f ? skinningData.weights[i] / weightSum : 0.f;
+        sd.weights[i] = (std::uint16_t)std::round(std::clamp(w, 0.f, 1.f) * UNORM16_MAX);
+        quantizedSum += sd.weights[i];
+    }
+
+    // rounding errors go to the biggest weight, so that the weights still sum up to 1
+    if (quantizedSum > 0) {
+        auto& biggest = *std::max_element(sd.weights.begin(), sd.weights.end());
+        biggest = (std::uint16_t)((int)biggest + (int)UNORM16_MAX - (int)quantizedSum);
+    }
+    return sd;
+}
+
+CPUMesh::SkinningData decodeCompactSkinningData(const CompactSkinningData& skinningData)
+{
+    auto sd = CPUMesh::SkinningData{};
+    for (int i = 0; i < 4; ++i) {
+        sd.jointIds[i] = skinningData.jointIds[i];
+        sd.weights[i] = (float)skinningData.weights[i] / UNORM16_MAX;
+    }
+    return sd;
+}
+
+CompactMeshData encodeCompactMesh(
+    std::span<const CPUMesh::Vertex> vertices,
+    std::span<const CPUMesh::SkinningData> skinningData)
+{
+    auto mesh = CompactMeshData{
+        .header = makeCompactVertexHeader(vertices),
+    };
+    mesh.vertices.reserve(vertices.size());
+    for (const auto& v : vertices) {
+        mesh.vertices.push_back(encodeCompactVertex(v, mesh.header));
+    }
+    mesh.skinningData.reserve(skinningData.size());
+    for (const auto& sd : skinningData) {
+        mesh.skinningData.push_back(encodeCompactSkinningData(sd));
+    }
+    return mesh;
+}
+}
@@ -19,6 +19,7 @@ void transitionImage(
 {
     VkImageAspectFlags aspectMask =
         (currentLayout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL ||
+         currentLayout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL ||
          newLayout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL ||
          newLayout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL) ?
             VK_IMAGE_ASPECT_DEPTH_BIT :
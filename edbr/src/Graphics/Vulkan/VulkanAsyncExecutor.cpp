@@ -0,0 +1,116 @@
+#include <edbr/Graphics/Vulkan/VulkanAsyncExecutor.h>
+
+#include <volk.h>
+
+#include <edbr/Graphics/Vulkan/Init.h>
+#include <edbr/Graphics/Vulkan/Util.h>
+
+namespace
+{
+static constexpr auto NO_TIMEOUT = std::numeric_limits<std::uint64_t>::max();
+}
+
+void VulkanAsyncExecutor::init(VkDevice device, std::uint32_t queueFamily, VkQueue queue)
+{
+    assert(!initialized);
+
+    this->device = device;
+    this->queue = queue;
+
+    const auto poolCreateInfo =
+        vkinit::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queueFamily);
+    VK_CHECK(vkCreateCommandPool(device, &poolCreateInfo, nullptr, &commandPool));
+
+    const auto typeCreateInfo = VkSemaphoreTypeCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreCreateInfo = VkSemaphoreCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &typeCreateInfo,
+    };
+    VK_CHECK(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &timelineSemaphore));
+
+    initialized = true;
+}
+
+void VulkanAsyncExecutor::cleanup(VkDevice device)
+{
+    assert(initialized);
+    wait(lastSubmittedValue);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    vkDestroySemaphore(device, timelineSemaphore, nullptr);
+}
+
+std::uint64_t VulkanAsyncExecutor::submit(std::function<void(VkCommandBuffer cmd)>&& function)
+{
+    assert(initialized);
+
+    auto cmd = acquireCommandBuffer();
+    const auto cmdBeginInfo = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    VK_CHECK(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
+    function(cmd);
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    const auto value = ++lastSubmittedValue;
+    const auto cmdInfo = vkinit::commandBufferSubmitInfo(cmd);
+    auto signalInfo =
+        vkinit::semaphoreSubmitInfo(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, timelineSemaphore);
+    signalInfo.value = value;
+    const auto submit = vkinit::submitInfo(&cmdInfo, nullptr, &signalInfo);
+
+    VK_CHECK(vkQueueSubmit2(queue, 1, &submit, VK_NULL_HANDLE));
+
+    submissions.push_back({.cmd = cmd, .value = value});
+    return value;
+}
+
+std::uint64_t VulkanAsyncExecutor::getCompletedValue() const
+{
+    assert(initialized);
+    std::uint64_t value{0};
+    VK_CHECK(vkGetSemaphoreCounterValue(device, timelineSemaphore, &value));
+    return value;
+}
+
+void VulkanAsyncExecutor::wait(std::uint64_t value) const
+{
+    assert(initialized);
+    const auto waitInfo = VkSemaphoreWaitInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &timelineSemaphore,
+        .pValues = &value,
+    };
+    VK_CHECK(vkWaitSemaphores(device, &waitInfo, NO_TIMEOUT));
+}
+
+VkCommandBuffer VulkanAsyncExecutor::acquireCommandBuffer()
+{
+    // reuse command buffers of completed submissions
+    const auto completedValue = getCompletedValue();
+    std::erase_if(submissions, [this, completedValue](const Submission& s) {
+        if (s.value <= completedValue) {
+            freeCommandBuffers.push_back(s.cmd);
+            return true;
+        }
+        return false;
+    });
+
+    if (!freeCommandBuffers.empty()) {
+        const auto cmd = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+        VK_CHECK(vkResetCommandBuffer(cmd, 0));
+        return cmd;
+    }
+
+    VkCommandBuffer cmd;
+    const auto cmdAllocInfo = vkinit::commandBufferAllocateInfo(commandPool, 1);
+    VK_CHECK(vkAllocateCommandBuffers(device, &cmdAllocInfo, &cmd));
+    return cmd;
+}
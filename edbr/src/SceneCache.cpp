@@ -2,18 +2,70 @@
 
 #include <fmt/printf.h>
 
+#include <edbr/Graphics/AnimationCompression.h>
+#include <edbr/Graphics/GfxDevice.h>
+#include <edbr/Graphics/MeshCache.h>
 #include <edbr/Graphics/SkeletalAnimationCache.h>
+#include <edbr/Util/CookedScene.h>
 #include <edbr/Util/GltfLoader.h>
 
+namespace
+{
+// can be called from any thread
+DecodedScene decodeScene(const std::filesystem::path& path)
+{
+    // cooked scenes are made by scene_cooker
+    if (util::isCookedSceneUpToDate(path)) {
+        const auto cookedPath = util::getCookedScenePath(path);
+        fmt::print("Loading cooked scene '{}'\n", cookedPath.string());
+        if (auto cookedScene = util::readCookedScene(cookedPath); cookedScene) {
+            return std::move(*cookedScene);
+        }
+        fmt::print("Failed to read cooked scene '{}', using gltf\n", cookedPath.string());
+    }
+
+    fmt::print("Loading gltf scene '{}'\n", path.string());
+    auto data = util::loadGltfSceneData(path);
+    // cooked scenes already have compressed animations
+    auto& scene = data.scene;
+    for (const auto& [name, animation] : scene.animations) {
+        scene.compressedAnimations.emplace(name, graphics::compressAnimation(animation));
+    }
+    scene.animations.clear();
+    return data;
+}
+}
+
 SceneCache::SceneCache(
     GfxDevice& gfxDevice,
     MeshCache& meshCache,
     MaterialCache& materialCache,
-    SkeletalAnimationCache& animationCache) :
+    SkeletalAnimationCache& animationCache,
+    TaskQueue& taskQueue) :
     gfxDevice(gfxDevice),
     meshCache(meshCache),
     materialCache(materialCache),
-    animationCache(animationCache)
+    animationCache(animationCache),
+    asyncLoader(
+        taskQueue,
+        {
+            .decode = decodeScene,
+            .upload =
+                [this](const std::filesystem::path& path, DecodedScene decoded) {
+                    return uploadScene(path, std::move(decoded));
+                },
+            .submit = [this]() { return this->gfxDevice.flushUploads(); },
+            .isUploadComplete =
+                [this](std::uint64_t value) {
+                    return this->gfxDevice.isAsyncSubmitComplete(value);
+                },
+            .waitForUpload =
+                [this](std::uint64_t value) { this->gfxDevice.waitForAsyncSubmit(value); },
+            .onLoaded =
+                [this](const std::filesystem::path& path, Scene scene) {
+                    addLoadedScene(path, std::move(scene));
+                },
+        })
 {}
 
 const Scene& SceneCache::addScene(const std::string& scenePath, Scene scene)
@@ -41,15 +93,54 @@ const Scene& SceneCache::loadOrGetScene(const std::filesystem::path& path)
         return it->second;
     }
 
-    fmt::print("Loading gltf scene '{}'\n", path.string());
+    if (const auto handle = asyncLoader.findLoadingScene(path); handle.isValid()) {
+        asyncLoader.wait(handle);
+        return getScene(path.string());
+    }
+
+    auto scene = uploadScene(path, decodeScene(path));
+    // the scene can be used right away: the upload is submitted before anything else
+    gfxDevice.flushUploads();
+    return addLoadedScene(path, std::move(scene));
+}
 
-    auto scene = util::loadGltfFile(gfxDevice, meshCache, materialCache, path);
-    if (!scene.animations.empty()) {
-        // NOTE: we don't move here so that the returned/cached scene still
-        // has animations inspectable in it
-        animationCache.addAnimations(path, scene.animations);
+SceneLoadHandle SceneCache::loadSceneAsync(const std::filesystem::path& path)
+{
+    if (sceneCache.contains(path.string())) {
+        return SceneLoadHandle::makeReady(path);
+    }
+    return asyncLoader.load(path);
+}
+
+void SceneCache::update()
+{
+    asyncLoader.update();
+}
+
+Scene SceneCache::uploadScene(const std::filesystem::path& path, DecodedScene decoded)
+{
+    auto scene = std::holds_alternative<CookedScene>(decoded) ?
+                     util::loadCookedScene(
+                         gfxDevice,
+                         meshCache,
+                         materialCache,
+                         std::move(std::get<CookedScene>(decoded))) :
+                     util::uploadGltfSceneData(
+                         gfxDevice,
+                         meshCache,
+                         materialCache,
+                         std::move(std::get<SceneData>(decoded)));
+    scene.path = path;
+    return scene;
+}
+
+const Scene& SceneCache::addLoadedScene(const std::filesystem::path& path, Scene scene)
+{
+    if (!scene.compressedAnimations.empty()) {
+        animationCache.addAnimations(path, std::move(scene.compressedAnimations));
+        scene.compressedAnimations.clear();
     }
-    const auto [it2, inserted] = sceneCache.emplace(path.string(), std::move(scene));
+    const auto [it, inserted] = sceneCache.emplace(path.string(), std::move(scene));
     assert(inserted);
-    return it2->second;
+    return it->second;
 }
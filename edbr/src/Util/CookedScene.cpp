@@ -0,0 +1,605 @@
+#include <edbr/Util/CookedScene.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+#include <edbr/Graphics/AnimationCompression.h>
+#include <edbr/Graphics/AnimationSampling.h>
+#include <edbr/Graphics/MaterialCache.h>
+#include <edbr/Math/Util.h>
+
+namespace
+{
+constexpr std::uint32_t COOKED_SCENE_MAGIC = 0x43534445; // "EDSC"
+constexpr std::size_t ARRAY_ALIGNMENT = 16;
+
+struct Header {
+    std::uint32_t magic{COOKED_SCENE_MAGIC};
+    std::uint32_t version{util::COOKED_SCENE_VERSION};
+    // catch layout changes which didn't bump the version
+    std::uint32_t vertexSize{sizeof(CPUMesh::Vertex)};
+    std::uint32_t skinningDataSize{sizeof(CPUMesh::SkinningData)};
+    std::uint32_t meshletSize{sizeof(Meshlet)};
+
+    bool isValid() const
+    {
+        const Header current{};
+        return magic == current.magic && version == current.version &&
+               vertexSize == current.vertexSize &&
+               skinningDataSize == current.skinningDataSize &&
+               meshletSize == current.meshletSize;
+    }
+};
+
+class BinaryWriter {
+public:
+    template<typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(&value, sizeof(T));
+    }
+
+    // arrays are aligned, so that they can be used from the mapped file directly
+    template<typename T>
+    void writeArray(std::span<const T> values)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= ARRAY_ALIGNMENT);
+        write((std::uint32_t)values.size());
+        data.resize((data.size() + ARRAY_ALIGNMENT - 1) / ARRAY_ALIGNMENT * ARRAY_ALIGNMENT);
+        append(values.data(), values.size_bytes());
+    }
+
+    void writeString(const std::string& str)
+    {
+        write((std::uint32_t)str.size());
+        append(str.data(), str.size());
+    }
+
+    const std::vector<std::byte>& getData() const { return data; }
+
+private:
+    void append(const void* ptr, std::size_t size)
+    {
+        const auto* bytes = static_cast<const std::byte*>(ptr);
+        data.insert(data.end(), bytes, bytes + size);
+    }
+
+    std::vector<std::byte> data;
+};
+
+// All reads are bounds checked: after the first failed read, isGood returns
+// false and all the other reads return empty values
+class BinaryReader {
+public:
+    explicit BinaryReader(std::span<const std::byte> data) : data(data) {}
+
+    template<typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (canRead(sizeof(T))) {
+            std::memcpy(&value, &data[offset], sizeof(T));
+            offset += sizeof(T);
+        }
+        return value;
+    }
+
+    template<typename T>
+    std::span<const T> readArray()
+    {
+        const auto count = read<std::uint32_t>();
+        offset = (offset + ARRAY_ALIGNMENT - 1) / ARRAY_ALIGNMENT * ARRAY_ALIGNMENT;
+        if (!canRead((std::size_t)count * sizeof(T))) {
+            return {};
+        }
+        const auto* ptr = reinterpret_cast<const T*>(&data[offset]);
+        offset += count * sizeof(T);
+        return {ptr, count};
+    }
+
+    template<typename T>
+    std::vector<T> readVector()
+    {
+        const auto values = readArray<T>();
+        return {values.begin(), values.end()};
+    }
+
+    std::string readString()
+    {
+        const auto size = read<std::uint32_t>();
+        if (!canRead(size)) {
+            return {};
+        }
+        std::string str(reinterpret_cast<const char*>(&data[offset]), size);
+        offset += size;
+        return str;
+    }
+
+    bool isGood() const { return good; }
+
+private:
+    bool canRead(std::size_t size)
+    {
+        good = good && offset <= data.size() && size <= data.size() - offset;
+        return good;
+    }
+
+    std::span<const std::byte> data;
+    std::size_t offset{0};
+    bool good{true};
+};
+
+void writeTransform(BinaryWriter& writer, const Transform& transform)
+{
+    writer.write(transform.getPosition());
+    writer.write(transform.getHeading());
+    writer.write(transform.getScale());
+}
+
+Transform readTransform(BinaryReader& reader)
+{
+    Transform transform;
+    transform.setPosition(reader.read<glm::vec3>());
+    transform.setHeading(reader.read<glm::quat>());
+    transform.setScale(reader.read<glm::vec3>());
+    return transform;
+}
+
+void writePath(
+    BinaryWriter& writer,
+    const std::filesystem::path& path,
+    const std::filesystem::path& sceneDir)
+{
+    // paths are relative to the scene, so that cooked files can be moved with it
+    writer.writeString(path.empty() ? std::string{} : path.lexically_relative(sceneDir).string());
+}
+
+std::filesystem::path readPath(BinaryReader& reader, const std::filesystem::path& sceneDir)
+{
+    const auto str = reader.readString();
+    return str.empty() ? std::filesystem::path{} : sceneDir / str;
+}
+
+void writeNode(BinaryWriter& writer, const SceneNode& node)
+{
+    writer.writeString(node.name);
+    writeTransform(writer, node.transform);
+    writer.write((std::int32_t)node.meshIndex);
+    writer.write((std::int32_t)node.skinId);
+    writer.write((std::int32_t)node.lightId);
+    writer.write((std::int32_t)node.cameraId);
+    writer.write((std::uint32_t)node.children.size());
+    for (const auto& child : node.children) {
+        writeNode(writer, *child);
+    }
+}
+
+void readNode(BinaryReader& reader, SceneNode& node)
+{
+    node.name = reader.readString();
+    node.transform = readTransform(reader);
+    node.meshIndex = reader.read<std::int32_t>();
+    node.skinId = reader.read<std::int32_t>();
+    node.lightId = reader.read<std::int32_t>();
+    node.cameraId = reader.read<std::int32_t>();
+    const auto numChildren = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numChildren && reader.isGood(); ++i) {
+        auto& child = node.children.emplace_back(std::make_unique<SceneNode>());
+        child->parent = &node;
+        readNode(reader, *child);
+    }
+}
+
+void writeMaterials(
+    BinaryWriter& writer,
+    const std::vector<SceneMaterial>& materials,
+    const std::filesystem::path& sceneDir)
+{
+    writer.write((std::uint32_t)materials.size());
+    for (const auto& sm : materials) {
+        const auto& material = sm.material;
+        writer.writeString(material.name);
+        writer.write(material.baseColor);
+        writer.write(material.metallicFactor);
+        writer.write(material.roughnessFactor);
+        writer.write(material.emissiveFactor);
+        writePath(writer, sm.diffuseTexture, sceneDir);
+        writePath(writer, sm.normalMapTexture, sceneDir);
+        writePath(writer, sm.metallicRoughnessTexture, sceneDir);
+        writePath(writer, sm.emissiveTexture, sceneDir);
+    }
+}
+
+void readMaterials(
+    BinaryReader& reader,
+    std::vector<SceneMaterial>& materials,
+    const std::filesystem::path& sceneDir)
+{
+    const auto numMaterials = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numMaterials && reader.isGood(); ++i) {
+        auto& sm = materials.emplace_back();
+        auto& material = sm.material;
+        material.name = reader.readString();
+        material.baseColor = reader.read<LinearColor>();
+        material.metallicFactor = reader.read<float>();
+        material.roughnessFactor = reader.read<float>();
+        material.emissiveFactor = reader.read<float>();
+        sm.diffuseTexture = readPath(reader, sceneDir);
+        sm.normalMapTexture = readPath(reader, sceneDir);
+        sm.metallicRoughnessTexture = readPath(reader, sceneDir);
+        sm.emissiveTexture = readPath(reader, sceneDir);
+    }
+}
+
+void writeMeshes(BinaryWriter& writer, const std::vector<std::vector<ScenePrimitive>>& meshes)
+{
+    writer.write((std::uint32_t)meshes.size());
+    for (const auto& primitives : meshes) {
+        writer.write((std::uint32_t)primitives.size());
+        for (const auto& primitive : primitives) {
+            const auto& mesh = primitive.mesh;
+            writer.writeString(mesh.name);
+            writer.write((std::int32_t)primitive.materialIndex);
+            writer.write(mesh.minPos);
+            writer.write(mesh.maxPos);
+
+            // calculated here, so that MeshCache doesn't need to do it on load
+            std::vector<glm::vec3> positions(mesh.vertices.size());
+            for (std::size_t i = 0; i < mesh.vertices.size(); ++i) {
+                positions[i] = mesh.vertices[i].position;
+            }
+            writer.write(util::calculateBoundingSphere(positions));
+
+            writer.writeArray(std::span{mesh.vertices});
+            writer.writeArray(std::span{mesh.indices});
+            if (mesh.hasSkeleton) {
+                writer.writeArray(std::span{mesh.skinningData});
+            } else {
+                writer.writeArray(std::span<const CPUMesh::SkinningData>{});
+            }
+            writer.write((std::uint32_t)mesh.lods.size());
+            for (const auto& lod : mesh.lods) {
+                writer.write(lod.error);
+                writer.writeArray(std::span{lod.indices});
+            }
+            writer.writeArray(std::span{mesh.meshlets});
+        }
+    }
+}
+
+void readMeshes(BinaryReader& reader, std::vector<std::vector<CookedScene::Primitive>>& meshes)
+{
+    const auto numMeshes = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numMeshes && reader.isGood(); ++i) {
+        auto& primitives = meshes.emplace_back();
+        const auto numPrimitives = reader.read<std::uint32_t>();
+        for (std::uint32_t j = 0; j < numPrimitives && reader.isGood(); ++j) {
+            auto& primitive = primitives.emplace_back();
+            primitive.name = reader.readString();
+            primitive.materialIndex = reader.read<std::int32_t>();
+            auto& mesh = primitive.mesh;
+            mesh.minPos = reader.read<glm::vec3>();
+            mesh.maxPos = reader.read<glm::vec3>();
+            mesh.boundingSphere = reader.read<math::Sphere>();
+            mesh.vertices = reader.readArray<CPUMesh::Vertex>();
+            mesh.indices = reader.readArray<std::uint32_t>();
+            mesh.skinningData = reader.readArray<CPUMesh::SkinningData>();
+            const auto numLODs = reader.read<std::uint32_t>();
+            for (std::uint32_t k = 0; k < numLODs && reader.isGood(); ++k) {
+                const auto error = reader.read<float>();
+                mesh.lods.push_back(MeshLODView{
+                    .indices = reader.readArray<std::uint32_t>(),
+                    .error = error,
+                });
+            }
+            mesh.meshlets = reader.readArray<Meshlet>();
+        }
+    }
+}
+
+void writeSkeletons(BinaryWriter& writer, const std::vector<Skeleton>& skeletons)
+{
+    writer.write((std::uint32_t)skeletons.size());
+    for (const auto& skeleton : skeletons) {
+        writer.write((std::uint32_t)skeleton.joints.size());
+        for (std::size_t i = 0; i < skeleton.joints.size(); ++i) {
+            writeTransform(writer, skeleton.joints[i].localTransform);
+            writer.writeString(skeleton.jointNames[i]);
+            writer.writeArray(std::span{skeleton.hierarchy[i].children});
+        }
+        writer.writeArray(std::span{skeleton.inverseBindMatrices});
+    }
+}
+
+void readSkeletons(BinaryReader& reader, std::vector<Skeleton>& skeletons)
+{
+    const auto numSkeletons = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numSkeletons && reader.isGood(); ++i) {
+        auto& skeleton = skeletons.emplace_back();
+        const auto numJoints = reader.read<std::uint32_t>();
+        for (std::uint32_t j = 0; j < numJoints && reader.isGood(); ++j) {
+            skeleton.joints.push_back(Joint{
+                .id = (JointId)j,
+                .localTransform = readTransform(reader),
+            });
+            skeleton.jointNames.push_back(reader.readString());
+            skeleton.hierarchy.push_back({.children = reader.readVector<JointId>()});
+        }
+        skeleton.inverseBindMatrices = reader.readVector<glm::mat4>();
+
+        // don't let corrupted hierarchy crash makeFlatSkeleton
+        for (const auto& node : skeleton.hierarchy) {
+            for (const auto child : node.children) {
+                if (child >= numJoints || skeleton.inverseBindMatrices.size() != numJoints) {
+                    return;
+                }
+            }
+        }
+        skeleton.flatSkeleton = graphics::makeFlatSkeleton(skeleton);
+    }
+}
+
+void writeAnimations(
+    BinaryWriter& writer,
+    const std::unordered_map<std::string, SkeletalAnimation>& animations)
+{
+    // sorted, so that cooking the same file gives the same result
+    std::vector<const SkeletalAnimation*> sorted;
+    for (const auto& [name, animation] : animations) {
+        sorted.push_back(&animation);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) {
+        return a->name < b->name;
+    });
+
+    // compressed here, so that the game doesn't have to do it on every load
+    writer.write((std::uint32_t)sorted.size());
+    for (const auto* animation : sorted) {
+        const auto compressed = graphics::compressAnimation(*animation);
+        writer.writeString(compressed.name);
+        writer.write(compressed.duration);
+        writer.write(compressed.error);
+        writer.writeArray(std::span{compressed.tracks});
+        writer.writeArray(std::span{compressed.keyFrames});
+        writer.writeArray(std::span{compressed.keyValues});
+        writer.writeArray(std::span{compressed.ranges});
+    }
+}
+
+// Checks that decompressAnimation won't read out of bounds
+bool isValid(const CompressedAnimation& animation)
+{
+    const auto numTrackTypes = CompressedAnimation::NUM_TRACK_TYPES;
+    if (animation.tracks.size() % numTrackTypes != 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < animation.tracks.size(); ++i) {
+        const auto& track = animation.tracks[i];
+        if (track.numKeys == 0) {
+            continue;
+        }
+        if ((std::size_t)track.firstKey + track.numKeys > animation.keyValues.size() / 3) {
+            return false;
+        }
+        const auto type = (CompressedAnimation::TrackType)(i % numTrackTypes);
+        if (type != CompressedAnimation::TrackType::Rotation &&
+            track.rangeIndex >= animation.ranges.size()) {
+            return false;
+        }
+        if (track.numKeys == 1) {
+            continue;
+        }
+        if ((std::size_t)track.firstFrame + track.numKeys > animation.keyFrames.size()) {
+            return false;
+        }
+        const auto* frames = &animation.keyFrames[track.firstFrame];
+        if (!std::is_sorted(frames, frames + track.numKeys, std::less_equal{})) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readAnimations(
+    BinaryReader& reader,
+    std::unordered_map<std::string, CompressedAnimation>& animations)
+{
+    const auto numAnimations = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numAnimations && reader.isGood(); ++i) {
+        CompressedAnimation animation;
+        animation.name = reader.readString();
+        animation.duration = reader.read<float>();
+        animation.error = reader.read<CompressedAnimation::Error>();
+        animation.tracks = reader.readVector<CompressedAnimation::Track>();
+        animation.keyFrames = reader.readVector<std::uint16_t>();
+        animation.keyValues = reader.readVector<std::uint16_t>();
+        animation.ranges = reader.readVector<CompressedAnimation::Range>();
+        if (!isValid(animation)) {
+            return false;
+        }
+        auto name = animation.name;
+        animations.emplace(std::move(name), std::move(animation));
+    }
+    return true;
+}
+
+void writeLights(BinaryWriter& writer, const std::vector<Light>& lights)
+{
+    writer.write((std::uint32_t)lights.size());
+    for (const auto& light : lights) {
+        writer.writeString(light.name);
+        writer.write(light.type);
+        writer.write(light.color);
+        writer.write(light.range);
+        writer.write(light.intensity);
+        writer.write(light.scaleOffset);
+        writer.write(light.castShadow);
+    }
+}
+
+void readLights(BinaryReader& reader, std::vector<Light>& lights)
+{
+    const auto numLights = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numLights && reader.isGood(); ++i) {
+        auto& light = lights.emplace_back();
+        light.name = reader.readString();
+        light.type = reader.read<LightType>();
+        light.color = reader.read<LinearColor>();
+        light.range = reader.read<float>();
+        light.intensity = reader.read<float>();
+        light.scaleOffset = reader.read<glm::vec2>();
+        light.castShadow = reader.read<bool>();
+    }
+}
+} // end of anonymous namespace
+
+namespace util
+{
+std::filesystem::path getCookedScenePath(const std::filesystem::path& gltfPath)
+{
+    auto path = gltfPath;
+    path.replace_extension(".edbrscene");
+    return path;
+}
+
+bool isCookedSceneUpToDate(const std::filesystem::path& gltfPath)
+{
+    const auto cookedPath = getCookedScenePath(gltfPath);
+    std::error_code ec;
+    const auto cookedTime = std::filesystem::last_write_time(cookedPath, ec);
+    if (ec || cookedTime < std::filesystem::last_write_time(gltfPath, ec) || ec) {
+        return false;
+    }
+
+    Header header{.magic = 0};
+    std::ifstream file(cookedPath, std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+    return file.good() && header.isValid();
+}
+
+void writeCookedScene(const std::filesystem::path& path, const SceneData& data)
+{
+    const auto sceneDir = path.parent_path();
+    const auto& scene = data.scene;
+
+    BinaryWriter writer;
+    writer.write(Header{});
+    writeMaterials(writer, data.materials, sceneDir);
+    writeMeshes(writer, data.meshes);
+    writeSkeletons(writer, scene.skeletons);
+    writeAnimations(writer, scene.animations);
+    writeLights(writer, scene.lights);
+    writer.write((std::uint32_t)scene.nodes.size());
+    for (const auto& node : scene.nodes) {
+        writeNode(writer, *node);
+    }
+
+    // write to a temporary file first, so that the game never sees half-written files
+    auto tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file.good()) {
+            throw std::runtime_error(
+                fmt::format("failed to open {} for writing", tempPath.string()));
+        }
+        const auto& bytes = writer.getData();
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    std::filesystem::rename(tempPath, path);
+}
+
+std::optional<CookedScene> readCookedScene(const std::filesystem::path& path)
+{
+    CookedScene cooked{.file = MappedFile(path)};
+    if (!cooked.file.isOpen()) {
+        return std::nullopt;
+    }
+
+    BinaryReader reader(cooked.file.getData());
+    if (!reader.read<Header>().isValid()) {
+        return std::nullopt;
+    }
+
+    const auto sceneDir = path.parent_path();
+    auto& scene = cooked.scene;
+    readMaterials(reader, cooked.materials, sceneDir);
+    readMeshes(reader, cooked.meshes);
+    readSkeletons(reader, scene.skeletons);
+    if (!readAnimations(reader, scene.compressedAnimations)) {
+        return std::nullopt;
+    }
+    readLights(reader, scene.lights);
+    const auto numNodes = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < numNodes && reader.isGood(); ++i) {
+        auto& node = scene.nodes.emplace_back(std::make_unique<SceneNode>());
+        readNode(reader, *node);
+    }
+
+    if (!reader.isGood()) {
+        return std::nullopt;
+    }
+    return cooked;
+}
+
+Scene loadCookedScene(
+    GfxDevice& gfxDevice,
+    MeshCache& meshCache,
+    MaterialCache& materialCache,
+    CookedScene cookedScene)
+{
+    std::vector<MaterialId> materialMapping;
+    materialMapping.reserve(cookedScene.materials.size());
+    for (auto& material : edbr::loadSceneMaterials(gfxDevice, cookedScene.materials)) {
+        materialMapping.push_back(materialCache.addMaterial(gfxDevice, std::move(material)));
+    }
+
+    auto scene = std::move(cookedScene.scene);
+    scene.meshes.reserve(cookedScene.meshes.size());
+    for (const auto& primitives : cookedScene.meshes) {
+        SceneMesh mesh;
+        mesh.primitives.resize(primitives.size());
+        mesh.primitiveMaterials.resize(primitives.size());
+        for (std::size_t primitiveIdx = 0; primitiveIdx < primitives.size(); ++primitiveIdx) {
+            const auto& primitive = primitives[primitiveIdx];
+            const auto& data = primitive.mesh;
+            if (data.indices.empty()) {
+                continue;
+            }
+
+            auto materialId = materialCache.getPlaceholderMaterialId();
+            if (primitive.materialIndex != -1) {
+                materialId = materialMapping.at(primitive.materialIndex);
+            }
+
+            // copied straight from the mapped file
+            const auto meshId = meshCache.addMesh(gfxDevice, data);
+            mesh.primitives[primitiveIdx] = meshId;
+            mesh.primitiveMaterials[primitiveIdx] = materialId;
+
+            // CPU copy is still needed for physics (see Scene::cpuMeshes)
+            scene.cpuMeshes.emplace(
+                meshId,
+                CPUMesh{
+                    .indices = {data.indices.begin(), data.indices.end()},
+                    .vertices = {data.vertices.begin(), data.vertices.end()},
+                    .skinningData = {data.skinningData.begin(), data.skinningData.end()},
+                    .hasSkeleton = !data.skinningData.empty(),
+                    .name = primitive.name,
+                    .minPos = data.minPos,
+                    .maxPos = data.maxPos,
+                });
+        }
+        scene.meshes.push_back(std::move(mesh));
+    }
+
+    return scene;
+}
+}
@@ -0,0 +1,146 @@
+#include <edbr/Util/CookedTexture.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <edbr/Graphics/ImageLoader.h>
+#include <edbr/Graphics/TextureCompression.h>
+
+namespace
+{
+graphics::BlockCompression getBlockCompression(util::TextureKind kind)
+{
+    switch (kind) {
+    case util::TextureKind::NormalMap:
+        return graphics::BlockCompression::BC5;
+    case util::TextureKind::SingleChannel:
+        return graphics::BlockCompression::BC4;
+    default:
+        return graphics::BlockCompression::BC7;
+    }
+}
+
+graphics::MipFilter getMipFilter(util::TextureKind kind)
+{
+    switch (kind) {
+    case util::TextureKind::Color:
+        return graphics::MipFilter::SRGB;
+    case util::TextureKind::NormalMap:
+        return graphics::MipFilter::NormalMap;
+    default:
+        return graphics::MipFilter::Linear;
+    }
+}
+}
+
+namespace util
+{
+VkFormat getCookedTextureFormat(TextureKind kind)
+{
+    switch (kind) {
+    case TextureKind::Color:
+        return VK_FORMAT_BC7_SRGB_BLOCK;
+    case TextureKind::Linear:
+        return VK_FORMAT_BC7_UNORM_BLOCK;
+    case TextureKind::NormalMap:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+    case TextureKind::SingleChannel:
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+bool isCookedTextureCompatible(
+    VkFormat cookedFormat,
+    VkFormat requestedFormat,
+    std::optional<TextureKind> kind)
+{
+    if (requestedFormat != VK_FORMAT_R8G8B8A8_SRGB && requestedFormat != VK_FORMAT_R8G8B8A8_UNORM) {
+        return false;
+    }
+    const auto isSRGB = requestedFormat == VK_FORMAT_R8G8B8A8_SRGB;
+    if (!kind.has_value()) {
+        kind = isSRGB ? TextureKind::Color : TextureKind::Linear;
+    }
+    // only color textures are sampled as sRGB
+    if (isSRGB != (*kind == TextureKind::Color)) {
+        return false;
+    }
+    return cookedFormat == getCookedTextureFormat(*kind);
+}
+
+std::filesystem::path getCookedTexturePath(const std::filesystem::path& imagePath)
+{
+    auto path = imagePath;
+    path.replace_extension(".ktx2");
+    return path;
+}
+
+bool isCookedTextureUpToDate(const std::filesystem::path& imagePath)
+{
+    const auto cookedPath = getCookedTexturePath(imagePath);
+    std::error_code ec;
+    const auto cookedTime = std::filesystem::last_write_time(cookedPath, ec);
+    if (ec || cookedTime < std::filesystem::last_write_time(imagePath, ec) || ec) {
+        return false;
+    }
+
+    static const std::array<char, 12> identifier =
+        {'\xAB', 'K', 'T', 'X', ' ', '2', '0', '\xBB', '\r', '\n', '\x1A', '\n'};
+    std::array<char, 12> fileIdentifier{};
+    std::ifstream file(cookedPath, std::ios::binary);
+    file.read(fileIdentifier.data(), fileIdentifier.size());
+    return file.good() && fileIdentifier == identifier;
+}
+
+void writeCookedTexture(
+    const std::filesystem::path& path,
+    TextureKind kind,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::uint8_t> rgba)
+{
+    const auto compression = getBlockCompression(kind);
+    auto mips = graphics::generateMipChain(width, height, rgba, getMipFilter(kind));
+    for (std::size_t i = 0; i < mips.size(); ++i) {
+        const auto mipWidth = std::max(width >> i, 1u);
+        const auto mipHeight = std::max(height >> i, 1u);
+        mips[i] = graphics::compressImage(compression, mipWidth, mipHeight, mips[i]);
+    }
+    writeKtx2(path, getCookedTextureFormat(kind), width, height, mips);
+}
+
+void cookTexture(const std::filesystem::path& imagePath, TextureKind kind)
+{
+    const auto data = util::loadImage(imagePath);
+    if (!data.pixels) {
+        throw std::runtime_error(fmt::format("failed to load image {}", imagePath.string()));
+    }
+    const auto width = (std::uint32_t)data.width;
+    const auto height = (std::uint32_t)data.height;
+    writeCookedTexture(
+        getCookedTexturePath(imagePath),
+        kind,
+        width,
+        height,
+        {data.pixels, (std::size_t)width * height * 4});
+}
+
+std::optional<CookedTexture> readCookedTexture(const std::filesystem::path& path)
+{
+    CookedTexture cooked{.file = MappedFile(path)};
+    if (!cooked.file.isOpen()) {
+        return std::nullopt;
+    }
+    auto texture = parseKtx2(cooked.file.getData());
+    if (!texture) {
+        return std::nullopt;
+    }
+    cooked.texture = std::move(*texture);
+    return cooked;
+}
+}
@@ -10,6 +10,8 @@
 #include <edbr/Graphics/GfxDevice.h>
 #include <edbr/Graphics/MaterialCache.h>
 #include <edbr/Graphics/MeshCache.h>
+#include <edbr/Graphics/MeshClustering.h>
+#include <edbr/Graphics/MeshSimplification.h>
 #include <edbr/Graphics/Scene.h>
 #include <edbr/Graphics/Skeleton.h>
 #include <edbr/Math/Util.h>
@@ -250,8 +252,22 @@ CPUMesh loadPrimitive(
 
     if (primitive.indices != -1) { // load indices
         const auto& indexAccessor = model.accessors[primitive.indices];
-        const auto indices = getPackedBufferSpan<std::uint16_t>(model, indexAccessor);
-        mesh.indices.assign(indices.begin(), indices.end());
+        switch (indexAccessor.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+            const auto indices = getPackedBufferSpan<std::uint8_t>(model, indexAccessor);
+            mesh.indices.assign(indices.begin(), indices.end());
+        } break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            const auto indices = getPackedBufferSpan<std::uint16_t>(model, indexAccessor);
+            mesh.indices.assign(indices.begin(), indices.end());
+        } break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+            const auto indices = getPackedBufferSpan<std::uint32_t>(model, indexAccessor);
+            mesh.indices.assign(indices.begin(), indices.end());
+        } break;
+        default:
+            assert(false && "unsupported index type");
+        }
     }
 
     // load positions
@@ -328,44 +344,37 @@ CPUMesh loadPrimitive(
     return mesh;
 }
 
-Material loadMaterial(
-    GfxDevice& gfxDevice,
+SceneMaterial loadMaterial(
     const tinygltf::Model& gltfModel,
     const std::filesystem::path& fileDir,
     const tinygltf::Material& gltfMaterial)
 {
-    Material material{
-        .baseColor = getDiffuseColor(gltfMaterial),
-        .metallicFactor = (float)gltfMaterial.pbrMetallicRoughness.metallicFactor,
-        .roughnessFactor = (float)gltfMaterial.pbrMetallicRoughness.roughnessFactor,
-        .name = gltfMaterial.name,
+    SceneMaterial material{
+        .material =
+            {
+                .baseColor = getDiffuseColor(gltfMaterial),
+                .metallicFactor = (float)gltfMaterial.pbrMetallicRoughness.metallicFactor,
+                .roughnessFactor = (float)gltfMaterial.pbrMetallicRoughness.roughnessFactor,
+                .name = gltfMaterial.name,
+            },
     };
 
     if (hasDiffuseTexture(gltfMaterial)) {
-        const auto diffusePath = getDiffuseTexturePath(gltfModel, gltfMaterial, fileDir);
-        material.diffuseTexture = gfxDevice.loadImageFromFile(
-            diffusePath, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+        material.diffuseTexture = getDiffuseTexturePath(gltfModel, gltfMaterial, fileDir);
     }
 
     if (hasNormalMapTexture(gltfMaterial)) {
-        const auto normalMapPath = getNormalMapTexturePath(gltfModel, gltfMaterial, fileDir);
-        material.normalMapTexture = gfxDevice.loadImageFromFile(
-            normalMapPath, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+        material.normalMapTexture = getNormalMapTexturePath(gltfModel, gltfMaterial, fileDir);
     }
 
     if (hasMetallicRoughnessTexture(gltfMaterial)) {
-        const auto metalRoughnessPath =
+        material.metallicRoughnessTexture =
             getMetallicRoughnessTexturePath(gltfModel, gltfMaterial, fileDir);
-        material.metallicRoughnessTexture = gfxDevice.loadImageFromFile(
-            metalRoughnessPath, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, true);
     }
 
     if (hasEmissiveTexture(gltfMaterial)) {
-        material.emissiveFactor = getEmissiveStrength(gltfMaterial);
-
-        const auto emissivePath = getEmissiveTexturePath(gltfModel, gltfMaterial, fileDir);
-        material.emissiveTexture = gfxDevice.loadImageFromFile(
-            emissivePath, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+        material.material.emissiveFactor = getEmissiveStrength(gltfMaterial);
+        material.emissiveTexture = getEmissiveTexturePath(gltfModel, gltfMaterial, fileDir);
     }
 
     return material;
@@ -432,6 +441,8 @@ Skeleton loadSkeleton(
         }
     }
 
+    skeleton.flatSkeleton = graphics::makeFlatSkeleton(skeleton);
+
     return skeleton;
 }
 
@@ -521,6 +532,8 @@ std::unordered_map<std::string, SkeletalAnimation> loadAnimations(
                 assert(false && "unexpected target_path");
             }
         }
+
+        animation.soaTracks = graphics::makeSoAAnimation(animation);
     }
 
     return animations;
@@ -609,11 +622,7 @@ void loadGltfFile(tinygltf::Model& gltfModel, const std::filesystem::path& path)
 
 namespace util
 {
-Scene loadGltfFile(
-    GfxDevice& gfxDevice,
-    MeshCache& meshCache,
-    MaterialCache& materialCache,
-    const std::filesystem::path& path)
+SceneData loadGltfSceneData(const std::filesystem::path& path)
 {
     const auto fileDir = path.parent_path();
 
@@ -622,46 +631,32 @@ Scene loadGltfFile(
 
     const auto& gltfScene = gltfModel.scenes[gltfModel.defaultScene];
 
-    // gltf material id -> material cache id
-    std::unordered_map<std::size_t, MaterialId> materialMapping;
+    SceneData data{.scene = {.path = path}};
+    auto& scene = data.scene;
+
     // load materials
-    {
-        for (std::size_t materialIdx = 0; materialIdx < gltfModel.materials.size(); ++materialIdx) {
-            const auto& gltfMaterial = gltfModel.materials[materialIdx];
-            const auto materialId = materialCache.addMaterial(
-                gfxDevice, loadMaterial(gfxDevice, gltfModel, fileDir, gltfMaterial));
-            materialMapping.emplace(materialIdx, materialId);
-        }
+    data.materials.reserve(gltfModel.materials.size());
+    for (const auto& gltfMaterial : gltfModel.materials) {
+        data.materials.push_back(loadMaterial(gltfModel, fileDir, gltfMaterial));
     }
 
-    Scene scene{.path = path};
     // load meshes
-    scene.meshes.reserve(gltfModel.meshes.size());
+    data.meshes.reserve(gltfModel.meshes.size());
     for (const auto& gltfMesh : gltfModel.meshes) {
-        SceneMesh mesh;
-        mesh.primitives.resize(gltfMesh.primitives.size());
-        mesh.primitiveMaterials.resize(gltfMesh.primitives.size());
-        for (std::size_t primitiveIdx = 0; primitiveIdx < gltfMesh.primitives.size();
-             ++primitiveIdx) {
-            // load on CPU
-            const auto& gltfPrimitive = gltfMesh.primitives[primitiveIdx];
-            auto cpuMesh = loadPrimitive(gltfModel, gltfMesh.name, gltfPrimitive);
-            if (cpuMesh.indices.empty()) {
-                continue;
-            }
-
-            // upload to GPU
-            auto materialId = materialCache.getPlaceholderMaterialId();
-            if (gltfPrimitive.material != -1) {
-                materialId = materialMapping.at(gltfPrimitive.material);
-            }
-
-            const auto meshId = meshCache.addMesh(gfxDevice, cpuMesh);
-            mesh.primitives[primitiveIdx] = meshId;
-            mesh.primitiveMaterials[primitiveIdx] = materialId;
-            scene.cpuMeshes.emplace(meshId, std::move(cpuMesh));
+        auto& primitives = data.meshes.emplace_back();
+        primitives.reserve(gltfMesh.primitives.size());
+        for (const auto& gltfPrimitive : gltfMesh.primitives) {
+            auto mesh = loadPrimitive(gltfModel, gltfMesh.name, gltfPrimitive);
+            const auto optimizationStats = graphics::optimizeMesh(mesh);
+            // LODs are made from the optimized mesh, as they use its vertices
+            graphics::generateMeshLODs(mesh);
+            graphics::generateMeshlets(mesh);
+            primitives.push_back(ScenePrimitive{
+                .mesh = std::move(mesh),
+                .materialIndex = gltfPrimitive.material,
+                .optimizationStats = optimizationStats,
+            });
         }
-        scene.meshes.push_back(std::move(mesh));
     }
 
     // gltf node id -> JointId
@@ -716,6 +711,80 @@ Scene loadGltfFile(
         loadNode(node, gltfNode, gltfModel);
     }
 
+    return data;
+}
+
+Scene uploadGltfSceneData(
+    GfxDevice& gfxDevice,
+    MeshCache& meshCache,
+    MaterialCache& materialCache,
+    SceneData data)
+{
+    // gltf material id -> material cache id
+    std::vector<MaterialId> materialMapping;
+    materialMapping.reserve(data.materials.size());
+    for (auto& material : edbr::loadSceneMaterials(gfxDevice, data.materials)) {
+        materialMapping.push_back(materialCache.addMaterial(gfxDevice, std::move(material)));
+    }
+
+    auto scene = std::move(data.scene);
+    scene.meshes.reserve(data.meshes.size());
+    for (auto& primitives : data.meshes) {
+        SceneMesh mesh;
+        mesh.primitives.resize(primitives.size());
+        mesh.primitiveMaterials.resize(primitives.size());
+        for (std::size_t primitiveIdx = 0; primitiveIdx < primitives.size(); ++primitiveIdx) {
+            auto& primitive = primitives[primitiveIdx];
+            if (primitive.mesh.indices.empty()) {
+                continue;
+            }
+
+            // upload to GPU
+            auto materialId = materialCache.getPlaceholderMaterialId();
+            if (primitive.materialIndex != -1) {
+                materialId = materialMapping.at(primitive.materialIndex);
+            }
+
+            const auto meshId = meshCache.addMesh(gfxDevice, primitive.mesh);
+            mesh.primitives[primitiveIdx] = meshId;
+            mesh.primitiveMaterials[primitiveIdx] = materialId;
+            scene.cpuMeshes.emplace(meshId, std::move(primitive.mesh));
+        }
+        scene.meshes.push_back(std::move(mesh));
+    }
+
+    return scene;
+}
+
+Scene loadGltfFile(
+    GfxDevice& gfxDevice,
+    MeshCache& meshCache,
+    MaterialCache& materialCache,
+    const std::filesystem::path& path)
+{
+    auto scene =
+        uploadGltfSceneData(gfxDevice, meshCache, materialCache, loadGltfSceneData(path));
+    gfxDevice.flushUploads();
+    return scene;
+}
+
+Scene loadGltfAnimations(const std::filesystem::path& path)
+{
+    tinygltf::Model gltfModel;
+    ::loadGltfFile(gltfModel, path);
+
+    Scene scene{.path = path};
+    std::unordered_map<int, JointId> gltfNodeIdxToJointId;
+    scene.skeletons.reserve(gltfModel.skins.size());
+    for (const auto& skin : gltfModel.skins) {
+        scene.skeletons.push_back(loadSkeleton(gltfNodeIdxToJointId, gltfModel, skin));
+    }
+
+    if (!gltfModel.skins.empty()) {
+        assert(gltfModel.skins.size() == 1); // for now only one skeleton supported
+        scene.animations = loadAnimations(scene.skeletons[0], gltfNodeIdxToJointId, gltfModel);
+    }
+
     return scene;
 }
 
@@ -0,0 +1,293 @@
+#include <edbr/Util/Ktx2.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+namespace
+{
+constexpr std::array<std::uint8_t, 12> KTX2_IDENTIFIER =
+    {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+struct Header {
+    std::array<std::uint8_t, 12> identifier{KTX2_IDENTIFIER};
+    std::uint32_t vkFormat{0};
+    std::uint32_t typeSize{1};
+    std::uint32_t pixelWidth{0};
+    std::uint32_t pixelHeight{0};
+    std::uint32_t pixelDepth{0};
+    std::uint32_t layerCount{0};
+    std::uint32_t faceCount{1};
+    std::uint32_t levelCount{0};
+    std::uint32_t supercompressionScheme{0};
+
+    std::uint32_t dfdByteOffset{0};
+    std::uint32_t dfdByteLength{0};
+    std::uint32_t kvdByteOffset{0};
+    std::uint32_t kvdByteLength{0};
+    std::uint64_t sgdByteOffset{0};
+    std::uint64_t sgdByteLength{0};
+};
+static_assert(sizeof(Header) == 80);
+
+struct LevelIndex {
+    std::uint64_t byteOffset;
+    std::uint64_t byteLength;
+    std::uint64_t uncompressedByteLength;
+};
+
+// Khronos Data Format color models
+constexpr std::uint8_t KHR_DF_MODEL_RGBSDA = 1;
+constexpr std::uint8_t KHR_DF_MODEL_BC4 = 131;
+constexpr std::uint8_t KHR_DF_MODEL_BC5 = 132;
+constexpr std::uint8_t KHR_DF_MODEL_BC7 = 134;
+
+constexpr std::uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+constexpr std::uint8_t KHR_DF_TRANSFER_SRGB = 2;
+constexpr std::uint8_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+
+struct FormatInfo {
+    std::uint8_t colorModel;
+    bool srgb;
+    std::uint32_t blockSize; // in bytes, blocks are 4x4 for BC formats
+};
+
+std::optional<FormatInfo> getFormatInfo(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        return FormatInfo{KHR_DF_MODEL_RGBSDA, false, 4};
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return FormatInfo{KHR_DF_MODEL_RGBSDA, true, 4};
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return FormatInfo{KHR_DF_MODEL_BC4, false, 8};
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return FormatInfo{KHR_DF_MODEL_BC5, false, 16};
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        return FormatInfo{KHR_DF_MODEL_BC7, false, 16};
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return FormatInfo{KHR_DF_MODEL_BC7, true, 16};
+    default:
+        return std::nullopt;
+    }
+}
+
+std::size_t getMipSize(const FormatInfo& info, std::uint32_t width, std::uint32_t height)
+{
+    if (info.colorModel == KHR_DF_MODEL_RGBSDA) {
+        return (std::size_t)width * height * info.blockSize;
+    }
+    return (std::size_t)((width + 3) / 4) * ((height + 3) / 4) * info.blockSize;
+}
+
+class ByteWriter {
+public:
+    template<typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(&value, sizeof(T));
+    }
+
+    void append(const void* ptr, std::size_t size)
+    {
+        const auto* bytes = static_cast<const std::uint8_t*>(ptr);
+        data.insert(data.end(), bytes, bytes + size);
+    }
+
+    void align(std::size_t alignment)
+    {
+        data.resize((data.size() + alignment - 1) / alignment * alignment);
+    }
+
+    std::size_t getSize() const { return data.size(); }
+    std::vector<std::uint8_t>& getData() { return data; }
+
+private:
+    std::vector<std::uint8_t> data;
+};
+
+// Basic data format descriptor with one sample per channel
+void writeDFD(ByteWriter& writer, const FormatInfo& info)
+{
+    struct Sample {
+        std::uint16_t bitOffset;
+        std::uint8_t bitLength; // minus one
+        std::uint8_t channelType;
+        std::uint32_t upper;
+    };
+    std::vector<Sample> samples;
+    if (info.colorModel == KHR_DF_MODEL_RGBSDA) {
+        // alpha is always linear
+        const auto alpha = (std::uint8_t)(15 | (info.srgb ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0));
+        samples = {{0, 7, 0, 255}, {8, 7, 1, 255}, {16, 7, 2, 255}, {24, 7, alpha, 255}};
+    } else if (info.colorModel == KHR_DF_MODEL_BC5) {
+        samples = {{0, 63, 0, 0xFFFFFFFF}, {64, 63, 1, 0xFFFFFFFF}};
+    } else {
+        const auto bitLength = (std::uint8_t)(info.blockSize * 8 - 1);
+        samples = {{0, bitLength, 0, 0xFFFFFFFF}};
+    }
+
+    const auto blockSize = (std::uint32_t)(24 + 16 * samples.size());
+    const auto blockDimension = (std::uint8_t)(info.colorModel == KHR_DF_MODEL_RGBSDA ? 0 : 3);
+    writer.write<std::uint32_t>(4 + blockSize); // dfdTotalSize
+    writer.write<std::uint32_t>(0); // vendorId = Khronos, descriptorType = basic
+    writer.write<std::uint16_t>(2); // versionNumber
+    writer.write<std::uint16_t>((std::uint16_t)blockSize);
+    writer.write(info.colorModel);
+    writer.write<std::uint8_t>(1); // colorPrimaries = BT709
+    writer.write(info.srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR);
+    writer.write<std::uint8_t>(0); // flags = straight alpha
+    const std::array<std::uint8_t, 4> texelBlockDimension{blockDimension, blockDimension, 0, 0};
+    writer.write(texelBlockDimension);
+    std::array<std::uint8_t, 8> bytesPlane{};
+    bytesPlane[0] = (std::uint8_t)info.blockSize;
+    writer.write(bytesPlane);
+    for (const auto& sample : samples) {
+        writer.write(sample.bitOffset);
+        writer.write(sample.bitLength);
+        writer.write(sample.channelType);
+        writer.write<std::uint32_t>(0); // samplePosition
+        writer.write<std::uint32_t>(0); // sampleLower
+        writer.write(sample.upper);
+    }
+}
+
+void writeKeyValue(ByteWriter& writer, std::string_view key, std::string_view value)
+{
+    writer.write((std::uint32_t)(key.size() + value.size() + 2));
+    writer.append(key.data(), key.size());
+    writer.write<std::uint8_t>(0);
+    writer.append(value.data(), value.size());
+    writer.write<std::uint8_t>(0);
+    writer.align(4);
+}
+}
+
+namespace util
+{
+void writeKtx2(
+    const std::filesystem::path& path,
+    VkFormat format,
+    std::uint32_t width,
+    std::uint32_t height,
+    std::span<const std::vector<std::uint8_t>> mips)
+{
+    const auto info = getFormatInfo(format);
+    if (!info) {
+        throw std::runtime_error(fmt::format("unsupported KTX2 format: {}", (int)format));
+    }
+    if (mips.empty() || width == 0 || height == 0) {
+        throw std::runtime_error("KTX2 texture should have at least one mip");
+    }
+
+    Header header{
+        .vkFormat = (std::uint32_t)format,
+        .pixelWidth = width,
+        .pixelHeight = height,
+        .levelCount = (std::uint32_t)mips.size(),
+    };
+
+    ByteWriter writer;
+    writer.write(header);
+    const auto levelIndexOffset = writer.getSize();
+    writer.getData().resize(levelIndexOffset + sizeof(LevelIndex) * mips.size());
+
+    header.dfdByteOffset = (std::uint32_t)writer.getSize();
+    writeDFD(writer, *info);
+    header.dfdByteLength = (std::uint32_t)writer.getSize() - header.dfdByteOffset;
+
+    header.kvdByteOffset = (std::uint32_t)writer.getSize();
+    writeKeyValue(writer, "KTXwriter", "edbr");
+    header.kvdByteLength = (std::uint32_t)writer.getSize() - header.kvdByteOffset;
+
+    // mips are stored from the smallest to the largest one, aligned to
+    // lcm(texel block size, 4)
+    std::vector<LevelIndex> levels(mips.size());
+    for (std::size_t i = mips.size(); i-- > 0;) {
+        const auto mipWidth = std::max(width >> i, 1u);
+        const auto mipHeight = std::max(height >> i, 1u);
+        if (mips[i].size() != getMipSize(*info, mipWidth, mipHeight)) {
+            throw std::runtime_error(fmt::format("mip {} has wrong size", i));
+        }
+        writer.align(info->blockSize < 4 ? 4 : info->blockSize);
+        levels[i] = LevelIndex{
+            .byteOffset = writer.getSize(),
+            .byteLength = mips[i].size(),
+            .uncompressedByteLength = mips[i].size(),
+        };
+        writer.append(mips[i].data(), mips[i].size());
+    }
+
+    auto& bytes = writer.getData();
+    std::memcpy(bytes.data(), &header, sizeof(Header));
+    std::memcpy(&bytes[levelIndexOffset], levels.data(), levels.size() * sizeof(LevelIndex));
+
+    // write to a temporary file first, so that the game never sees half-written files
+    auto tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file.good()) {
+            throw std::runtime_error(
+                fmt::format("failed to open {} for writing", tempPath.string()));
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    std::filesystem::rename(tempPath, path);
+}
+
+std::optional<Ktx2Texture> parseKtx2(std::span<const std::byte> data)
+{
+    Header header;
+    if (data.size() < sizeof(Header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, data.data(), sizeof(Header));
+
+    if (header.identifier != KTX2_IDENTIFIER) {
+        return std::nullopt;
+    }
+    const auto format = (VkFormat)header.vkFormat;
+    const auto info = getFormatInfo(format);
+    if (!info || header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 ||
+        header.layerCount > 1 || header.faceCount != 1 || header.supercompressionScheme != 0) {
+        return std::nullopt;
+    }
+    // levelCount == 0 means "generate mips on load", which isn't supported
+    if (header.levelCount == 0 || header.levelCount > 32 ||
+        (std::max(header.pixelWidth, header.pixelHeight) >> (header.levelCount - 1)) == 0) {
+        return std::nullopt;
+    }
+
+    const auto levelIndexSize = header.levelCount * sizeof(LevelIndex);
+    if (data.size() - sizeof(Header) < levelIndexSize) {
+        return std::nullopt;
+    }
+
+    Ktx2Texture texture{
+        .format = format,
+        .width = header.pixelWidth,
+        .height = header.pixelHeight,
+    };
+    for (std::uint32_t i = 0; i < header.levelCount; ++i) {
+        LevelIndex level;
+        std::memcpy(&level, &data[sizeof(Header) + i * sizeof(LevelIndex)], sizeof(LevelIndex));
+
+        const auto mipWidth = std::max(header.pixelWidth >> i, 1u);
+        const auto mipHeight = std::max(header.pixelHeight >> i, 1u);
+        if (level.byteLength != getMipSize(*info, mipWidth, mipHeight) ||
+            level.byteOffset > data.size() || level.byteLength > data.size() - level.byteOffset) {
+            return std::nullopt;
+        }
+        texture.mips.push_back(data.subspan(level.byteOffset, level.byteLength));
+    }
+    return texture;
+}
+}
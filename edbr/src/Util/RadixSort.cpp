@@ -0,0 +1,54 @@
+#include <edbr/Util/RadixSort.h>
+
+#include <array>
+#include <utility> // swap
+
+namespace util
+{
+void radixSort(std::vector<KeyIndex>& items, std::vector<KeyIndex>& scratch)
+{
+    static constexpr std::size_t NUM_PASSES = sizeof(std::uint64_t);
+    static constexpr std::size_t NUM_BUCKETS = 256;
+
+    const auto n = items.size();
+    if (n < 2) {
+        return;
+    }
+
+    // histograms of all bytes are computed in one go
+    std::array<std::array<std::uint32_t, NUM_BUCKETS>, NUM_PASSES> counts{};
+    for (const auto& item : items) {
+        for (std::size_t pass = 0; pass < NUM_PASSES; ++pass) {
+            ++counts[pass][(item.key >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    scratch.resize(n);
+    auto* src = &items;
+    auto* dst = &scratch;
+    for (std::size_t pass = 0; pass < NUM_PASSES; ++pass) {
+        auto& passCounts = counts[pass];
+        const auto shift = pass * 8;
+        if (passCounts[(items[0].key >> shift) & 0xFF] == n) {
+            continue; // all keys have the same byte
+        }
+
+        // counts -> offsets
+        std::uint32_t offset = 0;
+        for (auto& count : passCounts) {
+            const auto c = count;
+            count = offset;
+            offset += c;
+        }
+
+        for (const auto& item : *src) {
+            (*dst)[passCounts[(item.key >> shift) & 0xFF]++] = item;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != &items) {
+        std::swap(items, scratch);
+    }
+}
+}
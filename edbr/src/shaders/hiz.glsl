@@ -0,0 +1,102 @@
+#ifndef HIZ_GLSL
+#define HIZ_GLSL
+
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_scalar_block_layout: require
+
+// Hi-Z pyramid with all levels packed into one buffer.
+// Depth is reverse-Z, so each texel stores the farthest (min) depth.
+// keep in sync with HiZPyramid.cpp
+layout (buffer_reference, scalar) buffer HiZBuffer {
+    float depth[];
+};
+
+struct HiZLevel {
+    ivec2 size;
+    uint offset;
+};
+
+HiZLevel getHiZLevel(ivec2 depthImageSize, uint level)
+{
+    HiZLevel l;
+    l.size = depthImageSize;
+    l.offset = 0;
+    for (uint i = 0; i <= level; ++i) {
+        if (i > 0) {
+            l.offset += uint(l.size.x * l.size.y);
+        }
+        l.size = (l.size + 1) / 2;
+    }
+    return l;
+}
+
+uint getNumHiZLevels(ivec2 depthImageSize)
+{
+    ivec2 size = depthImageSize;
+    uint numLevels = 0;
+    do {
+        size = (size + 1) / 2;
+        ++numLevels;
+    } while (size.x > 1 || size.y > 1);
+    return numLevels;
+}
+
+bool isSphereOccluded(
+    HiZBuffer hiz, ivec2 depthImageSize,
+    vec3 center, float radius,
+    mat4 view, mat4 proj, float zNear)
+{
+    vec3 c = (view * vec4(center, 1.0)).xyz;
+    float r = radius;
+    if (-c.z - r < zNear) {
+        return false;
+    }
+
+    // screen rect of the sphere's view space AABB
+    vec2 uvMin = vec2(1e30);
+    vec2 uvMax = vec2(-1e30);
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = c + vec3(
+            (i & 1) != 0 ? r : -r,
+            (i & 2) != 0 ? r : -r,
+            (i & 4) != 0 ? r : -r);
+        vec4 clip = proj * vec4(corner, 1.0);
+        vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+        uvMin = min(uvMin, uv);
+        uvMax = max(uvMax, uv);
+    }
+    if (uvMax.x < 0.0 || uvMax.y < 0.0 || uvMin.x > 1.0 || uvMin.y > 1.0) {
+        return false;
+    }
+
+    // depth of the sphere's closest point (max depth with reverse-Z)
+    vec4 nearestClip = proj * vec4(c.xy, c.z + r, 1.0);
+    float sphereDepth = nearestClip.z / nearestClip.w;
+
+    ivec2 maxPixel = depthImageSize - 1;
+    ivec2 pMin = clamp(ivec2(uvMin * vec2(depthImageSize)), ivec2(0), maxPixel);
+    ivec2 pMax = clamp(ivec2(uvMax * vec2(depthImageSize)), ivec2(0), maxPixel);
+
+    // pick the level where the rect covers at most 2x2 texels
+    int extent = max(pMax.x - pMin.x, pMax.y - pMin.y) + 1;
+    uint numLevels = getNumHiZLevels(depthImageSize);
+    uint level = 0;
+    while (level + 1 < numLevels && (1 << (level + 1)) < extent) {
+        ++level;
+    }
+
+    HiZLevel l = getHiZLevel(depthImageSize, level);
+    int shift = int(level) + 1;
+    ivec2 tMin = min(pMin >> shift, l.size - 1);
+    ivec2 tMax = min(pMax >> shift, l.size - 1);
+
+    float farthestDepth = 1.0;
+    for (int y = tMin.y; y <= tMax.y; ++y) {
+        for (int x = tMin.x; x <= tMax.x; ++x) {
+            farthestDepth = min(farthestDepth, hiz.depth[l.offset + y * l.size.x + x]);
+        }
+    }
+    return sphereDepth < farthestDepth;
+}
+
+#endif // HIZ_GLSL
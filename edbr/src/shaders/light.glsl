@@ -18,9 +18,17 @@ struct Light
     float intensity;
 
     vec2 scaleOffset; // spot light only
-    uint shadowMapID;
+    uint shadowSlot; // 0 - no shadow, otherwise point light shadow slot + 1
 
     float unused;
 };
 
+// face of the point light's shadow in the shadow atlas
+// (see PointLightShadowMapPipeline::GPUFaceData)
+struct PointShadowFace
+{
+    mat4 viewProj;
+    vec4 atlasRect; // xy - offset, z - size (atlas UV), w - half texel (face UV)
+};
+
 #endif // LIGHT_DATA_H
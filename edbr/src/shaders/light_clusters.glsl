@@ -0,0 +1,44 @@
+#ifndef LIGHT_CLUSTERS_GLSL
+#define LIGHT_CLUSTERS_GLSL
+
+#extension GL_EXT_scalar_block_layout: require
+#extension GL_EXT_buffer_reference : require
+
+// keep in sync with LightClusterGrid
+#define LIGHT_CLUSTER_GRID_SIZE_X 16
+#define LIGHT_CLUSTER_GRID_SIZE_Y 9
+#define LIGHT_CLUSTER_GRID_SIZE_Z 24
+
+struct LightCluster {
+    uint offset; // into light indices
+    uint count;
+};
+
+layout (buffer_reference, scalar) readonly buffer LightClustersBuffer {
+    LightCluster data[];
+};
+
+layout (buffer_reference, scalar) readonly buffer LightIndicesBuffer {
+    uint data[];
+};
+
+// screenUV - (0, 0) is the top left corner of the screen,
+// viewDepth - distance from the camera along its view direction
+uint getLightClusterIndex(vec2 screenUV, float viewDepth, float zNear, float zFar)
+{
+    uvec2 tile = uvec2(clamp(
+        ivec2(floor(screenUV * vec2(LIGHT_CLUSTER_GRID_SIZE_X, LIGHT_CLUSTER_GRID_SIZE_Y))),
+        ivec2(0),
+        ivec2(LIGHT_CLUSTER_GRID_SIZE_X - 1, LIGHT_CLUSTER_GRID_SIZE_Y - 1)));
+
+    // exponential slices between zNear and zFar
+    uint slice = 0;
+    if (viewDepth > zNear) {
+        float s = log(viewDepth / zNear) / log(zFar / zNear) * LIGHT_CLUSTER_GRID_SIZE_Z;
+        slice = uint(clamp(int(floor(s)), 0, LIGHT_CLUSTER_GRID_SIZE_Z - 1));
+    }
+
+    return (slice * LIGHT_CLUSTER_GRID_SIZE_Y + tile.y) * LIGHT_CLUSTER_GRID_SIZE_X + tile.x;
+}
+
+#endif // LIGHT_CLUSTERS_GLSL
@@ -12,12 +12,43 @@ layout (location = 1) in vec2 inUV;
 layout (location = 2) in vec3 inNormal;
 layout (location = 3) in vec4 inTangent;
 layout (location = 4) in mat3 inTBN;
+layout (location = 7) flat in uint inMaterialID;
 
 layout (location = 0) out vec4 outFragColor;
 
+vec3 calculateLightContribution(Light light, vec3 fragPos, vec3 cameraPos, vec3 n, vec3 v,
+        vec3 diffuseColor, float roughness, float metallic, vec3 f0)
+{
+    vec3 l = light.direction;
+    if (light.type != TYPE_DIRECTIONAL_LIGHT) {
+        l = normalize(light.position - fragPos);
+    }
+    float NoL = clamp(dot(n, l), 0.0, 1.0);
+
+    float occlusion = 1.0;
+    if (light.type == TYPE_DIRECTIONAL_LIGHT) {
+        occlusion = calculateCSMOcclusion(
+                fragPos, cameraPos, NoL,
+                pcs.sceneData.csmShadowMapId,
+                pcs.sceneData.cascadeFarPlaneZs,
+                pcs.sceneData.csmLightSpaceTMs);
+    } else if (light.type == TYPE_POINT_LIGHT && light.shadowSlot != 0) {
+        uint faceIndex = (light.shadowSlot - 1) * 6 + getPointShadowFace(fragPos - light.position);
+        PointShadowFace face = pcs.sceneData.pointShadowFaces.data[faceIndex];
+        occlusion = calculatePointShadow(
+                fragPos, light.position, NoL,
+                pcs.sceneData.pointShadowAtlasId,
+                face.viewProj, face.atlasRect,
+                pcs.sceneData.pointLightFarPlane);
+    }
+
+    return calculateLight(light, fragPos, n, v, l,
+            diffuseColor, roughness, metallic, f0, occlusion);
+}
+
 void main()
 {
-    MaterialData material = pcs.sceneData.materials.data[pcs.materialID];
+    MaterialData material = pcs.sceneData.materials.data[inMaterialID];
 
     vec4 diffuse = sampleTexture2DLinear(material.diffuseTex, inUV);
     if (diffuse.a < 0.1) {
@@ -31,9 +62,11 @@ void main()
         // FIXME: sometimes Blender doesn't export tangents for some objects
         // for some reason. When we will start computing tangents manually,
         // this check can be removed
-        normal = sampleTexture2DLinear(material.normalTex, inUV).rgb;
-        // normal.y = 1 - normal.y; // flip to make OpenGL normal maps work
-        normal = inTBN * normalize(normal * 2.0 - 1.0);
+        // Z is reconstructed from XY, so that two-channel (BC5) normal maps work
+        vec2 normalXY = sampleTexture2DLinear(material.normalTex, inUV).rg * 2.0 - 1.0;
+        // normalXY.y = -normalXY.y; // flip to make OpenGL normal maps work
+        normal = vec3(normalXY, sqrt(max(0.0, 1.0 - dot(normalXY, normalXY))));
+        normal = inTBN * normal;
         normal = normalize(normal);
     }
 
@@ -69,31 +102,23 @@ void main()
     // baseColor = vec3(1.0);
 
     vec3 fragColor = vec3(0.0);
-    for (int i = 0; i < pcs.sceneData.numLights; i++) {
-        Light light = pcs.sceneData.lights.data[i];
-
-        vec3 l = light.direction;
-        if (light.type != TYPE_DIRECTIONAL_LIGHT) {
-            l = normalize(light.position - fragPos);
-        }
-        float NoL = clamp(dot(n, l), 0.0, 1.0);
-
-        float occlusion = 1.0;
-        if (light.type == TYPE_DIRECTIONAL_LIGHT) {
-            occlusion = calculateCSMOcclusion(
-                    fragPos, cameraPos, NoL,
-                    pcs.sceneData.csmShadowMapId,
-                    pcs.sceneData.cascadeFarPlaneZs,
-                    pcs.sceneData.csmLightSpaceTMs);
-        } else if (light.type == TYPE_POINT_LIGHT && light.shadowMapID != 0) {
-            occlusion = calculatePointShadow(
-                    fragPos, light.position, NoL,
-                    light.shadowMapID,
-                    pcs.sceneData.pointLightFarPlane);
-        }
-
-        fragColor += calculateLight(light, fragPos, n, v, l,
-                diffuseColor, roughness, metallic, f0, occlusion);
+    if (pcs.sceneData.sunlightIndex != -1) {
+        Light light = pcs.sceneData.lights.data[pcs.sceneData.sunlightIndex];
+        fragColor += calculateLightContribution(light, fragPos, cameraPos, n, v,
+                diffuseColor, roughness, metallic, f0);
+    }
+
+    // only go through the lights binned into the fragment's cluster
+    vec4 clipPos = pcs.sceneData.viewProj * vec4(fragPos, 1.0);
+    vec2 screenUV = clipPos.xy / clipPos.w * 0.5 + 0.5;
+    uint clusterIndex = getLightClusterIndex(screenUV, clipPos.w,
+            pcs.sceneData.cameraZNear, pcs.sceneData.cameraZFar);
+    LightCluster cluster = pcs.sceneData.lightClusters.data[clusterIndex];
+    for (uint i = 0; i < cluster.count; i++) {
+        uint lightIndex = pcs.sceneData.lightIndices.data[cluster.offset + i];
+        Light light = pcs.sceneData.lights.data[lightIndex];
+        fragColor += calculateLightContribution(light, fragPos, cameraPos, n, v,
+                diffuseColor, roughness, metallic, f0);
     }
 
     // emissive
@@ -9,12 +9,17 @@ layout (location = 1) out vec2 outUV;
 layout (location = 2) out vec3 outNormal;
 layout (location = 3) out vec4 outTangent;
 layout (location = 4) out mat3 outTBN;
+layout (location = 7) flat out uint outMaterialID;
 
 void main()
 {
-    Vertex v = pcs.vertexBuffer.vertices[gl_VertexIndex];
+    // visible instances of each indirect draw are stored starting from its firstInstance
+    // (see mesh_cull.comp)
+    uint instanceIndex = pcs.visibleInstances.indices[gl_InstanceIndex];
+    MeshInstanceData inst = pcs.instanceData.data[instanceIndex];
+    Vertex v = loadVertex(inst.vertexBuffer, inst.vertexFormat, gl_VertexIndex);
 
-    vec4 worldPos = pcs.transform * vec4(v.position, 1.0f);
+    vec4 worldPos = inst.transform * vec4(v.position, 1.0f);
 
     gl_Position = pcs.sceneData.viewProj * worldPos;
     outPos = worldPos.xyz;
@@ -22,13 +27,15 @@ void main()
     // A bit inefficient, but okay - this is needed for non-uniform scale
     // models. See: http://www.lighthouse3d.com/tutorials/glsl-12-tutorial/the-normal-matrix/
     // Simpler case, when everything is uniform
-    // outNormal = (pcs.transform * vec4(v.normal, 0.0)).xyz;
-    outNormal = mat3(transpose(inverse(pcs.transform))) * v.normal;
+    // outNormal = (inst.transform * vec4(v.normal, 0.0)).xyz;
+    outNormal = mat3(transpose(inverse(inst.transform))) * v.normal;
 
     outTangent = v.tangent;
 
-    vec3 T = normalize(vec3(pcs.transform * v.tangent));
+    vec3 T = normalize(vec3(inst.transform * v.tangent));
     vec3 N = normalize(outNormal);
     vec3 B = cross(N, T) * v.tangent.w;
     outTBN = mat3(T, B, N);
+
+    outMaterialID = inst.materialID;
 }
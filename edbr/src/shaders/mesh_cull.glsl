@@ -0,0 +1,90 @@
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_scalar_block_layout: require
+
+#include "hiz.glsl"
+#include "mesh_instance.glsl"
+
+// VkDrawIndexedIndirectCommand
+struct DrawIndexedIndirectCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout (buffer_reference, scalar) buffer DrawCommandsBuffer {
+    DrawIndexedIndirectCommand commands[];
+};
+
+layout (buffer_reference, scalar) buffer CountsBuffer {
+    uint counts[];
+};
+
+// keep in sync with Meshlet (Meshlet.h)
+struct Meshlet {
+    vec4 boundingSphere; // xyz - center, w - radius (in mesh space)
+    vec3 coneApex;
+    vec3 coneAxis;
+    float coneCutoff;
+    uint firstIndex;
+    uint numIndices;
+};
+
+layout (buffer_reference, scalar) readonly buffer MeshletsBuffer {
+    Meshlet meshlets[];
+};
+
+// keep in sync with GPUMeshletDraw (IndirectDrawBuilder.h)
+struct MeshletDraw {
+    uint instanceIndex;
+    uint meshletIndex;
+};
+
+layout (buffer_reference, scalar) readonly buffer MeshletDrawsBuffer {
+    MeshletDraw draws[];
+};
+
+// keep in sync with MeshCullingPipeline::CullData
+layout (buffer_reference, scalar) readonly buffer CullDataBuffer {
+    vec4 frustumPlanes[6]; // xyz - normal (pointing inside), w - distance
+    // camera which was used to render the depth which Hi-Z was built from
+    mat4 hizView;
+    mat4 hizProj;
+    ivec2 depthImageSize;
+    float hizZNear;
+    uint occlusionCullingEnabled;
+    uint numInstances;
+    uint numDraws;
+    uint numIndex16Draws;
+    uint numMeshletDraws;
+    uint numIndex16MeshletDraws;
+    uint numIndex16Slots; // first compacted command with 32-bit indices
+    uint firstMeshletInstance; // first visible instance slot of meshlet draws
+    vec3 cameraPos;
+};
+
+layout (push_constant, scalar) uniform constants
+{
+    CullDataBuffer cullData;
+    MeshInstanceDataBuffer instances;
+    DrawCommandsBuffer commands;
+    CountsBuffer visibleCounts; // number of visible instances per draw command
+    VisibleInstancesBuffer visibleInstances;
+    HiZBuffer hiz;
+    DrawCommandsBuffer compactedCommands;
+    CountsBuffer drawCount;
+    MeshletsBuffer meshlets;
+    MeshletDrawsBuffer meshletDraws;
+} pcs;
+
+bool isInFrustum(vec3 center, float radius)
+{
+    for (int i = 0; i < 6; ++i) {
+        vec4 plane = pcs.cullData.frustumPlanes[i];
+        if (dot(plane.xyz, center) - plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
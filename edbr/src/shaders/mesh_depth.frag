@@ -12,6 +12,7 @@ layout (push_constant) uniform constants
     VertexBuffer vertexBuffer;
     MaterialsBuffer materials;
     uint materialID;
+    uint vertexFormat;
 } pcs;
 
 layout (location = 0) in vec2 inUV;
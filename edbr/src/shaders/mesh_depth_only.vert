@@ -13,11 +13,12 @@ layout (push_constant) uniform constants
     VertexBuffer vertexBuffer;
     MaterialsBuffer materials;
     uint materialID;
+    uint vertexFormat;
 } pcs;
 
 void main()
 {
-    Vertex v = pcs.vertexBuffer.vertices[gl_VertexIndex];
+    Vertex v = loadVertex(pcs.vertexBuffer, pcs.vertexFormat, gl_VertexIndex);
 
     outUV = vec2(v.uv_x, v.uv_y);
     gl_Position = pcs.mvp * vec4(v.position, 1.0f);
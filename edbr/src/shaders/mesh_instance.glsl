@@ -0,0 +1,29 @@
+#ifndef MESH_INSTANCE_GLSL
+#define MESH_INSTANCE_GLSL
+
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_scalar_block_layout: require
+
+#include "vertex.glsl"
+
+// keep in sync with GPUMeshInstanceData (IndirectDrawBuilder.h)
+struct MeshInstanceData {
+    mat4 transform;
+    vec4 worldBoundingSphere; // xyz - center, w - radius
+    VertexBuffer vertexBuffer;
+    uint vertexFormat;
+    uint materialID;
+    uint drawIndex;
+    uint padding;
+};
+
+layout (buffer_reference, scalar) readonly buffer MeshInstanceDataBuffer {
+    MeshInstanceData data[];
+};
+
+// indices into MeshInstanceDataBuffer of instances which passed GPU culling
+layout (buffer_reference, scalar) buffer VisibleInstancesBuffer {
+    uint indices[];
+};
+
+#endif // MESH_INSTANCE_GLSL
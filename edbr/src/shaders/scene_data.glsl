@@ -5,12 +5,17 @@
 #extension GL_EXT_buffer_reference : require
 
 #include "light.glsl"
+#include "light_clusters.glsl"
 #include "materials.glsl"
 
 layout (buffer_reference, scalar) readonly buffer LightsDataBuffer {
     Light data[];
 };
 
+layout (buffer_reference, scalar) readonly buffer PointShadowFacesBuffer {
+    PointShadowFace data[];
+};
+
 layout (buffer_reference, scalar) readonly buffer SceneDataBuffer {
     // camera
     mat4 view;
@@ -32,12 +37,20 @@ layout (buffer_reference, scalar) readonly buffer SceneDataBuffer {
     uint csmShadowMapId;
 
     float pointLightFarPlane;
+    uint pointShadowAtlasId;
+    PointShadowFacesBuffer pointShadowFaces; // 6 faces per shadow slot
 
     LightsDataBuffer lights;
     int numLights;
     int sunlightIndex; // if -1, there's no sun
 
     MaterialsBuffer materials;
+
+    // clustered lighting: sun is not binned - see LightClusterGrid
+    LightClustersBuffer lightClusters;
+    LightIndicesBuffer lightIndices;
+    float cameraZNear;
+    float cameraZFar;
 } sceneDataBuffer;
 
 #endif // SCENE_DATA_GLSL
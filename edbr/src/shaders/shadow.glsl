@@ -45,18 +45,33 @@ float calculateCSMOcclusion(
 }
 
 // point light shadows
-float calculatePointShadow(vec3 pos, vec3 lightPos, float NoL, uint shadowMapIndex, float farPlane)
+// faces look along +X, -X, +Y, -Y, +Z, -Z - see graphics::getPointShadowFace
+uint getPointShadowFace(vec3 lightToPoint)
 {
-    vec3 fragToLight = pos - lightPos;
-    fragToLight.z = -fragToLight.z; // coordinate system BS?
+    vec3 a = abs(lightToPoint);
+    if (a.x >= a.y && a.x >= a.z) {
+        return lightToPoint.x > 0.0 ? 0u : 1u;
+    }
+    if (a.y >= a.z) {
+        return lightToPoint.y > 0.0 ? 2u : 3u;
+    }
+    return lightToPoint.z > 0.0 ? 4u : 5u;
+}
 
-    float currentDepth = length(fragToLight);
+float calculatePointShadow(vec3 pos, vec3 lightPos, float NoL,
+        uint shadowAtlasId, mat4 faceViewProj, vec4 atlasRect, float farPlane)
+{
+    float currentDepth = distance(pos, lightPos);
 
     // slope based bias
     float bias = max(0.05f * (1.0f - NoL), 0.05f);
 
-	// float closestDepth = texture(shadowMap, vec4(fragToLight, mapIndex)).r;
-	float closestDepth = sampleTextureCubeNearest(shadowMapIndex, fragToLight).r;
+    vec4 faceClipPos = faceViewProj * vec4(pos, 1.0);
+    vec2 faceUV = faceClipPos.xy / faceClipPos.w * 0.5 + 0.5;
+    // don't sample neighbouring tiles
+    faceUV = clamp(faceUV, vec2(atlasRect.w), vec2(1.0 - atlasRect.w));
+    vec2 atlasUV = atlasRect.xy + faceUV * atlasRect.z;
+    float closestDepth = sampleTexture2DNearest(shadowAtlasId, atlasUV).r;
 
     closestDepth *= farPlane;
     return currentDepth -  bias > closestDepth ? 0.0 : 1.0;
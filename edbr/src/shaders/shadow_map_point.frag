@@ -16,7 +16,6 @@ void main()
         discard;
     }
 
-    Light light = pcs.lights.data[pcs.lightIndex];
-    gl_FragDepth = length(vec3(inWorldPos) - light.position) / pcs.farPlane;
+    gl_FragDepth = length(vec3(inWorldPos) - pcs.lightPosition) / pcs.farPlane;
 }
 
@@ -9,10 +9,10 @@ layout (location = 1) out vec2 outUV;
 
 void main()
 {
-    Vertex v = pcs.vertexBuffer.vertices[gl_VertexIndex];
+    Vertex v = loadVertex(pcs.vertexBuffer, pcs.vertexFormat, gl_VertexIndex);
 
     outWorldPos = pcs.model * vec4(v.position, 1.0f);
     outUV = vec2(v.uv_x, v.uv_y);
-    gl_Position = pcs.vpsBuffer.vps[pcs.vpsBufferIndex] * outWorldPos;
+    gl_Position = pcs.faces.data[pcs.faceIndex].viewProj * outWorldPos;
 }
 
@@ -5,20 +5,16 @@
 #include "scene_data.glsl"
 #include "materials.glsl"
 
-layout (buffer_reference, scalar) readonly buffer PointLightVPsBuffer {
-	mat4 vps[];
-};
-
 layout (push_constant) uniform constants
 {
     mat4 model;
+    vec3 lightPosition;
+    float farPlane;
     VertexBuffer vertexBuffer;
     MaterialsBuffer materials;
-    LightsDataBuffer lights;
-    PointLightVPsBuffer vpsBuffer;
+    PointShadowFacesBuffer faces;
     uint materialID;
-    uint lightIndex;
-    uint vpsBufferIndex; // index in vpsBuffer array
-    float farPlane;
+    uint faceIndex; // index in faces array
+    uint vertexFormat;
 } pcs;
 
@@ -2,6 +2,11 @@
 #define VERTEX_GLSL
 
 #extension GL_EXT_buffer_reference : require
+#extension GL_EXT_scalar_block_layout: require
+
+// keep in sync with VertexFormat (VertexQuantization.h)
+#define VERTEX_FORMAT_FULL 0
+#define VERTEX_FORMAT_COMPACT 1
 
 struct Vertex {
     vec3 position;
@@ -15,4 +20,68 @@ layout (buffer_reference, std430) readonly buffer VertexBuffer {
 	Vertex vertices[];
 };
 
+// keep in sync with graphics::CompactVertex (VertexQuantization.h)
+struct CompactVertex {
+    uint positionXY; // unorm16 x 2
+    uint positionZTangent; // unorm16 z, tangent angle and bitangent sign
+    uint normal; // octahedral, snorm16 x 2
+    uint uv; // half x 2
+};
+
+// keep in sync with graphics::CompactVertexHeader (VertexQuantization.h)
+layout (buffer_reference, scalar) readonly buffer CompactVertexBuffer {
+    vec3 positionMin;
+    float padding0;
+    vec3 positionScale;
+    float padding1;
+    CompactVertex vertices[];
+};
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 signNotZero = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * signNotZero;
+    }
+    return normalize(n);
+}
+
+// see graphics::decodeTangent
+vec4 decodeTangent(vec3 n, uint tangent)
+{
+    float s = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (s + n.z);
+    float c = n.x * n.y * a;
+    vec3 t = vec3(1.0 + s * n.x * n.x * a, s * c, -s * n.x);
+    vec3 b = vec3(c, s + n.y * n.y * a, -n.y);
+
+    float angle = float(tangent & 0x7fffu) / 32768.0 * 6.28318530718;
+    float bitangentSign = (tangent & 0x8000u) != 0u ? -1.0 : 1.0;
+    return vec4(cos(angle) * t + sin(angle) * b, bitangentSign);
+}
+
+// vertexFormat is one of VERTEX_FORMAT_* (should be uniform across the draw)
+Vertex loadVertex(VertexBuffer vertexBuffer, uint vertexFormat, uint index)
+{
+    if (vertexFormat == VERTEX_FORMAT_FULL) {
+        return vertexBuffer.vertices[index];
+    }
+
+    CompactVertexBuffer compactBuffer = CompactVertexBuffer(vertexBuffer);
+    CompactVertex cv = compactBuffer.vertices[index];
+
+    Vertex v;
+    vec3 position = vec3(
+        unpackUnorm2x16(cv.positionXY),
+        unpackUnorm2x16(cv.positionZTangent).x);
+    v.position = compactBuffer.positionMin + position * compactBuffer.positionScale;
+    vec2 uv = unpackHalf2x16(cv.uv);
+    v.uv_x = uv.x;
+    v.uv_y = uv.y;
+    v.normal = decodeOctahedral(unpackSnorm2x16(cv.normal));
+    v.tangent = decodeTangent(v.normal, cv.positionZTangent >> 16);
+    return v;
+}
+
 #endif // VERTEX_GLSL
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <edbr/Graphics/AnimationCompression.h>
+#include <edbr/Graphics/SkeletalAnimation.h>
+
+namespace
+{
+// smooth motion like in real animations, with a few constant and identity tracks
+SkeletalAnimation makeAnimation(std::size_t numJoints, std::size_t numFrames)
+{
+    SkeletalAnimation animation;
+    animation.name = "Test";
+    animation.duration = (float)(numFrames - 1) / 30.f;
+    animation.events[3].push_back("step");
+    animation.tracks.resize(numJoints);
+    for (std::size_t j = 0; j < numJoints; ++j) {
+        auto& tracks = animation.tracks[j];
+        const auto phase = (float)j * 0.3f;
+        for (std::size_t f = 0; f < numFrames; ++f) {
+            const auto t = (float)f / 30.f;
+            if (j == 0) {
+                // root moves
+                tracks.translations.push_back({std::sin(t + phase), 0.1f * t, std::cos(t)});
+            } else if (f == 0) {
+                // bone offset, constant
+                tracks.translations.push_back({0.f, 0.5f, 0.f});
+            }
+
+            const auto angle = 0.8f * std::sin(2.f * t + phase);
+            const auto axis = glm::normalize(glm::vec3{1.f, (float)j, 0.5f});
+            auto q = glm::angleAxis(angle, axis);
+            if (f % 7 == 0) {
+                q = -q; // same rotation
+            }
+            tracks.rotations.push_back(q);
+
+            if (j % 5 == 0) {
+                tracks.scales.push_back(glm::vec3{1.f + 0.2f * std::sin(t)});
+            } else if (j % 5 == 1) {
+                tracks.scales.push_back(glm::vec3{1.f}); // identity, should be dropped
+            }
+        }
+    }
+    return animation;
+}
+
+template<typename T>
+T getKey(const std::vector<T>& keys, std::size_t frame, const T& identity)
+{
+    return keys.empty() ? identity : keys[std::min(frame, keys.size() - 1)];
+}
+}
+
+TEST(AnimationCompression, ReconstructionError)
+{
+    static const std::size_t numFrames = 61;
+    const auto animation = makeAnimation(40, numFrames);
+
+    const auto settings = graphics::AnimationCompressionSettings{};
+    const auto compressed = graphics::compressAnimation(animation, settings);
+    const auto decompressed = graphics::decompressAnimation(compressed);
+
+    EXPECT_EQ(decompressed.name, animation.name);
+    EXPECT_EQ(decompressed.duration, animation.duration);
+    EXPECT_EQ(decompressed.events, animation.events);
+    ASSERT_EQ(decompressed.tracks.size(), animation.tracks.size());
+    EXPECT_EQ(decompressed.soaTracks.numLanes, 40);
+
+    // quantization error is added on top of key reduction tolerance
+    const auto maxTranslationError = settings.translationTolerance + 1e-4f;
+    const auto maxRotationError = settings.rotationTolerance + 5e-4f;
+    const auto maxScaleError = settings.scaleTolerance + 1e-4f;
+
+    float translationError = 0.f;
+    float rotationError = 0.f;
+    float scaleError = 0.f;
+    for (std::size_t j = 0; j < animation.tracks.size(); ++j) {
+        const auto& orig = animation.tracks[j];
+        const auto& dec = decompressed.tracks[j];
+        for (std::size_t f = 0; f < numFrames; ++f) {
+            const auto t0 = getKey(orig.translations, f, glm::vec3{0.f});
+            const auto t1 = getKey(dec.translations, f, glm::vec3{0.f});
+            translationError = std::max(translationError, glm::length(t0 - t1));
+
+            const auto q0 = getKey(orig.rotations, f, glm::quat{1.f, 0.f, 0.f, 0.f});
+            const auto q1 = getKey(dec.rotations, f, glm::quat{1.f, 0.f, 0.f, 0.f});
+            const auto sign = glm::dot(q0, q1) < 0.f ? -1.f : 1.f;
+            const auto d = glm::length(glm::vec4{
+                q0.x - sign * q1.x, q0.y - sign * q1.y, q0.z - sign * q1.z, q0.w - sign * q1.w});
+            rotationError = std::max(rotationError, 4.f * std::asin(d * 0.5f));
+
+            const auto s0 = getKey(orig.scales, f, glm::vec3{1.f});
+            const auto s1 = getKey(dec.scales, f, glm::vec3{1.f});
+            scaleError = std::max(scaleError, glm::length(s0 - s1));
+        }
+    }
+
+    EXPECT_LE(translationError, maxTranslationError);
+    EXPECT_LE(rotationError, maxRotationError);
+    EXPECT_LE(scaleError, maxScaleError);
+
+    // the stored metric is what was measured
+    EXPECT_NEAR(compressed.error.translation, translationError, 1e-5f);
+    EXPECT_NEAR(compressed.error.rotation, rotationError, 1e-4f);
+    EXPECT_NEAR(compressed.error.scale, scaleError, 1e-5f);
+}
+
+TEST(AnimationCompression, ConstantAndIdentityTracks)
+{
+    const auto animation = makeAnimation(10, 61);
+    const auto compressed = graphics::compressAnimation(animation);
+
+    using TrackType = CompressedAnimation::TrackType;
+    ASSERT_EQ(compressed.getNumJoints(), 10);
+
+    // constant translation is one key
+    EXPECT_EQ(compressed.getTrack(3, TrackType::Translation).numKeys, 1);
+    // identity scale is dropped
+    EXPECT_EQ(compressed.getTrack(1, TrackType::Scale).numKeys, 0);
+    // missing tracks stay missing
+    EXPECT_EQ(compressed.getTrack(2, TrackType::Scale).numKeys, 0);
+    // moving tracks keep the last key
+    const auto& track = compressed.getTrack(0, TrackType::Translation);
+    ASSERT_GT(track.numKeys, 1);
+    EXPECT_EQ(compressed.keyFrames[track.firstFrame + track.numKeys - 1], 60);
+}
+
+TEST(AnimationCompression, TrackDataIsSmaller)
+{
+    const auto animation = makeAnimation(40, 121);
+    const auto compressed = graphics::compressAnimation(animation);
+
+    const auto originalSize = graphics::getTrackDataSize(animation);
+    const auto compressedSize = graphics::getTrackDataSize(compressed);
+    EXPECT_LT(compressedSize * 5, originalSize);
+}
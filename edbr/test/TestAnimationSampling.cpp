@@ -0,0 +1,259 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <edbr/Graphics/AnimationSampling.h>
+#include <edbr/Graphics/SkeletalAnimation.h>
+#include <edbr/Graphics/Skeleton.h>
+
+namespace
+{
+// 0 -> {5, 2}, 5 -> {1}, 2 -> {3, 4}, 4 -> {6, 7, 8}
+// (children have smaller ids than parents sometimes)
+Skeleton makeSkeleton()
+{
+    Skeleton skeleton;
+    skeleton.joints.resize(9);
+    skeleton.hierarchy.resize(9);
+    skeleton.hierarchy[0].children = {5, 2};
+    skeleton.hierarchy[5].children = {1};
+    skeleton.hierarchy[2].children = {3, 4};
+    skeleton.hierarchy[4].children = {6, 7, 8};
+    for (std::size_t i = 0; i < skeleton.joints.size(); ++i) {
+        skeleton.joints[i].id = (JointId)i;
+        skeleton.inverseBindMatrices.push_back(
+            glm::translate(glm::mat4{1.f}, glm::vec3{0.f, -(float)i, 0.f}));
+    }
+    skeleton.flatSkeleton = graphics::makeFlatSkeleton(skeleton);
+    return skeleton;
+}
+
+SkeletalAnimation makeAnimation(const Skeleton& skeleton, std::size_t numKeys)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> dist{-1.f, 1.f};
+
+    SkeletalAnimation animation;
+    animation.tracks.resize(skeleton.joints.size());
+    animation.duration = (float)(numKeys - 1) / graphics::ANIMATION_FPS;
+    for (std::size_t i = 0; i < animation.tracks.size(); ++i) {
+        auto& tracks = animation.tracks[i];
+        // some tracks are constant and some are missing, like in glTF files
+        const auto numTrackKeys = (i % 3 == 0) ? 1 : numKeys;
+        glm::quat rot{1.f, 0.f, 0.f, 0.f};
+        for (std::size_t key = 0; key < numTrackKeys; ++key) {
+            tracks.translations.push_back({dist(rng), dist(rng), dist(rng)});
+            // small steps, like in real animations
+            rot = glm::normalize(rot * glm::quat{1.f, dist(rng) * 0.1f, dist(rng) * 0.1f, 0.f});
+            // sign flips shouldn't change anything
+            tracks.rotations.push_back(key % 2 ? -rot : rot);
+            if (i % 4 != 0) {
+                tracks.scales.push_back(glm::vec3{1.f + dist(rng) * 0.3f});
+            }
+        }
+    }
+    animation.soaTracks = graphics::makeSoAAnimation(animation);
+    return animation;
+}
+
+// how SkeletonAnimator used to sample animations
+glm::mat4 sampleJointReference(const SkeletalAnimation& animation, JointId jointId, float time)
+{
+    const auto findKeys = [time](std::size_t numKeys) {
+        const auto prevKey =
+            std::min((std::size_t)std::floor(time * graphics::ANIMATION_FPS), numKeys - 1);
+        const auto nextKey = std::min(prevKey + 1, numKeys - 1);
+        const auto t = prevKey != nextKey ? time * graphics::ANIMATION_FPS - (float)prevKey : 0.f;
+        return std::tuple{prevKey, nextKey, t};
+    };
+
+    const auto& ts = animation.tracks[jointId];
+    glm::mat4 tm{1.f};
+    if (!ts.translations.empty()) {
+        const auto [p, n, t] = findKeys(ts.translations.size());
+        tm[3] = glm::vec4{glm::mix(ts.translations[p], ts.translations[n], t), 1.f};
+    }
+    if (!ts.rotations.empty()) {
+        const auto [p, n, t] = findKeys(ts.rotations.size());
+        tm *= glm::mat4_cast(glm::slerp(ts.rotations[p], ts.rotations[n], t));
+    }
+    if (!ts.scales.empty()) {
+        const auto [p, n, t] = findKeys(ts.scales.size());
+        tm = glm::scale(tm, glm::mix(ts.scales[p], ts.scales[n], t));
+    }
+    return tm;
+}
+
+void calculateReference(
+    const Skeleton& skeleton,
+    const SkeletalAnimation& animation,
+    float time,
+    JointId jointId,
+    const glm::mat4& parentTransform,
+    std::vector<glm::mat4>& jointMatrices)
+{
+    const auto modelTransform = parentTransform * sampleJointReference(animation, jointId, time);
+    jointMatrices[jointId] = modelTransform * skeleton.inverseBindMatrices[jointId];
+    for (const auto childId : skeleton.hierarchy[jointId].children) {
+        calculateReference(skeleton, animation, time, childId, modelTransform, jointMatrices);
+    }
+}
+
+void expectValuesNear(const std::vector<float>& a, const std::vector<float>& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        EXPECT_NEAR(a[i], b[i], 1e-5f) << "i = " << i;
+    }
+}
+
+void expectMatricesNear(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t j = 0; j < a.size(); ++j) {
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                EXPECT_NEAR(a[j][c][r], b[j][c][r], 1e-3f) << "joint = " << j;
+            }
+        }
+    }
+}
+}
+
+TEST(AnimationSampling, FlatSkeletonParentsGoFirst)
+{
+    const auto skeleton = makeSkeleton();
+    const auto& flat = skeleton.flatSkeleton;
+
+    ASSERT_EQ(flat.getNumJoints(), 9);
+    EXPECT_EQ(flat.jointIds[0], ROOT_JOINT_ID);
+    EXPECT_EQ(flat.parents[0], FlatSkeleton::NO_PARENT);
+    for (std::size_t i = 1; i < flat.getNumJoints(); ++i) {
+        const auto parent = flat.parents[i];
+        const auto parentIt = std::find(flat.jointIds.begin(), flat.jointIds.end(), parent);
+        ASSERT_LT(parentIt - flat.jointIds.begin(), i);
+        const auto& children = skeleton.hierarchy[parent].children;
+        EXPECT_NE(std::find(children.begin(), children.end(), flat.jointIds[i]), children.end());
+        EXPECT_EQ(flat.inverseBindMatrices[i], skeleton.inverseBindMatrices[flat.jointIds[i]]);
+    }
+}
+
+TEST(AnimationSampling, MatchesRecursiveSampling)
+{
+    const auto skeleton = makeSkeleton();
+    const auto animation = makeAnimation(skeleton, 20);
+
+    std::vector<glm::mat4> expected(skeleton.joints.size());
+    std::vector<glm::mat4> jointMatrices(skeleton.joints.size());
+    std::vector<glm::mat4> transforms;
+    for (float time = 0.f; time <= animation.duration + 0.1f; time += 0.01f) {
+        calculateReference(skeleton, animation, time, ROOT_JOINT_ID, glm::mat4{1.f}, expected);
+        graphics::sampleJointMatrices(
+            skeleton.flatSkeleton, animation.soaTracks, time, jointMatrices, transforms);
+
+        for (std::size_t j = 0; j < expected.size(); ++j) {
+            for (int c = 0; c < 4; ++c) {
+                for (int r = 0; r < 4; ++r) {
+                    EXPECT_NEAR(jointMatrices[j][c][r], expected[j][c][r], 1e-3f)
+                        << "time = " << time << ", joint = " << j;
+                }
+            }
+        }
+    }
+}
+
+TEST(AnimationSampling, PoseSamplingMatchesDirectSampling)
+{
+    const auto skeleton = makeSkeleton();
+    const auto animation = makeAnimation(skeleton, 20);
+
+    std::vector<glm::mat4> expected(skeleton.joints.size());
+    std::vector<glm::mat4> jointMatrices(skeleton.joints.size());
+    std::vector<glm::mat4> transforms;
+    LocalPose pose;
+    for (float time = 0.f; time <= animation.duration; time += 0.07f) {
+        graphics::sampleJointMatrices(
+            skeleton.flatSkeleton, animation.soaTracks, time, expected, transforms);
+        graphics::sampleLocalPose(animation.soaTracks, time, pose);
+        graphics::calculateJointMatrices(skeleton.flatSkeleton, pose, jointMatrices, transforms);
+        expectMatricesNear(jointMatrices, expected);
+    }
+}
+
+TEST(AnimationSampling, BlendLocalPoses)
+{
+    const auto skeleton = makeSkeleton();
+    const auto animation = makeAnimation(skeleton, 20);
+
+    LocalPose a, b, blended;
+    graphics::sampleLocalPose(animation.soaTracks, 0.1f, a);
+    graphics::sampleLocalPose(animation.soaTracks, 0.5f, b);
+
+    graphics::blendLocalPoses(a, b, 0.f, blended);
+    expectValuesNear(blended.translations, a.translations);
+    expectValuesNear(blended.rotations, a.rotations);
+    graphics::blendLocalPoses(a, b, 1.f, blended);
+    expectValuesNear(blended.translations, b.translations);
+    expectValuesNear(blended.rotations, b.rotations);
+
+    // rotations in the opposite hemisphere are the same rotations
+    auto negated = a;
+    for (auto& v : negated.rotations) {
+        v = -v;
+    }
+    graphics::blendLocalPoses(a, negated, 0.5f, blended);
+    expectValuesNear(blended.rotations, a.rotations);
+
+    // out can be one of the inputs
+    graphics::blendLocalPoses(a, b, 0.25f, blended);
+    graphics::blendLocalPoses(a, b, 0.25f, a);
+    EXPECT_EQ(a.rotations, blended.rotations);
+}
+
+TEST(AnimationSampling, AdditivePoseRestoresAnimation)
+{
+    const auto skeleton = makeSkeleton();
+    const auto animation = makeAnimation(skeleton, 20);
+    const auto additive = graphics::makeAdditiveAnimation(animation.soaTracks);
+
+    std::vector<glm::mat4> expected(skeleton.joints.size());
+    std::vector<glm::mat4> jointMatrices(skeleton.joints.size());
+    std::vector<glm::mat4> transforms;
+    LocalPose pose, delta;
+    for (float time = 0.f; time <= animation.duration; time += 0.07f) {
+        // reference pose + full delta = animation
+        graphics::sampleLocalPose(animation.soaTracks, 0.f, pose);
+        graphics::sampleLocalPose(additive, time, delta);
+        graphics::addLocalPose(pose, delta, 1.f);
+        graphics::calculateJointMatrices(skeleton.flatSkeleton, pose, jointMatrices, transforms);
+        graphics::sampleJointMatrices(
+            skeleton.flatSkeleton, animation.soaTracks, time, expected, transforms);
+        expectMatricesNear(jointMatrices, expected);
+
+        // zero weight doesn't change anything
+        graphics::sampleLocalPose(animation.soaTracks, 0.f, pose);
+        const auto before = pose;
+        graphics::addLocalPose(pose, delta, 0.f);
+        expectValuesNear(pose.rotations, before.rotations);
+        expectValuesNear(pose.translations, before.translations);
+    }
+}
+
+TEST(AnimationSampling, LocalPosePoolReusesPoses)
+{
+    LocalPosePool pool;
+    auto& a = pool.acquire();
+    auto& b = pool.acquire();
+    EXPECT_NE(&a, &b);
+
+    pool.releaseAll();
+    EXPECT_EQ(&pool.acquire(), &a);
+    EXPECT_EQ(&pool.acquire(), &b);
+    pool.acquire();
+    EXPECT_EQ(pool.getNumPoses(), 3);
+}
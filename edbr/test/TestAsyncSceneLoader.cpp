@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include <edbr/AsyncSceneLoader.h>
+#include <edbr/Core/TaskQueue.h>
+
+namespace
+{
+// fake GPU: uploads are complete when the test says so
+struct FakeStages {
+    std::atomic<int> numDecoded{0};
+    std::atomic<bool> decodedOnMainThread{false};
+    std::thread::id mainThreadId{std::this_thread::get_id()};
+
+    std::vector<std::filesystem::path> uploaded;
+    std::uint64_t lastSubmitValue{0};
+    std::uint64_t completedValue{0};
+    int numSubmits{0};
+    std::vector<std::filesystem::path> loaded;
+
+    AsyncSceneLoader::Stages makeStages()
+    {
+        return {
+            .decode =
+                [this](const std::filesystem::path& path) {
+                    if (std::this_thread::get_id() == mainThreadId) {
+                        decodedOnMainThread = true;
+                    }
+                    if (path == "missing.gltf") {
+                        throw std::runtime_error("file not found");
+                    }
+                    ++numDecoded;
+                    return DecodedScene{SceneData{.scene = {.path = path}}};
+                },
+            .upload =
+                [this](const std::filesystem::path& path, DecodedScene decoded) {
+                    uploaded.push_back(path);
+                    return std::move(std::get<SceneData>(decoded).scene);
+                },
+            .submit =
+                [this]() {
+                    ++numSubmits;
+                    return ++lastSubmitValue;
+                },
+            .isUploadComplete = [this](std::uint64_t value) { return value <= completedValue; },
+            .waitForUpload = [this](std::uint64_t value) { completedValue = value; },
+            .onLoaded =
+                [this](const std::filesystem::path& path, Scene scene) {
+                    EXPECT_EQ(scene.path, path);
+                    loaded.push_back(path);
+                },
+        };
+    }
+};
+}
+
+TEST(TaskQueue, RunsAllTasks)
+{
+    std::atomic<int> sum{0};
+    {
+        TaskQueue taskQueue(3);
+        for (int i = 1; i <= 100; ++i) {
+            taskQueue.push([&sum, i]() { sum += i; });
+        }
+        taskQueue.waitIdle();
+        EXPECT_EQ(sum, 5050);
+
+        // the destructor finishes pushed tasks
+        taskQueue.push([&sum]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            sum += 1;
+        });
+    }
+    EXPECT_EQ(sum, 5051);
+}
+
+TEST(TaskQueue, NoThreads)
+{
+    TaskQueue taskQueue(0);
+    int value = 0;
+    taskQueue.push([&value]() { value = 42; });
+    EXPECT_EQ(value, 42);
+}
+
+TEST(AsyncSceneLoader, StagesAndBatchedSubmit)
+{
+    TaskQueue taskQueue(2);
+    FakeStages fake;
+    AsyncSceneLoader loader(taskQueue, fake.makeStages());
+
+    const auto a = loader.load("a.gltf");
+    const auto b = loader.load("b.gltf");
+    EXPECT_EQ(loader.load("a.gltf").getPath(), a.getPath()); // already loading
+    EXPECT_EQ(loader.getNumLoadingScenes(), 2);
+
+    taskQueue.waitIdle();
+    EXPECT_EQ(fake.numDecoded, 2);
+    EXPECT_FALSE(fake.decodedOnMainThread);
+    EXPECT_FALSE(a.isReady());
+
+    // both scenes are uploaded with one submit
+    loader.update();
+    EXPECT_EQ(fake.uploaded.size(), 2);
+    EXPECT_EQ(fake.numSubmits, 1);
+    EXPECT_FALSE(a.isReady());
+    EXPECT_TRUE(fake.loaded.empty());
+
+    // not ready until the GPU is done
+    loader.update();
+    EXPECT_EQ(fake.numSubmits, 1);
+    EXPECT_FALSE(b.isReady());
+
+    fake.completedValue = fake.lastSubmitValue;
+    loader.update();
+    EXPECT_TRUE(a.isReady());
+    EXPECT_TRUE(b.isReady());
+    EXPECT_EQ(fake.loaded.size(), 2);
+    EXPECT_EQ(loader.getNumLoadingScenes(), 0);
+    EXPECT_FALSE(loader.findLoadingScene("a.gltf").isValid());
+}
+
+TEST(AsyncSceneLoader, Wait)
+{
+    TaskQueue taskQueue(1);
+    FakeStages fake;
+    AsyncSceneLoader loader(taskQueue, fake.makeStages());
+
+    const auto handle = loader.load("a.gltf");
+    loader.wait(handle);
+    EXPECT_TRUE(handle.isReady());
+    ASSERT_EQ(fake.loaded.size(), 1);
+    EXPECT_EQ(fake.loaded[0], "a.gltf");
+}
+
+TEST(AsyncSceneLoader, DecodeFailure)
+{
+    TaskQueue taskQueue(1);
+    FakeStages fake;
+    AsyncSceneLoader loader(taskQueue, fake.makeStages());
+
+    const auto handle = loader.load("missing.gltf");
+    loader.wait(handle);
+    EXPECT_TRUE(handle.hasFailed());
+    EXPECT_TRUE(handle.isDone());
+    EXPECT_TRUE(fake.uploaded.empty());
+    EXPECT_TRUE(fake.loaded.empty());
+    EXPECT_EQ(loader.getNumLoadingScenes(), 0);
+}
+
+TEST(AsyncSceneLoader, ReadyHandle)
+{
+    const auto handle = SceneLoadHandle::makeReady("a.gltf");
+    EXPECT_TRUE(handle.isReady());
+    EXPECT_FALSE(SceneLoadHandle{}.isValid());
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <edbr/Graphics/BufferSubAllocator.h>
+
+TEST(BufferSubAllocator, AllocatesSequentially)
+{
+    BufferSubAllocator allocator(100);
+    EXPECT_EQ(allocator.allocate(10), 0);
+    EXPECT_EQ(allocator.allocate(20), 10);
+    EXPECT_EQ(allocator.allocate(70), 30);
+    EXPECT_EQ(allocator.getUsedSize(), 100);
+    EXPECT_EQ(allocator.allocate(1), std::nullopt);
+    EXPECT_EQ(allocator.allocate(0), std::nullopt);
+}
+
+TEST(BufferSubAllocator, ReusesFreedRanges)
+{
+    BufferSubAllocator allocator(100);
+    const auto a = allocator.allocate(10);
+    const auto b = allocator.allocate(10);
+    ASSERT_TRUE(a.has_value() && b.has_value());
+
+    allocator.free(*a, 10);
+    EXPECT_EQ(allocator.allocate(15), 20); // doesn't fit into the freed range
+    EXPECT_EQ(allocator.allocate(5), 0); // first fit
+    EXPECT_EQ(allocator.allocate(5), 5);
+}
+
+TEST(BufferSubAllocator, CoalescesFreeRanges)
+{
+    BufferSubAllocator allocator(30);
+    const auto a = allocator.allocate(10);
+    const auto b = allocator.allocate(10);
+    const auto c = allocator.allocate(10);
+    EXPECT_EQ(allocator.getNumFreeRanges(), 0);
+
+    allocator.free(*a, 10);
+    allocator.free(*c, 10);
+    EXPECT_EQ(allocator.getNumFreeRanges(), 2);
+
+    allocator.free(*b, 10); // merges with both neighbours
+    EXPECT_EQ(allocator.getNumFreeRanges(), 1);
+    EXPECT_EQ(allocator.getUsedSize(), 0);
+    EXPECT_EQ(allocator.allocate(30), 0);
+}
+
+TEST(BufferSubAllocator, Grow)
+{
+    BufferSubAllocator allocator;
+    EXPECT_EQ(allocator.allocate(10), std::nullopt);
+
+    allocator.grow(16);
+    EXPECT_EQ(allocator.allocate(10), 0);
+    EXPECT_EQ(allocator.allocate(10), std::nullopt);
+
+    allocator.grow(32); // extends the trailing free range [10, 16)
+    EXPECT_EQ(allocator.getNumFreeRanges(), 1);
+    EXPECT_EQ(allocator.allocate(22), 10);
+    EXPECT_EQ(allocator.getCapacity(), 32);
+}
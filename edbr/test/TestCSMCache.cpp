@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <random>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/CSMCache.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+namespace
+{
+using UpdateType = CSMCache::UpdateType;
+
+const auto lightDir = glm::normalize(glm::vec3{0.3f, -1.f, 0.2f});
+
+CSMCache::Params makeParams()
+{
+    return CSMCache::Params{
+        .shadowMapSize = 1024.f,
+        .moveThresholdTexels = 32.f,
+    };
+}
+
+std::array<math::Sphere, 3> makeBounds(const glm::vec3& offset)
+{
+    return {
+        math::Sphere{.center = offset + glm::vec3{0.f, 0.f, -5.f}, .radius = 6.f},
+        math::Sphere{.center = offset + glm::vec3{0.f, 0.f, -20.f}, .radius = 16.f},
+        math::Sphere{.center = offset + glm::vec3{0.f, 0.f, -60.f}, .radius = 45.f},
+    };
+}
+
+// cascades are square in light space (see createCSMCamera)
+bool isCovered(const Camera& camera, const math::Sphere& sphere)
+{
+    const auto viewProj = camera.getViewProj();
+    for (const auto& d : {
+             glm::vec3{1.f, 0.f, 0.f},
+             glm::vec3{-1.f, 0.f, 0.f},
+             glm::vec3{0.f, 1.f, 0.f},
+             glm::vec3{0.f, -1.f, 0.f},
+             glm::vec3{0.f, 0.f, 1.f},
+             glm::vec3{0.f, 0.f, -1.f},
+         }) {
+        const auto p = viewProj * glm::vec4{sphere.center + d * sphere.radius, 1.f};
+        if (std::abs(p.x) > 1.0001f || std::abs(p.y) > 1.0001f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::array<UpdateType, 3> getUpdateTypes(const CSMCache& cache)
+{
+    return {cache.getUpdateType(0), cache.getUpdateType(1), cache.getUpdateType(2)};
+}
+}
+
+TEST(CSMCache, FirstUpdateIsFull)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+
+    cache.update(makeBounds({}), lightDir, 42);
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(cache.getUpdateType(i), UpdateType::Full);
+    }
+
+    // nothing changed - only dynamic casters are drawn
+    cache.update(makeBounds({}), lightDir, 42);
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(cache.getUpdateType(i), UpdateType::Dynamic);
+    }
+}
+
+TEST(CSMCache, SmallMovesKeepCamera)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+    cache.update(makeBounds({}), lightDir, 0);
+    const auto camera0 = cache.getCamera(0).getViewProj();
+
+    // cascade 0 has 2 * 6 * 1024 / (1024 - 64) = 12.8 units over 1024 texels,
+    // so 32 texels are 0.4 units
+    cache.update(makeBounds({0.1f, 0.f, 0.f}), lightDir, 0);
+    EXPECT_EQ(cache.getUpdateType(0), UpdateType::Dynamic);
+    EXPECT_EQ(cache.getCamera(0).getViewProj(), camera0);
+
+    cache.update(makeBounds({1.f, 0.f, 0.f}), lightDir, 0);
+    // bigger cascades still cover their spheres
+    EXPECT_EQ(
+        getUpdateTypes(cache),
+        (std::array{UpdateType::Full, UpdateType::Dynamic, UpdateType::Dynamic}));
+    EXPECT_NE(cache.getCamera(0).getViewProj(), camera0);
+}
+
+TEST(CSMCache, CascadesAlwaysCoverBounds)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+
+    std::mt19937 rng{5};
+    std::uniform_real_distribution<float> stepDist{-0.3f, 0.3f};
+    auto pos = glm::vec3{};
+    std::array<int, 3> numFullUpdates{};
+    for (int frame = 0; frame < 1000; ++frame) {
+        pos += glm::vec3{stepDist(rng), stepDist(rng) * 0.1f, stepDist(rng)};
+        const auto bounds = makeBounds(pos);
+        cache.update(bounds, lightDir, 0);
+        for (std::size_t i = 0; i < 3; ++i) {
+            EXPECT_TRUE(isCovered(cache.getCamera(i), bounds[i])) << frame << " " << i;
+            if (cache.getUpdateType(i) == UpdateType::Full) {
+                ++numFullUpdates[i];
+            }
+        }
+    }
+
+    // far cascades have more texels per unit of movement
+    EXPECT_LT(numFullUpdates[0], 500);
+    EXPECT_LT(numFullUpdates[2], numFullUpdates[0]);
+    EXPECT_LT(numFullUpdates[2], 50);
+}
+
+TEST(CSMCache, CameraIsSnappedToTexels)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+    cache.update(makeBounds({0.123f, 0.f, 0.f}), lightDir, 0);
+
+    // camera center is at a whole texel in light space
+    const auto texelSize = cache.getRadius(0) * 2.f / 1024.f;
+    const auto view = cache.getCamera(0).getView();
+    const auto origin = view * glm::vec4{0.f, 0.f, 0.f, 1.f};
+    for (int c = 0; c < 2; ++c) {
+        const auto texels = origin[c] / texelSize;
+        EXPECT_NEAR(texels, std::round(texels), 1e-2f);
+    }
+}
+
+TEST(CSMCache, LightDirectionChangeInvalidatesAll)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+    cache.update(makeBounds({}), lightDir, 0);
+    cache.update(makeBounds({}), lightDir, 0);
+    EXPECT_EQ(cache.getUpdateType(2), UpdateType::Dynamic);
+
+    const auto newLightDir = glm::normalize(lightDir + glm::vec3{0.05f, 0.f, 0.f});
+    cache.update(makeBounds({}), newLightDir, 0);
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(cache.getUpdateType(i), UpdateType::Full);
+    }
+}
+
+TEST(CSMCache, StaticCastersChangeInvalidatesAll)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+    cache.update(makeBounds({}), lightDir, 1);
+    cache.update(makeBounds({}), lightDir, 1);
+    EXPECT_EQ(cache.getUpdateType(0), UpdateType::Dynamic);
+
+    cache.update(makeBounds({}), lightDir, 2);
+    EXPECT_EQ(cache.getUpdateType(0), UpdateType::Full);
+
+    cache.invalidate();
+    cache.update(makeBounds({}), lightDir, 2);
+    EXPECT_EQ(cache.getUpdateType(0), UpdateType::Full);
+}
+
+TEST(CSMCache, ShrinkingCascadeIsRefit)
+{
+    CSMCache cache;
+    cache.init(3, makeParams());
+    auto bounds = makeBounds({});
+    cache.update(bounds, lightDir, 0);
+
+    bounds[1].radius *= 0.9f;
+    cache.update(bounds, lightDir, 0);
+    EXPECT_EQ(cache.getUpdateType(1), UpdateType::Dynamic);
+
+    bounds[1].radius *= 0.5f;
+    cache.update(bounds, lightDir, 0);
+    EXPECT_EQ(cache.getUpdateType(1), UpdateType::Full);
+}
+
+TEST(CSMCache, FarCascadeEveryOtherFrame)
+{
+    CSMCache cache;
+    auto params = makeParams();
+    params.updateFarCascadesEveryOtherFrame = true;
+    params.firstFarCascade = 2;
+    cache.init(3, params);
+
+    cache.update(makeBounds({}), lightDir, 0);
+    EXPECT_EQ(cache.getUpdateType(2), UpdateType::Full);
+
+    std::array<int, 3> numDynamicUpdates{};
+    for (int frame = 0; frame < 10; ++frame) {
+        cache.update(makeBounds({}), lightDir, 0);
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (cache.getUpdateType(i) == UpdateType::Dynamic) {
+                ++numDynamicUpdates[i];
+            }
+        }
+    }
+    EXPECT_EQ(numDynamicUpdates, (std::array{10, 10, 5}));
+
+    // refit is never delayed
+    for (int frame = 0; frame < 2; ++frame) {
+        cache.update(makeBounds({20.f * (float)(frame + 1), 0.f, 0.f}), lightDir, 0);
+        EXPECT_EQ(cache.getUpdateType(2), UpdateType::Full);
+    }
+}
+
+TEST(CSMCache, StaticCastersHash)
+{
+    auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 1, .transformMatrix = glm::mat4{1.f}, .materialId = 1, .isStatic = true},
+        {.meshId = 2, .transformMatrix = glm::mat4{1.f}, .materialId = 1, .isStatic = true},
+        {.meshId = 3, .transformMatrix = glm::mat4{1.f}, .materialId = 1, .isStatic = false},
+    };
+    drawCommands[1].transformMatrix[3] = glm::vec4{1.f, 2.f, 3.f, 1.f};
+    const auto hash = graphics::hashStaticShadowCasters(drawCommands);
+
+    // order doesn't matter (parallel draw lists are merged in any order)
+    std::swap(drawCommands[0], drawCommands[1]);
+    EXPECT_EQ(graphics::hashStaticShadowCasters(drawCommands), hash);
+
+    // dynamic casters don't matter
+    drawCommands[2].transformMatrix[3].x = 5.f;
+    EXPECT_EQ(graphics::hashStaticShadowCasters(drawCommands), hash);
+
+    // moved static caster
+    drawCommands[0].transformMatrix[3].x += 0.01f;
+    EXPECT_NE(graphics::hashStaticShadowCasters(drawCommands), hash);
+
+    // removed static caster
+    drawCommands.erase(drawCommands.begin());
+    EXPECT_NE(graphics::hashStaticShadowCasters(drawCommands), hash);
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include <edbr/Util/CookedScene.h>
+
+namespace
+{
+std::filesystem::path getTempDir()
+{
+    const auto dir = std::filesystem::temp_directory_path() / "edbr_test_cooked_scene";
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+SceneData makeSceneData(const std::filesystem::path& dir)
+{
+    SceneData data;
+    data.materials.push_back(SceneMaterial{
+        .material =
+            {
+                .baseColor = {0.5f, 0.25f, 1.f, 1.f},
+                .metallicFactor = 0.3f,
+                .name = "Skin",
+            },
+        .diffuseTexture = dir / "textures" / "skin.png",
+    });
+
+    CPUMesh mesh{
+        .indices = {0, 1, 2, 2, 1, 3},
+        .hasSkeleton = true,
+        .name = "Body",
+        .minPos = {-1.f, 0.f, 0.f},
+        .maxPos = {1.f, 2.f, 0.f},
+    };
+    for (int i = 0; i < 4; ++i) {
+        mesh.vertices.push_back({
+            .position = {(i % 2) ? 1.f : -1.f, (float)(i / 2) * 2.f, 0.f},
+            .uv_x = (float)i,
+        });
+        mesh.skinningData.push_back({
+            .jointIds = {0, 1, 0, 0},
+            .weights = {0.75f, 0.25f, 0.f, 0.f},
+        });
+    }
+    mesh.lods.push_back({.indices = {0, 1, 3}, .error = 0.5f});
+    mesh.meshlets.push_back(Meshlet{.coneCutoff = 0.5f, .firstIndex = 3, .numIndices = 3});
+    data.meshes.push_back({ScenePrimitive{.mesh = mesh, .materialIndex = 0}});
+
+    auto& scene = data.scene;
+    Skeleton skeleton;
+    skeleton.joints = {{.id = 0}, {.id = 1}};
+    skeleton.joints[1].localTransform.setPosition({0.f, 1.f, 0.f});
+    skeleton.jointNames = {"root", "spine"};
+    skeleton.hierarchy = {{.children = {1}}, {}};
+    skeleton.inverseBindMatrices = {glm::mat4{1.f}, glm::mat4{2.f}};
+    scene.skeletons.push_back(skeleton);
+
+    SkeletalAnimation animation{.duration = 1.f, .name = "Walk"};
+    animation.tracks.resize(2);
+    animation.tracks[1].translations = {{0.f, 1.f, 0.f}, {0.f, 2.f, 0.f}};
+    animation.tracks[1].rotations = {glm::quat{1.f, 0.f, 0.f, 0.f}};
+    scene.animations.emplace("Walk", animation);
+
+    scene.lights.push_back(Light{.name = "Lamp", .type = LightType::Point, .range = 5.f});
+
+    auto& root = scene.nodes.emplace_back(std::make_unique<SceneNode>());
+    root->name = "Root";
+    root->skinId = 0;
+    auto& child = root->children.emplace_back(std::make_unique<SceneNode>());
+    child->name = "Body";
+    child->meshIndex = 0;
+    child->parent = root.get();
+    child->transform.setPosition({3.f, 4.f, 5.f});
+
+    return data;
+}
+}
+
+TEST(CookedScene, Roundtrip)
+{
+    const auto dir = getTempDir();
+    const auto path = dir / "roundtrip.edbrscene";
+    const auto data = makeSceneData(dir);
+    util::writeCookedScene(path, data);
+
+    const auto cooked = util::readCookedScene(path);
+    ASSERT_TRUE(cooked.has_value());
+
+    ASSERT_EQ(cooked->materials.size(), 1);
+    EXPECT_EQ(cooked->materials[0].material.name, "Skin");
+    EXPECT_EQ(cooked->materials[0].material.metallicFactor, 0.3f);
+    EXPECT_EQ(cooked->materials[0].diffuseTexture, dir / "textures" / "skin.png");
+    EXPECT_TRUE(cooked->materials[0].normalMapTexture.empty());
+
+    ASSERT_EQ(cooked->meshes.size(), 1);
+    ASSERT_EQ(cooked->meshes[0].size(), 1);
+    const auto& primitive = cooked->meshes[0][0];
+    const auto& srcMesh = data.meshes[0][0].mesh;
+    EXPECT_EQ(primitive.name, "Body");
+    EXPECT_EQ(primitive.materialIndex, 0);
+    EXPECT_EQ(primitive.mesh.maxPos, srcMesh.maxPos);
+    EXPECT_TRUE(primitive.mesh.boundingSphere.has_value());
+    ASSERT_EQ(primitive.mesh.indices.size(), srcMesh.indices.size());
+    ASSERT_EQ(primitive.mesh.vertices.size(), srcMesh.vertices.size());
+    ASSERT_EQ(primitive.mesh.skinningData.size(), srcMesh.skinningData.size());
+    for (std::size_t i = 0; i < srcMesh.indices.size(); ++i) {
+        EXPECT_EQ(primitive.mesh.indices[i], srcMesh.indices[i]);
+    }
+    for (std::size_t i = 0; i < srcMesh.vertices.size(); ++i) {
+        EXPECT_EQ(primitive.mesh.vertices[i].position, srcMesh.vertices[i].position);
+        EXPECT_EQ(primitive.mesh.vertices[i].uv_x, srcMesh.vertices[i].uv_x);
+        EXPECT_EQ(primitive.mesh.skinningData[i].weights, srcMesh.skinningData[i].weights);
+    }
+    ASSERT_EQ(primitive.mesh.lods.size(), 1);
+    EXPECT_EQ(primitive.mesh.lods[0].error, 0.5f);
+    EXPECT_TRUE(std::ranges::equal(primitive.mesh.lods[0].indices, srcMesh.lods[0].indices));
+    ASSERT_EQ(primitive.mesh.meshlets.size(), 1);
+    EXPECT_EQ(primitive.mesh.meshlets[0].coneCutoff, 0.5f);
+    EXPECT_EQ(primitive.mesh.meshlets[0].firstIndex, 3);
+    // arrays are used straight from the mapping, so they must be aligned
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(primitive.mesh.vertices.data()) % 16, 0);
+
+    const auto& scene = cooked->scene;
+    ASSERT_EQ(scene.skeletons.size(), 1);
+    const auto& skeleton = scene.skeletons[0];
+    EXPECT_EQ(skeleton.jointNames[1], "spine");
+    EXPECT_EQ(skeleton.joints[1].localTransform.getPosition(), glm::vec3(0.f, 1.f, 0.f));
+    ASSERT_EQ(skeleton.hierarchy[0].children.size(), 1);
+    EXPECT_EQ(skeleton.hierarchy[0].children[0], 1);
+    EXPECT_EQ(skeleton.inverseBindMatrices[1], glm::mat4{2.f});
+    EXPECT_EQ(skeleton.flatSkeleton.parents.size(), 2);
+
+    // animations are compressed when cooking
+    EXPECT_TRUE(scene.animations.empty());
+    ASSERT_TRUE(scene.compressedAnimations.contains("Walk"));
+    const auto animation = graphics::decompressAnimation(scene.compressedAnimations.at("Walk"));
+    EXPECT_EQ(animation.duration, 1.f);
+    ASSERT_EQ(animation.tracks.size(), 2);
+    ASSERT_EQ(animation.tracks[1].translations.size(), 2);
+    EXPECT_NEAR(animation.tracks[1].translations[1].y, 2.f, 0.001f);
+    EXPECT_TRUE(animation.tracks[0].rotations.empty());
+    EXPECT_EQ(animation.soaTracks.numKeys, 2);
+
+    ASSERT_EQ(scene.lights.size(), 1);
+    EXPECT_EQ(scene.lights[0].name, "Lamp");
+    EXPECT_EQ(scene.lights[0].type, LightType::Point);
+    EXPECT_EQ(scene.lights[0].range, 5.f);
+
+    ASSERT_EQ(scene.nodes.size(), 1);
+    const auto& root = *scene.nodes[0];
+    EXPECT_EQ(root.name, "Root");
+    EXPECT_EQ(root.skinId, 0);
+    ASSERT_EQ(root.children.size(), 1);
+    EXPECT_EQ(root.children[0]->parent, &root);
+    EXPECT_EQ(root.children[0]->meshIndex, 0);
+    EXPECT_EQ(root.children[0]->transform.getPosition(), glm::vec3(3.f, 4.f, 5.f));
+}
+
+TEST(CookedScene, RejectsBadFiles)
+{
+    const auto dir = getTempDir();
+    const auto path = dir / "bad.edbrscene";
+    EXPECT_FALSE(util::readCookedScene(dir / "missing.edbrscene").has_value());
+
+    util::writeCookedScene(path, makeSceneData(dir));
+    const auto size = std::filesystem::file_size(path);
+
+    // truncated
+    std::filesystem::resize_file(path, size - 8);
+    EXPECT_FALSE(util::readCookedScene(path).has_value());
+
+    // other version
+    util::writeCookedScene(path, makeSceneData(dir));
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(sizeof(std::uint32_t));
+        const std::uint32_t version = util::COOKED_SCENE_VERSION + 1;
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    EXPECT_FALSE(util::readCookedScene(path).has_value());
+}
+
+TEST(CookedScene, UpToDate)
+{
+    const auto dir = getTempDir();
+    const auto gltfPath = dir / "model.gltf";
+    std::ofstream(gltfPath) << "{}";
+    const auto cookedPath = util::getCookedScenePath(gltfPath);
+    EXPECT_EQ(cookedPath, dir / "model.edbrscene");
+    std::filesystem::remove(cookedPath);
+    EXPECT_FALSE(util::isCookedSceneUpToDate(gltfPath));
+
+    util::writeCookedScene(cookedPath, makeSceneData(dir));
+    std::filesystem::last_write_time(
+        gltfPath, std::filesystem::last_write_time(cookedPath) - std::chrono::seconds(10));
+    EXPECT_TRUE(util::isCookedSceneUpToDate(gltfPath));
+
+    std::filesystem::last_write_time(
+        gltfPath, std::filesystem::last_write_time(cookedPath) + std::chrono::seconds(10));
+    EXPECT_FALSE(util::isCookedSceneUpToDate(gltfPath));
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Graphics/CullingStage.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+namespace
+{
+// axis aligned box frustum: [-halfSize, halfSize] on each axis
+Frustum makeBoxFrustum(float halfSize)
+{
+    Frustum f;
+    f.leftFace = {glm::vec3{-halfSize, 0.f, 0.f}, glm::vec3{1.f, 0.f, 0.f}};
+    f.rightFace = {glm::vec3{halfSize, 0.f, 0.f}, glm::vec3{-1.f, 0.f, 0.f}};
+    f.bottomFace = {glm::vec3{0.f, -halfSize, 0.f}, glm::vec3{0.f, 1.f, 0.f}};
+    f.topFace = {glm::vec3{0.f, halfSize, 0.f}, glm::vec3{0.f, -1.f, 0.f}};
+    f.nearFace = {glm::vec3{0.f, 0.f, -halfSize}, glm::vec3{0.f, 0.f, 1.f}};
+    f.farFace = {glm::vec3{0.f, 0.f, halfSize}, glm::vec3{0.f, 0.f, -1.f}};
+    return f;
+}
+
+MeshDrawCommand makeDrawCommand(const glm::vec3& center, float radius, bool castShadow = true)
+{
+    return MeshDrawCommand{
+        .worldBoundingSphere = {.center = center, .radius = radius},
+        .castShadow = castShadow,
+    };
+}
+
+std::vector<std::size_t> identityOrder(std::size_t size)
+{
+    std::vector<std::size_t> order(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        order[i] = i;
+    }
+    return order;
+}
+}
+
+TEST(CullingStage, BasicVisibility)
+{
+    const auto dcs = std::vector{
+        makeDrawCommand({0.f, 0.f, 0.f}, 1.f), // inside
+        makeDrawCommand({20.f, 0.f, 0.f}, 1.f), // outside
+        makeDrawCommand({10.5f, 0.f, 0.f}, 1.f), // intersects the right plane
+        makeDrawCommand({0.f, -30.f, 0.f}, 5.f), // outside
+        makeDrawCommand({0.f, 0.f, 5.f}, 1.f, false), // inside, doesn't cast shadow
+    };
+    const auto order = identityOrder(dcs.size());
+
+    CullingStage stage;
+    stage.setDrawCommands(dcs, order);
+    const auto mainView = stage.addView({.volume = makeBoxFrustum(10.f)});
+    const auto shadowView = stage.addView({
+        .volume = makeBoxFrustum(10.f),
+        .shadowCastersOnly = true,
+    });
+    stage.cull(nullptr);
+
+    const auto visible = stage.getVisibleDrawCommands(mainView);
+    EXPECT_EQ(
+        std::vector<std::uint32_t>(visible.begin(), visible.end()),
+        (std::vector<std::uint32_t>{0, 2, 4}));
+
+    const auto visibleShadow = stage.getVisibleDrawCommands(shadowView);
+    EXPECT_EQ(
+        std::vector<std::uint32_t>(visibleShadow.begin(), visibleShadow.end()),
+        (std::vector<std::uint32_t>{0, 2}));
+}
+
+TEST(CullingStage, VolumeWithSphere)
+{
+    const auto dcs = std::vector{
+        makeDrawCommand({0.f, 0.f, 0.f}, 1.f), // inside
+        makeDrawCommand({9.f, 9.f, 0.f}, 1.f), // inside the box, outside the sphere
+        makeDrawCommand({7.f, 0.f, 0.f}, 1.5f), // intersects the sphere
+        makeDrawCommand({0.f, 0.f, -6.f}, 1.f), // inside the sphere, outside the extra plane
+    };
+    const auto order = identityOrder(dcs.size());
+
+    auto volume = CullingVolume{makeBoxFrustum(10.f)};
+    volume.addPlane({glm::vec3{0.f, 0.f, -4.f}, glm::vec3{0.f, 0.f, 1.f}});
+    volume.sphere = math::Sphere{.center = {}, .radius = 6.f};
+
+    CullingStage stage;
+    stage.setDrawCommands(dcs, order);
+    stage.addView({.volume = volume});
+    stage.cull(nullptr);
+
+    const auto visible = stage.getVisibleDrawCommands(0);
+    EXPECT_EQ(
+        std::vector<std::uint32_t>(visible.begin(), visible.end()),
+        (std::vector<std::uint32_t>{0, 2}));
+}
+
+TEST(CullingStage, EmptyVolume)
+{
+    // no planes - everything is visible, but padding lanes are still skipped
+    const auto dcs = std::vector{
+        makeDrawCommand({100.f, 0.f, 0.f}, 1.f),
+        makeDrawCommand({0.f, -100.f, 0.f}, 1.f, false),
+    };
+    const auto order = identityOrder(dcs.size());
+
+    CullingStage stage;
+    stage.setDrawCommands(dcs, order);
+    stage.addView({});
+    stage.addView({.shadowCastersOnly = true});
+    stage.cull(nullptr);
+
+    EXPECT_EQ(stage.getVisibleDrawCommands(0).size(), 2);
+    const auto visibleShadow = stage.getVisibleDrawCommands(1);
+    ASSERT_EQ(visibleShadow.size(), 1);
+    EXPECT_EQ(visibleShadow[0], 0);
+}
+
+TEST(CullingStage, MatchesScalarCullingAndKeepsOrder)
+{
+    std::mt19937 rng{1};
+    std::uniform_real_distribution<float> posDist{-50.f, 50.f};
+    std::uniform_real_distribution<float> radiusDist{0.1f, 3.f};
+
+    // not a multiple of 4 or chunk size on purpose
+    std::vector<MeshDrawCommand> dcs;
+    for (int i = 0; i < 5003; ++i) {
+        dcs.push_back(makeDrawCommand(
+            {posDist(rng), posDist(rng), posDist(rng)}, radiusDist(rng), i % 3 != 0));
+    }
+
+    // reversed order - visible lists should follow it
+    auto order = identityOrder(dcs.size());
+    std::reverse(order.begin(), order.end());
+
+    auto sphereVolume = CullingVolume{makeBoxFrustum(20.f)};
+    sphereVolume.addPlane({glm::vec3{0.f, 5.f, 0.f}, glm::normalize(glm::vec3{1.f, -1.f, 0.f})});
+    sphereVolume.sphere = math::Sphere{.center = {5.f, 0.f, -3.f}, .radius = 18.f};
+
+    const auto views = std::array<CullingStage::View, 2>{{
+        {.volume = makeBoxFrustum(10.f)},
+        {.volume = sphereVolume, .shadowCastersOnly = true},
+    }};
+
+    JobSystem jobSystem(3);
+    CullingStage stage;
+    stage.setDrawCommands(dcs, order);
+    for (const auto& view : views) {
+        stage.addView(view);
+    }
+    stage.cull(&jobSystem);
+
+    for (std::size_t v = 0; v < views.size(); ++v) {
+        const auto& view = views[v];
+        std::vector<std::uint32_t> expected;
+        for (const auto i : order) {
+            const auto& dc = dcs[i];
+            if (view.shadowCastersOnly && !dc.castShadow) {
+                continue;
+            }
+            if (edge::isInVolume(view.volume, dc.worldBoundingSphere)) {
+                expected.push_back((std::uint32_t)i);
+            }
+        }
+
+        const auto visible = stage.getVisibleDrawCommands(v);
+        EXPECT_EQ(std::vector<std::uint32_t>(visible.begin(), visible.end()), expected);
+    }
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <edbr/Graphics/UploadRegions.h>
+#include <edbr/Graphics/UploadRingAllocator.h>
+
+namespace
+{
+// only compared, never dereferenced
+VkBuffer fakeBuffer(std::uintptr_t id)
+{
+    return reinterpret_cast<VkBuffer>(id);
+}
+}
+
+TEST(UploadRingAllocator, AllocatesAligned)
+{
+    UploadRingAllocator ring(256);
+    EXPECT_EQ(ring.allocate(10, 16), 0);
+    EXPECT_EQ(ring.allocate(10, 16), 16);
+    EXPECT_EQ(ring.allocate(4, 4), 28);
+    EXPECT_EQ(ring.getUsedSize(), 32);
+
+    EXPECT_FALSE(ring.allocate(0, 16).has_value());
+    EXPECT_FALSE(ring.allocate(257, 16).has_value());
+}
+
+TEST(UploadRingAllocator, ReleasesCompletedBatches)
+{
+    UploadRingAllocator ring(256);
+    EXPECT_EQ(ring.allocate(100, 4), 0);
+    ring.endBatch(1);
+    EXPECT_EQ(ring.allocate(100, 4), 100);
+    ring.endBatch(2);
+    EXPECT_FALSE(ring.allocate(100, 4).has_value());
+    EXPECT_EQ(ring.getOldestBatchValue(), 1);
+
+    ring.release(0);
+    EXPECT_EQ(ring.getUsedSize(), 200);
+
+    ring.release(1);
+    EXPECT_EQ(ring.getUsedSize(), 100);
+    EXPECT_EQ(ring.getOldestBatchValue(), 2);
+
+    ring.release(2);
+    EXPECT_EQ(ring.getUsedSize(), 0);
+    EXPECT_FALSE(ring.hasBatchesInFlight());
+    // starts from the beginning when the ring is empty
+    EXPECT_EQ(ring.allocate(256, 4), 0);
+}
+
+TEST(UploadRingAllocator, WrapsAround)
+{
+    UploadRingAllocator ring(256);
+    EXPECT_EQ(ring.allocate(100, 4), 0);
+    ring.endBatch(1);
+    EXPECT_EQ(ring.allocate(100, 4), 100);
+    ring.endBatch(2);
+    ring.release(1);
+
+    // doesn't fit into [200, 256), so the end of the buffer is skipped
+    EXPECT_EQ(ring.allocate(80, 4), 0);
+    EXPECT_EQ(ring.getUsedSize(), 100 + 56 + 80);
+    // [80, 100) is free, but not enough
+    EXPECT_FALSE(ring.allocate(24, 4).has_value());
+    EXPECT_EQ(ring.allocate(20, 4), 80);
+    ring.endBatch(3);
+    EXPECT_EQ(ring.getUsedSize(), 256);
+    EXPECT_FALSE(ring.allocate(1, 1).has_value());
+
+    // the skipped end belongs to the batch which skipped it
+    ring.release(2);
+    EXPECT_EQ(ring.getUsedSize(), 156);
+    EXPECT_EQ(ring.allocate(100, 4), 100);
+    ring.endBatch(4);
+    EXPECT_FALSE(ring.allocate(1, 1).has_value());
+
+    ring.release(3);
+    EXPECT_EQ(ring.getUsedSize(), 100);
+    ring.release(4);
+    EXPECT_EQ(ring.getUsedSize(), 0);
+}
+
+TEST(UploadRingAllocator, EmptyBatchesAreIgnored)
+{
+    UploadRingAllocator ring(64);
+    ring.endBatch(1);
+    EXPECT_FALSE(ring.hasBatchesInFlight());
+
+    EXPECT_EQ(ring.allocate(64, 4), 0);
+    ring.endBatch(2);
+    ring.endBatch(3);
+    ring.release(2);
+    EXPECT_FALSE(ring.hasBatchesInFlight());
+    EXPECT_EQ(ring.getUsedSize(), 0);
+}
+
+TEST(UploadRegions, MergesContiguousCopies)
+{
+    const auto vb = fakeBuffer(1);
+    const auto ib = fakeBuffer(2);
+    const std::vector<graphics::BufferUploadRegion> uploads{
+        {.dstBuffer = vb, .region = {.srcOffset = 0, .dstOffset = 0, .size = 64}},
+        {.dstBuffer = vb, .region = {.srcOffset = 64, .dstOffset = 64, .size = 32}},
+        {.dstBuffer = ib, .region = {.srcOffset = 96, .dstOffset = 0, .size = 16}},
+        // contiguous in the destination, but not in the staging buffer
+        {.dstBuffer = vb, .region = {.srcOffset = 112, .dstOffset = 96, .size = 32}},
+        {.dstBuffer = ib, .region = {.srcOffset = 144, .dstOffset = 16, .size = 16}},
+        {.dstBuffer = ib, .region = {.srcOffset = 160, .dstOffset = 32, .size = 16}},
+        {.dstBuffer = ib, .region = {.srcOffset = 176, .dstOffset = 48, .size = 0}},
+    };
+
+    const auto batches = graphics::coalesceBufferUploads(uploads);
+    ASSERT_EQ(batches.size(), 2);
+
+    EXPECT_EQ(batches[0].dstBuffer, vb);
+    ASSERT_EQ(batches[0].regions.size(), 2);
+    EXPECT_EQ(batches[0].regions[0].srcOffset, 0);
+    EXPECT_EQ(batches[0].regions[0].size, 96);
+    EXPECT_EQ(batches[0].regions[1].srcOffset, 112);
+    EXPECT_EQ(batches[0].regions[1].dstOffset, 96);
+
+    EXPECT_EQ(batches[1].dstBuffer, ib);
+    ASSERT_EQ(batches[1].regions.size(), 2);
+    EXPECT_EQ(batches[1].regions[0].size, 16);
+    EXPECT_EQ(batches[1].regions[1].srcOffset, 144);
+    EXPECT_EQ(batches[1].regions[1].dstOffset, 16);
+    EXPECT_EQ(batches[1].regions[1].size, 32);
+}
+
+TEST(UploadRegions, OverlappingCopiesKeepOrder)
+{
+    const auto buffer = fakeBuffer(1);
+    const auto other = fakeBuffer(2);
+    const std::vector<graphics::BufferUploadRegion> uploads{
+        {.dstBuffer = buffer, .region = {.srcOffset = 0, .dstOffset = 0, .size = 64}},
+        {.dstBuffer = other, .region = {.srcOffset = 64, .dstOffset = 0, .size = 64}},
+        // overwrites a part of the first copy - must be done after it
+        {.dstBuffer = buffer, .region = {.srcOffset = 128, .dstOffset = 32, .size = 64}},
+        {.dstBuffer = buffer, .region = {.srcOffset = 192, .dstOffset = 96, .size = 16}},
+    };
+
+    const auto batches = graphics::coalesceBufferUploads(uploads);
+    ASSERT_EQ(batches.size(), 3);
+    EXPECT_EQ(batches[0].dstBuffer, buffer);
+    EXPECT_EQ(batches[0].regions.size(), 1);
+    EXPECT_EQ(batches[1].dstBuffer, other);
+    EXPECT_EQ(batches[2].dstBuffer, buffer);
+    ASSERT_EQ(batches[2].regions.size(), 1);
+    EXPECT_EQ(batches[2].regions[0].srcOffset, 128);
+    EXPECT_EQ(batches[2].regions[0].size, 80);
+}
+
+TEST(UploadRegions, ImageLargerThanRemainingRingSpace)
+{
+    // 16x16 RGBA8 image with all mips: 1024 + 256 + 64 + 16 + 4 bytes
+    std::vector<std::vector<std::byte>> mipData;
+    std::vector<graphics::ImageSubresourceUpload> mips;
+    for (std::uint32_t mip = 0; mip < 5; ++mip) {
+        const auto size = std::max(16u >> mip, 1u);
+        mipData.emplace_back(size * size * 4);
+    }
+    for (std::uint32_t mip = 0; mip < 5; ++mip) {
+        mips.push_back({.data = mipData[mip], .mipLevel = mip});
+    }
+
+    const auto upload = graphics::makeImageUploadRegions(VkExtent3D{16, 16, 1}, mips, 16);
+    ASSERT_EQ(upload.regions.size(), 5);
+    EXPECT_EQ(upload.regions[0].bufferOffset, 0);
+    EXPECT_EQ(upload.regions[1].bufferOffset, 1024);
+    EXPECT_EQ(upload.regions[2].bufferOffset, 1280);
+    EXPECT_EQ(upload.regions[3].bufferOffset, 1344);
+    EXPECT_EQ(upload.regions[4].bufferOffset, 1360);
+    EXPECT_EQ(upload.stagingSize, 1364);
+    EXPECT_EQ(upload.regions[2].imageSubresource.mipLevel, 2);
+    EXPECT_EQ(upload.regions[2].imageExtent.width, 4);
+    EXPECT_EQ(upload.regions[4].imageExtent.width, 1);
+    EXPECT_EQ(upload.regions[4].imageExtent.height, 1);
+
+    // Mip 0 alone would still fit after the in-flight batch, but the image
+    // doesn't. Staging is allocated for the whole image, so the queue flushes
+    // and waits before recording any of its copies instead of in the middle
+    // of the image, and all mips are copied by the same submission.
+    UploadRingAllocator ring(2048);
+    EXPECT_EQ(ring.allocate(1024, 16), 0);
+    ring.endBatch(1);
+    EXPECT_FALSE(ring.allocate(upload.stagingSize, 16).has_value());
+    EXPECT_EQ(ring.getUsedSize(), 1024);
+
+    ring.release(1);
+    EXPECT_EQ(ring.allocate(upload.stagingSize, 16), 0);
+    // the last mip ends at the end of the allocation
+    EXPECT_EQ(upload.regions[4].bufferOffset + mipData[4].size(), upload.stagingSize);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <edbr/Graphics/HiZPyramid.h>
+#include <edbr/Math/Sphere.h>
+
+namespace
+{
+// reverse-Z projection, same as Camera with inverse depth and clip space Y down
+glm::mat4 makeProjection(float zNear, float zFar, float aspectRatio)
+{
+    auto proj = glm::perspective(glm::radians(60.f), aspectRatio, zFar, zNear);
+    proj[1][1] *= -1;
+    return proj;
+}
+
+float calculateDepth(const glm::mat4& proj, float viewZ)
+{
+    const auto clip = proj * glm::vec4{0.f, 0.f, viewZ, 1.f};
+    return clip.z / clip.w;
+}
+}
+
+TEST(HiZPyramid, Levels)
+{
+    const auto levels = HiZPyramid::calculateLevels({5, 3});
+    ASSERT_EQ(levels.size(), 3);
+    EXPECT_EQ(levels[0].size, glm::ivec2(3, 2));
+    EXPECT_EQ(levels[0].offset, 0);
+    EXPECT_EQ(levels[1].size, glm::ivec2(2, 1));
+    EXPECT_EQ(levels[1].offset, 6);
+    EXPECT_EQ(levels[2].size, glm::ivec2(1, 1));
+    EXPECT_EQ(levels[2].offset, 8);
+    EXPECT_EQ(HiZPyramid::calculateDataSize(levels), 9);
+
+    EXPECT_EQ(HiZPyramid::calculateLevels({1, 1}).size(), 1);
+}
+
+TEST(HiZPyramid, StoresFarthestDepthOfCoveredPixels)
+{
+    const auto size = glm::ivec2{37, 21}; // odd sizes on purpose
+    std::vector<float> depth(size.x * size.y);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    for (auto& d : depth) {
+        d = dist(rng);
+    }
+
+    HiZPyramid pyramid;
+    pyramid.build(depth, size);
+
+    const auto& levels = pyramid.getLevels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+        const auto shift = (int)l + 1;
+        for (int y = 0; y < levels[l].size.y; ++y) {
+            for (int x = 0; x < levels[l].size.x; ++x) {
+                auto expected = 1.f;
+                for (int py = y << shift; py < std::min((y + 1) << shift, size.y); ++py) {
+                    for (int px = x << shift; px < std::min((x + 1) << shift, size.x); ++px) {
+                        expected = std::min(expected, depth[py * size.x + px]);
+                    }
+                }
+                ASSERT_EQ(pyramid.getDepth(l, x, y), expected) << "level " << l;
+            }
+        }
+    }
+}
+
+TEST(HiZPyramid, SphereOcclusion)
+{
+    const auto size = glm::ivec2{64, 48};
+    const auto zNear = 0.1f;
+    const auto proj = makeProjection(zNear, 100.f, (float)size.x / (float)size.y);
+    const auto view = glm::mat4{1.f}; // camera at origin looking at -Z
+
+    // a wall at z = -10 which covers the whole screen
+    std::vector<float> depth(size.x * size.y, calculateDepth(proj, -10.f));
+
+    HiZPyramid pyramid;
+    pyramid.build(depth, size);
+
+    const auto isOccluded = [&](const glm::vec3& center, float radius) {
+        return pyramid.isSphereOccluded({.center = center, .radius = radius}, view, proj, zNear);
+    };
+
+    // behind the wall
+    EXPECT_TRUE(isOccluded({0.f, 0.f, -20.f}, 1.f));
+    EXPECT_TRUE(isOccluded({3.f, -2.f, -30.f}, 5.f));
+    // in front of the wall
+    EXPECT_FALSE(isOccluded({0.f, 0.f, -5.f}, 1.f));
+    // intersects the wall
+    EXPECT_FALSE(isOccluded({0.f, 0.f, -10.5f}, 1.f));
+    // intersects the near plane
+    EXPECT_FALSE(isOccluded({0.f, 0.f, 0.f}, 1.f));
+
+    // make a hole in the middle of the wall - the sphere behind it is now visible
+    for (int y = size.y / 2 - 1; y <= size.y / 2; ++y) {
+        for (int x = size.x / 2 - 1; x <= size.x / 2; ++x) {
+            depth[y * size.x + x] = 0.f;
+        }
+    }
+    pyramid.build(depth, size);
+    EXPECT_FALSE(isOccluded({0.f, 0.f, -20.f}, 1.f));
+    // but the one to the side is still occluded
+    EXPECT_TRUE(isOccluded({8.f, 0.f, -20.f}, 1.f));
+}
@@ -0,0 +1,333 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <edbr/Core/TaskQueue.h>
+#include <edbr/Graphics/Common.h>
+#include <edbr/Graphics/ImageCache.h>
+
+namespace
+{
+struct MockDevice {
+    std::atomic<int> numDecodes{0}; // called on decode threads
+    int numLoads{0};
+    std::vector<VkImage> destroyedImages;
+    std::vector<std::pair<ImageId, VkImage>> bindlessWrites;
+    std::uintptr_t nextHandle{1};
+
+    GPUImage createImage()
+    {
+        GPUImage image{};
+        image.image = reinterpret_cast<VkImage>(nextHandle++);
+        return image;
+    }
+
+    ImageCache::Device get()
+    {
+        return ImageCache::Device{
+            .decodeImage = [this](const ImageCache::LoadParams& params)
+                -> std::optional<DecodedImage> {
+                if (params.path == "missing.png") {
+                    return std::nullopt;
+                }
+                ++numDecodes;
+                return DecodedImage{};
+            },
+            .createImage = [this](const ImageCache::LoadParams&, DecodedImage)
+                -> std::optional<GPUImage> {
+                ++numLoads;
+                return createImage();
+            },
+            .destroyImage =
+                [this](const GPUImage& image) { destroyedImages.push_back(image.image); },
+            .setBindlessImage =
+                [this](ImageId id, const GPUImage& image) {
+                    bindlessWrites.emplace_back(id, image.image);
+                },
+            .getMemorySize = [](const GPUImage&) { return std::size_t{100}; },
+        };
+    }
+
+    bool wasDestroyed(VkImage image) const
+    {
+        return std::find(destroyedImages.begin(), destroyedImages.end(), image) !=
+               destroyedImages.end();
+    }
+};
+
+ImageId load(ImageCache& cache, const char* path, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB)
+{
+    return cache.loadImageFromFile(path, format, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+}
+
+ImageCache::LoadParams makeParams(const std::string& path)
+{
+    return ImageCache::LoadParams{
+        .path = path,
+        .format = VK_FORMAT_R8G8B8A8_SRGB,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+        .mipMap = true,
+    };
+}
+}
+
+TEST(ImageCache, LoadsEachImageOnce)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+
+    const auto a = load(cache, "a.png");
+    const auto b = load(cache, "b.png");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(load(cache, "a.png"), a);
+    EXPECT_EQ(device.numLoads, 2);
+    EXPECT_EQ(cache.getRefCount(a), 2);
+    EXPECT_EQ(cache.getRefCount(b), 1);
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 200);
+
+    // same path with different parameters is a different image
+    const auto aUnorm = load(cache, "a.png", VK_FORMAT_R8G8B8A8_UNORM);
+    EXPECT_NE(aUnorm, a);
+    EXPECT_EQ(device.numLoads, 3);
+
+    ASSERT_EQ(device.bindlessWrites.size(), 3);
+    EXPECT_EQ(device.bindlessWrites[0].first, a);
+    EXPECT_EQ(cache.getImage(a).getBindlessId(), a);
+}
+
+TEST(ImageCache, FailedLoadReturnsErrorImage)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+    const auto errorImageId = cache.addImage(device.createImage());
+    cache.setErrorImageId(errorImageId);
+
+    EXPECT_EQ(load(cache, "missing.png"), errorImageId);
+    EXPECT_EQ(cache.getRefCount(errorImageId), 2);
+    cache.releaseImage(errorImageId);
+    EXPECT_EQ(cache.getRefCount(errorImageId), 1);
+}
+
+TEST(ImageCache, DestroysReleasedImagesAfterFramesInFlight)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+
+    cache.beginFrame(10);
+    const auto a = load(cache, "a.png");
+    const auto b = load(cache, "b.png");
+    const auto aImage = cache.getImage(a).image;
+
+    cache.releaseImage(a);
+    EXPECT_EQ(cache.getNumPendingDestroys(), 1);
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 100);
+    // the slot can't be reused while frames in flight can use it
+    EXPECT_EQ(cache.getFreeImageId(), 2);
+
+    for (std::uint64_t frame = 11; frame < 10 + graphics::FRAME_OVERLAP; ++frame) {
+        cache.beginFrame(frame);
+        EXPECT_FALSE(device.wasDestroyed(aImage));
+    }
+    cache.beginFrame(10 + graphics::FRAME_OVERLAP);
+    EXPECT_TRUE(device.wasDestroyed(aImage));
+    EXPECT_EQ(cache.getNumPendingDestroys(), 0);
+    EXPECT_FALSE(cache.getImage(a).isInitialized());
+
+    // freed slot is reused
+    EXPECT_EQ(cache.getFreeImageId(), a);
+    const auto c = cache.addImage(device.createImage());
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(cache.getRefCount(c), 1);
+    EXPECT_EQ(device.bindlessWrites.back().first, a);
+    EXPECT_EQ(cache.getFreeImageId(), 2);
+
+    // loading the released image again creates it again
+    const auto a2 = load(cache, "a.png");
+    EXPECT_EQ(a2, 2);
+    EXPECT_EQ(device.numLoads, 3);
+    EXPECT_EQ(cache.getRefCount(b), 1);
+}
+
+TEST(ImageCache, BudgetEvictsLeastRecentlyReleased)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+    cache.setMemoryBudget(250);
+
+    const auto a = load(cache, "a.png");
+    const auto b = load(cache, "b.png");
+    const auto c = load(cache, "c.png");
+    // referenced images are never evicted, even if over budget
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 300);
+
+    cache.releaseImage(a);
+    EXPECT_EQ(cache.getNumPendingDestroys(), 1); // evicted right away
+    cache.releaseImage(b);
+    EXPECT_EQ(cache.getNumPendingDestroys(), 1); // kept, fits into budget
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 200);
+
+    // reloading the kept image doesn't load it again
+    EXPECT_EQ(load(cache, "b.png"), b);
+    EXPECT_EQ(cache.getRefCount(b), 1);
+    EXPECT_EQ(device.numLoads, 3);
+
+    cache.releaseImage(c);
+    cache.releaseImage(b);
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 200);
+
+    // c was released before b, so it's evicted first
+    load(cache, "d.png");
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 200);
+    EXPECT_EQ(load(cache, "b.png"), b);
+    EXPECT_EQ(device.numLoads, 4);
+    cache.releaseImage(b);
+
+    // without a budget nothing is kept
+    cache.setMemoryBudget(std::nullopt);
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 100);
+    EXPECT_EQ(cache.getNumPendingDestroys(), 3);
+}
+
+TEST(ImageCache, DestroyImagesDestroysEverything)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+    load(cache, "a.png");
+    const auto b = load(cache, "b.png");
+    cache.releaseImage(b);
+
+    cache.destroyImages();
+    EXPECT_EQ(device.destroyedImages.size(), 2);
+    EXPECT_EQ(cache.getFreeImageId(), 0);
+}
+
+TEST(ImageCache, BatchLoadShowsErrorImageUntilCreated)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+    const auto errorImageId = cache.addImage(device.createImage());
+    cache.setErrorImageId(errorImageId);
+    const auto errorImage = cache.getImage(errorImageId).image;
+    const auto a = load(cache, "a.png");
+
+    const std::vector<ImageCache::LoadParams> params{
+        makeParams("a.png"),
+        makeParams("b.png"),
+        makeParams("c.png"),
+        makeParams("b.png"),
+    };
+    const auto ids = cache.loadImagesFromFiles(params);
+    ASSERT_EQ(ids.size(), 4);
+    EXPECT_EQ(ids[0], a); // already loaded
+    EXPECT_EQ(ids[1], ids[3]);
+    EXPECT_EQ(cache.getRefCount(a), 2);
+    EXPECT_EQ(cache.getRefCount(ids[1]), 2);
+
+    // decoded, but not created until update
+    const auto b = ids[1];
+    EXPECT_TRUE(cache.isImageLoading(b));
+    EXPECT_EQ(cache.getNumLoadingImages(), 2);
+    EXPECT_EQ(cache.getImage(b).image, errorImage);
+    EXPECT_EQ(device.bindlessWrites.back(), std::make_pair(ids[2], errorImage));
+    EXPECT_EQ(device.numLoads, 1);
+
+    cache.update();
+    EXPECT_EQ(device.numLoads, 3);
+    EXPECT_FALSE(cache.isImageLoading(b));
+    EXPECT_EQ(cache.getNumLoadingImages(), 0);
+    EXPECT_NE(cache.getImage(b).image, errorImage);
+    EXPECT_EQ(cache.getImage(b).getBindlessId(), b);
+    EXPECT_EQ(device.bindlessWrites.back(), std::make_pair(ids[2], cache.getImage(ids[2]).image));
+    EXPECT_EQ(cache.getLoadedImagesMemory(), 300);
+}
+
+TEST(ImageCache, BatchLoadOnDecodeThreads)
+{
+    MockDevice device;
+    TaskQueue decodeQueue(4);
+    ImageCache cache(device.get());
+    cache.setDecodeQueue(decodeQueue);
+
+    std::vector<ImageCache::LoadParams> params;
+    for (int i = 0; i < 200; ++i) {
+        params.push_back(makeParams(std::to_string(i) + ".png"));
+    }
+    const auto ids = cache.loadImagesFromFiles(params);
+
+    // synchronous load of an image from the batch waits for it
+    const auto id = load(cache, "7.png");
+    EXPECT_EQ(id, ids[7]);
+    EXPECT_FALSE(cache.isImageLoading(id));
+
+    cache.waitForLoads();
+    EXPECT_EQ(device.numDecodes, 200);
+    EXPECT_EQ(device.numLoads, 200);
+    EXPECT_EQ(cache.getNumLoadingImages(), 0);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(ids[i], i);
+        EXPECT_TRUE(cache.getImage(ids[i]).isInitialized());
+    }
+}
+
+TEST(ImageCache, WaitForLoadsDoesntWaitForOtherTasks)
+{
+    MockDevice device;
+    TaskQueue taskQueue(2);
+    ImageCache cache(device.get());
+    cache.setDecodeQueue(taskQueue);
+
+    // the queue is shared with a task which only finishes after the images are loaded
+    std::atomic<bool> loaded{false};
+    taskQueue.push([&loaded]() {
+        while (!loaded) {
+            std::this_thread::yield();
+        }
+    });
+
+    const auto params = std::vector{makeParams("a.png"), makeParams("b.png")};
+    const auto ids = cache.loadImagesFromFiles(params);
+    cache.waitForLoads();
+    EXPECT_EQ(cache.getNumLoadingImages(), 0);
+    EXPECT_TRUE(cache.getImage(ids[1]).isInitialized());
+    loaded = true;
+}
+
+TEST(ImageCache, ReleaseWhileLoading)
+{
+    MockDevice device;
+    ImageCache cache(device.get());
+    const auto errorImageId = cache.addImage(device.createImage());
+    cache.setErrorImageId(errorImageId);
+
+    cache.beginFrame(0);
+    const std::vector<ImageCache::LoadParams> params{makeParams("a.png")};
+    const auto a = cache.loadImagesFromFiles(params)[0];
+    cache.releaseImage(a);
+    EXPECT_EQ(cache.getNumLoadingImages(), 0);
+
+    // the slot is reused before the decoded image is created
+    cache.beginFrame(graphics::FRAME_OVERLAP);
+    EXPECT_TRUE(device.destroyedImages.empty()); // nothing was created
+    const std::vector<ImageCache::LoadParams> params2{makeParams("b.png")};
+    const auto b = cache.loadImagesFromFiles(params2)[0];
+    EXPECT_EQ(b, a);
+
+    // the result of the first load is dropped
+    cache.update();
+    EXPECT_EQ(device.numLoads, 1);
+    EXPECT_FALSE(cache.isImageLoading(b));
+    EXPECT_EQ(load(cache, "b.png"), b);
+
+    // failed loads keep showing the error image
+    const std::vector<ImageCache::LoadParams> missing{makeParams("missing.png")};
+    const auto m = cache.loadImagesFromFiles(missing)[0];
+    cache.update();
+    EXPECT_FALSE(cache.isImageLoading(m));
+    EXPECT_EQ(cache.getImage(m).image, cache.getImage(errorImageId).image);
+    cache.releaseImage(m);
+    cache.beginFrame(2 * graphics::FRAME_OVERLAP);
+    EXPECT_FALSE(cache.getImage(m).isInitialized());
+}
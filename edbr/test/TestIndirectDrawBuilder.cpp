@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+
+#include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/IndirectDrawBuilder.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+
+namespace
+{
+GPUMesh makeMesh(std::uint32_t vertexOffset, std::uint32_t firstIndex, std::uint32_t numIndices)
+{
+    auto mesh = GPUMesh{
+        .vertexOffset = vertexOffset,
+        .firstIndex = firstIndex,
+        .vertexBufferAddress = 0x1000 + vertexOffset * 48,
+        .numIndices = numIndices,
+    };
+    mesh.lods[0] = {.firstIndex = firstIndex, .numIndices = numIndices};
+    return mesh;
+}
+}
+
+TEST(IndirectDrawBuilder, OneCommandPerVisibleDraw)
+{
+    const auto meshes = std::vector{
+        makeMesh(0, 0, 36),
+        makeMesh(24, 36, 60),
+    };
+
+    std::vector<MeshDrawCommand> drawCommands(3);
+    drawCommands[0] = {.meshId = 1, .materialId = 5};
+    drawCommands[1] = {.meshId = 0, .materialId = 6};
+    drawCommands[2] = {.meshId = 1, .materialId = 7};
+    drawCommands[2].transformMatrix[3][0] = 42.f;
+    drawCommands[2].worldBoundingSphere = math::Sphere{.center = {1.f, 2.f, 3.f}, .radius = 4.f};
+
+    const auto visible = std::vector<std::uint32_t>{2, 1};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<GPUMeshInstanceData> instanceData;
+    graphics::buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData);
+
+    ASSERT_EQ(commands.size(), 2);
+    ASSERT_EQ(instanceData.size(), 2);
+
+    EXPECT_EQ(commands[0].indexCount, 60);
+    EXPECT_EQ(commands[0].firstIndex, 36);
+    EXPECT_EQ(commands[0].instanceCount, 1);
+    EXPECT_EQ(commands[0].vertexOffset, 0);
+    EXPECT_EQ(commands[0].firstInstance, 0);
+    EXPECT_EQ(instanceData[0].materialId, 7);
+    EXPECT_EQ(instanceData[0].vertexBuffer, meshes[1].vertexBufferAddress);
+    EXPECT_EQ(instanceData[0].transform[3][0], 42.f);
+    EXPECT_EQ(instanceData[0].worldBoundingSphere, glm::vec4(1.f, 2.f, 3.f, 4.f));
+
+    EXPECT_EQ(commands[1].indexCount, 36);
+    EXPECT_EQ(commands[1].firstIndex, 0);
+    EXPECT_EQ(commands[1].firstInstance, 1);
+    EXPECT_EQ(instanceData[1].materialId, 6);
+    EXPECT_EQ(instanceData[1].vertexBuffer, meshes[0].vertexBufferAddress);
+    EXPECT_EQ(instanceData[1].vertexFormat, VertexFormat::Full);
+}
+
+TEST(IndirectDrawBuilder, CompactMeshes)
+{
+    auto meshes = std::vector{makeMesh(0, 0, 3)};
+    meshes[0].vertexFormat = VertexFormat::Compact;
+
+    const auto drawCommands = std::vector{MeshDrawCommand{.meshId = 0, .materialId = 1}};
+    const auto visible = std::vector<std::uint32_t>{0};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<GPUMeshInstanceData> instanceData;
+    graphics::buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData);
+
+    ASSERT_EQ(instanceData.size(), 1);
+    EXPECT_EQ(instanceData[0].vertexFormat, VertexFormat::Compact);
+}
+
+TEST(IndirectDrawBuilder, SkinnedMeshesUseSkinnedVertexBuffer)
+{
+    auto meshes = std::vector{makeMesh(0, 0, 3)};
+    meshes[0].vertexFormat = VertexFormat::Compact;
+
+    auto skinnedMesh = SkinnedMesh{};
+    skinnedMesh.skinnedVertexBuffer.address = 0xABC0;
+
+    const auto drawCommands = std::vector{
+        MeshDrawCommand{.meshId = 0, .materialId = 1, .skinnedMesh = &skinnedMesh},
+    };
+    const auto visible = std::vector<std::uint32_t>{0};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands{VkDrawIndexedIndirectCommand{}};
+    std::vector<GPUMeshInstanceData> instanceData;
+    graphics::buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData);
+
+    ASSERT_EQ(commands.size(), 1); // old contents are cleared
+    EXPECT_EQ(instanceData[0].vertexBuffer, 0xABC0);
+    // skinning.comp outputs full vertices even for compact meshes
+    EXPECT_EQ(instanceData[0].vertexFormat, VertexFormat::Full);
+}
+
+TEST(IndirectDrawBuilder, MergesRepeatedMeshesIntoInstances)
+{
+    const auto meshes = std::vector{makeMesh(0, 0, 36), makeMesh(24, 36, 60)};
+
+    auto skinnedMesh = SkinnedMesh{};
+    std::vector<MeshDrawCommand> drawCommands{
+        {.meshId = 0, .materialId = 1},
+        {.meshId = 0, .materialId = 1},
+        {.meshId = 0, .materialId = 1},
+        {.meshId = 0, .materialId = 2}, // different material
+        {.meshId = 1, .materialId = 2}, // different mesh
+        {.meshId = 1, .materialId = 2},
+        {.meshId = 1, .materialId = 2, .skinnedMesh = &skinnedMesh}, // skinned
+        {.meshId = 1, .materialId = 2, .skinnedMesh = &skinnedMesh},
+    };
+    for (std::size_t i = 0; i < drawCommands.size(); ++i) {
+        drawCommands[i].transformMatrix[3][0] = (float)i;
+    }
+    // draw command 2 is culled
+    const auto visible = std::vector<std::uint32_t>{0, 1, 3, 4, 5, 6, 7};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<GPUMeshInstanceData> instanceData;
+    const auto stats =
+        graphics::buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData);
+
+    EXPECT_EQ(stats.numDraws, 5);
+    EXPECT_EQ(stats.numInstances, 7);
+    ASSERT_EQ(commands.size(), 5);
+    ASSERT_EQ(instanceData.size(), 7);
+
+    const auto expected = std::vector<std::pair<std::uint32_t, std::uint32_t>>{
+        // first instance, instance count
+        {0, 2},
+        {2, 1},
+        {3, 2},
+        {5, 1},
+        {6, 1},
+    };
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(commands[i].firstInstance, expected[i].first);
+        EXPECT_EQ(commands[i].instanceCount, expected[i].second);
+    }
+
+    // instance data is stored in visible order
+    for (std::size_t i = 0; i < visible.size(); ++i) {
+        EXPECT_EQ(instanceData[i].transform[3][0], (float)visible[i]);
+    }
+
+    // each instance knows its draw so that GPU culling can compact it
+    const auto expectedDrawIndices = std::vector<std::uint32_t>{0, 0, 1, 2, 2, 3, 4};
+    for (std::size_t i = 0; i < expectedDrawIndices.size(); ++i) {
+        EXPECT_EQ(instanceData[i].drawIndex, expectedDrawIndices[i]);
+    }
+}
+
+TEST(IndirectDrawBuilder, MaxInstances)
+{
+    const auto meshes = std::vector{makeMesh(0, 0, 3)};
+    const auto drawCommands = std::vector<MeshDrawCommand>(10, {.meshId = 0, .materialId = 1});
+    const auto visible = std::vector<std::uint32_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<GPUMeshInstanceData> instanceData;
+    const auto stats = graphics::
+        buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData, 4);
+
+    EXPECT_EQ(stats.numInstances, 4);
+    ASSERT_EQ(commands.size(), 1);
+    EXPECT_EQ(commands[0].instanceCount, 4);
+}
+
+TEST(IndirectDrawBuilder, Index16DrawsGoFirst)
+{
+    auto meshes = std::vector{makeMesh(0, 0, 36), makeMesh(24, 72, 60), makeMesh(48, 36, 6)};
+    meshes[1].indexType = VK_INDEX_TYPE_UINT16;
+    meshes[2].indexType = VK_INDEX_TYPE_UINT16;
+
+    const auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 0, .materialId = 1},
+        {.meshId = 1, .materialId = 1},
+        {.meshId = 1, .materialId = 1},
+        {.meshId = 0, .materialId = 1},
+        {.meshId = 2, .materialId = 1},
+    };
+    const auto visible = std::vector<std::uint32_t>{0, 1, 2, 3, 4};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<GPUMeshInstanceData> instanceData;
+    const auto stats = graphics::
+        buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData);
+
+    EXPECT_EQ(stats.numIndex16Draws, 2);
+    ASSERT_EQ(commands.size(), 3);
+    // 16-bit: mesh 1 (two instances), mesh 2
+    EXPECT_EQ(commands[0].firstIndex, 72);
+    EXPECT_EQ(commands[0].instanceCount, 2);
+    EXPECT_EQ(commands[1].firstIndex, 36);
+    // 32-bit: mesh 0 - 16-bit draws between its draw commands don't break instancing
+    EXPECT_EQ(commands[2].firstIndex, 0);
+    EXPECT_EQ(commands[2].instanceCount, 2);
+
+    ASSERT_EQ(instanceData.size(), 5);
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        for (std::uint32_t j = 0; j < commands[i].instanceCount; ++j) {
+            EXPECT_EQ(instanceData[commands[i].firstInstance + j].drawIndex, i);
+        }
+    }
+}
+
+TEST(IndirectDrawBuilder, LODs)
+{
+    auto meshes = std::vector{makeMesh(0, 0, 36)};
+    meshes[0].lods[1] = {.firstIndex = 36, .numIndices = 12, .error = 0.1f};
+    meshes[0].numLODs = 2;
+
+    const auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 0, .materialId = 1, .lod = 1},
+        {.meshId = 0, .materialId = 1, .lod = 1},
+        {.meshId = 0, .materialId = 1, .lod = 0},
+    };
+    const auto visible = std::vector<std::uint32_t>{0, 1, 2};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<GPUMeshInstanceData> instanceData;
+    graphics::buildIndirectDrawCommands(drawCommands, visible, meshes, commands, instanceData);
+
+    // different LODs of the same mesh aren't instanced together
+    ASSERT_EQ(commands.size(), 2);
+    EXPECT_EQ(commands[0].firstIndex, 36);
+    EXPECT_EQ(commands[0].indexCount, 12);
+    EXPECT_EQ(commands[0].instanceCount, 2);
+    EXPECT_EQ(commands[1].firstIndex, 0);
+    EXPECT_EQ(commands[1].indexCount, 36);
+    EXPECT_EQ(commands[1].instanceCount, 1);
+}
+
+TEST(IndirectDrawBuilder, SplitMeshletDrawCommands)
+{
+    auto meshes = std::vector{makeMesh(0, 0, 36), makeMesh(24, 36, 60)};
+    meshes[1].firstMeshlet = 0;
+    meshes[1].numMeshlets = 3;
+
+    const auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 1, .materialId = 1, .isStatic = true},
+        {.meshId = 0, .materialId = 1, .isStatic = true}, // no meshlets
+        {.meshId = 1, .materialId = 1, .isStatic = false},
+        {.meshId = 1, .materialId = 1, .lod = 1, .isStatic = true},
+        {.meshId = 1, .materialId = 1, .isStatic = true},
+        {.meshId = 1, .materialId = 1, .isStatic = true}, // over the limit
+    };
+    auto visible = std::vector<std::uint32_t>{0, 1, 2, 3, 4, 5};
+    std::vector<std::uint32_t> meshletDrawCommands;
+    graphics::splitMeshletDrawCommands(drawCommands, meshes, visible, meshletDrawCommands, 7);
+
+    EXPECT_EQ(meshletDrawCommands, (std::vector<std::uint32_t>{0, 4}));
+    EXPECT_EQ(visible, (std::vector<std::uint32_t>{1, 2, 3, 5}));
+}
+
+TEST(IndirectDrawBuilder, MeshletDraws)
+{
+    auto meshes = std::vector{makeMesh(0, 0, 36), makeMesh(24, 36, 60)};
+    meshes[0].firstMeshlet = 0;
+    meshes[0].numMeshlets = 2;
+    meshes[1].firstMeshlet = 2;
+    meshes[1].numMeshlets = 3;
+    meshes[1].indexType = VK_INDEX_TYPE_UINT16;
+
+    const auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 0, .materialId = 1, .isStatic = true},
+        {.meshId = 1, .materialId = 2, .isStatic = true},
+        {.meshId = 0, .materialId = 3, .isStatic = true},
+    };
+    const auto meshletDrawCommands = std::vector<std::uint32_t>{0, 1, 2};
+
+    // meshlet instances go after the instances of regular draws
+    std::vector<GPUMeshInstanceData> instanceData(4);
+    std::vector<GPUMeshletDraw> meshletDraws;
+    const auto stats = graphics::buildMeshletDraws(
+        drawCommands, meshletDrawCommands, meshes, instanceData, meshletDraws);
+
+    EXPECT_EQ(stats.numInstances, 3);
+    EXPECT_EQ(stats.numDraws, 7);
+    EXPECT_EQ(stats.numIndex16Draws, 3);
+    ASSERT_EQ(instanceData.size(), 7);
+    EXPECT_EQ(instanceData[4].materialId, 2);
+    EXPECT_EQ(instanceData[5].materialId, 1);
+    EXPECT_EQ(instanceData[6].materialId, 3);
+
+    ASSERT_EQ(meshletDraws.size(), 7);
+    // 16-bit: mesh 1
+    for (std::uint32_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(meshletDraws[i].instanceIndex, 4);
+        EXPECT_EQ(meshletDraws[i].meshletIndex, 2 + i);
+    }
+    // 32-bit: two instances of mesh 0
+    EXPECT_EQ(meshletDraws[3].instanceIndex, 5);
+    EXPECT_EQ(meshletDraws[3].meshletIndex, 0);
+    EXPECT_EQ(meshletDraws[4].meshletIndex, 1);
+    EXPECT_EQ(meshletDraws[5].instanceIndex, 6);
+    EXPECT_EQ(meshletDraws[6].instanceIndex, 6);
+
+    // instances which don't fit are skipped with all of their meshlets
+    instanceData.resize(4);
+    const auto limited = graphics::buildMeshletDraws(
+        drawCommands, meshletDrawCommands, meshes, instanceData, meshletDraws, 6);
+    EXPECT_EQ(limited.numInstances, 2);
+    EXPECT_EQ(limited.numDraws, 5);
+    EXPECT_EQ(meshletDraws.size(), 5);
+}
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include <edbr/Core/JobSystem.h>
+
+TEST(JobSystem, ParallelForVisitsEachIndexOnce)
+{
+    JobSystem jobSystem(3);
+
+    static const std::size_t count = 10'007;
+    std::vector<std::atomic<int>> visited(count);
+    for (int i = 0; i < 3; ++i) { // reuse the same workers for several tasks
+        jobSystem.parallelFor(count, 64, [&](std::size_t begin, std::size_t end, std::size_t t) {
+            EXPECT_LT(t, jobSystem.getNumThreads());
+            for (auto j = begin; j < end; ++j) {
+                ++visited[j];
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(visited[i], 3);
+    }
+}
+
+TEST(JobSystem, NoWorkers)
+{
+    JobSystem jobSystem(0);
+    EXPECT_EQ(jobSystem.getNumThreads(), 1);
+
+    std::size_t sum = 0;
+    jobSystem.parallelFor(100, 10, [&](std::size_t begin, std::size_t end, std::size_t t) {
+        EXPECT_EQ(t, 0);
+        for (auto i = begin; i < end; ++i) {
+            sum += i;
+        }
+    });
+    EXPECT_EQ(sum, 4950);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/Light.h>
+#include <edbr/Graphics/LightClusterGrid.h>
+
+namespace
+{
+// looks at +Z
+Camera makeCamera()
+{
+    Camera camera;
+    camera.setUseInverseDepth(true);
+    camera.init(glm::radians(90.f), 0.1f, 100.f, 16.f / 9.f);
+    return camera;
+}
+
+GPULightData makePointLight(const glm::vec3& position, float range)
+{
+    return GPULightData{
+        .position = position,
+        .type = edbr::TYPE_POINT_LIGHT,
+        .range = range,
+    };
+}
+
+// inverse of the projection done by the grid (view space looks at -Z)
+glm::vec3 toViewSpace(const Camera& camera, const glm::vec2& uv, float depth)
+{
+    const auto& proj = camera.getProjection();
+    const auto ndc = uv * 2.f - 1.f;
+    return glm::vec3{ndc.x * depth / proj[0][0], ndc.y * depth / proj[1][1], -depth};
+}
+
+bool clusterHasLight(
+    const LightClusterGrid& grid,
+    const glm::vec2& uv,
+    float depth,
+    std::uint32_t lightIndex)
+{
+    const auto clusterIndex = LightClusterGrid::getClusterIndex(grid.findCluster(uv, depth));
+    const auto lights = grid.getClusterLights(clusterIndex);
+    return std::find(lights.begin(), lights.end(), lightIndex) != lights.end();
+}
+}
+
+TEST(LightClusterGrid, FindCluster)
+{
+    const auto camera = makeCamera();
+    LightClusterGrid grid;
+    grid.build(camera, {});
+
+    EXPECT_EQ(grid.findCluster({0.f, 0.f}, 0.f), glm::uvec3(0, 0, 0));
+    EXPECT_EQ(grid.findCluster({0.f, 0.f}, camera.getZNear()), glm::uvec3(0, 0, 0));
+    EXPECT_EQ(
+        grid.findCluster({1.f, 1.f}, camera.getZFar()),
+        glm::uvec3(
+            LightClusterGrid::GRID_SIZE_X - 1,
+            LightClusterGrid::GRID_SIZE_Y - 1,
+            LightClusterGrid::GRID_SIZE_Z - 1));
+    EXPECT_EQ(grid.findCluster({0.5f, 0.25f}, 1.f).x, LightClusterGrid::GRID_SIZE_X / 2);
+
+    // slices are exponential: equal depth ratios give equal number of slices
+    const auto s1 = (int)grid.findCluster({}, 1.01f).z;
+    const auto s10 = (int)grid.findCluster({}, 10.1f).z;
+    EXPECT_EQ(s10 - s1, (int)LightClusterGrid::GRID_SIZE_Z / 3);
+}
+
+TEST(LightClusterGrid, BinsLightsIntoClustersTheyTouch)
+{
+    const auto camera = makeCamera();
+    const auto lights = std::vector{
+        makePointLight({0.f, 0.f, 10.f}, 1.f), // in the center of the screen
+        makePointLight({0.f, 0.f, -10.f}, 1.f), // behind the camera
+        makePointLight({100.f, 0.f, 10.f}, 1.f), // off-screen
+        GPULightData{.type = edbr::TYPE_DIRECTIONAL_LIGHT}, // never binned
+        makePointLight({0.f, 0.f, 0.f}, 2.f), // around the camera
+    };
+
+    LightClusterGrid grid;
+    grid.build(camera, lights);
+
+    EXPECT_TRUE(clusterHasLight(grid, {0.5f, 0.5f}, 10.f, 0));
+    EXPECT_FALSE(clusterHasLight(grid, {0.5f, 0.5f}, 30.f, 0));
+    EXPECT_FALSE(clusterHasLight(grid, {0.05f, 0.05f}, 10.f, 0));
+
+    EXPECT_TRUE(clusterHasLight(grid, {0.05f, 0.05f}, 0.5f, 4));
+    EXPECT_TRUE(clusterHasLight(grid, {0.95f, 0.5f}, 1.f, 4));
+    EXPECT_FALSE(clusterHasLight(grid, {0.5f, 0.5f}, 10.f, 4));
+
+    for (const auto lightIndex : grid.getLightIndices()) {
+        EXPECT_NE(lightIndex, 1);
+        EXPECT_NE(lightIndex, 2);
+        EXPECT_NE(lightIndex, 3);
+    }
+}
+
+TEST(LightClusterGrid, EveryLitPointFindsItsLights)
+{
+    auto camera = makeCamera();
+    camera.setPosition({3.f, 2.f, 1.f});
+    camera.setYawPitch(0.7f, -0.2f);
+
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-60.f, 60.f};
+    std::uniform_real_distribution<float> rangeDist{0.5f, 15.f};
+    std::vector<GPULightData> lights;
+    for (int i = 0; i < 500; ++i) {
+        const auto pos = glm::vec3{posDist(rng), posDist(rng), posDist(rng)};
+        lights.push_back(makePointLight(pos, rangeDist(rng)));
+    }
+
+    LightClusterGrid grid;
+    grid.build(camera, lights);
+    EXPECT_EQ(grid.getNumDroppedLightIndices(), 0);
+
+    // brute force: every light which reaches the point must be in the point's cluster
+    const auto invView = glm::inverse(camera.getView());
+    std::uniform_real_distribution<float> uvDist{0.f, 1.f};
+    std::uniform_real_distribution<float> depthDist{camera.getZNear(), camera.getZFar()};
+    int numLitPoints = 0;
+    for (int i = 0; i < 5000; ++i) {
+        const auto uv = glm::vec2{uvDist(rng), uvDist(rng)};
+        const auto depth = depthDist(rng);
+        const auto p = glm::vec3{invView * glm::vec4{toViewSpace(camera, uv, depth), 1.f}};
+        for (std::uint32_t l = 0; l < lights.size(); ++l) {
+            if (glm::length(lights[l].position - p) < lights[l].range * 0.999f) {
+                ++numLitPoints;
+                EXPECT_TRUE(clusterHasLight(grid, uv, depth, l));
+            }
+        }
+    }
+    EXPECT_GT(numLitPoints, 0);
+
+    // and the grid should be much tighter than "all lights everywhere"
+    EXPECT_LT(grid.getLightIndices().size(), lights.size() * LightClusterGrid::NUM_CLUSTERS / 20);
+}
+
+TEST(LightClusterGrid, MaxLightIndices)
+{
+    const auto camera = makeCamera();
+    const auto lights = std::vector{
+        makePointLight({0.f, 0.f, 10.f}, 5.f),
+        makePointLight({1.f, 0.f, 10.f}, 5.f),
+    };
+
+    LightClusterGrid grid;
+    grid.build(camera, lights);
+    const auto numLightIndices = grid.getLightIndices().size();
+    ASSERT_GT(numLightIndices, 10);
+
+    grid.build(camera, lights, 10);
+    EXPECT_EQ(grid.getLightIndices().size(), 10);
+    EXPECT_EQ(grid.getNumDroppedLightIndices(), numLightIndices - 10);
+
+    std::size_t total = 0;
+    for (const auto& cluster : grid.getClusters()) {
+        EXPECT_LE(cluster.offset + cluster.count, 10);
+        total += cluster.count;
+    }
+    EXPECT_EQ(total, 10);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <set>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/MeshClustering.h>
+#include <edbr/Graphics/MeshletCulling.h>
+
+#include "TestMeshes.h"
+
+namespace
+{
+using testutil::makeGrid;
+using testutil::makeSphere;
+
+using Triangles = std::multiset<std::array<std::uint32_t, 3>>;
+
+Triangles getTriangles(const std::vector<std::uint32_t>& indices)
+{
+    Triangles triangles;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        triangles.insert({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    return triangles;
+}
+}
+
+TEST(MeshClustering, AllTrianglesAreKept)
+{
+    auto mesh = makeSphere(32, 64);
+    const auto triangles = getTriangles(mesh.indices);
+
+    const auto meshlets = graphics::buildMeshlets(mesh.indices, mesh.vertices);
+    EXPECT_EQ(getTriangles(mesh.indices), triangles);
+
+    // meshlets are contiguous ranges which cover all indices
+    std::uint32_t nextIndex = 0;
+    for (const auto& meshlet : meshlets) {
+        EXPECT_EQ(meshlet.firstIndex, nextIndex);
+        EXPECT_GT(meshlet.numIndices, 0);
+        EXPECT_EQ(meshlet.numIndices % 3, 0);
+        nextIndex += meshlet.numIndices;
+    }
+    EXPECT_EQ(nextIndex, mesh.indices.size());
+}
+
+TEST(MeshClustering, MeshletSizes)
+{
+    auto mesh = makeGrid(64);
+    const auto params = graphics::MeshletParams{.maxVertices = 96, .maxTriangles = 128};
+    const auto meshlets = graphics::buildMeshlets(mesh.indices, mesh.vertices, params);
+
+    for (const auto& meshlet : meshlets) {
+        EXPECT_LE(meshlet.numIndices / 3, params.maxTriangles);
+        const auto first = mesh.indices.begin() + meshlet.firstIndex;
+        const auto vertices = std::set<std::uint32_t>(first, first + meshlet.numIndices);
+        EXPECT_LE(vertices.size(), params.maxVertices);
+    }
+
+    // regular grid is split into mostly full meshlets
+    const auto numTriangles = mesh.indices.size() / 3;
+    EXPECT_GE((float)numTriangles / (float)meshlets.size(), 90.f);
+}
+
+TEST(MeshClustering, Bounds)
+{
+    auto mesh = makeGrid(32);
+    const auto meshlets = graphics::buildMeshlets(mesh.indices, mesh.vertices);
+
+    for (const auto& meshlet : meshlets) {
+        const auto& sphere = meshlet.boundingSphere;
+        for (std::uint32_t i = 0; i < meshlet.numIndices; ++i) {
+            const auto& p = mesh.vertices[mesh.indices[meshlet.firstIndex + i]].position;
+            EXPECT_LE(glm::length(p - sphere.center), sphere.radius * 1.0001f + 1e-5f);
+        }
+        // flat meshlets have zero-width cones
+        EXPECT_NEAR(meshlet.coneAxis.y, 1.f, 1e-5f);
+        EXPECT_NEAR(meshlet.coneCutoff, 0.f, 1e-3f);
+    }
+}
+
+TEST(MeshClustering, ConeTestIsConservative)
+{
+    auto mesh = makeSphere(32, 64);
+    const auto meshlets = graphics::buildMeshlets(mesh.indices, mesh.vertices);
+
+    const auto viewPoints = std::array{
+        glm::vec3{0.f, 0.f, 3.f},
+        glm::vec3{2.f, 1.f, 0.f},
+        glm::vec3{-1.2f, -0.5f, 0.3f},
+        glm::vec3{0.f, 10.f, 0.f},
+    };
+    for (const auto& viewPoint : viewPoints) {
+        std::size_t numBackfacing = 0;
+        for (const auto& meshlet : meshlets) {
+            if (!graphics::isMeshletBackfacing(meshlet, viewPoint)) {
+                continue;
+            }
+            ++numBackfacing;
+            // every triangle of a backfacing meshlet is backfacing
+            for (std::uint32_t i = 0; i < meshlet.numIndices; i += 3) {
+                const auto idx = meshlet.firstIndex + i;
+                const auto& p0 = mesh.vertices[mesh.indices[idx]].position;
+                const auto& p1 = mesh.vertices[mesh.indices[idx + 1]].position;
+                const auto& p2 = mesh.vertices[mesh.indices[idx + 2]].position;
+                const auto n = glm::cross(p1 - p0, p2 - p0);
+                EXPECT_GE(glm::dot(n, p0 - viewPoint), -1e-6f);
+            }
+        }
+        // about a half of the sphere faces away from the view point
+        EXPECT_GT(numBackfacing, meshlets.size() / 5);
+        EXPECT_LT(numBackfacing, meshlets.size());
+    }
+}
+
+TEST(MeshClustering, GenerateMeshlets)
+{
+    auto small = makeGrid(4);
+    graphics::generateMeshlets(small);
+    EXPECT_TRUE(small.meshlets.empty());
+
+    auto skinned = makeGrid(32);
+    skinned.hasSkeleton = true;
+    graphics::generateMeshlets(skinned);
+    EXPECT_TRUE(skinned.meshlets.empty());
+
+    auto big = makeGrid(32);
+    graphics::generateMeshlets(big);
+    EXPECT_FALSE(big.meshlets.empty());
+}
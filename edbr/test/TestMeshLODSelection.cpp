@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <glm/trigonometric.hpp>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/MeshLODSelection.h>
+
+namespace
+{
+// errors of LOD 1, 2 and 3 are 0.01, 0.04 and 0.16
+GPUMesh makeMesh()
+{
+    GPUMesh mesh{.numIndices = 3000, .boundingSphere = {.radius = 1.f}};
+    mesh.lods[0] = {.firstIndex = 0, .numIndices = 3000};
+    mesh.lods[1] = {.firstIndex = 3000, .numIndices = 1500, .error = 0.01f};
+    mesh.lods[2] = {.firstIndex = 4500, .numIndices = 750, .error = 0.04f};
+    mesh.lods[3] = {.firstIndex = 5250, .numIndices = 375, .error = 0.16f};
+    mesh.numLODs = 4;
+    return mesh;
+}
+}
+
+TEST(MeshLODSelection, PixelsPerUnit)
+{
+    Camera camera;
+    camera.init(glm::radians(90.f), 0.1f, 100.f, 1.f);
+
+    // tan(fovY / 2) = 1, so the view is 2 * distance units high
+    const auto near = math::Sphere{.center = {0.f, 0.f, -10.f}, .radius = 1.f};
+    const auto far = math::Sphere{.center = {0.f, 0.f, -19.f}, .radius = 1.f};
+    EXPECT_NEAR(graphics::calculatePixelsPerUnit(camera, 1080.f, near), 60.f, 1e-3f);
+    EXPECT_NEAR(graphics::calculatePixelsPerUnit(camera, 1080.f, far), 30.f, 1e-3f);
+    // camera is inside of the sphere
+    const auto around = math::Sphere{.center = {0.f, 0.f, -1.f}, .radius = 2.f};
+    EXPECT_NEAR(graphics::calculatePixelsPerUnit(camera, 1080.f, around), 5400.f, 0.1f);
+
+    Camera ortho;
+    ortho.initOrtho(10.f, 0.f, 100.f);
+    EXPECT_NEAR(graphics::calculatePixelsPerUnit(ortho, 1000.f, near), 50.f, 1e-3f);
+    EXPECT_NEAR(graphics::calculatePixelsPerUnit(ortho, 1000.f, far), 50.f, 1e-3f);
+}
+
+TEST(MeshLODSelection, CoarsestLODUnderThreshold)
+{
+    const auto mesh = makeMesh();
+    const auto params = graphics::LODSelectionParams{.maxScreenError = 1.f};
+
+    // threshold = 1 / pixelsPerUnit
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 1000.f, params), 0);
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 50.f, params), 1);
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 20.f, params), 2);
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 1.f, params), 3);
+    // scaled up meshes have bigger errors in world units
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 4.f, 20.f, params), 1);
+    // bias makes coarser LODs get picked
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 50.f, {.bias = 2.f}), 2);
+
+    GPUMesh noLODs;
+    EXPECT_EQ(graphics::selectMeshLOD(noLODs, 1.f, 1.f, params), 0);
+}
+
+TEST(MeshLODSelection, Hysteresis)
+{
+    const auto mesh = makeMesh();
+    const auto params = graphics::LODSelectionParams{.hysteresis = 0.25f};
+
+    // threshold is 0.045: LOD 2 fits, but not with the 25% margin
+    const auto ppu = 1.f / 0.045f;
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, ppu, params), 2);
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, ppu, params, 1), 1);
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, ppu, params, 2), 2);
+    // finer LODs are picked as soon as the error is too big
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, ppu, params, 3), 2);
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 1000.f, params, 3), 0);
+    // far enough - coarsened past the margin
+    EXPECT_EQ(graphics::selectMeshLOD(mesh, 1.f, 1.f / 0.06f, params, 1), 2);
+}
+
+TEST(MeshLODSelection, HistoryFollowsDrawId)
+{
+    const auto meshes = std::vector{makeMesh(), GPUMesh{}};
+    Camera camera;
+    camera.init(glm::radians(90.f), 0.1f, 100.f, 1.f);
+
+    // 0.045 units per pixel at the closest point of the sphere:
+    // LOD 2 without hysteresis, LOD 1 is kept by it
+    const auto viewportHeight = 1000.f;
+    const auto distance = 0.045f * viewportHeight / 2.f;
+    const auto sphere = math::Sphere{.center = {0.f, 0.f, -distance - 1.f}, .radius = 1.f};
+    std::vector<MeshDrawCommand> drawCommands{
+        {.meshId = 0, .worldBoundingSphere = sphere, .drawId = 10},
+        {.meshId = 0, .worldBoundingSphere = sphere, .drawId = 20},
+        {.meshId = 1, .worldBoundingSphere = sphere, .drawId = 30},
+        {.meshId = 0, .worldBoundingSphere = sphere},
+    };
+
+    graphics::MeshLODHistory history;
+    history.entries[10] = {.meshId = 0, .lod = 1};
+    history.entries[20] = {.meshId = 0, .lod = 3};
+    history.entries[30] = {.meshId = 0, .lod = 1};
+    graphics::selectMeshLODs(drawCommands, meshes, camera, viewportHeight, {}, history);
+    EXPECT_EQ(drawCommands[0].lod, 1); // kept by hysteresis
+    EXPECT_EQ(drawCommands[1].lod, 2); // too coarse, refined
+    EXPECT_EQ(drawCommands[2].lod, 0); // mesh doesn't have LODs
+    EXPECT_EQ(drawCommands[3].lod, 2); // no id - no hysteresis
+
+    ASSERT_EQ(history.entries.size(), 3);
+    EXPECT_EQ(history.entries[30].meshId, 1);
+
+    // draws are submitted in another order (e.g. by drawMeshParallel):
+    // each one still gets its own LOD back
+    std::swap(drawCommands[0], drawCommands[1]);
+    drawCommands[1].lod = 0;
+    graphics::selectMeshLODs(drawCommands, meshes, camera, viewportHeight, {}, history);
+    EXPECT_EQ(drawCommands[0].drawId, 20);
+    EXPECT_EQ(drawCommands[0].lod, 2);
+    EXPECT_EQ(drawCommands[1].drawId, 10);
+    EXPECT_EQ(drawCommands[1].lod, 1);
+
+    // same id, but the previous LOD was of another mesh
+    drawCommands[2].meshId = 0;
+    graphics::selectMeshLODs(drawCommands, meshes, camera, viewportHeight, {}, history);
+    EXPECT_EQ(drawCommands[2].lod, 2);
+
+    // draws which weren't submitted are forgotten
+    drawCommands.resize(1);
+    graphics::selectMeshLODs(drawCommands, meshes, camera, viewportHeight, {}, history);
+    EXPECT_EQ(history.entries.size(), 1);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/MeshOptimization.h>
+
+#include "TestMeshes.h"
+
+namespace
+{
+using testutil::makeGrid;
+using testutil::makeSphere;
+
+void shuffleTriangles(std::vector<std::uint32_t>& indices, std::uint32_t seed)
+{
+    std::vector<std::array<std::uint32_t, 3>> triangles(indices.size() / 3);
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        triangles[t] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937{seed});
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        std::copy(triangles[t].begin(), triangles[t].end(), indices.begin() + t * 3);
+    }
+}
+
+// triangles as sorted lists of vertex positions - lets meshes with
+// different vertex order be compared
+using PositionTriangle = std::array<std::array<float, 3>, 3>;
+
+std::vector<PositionTriangle> getTriangles(const CPUMesh& mesh)
+{
+    std::vector<PositionTriangle> triangles;
+    for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+        PositionTriangle tri;
+        for (int j = 0; j < 3; ++j) {
+            const auto& p = mesh.vertices[mesh.indices[i + j]].position;
+            tri[j] = {p.x, p.y, p.z};
+        }
+        // rotate so that the winding is kept
+        std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+        triangles.push_back(tri);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+}
+
+TEST(MeshOptimization, FIFOCacheSimulator)
+{
+    // triangles sharing an edge
+    const auto strip = std::vector<std::uint32_t>{0, 1, 2, 2, 1, 3};
+    const auto stripStats = graphics::analyzeVertexCache(strip, 4);
+    EXPECT_EQ(stripStats.numTransformedVertices, 4);
+    EXPECT_FLOAT_EQ(stripStats.acmr, 2.f);
+    EXPECT_FLOAT_EQ(stripStats.atvr, 1.f);
+
+    // FIFO doesn't move vertices to the front on hits (LRU would):
+    // vertex 0 is evicted by 3 and 4 even though it was used by the second triangle
+    const auto fan = std::vector<std::uint32_t>{0, 1, 2, 0, 3, 4, 0, 5, 6};
+    EXPECT_EQ(graphics::analyzeVertexCache(fan, 7, 3).numTransformedVertices, 8);
+    EXPECT_EQ(graphics::analyzeVertexCache(fan, 7, 16).numTransformedVertices, 7);
+
+    EXPECT_EQ(graphics::analyzeVertexCache({}, 0).numTransformedVertices, 0);
+}
+
+TEST(MeshOptimization, DeduplicateVertices)
+{
+    // non-indexed quad: 6 vertices, 2 of them duplicated
+    CPUMesh mesh;
+    for (const auto& p : {
+             glm::vec3{0.f, 0.f, 0.f},
+             glm::vec3{1.f, 0.f, 0.f},
+             glm::vec3{0.f, 1.f, 0.f},
+             glm::vec3{0.f, 1.f, 0.f},
+             glm::vec3{1.f, 0.f, 0.f},
+             glm::vec3{1.f, 1.f, 0.f},
+         }) {
+        mesh.vertices.push_back(CPUMesh::Vertex{.position = p});
+    }
+    const auto triangles = getTriangles(
+        CPUMesh{.indices = {0, 1, 2, 3, 4, 5}, .vertices = mesh.vertices});
+
+    EXPECT_EQ(graphics::deduplicateVertices(mesh), 2);
+    EXPECT_EQ(mesh.vertices.size(), 4);
+    EXPECT_EQ(mesh.indices, (std::vector<std::uint32_t>{0, 1, 2, 2, 1, 3}));
+    EXPECT_EQ(getTriangles(mesh), triangles);
+}
+
+TEST(MeshOptimization, DeduplicateKeepsDifferentSkinningData)
+{
+    CPUMesh mesh{
+        .indices = {0, 1, 2},
+        .vertices = std::vector<CPUMesh::Vertex>(3),
+        .skinningData = std::vector<CPUMesh::SkinningData>(3),
+        .hasSkeleton = true,
+    };
+    mesh.skinningData[2].jointIds.x = 1;
+
+    EXPECT_EQ(graphics::deduplicateVertices(mesh), 1);
+    ASSERT_EQ(mesh.skinningData.size(), 2);
+    EXPECT_EQ(mesh.skinningData[1].jointIds.x, 1);
+    EXPECT_EQ(mesh.indices, (std::vector<std::uint32_t>{0, 0, 1}));
+}
+
+TEST(MeshOptimization, VertexFetchOrder)
+{
+    CPUMesh mesh;
+    for (int i = 0; i < 6; ++i) {
+        mesh.vertices.push_back(CPUMesh::Vertex{.position = {(float)i, 0.f, 0.f}});
+    }
+    mesh.indices = {4, 2, 5, 5, 2, 0}; // vertices 1 and 3 are unused
+    const auto triangles = getTriangles(mesh);
+
+    graphics::optimizeVertexFetch(mesh);
+    EXPECT_EQ(mesh.vertices.size(), 4);
+    EXPECT_EQ(mesh.indices, (std::vector<std::uint32_t>{0, 1, 2, 2, 1, 3}));
+    EXPECT_EQ(getTriangles(mesh), triangles);
+}
+
+TEST(MeshOptimization, VertexCacheImprovesACMR)
+{
+    auto mesh = makeGrid(64);
+    shuffleTriangles(mesh.indices, 1);
+    const auto triangles = getTriangles(mesh);
+
+    const auto stats = graphics::optimizeMesh(mesh);
+    EXPECT_EQ(stats.numVerticesBefore, stats.numVerticesAfter);
+    // shuffled grid misses almost every vertex
+    EXPECT_GT(stats.cacheBefore.acmr, 2.f);
+    // 0.5 is the limit for big regular grids
+    EXPECT_LT(stats.cacheAfter.acmr, 0.8f);
+    EXPECT_EQ(
+        stats.cacheAfter.acmr,
+        graphics::analyzeVertexCache(mesh.indices, mesh.vertices.size()).acmr);
+
+    EXPECT_EQ(getTriangles(mesh), triangles);
+
+    // vertices are in the order of first use
+    std::uint32_t maxIndex = 0;
+    for (const auto index : mesh.indices) {
+        EXPECT_LE(index, maxIndex + 1);
+        maxIndex = std::max(maxIndex, index);
+    }
+}
+
+TEST(MeshOptimization, OverdrawKeepsCacheEfficiency)
+{
+    auto mesh = makeSphere(32, 64);
+    shuffleTriangles(mesh.indices, 2);
+    const auto triangles = getTriangles(mesh);
+
+    graphics::optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    const auto cacheOptimized = graphics::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    graphics::optimizeOverdraw(mesh.indices, mesh.vertices, 1.05f);
+    const auto overdrawOptimized =
+        graphics::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    // clusters start with a cold cache after reordering, so allow some slack
+    EXPECT_LT(overdrawOptimized.acmr, cacheOptimized.acmr * 1.15f);
+    EXPECT_EQ(getTriangles(mesh), triangles);
+}
+
+TEST(MeshOptimization, NonIndexedMesh)
+{
+    auto grid = makeGrid(8);
+    CPUMesh mesh;
+    for (const auto index : grid.indices) {
+        mesh.vertices.push_back(grid.vertices[index]);
+    }
+    const auto triangles = getTriangles(grid);
+
+    const auto stats = graphics::optimizeMesh(mesh);
+    EXPECT_EQ(stats.numVerticesBefore, grid.indices.size());
+    EXPECT_EQ(stats.numVerticesAfter, grid.vertices.size());
+    EXPECT_FLOAT_EQ(stats.cacheBefore.acmr, 3.f);
+    EXPECT_LT(stats.cacheAfter.acmr, 1.f);
+    EXPECT_EQ(getTriangles(mesh), triangles);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/MeshSimplification.h>
+
+#include "TestMeshes.h"
+
+namespace
+{
+using testutil::makeGrid;
+using testutil::makeSphere;
+
+float distanceToTriangle(
+    const glm::vec3& p,
+    const glm::vec3& a,
+    const glm::vec3& b,
+    const glm::vec3& c)
+{
+    // "Real-Time Collision Detection", 5.1.5
+    const auto ab = b - a;
+    const auto ac = c - a;
+    const auto ap = p - a;
+    const auto d1 = glm::dot(ab, ap);
+    const auto d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f) {
+        return glm::length(p - a);
+    }
+    const auto bp = p - b;
+    const auto d3 = glm::dot(ab, bp);
+    const auto d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3) {
+        return glm::length(p - b);
+    }
+    const auto vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+        return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+    }
+    const auto cp = p - c;
+    const auto d5 = glm::dot(ab, cp);
+    const auto d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6) {
+        return glm::length(p - c);
+    }
+    const auto vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+        return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+    }
+    const auto va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) {
+        return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+    }
+    const auto denom = 1.f / (va + vb + vc);
+    return glm::length(p - (a + ab * (vb * denom) + ac * (vc * denom)));
+}
+
+// max distance from the original vertices to the simplified surface
+float measureError(const CPUMesh& mesh, const std::vector<std::uint32_t>& simplified)
+{
+    float maxDistance = 0.f;
+    for (const auto& v : mesh.vertices) {
+        auto distance = std::numeric_limits<float>::max();
+        for (std::size_t i = 0; i < simplified.size(); i += 3) {
+            distance = std::min(
+                distance,
+                distanceToTriangle(
+                    v.position,
+                    mesh.vertices[simplified[i]].position,
+                    mesh.vertices[simplified[i + 1]].position,
+                    mesh.vertices[simplified[i + 2]].position));
+        }
+        maxDistance = std::max(maxDistance, distance);
+    }
+    return maxDistance;
+}
+
+float calculateArea(const CPUMesh& mesh, const std::vector<std::uint32_t>& indices)
+{
+    float area = 0.f;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        const auto& a = mesh.vertices[indices[i]].position;
+        const auto& b = mesh.vertices[indices[i + 1]].position;
+        const auto& c = mesh.vertices[indices[i + 2]].position;
+        area += glm::length(glm::cross(b - a, c - a)) * 0.5f;
+    }
+    return area;
+}
+}
+
+TEST(MeshSimplification, FlatGridKeepsItsBorder)
+{
+    const auto mesh = makeGrid(16);
+    const auto result = graphics::simplifyMesh(mesh.indices, mesh.vertices, 0, 1e-4f);
+
+    // flat interior and straight borders can be collapsed for free,
+    // corners can't be moved
+    EXPECT_LE(result.indices.size() / 3, 16);
+    EXPECT_LT(result.error, 1e-4f);
+    EXPECT_NEAR(calculateArea(mesh, result.indices), 256.f, 1e-3f);
+    for (const auto corner : {0u, 16u, 16u * 17u, 17u * 17u - 1u}) {
+        EXPECT_NE(
+            std::find(result.indices.begin(), result.indices.end(), corner),
+            result.indices.end())
+            << corner;
+    }
+}
+
+TEST(MeshSimplification, ReducesTrianglesWithBoundedError)
+{
+    const auto mesh = makeSphere(32, 64);
+    const auto numTriangles = mesh.indices.size() / 3;
+    const auto result = graphics::simplifyMesh(mesh.indices, mesh.vertices, numTriangles / 4 * 3);
+
+    EXPECT_LE(result.indices.size() / 3, numTriangles / 4);
+    EXPECT_GT(result.indices.size() / 3, numTriangles / 8);
+    EXPECT_GT(result.error, 0.f);
+
+    // reported error is an estimate (RMS distance to the planes of the
+    // original triangles), the real one shouldn't be far off
+    const auto measuredError = measureError(mesh, result.indices);
+    EXPECT_LT(measuredError, 0.05f);
+    EXPECT_LT(measuredError, result.error * 4.f);
+    // the sphere doesn't collapse on itself
+    EXPECT_NEAR(calculateArea(mesh, result.indices), 4.f * 3.14159265f, 0.3f);
+}
+
+TEST(MeshSimplification, MaxErrorStopsSimplification)
+{
+    const auto mesh = makeSphere(16, 32);
+    const auto exact = graphics::simplifyMesh(mesh.indices, mesh.vertices, 0, 0.f);
+    // only degenerate pole triangles are removed
+    EXPECT_EQ(exact.indices.size(), mesh.indices.size() - 2 * 32 * 3);
+    EXPECT_EQ(exact.error, 0.f);
+
+    const auto coarse = graphics::simplifyMesh(mesh.indices, mesh.vertices, 0, 0.01f);
+    EXPECT_LT(coarse.indices.size(), exact.indices.size());
+    EXPECT_LE(coarse.error, 0.01f);
+}
+
+TEST(MeshSimplification, SeamsAreLocked)
+{
+    const auto mesh = makeSphere(16, 32);
+    const auto result = graphics::simplifyMesh(mesh.indices, mesh.vertices, 0);
+    EXPECT_LT(result.indices.size(), mesh.indices.size() / 4);
+
+    // both sides of the UV seam are kept
+    const auto used = std::set<std::uint32_t>(result.indices.begin(), result.indices.end());
+    for (std::uint32_t r = 1; r < 16; ++r) {
+        EXPECT_TRUE(used.contains(r * 33)) << r;
+        EXPECT_TRUE(used.contains(r * 33 + 32)) << r;
+    }
+}
+
+TEST(MeshSimplification, LODChain)
+{
+    auto mesh = makeSphere(32, 64);
+    graphics::generateMeshLODs(mesh, graphics::MeshLODParams{.maxLODs = 4, .maxError = 0.1f});
+    ASSERT_GE(mesh.lods.size(), 2);
+    EXPECT_LE(mesh.lods.size(), 4);
+
+    auto prevNumTriangles = mesh.indices.size() / 3;
+    auto prevError = 0.f;
+    for (const auto& lod : mesh.lods) {
+        const auto numTriangles = lod.indices.size() / 3;
+        EXPECT_LE(numTriangles, prevNumTriangles / 2);
+        EXPECT_GE(lod.error, prevError);
+        EXPECT_LE(lod.error, 0.1f);
+        for (const auto index : lod.indices) {
+            EXPECT_LT(index, mesh.vertices.size());
+        }
+        prevNumTriangles = numTriangles;
+        prevError = lod.error;
+    }
+    EXPECT_LT(measureError(mesh, mesh.lods.back().indices), 0.2f);
+
+    auto small = makeGrid(4);
+    graphics::generateMeshLODs(small);
+    EXPECT_TRUE(small.lods.empty());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <edbr/Graphics/CPUMesh.h>
+
+// Procedural meshes shared by mesh processing tests
+namespace testutil
+{
+// size x size quads on the XZ plane, facing +Y, UVs go from 0 to 1
+inline CPUMesh makeGrid(std::uint32_t size)
+{
+    CPUMesh mesh;
+    for (std::uint32_t z = 0; z <= size; ++z) {
+        for (std::uint32_t x = 0; x <= size; ++x) {
+            mesh.vertices.push_back(CPUMesh::Vertex{
+                .position = {(float)x, 0.f, (float)z},
+                .uv_x = (float)x / (float)size,
+                .normal = {0.f, 1.f, 0.f},
+                .uv_y = (float)z / (float)size,
+            });
+        }
+    }
+    for (std::uint32_t z = 0; z < size; ++z) {
+        for (std::uint32_t x = 0; x < size; ++x) {
+            const auto i = z * (size + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), {i, i + size + 1, i + 1});
+            mesh.indices.insert(mesh.indices.end(), {i + 1, i + size + 1, i + size + 2});
+        }
+    }
+    return mesh;
+}
+
+// Unit UV sphere, every vertex is used by up to 6 triangles.
+// Vertices of the first and last segment share positions (UV seam),
+// as do the vertices of each pole.
+inline CPUMesh makeSphere(std::uint32_t rings, std::uint32_t segments)
+{
+    CPUMesh mesh;
+    for (std::uint32_t r = 0; r <= rings; ++r) {
+        const auto phi = 3.14159265f * (float)r / (float)rings;
+        const auto isPole = (r == 0 || r == rings);
+        for (std::uint32_t s = 0; s <= segments; ++s) {
+            const auto theta = 6.2831853f * (float)(s % segments) / (float)segments;
+            const auto p = glm::vec3{
+                isPole ? 0.f : std::sin(phi) * std::cos(theta),
+                r == 0 ? 1.f : (r == rings ? -1.f : std::cos(phi)),
+                isPole ? 0.f : std::sin(phi) * std::sin(theta),
+            };
+            mesh.vertices.push_back(CPUMesh::Vertex{
+                .position = p,
+                .uv_x = (float)s / (float)segments,
+                .normal = p,
+                .uv_y = (float)r / (float)rings,
+            });
+        }
+    }
+    for (std::uint32_t r = 0; r < rings; ++r) {
+        for (std::uint32_t s = 0; s < segments; ++s) {
+            const auto i = r * (segments + 1) + s;
+            mesh.indices.insert(mesh.indices.end(), {i, i + 1, i + segments + 1});
+            mesh.indices.insert(mesh.indices.end(), {i + 1, i + segments + 2, i + segments + 1});
+        }
+    }
+    return mesh;
+}
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/trigonometric.hpp>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/MeshletCulling.h>
+
+namespace
+{
+// flat meshlets facing +Y placed along the X axis, 30 indices each
+std::vector<Meshlet> makeFlatMeshlets(std::size_t count)
+{
+    std::vector<Meshlet> meshlets;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto center = glm::vec3{(float)i * 2.f, 0.f, 0.f};
+        meshlets.push_back(Meshlet{
+            .boundingSphere = {.center = center, .radius = 1.f},
+            .coneApex = center,
+            .coneAxis = {0.f, 1.f, 0.f},
+            .coneCutoff = 0.f,
+            .firstIndex = (std::uint32_t)i * 30,
+            .numIndices = 30,
+        });
+    }
+    return meshlets;
+}
+
+graphics::MeshletCullingView makeView(const glm::vec3& position)
+{
+    return graphics::MeshletCullingView{.viewPoint = position};
+}
+}
+
+TEST(MeshletCulling, ConeTest)
+{
+    const auto meshlet = makeFlatMeshlets(1)[0];
+    EXPECT_FALSE(graphics::isMeshletBackfacing(meshlet, {0.f, 1.f, 0.f}));
+    EXPECT_FALSE(graphics::isMeshletBackfacing(meshlet, {5.f, 0.1f, 5.f}));
+    EXPECT_TRUE(graphics::isMeshletBackfacing(meshlet, {0.f, -1.f, 0.f}));
+    EXPECT_TRUE(graphics::isMeshletBackfacing(meshlet, {5.f, -0.1f, 5.f}));
+
+    EXPECT_FALSE(graphics::isMeshletBackfacingOrtho(meshlet, {0.f, -1.f, 0.f}));
+    EXPECT_TRUE(graphics::isMeshletBackfacingOrtho(meshlet, {0.f, 1.f, 0.f}));
+
+    // 60 degree wide cone: only views which are at least 30 degrees below
+    // the apex can't see any of the triangles
+    auto wide = meshlet;
+    wide.coneCutoff = std::sin(glm::radians(30.f));
+    EXPECT_FALSE(graphics::isMeshletBackfacing(wide, {1.f, -0.5f, 0.f}));
+    EXPECT_TRUE(graphics::isMeshletBackfacing(wide, {1.f, -2.f, 0.f}));
+
+    // cones wider than a hemisphere are never backfacing
+    auto open = meshlet;
+    open.coneCutoff = 1.f;
+    EXPECT_FALSE(graphics::isMeshletBackfacing(open, {0.f, -1.f, 0.f}));
+    EXPECT_FALSE(graphics::isMeshletBackfacingOrtho(open, {0.f, 1.f, 0.f}));
+}
+
+TEST(MeshletCulling, VisibleRangesAreMerged)
+{
+    const auto meshlets = makeFlatMeshlets(8);
+    std::vector<graphics::IndexRange> ranges;
+
+    graphics::cullMeshlets(meshlets, glm::mat4{1.f}, makeView({0.f, 10.f, 0.f}), ranges);
+    ASSERT_EQ(ranges.size(), 1);
+    EXPECT_EQ(ranges[0].firstIndex, 0);
+    EXPECT_EQ(ranges[0].numIndices, 8 * 30);
+
+    ranges.clear();
+    graphics::cullMeshlets(meshlets, glm::mat4{1.f}, makeView({0.f, -10.f, 0.f}), ranges);
+    EXPECT_TRUE(ranges.empty());
+
+    // ranges from previous calls aren't extended
+    auto view = makeView({0.f, 10.f, 0.f});
+    view.volume.addPlane(Frustum::Plane{{4.5f, 0.f, 0.f}, {1.f, 0.f, 0.f}});
+    ranges.push_back({.firstIndex = 0, .numIndices = 2 * 30});
+    graphics::cullMeshlets(meshlets, glm::mat4{1.f}, view, ranges);
+    ASSERT_EQ(ranges.size(), 2);
+    EXPECT_EQ(ranges[1].firstIndex, 2 * 30);
+
+    // meshlet 5 is moved out of the volume
+    view.volume = {};
+    view.volume.addPlane(Frustum::Plane{{3.5f, 0.f, 0.f}, {1.f, 0.f, 0.f}});
+    auto withGap = meshlets;
+    withGap[5].boundingSphere.center.x = -10.f;
+    ranges.clear();
+    graphics::cullMeshlets(withGap, glm::mat4{1.f}, view, ranges);
+    ASSERT_EQ(ranges.size(), 2);
+    EXPECT_EQ(ranges[0].firstIndex, 2 * 30);
+    EXPECT_EQ(ranges[0].numIndices, 3 * 30);
+    EXPECT_EQ(ranges[1].firstIndex, 6 * 30);
+    EXPECT_EQ(ranges[1].numIndices, 2 * 30);
+}
+
+TEST(MeshletCulling, Transform)
+{
+    const auto meshlets = makeFlatMeshlets(4);
+    std::vector<graphics::IndexRange> ranges;
+
+    // upside down - faces -Y
+    const auto flipped = glm::rotate(glm::mat4{1.f}, glm::radians(180.f), glm::vec3{1.f, 0, 0});
+    graphics::cullMeshlets(meshlets, flipped, makeView({0.f, 10.f, 0.f}), ranges);
+    EXPECT_TRUE(ranges.empty());
+    graphics::cullMeshlets(meshlets, flipped, makeView({0.f, -10.f, 0.f}), ranges);
+    EXPECT_EQ(ranges.size(), 1);
+
+    // non-uniform scale doesn't change which side of the meshlets the view is on
+    ranges.clear();
+    const auto scaled = glm::scale(glm::mat4{1.f}, glm::vec3{1.f, 0.01f, 5.f});
+    graphics::cullMeshlets(meshlets, scaled, makeView({0.f, -0.001f, 0.f}), ranges);
+    EXPECT_TRUE(ranges.empty());
+
+    // mirrored transforms aren't backface culled
+    const auto mirrored = glm::scale(glm::mat4{1.f}, glm::vec3{1.f, -1.f, 1.f});
+    graphics::cullMeshlets(meshlets, mirrored, makeView({0.f, 10.f, 0.f}), ranges);
+    EXPECT_EQ(ranges.size(), 1);
+
+    // meshlet bounds are transformed too
+    ranges.clear();
+    auto view = makeView({0.f, 10.f, 0.f});
+    view.volume.addPlane(Frustum::Plane{{100.f, 0.f, 0.f}, {1.f, 0.f, 0.f}});
+    graphics::cullMeshlets(meshlets, glm::mat4{1.f}, view, ranges);
+    EXPECT_TRUE(ranges.empty());
+    const auto moved = glm::translate(glm::mat4{1.f}, glm::vec3{100.f, 0.f, 0.f});
+    graphics::cullMeshlets(meshlets, moved, view, ranges);
+    EXPECT_EQ(ranges.size(), 1);
+}
+
+TEST(MeshletCulling, OrthographicView)
+{
+    Camera camera;
+    camera.initOrtho(10.f, 0.f, 100.f);
+    // cameras look along -Z of the quatLookAt's rotation (see PointShadowAtlas)
+    camera.setHeading(glm::quatLookAt(glm::vec3{0.f, 1.f, 0.f}, glm::vec3{0.f, 0.f, 1.f}));
+
+    const auto view = graphics::createMeshletCullingView(camera, {});
+    EXPECT_TRUE(view.orthographic);
+    EXPECT_NEAR(view.viewPoint.y, -1.f, 1e-5f);
+
+    // looks down at meshlets which face up
+    const auto meshlets = makeFlatMeshlets(4);
+    std::vector<graphics::IndexRange> ranges;
+    graphics::cullMeshlets(meshlets, glm::mat4{1.f}, view, ranges);
+    EXPECT_EQ(ranges.size(), 1);
+
+    camera.setHeading(glm::quatLookAt(glm::vec3{0.f, -1.f, 0.f}, glm::vec3{0.f, 0.f, 1.f}));
+    ranges.clear();
+    graphics::cullMeshlets(
+        meshlets, glm::mat4{1.f}, graphics::createMeshletCullingView(camera, {}), ranges);
+    EXPECT_TRUE(ranges.empty());
+
+    Camera perspectiveCamera;
+    perspectiveCamera.init(glm::radians(90.f), 0.1f, 100.f, 1.f);
+    perspectiveCamera.setPosition({1.f, 2.f, 3.f});
+    const auto perspective = graphics::createMeshletCullingView(perspectiveCamera, {});
+    EXPECT_FALSE(perspective.orthographic);
+    EXPECT_EQ(perspective.viewPoint, glm::vec3(1.f, 2.f, 3.f));
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Core/PerThreadVector.h>
+#include <edbr/ECS/ParallelForEach.h>
+
+namespace
+{
+// minimal stand-in for entt views
+struct FakeView {
+    using entity_type = std::uint32_t;
+
+    std::vector<entity_type> entities;
+
+    auto begin() const { return entities.begin(); }
+    auto end() const { return entities.end(); }
+};
+}
+
+TEST(ParallelForEach, VisitsEveryEntityOnce)
+{
+    JobSystem jobSystem(3);
+
+    FakeView view;
+    for (std::uint32_t i = 0; i < 10'000; ++i) {
+        view.entities.push_back(i * 2);
+    }
+
+    PerThreadVector<FakeView::entity_type> visited;
+    visited.reset(jobSystem.getNumThreads());
+    std::vector<FakeView::entity_type> entities;
+    edbr::ecs::parallelForEach(
+        jobSystem, view, entities, 64, [&visited](std::uint32_t e, std::size_t threadIndex) {
+            visited.get(threadIndex).push_back(e);
+        });
+
+    std::vector<FakeView::entity_type> visitedEntities;
+    visited.mergeInto(visitedEntities);
+    std::sort(visitedEntities.begin(), visitedEntities.end());
+    EXPECT_EQ(visitedEntities, view.entities);
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Core/PerThreadVector.h>
+
+TEST(PerThreadVector, MergeKeepsThreadOrder)
+{
+    PerThreadVector<int> v;
+    v.reset(3);
+    v.get(2).push_back(20);
+    v.get(0).push_back(0);
+    v.get(0).push_back(1);
+    EXPECT_EQ(v.getNumElements(), 3);
+
+    std::vector<int> out{-1};
+    v.mergeInto(out);
+    EXPECT_EQ(out, (std::vector<int>{-1, 0, 1, 20}));
+    EXPECT_EQ(v.getNumElements(), 0);
+    EXPECT_TRUE(v.get(0).empty());
+    EXPECT_TRUE(v.get(2).empty());
+}
+
+TEST(PerThreadVector, ParallelAppend)
+{
+    JobSystem jobSystem(3);
+    PerThreadVector<std::size_t> v;
+    v.reset(jobSystem.getNumThreads());
+
+    static const std::size_t count = 10'000;
+    jobSystem.parallelFor(count, 64, [&v](std::size_t begin, std::size_t end, std::size_t ti) {
+        for (std::size_t i = begin; i < end; ++i) {
+            v.get(ti).push_back(i);
+        }
+    });
+
+    std::vector<std::size_t> out;
+    v.mergeInto(out);
+    std::sort(out.begin(), out.end());
+    ASSERT_EQ(out.size(), count);
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(out[i], i);
+    }
+}
@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/Light.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/PointShadowAtlas.h>
+
+namespace
+{
+using FaceState = PointShadowAtlas::FaceState;
+
+constexpr float FAR_PLANE = 25.f;
+
+// looks along +Z
+Camera makeCamera(const glm::vec3& pos = {})
+{
+    Camera camera;
+    camera.init(glm::radians(90.f), 0.1f, 100.f, 1.f);
+    camera.setPosition(pos);
+    return camera;
+}
+
+GPULightData makePointLight(const glm::vec3& pos, float range = 5.f)
+{
+    return GPULightData{
+        .position = pos,
+        .type = (std::uint32_t)edbr::TYPE_POINT_LIGHT,
+        .range = range,
+    };
+}
+
+bool overlap(const ShadowAtlasTile& a, const ShadowAtlasTile& b)
+{
+    return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+}
+
+void checkNoOverlaps(const PointShadowAtlas& atlas)
+{
+    std::vector<ShadowAtlasTile> tiles;
+    for (const auto& light : atlas.getShadowCastingLights()) {
+        for (const auto& face : light.faces) {
+            EXPECT_EQ(face.tile.size, light.tileSize);
+            EXPECT_LE(face.tile.x + face.tile.size, atlas.getParams().atlasSize);
+            EXPECT_LE(face.tile.y + face.tile.size, atlas.getParams().atlasSize);
+            tiles.push_back(face.tile);
+        }
+    }
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+        for (std::size_t j = i + 1; j < tiles.size(); ++j) {
+            EXPECT_FALSE(overlap(tiles[i], tiles[j])) << i << " " << j;
+        }
+    }
+}
+
+MeshDrawCommand makeCaster(MeshId meshId, const glm::vec3& pos)
+{
+    auto dc = MeshDrawCommand{.meshId = meshId, .transformMatrix = glm::mat4{1.f}};
+    dc.transformMatrix[3] = glm::vec4{pos, 1.f};
+    return dc;
+}
+}
+
+TEST(ShadowAtlasAllocator, SplitAndMerge)
+{
+    ShadowAtlasAllocator allocator;
+    allocator.init(1024, 64);
+
+    std::vector<ShadowAtlasTile> tiles;
+    for (int i = 0; i < 16; ++i) {
+        const auto tile = allocator.allocate(256);
+        ASSERT_TRUE(tile.has_value());
+        tiles.push_back(*tile);
+    }
+    EXPECT_FALSE(allocator.allocate(64).has_value());
+    EXPECT_EQ(allocator.getNumFreeTexels(), 0);
+
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+        for (std::size_t j = i + 1; j < tiles.size(); ++j) {
+            EXPECT_FALSE(overlap(tiles[i], tiles[j]));
+        }
+    }
+
+    // freeing everything merges the tiles back into the whole atlas
+    for (const auto& tile : tiles) {
+        allocator.free(tile);
+    }
+    EXPECT_EQ(allocator.getNumFreeTexels(), 1024 * 1024);
+    const auto whole = allocator.allocate(1024);
+    ASSERT_TRUE(whole.has_value());
+    EXPECT_EQ(*whole, (ShadowAtlasTile{.x = 0, .y = 0, .size = 1024}));
+}
+
+TEST(ShadowAtlasAllocator, RandomAllocations)
+{
+    ShadowAtlasAllocator allocator;
+    allocator.init(2048, 32);
+
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<std::uint32_t> sizeDist{5, 9}; // 32..512
+    std::vector<ShadowAtlasTile> tiles;
+    std::uint64_t usedTexels = 0;
+    for (int i = 0; i < 2000; ++i) {
+        if (!tiles.empty() && rng() % 3 == 0) {
+            const auto index = rng() % tiles.size();
+            allocator.free(tiles[index]);
+            usedTexels -= (std::uint64_t)tiles[index].size * tiles[index].size;
+            tiles.erase(tiles.begin() + index);
+        } else if (const auto tile = allocator.allocate(1u << sizeDist(rng))) {
+            EXPECT_EQ(tile->x % tile->size, 0);
+            EXPECT_EQ(tile->y % tile->size, 0);
+            for (const auto& other : tiles) {
+                ASSERT_FALSE(overlap(*tile, other));
+            }
+            tiles.push_back(*tile);
+            usedTexels += (std::uint64_t)tile->size * tile->size;
+        }
+        ASSERT_EQ(allocator.getNumFreeTexels() + usedTexels, 2048 * 2048);
+    }
+}
+
+TEST(PointShadowAtlas, FaceSelectionMatchesFaceCameras)
+{
+    PointShadowAtlas atlas;
+    atlas.init({}, FAR_PLANE);
+    const auto lightPos = glm::vec3{1.f, 2.f, 10.f};
+    const auto lights = std::array{makePointLight(lightPos)};
+    atlas.update(makeCamera(), lights);
+    ASSERT_EQ(atlas.getShadowCastingLights().size(), 1);
+    const auto& light = atlas.getShadowCastingLights()[0];
+
+    std::mt19937 rng{3};
+    std::uniform_real_distribution<float> dist{-1.f, 1.f};
+    for (int i = 0; i < 1000; ++i) {
+        const auto dir = glm::vec3{dist(rng), dist(rng), dist(rng)};
+        if (glm::length(dir) < 0.01f) {
+            continue;
+        }
+        const auto face = graphics::getPointShadowFace(dir);
+        const auto& camera = light.faces[face].camera;
+        const auto p = camera.getViewProj() * glm::vec4{lightPos + glm::normalize(dir) * 3.f, 1.f};
+        EXPECT_GT(p.w, 0.f);
+        EXPECT_LE(std::abs(p.x), p.w * 1.0001f);
+        EXPECT_LE(std::abs(p.y), p.w * 1.0001f);
+    }
+}
+
+TEST(PointShadowAtlas, LightsAreRankedByScreenArea)
+{
+    PointShadowAtlas atlas;
+    auto params = PointShadowAtlas::Params{};
+    params.maxShadowCastingLights = 2;
+    atlas.init(params, FAR_PLANE);
+
+    const auto lights = std::vector{
+        makePointLight({0.f, 0.f, 30.f}),
+        makePointLight({0.f, 0.f, -10.f}), // behind the camera
+        makePointLight({0.f, 0.f, 10.f}),
+        makePointLight({3.f, 0.f, 20.f}, 15.f), // further, but bigger
+        GPULightData{.position = {0.f, 0.f, 5.f}, .type = edbr::TYPE_SPOT_LIGHT, .range = 5.f},
+    };
+    atlas.update(makeCamera(), lights);
+
+    const auto shadowCastingLights = atlas.getShadowCastingLights();
+    ASSERT_EQ(shadowCastingLights.size(), 2);
+    EXPECT_EQ(shadowCastingLights[0].lightIndex, 3);
+    EXPECT_EQ(shadowCastingLights[1].lightIndex, 2);
+    EXPECT_GT(shadowCastingLights[0].importance, shadowCastingLights[1].importance);
+}
+
+TEST(PointShadowAtlas, TileSizeDependsOnDistance)
+{
+    PointShadowAtlas atlas;
+    auto params = PointShadowAtlas::Params{
+        .maxTileSize = 512,
+        .minTileSize = 64,
+        .fullResolutionDistance = 5.f,
+        .lodHysteresis = 0.2f,
+    };
+    atlas.init(params, FAR_PLANE);
+
+    const auto getTileSize = [&atlas](float distance) {
+        const auto lights = std::array{makePointLight({0.f, 0.f, distance})};
+        atlas.update(makeCamera(), lights);
+        return atlas.getShadowCastingLights()[0].tileSize;
+    };
+
+    EXPECT_EQ(getTileSize(3.f), 512);
+    EXPECT_EQ(getTileSize(13.f), 256);
+    EXPECT_EQ(getTileSize(25.f), 128);
+    EXPECT_EQ(getTileSize(80.f), 64);
+
+    // hysteresis: 20 is the threshold between 128 and 256 (log2(20 / 5) = 2)
+    EXPECT_EQ(getTileSize(21.f), 128);
+    EXPECT_EQ(getTileSize(19.f), 128);
+    EXPECT_EQ(getTileSize(17.f), 256);
+    EXPECT_EQ(getTileSize(21.f), 256);
+    EXPECT_EQ(getTileSize(24.f), 128);
+}
+
+TEST(PointShadowAtlas, FullAtlasShrinksLessImportantLights)
+{
+    PointShadowAtlas atlas;
+    // 1024x1024 fits two lights with 256x256 faces
+    auto params = PointShadowAtlas::Params{
+        .atlasSize = 1024,
+        .maxTileSize = 256,
+        .minTileSize = 64,
+        .fullResolutionDistance = 100.f,
+    };
+    atlas.init(params, FAR_PLANE);
+
+    std::vector<GPULightData> lights;
+    for (int i = 0; i < 8; ++i) {
+        lights.push_back(makePointLight({0.f, 0.f, 5.f + (float)i}));
+    }
+    atlas.update(makeCamera(), lights);
+
+    // the last two lights don't fit even with the smallest tiles
+    const auto shadowCastingLights = atlas.getShadowCastingLights();
+    ASSERT_EQ(shadowCastingLights.size(), 6);
+    EXPECT_EQ(shadowCastingLights[0].tileSize, 256);
+    EXPECT_EQ(shadowCastingLights[1].tileSize, 256);
+    for (std::size_t i = 2; i < shadowCastingLights.size(); ++i) {
+        EXPECT_LT(shadowCastingLights[i].tileSize, 256);
+        EXPECT_LE(shadowCastingLights[i].tileSize, shadowCastingLights[i - 1].tileSize);
+    }
+    checkNoOverlaps(atlas);
+
+    // the most important light moves closer - tiles of others are evicted
+    // first, so it still gets the full resolution
+    lights.push_back(makePointLight({0.f, 0.f, 2.f}));
+    atlas.update(makeCamera(), lights);
+    EXPECT_EQ(atlas.getShadowCastingLights()[0].lightIndex, 8);
+    EXPECT_EQ(atlas.getShadowCastingLights()[0].tileSize, 256);
+    checkNoOverlaps(atlas);
+}
+
+TEST(PointShadowAtlas, FacesOutsideOfViewAreSkipped)
+{
+    PointShadowAtlas atlas;
+    atlas.init({}, FAR_PLANE);
+
+    // to the left of the 90 degree frustum: the light's sphere touches it,
+    // but the face which looks away from the frustum doesn't
+    const auto lights = std::array{makePointLight({-12.f, 0.f, 5.f}, 8.f)};
+    atlas.update(makeCamera(), lights);
+    ASSERT_EQ(atlas.getShadowCastingLights().size(), 1);
+
+    const auto& faces = atlas.getShadowCastingLights()[0].faces;
+    const auto awayFace = graphics::getPointShadowFace({-1.f, 0.f, 0.f});
+    const auto towardsFace = graphics::getPointShadowFace({1.f, 0.f, 0.f});
+    EXPECT_EQ(faces[awayFace].state, FaceState::Skipped);
+    EXPECT_EQ(faces[towardsFace].state, FaceState::Draw);
+    EXPECT_EQ(atlas.getStats().numSkippedFaces, 2); // -X and -Z
+
+    // the sphere isn't visible at all
+    const auto hiddenLights = std::array{makePointLight({-30.f, 0.f, 5.f}, 8.f)};
+    atlas.update(makeCamera(), hiddenLights);
+    EXPECT_TRUE(atlas.getShadowCastingLights().empty());
+}
+
+TEST(PointShadowAtlas, FacesAreCachedUntilCastersChange)
+{
+    PointShadowAtlas atlas;
+    atlas.init({}, FAR_PLANE);
+    const auto lights = std::array{makePointLight({0.f, 0.f, 10.f})};
+    auto drawCommands = std::vector{
+        makeCaster(1, {1.f, 0.f, 10.f}),
+        makeCaster(2, {0.f, 0.f, 12.f}),
+    };
+    const auto visible = std::vector<std::uint32_t>{0, 1};
+
+    const auto updateFace = [&]() {
+        atlas.update(makeCamera(), lights);
+        atlas.updateFaceCasters(0, 0, drawCommands, visible);
+        return atlas.getShadowCastingLights()[0].faces[0].state;
+    };
+
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Cached);
+    // faces without updateFaceCasters call are always drawn
+    EXPECT_EQ(atlas.getShadowCastingLights()[0].faces[1].state, FaceState::Draw);
+
+    // caster moved
+    drawCommands[0].transformMatrix[3].x += 0.1f;
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Cached);
+
+    // caster disappeared
+    atlas.update(makeCamera(), lights);
+    atlas.updateFaceCasters(0, 0, drawCommands, std::span{visible}.first(1));
+    EXPECT_EQ(atlas.getShadowCastingLights()[0].faces[0].state, FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Cached);
+
+    // skinned casters can change without moving
+    drawCommands[1].skinnedMesh = reinterpret_cast<const SkinnedMesh*>(&drawCommands);
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    drawCommands[1].skinnedMesh = nullptr;
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Cached);
+
+    atlas.invalidate();
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+
+    auto params = atlas.getParams();
+    params.cachingEnabled = false;
+    atlas.setParams(params);
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+    EXPECT_EQ(updateFace(), FaceState::Draw);
+}
+
+TEST(PointShadowAtlas, MovingLightIsRedrawn)
+{
+    PointShadowAtlas atlas;
+    atlas.init({}, FAR_PLANE);
+    const auto drawCommands = std::vector{makeCaster(1, {1.f, 0.f, 10.f})};
+    const auto visible = std::vector<std::uint32_t>{0};
+
+    const auto updateFace = [&](const glm::vec3& lightPos) {
+        const auto lights = std::array{makePointLight(lightPos)};
+        atlas.update(makeCamera(), lights);
+        atlas.updateFaceCasters(0, 0, drawCommands, visible);
+        return atlas.getShadowCastingLights()[0].faces[0];
+    };
+
+    const auto face = updateFace({0.f, 0.f, 10.f});
+    EXPECT_EQ(face.state, FaceState::Draw);
+    EXPECT_EQ(updateFace({0.f, 0.f, 10.f}).state, FaceState::Cached);
+
+    const auto movedFace = updateFace({0.f, 0.1f, 10.f});
+    EXPECT_EQ(movedFace.state, FaceState::Draw);
+    // tile is kept - only its contents are redrawn
+    EXPECT_EQ(movedFace.tile, face.tile);
+    EXPECT_NE(movedFace.camera.getViewProj(), face.camera.getViewProj());
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include <edbr/Graphics/DrawSortKey.h>
+#include <edbr/Util/RadixSort.h>
+
+TEST(RadixSort, MatchesStableSort)
+{
+    std::mt19937_64 rng{42};
+    std::vector<util::KeyIndex> items;
+    for (std::uint32_t i = 0; i < 10'000; ++i) {
+        // few distinct keys to check stability, some bytes are always the same
+        const auto key = (rng() % 100) << 40 | (rng() % 4);
+        items.push_back({.key = key, .index = i});
+    }
+
+    auto expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) {
+        return a.key < b.key;
+    });
+
+    std::vector<util::KeyIndex> scratch;
+    util::radixSort(items, scratch);
+    ASSERT_EQ(items.size(), expected.size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        EXPECT_EQ(items[i].key, expected[i].key);
+        EXPECT_EQ(items[i].index, expected[i].index);
+    }
+}
+
+TEST(RadixSort, SameKeys)
+{
+    std::vector<util::KeyIndex> items{{.key = 7, .index = 0}, {.key = 7, .index = 1}};
+    std::vector<util::KeyIndex> scratch;
+    util::radixSort(items, scratch);
+    EXPECT_EQ(items[0].index, 0);
+    EXPECT_EQ(items[1].index, 1);
+}
+
+TEST(DrawSortKey, OpaqueOrder)
+{
+    const auto key = [](bool skinned, MaterialId materialId, MeshId meshId, float depth) {
+        return graphics::
+            makeDrawSortKey(graphics::DrawSortPass::Opaque, skinned, materialId, meshId, 0, depth);
+    };
+
+    // same material and mesh - front to back
+    EXPECT_LT(key(false, 1, 1, 0.1f), key(false, 1, 1, 0.2f));
+    // material and mesh go before depth
+    EXPECT_LT(key(false, 1, 1, 0.9f), key(false, 1, 2, 0.1f));
+    EXPECT_LT(key(false, 1, 9, 0.1f), key(false, 2, 1, 0.1f));
+    // non-skinned meshes first
+    EXPECT_LT(key(false, 9, 9, 0.9f), key(true, 0, 0, 0.f));
+    // LODs of the same mesh are grouped (so that they can be instanced)
+    const auto lodKey = [](MeshId meshId, std::uint32_t lod, float depth) {
+        using namespace graphics;
+        return makeDrawSortKey(DrawSortPass::Opaque, false, 1, meshId, lod, depth);
+    };
+    EXPECT_LT(lodKey(1, 0, 0.9f), lodKey(1, 1, 0.1f));
+    EXPECT_LT(lodKey(1, 7, 0.9f), lodKey(2, 0, 0.1f));
+    // depth outside of [0, 1] is clamped
+    EXPECT_EQ(key(false, 1, 1, -1.f), key(false, 1, 1, 0.f));
+    EXPECT_EQ(key(false, 1, 1, 5.f), key(false, 1, 1, 1.f));
+}
+
+TEST(DrawSortKey, TransparentOrder)
+{
+    using namespace graphics;
+    const auto transparent = DrawSortPass::Transparent;
+
+    // back to front, even across materials
+    EXPECT_LT(
+        makeDrawSortKey(transparent, false, 9, 9, 0, 0.8f),
+        makeDrawSortKey(transparent, false, 0, 0, 0, 0.2f));
+    // transparent after opaque
+    EXPECT_LT(
+        makeDrawSortKey(DrawSortPass::Opaque, true, 9, 9, 0, 1.f),
+        makeDrawSortKey(transparent, false, 0, 0, 0, 1.f));
+}
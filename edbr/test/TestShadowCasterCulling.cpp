@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <edbr/Graphics/Camera.h>
+#include <edbr/Graphics/FrustumCulling.h>
+#include <edbr/Graphics/ShadowCasterCulling.h>
+#include <edbr/Graphics/ShadowMapping.h>
+
+namespace
+{
+const auto lightPosition = glm::vec3{1.f, 2.f, 3.f};
+const float lightRange = 5.f;
+
+// same as face cameras in PointShadowAtlas
+std::array<CullingVolume, 6> makePointLightFaceVolumes()
+{
+    static const std::array<std::pair<glm::vec3, glm::vec3>, 6> faceDirections{{
+        {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+        {{-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}},
+        {{0.f, -1.f, 0.f}, {0.f, 0.f, -1.f}},
+        {{0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 0.f, -1.f}, {0.f, 1.f, 0.f}},
+    }};
+    std::array<CullingVolume, 6> volumes;
+    for (std::size_t i = 0; i < 6; ++i) {
+        Camera camera;
+        camera.setHeading(glm::quatLookAt(-faceDirections[i].first, faceDirections[i].second));
+        camera.setPosition(lightPosition);
+        camera.init(glm::radians(90.f), 0.1f, 25.f, 1.f);
+        volumes[i] = edge::createPointLightFaceCasterVolume(camera, lightPosition, lightRange);
+    }
+    return volumes;
+}
+
+bool isVisible(const CullingVolume& volume, const glm::vec3& center, float radius)
+{
+    return edge::isInVolume(volume, math::Sphere{.center = center, .radius = radius});
+}
+
+// Reference: the caster at p shadows the receiver if any point on the ray
+// from p away from the light is inside the receiver frustum
+bool castsShadowBruteForce(
+    const Frustum& receiver,
+    const glm::vec3& p,
+    const glm::vec3& lightDir,
+    float radius)
+{
+    static const float step = 0.05f;
+    static const float maxDistance = 300.f;
+    for (float t = 0.f; t < maxDistance; t += step) {
+        const auto sphere = math::Sphere{.center = p - lightDir * t, .radius = radius};
+        if (edge::isInFrustum(receiver, sphere)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void checkAgainstBruteForce(const Camera& receiverCamera, const glm::vec3& lightDir)
+{
+    const auto corners = edge::calculateFrustumCornersWorldSpace(receiverCamera);
+    const auto volume = edge::createDirectionalLightCasterVolume(corners, lightDir);
+    const auto receiver = edge::createFrustumFromCamera(receiverCamera);
+
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> dist{-60.f, 60.f};
+    // points are tested with a bit of slack so that the ones on the volume's
+    // boundary don't fail because of sampling
+    static const float eps = 0.1f;
+    int numVisible = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const auto p = glm::vec3{dist(rng), dist(rng), dist(rng)};
+        if (isVisible(volume, p, 0.f)) {
+            ++numVisible;
+            EXPECT_TRUE(castsShadowBruteForce(receiver, p, lightDir, eps)) << i;
+        }
+        if (castsShadowBruteForce(receiver, p, lightDir, 0.f)) {
+            EXPECT_TRUE(isVisible(volume, p, eps)) << i;
+        }
+    }
+    EXPECT_GT(numVisible, 0);
+}
+}
+
+TEST(ShadowCasterCulling, PointLightFaceIsLimitedByRange)
+{
+    const auto volumes = makePointLightFaceVolumes();
+    const auto& posX = volumes[0];
+
+    EXPECT_TRUE(isVisible(posX, lightPosition + glm::vec3{3.f, 0.f, 0.f}, 0.5f));
+    EXPECT_TRUE(isVisible(posX, lightPosition + glm::vec3{3.f, 2.f, -2.f}, 0.5f));
+    // inside of the face camera's frustum, but out of range
+    EXPECT_FALSE(isVisible(posX, lightPosition + glm::vec3{6.f, 0.f, 0.f}, 0.5f));
+    EXPECT_FALSE(isVisible(posX, lightPosition + glm::vec3{5.f, 3.f, 0.f}, 0.5f));
+    // intersects the range sphere
+    EXPECT_TRUE(isVisible(posX, lightPosition + glm::vec3{5.3f, 0.f, 0.f}, 0.5f));
+    // other faces
+    EXPECT_FALSE(isVisible(posX, lightPosition + glm::vec3{-3.f, 0.f, 0.f}, 0.5f));
+    EXPECT_FALSE(isVisible(posX, lightPosition + glm::vec3{0.f, 3.f, 0.f}, 0.5f));
+    EXPECT_TRUE(isVisible(volumes[1], lightPosition + glm::vec3{-3.f, 0.f, 0.f}, 0.5f));
+    EXPECT_TRUE(isVisible(volumes[2], lightPosition + glm::vec3{0.f, 3.f, 0.f}, 0.5f));
+    EXPECT_TRUE(isVisible(volumes[5], lightPosition + glm::vec3{0.f, 0.f, -3.f}, 0.5f));
+}
+
+TEST(ShadowCasterCulling, PointLightFacesCoverRange)
+{
+    const auto volumes = makePointLightFaceVolumes();
+
+    std::mt19937 rng{3};
+    std::uniform_real_distribution<float> dist{-8.f, 8.f};
+    for (int i = 0; i < 10000; ++i) {
+        const auto p = lightPosition + glm::vec3{dist(rng), dist(rng), dist(rng)};
+        const auto d = glm::length(p - lightPosition);
+        if (d < 0.5f) { // too close to the faces' near planes
+            continue;
+        }
+        std::size_t numFaces = 0;
+        for (const auto& volume : volumes) {
+            if (isVisible(volume, p, 0.f)) {
+                ++numFaces;
+            }
+        }
+        if (d < lightRange) {
+            EXPECT_GE(numFaces, 1) << i;
+        } else {
+            EXPECT_EQ(numFaces, 0) << i;
+        }
+    }
+}
+
+TEST(ShadowCasterCulling, CascadeIsExtrudedTowardsLight)
+{
+    const auto lightDir = glm::normalize(glm::vec3{0.3f, 1.f, 0.2f});
+    const auto center = glm::vec3{10.f, 0.f, -5.f};
+    const float radius = 10.f;
+    const auto camera = createCSMCamera(center, radius, lightDir);
+    const auto corners = edge::calculateFrustumCornersWorldSpace(camera);
+    const auto volume = edge::createDirectionalLightCasterVolume(corners, lightDir);
+
+    // the light is parallel to the cascade's sides, so only the face which
+    // looks at the light is removed
+    EXPECT_EQ(volume.numPlanes, 5);
+
+    EXPECT_TRUE(isVisible(volume, center, 1.f));
+    // far away towards the light (behind the cascade camera)
+    EXPECT_TRUE(isVisible(volume, center + lightDir * 100.f, 1.f));
+    EXPECT_FALSE(edge::isInFrustum(
+        edge::createFrustumFromCamera(camera),
+        math::Sphere{.center = center + lightDir * 100.f, .radius = 1.f}));
+    // behind the receivers
+    EXPECT_FALSE(isVisible(volume, center - lightDir * 100.f, 1.f));
+    // to the side
+    const auto side = glm::normalize(glm::cross(lightDir, glm::vec3{0.f, 0.f, 1.f}));
+    EXPECT_FALSE(isVisible(volume, center + side * 20.f + lightDir * 50.f, 1.f));
+    EXPECT_TRUE(isVisible(volume, center + side * 9.f + lightDir * 50.f, 1.f));
+}
+
+TEST(ShadowCasterCulling, PerspectiveReceiverMatchesBruteForce)
+{
+    Camera camera;
+    camera.setPosition({0.f, 5.f, 0.f});
+    const auto front = glm::normalize(glm::vec3{1.f, -0.2f, 0.5f});
+    camera.setHeading(glm::quatLookAt(front, {0.f, 1.f, 0.f}));
+    camera.init(glm::radians(60.f), 1.f, 40.f, 16.f / 9.f);
+
+    checkAgainstBruteForce(camera, glm::normalize(glm::vec3{-0.3f, 1.f, -0.5f}));
+    checkAgainstBruteForce(camera, glm::normalize(glm::vec3{0.9f, 0.2f, 0.1f}));
+}
+
+TEST(ShadowCasterCulling, CascadeMatchesBruteForce)
+{
+    const auto lightDir = glm::normalize(glm::vec3{-0.3f, 1.f, -0.5f});
+    checkAgainstBruteForce(createCSMCamera({5.f, 0.f, 5.f}, 20.f, lightDir), lightDir);
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <edbr/Graphics/AnimationSampling.h>
+#include <edbr/Graphics/SkeletalAnimation.h>
+#include <edbr/Graphics/SkeletonAnimator.h>
+
+namespace
+{
+Skeleton makeSkeleton()
+{
+    Skeleton skeleton;
+    skeleton.joints.resize(1);
+    skeleton.hierarchy.resize(1);
+    skeleton.inverseBindMatrices.push_back(glm::mat4{1.f});
+    skeleton.flatSkeleton = graphics::makeFlatSkeleton(skeleton);
+    return skeleton;
+}
+
+// root joint stays at {x, 0, 0}
+SkeletalAnimation makeAnimation(const std::string& name, float x, float duration)
+{
+    SkeletalAnimation animation;
+    animation.name = name;
+    animation.duration = duration;
+    animation.tracks.resize(1);
+    animation.tracks[0].translations.push_back({x, 0.f, 0.f});
+    animation.soaTracks = graphics::makeSoAAnimation(animation);
+    return animation;
+}
+
+float getRootX(const SkeletonAnimator& animator)
+{
+    return animator.getJointMatrices()[ROOT_JOINT_ID][3][0];
+}
+}
+
+TEST(SkeletonAnimator, CrossFade)
+{
+    const auto skeleton = makeSkeleton();
+    const auto a = makeAnimation("A", 0.f, 1.f);
+    const auto b = makeAnimation("B", 1.f, 1.f);
+    const auto c = makeAnimation("C", 2.f, 1.f);
+
+    SkeletonAnimator animator;
+    animator.setAnimation(skeleton, a);
+    EXPECT_FLOAT_EQ(getRootX(animator), 0.f);
+
+    animator.setAnimation(skeleton, b, 1.f);
+    EXPECT_EQ(animator.getCurrentAnimationName(), "B");
+    EXPECT_FLOAT_EQ(getRootX(animator), 0.f);
+    animator.update(skeleton, 0.5f);
+    EXPECT_NEAR(getRootX(animator), 0.5f, 1e-5f);
+
+    // interrupted fade starts from the current pose
+    animator.setAnimation(skeleton, c, 1.f);
+    EXPECT_NEAR(getRootX(animator), 0.5f, 1e-5f);
+    animator.update(skeleton, 0.5f);
+    EXPECT_NEAR(getRootX(animator), 1.25f, 1e-5f);
+    animator.update(skeleton, 0.6f);
+    EXPECT_NEAR(getRootX(animator), 2.f, 1e-5f);
+
+    // no fade - switch immediately
+    animator.setAnimation(skeleton, a);
+    EXPECT_FLOAT_EQ(getRootX(animator), 0.f);
+}
+
+TEST(SkeletonAnimator, BlendSpace)
+{
+    const auto skeleton = makeSkeleton();
+    const auto idle = makeAnimation("Idle", 0.f, 2.f);
+    const auto walk = makeAnimation("Walk", 1.f, 1.f);
+    const auto run = makeAnimation("Run", 3.f, 0.5f);
+    const AnimationBlendSpace1D blendSpace{
+        .name = "Locomotion",
+        .entries = {{0.f, &idle}, {1.f, &walk}, {4.f, &run}},
+    };
+
+    SkeletonAnimator animator;
+    animator.setBlendSpace(skeleton, blendSpace);
+    EXPECT_TRUE(animator.isBlendSpacePlaying());
+
+    animator.setBlendParameter(2.5f); // halfway between Walk and Run
+    animator.update(skeleton, 0.f);
+    EXPECT_NEAR(getRootX(animator), 2.f, 1e-5f);
+
+    // playback speed is between Walk and Run: 0.75 s per cycle
+    animator.update(skeleton, 0.375f);
+    EXPECT_NEAR(animator.getNormalizedProgress(), 0.5f, 1e-5f);
+
+    animator.setBlendParameter(3.f); // Run has more weight
+    animator.update(skeleton, 0.f);
+    EXPECT_EQ(animator.getCurrentAnimationName(), "Run");
+    EXPECT_NEAR(getRootX(animator), 2.f + 1.f / 3.f, 1e-5f);
+
+    animator.setBlendParameter(10.f);
+    animator.update(skeleton, 0.f);
+    EXPECT_NEAR(getRootX(animator), 3.f, 1e-5f);
+
+    // setting the same blend space again doesn't restart it
+    animator.setBlendSpace(skeleton, blendSpace, 1.f);
+    EXPECT_NEAR(getRootX(animator), 3.f, 1e-5f);
+    EXPECT_NEAR(animator.getNormalizedProgress(), 0.5f, 1e-5f);
+}
+
+TEST(SkeletonAnimator, AdditiveLayer)
+{
+    const auto skeleton = makeSkeleton();
+    const auto base = makeAnimation("Base", 1.f, 1.f);
+
+    // moves the root by 0.3 on the second key
+    SkeletalAnimation additive;
+    additive.name = "Additive";
+    additive.duration = 1.f / graphics::ANIMATION_FPS;
+    additive.tracks.resize(1);
+    additive.tracks[0].translations = {glm::vec3{5.f, 0.f, 0.f}, glm::vec3{5.3f, 0.f, 0.f}};
+    additive.soaTracks = graphics::makeAdditiveAnimation(graphics::makeSoAAnimation(additive));
+
+    SkeletonAnimator animator;
+    animator.setAnimation(skeleton, base);
+    animator.setAdditiveLayer(0, &additive, 0.5f);
+    animator.update(skeleton, 0.5f / graphics::ANIMATION_FPS);
+    EXPECT_NEAR(getRootX(animator), 1.f + 0.15f * 0.5f, 1e-5f);
+
+    animator.setAdditiveLayerWeight(0, 0.f);
+    animator.update(skeleton, 0.f);
+    EXPECT_NEAR(getRootX(animator), 1.f, 1e-5f);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <edbr/Graphics/GPUMesh.h>
+#include <edbr/Graphics/MeshDrawCommand.h>
+#include <edbr/Graphics/SkinningJobBuilder.h>
+
+namespace
+{
+GPUMesh makeMesh(std::uint32_t numVertices, bool hasSkeleton, VkDeviceAddress address)
+{
+    GPUMesh mesh{
+        .vertexBufferAddress = address,
+        .numVertices = numVertices,
+        .hasSkeleton = hasSkeleton,
+    };
+    mesh.skinningDataBuffer.address = address + 1;
+    return mesh;
+}
+
+SkinnedMesh makeSkinnedMesh(VkDeviceAddress address)
+{
+    SkinnedMesh skinnedMesh;
+    skinnedMesh.skinnedVertexBuffer.address = address;
+    return skinnedMesh;
+}
+}
+
+TEST(SkinningJobBuilder, NoSkinnedMeshes)
+{
+    const auto meshes = std::vector{makeMesh(100, false, 1000)};
+    const auto drawCommands = std::vector<MeshDrawCommand>{{.meshId = 0}, {.meshId = 0}};
+
+    std::vector<GPUSkinningJob> jobs{{}};
+    EXPECT_EQ(graphics::buildSkinningJobs(drawCommands, meshes, jobs), 0);
+    EXPECT_TRUE(jobs.empty());
+}
+
+TEST(SkinningJobBuilder, WorkgroupRanges)
+{
+    const auto meshes = std::vector{
+        makeMesh(10, false, 1000),
+        makeMesh(256, true, 2000),
+        makeMesh(300, true, 3000),
+    };
+    auto sm1 = makeSkinnedMesh(10'000);
+    auto sm2 = makeSkinnedMesh(20'000);
+    auto sm3 = makeSkinnedMesh(30'000);
+
+    const auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 2, .skinnedMesh = &sm1, .jointMatricesStartIndex = 0},
+        {.meshId = 0},
+        {.meshId = 1, .skinnedMesh = &sm2, .jointMatricesStartIndex = 40},
+        {.meshId = 2, .skinnedMesh = &sm3, .jointMatricesStartIndex = 80},
+    };
+
+    std::vector<GPUSkinningJob> jobs;
+    // 300 vertices = 2 groups, 256 vertices = 1 group
+    EXPECT_EQ(graphics::buildSkinningJobs(drawCommands, meshes, jobs), 5);
+    ASSERT_EQ(jobs.size(), 3);
+
+    EXPECT_EQ(jobs[0].inputBuffer, 3000);
+    EXPECT_EQ(jobs[0].skinningData, 3001);
+    EXPECT_EQ(jobs[0].outputBuffer, 10'000);
+    EXPECT_EQ(jobs[0].numVertices, 300);
+    EXPECT_EQ(jobs[0].firstGroup, 0);
+
+    EXPECT_EQ(jobs[1].inputBuffer, 2000);
+    EXPECT_EQ(jobs[1].outputBuffer, 20'000);
+    EXPECT_EQ(jobs[1].jointMatricesStartIndex, 40);
+    EXPECT_EQ(jobs[1].firstGroup, 2);
+
+    EXPECT_EQ(jobs[2].outputBuffer, 30'000);
+    EXPECT_EQ(jobs[2].jointMatricesStartIndex, 80);
+    EXPECT_EQ(jobs[2].firstGroup, 3);
+}
+
+TEST(SkinningJobBuilder, CompactInputVertices)
+{
+    auto meshes = std::vector{makeMesh(100, true, 1000), makeMesh(100, true, 2000)};
+    meshes[1].vertexFormat = VertexFormat::Compact;
+    auto sm1 = makeSkinnedMesh(10'000);
+    auto sm2 = makeSkinnedMesh(20'000);
+
+    const auto drawCommands = std::vector<MeshDrawCommand>{
+        {.meshId = 0, .skinnedMesh = &sm1},
+        {.meshId = 1, .skinnedMesh = &sm2},
+    };
+
+    std::vector<GPUSkinningJob> jobs;
+    graphics::buildSkinningJobs(drawCommands, meshes, jobs);
+    ASSERT_EQ(jobs.size(), 2);
+    EXPECT_EQ(jobs[0].inputVertexFormat, VertexFormat::Full);
+    EXPECT_EQ(jobs[1].inputVertexFormat, VertexFormat::Compact);
+}
+
+TEST(SkinningJobBuilder, SkinnedMeshIsSkinnedOnce)
+{
+    const auto meshes = std::vector{makeMesh(1000, true, 1000)};
+    auto sm = makeSkinnedMesh(10'000);
+
+    const auto dc = MeshDrawCommand{.meshId = 0, .skinnedMesh = &sm};
+    const auto drawCommands = std::vector{dc, dc, dc};
+
+    std::vector<GPUSkinningJob> jobs;
+    EXPECT_EQ(graphics::buildSkinningJobs(drawCommands, meshes, jobs), 4);
+    EXPECT_EQ(jobs.size(), 1);
+}
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include <edbr/Graphics/TextureCompression.h>
+#include <edbr/Util/CookedTexture.h>
+#include <edbr/Util/Ktx2.h>
+
+namespace
+{
+std::filesystem::path getTempDir()
+{
+    const auto dir = std::filesystem::temp_directory_path() / "edbr_test_texture_compression";
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+// smooth gradients with some noise, similar to what real textures look like
+std::vector<std::uint8_t> makeTestImage(std::uint32_t width, std::uint32_t height)
+{
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> noise{-6, 6};
+    std::vector<std::uint8_t> rgba(width * height * 4);
+    for (std::uint32_t y = 0; y < height; ++y) {
+        for (std::uint32_t x = 0; x < width; ++x) {
+            auto* texel = &rgba[(y * width + x) * 4];
+            texel[0] = (std::uint8_t)std::clamp((int)(x * 255 / width) + noise(rng), 0, 255);
+            texel[1] = (std::uint8_t)std::clamp((int)(y * 255 / height) + noise(rng), 0, 255);
+            texel[2] = (std::uint8_t)std::clamp(128 + noise(rng), 0, 255);
+            texel[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+// root mean square error of the first numChannels channels
+double getRMSE(
+    const std::vector<std::uint8_t>& a,
+    const std::vector<std::uint8_t>& b,
+    int numChannels)
+{
+    double sum = 0.0;
+    for (std::size_t i = 0; i < a.size(); i += 4) {
+        for (int c = 0; c < numChannels; ++c) {
+            const auto d = (double)a[i + c] - b[i + c];
+            sum += d * d;
+        }
+    }
+    return std::sqrt(sum / (a.size() / 4 * numChannels));
+}
+}
+
+TEST(TextureCompression, SolidColorBlocks)
+{
+    const std::array<std::array<std::uint8_t, 4>, 4> colors{{
+        {0, 0, 0, 255},
+        {255, 255, 255, 255},
+        {200, 17, 93, 128},
+        {1, 254, 127, 0},
+    }};
+    for (const auto& color : colors) {
+        std::array<std::uint8_t, 64> rgba;
+        for (int t = 0; t < 16; ++t) {
+            std::copy(color.begin(), color.end(), rgba.begin() + t * 4);
+        }
+
+        std::array<std::uint8_t, 16> block;
+        graphics::encodeBC7Block(rgba, block);
+        std::array<std::uint8_t, 64> decoded;
+        ASSERT_TRUE(graphics::decodeBC7Block(block, decoded));
+        for (int i = 0; i < 64; ++i) {
+            EXPECT_NEAR(decoded[i], rgba[i], 1);
+        }
+
+        std::array<std::uint8_t, 16> values;
+        values.fill(color[0]);
+        std::array<std::uint8_t, 8> bc4Block;
+        graphics::encodeBC4Block(values, bc4Block);
+        std::array<std::uint8_t, 16> decodedValues;
+        graphics::decodeBC4Block(bc4Block, decodedValues);
+        EXPECT_EQ(decodedValues, values);
+    }
+}
+
+TEST(TextureCompression, BC4Block)
+{
+    std::array<std::uint8_t, 16> values;
+    for (int i = 0; i < 16; ++i) {
+        values[i] = (std::uint8_t)(40 + i * 7);
+    }
+    std::array<std::uint8_t, 8> block;
+    graphics::encodeBC4Block(values, block);
+    std::array<std::uint8_t, 16> decoded;
+    graphics::decodeBC4Block(block, decoded);
+    // endpoints are exact, the other values are at most half a step away
+    EXPECT_EQ(decoded[0], values[0]);
+    EXPECT_EQ(decoded[15], values[15]);
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_NEAR(decoded[i], values[i], (105 / 7) / 2 + 1);
+    }
+}
+
+TEST(TextureCompression, RejectsOtherBC7Modes)
+{
+    std::array<std::uint8_t, 16> block{};
+    block[0] = 0x01; // mode 0
+    std::array<std::uint8_t, 64> decoded;
+    EXPECT_FALSE(graphics::decodeBC7Block(block, decoded));
+}
+
+TEST(TextureCompression, ImageRoundTrip)
+{
+    // not a multiple of 4: edge blocks are partial
+    const std::uint32_t width = 37;
+    const std::uint32_t height = 22;
+    const auto rgba = makeTestImage(width, height);
+
+    struct Case {
+        graphics::BlockCompression compression;
+        std::size_t blockSize;
+        int numChannels;
+        double maxRMSE;
+    };
+    for (const auto& c : {
+             Case{graphics::BlockCompression::BC4, 8, 1, 4.0},
+             Case{graphics::BlockCompression::BC5, 16, 2, 4.0},
+             // R and G change in different directions, which can't be exactly
+             // represented by one line of mode 6 endpoints
+             Case{graphics::BlockCompression::BC7, 16, 4, 6.0},
+         }) {
+        const auto compressed = graphics::compressImage(c.compression, width, height, rgba);
+        EXPECT_EQ(compressed.size(), 10 * 6 * c.blockSize);
+        const auto decoded = graphics::decompressImage(c.compression, width, height, compressed);
+        ASSERT_EQ(decoded.size(), rgba.size());
+        EXPECT_LT(getRMSE(rgba, decoded, c.numChannels), c.maxRMSE);
+    }
+}
+
+TEST(TextureCompression, MipChain)
+{
+    const auto rgba = makeTestImage(13, 6);
+    const auto mips = graphics::generateMipChain(13, 6, rgba, graphics::MipFilter::SRGB);
+    ASSERT_EQ(mips.size(), 4); // 13x6, 6x3, 3x1, 1x1
+    EXPECT_EQ(mips[0], rgba);
+    EXPECT_EQ(mips[1].size(), 6 * 3 * 4);
+    EXPECT_EQ(mips[2].size(), 3 * 1 * 4);
+    EXPECT_EQ(mips[3].size(), 4);
+
+    // a box of four normals pointing in different directions is renormalized
+    const std::vector<std::uint8_t> normals{
+        255, 128, 128, 255, // +X
+        128, 128, 255, 255, // +Z
+        128, 128, 255, 255, // +Z
+        0, 128, 128, 255, // -X
+    };
+    const auto normalMips =
+        graphics::generateMipChain(2, 2, normals, graphics::MipFilter::NormalMap);
+    ASSERT_EQ(normalMips.size(), 2);
+    EXPECT_NEAR(normalMips[1][0], 128, 1);
+    EXPECT_NEAR(normalMips[1][1], 128, 1);
+    EXPECT_EQ(normalMips[1][2], 255);
+}
+
+TEST(TextureCompression, CookedTextureRoundTrip)
+{
+    const auto path = getTempDir() / "roundtrip.ktx2";
+    const auto rgba = makeTestImage(64, 32);
+    util::writeCookedTexture(path, util::TextureKind::Color, 64, 32, rgba);
+
+    const auto cooked = util::readCookedTexture(path);
+    ASSERT_TRUE(cooked.has_value());
+    const auto& texture = cooked->texture;
+    EXPECT_EQ(texture.format, VK_FORMAT_BC7_SRGB_BLOCK);
+    EXPECT_EQ(texture.width, 64);
+    EXPECT_EQ(texture.height, 32);
+    ASSERT_EQ(texture.mips.size(), 7);
+    EXPECT_EQ(texture.mips[0].size(), 16 * 8 * 16);
+    EXPECT_EQ(texture.mips[6].size(), 16); // 1x1 still takes a whole block
+
+    const auto& mip0 = texture.mips[0];
+    const auto decoded = graphics::decompressImage(
+        graphics::BlockCompression::BC7,
+        64,
+        32,
+        {reinterpret_cast<const std::uint8_t*>(mip0.data()), mip0.size()});
+    EXPECT_LT(getRMSE(rgba, decoded, 4), 4.0);
+
+    EXPECT_TRUE(util::isCookedTextureCompatible(texture.format, VK_FORMAT_R8G8B8A8_SRGB, {}));
+    EXPECT_FALSE(util::isCookedTextureCompatible(texture.format, VK_FORMAT_R8G8B8A8_UNORM, {}));
+}
+
+TEST(TextureCompression, CookedTextureMustMatchRequestedKind)
+{
+    const auto dir = getTempDir();
+    const auto path = dir / "normal.ktx2";
+    util::writeCookedTexture(path, util::TextureKind::NormalMap, 16, 16, makeTestImage(16, 16));
+    const auto cooked = util::readCookedTexture(path);
+    ASSERT_TRUE(cooked.has_value());
+    const auto format = cooked->texture.format;
+    ASSERT_EQ(format, VK_FORMAT_BC5_UNORM_BLOCK);
+
+    // plain RGBA images can't be replaced by two-channel normal maps
+    EXPECT_FALSE(util::isCookedTextureCompatible(format, VK_FORMAT_R8G8B8A8_UNORM, {}));
+    EXPECT_FALSE(util::isCookedTextureCompatible(
+        format, VK_FORMAT_R8G8B8A8_UNORM, util::TextureKind::Linear));
+    EXPECT_FALSE(util::isCookedTextureCompatible(
+        format, VK_FORMAT_R8G8B8A8_UNORM, util::TextureKind::SingleChannel));
+    EXPECT_TRUE(util::isCookedTextureCompatible(
+        format, VK_FORMAT_R8G8B8A8_UNORM, util::TextureKind::NormalMap));
+    // normal maps are never sampled as sRGB
+    EXPECT_FALSE(util::isCookedTextureCompatible(
+        format, VK_FORMAT_R8G8B8A8_SRGB, util::TextureKind::NormalMap));
+}
+
+TEST(TextureCompression, RejectsBadKtx2Files)
+{
+    const auto dir = getTempDir();
+    const auto path = dir / "bad.ktx2";
+    EXPECT_FALSE(util::readCookedTexture(dir / "missing.ktx2").has_value());
+
+    const auto rgba = makeTestImage(16, 16);
+    util::writeCookedTexture(path, util::TextureKind::NormalMap, 16, 16, rgba);
+    ASSERT_TRUE(util::readCookedTexture(path).has_value());
+
+    // truncated
+    const auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 8);
+    EXPECT_FALSE(util::readCookedTexture(path).has_value());
+
+    // bad identifier
+    util::writeCookedTexture(path, util::TextureKind::NormalMap, 16, 16, rgba);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(1);
+        file.put('X');
+    }
+    EXPECT_FALSE(util::readCookedTexture(path).has_value());
+
+    // unsupported format
+    util::writeCookedTexture(path, util::TextureKind::NormalMap, 16, 16, rgba);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(12);
+        const std::uint32_t format = 1000;
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    }
+    EXPECT_FALSE(util::readCookedTexture(path).has_value());
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <glm/geometric.hpp>
+
+#include <edbr/Graphics/VertexQuantization.h>
+
+namespace
+{
+glm::vec3 randomUnitVector(std::mt19937& rng)
+{
+    std::normal_distribution<float> dist;
+    glm::vec3 v;
+    do {
+        v = {dist(rng), dist(rng), dist(rng)};
+    } while (glm::length(v) < 1e-3f);
+    return glm::normalize(v);
+}
+
+float angleBetween(const glm::vec3& a, const glm::vec3& b)
+{
+    // acos is too imprecise for tiny angles
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+std::vector<CPUMesh::Vertex> makeRandomVertices(std::size_t numVertices)
+{
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> posDist{-20.f, 35.f};
+    std::uniform_real_distribution<float> uvDist{0.f, 1.f};
+
+    std::vector<CPUMesh::Vertex> vertices(numVertices);
+    for (auto& v : vertices) {
+        v.position = {posDist(rng), posDist(rng) * 0.1f, posDist(rng)};
+        v.uv_x = uvDist(rng);
+        v.uv_y = uvDist(rng);
+        v.normal = randomUnitVector(rng);
+        // glTF tangents are orthogonal to normals
+        const auto t = glm::normalize(glm::cross(v.normal, randomUnitVector(rng)));
+        v.tangent = glm::vec4{t, uvDist(rng) < 0.5f ? -1.f : 1.f};
+    }
+    return vertices;
+}
+}
+
+TEST(VertexQuantization, OctahedralRoundTrip)
+{
+    std::mt19937 rng{1};
+    for (int i = 0; i < 10'000; ++i) {
+        const auto n = randomUnitVector(rng);
+        const auto e = graphics::encodeOctahedral(n);
+        EXPECT_LE(std::abs(e.x), 1.f);
+        EXPECT_LE(std::abs(e.y), 1.f);
+        EXPECT_LT(angleBetween(graphics::decodeOctahedral(e), n), 1e-3f);
+    }
+
+    // axes and the folded edges of the lower hemisphere
+    for (const auto& n : {
+             glm::vec3{1.f, 0.f, 0.f},
+             glm::vec3{0.f, -1.f, 0.f},
+             glm::vec3{0.f, 0.f, 1.f},
+             glm::vec3{0.f, 0.f, -1.f},
+             glm::normalize(glm::vec3{-1.f, 1.f, -1.f}),
+         }) {
+        const auto decoded = graphics::decodeOctahedral(graphics::encodeOctahedral(n));
+        EXPECT_LT(angleBetween(decoded, n), 1e-3f);
+    }
+}
+
+TEST(VertexQuantization, VertexErrorBounds)
+{
+    const auto vertices = makeRandomVertices(10'000);
+    const auto mesh = graphics::encodeCompactMesh(vertices, {});
+    ASSERT_EQ(mesh.vertices.size(), vertices.size());
+
+    const auto& scale = mesh.header.positionScale;
+    // half of the quantization step on each axis
+    const auto maxPosError = scale / 65535.f * 0.5f + 1e-5f;
+
+    float maxNormalAngle = 0.f;
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        const auto& v = vertices[i];
+        const auto decoded = graphics::decodeCompactVertex(mesh.vertices[i], mesh.header);
+
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_LE(std::abs(decoded.position[c] - v.position[c]), maxPosError[c]);
+        }
+        // half floats have an 11-bit significand
+        EXPECT_NEAR(decoded.uv_x, v.uv_x, 1.f / 2048.f);
+        EXPECT_NEAR(decoded.uv_y, v.uv_y, 1.f / 2048.f);
+
+        maxNormalAngle = std::max(maxNormalAngle, angleBetween(decoded.normal, v.normal));
+        maxNormalAngle = std::max(
+            maxNormalAngle, angleBetween(glm::vec3{decoded.tangent}, glm::vec3{v.tangent}));
+        EXPECT_EQ(decoded.tangent.w, v.tangent.w);
+    }
+    // about 0.02 degrees (tangent error includes the error of the normal)
+    EXPECT_LT(maxNormalAngle, 4e-4f);
+}
+
+TEST(VertexQuantization, TangentRoundTrip)
+{
+    std::mt19937 rng{3};
+    for (int i = 0; i < 10'000; ++i) {
+        const auto n = randomUnitVector(rng);
+        const auto t = glm::vec4{
+            glm::normalize(glm::cross(n, randomUnitVector(rng))),
+            i % 2 == 0 ? 1.f : -1.f,
+        };
+        const auto decoded = graphics::decodeTangent(n, graphics::encodeTangent(n, t));
+        EXPECT_EQ(decoded.w, t.w);
+        // 15 bits per full turn
+        EXPECT_LT(angleBetween(glm::vec3{decoded}, glm::vec3{t}), 2e-4f);
+        EXPECT_NEAR(glm::dot(glm::vec3{decoded}, n), 0.f, 1e-5f);
+    }
+}
+
+TEST(VertexQuantization, CompactVertexSize)
+{
+    EXPECT_EQ(sizeof(graphics::CompactVertex) * 3, sizeof(CPUMesh::Vertex));
+    EXPECT_LT(sizeof(graphics::CompactSkinningData) * 2, sizeof(CPUMesh::SkinningData));
+}
+
+TEST(VertexQuantization, FlatMesh)
+{
+    // all vertices lie on the y = 3 plane, so the AABB has no height
+    auto vertices = makeRandomVertices(100);
+    for (auto& v : vertices) {
+        v.position.y = 3.f;
+    }
+    const auto mesh = graphics::encodeCompactMesh(vertices, {});
+    EXPECT_EQ(mesh.header.positionScale.y, 0.f);
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        const auto decoded = graphics::decodeCompactVertex(mesh.vertices[i], mesh.header);
+        EXPECT_EQ(decoded.position.y, 3.f);
+        EXPECT_FALSE(std::isnan(decoded.position.x));
+    }
+}
+
+TEST(VertexQuantization, ZeroTangent)
+{
+    auto vertex = makeRandomVertices(1)[0];
+    vertex.tangent = glm::vec4{0.f, 0.f, 0.f, 1.f};
+    const auto header = graphics::makeCompactVertexHeader(std::span{&vertex, 1});
+    const auto decoded =
+        graphics::decodeCompactVertex(graphics::encodeCompactVertex(vertex, header), header);
+    EXPECT_FALSE(std::isnan(decoded.tangent.x));
+    EXPECT_NEAR(glm::length(glm::vec3{decoded.tangent}), 1.f, 1e-4f);
+}
+
+TEST(VertexQuantization, SkinningWeightsSumToOne)
+{
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> weightDist{0.f, 1.f};
+    std::uniform_int_distribution<std::uint32_t> jointDist{0, 255};
+
+    for (int i = 0; i < 10'000; ++i) {
+        auto sd = CPUMesh::SkinningData{
+            .jointIds = {jointDist(rng), jointDist(rng), jointDist(rng), jointDist(rng)},
+            .weights = {weightDist(rng), weightDist(rng), weightDist(rng), weightDist(rng)},
+        };
+        if (i % 3 == 0) {
+            sd.weights.z = 0.f;
+            sd.weights.w = 0.f;
+        }
+        sd.weights /= sd.weights.x + sd.weights.y + sd.weights.z + sd.weights.w;
+
+        const auto compact = graphics::encodeCompactSkinningData(sd);
+        std::uint32_t sum = 0;
+        for (const auto w : compact.weights) {
+            sum += w;
+        }
+        EXPECT_EQ(sum, 65535);
+
+        const auto decoded = graphics::decodeCompactSkinningData(compact);
+        EXPECT_EQ(decoded.jointIds, sd.jointIds);
+        for (int c = 0; c < 4; ++c) {
+            EXPECT_NEAR(decoded.weights[c], sd.weights[c], 2.f / 65535.f);
+        }
+    }
+}
+
+TEST(VertexQuantization, CompactSkinningDataJointLimit)
+{
+    auto skinningData = std::vector<CPUMesh::SkinningData>(2);
+    skinningData[0].jointIds = {0, 1, 2, 255};
+    EXPECT_TRUE(graphics::canUseCompactSkinningData(skinningData));
+    skinningData[1].jointIds = {0, 256, 0, 0};
+    EXPECT_FALSE(graphics::canUseCompactSkinningData(skinningData));
+}
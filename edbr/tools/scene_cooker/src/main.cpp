@@ -0,0 +1,114 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include <CLI/CLI.hpp>
+
+#include <edbr/Graphics/MeshOptimization.h>
+#include <edbr/Util/CookedScene.h>
+#include <edbr/Util/GltfLoader.h>
+
+namespace
+{
+bool isGltfFile(const std::filesystem::path& p)
+{
+    return p.extension() == ".gltf";
+}
+
+bool cookScene(const std::filesystem::path& path, bool force)
+{
+    if (!force && util::isCookedSceneUpToDate(path)) {
+        return true;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto cookedPath = util::getCookedScenePath(path);
+    // ACMR of the whole scene (transformed vertices per triangle)
+    std::size_t numTriangles = 0;
+    std::size_t numTransformedBefore = 0;
+    std::size_t numTransformedAfter = 0;
+    // triangles of the last LOD of each mesh
+    std::size_t numLowestLODTriangles = 0;
+    std::size_t numLODs = 0;
+    // triangles of meshes which were split into meshlets
+    std::size_t numMeshletTriangles = 0;
+    std::size_t numMeshlets = 0;
+    try {
+        const auto sceneData = util::loadGltfSceneData(path);
+        for (const auto& primitives : sceneData.meshes) {
+            for (const auto& primitive : primitives) {
+                const auto& stats = primitive.optimizationStats;
+                numTriangles += primitive.mesh.indices.size() / 3;
+                numTransformedBefore += stats.cacheBefore.numTransformedVertices;
+                numTransformedAfter += stats.cacheAfter.numTransformedVertices;
+                const auto& lods = primitive.mesh.lods;
+                numLODs += lods.size();
+                const auto& lowestLOD = lods.empty() ? primitive.mesh.indices : lods.back().indices;
+                numLowestLODTriangles += lowestLOD.size() / 3;
+                const auto& meshlets = primitive.mesh.meshlets;
+                numMeshlets += meshlets.size();
+                if (!meshlets.empty()) {
+                    numMeshletTriangles += primitive.mesh.indices.size() / 3;
+                }
+            }
+        }
+        util::writeCookedScene(cookedPath, sceneData);
+    } catch (const std::exception& e) {
+        std::cout << "failed to cook " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+
+    const auto ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    std::cout << "cooked " << cookedPath << " (" << std::filesystem::file_size(cookedPath)
+              << " bytes, " << ms << " ms)" << std::endl;
+    if (numTriangles > 0) {
+        std::cout << "  ACMR: " << (float)numTransformedBefore / (float)numTriangles << " -> "
+                  << (float)numTransformedAfter / (float)numTriangles << std::endl;
+        std::cout << "  LODs: " << numLODs << ", triangles: " << numTriangles << " -> "
+                  << numLowestLODTriangles << " (lowest LODs)" << std::endl;
+    }
+    if (numMeshlets > 0) {
+        std::cout << "  meshlets: " << numMeshlets << ", "
+                  << (float)numMeshletTriangles / (float)numMeshlets << " triangles per meshlet"
+                  << std::endl;
+    }
+    return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+    CLI::App app{
+        "scene_cooker - a tool for converting .gltf scenes to binary .edbrscene files which "
+        "are loaded by SceneCache instead of .gltf files (only outdated files are cooked)"};
+    argv = app.ensure_utf8(argv);
+
+    std::string in;
+    bool force{false};
+
+    app.add_option("in", in, "Input .gltf file or directory");
+    app.add_flag("-f,--force", force, "Cook all files, even if they're up to date");
+    app.validate_positionals();
+
+    CLI11_PARSE(app, argc, argv);
+
+    if (in.empty()) {
+        std::cout << "usage: scene_cooker [--force] IN_FILE_OR_DIR\n";
+        std::exit(1);
+    }
+
+    bool ok = true;
+    if (std::filesystem::is_directory(in)) {
+        for (const auto& p : std::filesystem::recursive_directory_iterator(in)) {
+            if (std::filesystem::is_regular_file(p) && isGltfFile(p.path())) {
+                ok = cookScene(p.path(), force) && ok;
+            }
+        }
+    } else {
+        ok = cookScene(in, force);
+    }
+
+    return ok ? 0 : 1;
+}
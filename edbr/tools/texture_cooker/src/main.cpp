@@ -0,0 +1,126 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+#include <CLI/CLI.hpp>
+
+#include <edbr/Graphics/Scene.h>
+#include <edbr/Util/CookedTexture.h>
+#include <edbr/Util/GltfLoader.h>
+
+namespace
+{
+bool isGltfFile(const std::filesystem::path& p)
+{
+    return p.extension() == ".gltf";
+}
+
+bool cookTexture(const std::filesystem::path& path, util::TextureKind kind, bool force)
+{
+    if (!force && util::isCookedTextureUpToDate(path)) {
+        return true;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto cookedPath = util::getCookedTexturePath(path);
+    try {
+        util::cookTexture(path, kind);
+    } catch (const std::exception& e) {
+        std::cout << "failed to cook " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+
+    const auto ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    std::cout << "cooked " << cookedPath << " (" << std::filesystem::file_size(cookedPath)
+              << " bytes, " << ms << " ms)" << std::endl;
+    return true;
+}
+
+// the kind of each texture is decided by the material slot which uses it
+void collectSceneTextures(
+    const std::filesystem::path& gltfPath,
+    std::map<std::filesystem::path, util::TextureKind>& textures)
+{
+    const auto addTexture = [&textures](const std::filesystem::path& p, util::TextureKind kind) {
+        if (p.empty()) {
+            return;
+        }
+        const auto [it, inserted] = textures.emplace(p, kind);
+        if (!inserted && it->second != kind) {
+            std::cout << "warning: " << p << " is used in different material slots" << std::endl;
+        }
+    };
+
+    const auto sceneData = util::loadGltfSceneData(gltfPath);
+    for (const auto& material : sceneData.materials) {
+        addTexture(material.diffuseTexture, util::TextureKind::Color);
+        addTexture(material.normalMapTexture, util::TextureKind::NormalMap);
+        addTexture(material.metallicRoughnessTexture, util::TextureKind::Linear);
+        addTexture(material.emissiveTexture, util::TextureKind::Color);
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    CLI::App app{
+        "texture_cooker - a tool for compressing textures into .ktx2 files with all mips "
+        "which are loaded by GfxDevice instead of the source images (only outdated files "
+        "are cooked)"};
+    argv = app.ensure_utf8(argv);
+
+    std::string in;
+    bool force{false};
+    util::TextureKind kind{util::TextureKind::Color};
+    const std::map<std::string, util::TextureKind> kinds{
+        {"color", util::TextureKind::Color},
+        {"linear", util::TextureKind::Linear},
+        {"normal", util::TextureKind::NormalMap},
+        {"single", util::TextureKind::SingleChannel},
+    };
+
+    app.add_option(
+        "in",
+        in,
+        "Input image, .gltf file or directory (textures of all materials of .gltf files are "
+        "cooked)");
+    app.add_flag("-f,--force", force, "Cook all files, even if they're up to date");
+    app.add_option("-t,--type", kind, "Texture type (only used for image files)")
+        ->transform(CLI::CheckedTransformer(kinds, CLI::ignore_case));
+    app.validate_positionals();
+
+    CLI11_PARSE(app, argc, argv);
+
+    if (in.empty()) {
+        std::cout << "usage: texture_cooker [--force] [--type TYPE] IN_FILE_OR_DIR\n";
+        std::exit(1);
+    }
+
+    std::map<std::filesystem::path, util::TextureKind> textures;
+    try {
+        if (std::filesystem::is_directory(in)) {
+            for (const auto& p : std::filesystem::recursive_directory_iterator(in)) {
+                if (std::filesystem::is_regular_file(p) && isGltfFile(p.path())) {
+                    collectSceneTextures(p.path(), textures);
+                }
+            }
+        } else if (isGltfFile(in)) {
+            collectSceneTextures(in, textures);
+        } else {
+            textures.emplace(in, kind);
+        }
+    } catch (const std::exception& e) {
+        std::cout << "failed to load " << in << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    for (const auto& [path, textureKind] : textures) {
+        ok = cookTexture(path, textureKind, force) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -34,8 +34,8 @@ struct SkeletonComponent {
     std::vector<SkinnedMesh> skinnedMeshes;
     SkeletonAnimator skeletonAnimator;
 
-    // pointer to the animations stored in SkeletalAnimationCache
-    const std::unordered_map<std::string, SkeletalAnimation>* animations{nullptr};
+    // Idle/Walk/Run by movement speed (only set for the player)
+    AnimationBlendSpace1D locomotionBlendSpace;
 
     int skinId{-1}; // reference to skin id from the glTF scene
 };
@@ -10,6 +10,7 @@
 #include <edbr/ECS/Components/TransformComponent.h>
 
 #include <edbr/Event/EventManager.h>
+#include <edbr/Graphics/SkeletalAnimationCache.h>
 
 namespace entityutil
 {
@@ -21,6 +22,13 @@ void setEventManager(EventManager& em)
     eventManager = &em;
 }
 
+SkeletalAnimationCache* animationCache{nullptr};
+
+void setAnimationCache(SkeletalAnimationCache& ac)
+{
+    animationCache = &ac;
+}
+
 void addChild(entt::handle parent, entt::handle child)
 {
     auto& parentHC = parent.get<HierarchyComponent>();
@@ -100,15 +108,20 @@ void rotateSmoothlyTo(entt::handle e, const glm::quat& targetHeading, float rota
     mc.rotationProgress = 0.f;
 }
 
-void setAnimation(entt::handle e, const std::string& name)
+const SkeletalAnimation& getAnimation(entt::handle e, const std::string& name)
+{
+    assert(animationCache);
+    return animationCache->getAnimation(e.get<SceneComponent>().sceneName, name);
+}
+
+void setAnimation(entt::handle e, const std::string& name, float fadeDuration)
 {
     auto scPtr = e.try_get<SkeletonComponent>();
     if (!scPtr) {
         return;
     }
     auto& sc = *scPtr;
-    assert(sc.animations);
-    sc.skeletonAnimator.setAnimation(sc.skeleton, sc.animations->at(name));
+    sc.skeletonAnimator.setAnimation(sc.skeleton, getAnimation(e, name), fadeDuration);
 }
 
 entt::handle findEntityBySceneNodeName(entt::registry& registry, const std::string& name)
@@ -14,11 +14,15 @@
 #include <edbr/GameCommon/EntityUtil.h>
 
 class EventManager;
+class SkeletalAnimationCache;
+struct SkeletalAnimation;
 
 namespace entityutil
 {
 // allows to send events from any function without carrying event manager around
 void setEventManager(EventManager& eventManager);
+// animations of entities are taken from this cache (see getAnimation)
+void setAnimationCache(SkeletalAnimationCache& animationCache);
 
 void addChild(entt::handle parent, entt::handle child);
 glm::vec3 getWorldPosition(entt::handle e);
@@ -29,7 +33,10 @@ void setPosition(entt::handle e, const glm::vec3& pos);
 void teleportEntity(entt::handle e, const glm::vec3& pos);
 void setRotation(entt::handle e, const glm::quat& rotation);
 void rotateSmoothlyTo(entt::handle e, const glm::quat& targetHeading, float rotationTime);
-void setAnimation(entt::handle e, const std::string& name);
+// returns the animation from the entity's scene shared by all entities
+const SkeletalAnimation& getAnimation(entt::handle e, const std::string& name);
+// if fadeDuration > 0, the current animation is cross-faded into the new one
+void setAnimation(entt::handle e, const std::string& name, float fadeDuration = 0.f);
 
 // Find entity by glTF scene node name - pretty slow
 entt::handle findEntityBySceneNodeName(entt::registry& registry, const std::string& name);
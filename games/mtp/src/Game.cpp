@@ -11,11 +11,13 @@
 
 #include <edbr/ECS/Components/HierarchyComponent.h>
 #include <edbr/ECS/Components/MetaInfoComponent.h>
+#include <edbr/ECS/Components/MovementComponent.h>
 #include <edbr/ECS/Components/NPCComponent.h>
 #include <edbr/ECS/Components/PersistentComponent.h>
 #include <edbr/ECS/Components/SceneComponent.h>
 #include <edbr/ECS/Components/TagComponent.h>
 #include <edbr/ECS/Components/TransformComponent.h>
+#include <edbr/ECS/ParallelForEach.h>
 
 #include <edbr/ECS/Systems/MovementSystem.h>
 #include <edbr/ECS/Systems/TransformSystem.h>
@@ -37,10 +39,20 @@
 
 namespace eu = entityutil;
 
+namespace
+{
+// draw ids are stable between frames: the entity's version changes when
+// its id is reused
+DrawId getDrawId(entt::entity e, std::size_t meshIndex)
+{
+    return ((DrawId)entt::to_integral(e) << 32) | (DrawId)meshIndex;
+}
+}
+
 Game::Game() :
     Application(),
-    renderer(meshCache, materialCache),
-    sceneCache(gfxDevice, meshCache, materialCache, animationCache),
+    renderer(meshCache, materialCache, jobSystem),
+    sceneCache(gfxDevice, meshCache, materialCache, animationCache, taskQueue),
     entityCreator(registry, "static_geometry", entityFactory, sceneCache),
     cameraManager(actionListManager),
     ui(actionListManager)
@@ -84,6 +96,8 @@ void Game::customInit()
     skyboxDir = "assets/images/skybox";
 
     materialCache.init(gfxDevice);
+    // vertices take a third of the memory and bandwidth, see VertexQuantization.h
+    meshCache.setVertexFormat(VertexFormat::Compact);
     renderer.init(gfxDevice, params.renderSize);
     spriteRenderer.init(gfxDevice, renderer.getDrawImageFormat());
 
@@ -97,6 +111,7 @@ void Game::customInit()
     registerComponentDisplayers();
     entityCreator.setPostInitEntityFunc([this](entt::handle e) { entityPostInit(e); });
     eu::setEventManager(eventManager);
+    eu::setAnimationCache(animationCache);
 
     { // physics
         PhysicsSystem::InitStaticObjects();
@@ -322,6 +337,8 @@ void Game::customUpdate(float dt)
         devToolsNewFrame(dt);
     }
 
+    sceneCache.update();
+
     // changeLevel loads level with a delay so that the call to it
     // in the middle of the frame doesn't lead to unexpected results
     if (!newLevelToLoad.empty()) {
@@ -404,7 +421,7 @@ void Game::updateGameLogic(float dt)
     if (auto player = entityutil::getPlayerEntity(registry); player.entity() != entt::null) {
         playerAnimationSystemUpdate(player, *physicsSystem, dt);
     }
-    skeletonAnimationSystemUpdate(registry, eventManager, dt);
+    skeletonAnimationSystem.update(registry, eventManager, jobSystem, dt);
     blinkSystemUpdate(registry, dt);
 
     // camera update
@@ -640,14 +657,33 @@ void Game::generateDrawList()
     const auto staticMeshes = registry.view<TransformComponent, MeshComponent>(
         entt::
             exclude<SkeletonComponent, TriggerComponent, ColliderComponent, PlayerSpawnComponent>);
-    for (const auto&& [e, tc, mc] : staticMeshes.each()) {
-        for (std::size_t i = 0; i < mc.meshes.size(); ++i) {
-            const auto meshTransform = mc.meshTransforms[i].isIdentity() ?
-                                           tc.worldTransform :
-                                           tc.worldTransform * mc.meshTransforms[i].asMatrix();
-            renderer.drawMesh(mc.meshes[i], meshTransform, mc.meshMaterials[i], mc.castShadow);
-        }
-    }
+    static const std::size_t chunkSize = 256;
+    edbr::ecs::parallelForEach(
+        jobSystem,
+        staticMeshes,
+        drawListEntities,
+        chunkSize,
+        [this, &staticMeshes](entt::entity e, std::size_t threadIndex) {
+            const auto& [tc, mc] = staticMeshes.get<TransformComponent, MeshComponent>(e);
+            // entities without physics bodies can still be moved by scripts,
+            // the renderer detects this (see CSMCache)
+            const auto* pc = registry.try_get<PhysicsComponent>(e);
+            const auto isStatic = (!pc || pc->type == PhysicsComponent::Type::Static) &&
+                                  !registry.all_of<MovementComponent>(e);
+            for (std::size_t i = 0; i < mc.meshes.size(); ++i) {
+                const auto meshTransform = mc.meshTransforms[i].isIdentity() ?
+                                               tc.worldTransform :
+                                               tc.worldTransform * mc.meshTransforms[i].asMatrix();
+                renderer.drawMeshParallel(
+                    threadIndex,
+                    mc.meshes[i],
+                    meshTransform,
+                    mc.meshMaterials[i],
+                    mc.castShadow,
+                    isStatic,
+                    getDrawId(e, i));
+            }
+        });
 
     // render meshes with skeletal animation
     const auto skinnedMeshes =
@@ -661,7 +697,8 @@ void Game::generateDrawList()
                 tc.worldTransform,
                 mc.meshMaterials[i],
                 sc.skinnedMeshes[i],
-                jointMatricesStartIndex);
+                jointMatricesStartIndex,
+                getDrawId(e, i));
         }
 #ifndef NDEBUG
         // 1. Not all meshes for the entity might be skinned
@@ -674,7 +711,7 @@ void Game::generateDrawList()
 #endif
     }
 
-    renderer.endDrawing();
+    renderer.endDrawing(camera);
 
     // UI
     {
@@ -767,6 +804,9 @@ void Game::doLevelChange()
     const auto levelToLoad = newLevelToLoad;
     const auto spawnName = newLevelSpawnName;
 
+    // the scene is loaded in background while the previous level fades out
+    const auto sceneLoad = loadLevelSceneAsync(levelToLoad);
+
     auto levelTransition = ActionList(levelTransitionListName);
 
     bool hasPreviousLevel = !level.getName().empty();
@@ -775,6 +815,9 @@ void Game::doLevelChange()
     }
 
     levelTransition.addActions(
+        waitWhile(
+            "Wait for level scene",
+            [sceneLoad](float) { return sceneLoad.isValid() && !sceneLoad.isDone(); }),
         doNamed(
             "Spawn player",
             [this, levelToLoad, spawnName] {
@@ -795,6 +838,18 @@ void Game::doLevelChange()
     newLevelSpawnName.clear();
 }
 
+SceneLoadHandle Game::loadLevelSceneAsync(const std::filesystem::path& levelPath)
+{
+    if (!std::filesystem::exists(levelPath)) {
+        // levels loaded from models in dev environment are loaded in loadLevel
+        return {};
+    }
+
+    Level nextLevel;
+    nextLevel.load(levelPath);
+    return sceneCache.loadSceneAsync(nextLevel.getSceneModelPath());
+}
+
 ActionList Game::enterLevel(LevelTransitionType ltt)
 {
     using namespace actions;
@@ -36,6 +36,7 @@
 #include "AnimationSoundSystem.h"
 #include "LevelScript.h"
 #include "PhysicsSystem.h"
+#include "SkeletonAnimationSystem.h"
 
 class ComponentFactory;
 class FollowCameraController;
@@ -78,6 +79,7 @@ public:
         const std::string& spawnName = {},
         LevelTransitionType ltt = LevelTransitionType::Teleport);
     void doLevelChange();
+    SceneLoadHandle loadLevelSceneAsync(const std::filesystem::path& levelPath);
     ActionList enterLevel(LevelTransitionType ltt);
     ActionList exitLevel(LevelTransitionType ltt);
 
@@ -183,11 +185,13 @@ private:
     SkeletalAnimationCache animationCache;
 
     entt::registry registry;
+    std::vector<entt::entity> drawListEntities; // for parallel draw list generation
     EntityFactory entityFactory;
     EntityCreator entityCreator;
 
     std::unique_ptr<PhysicsSystem> physicsSystem;
     AnimationSoundSystem animationSoundSystem;
+    SkeletonAnimationSystem skeletonAnimationSystem;
 
     std::filesystem::path skyboxDir;
 
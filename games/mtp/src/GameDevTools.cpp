@@ -337,7 +337,7 @@ void Game::devToolsUpdate(float dt)
     ImGui::End();
 
     const auto& imageCache = gfxDevice.getImageCache();
-    resourcesInspector.update(dt, imageCache, materialCache);
+    resourcesInspector.update(dt, imageCache, materialCache, animationCache);
 
     if (entityTreeView.hasSelectedEntity()) {
         if (ImGui::Begin("Selected entity")) {
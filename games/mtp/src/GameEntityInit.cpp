@@ -106,7 +106,6 @@ void Game::initEntityAnimation(entt::handle e)
     const auto& scene = sceneCache.loadOrGetScene(scc.sceneName);
 
     sc.skeleton = scene.skeletons[sc.skinId];
-    sc.animations = &animationCache.getAnimations(scc.sceneName);
 
     auto& mc = e.get<MeshComponent>();
     sc.skinnedMeshes.reserve(mc.meshes.size());
@@ -120,7 +119,7 @@ void Game::initEntityAnimation(entt::handle e)
         sc.skinnedMeshes.push_back(sm);
     }
 
-    if (sc.animations->contains("Idle")) {
-        sc.skeletonAnimator.setAnimation(sc.skeleton, sc.animations->at("Idle"));
+    if (animationCache.hasAnimation(scc.sceneName, "Idle")) {
+        sc.skeletonAnimator.setAnimation(sc.skeleton, entityutil::getAnimation(e, "Idle"));
     }
 }
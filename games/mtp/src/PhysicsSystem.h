@@ -189,6 +189,7 @@ public:
     glm::vec3 getCharacterPosition() const;
     glm::vec3 getCharacterVelocity() const;
     bool isCharacterOnGround() const;
+    const VirtualCharacterParams& getCharacterParams() const { return characterParams; }
 
     // creates entity physics body
     void addEntity(entt::handle e, SceneCache& sceneCache);
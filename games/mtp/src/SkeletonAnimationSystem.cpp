@@ -0,0 +1,66 @@
+#include "SkeletonAnimationSystem.h"
+
+#include <algorithm>
+
+#include <edbr/Core/JobSystem.h>
+#include <edbr/Event/EventManager.h>
+#include <edbr/Graphics/SkeletalAnimation.h>
+
+#include "Components.h"
+#include "Events.h"
+
+#include <tracy/Tracy.hpp>
+
+void SkeletonAnimationSystem::update(
+    entt::registry& registry,
+    EventManager& em,
+    JobSystem& jobSystem,
+    float dt)
+{
+    ZoneScopedN("Skeleton animation");
+
+    const auto view = registry.view<SkeletonComponent>();
+    entities.clear();
+    for (const auto e : view) {
+        entities.push_back(e);
+    }
+
+    threadEvents.reset(jobSystem.getNumThreads());
+    static const std::size_t batchSize = 16;
+    jobSystem.parallelFor(
+        entities.size(),
+        batchSize,
+        [this, &view, dt](std::size_t begin, std::size_t end, std::size_t threadIndex) {
+            auto& out = threadEvents.get(threadIndex);
+            for (std::size_t i = begin; i < end; ++i) {
+                auto& sc = view.get<SkeletonComponent>(entities[i]);
+                auto& animator = sc.skeletonAnimator;
+                animator.update(sc.skeleton, dt);
+                if (!animator.hasFrameChanged()) {
+                    continue;
+                }
+
+                const auto& animation = *animator.getAnimation();
+                for (const auto& eventName :
+                     animation.getEventsForFrame(animator.getCurrentFrame())) {
+                    out.push_back({.entityIndex = (std::uint32_t)i, .event = &eventName});
+                }
+            }
+        });
+
+    // batches are picked up by threads in any order - sort events by entity
+    // (stable sort, so that events of one entity stay in the same order)
+    events.clear();
+    threadEvents.mergeInto(events);
+    std::stable_sort(events.begin(), events.end(), [](const auto& a, const auto& b) {
+        return a.entityIndex < b.entityIndex;
+    });
+
+    // send frame events
+    for (const auto& pe : events) {
+        EntityAnimationEvent event;
+        event.entity = entt::handle{registry, entities[pe.entityIndex]};
+        event.event = *pe.event;
+        em.triggerEvent(event);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <entt/entity/registry.hpp>
+
+#include <edbr/Core/PerThreadVector.h>
+
+class EventManager;
+class JobSystem;
+
+// Updates all SkeletonComponents on JobSystem threads. Animation frame events
+// are collected per thread and sent afterwards in the same order as if
+// the animators were updated one after another.
+class SkeletonAnimationSystem {
+public:
+    void update(entt::registry& registry, EventManager& em, JobSystem& jobSystem, float dt);
+
+private:
+    struct PendingEvent {
+        std::uint32_t entityIndex; // index in entities
+        const std::string* event; // points into SkeletalAnimation::events
+    };
+
+    std::vector<entt::entity> entities;
+    PerThreadVector<PendingEvent> threadEvents;
+    std::vector<PendingEvent> events;
+};
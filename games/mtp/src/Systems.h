@@ -13,25 +13,6 @@
 #include "Events.h"
 #include "PhysicsSystem.h"
 
-inline void skeletonAnimationSystemUpdate(entt::registry& registry, EventManager& em, float dt)
-{
-    for (const auto&& [e, sc] : registry.view<SkeletonComponent>().each()) {
-        sc.skeletonAnimator.update(sc.skeleton, dt);
-
-        // send frame events
-        if (sc.skeletonAnimator.hasFrameChanged()) {
-            const auto& animation = *sc.skeletonAnimator.getAnimation();
-            const auto& events = animation.getEventsForFrame(sc.skeletonAnimator.getCurrentFrame());
-            for (const auto& eventName : events) {
-                EntityAnimationEvent event;
-                event.entity = entt::handle{registry, e};
-                event.event = eventName;
-                em.triggerEvent(event);
-            }
-        }
-    }
-}
-
 // TODO: do this in state machine instead
 inline void playerAnimationSystemUpdate(
     entt::handle player,
@@ -39,41 +20,46 @@ inline void playerAnimationSystemUpdate(
     float dt)
 {
     namespace eu = entityutil;
+    static const float fadeDuration = 0.15f;
+
     auto& mc = player.get<MovementComponent>();
     auto velocity = mc.effectiveVelocity;
     velocity.y = 0.f;
     const auto velMag = glm::length(velocity);
 
-    bool playerRunning = velMag > 1.5f;
-
     if (!physicsSystem.isCharacterOnGround()) {
         if (mc.effectiveVelocity.y > 0.f) {
-            eu::setAnimation(player, "Jump");
+            eu::setAnimation(player, "Jump", fadeDuration);
         } else {
-            eu::setAnimation(player, "Fall");
-        }
-    } else {
-        if (std::abs(velMag) <= 0.1f) {
-            const auto& animator = player.get<SkeletonComponent>().skeletonAnimator;
-            if (animator.getCurrentAnimationName() == "Run" ||
-                animator.getCurrentAnimationName() == "Walk" ||
-                animator.getCurrentAnimationName() == "Jump" ||
-                animator.getCurrentAnimationName() == "Fall") {
-                // eu::setAnimation(player, "Think");
-                eu::setAnimation(player, "Idle");
-            }
-        } else {
-            // ^^^
-            // when sliding against the wall, "Idle" and "Walk" animations
-            // change too quick - this prevents that (but we might not need it
-            // when blending is added)
-            if (playerRunning) {
-                eu::setAnimation(player, "Run");
-            } else if (velMag > 0.2f) {
-                // HACK: sometimes the player can fall slightly when being spawned
-                eu::setAnimation(player, "Walk");
-            }
+            eu::setAnimation(player, "Fall", fadeDuration);
         }
+        return;
+    }
+
+    auto& sc = player.get<SkeletonComponent>();
+    auto& animator = sc.skeletonAnimator;
+    if (sc.locomotionBlendSpace.entries.empty()) {
+        // clips are placed at the speeds they were made for
+        const auto& cp = physicsSystem.getCharacterParams();
+        sc.locomotionBlendSpace = AnimationBlendSpace1D{
+            .name = "Locomotion",
+            .entries =
+                {
+                    {.position = 0.f, .animation = &eu::getAnimation(player, "Idle")},
+                    {.position = cp.walkSpeed, .animation = &eu::getAnimation(player, "Walk")},
+                    {.position = cp.runSpeed, .animation = &eu::getAnimation(player, "Run")},
+                },
+        };
+    }
+
+    // when standing still, don't interrupt other animations (e.g. "Think")
+    const auto& animName = animator.getCurrentAnimationName();
+    if (velMag > 0.1f || animator.isBlendSpacePlaying() || animName == "Jump" ||
+        animName == "Fall") {
+        // Idle/Walk/Run are blended continuously, so sliding against the
+        // wall doesn't make them flicker
+        animator.setBlendSpace(sc.skeleton, sc.locomotionBlendSpace, fadeDuration);
+        animator.setBlendParameter(velMag);
     }
 }
 